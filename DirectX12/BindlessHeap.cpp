@@ -0,0 +1,52 @@
+#include "BindlessHeap.h"
+
+BindlessHeap::BindlessHeap():
+	device_{},
+	heap_{},
+	descriptor_size_{},
+	cpu_start_{},
+	gpu_start_{},
+	allocator_{}{}
+
+HRESULT BindlessHeap::Initialize(ID3D12Device *device, UINT capacity){
+	HRESULT hr;
+
+	D3D12_DESCRIPTOR_HEAP_DESC descriptor_heap_desc{};
+	descriptor_heap_desc.NumDescriptors = capacity;
+	descriptor_heap_desc.Type			= D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
+	descriptor_heap_desc.Flags			= D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
+	descriptor_heap_desc.NodeMask		= 0;
+	hr = device->CreateDescriptorHeap(&descriptor_heap_desc, IID_PPV_ARGS(heap_.ReleaseAndGetAddressOf()));
+	if(FAILED(hr)){
+		return hr;
+	}
+
+	device_				= device;
+	descriptor_size_	= device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+	cpu_start_			= heap_->GetCPUDescriptorHandleForHeapStart();
+	gpu_start_			= heap_->GetGPUDescriptorHandleForHeapStart();
+	allocator_.Reset(capacity);
+
+	return S_OK;
+}
+
+HRESULT BindlessHeap::Allocate(UINT count, UINT *index){
+	const uint32_t first = allocator_.Allocate(count);
+	if(first == DescriptorAllocator::INVALID_INDEX){
+		return E_OUTOFMEMORY;
+	}
+	*index = first;
+	return S_OK;
+}
+
+HRESULT BindlessHeap::CreateShaderResourceView(ID3D12Resource *resource, const D3D12_SHADER_RESOURCE_VIEW_DESC *desc, UINT *index){
+	HRESULT hr;
+
+	hr = Allocate(1, index);
+	if(FAILED(hr)){
+		return hr;
+	}
+	device_->CreateShaderResourceView(resource, desc, CpuHandle(*index));
+
+	return S_OK;
+}
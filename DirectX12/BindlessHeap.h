@@ -0,0 +1,44 @@
+#ifndef BINDLESS_HEAP_HEADER_
+#define BINDLESS_HEAP_HEADER_
+
+#include <d3d12.h>
+#include <wrl/client.h>
+#include "DescriptorAllocator.h"
+
+using namespace Microsoft::WRL;
+
+//全てのテクスチャのSRVを置くシェーダから見えるデスクリプタヒープ
+//ヒープの切り替えはコマンドリストごとに1回だけにし、シェーダはルート定数で渡した添字でテクスチャを引く
+//割り当てた添字はリソースを破棄するまで変わらない
+class BindlessHeap{
+public:
+	BindlessHeap();
+	~BindlessHeap(){}
+	HRESULT Initialize(ID3D12Device *device, UINT capacity);
+
+	//count個の連続したデスクリプタを割り当てる(空きがなければE_OUTOFMEMORY)
+	HRESULT Allocate(UINT count, UINT *index);
+
+	//fence_valueのフレームを描画し終えたら再利用する(0ならすぐに再利用してよい)
+	void Free(UINT index, UINT count, UINT64 fence_value){allocator_.Free(index, count, fence_value);}
+	void ReleaseCompleted(UINT64 completed_fence_value){allocator_.ReleaseCompleted(completed_fence_value);}
+
+	//1つ割り当ててSRVを作成する
+	HRESULT CreateShaderResourceView(ID3D12Resource *resource, const D3D12_SHADER_RESOURCE_VIEW_DESC *desc, UINT *index);
+
+	D3D12_CPU_DESCRIPTOR_HANDLE CpuHandle(UINT index) const{return {cpu_start_.ptr + static_cast<SIZE_T>(index) * descriptor_size_};}
+	D3D12_GPU_DESCRIPTOR_HANDLE GpuHandle(UINT index) const{return {gpu_start_.ptr + static_cast<UINT64>(index) * descriptor_size_};}
+	ID3D12DescriptorHeap* GetHeap() const{return heap_.Get();}
+	UINT Capacity() const{return allocator_.Capacity();}
+	DescriptorAllocator::Stats GetStats() const{return allocator_.GetStats();}
+
+private:
+	ComPtr<ID3D12Device>			device_;
+	ComPtr<ID3D12DescriptorHeap>	heap_;
+	UINT							descriptor_size_;
+	D3D12_CPU_DESCRIPTOR_HANDLE		cpu_start_;
+	D3D12_GPU_DESCRIPTOR_HANDLE		gpu_start_;
+	DescriptorAllocator				allocator_;
+};
+
+#endif
@@ -0,0 +1,353 @@
+#include <algorithm>
+#include <cmath>
+#include <future>
+#include <vector>
+#include "BlockCompressor.h"
+#include "JobSystem.h"
+
+namespace{
+typedef BlockCompressor::byte byte;
+
+struct Color{
+	float r, g, b;
+};
+
+uint16_t ToRGB565(const Color &c){
+	const int r = std::min(31, std::max(0, static_cast<int>(c.r * (31.0f / 255.0f) + 0.5f)));
+	const int g = std::min(63, std::max(0, static_cast<int>(c.g * (63.0f / 255.0f) + 0.5f)));
+	const int b = std::min(31, std::max(0, static_cast<int>(c.b * (31.0f / 255.0f) + 0.5f)));
+	return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+}
+
+Color FromRGB565(uint16_t v){
+	const int r = (v >> 11) & 31;
+	const int g = (v >> 5) & 63;
+	const int b = v & 31;
+	return {
+		static_cast<float>((r << 3) | (r >> 2)),
+		static_cast<float>((g << 2) | (g >> 4)),
+		static_cast<float>((b << 3) | (b >> 2)),
+	};
+}
+
+float Distance(const Color &a, const Color &b){
+	const float dr = a.r - b.r;
+	const float dg = a.g - b.g;
+	const float db = a.b - b.b;
+	return dr * dr + dg * dg + db * db;
+}
+
+//カラー部分(8バイト)の圧縮
+//主成分の方向に沿った両端を端点とし、4色モードで各画素に最も近い色を割り当てる
+void EncodeColorBlock(const byte *bgra, byte *dst){
+	Color px[16];
+	Color mean{};
+	for(int i = 0; i < 16; ++i){
+		px[i] = {static_cast<float>(bgra[i * 4 + 2]), static_cast<float>(bgra[i * 4 + 1]), static_cast<float>(bgra[i * 4 + 0])};
+		mean.r += px[i].r;
+		mean.g += px[i].g;
+		mean.b += px[i].b;
+	}
+	mean = {mean.r / 16.0f, mean.g / 16.0f, mean.b / 16.0f};
+
+	//共分散行列
+	float cov[6]{};
+	for(int i = 0; i < 16; ++i){
+		const float r = px[i].r - mean.r;
+		const float g = px[i].g - mean.g;
+		const float b = px[i].b - mean.b;
+		cov[0] += r * r; cov[1] += r * g; cov[2] += r * b;
+		cov[3] += g * g; cov[4] += g * b; cov[5] += b * b;
+	}
+
+	//べき乗法で主成分の方向を求める
+	Color axis{1.0f, 1.0f, 1.0f};
+	for(int i = 0; i < 8; ++i){
+		const Color next{
+			cov[0] * axis.r + cov[1] * axis.g + cov[2] * axis.b,
+			cov[1] * axis.r + cov[3] * axis.g + cov[4] * axis.b,
+			cov[2] * axis.r + cov[4] * axis.g + cov[5] * axis.b,
+		};
+		const float len = std::max(std::max(std::fabs(next.r), std::fabs(next.g)), std::fabs(next.b));
+		if(len < 1e-6f){
+			break;
+		}
+		axis = {next.r / len, next.g / len, next.b / len};
+	}
+
+	float t_min = 1e30f;
+	float t_max = -1e30f;
+	for(int i = 0; i < 16; ++i){
+		const float t = (px[i].r - mean.r) * axis.r + (px[i].g - mean.g) * axis.g + (px[i].b - mean.b) * axis.b;
+		t_min = std::min(t_min, t);
+		t_max = std::max(t_max, t);
+	}
+
+	//量子化誤差を考慮して端点を少し内側に寄せる
+	const float axis_len2 = axis.r * axis.r + axis.g * axis.g + axis.b * axis.b;
+	const float inset = (t_max - t_min) / 16.0f;
+	t_min = (t_min + inset) / axis_len2;
+	t_max = (t_max - inset) / axis_len2;
+
+	uint16_t c0 = ToRGB565({mean.r + axis.r * t_max, mean.g + axis.g * t_max, mean.b + axis.b * t_max});
+	uint16_t c1 = ToRGB565({mean.r + axis.r * t_min, mean.g + axis.g * t_min, mean.b + axis.b * t_min});
+	if(c0 < c1){
+		std::swap(c0, c1);
+	}
+
+	uint32_t indices{};
+	if(c0 != c1){
+		const Color e0 = FromRGB565(c0);
+		const Color e1 = FromRGB565(c1);
+		const Color palette[4] = {
+			e0,
+			e1,
+			{(2.0f * e0.r + e1.r) / 3.0f, (2.0f * e0.g + e1.g) / 3.0f, (2.0f * e0.b + e1.b) / 3.0f},
+			{(e0.r + 2.0f * e1.r) / 3.0f, (e0.g + 2.0f * e1.g) / 3.0f, (e0.b + 2.0f * e1.b) / 3.0f},
+		};
+
+		for(int i = 0; i < 16; ++i){
+			uint32_t best{};
+			float best_d = Distance(px[i], palette[0]);
+			for(uint32_t j = 1; j < 4; ++j){
+				const float d = Distance(px[i], palette[j]);
+				if(d < best_d){
+					best_d = d;
+					best = j;
+				}
+			}
+			indices |= best << (i * 2);
+		}
+	}
+
+	dst[0] = static_cast<byte>(c0 & 0xff);
+	dst[1] = static_cast<byte>(c0 >> 8);
+	dst[2] = static_cast<byte>(c1 & 0xff);
+	dst[3] = static_cast<byte>(c1 >> 8);
+	dst[4] = static_cast<byte>(indices & 0xff);
+	dst[5] = static_cast<byte>((indices >> 8) & 0xff);
+	dst[6] = static_cast<byte>((indices >> 16) & 0xff);
+	dst[7] = static_cast<byte>(indices >> 24);
+}
+
+//アルファ部分(8バイト)の圧縮(8段階補間モード)
+void EncodeAlphaBlock(const byte *bgra, byte *dst){
+	int a_min = 255;
+	int a_max = 0;
+	for(int i = 0; i < 16; ++i){
+		a_min = std::min(a_min, static_cast<int>(bgra[i * 4 + 3]));
+		a_max = std::max(a_max, static_cast<int>(bgra[i * 4 + 3]));
+	}
+
+	uint64_t indices{};
+	if(a_max != a_min){
+		int palette[8];
+		palette[0] = a_max;
+		palette[1] = a_min;
+		for(int i = 1; i < 7; ++i){
+			palette[i + 1] = ((7 - i) * a_max + i * a_min) / 7;
+		}
+
+		for(int i = 0; i < 16; ++i){
+			const int a = bgra[i * 4 + 3];
+			uint64_t best{};
+			int best_d = std::abs(a - palette[0]);
+			for(uint64_t j = 1; j < 8; ++j){
+				const int d = std::abs(a - palette[j]);
+				if(d < best_d){
+					best_d = d;
+					best = j;
+				}
+			}
+			indices |= best << (i * 3);
+		}
+	}
+
+	dst[0] = static_cast<byte>(a_max);
+	dst[1] = static_cast<byte>(a_min);
+	for(int i = 0; i < 6; ++i){
+		dst[2 + i] = static_cast<byte>((indices >> (i * 8)) & 0xff);
+	}
+}
+
+//画像からブロック1つ分の画素を取り出す(端は最後の画素を繰り返す)
+void FetchBlock(const byte *src, int width, int height, int src_pitch, int bx, int by, byte *block){
+	for(int y = 0; y < 4; ++y){
+		const int sy = std::min(by * 4 + y, height - 1);
+		for(int x = 0; x < 4; ++x){
+			const int sx = std::min(bx * 4 + x, width - 1);
+			const byte *p = src + sy * src_pitch + sx * 4;
+			byte *d = block + (y * 4 + x) * 4;
+			d[0] = p[0];
+			d[1] = p[1];
+			d[2] = p[2];
+			d[3] = p[3];
+		}
+	}
+}
+
+//カラー部分(8バイト)の展開(c0 <= c1の場合は3色+透明のモード)
+void DecodeColorBlock(const byte *src, byte *bgra, bool force_four_color){
+	const uint16_t c0 = static_cast<uint16_t>(src[0] | (src[1] << 8));
+	const uint16_t c1 = static_cast<uint16_t>(src[2] | (src[3] << 8));
+	const uint32_t indices = src[4] | (src[5] << 8) | (src[6] << 16) | (static_cast<uint32_t>(src[7]) << 24);
+
+	const Color e0 = FromRGB565(c0);
+	const Color e1 = FromRGB565(c1);
+	byte palette[4][4];
+	const auto set = [&](int i, float r, float g, float b, byte a){
+		palette[i][0] = static_cast<byte>(b + 0.5f);
+		palette[i][1] = static_cast<byte>(g + 0.5f);
+		palette[i][2] = static_cast<byte>(r + 0.5f);
+		palette[i][3] = a;
+	};
+	set(0, e0.r, e0.g, e0.b, 255);
+	set(1, e1.r, e1.g, e1.b, 255);
+	if(c0 > c1 || force_four_color){
+		set(2, (2.0f * e0.r + e1.r) / 3.0f, (2.0f * e0.g + e1.g) / 3.0f, (2.0f * e0.b + e1.b) / 3.0f, 255);
+		set(3, (e0.r + 2.0f * e1.r) / 3.0f, (e0.g + 2.0f * e1.g) / 3.0f, (e0.b + 2.0f * e1.b) / 3.0f, 255);
+	}else{
+		set(2, (e0.r + e1.r) / 2.0f, (e0.g + e1.g) / 2.0f, (e0.b + e1.b) / 2.0f, 255);
+		set(3, 0.0f, 0.0f, 0.0f, 0);
+	}
+
+	for(int i = 0; i < 16; ++i){
+		const byte *c = palette[(indices >> (i * 2)) & 3];
+		bgra[i * 4 + 0] = c[0];
+		bgra[i * 4 + 1] = c[1];
+		bgra[i * 4 + 2] = c[2];
+		bgra[i * 4 + 3] = c[3];
+	}
+}
+
+//アルファ部分(8バイト)の展開
+void DecodeAlphaBlock(const byte *src, byte *bgra){
+	const int a0 = src[0];
+	const int a1 = src[1];
+	uint64_t indices{};
+	for(int i = 0; i < 6; ++i){
+		indices |= static_cast<uint64_t>(src[2 + i]) << (i * 8);
+	}
+
+	int palette[8];
+	palette[0] = a0;
+	palette[1] = a1;
+	if(a0 > a1){
+		for(int i = 1; i < 7; ++i){
+			palette[i + 1] = ((7 - i) * a0 + i * a1) / 7;
+		}
+	}else{
+		for(int i = 1; i < 5; ++i){
+			palette[i + 1] = ((5 - i) * a0 + i * a1) / 5;
+		}
+		palette[6] = 0;
+		palette[7] = 255;
+	}
+
+	for(int i = 0; i < 16; ++i){
+		bgra[i * 4 + 3] = static_cast<byte>(palette[(indices >> (i * 3)) & 7]);
+	}
+}
+
+void CompressRows(TextureFormat format, const byte *src, int width, int height, int src_pitch, byte *dst, int row_begin, int row_end){
+	const int block_w		= (width + 3) / 4;
+	const int block_size	= (format == TEXTURE_FORMAT_BC1) ? 8 : 16;
+	const int dst_pitch		= CalcTextureRowPitch(format, width);
+
+	byte block[64];
+	for(int by = row_begin; by < row_end; ++by){
+		byte *d = dst + by * dst_pitch;
+		for(int bx = 0; bx < block_w; ++bx){
+			FetchBlock(src, width, height, src_pitch, bx, by, block);
+			if(format == TEXTURE_FORMAT_BC1){
+				BlockCompressor::EncodeBC1Block(block, d);
+			}else{
+				BlockCompressor::EncodeBC3Block(block, d);
+			}
+			d += block_size;
+		}
+	}
+}
+}
+
+
+void BlockCompressor::EncodeBC1Block(const byte *bgra, byte *dst){
+	EncodeColorBlock(bgra, dst);
+}
+
+void BlockCompressor::EncodeBC3Block(const byte *bgra, byte *dst){
+	EncodeAlphaBlock(bgra, dst);
+	EncodeColorBlock(bgra, dst + 8);
+}
+
+void BlockCompressor::DecodeBC1Block(const byte *src, byte *bgra){
+	DecodeColorBlock(src, bgra, false);
+}
+
+void BlockCompressor::DecodeBC3Block(const byte *src, byte *bgra){
+	//BC3のカラー部分は常に4色モード
+	DecodeColorBlock(src + 8, bgra, true);
+	DecodeAlphaBlock(src, bgra);
+}
+
+bool BlockCompressor::Decompress(TextureFormat format, const byte *src, int width, int height, byte *dst, int dst_pitch){
+	if(format != TEXTURE_FORMAT_BC1 && format != TEXTURE_FORMAT_BC3){
+		return false;
+	}
+
+	const int block_size	= (format == TEXTURE_FORMAT_BC1) ? 8 : 16;
+	const int src_pitch		= CalcTextureRowPitch(format, width);
+
+	byte block[64];
+	for(int by = 0; by < CalcTextureRowNum(format, height); ++by){
+		for(int bx = 0; bx < (width + 3) / 4; ++bx){
+			const byte *s = src + by * src_pitch + bx * block_size;
+			if(format == TEXTURE_FORMAT_BC1){
+				DecodeBC1Block(s, block);
+			}else{
+				DecodeBC3Block(s, block);
+			}
+
+			//画像の端からはみ出た画素は捨てる
+			for(int y = 0; y < 4 && by * 4 + y < height; ++y){
+				for(int x = 0; x < 4 && bx * 4 + x < width; ++x){
+					byte *d = dst + (by * 4 + y) * dst_pitch + (bx * 4 + x) * 4;
+					const byte *p = block + (y * 4 + x) * 4;
+					d[0] = p[0];
+					d[1] = p[1];
+					d[2] = p[2];
+					d[3] = p[3];
+				}
+			}
+		}
+	}
+
+	return true;
+}
+
+bool BlockCompressor::Compress(TextureFormat format, const byte *src, int width, int height, int src_pitch, byte *dst, JobSystem *jobs){
+	if(format != TEXTURE_FORMAT_BC1 && format != TEXTURE_FORMAT_BC3){
+		return false;
+	}
+
+	const int block_h = CalcTextureRowNum(format, height);
+	if(jobs == nullptr || block_h < 2){
+		CompressRows(format, src, width, height, src_pitch, dst, 0, block_h);
+		return true;
+	}
+
+	//ブロック行をスレッド数の数倍に分けて負荷を均す
+	const int chunk_num  = std::min(block_h, static_cast<int>(jobs->ThreadNum()) * 4);
+	const int chunk_rows = (block_h + chunk_num - 1) / chunk_num;
+
+	std::vector<std::future<void>> results;
+	for(int begin = 0; begin < block_h; begin += chunk_rows){
+		const int end = std::min(block_h, begin + chunk_rows);
+		results.push_back(jobs->Push([=]{CompressRows(format, src, width, height, src_pitch, dst, begin, end);}));
+	}
+	for(auto &r : results){
+		r.get();
+	}
+
+	return true;
+}
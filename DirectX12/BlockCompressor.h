@@ -0,0 +1,30 @@
+#ifndef BLOCK_COMPRESSOR_HEADER_
+#define BLOCK_COMPRESSOR_HEADER_
+
+#include "TextureContainer.h"
+
+class JobSystem;
+
+//BGRA8の画像をBC1/BC3に圧縮する(確認用に展開もできる)
+class BlockCompressor{
+public:
+	typedef unsigned char byte;
+
+public:
+	//4x4画素(BGRA8, 64バイト)を1ブロックに圧縮する
+	static void EncodeBC1Block(const byte *bgra, byte *dst);
+	static void EncodeBC3Block(const byte *bgra, byte *dst);
+
+	//画像全体を圧縮する(jobsを渡すとブロック行単位で並列に処理する)
+	//dstにはCalcTextureRowPitch(format, width) * CalcTextureRowNum(format, height)バイト必要
+	static bool Compress(TextureFormat format, const byte *src, int width, int height, int src_pitch, byte *dst, JobSystem *jobs);
+
+	//1ブロックを4x4画素(BGRA8, 64バイト)に展開する
+	static void DecodeBC1Block(const byte *src, byte *bgra);
+	static void DecodeBC3Block(const byte *src, byte *bgra);
+
+	//画像全体を展開する(dstはwidth x heightのBGRA8)
+	static bool Decompress(TextureFormat format, const byte *src, int width, int height, byte *dst, int dst_pitch);
+};
+
+#endif
@@ -0,0 +1,73 @@
+#include <algorithm>
+#include <cstring>
+#include "CopyFootprint.h"
+
+namespace{
+uint64_t AlignUp(uint64_t v, uint64_t alignment){
+	return (v + alignment - 1) & ~(alignment - 1);
+}
+}
+
+int GetTextureBlockDim(TextureFormat format){
+	switch(format){
+		case TEXTURE_FORMAT_BC1:
+		case TEXTURE_FORMAT_BC3: return 4;
+		default:				 return 1;
+	}
+}
+
+uint64_t CalcCopyFootprints(TextureFormat format, int width, int height, int first_level, int level_num, uint64_t base_offset, CopyFootprint *footprints){
+	const int block = GetTextureBlockDim(format);
+
+	uint64_t offset = base_offset;
+	uint64_t end = base_offset;
+	for(int i = 0; i < level_num; ++i){
+		const int level = first_level + i;
+		const int w = std::max(1, width >> level);
+		const int h = std::max(1, height >> level);
+
+		CopyFootprint &fp = footprints[i];
+		offset			= AlignUp(offset, CopyFootprint::PLACEMENT_ALIGNMENT);
+		fp.offset		= offset;
+		fp.width		= (w + block - 1) / block * block;
+		fp.height		= (h + block - 1) / block * block;
+		fp.row_size		= static_cast<uint32_t>(CalcTextureRowPitch(format, w));
+		fp.row_num		= CalcTextureRowNum(format, h);
+		fp.row_pitch	= static_cast<uint32_t>(AlignUp(fp.row_size, CopyFootprint::PITCH_ALIGNMENT));
+
+		//最後の行は詰め物を含まない(GetCopyableFootprintsのTotalBytesと同じ)
+		end		= fp.offset + static_cast<uint64_t>(fp.row_pitch) * (fp.row_num - 1) + fp.row_size;
+		offset	= fp.offset + static_cast<uint64_t>(fp.row_pitch) * fp.row_num;
+	}
+	return end - base_offset;
+}
+
+CopyFootprint SliceCopyFootprint(TextureFormat format, const CopyFootprint &footprint, int first_row, int row_num){
+	const int block = GetTextureBlockDim(format);
+
+	CopyFootprint fp = footprint;
+	fp.offset	= 0;
+	fp.row_num	= std::max(0, std::min(row_num, footprint.row_num - first_row));
+	fp.height	= fp.row_num * block;
+	return fp;
+}
+
+void CopyFootprintRows(const CopyFootprint &footprint, const void *src, size_t src_pitch, void *dst){
+	const unsigned char *s = static_cast<const unsigned char*>(src);
+	unsigned char *d = static_cast<unsigned char*>(dst) + footprint.offset;
+	if(footprint.row_num <= 0){
+		return;
+	}
+
+	//間隔が同じなら1回でコピーする
+	if(src_pitch == footprint.row_pitch){
+		memcpy(d, s, static_cast<size_t>(footprint.row_pitch) * (footprint.row_num - 1) + footprint.row_size);
+		return;
+	}
+
+	for(int y = 0; y < footprint.row_num; ++y){
+		memcpy(d, s, footprint.row_size);
+		s += src_pitch;
+		d += footprint.row_pitch;
+	}
+}
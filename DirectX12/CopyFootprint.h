@@ -0,0 +1,36 @@
+#ifndef COPY_FOOTPRINT_HEADER_
+#define COPY_FOOTPRINT_HEADER_
+
+#include <cstddef>
+#include <cstdint>
+#include "TextureContainer.h"
+
+//テクスチャをバッファ経由でコピーするときのレイアウト(GetCopyableFootprintsと同じ規則)
+//行の先頭はPITCH_ALIGNMENT、サブリソースの先頭はPLACEMENT_ALIGNMENTに揃える
+struct CopyFootprint{
+	static constexpr uint32_t PITCH_ALIGNMENT		= 256;
+	static constexpr uint32_t PLACEMENT_ALIGNMENT	= 512;
+
+	uint64_t	offset;		//バッファ先頭からのオフセット
+	int			width;		//BCの場合はブロックの大きさに切り上げた幅
+	int			height;		//BCの場合はブロックの大きさに切り上げた高さ
+	uint32_t	row_pitch;	//バッファ上の1行の間隔
+	uint32_t	row_size;	//1行の実際のバイト数
+	int			row_num;	//行数(BCの場合はブロックの行数)
+};
+
+//ブロック1つの幅・高さ(非圧縮なら1)
+int GetTextureBlockDim(TextureFormat format);
+
+//幅width・高さheightのレベル0から数えてfirst_levelからlevel_num個のレベルのレイアウトを求める
+//オフセットはbase_offsetから順に並べ、必要なバイト数(最後の行の詰め物を含まない)を返す
+uint64_t CalcCopyFootprints(TextureFormat format, int width, int height, int first_level, int level_num, uint64_t base_offset, CopyFootprint *footprints);
+
+//footprintの行[first_row, first_row + row_num)だけをコピーするレイアウト(1つのレベルを分けて転送する場合)
+//offsetは0にするので呼び出し側で設定すること
+CopyFootprint SliceCopyFootprint(TextureFormat format, const CopyFootprint &footprint, int first_row, int row_num);
+
+//行ごとの間隔がsrc_pitchの画素をfootprintのレイアウトでdstに書き込む(dstはバッファの先頭)
+void CopyFootprintRows(const CopyFootprint &footprint, const void *src, size_t src_pitch, void *dst);
+
+#endif
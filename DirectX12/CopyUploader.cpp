@@ -0,0 +1,366 @@
+#include <algorithm>
+#include <cstring>
+#include "CopyUploader.h"
+#include "D3D12Manager.h"
+
+CopyUploader::CopyUploader():
+	mutex_{},
+	device_{},
+	memory_allocator_(nullptr),
+	queue_{},
+	command_list_{},
+	fence_{},
+	fence_event_{},
+	fence_value_{},
+	batches_{},
+	open_allocator_{},
+	staging_{},
+	staging_address_(nullptr),
+	staging_allocator_{},
+	stats_{}{}
+
+CopyUploader::~CopyUploader(){
+	//コピー中のステージングを解放しないように完了を待つ
+	if(queue_ && fence_ && fence_event_ != NULL){
+		WaitIdle();
+	}
+	if(staging_ && staging_address_ != nullptr){
+		staging_->Unmap(0, nullptr);
+	}
+	if(fence_event_ != NULL){
+		CloseHandle(fence_event_);
+	}
+}
+
+HRESULT CopyUploader::Initialize(ID3D12Device *device, UINT64 staging_size, GpuMemoryAllocator *memory_allocator){
+	HRESULT hr{};
+
+	device_				= device;
+	memory_allocator_	= memory_allocator;
+
+	//コピー専用のキュー(描画用のキューと並行して転送する)
+	D3D12_COMMAND_QUEUE_DESC queue_desc{};
+	queue_desc.Type		= D3D12_COMMAND_LIST_TYPE_COPY;
+	queue_desc.Priority	= 0;
+	queue_desc.Flags	= D3D12_COMMAND_QUEUE_FLAG_NONE;
+	queue_desc.NodeMask	= 0;
+	hr = device->CreateCommandQueue(&queue_desc, IID_PPV_ARGS(&queue_));
+	if(FAILED(hr)){
+		return hr;
+	}
+
+	fence_event_ = CreateEventEx(nullptr, FALSE, FALSE, EVENT_ALL_ACCESS);
+	if(fence_event_ == NULL){
+		return E_FAIL;
+	}
+	hr = device->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&fence_));
+	if(FAILED(hr)){
+		return hr;
+	}
+
+
+	//コマンドリストは閉じた状態にしておき、最初のコピーでアロケータを割り当てる
+	ComPtr<ID3D12CommandAllocator> allocator{};
+	hr = device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_COPY, IID_PPV_ARGS(&allocator));
+	if(FAILED(hr)){
+		return hr;
+	}
+	hr = device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_COPY, allocator.Get(), nullptr, IID_PPV_ARGS(&command_list_));
+	if(FAILED(hr)){
+		return hr;
+	}
+	hr = command_list_->Close();
+	if(FAILED(hr)){
+		return hr;
+	}
+	batches_.push_back({allocator, 0});
+
+
+	//ステージング用のバッファ(作成時に一度だけMapする)
+	D3D12_HEAP_PROPERTIES heap_properties{};
+	D3D12_RESOURCE_DESC   resource_desc{};
+
+	heap_properties.Type					= D3D12_HEAP_TYPE_UPLOAD;
+	heap_properties.CPUPageProperty			= D3D12_CPU_PAGE_PROPERTY_UNKNOWN;
+	heap_properties.MemoryPoolPreference	= D3D12_MEMORY_POOL_UNKNOWN;
+	heap_properties.CreationNodeMask		= 0;
+	heap_properties.VisibleNodeMask			= 0;
+
+	resource_desc.Dimension				= D3D12_RESOURCE_DIMENSION_BUFFER;
+	resource_desc.Width					= staging_size;
+	resource_desc.Height				= 1;
+	resource_desc.DepthOrArraySize		= 1;
+	resource_desc.MipLevels				= 1;
+	resource_desc.Format				= DXGI_FORMAT_UNKNOWN;
+	resource_desc.Layout				= D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
+	resource_desc.SampleDesc.Count		= 1;
+	resource_desc.SampleDesc.Quality	= 0;
+
+	hr = device->CreateCommittedResource(&heap_properties, D3D12_HEAP_FLAG_NONE, &resource_desc, D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(&staging_));
+	if(FAILED(hr)){
+		return hr;
+	}
+
+	//CPUからは書き込むだけなので読み込み範囲は空にする
+	D3D12_RANGE read_range{0, 0};
+	hr = staging_->Map(0, &read_range, reinterpret_cast<void**>(&staging_address_));
+	if(FAILED(hr)){
+		return hr;
+	}
+
+	staging_allocator_.Reset(staging_size);
+
+	return S_OK;
+}
+
+
+HRESULT CopyUploader::CreateBuffer(const void *data, UINT64 size, GpuMemoryAllocator::BufferRange *buffer){
+	HRESULT hr;
+
+	//バッファはCOMMONから任意の状態に暗黙に遷移できる
+	hr = memory_allocator_->AllocateBuffer(D3D12_HEAP_TYPE_DEFAULT, size, D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT, buffer);
+	if(FAILED(hr)){
+		return hr;
+	}
+
+	return UploadBuffer(buffer->resource, buffer->offset, data, size);
+}
+
+HRESULT CopyUploader::CreateTexture(const D3D12_RESOURCE_DESC &desc, ID3D12Resource **texture, GpuMemoryAllocator::Allocation *allocation){
+	//COMMONからコピー先・シェーダリソースへ暗黙に遷移する
+	return memory_allocator_->CreateTexture(desc, D3D12_RESOURCE_STATE_COMMON, nullptr, texture, allocation);
+}
+
+HRESULT CopyUploader::UploadBuffer(ID3D12Resource *dst, UINT64 dst_offset, const void *data, UINT64 size){
+	HRESULT hr;
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	UINT64 offset{};
+	hr = Allocate(size, 16, &offset);
+	if(FAILED(hr)){
+		return hr;
+	}
+	hr = BeginBatch();
+	if(FAILED(hr)){
+		return hr;
+	}
+
+	memcpy(staging_address_ + offset, data, static_cast<size_t>(size));
+	command_list_->CopyBufferRegion(dst, dst_offset, staging_.Get(), offset, size);
+
+	++stats_.copy_num;
+	stats_.byte_num += size;
+	return S_OK;
+}
+
+
+HRESULT CopyUploader::UploadTexture(ID3D12Resource *dst, const TextureAsset &asset){
+	HRESULT hr;
+
+	for(int i = 0; i < asset.LevelNum(); ++i){
+		hr = UploadTextureLevel(dst, asset.Format(), i, asset.GetLevel(i));
+		if(FAILED(hr)){
+			return hr;
+		}
+	}
+	return S_OK;
+}
+
+HRESULT CopyUploader::UploadTextureLevel(ID3D12Resource *dst, TextureFormat format, int level, const TextureLevel &pixels){
+	return UploadTextureRows(dst, format, level, pixels, 0, pixels.row_num);
+}
+
+HRESULT CopyUploader::UploadTextureRows(ID3D12Resource *dst, TextureFormat format, int level, const TextureLevel &pixels, int first_row, int row_num){
+	HRESULT hr;
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	CopyFootprint footprint{};
+	CalcCopyFootprints(format, pixels.width, pixels.height, 0, 1, 0, &footprint);
+
+#if defined(_DEBUG)
+	//レイアウトの計算がドライバと食い違っていないか確認する
+	{
+		const D3D12_RESOURCE_DESC desc = dst->GetDesc();
+		D3D12_PLACED_SUBRESOURCE_FOOTPRINT layout{};
+		UINT row_num{};
+		UINT64 row_size{};
+		device_->GetCopyableFootprints(&desc, static_cast<UINT>(level), 1, 0, &layout, &row_num, &row_size, nullptr);
+		if(layout.Footprint.RowPitch != footprint.row_pitch || row_num != static_cast<UINT>(footprint.row_num) || row_size != footprint.row_size){
+			OutputDebugStringA("CopyUploader: footprint mismatch\n");
+			return E_FAIL;
+		}
+	}
+#endif
+
+	//ステージングに収まる行数ずつ転送する
+	const int block = GetTextureBlockDim(format);
+	const int last_row = std::min(first_row + row_num, footprint.row_num);
+	const int rows_per_copy = static_cast<int>(std::min<UINT64>(staging_allocator_.Size() / footprint.row_pitch, footprint.row_num));
+	if(rows_per_copy <= 0){
+		return E_OUTOFMEMORY;
+	}
+
+	for(int row = first_row; row < last_row; row += rows_per_copy){
+		CopyFootprint slice = SliceCopyFootprint(format, footprint, row, std::min(rows_per_copy, last_row - row));
+		const UINT64 size = static_cast<UINT64>(slice.row_pitch) * (slice.row_num - 1) + slice.row_size;
+
+		hr = Allocate(size, CopyFootprint::PLACEMENT_ALIGNMENT, &slice.offset);
+		if(FAILED(hr)){
+			return hr;
+		}
+		hr = BeginBatch();
+		if(FAILED(hr)){
+			return hr;
+		}
+
+		CopyFootprintRows(slice, pixels.pixels + static_cast<size_t>(row) * pixels.row_pitch, pixels.row_pitch, staging_address_);
+
+		D3D12_TEXTURE_COPY_LOCATION src{};
+		src.pResource							= staging_.Get();
+		src.Type								= D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT;
+		src.PlacedFootprint.Offset				= slice.offset;
+		src.PlacedFootprint.Footprint.Format	= GetDXGIFormat(format);
+		src.PlacedFootprint.Footprint.Width		= slice.width;
+		src.PlacedFootprint.Footprint.Height	= slice.height;
+		src.PlacedFootprint.Footprint.Depth		= 1;
+		src.PlacedFootprint.Footprint.RowPitch	= slice.row_pitch;
+
+		D3D12_TEXTURE_COPY_LOCATION dst_location{};
+		dst_location.pResource			= dst;
+		dst_location.Type				= D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX;
+		dst_location.SubresourceIndex	= static_cast<UINT>(level);
+
+		command_list_->CopyTextureRegion(&dst_location, 0, static_cast<UINT>(row * block), 0, &src, nullptr);
+
+		++stats_.copy_num;
+		stats_.byte_num += size;
+	}
+
+	return S_OK;
+}
+
+
+UINT64 CopyUploader::Flush(){
+	std::lock_guard<std::mutex> lock(mutex_);
+	return FlushLocked();
+}
+
+HRESULT CopyUploader::WaitOnQueue(ID3D12CommandQueue *queue){
+	std::lock_guard<std::mutex> lock(mutex_);
+	return queue->Wait(fence_.Get(), fence_value_);
+}
+
+HRESULT CopyUploader::WaitForQueue(ID3D12Fence *fence, UINT64 fence_value){
+	std::lock_guard<std::mutex> lock(mutex_);
+	return queue_->Wait(fence, fence_value);
+}
+
+HRESULT CopyUploader::WaitIdle(){
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	const UINT64 fence_value = FlushLocked();
+	const HRESULT hr = WaitFence(fence_value);
+	if(SUCCEEDED(hr)){
+		staging_allocator_.ReleaseCompletedFrames(fence_value);
+	}
+	return hr;
+}
+
+UINT64 CopyUploader::LastFenceValue() const{
+	std::lock_guard<std::mutex> lock(mutex_);
+	return fence_value_;
+}
+
+CopyUploader::Stats CopyUploader::GetStats() const{
+	std::lock_guard<std::mutex> lock(mutex_);
+	return stats_;
+}
+
+
+HRESULT CopyUploader::Allocate(UINT64 size, UINT64 alignment, UINT64 *offset){
+	HRESULT hr;
+
+	if(size > staging_allocator_.Size()){
+		return E_OUTOFMEMORY;
+	}
+
+	staging_allocator_.ReleaseCompletedFrames(fence_->GetCompletedValue());
+	*offset = staging_allocator_.Allocate(size, alignment);
+	if(*offset != RingAllocator::INVALID_OFFSET){
+		return S_OK;
+	}
+
+	//一杯なら記録中のコピーも提出し、全ての完了を待って空にする
+	++stats_.stall_num;
+	const UINT64 fence_value = FlushLocked();
+	hr = WaitFence(fence_value);
+	if(FAILED(hr)){
+		return hr;
+	}
+	staging_allocator_.ReleaseCompletedFrames(fence_value);
+
+	*offset = staging_allocator_.Allocate(size, alignment);
+	return (*offset != RingAllocator::INVALID_OFFSET) ? S_OK : E_OUTOFMEMORY;
+}
+
+//記録中でなければアロケータを用意してコマンドリストを開く
+HRESULT CopyUploader::BeginBatch(){
+	HRESULT hr;
+
+	if(open_allocator_ != nullptr){
+		return S_OK;
+	}
+
+	//GPUが使い終わった最も古いアロケータを使い回す(なければ作る)
+	if(!batches_.empty() && batches_.front().fence_value <= fence_->GetCompletedValue()){
+		open_allocator_ = batches_.front().allocator;
+		batches_.pop_front();
+		hr = open_allocator_->Reset();
+	}else{
+		hr = device_->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_COPY, IID_PPV_ARGS(&open_allocator_));
+	}
+	if(FAILED(hr)){
+		open_allocator_.Reset();
+		return hr;
+	}
+
+	hr = command_list_->Reset(open_allocator_.Get(), nullptr);
+	if(FAILED(hr)){
+		open_allocator_.Reset();
+	}
+	return hr;
+}
+
+UINT64 CopyUploader::FlushLocked(){
+	if(open_allocator_ == nullptr){
+		return fence_value_;
+	}
+
+	if(SUCCEEDED(command_list_->Close())){
+		ID3D12CommandList *command_lists[] = {command_list_.Get()};
+		queue_->ExecuteCommandLists(_countof(command_lists), command_lists);
+		++stats_.batch_num;
+	}
+
+	//提出できなかった場合もフェンスは進めて、ステージングの領域が解放されるようにする
+	++fence_value_;
+	queue_->Signal(fence_.Get(), fence_value_);
+	batches_.push_back({open_allocator_, fence_value_});
+	open_allocator_.Reset();
+	staging_allocator_.FinishFrame(fence_value_);
+
+	return fence_value_;
+}
+
+HRESULT CopyUploader::WaitFence(UINT64 fence_value){
+	HRESULT hr;
+
+	if(fence_->GetCompletedValue() < fence_value){
+		hr = fence_->SetEventOnCompletion(fence_value, fence_event_);
+		if(FAILED(hr)){
+			return hr;
+		}
+		WaitForSingleObject(fence_event_, INFINITE);
+	}
+	return S_OK;
+}
@@ -0,0 +1,93 @@
+#ifndef COPY_UPLOADER_HEADER_
+#define COPY_UPLOADER_HEADER_
+
+#include <deque>
+#include <mutex>
+#include <d3d12.h>
+#include <wrl/client.h>
+#include "RingAllocator.h"
+#include "GpuMemoryAllocator.h"
+#include "CopyFootprint.h"
+#include "TextureAsset.h"
+
+using namespace Microsoft::WRL;
+
+//DEFAULTヒープのバッファ・テクスチャへの転送
+//ステージング用のリングバッファに書き込み、コピーキューでまとめてコピーする
+//転送先はmemory_allocatorのブロックにCOMMON状態で作成し、コピーキューでの書き込みと描画での読み込みは暗黙の状態遷移に任せる
+class CopyUploader{
+public:
+	struct Stats{
+		uint64_t	copy_num;		//記録したコピーの数
+		uint64_t	byte_num;		//ステージングに書き込んだバイト数
+		uint64_t	batch_num;		//コピーキューに提出した回数
+		uint64_t	stall_num;		//ステージングが一杯でコピーの完了を待った回数
+	};
+
+public:
+	CopyUploader();
+	~CopyUploader();
+	HRESULT Initialize(ID3D12Device *device, UINT64 staging_size, GpuMemoryAllocator *memory_allocator);
+
+	//DEFAULTヒープのバッファの範囲を割り当て、dataの転送を記録する(定数バッファにも使えるように256バイトで揃える)
+	HRESULT CreateBuffer(const void *data, UINT64 size, GpuMemoryAllocator::BufferRange *buffer);
+
+	//DEFAULTヒープにテクスチャを作成する(転送はUploadTextureなどで記録する)
+	HRESULT CreateTexture(const D3D12_RESOURCE_DESC &desc, ID3D12Resource **texture, GpuMemoryAllocator::Allocation *allocation);
+	HRESULT UploadBuffer(ID3D12Resource *dst, UINT64 dst_offset, const void *data, UINT64 size);
+
+	//テクスチャの各レベルの転送を記録する(ステージングより大きいレベルは行で分けて転送する)
+	//書き込みはこの関数の中で終わるので、呼び出し後にassetを閉じてよい
+	HRESULT UploadTexture(ID3D12Resource *dst, const TextureAsset &asset);
+	HRESULT UploadTextureLevel(ID3D12Resource *dst, TextureFormat format, int level, const TextureLevel &pixels);
+
+	//レベルの行[first_row, first_row + row_num)だけを転送する(ストリーミングで1つのレベルを複数フレームに分ける場合)
+	//pixelsはレベル全体の画素を指すこと
+	HRESULT UploadTextureRows(ID3D12Resource *dst, TextureFormat format, int level, const TextureLevel &pixels, int first_row, int row_num);
+
+	//コピーキューにqueue側のフェンスを待たせる(以降に提出するコピーに効く)
+	HRESULT WaitForQueue(ID3D12Fence *fence, UINT64 fence_value);
+
+	//記録したコピーをコピーキューに提出し、そのフェンス値を返す
+	UINT64 Flush();
+
+	//queueにこれまでに提出したコピーの完了を待たせる(GPU側で待つのでCPUは止まらない)
+	HRESULT WaitOnQueue(ID3D12CommandQueue *queue);
+
+	//CPUでコピーの完了を待つ
+	HRESULT WaitIdle();
+
+	ID3D12Fence* GetFence() const{return fence_.Get();}
+	UINT64 LastFenceValue() const;
+	Stats GetStats() const;
+
+private:
+	struct Batch{
+		ComPtr<ID3D12CommandAllocator>	allocator;
+		UINT64							fence_value;
+	};
+
+	//ステージングの領域を確保する(一杯なら提出済みのコピーの完了を待つ)
+	HRESULT Allocate(UINT64 size, UINT64 alignment, UINT64 *offset);
+	HRESULT BeginBatch();
+	UINT64 FlushLocked();
+	HRESULT WaitFence(UINT64 fence_value);
+
+private:
+	mutable std::mutex					mutex_;
+	ComPtr<ID3D12Device>				device_;
+	GpuMemoryAllocator					*memory_allocator_;
+	ComPtr<ID3D12CommandQueue>			queue_;			//コピーキュー
+	ComPtr<ID3D12GraphicsCommandList>	command_list_;
+	ComPtr<ID3D12Fence>					fence_;
+	HANDLE								fence_event_;
+	UINT64								fence_value_;	//最後に提出したバッチのフェンス値
+	std::deque<Batch>					batches_;		//提出済みのバッチ(古い順)
+	ComPtr<ID3D12CommandAllocator>		open_allocator_;	//記録中のバッチのアロケータ(記録中でなければnullptr)
+	ComPtr<ID3D12Resource>				staging_;
+	unsigned char						*staging_address_;
+	RingAllocator						staging_allocator_;
+	Stats								stats_;
+};
+
+#endif
@@ -0,0 +1,136 @@
+#include "D3D12CommandList.h"
+
+static_assert(RENDER_ALL_SUBRESOURCES == D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES, "all subresources");
+
+D3D12_RESOURCE_STATES GetD3D12ResourceState(RenderResourceState state){
+	switch(state){
+		case RENDER_STATE_VERTEX_AND_CONSTANT_BUFFER:	return D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER;
+		case RENDER_STATE_INDEX_BUFFER:					return D3D12_RESOURCE_STATE_INDEX_BUFFER;
+		case RENDER_STATE_RENDER_TARGET:				return D3D12_RESOURCE_STATE_RENDER_TARGET;
+		case RENDER_STATE_DEPTH_WRITE:					return D3D12_RESOURCE_STATE_DEPTH_WRITE;
+		case RENDER_STATE_DEPTH_READ:					return D3D12_RESOURCE_STATE_DEPTH_READ;
+		case RENDER_STATE_SHADER_RESOURCE:				return D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE | D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE;
+		case RENDER_STATE_COPY_DEST:					return D3D12_RESOURCE_STATE_COPY_DEST;
+		case RENDER_STATE_COPY_SOURCE:					return D3D12_RESOURCE_STATE_COPY_SOURCE;
+		case RENDER_STATE_GENERIC_READ:					return D3D12_RESOURCE_STATE_GENERIC_READ;
+		default:										return D3D12_RESOURCE_STATE_COMMON;
+	}
+}
+
+
+void D3D12CommandList::ResourceBarriers(int num, const RenderBarrier *barriers){
+	D3D12_RESOURCE_BARRIER resource_barriers[MAX_BARRIER]{};
+
+	for(int first = 0; first < num; first += MAX_BARRIER){
+		const int count = (num - first < MAX_BARRIER) ? num - first : MAX_BARRIER;
+		for(int i = 0; i < count; ++i){
+			const RenderBarrier &barrier = barriers[first + i];
+			D3D12_RESOURCE_BARRIER &resource_barrier = resource_barriers[i];
+
+			//メモリを共有するリソースの切り替え(前に使っていたリソースは指定しない)
+			if(barrier.type == RENDER_BARRIER_ALIASING){
+				resource_barrier.Type					= D3D12_RESOURCE_BARRIER_TYPE_ALIASING;
+				resource_barrier.Flags					= D3D12_RESOURCE_BARRIER_FLAG_NONE;
+				resource_barrier.Aliasing.pResourceBefore	= nullptr;
+				resource_barrier.Aliasing.pResourceAfter	= reinterpret_cast<ID3D12Resource*>(barrier.resource.value);
+				continue;
+			}
+
+			resource_barrier.Type  = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
+			switch(barrier.type){
+				case RENDER_BARRIER_BEGIN:	resource_barrier.Flags = D3D12_RESOURCE_BARRIER_FLAG_BEGIN_ONLY; break;
+				case RENDER_BARRIER_END:	resource_barrier.Flags = D3D12_RESOURCE_BARRIER_FLAG_END_ONLY; break;
+				default:					resource_barrier.Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE; break;
+			}
+			resource_barrier.Transition.pResource   = reinterpret_cast<ID3D12Resource*>(barrier.resource.value);
+			resource_barrier.Transition.Subresource = barrier.subresource;
+			resource_barrier.Transition.StateBefore = GetD3D12ResourceState(barrier.before);
+			resource_barrier.Transition.StateAfter  = GetD3D12ResourceState(barrier.after);
+		}
+
+		command_list_->ResourceBarrier(count, resource_barriers);
+	}
+}
+
+void D3D12CommandList::ClearRenderTarget(RenderTargetView rtv, const float color[4]){
+	command_list_->ClearRenderTargetView({static_cast<SIZE_T>(rtv.value)}, color, 0, nullptr);
+}
+
+void D3D12CommandList::ClearDepth(RenderTargetView dsv, float depth){
+	command_list_->ClearDepthStencilView({static_cast<SIZE_T>(dsv.value)}, D3D12_CLEAR_FLAG_DEPTH, depth, 0, 0, nullptr);
+}
+
+void D3D12CommandList::CopyResource(RenderResource dst, RenderResource src){
+	command_list_->CopyResource(reinterpret_cast<ID3D12Resource*>(dst.value), reinterpret_cast<ID3D12Resource*>(src.value));
+}
+
+void D3D12CommandList::SetRenderTargets(int rtv_num, const RenderTargetView *rtvs, RenderTargetView dsv){
+	D3D12_CPU_DESCRIPTOR_HANDLE rtv_handles[MAX_RENDER_TARGET]{};
+	for(int i = 0; i < rtv_num && i < MAX_RENDER_TARGET; ++i){
+		rtv_handles[i].ptr = static_cast<SIZE_T>(rtvs[i].value);
+	}
+
+	const D3D12_CPU_DESCRIPTOR_HANDLE dsv_handle{static_cast<SIZE_T>(dsv.value)};
+	command_list_->OMSetRenderTargets(rtv_num, rtv_num > 0 ? rtv_handles : nullptr, FALSE, dsv.IsValid() ? &dsv_handle : nullptr);
+}
+
+void D3D12CommandList::SetViewport(const RenderViewport &viewport){
+	const D3D12_VIEWPORT vp{viewport.x, viewport.y, viewport.width, viewport.height, viewport.min_depth, viewport.max_depth};
+	command_list_->RSSetViewports(1, &vp);
+}
+
+void D3D12CommandList::SetScissorRect(const RenderRect &rect){
+	const D3D12_RECT rc{rect.left, rect.top, rect.right, rect.bottom};
+	command_list_->RSSetScissorRects(1, &rc);
+}
+
+void D3D12CommandList::SetRootSignature(RenderRootSignature root_signature){
+	command_list_->SetGraphicsRootSignature(reinterpret_cast<ID3D12RootSignature*>(root_signature.value));
+}
+
+void D3D12CommandList::SetPipeline(RenderPipeline pipeline){
+	command_list_->SetPipelineState(reinterpret_cast<ID3D12PipelineState*>(pipeline.value));
+}
+
+void D3D12CommandList::SetConstantBuffer(int slot, RenderGpuAddress address){
+	command_list_->SetGraphicsRootConstantBufferView(slot, address);
+}
+
+void D3D12CommandList::SetRootConstants(int slot, uint32_t num, const uint32_t *values, uint32_t offset){
+	command_list_->SetGraphicsRoot32BitConstants(slot, num, values, offset);
+}
+
+void D3D12CommandList::SetDescriptorHeap(RenderDescriptorHeap heap){
+	ID3D12DescriptorHeap *heaps = reinterpret_cast<ID3D12DescriptorHeap*>(heap.value);
+	command_list_->SetDescriptorHeaps(1, &heaps);
+}
+
+void D3D12CommandList::SetDescriptorTable(int slot, RenderDescriptorTable table){
+	command_list_->SetGraphicsRootDescriptorTable(slot, {table.value});
+}
+
+void D3D12CommandList::SetTopology(RenderTopology topology){
+	switch(topology){
+		case RENDER_TOPOLOGY_TRIANGLE_LIST:  command_list_->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST); break;
+		case RENDER_TOPOLOGY_TRIANGLE_STRIP: command_list_->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP); break;
+		default:							 command_list_->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_UNDEFINED); break;
+	}
+}
+
+void D3D12CommandList::SetVertexBuffer(int slot, RenderGpuAddress address, uint32_t size, uint32_t stride){
+	const D3D12_VERTEX_BUFFER_VIEW vertex_view{address, size, stride};
+	command_list_->IASetVertexBuffers(slot, 1, &vertex_view);
+}
+
+void D3D12CommandList::SetIndexBuffer(RenderGpuAddress address, uint32_t size, RenderIndexFormat format){
+	const D3D12_INDEX_BUFFER_VIEW index_view{address, size, format == RENDER_INDEX_32 ? DXGI_FORMAT_R32_UINT : DXGI_FORMAT_R16_UINT};
+	command_list_->IASetIndexBuffer(&index_view);
+}
+
+void D3D12CommandList::Draw(uint32_t vertex_num, uint32_t instance_num, uint32_t start_vertex, uint32_t start_instance){
+	command_list_->DrawInstanced(vertex_num, instance_num, start_vertex, start_instance);
+}
+
+void D3D12CommandList::DrawIndexed(uint32_t index_num, uint32_t instance_num, uint32_t start_index, int32_t base_vertex, uint32_t start_instance){
+	command_list_->DrawIndexedInstanced(index_num, instance_num, start_index, base_vertex, start_instance);
+}
@@ -0,0 +1,59 @@
+#ifndef D3D12_COMMAND_LIST_HEADER_
+#define D3D12_COMMAND_LIST_HEADER_
+
+#include <d3d12.h>
+#include "RenderCommandList.h"
+
+//D3D12のオブジェクトとハンドルの変換
+inline RenderResource ToRenderResource(ID3D12Resource *resource){return {reinterpret_cast<uint64_t>(resource)};}
+inline RenderPipeline ToRenderPipeline(ID3D12PipelineState *pso){return {reinterpret_cast<uint64_t>(pso)};}
+inline RenderRootSignature ToRenderRootSignature(ID3D12RootSignature *root_signature){return {reinterpret_cast<uint64_t>(root_signature)};}
+inline RenderDescriptorHeap ToRenderDescriptorHeap(ID3D12DescriptorHeap *heap){return {reinterpret_cast<uint64_t>(heap)};}
+inline RenderTargetView ToRenderTargetView(D3D12_CPU_DESCRIPTOR_HANDLE handle){return {static_cast<uint64_t>(handle.ptr)};}
+inline RenderDescriptorTable ToRenderDescriptorTable(D3D12_GPU_DESCRIPTOR_HANDLE handle){return {handle.ptr};}
+
+D3D12_RESOURCE_STATES GetD3D12ResourceState(RenderResourceState state);
+
+
+//RenderCommandListのコマンドをID3D12GraphicsCommandListにそのまま転送する
+class D3D12CommandList : public RenderCommandList{
+public:
+	D3D12CommandList():command_list_(nullptr){}
+	explicit D3D12CommandList(ID3D12GraphicsCommandList *command_list):command_list_(command_list){}
+	~D3D12CommandList(){}
+
+	void SetCommandList(ID3D12GraphicsCommandList *command_list){command_list_ = command_list;}
+	ID3D12GraphicsCommandList* GetCommandList() const{return command_list_;}
+
+	void ResourceBarriers(int num, const RenderBarrier *barriers) override;
+
+	void ClearRenderTarget(RenderTargetView rtv, const float color[4]) override;
+	void ClearDepth(RenderTargetView dsv, float depth) override;
+	void CopyResource(RenderResource dst, RenderResource src) override;
+
+	void SetRenderTargets(int rtv_num, const RenderTargetView *rtvs, RenderTargetView dsv) override;
+	void SetViewport(const RenderViewport &viewport) override;
+	void SetScissorRect(const RenderRect &rect) override;
+
+	void SetRootSignature(RenderRootSignature root_signature) override;
+	void SetPipeline(RenderPipeline pipeline) override;
+	void SetConstantBuffer(int slot, RenderGpuAddress address) override;
+	void SetRootConstants(int slot, uint32_t num, const uint32_t *values, uint32_t offset) override;
+	void SetDescriptorHeap(RenderDescriptorHeap heap) override;
+	void SetDescriptorTable(int slot, RenderDescriptorTable table) override;
+
+	void SetTopology(RenderTopology topology) override;
+	void SetVertexBuffer(int slot, RenderGpuAddress address, uint32_t size, uint32_t stride) override;
+	void SetIndexBuffer(RenderGpuAddress address, uint32_t size, RenderIndexFormat format) override;
+
+	void Draw(uint32_t vertex_num, uint32_t instance_num, uint32_t start_vertex, uint32_t start_instance) override;
+	void DrawIndexed(uint32_t index_num, uint32_t instance_num, uint32_t start_index, int32_t base_vertex, uint32_t start_instance) override;
+
+private:
+	static constexpr int MAX_RENDER_TARGET = D3D12_SIMULTANEOUS_RENDER_TARGET_COUNT;
+	static constexpr int MAX_BARRIER = 16;	//1回のResourceBarrierにまとめる数(超えた分は分けて呼ぶ)
+
+	ID3D12GraphicsCommandList	*command_list_;
+};
+
+#endif
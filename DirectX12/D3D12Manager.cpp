@@ -1,952 +1,1833 @@
-#include <fstream>
-#include "D3D12Manager.h"
-
-D3D12Manager::D3D12Manager(HWND hwnd, int window_width, int window_height):
-	window_handle_(hwnd),
-	window_width_(window_width),
-	window_height_(window_height),
-	frames_{},
-	rtv_index_{}{
-
-	CreateFactory();
-	CreateDevice();
-	CreateCommandQueue();
-	CreateSwapChain();
-	CreateRenderTargetView();
-	CreateDepthStencilBuffer();
-	CreateCommandList();
-	CreateRootSignature();
-	CreatePipelineStateObject();
-	CreateLightBuffer();
-	CreateShadowBuffer();
-	CreateShadowMapPipelineState();
-
-	viewport_.TopLeftX = 0.f; 
-	viewport_.TopLeftY = 0.f;
-	viewport_.Width    = (FLOAT)window_width_;
-	viewport_.Height   = (FLOAT)window_height_;
-	viewport_.MinDepth = 0.f;
-	viewport_.MaxDepth = 1.f;
-
-	scissor_rect_.top    = 0;
-	scissor_rect_.left   = 0;
-	scissor_rect_.right  = window_width_;
-	scissor_rect_.bottom = window_height_;
-
-	plane_.Initialize(device_.Get(), shadow_buffer_.Get());
-	sphere_.Initialize(device_.Get(), shadow_buffer_.Get());
-	sm_debug_.Initialize(device_.Get());
-
-}
-
-D3D12Manager::~D3D12Manager(){}
-
-
-//t@Ng̍쐬
-HRESULT D3D12Manager::CreateFactory(){
-	HRESULT hr{};
-	UINT flag{};
-
-	//fobO[h̏ꍇ̓fobOC[Lɂ
-#if defined(_DEBUG)
-	{
-		ComPtr<ID3D12Debug> debug;
-		hr = D3D12GetDebugInterface(IID_PPV_ARGS(debug.GetAddressOf()));
-		if(FAILED(hr)){
-			return hr;
-		}
-		debug->EnableDebugLayer();
-	}
-
-	flag |= DXGI_CREATE_FACTORY_DEBUG;
-#endif
-
-	//t@Ng̍쐬
-	hr = CreateDXGIFactory2(flag, IID_PPV_ARGS(factory_.GetAddressOf()));
-
-	return hr;
-}
-
-
-//foCX̍쐬
-HRESULT D3D12Manager::CreateDevice(){
-	HRESULT hr{};
-
-	//ŏɌA_v^[gp
-	hr = factory_->EnumAdapters(0, (IDXGIAdapter**)adapter_.GetAddressOf());
-	
-	if(SUCCEEDED(hr)){
-
-		//A_v^gpăfoCX쐬
-		hr = D3D12CreateDevice(adapter_.Get(), D3D_FEATURE_LEVEL_11_1, IID_PPV_ARGS(&device_));
-
-	}
-
-	return hr;
-}
-
-
-//R}hL[̍쐬
-HRESULT D3D12Manager::CreateCommandQueue(){
-	HRESULT hr{};
-	D3D12_COMMAND_QUEUE_DESC command_queue_desc{};
-
-	// R}hL[𐶐.
-	command_queue_desc.Type			= D3D12_COMMAND_LIST_TYPE_DIRECT;
-	command_queue_desc.Priority		= 0;
-	command_queue_desc.Flags		= D3D12_COMMAND_QUEUE_FLAG_NONE;
-	command_queue_desc.NodeMask		= 0;
-	hr = device_->CreateCommandQueue(&command_queue_desc, IID_PPV_ARGS(command_queue_.GetAddressOf()));
-	if (FAILED(hr)) {
-		return hr;
-	}
-
-	//R}hL[p̃tFX̐
-	fence_event_ = CreateEventEx(nullptr, FALSE, FALSE, EVENT_ALL_ACCESS);
-	if(fence_event_ == NULL ){
-		return E_FAIL;
-	}
-	hr = device_->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(queue_fence_.GetAddressOf()));
-	
-	return hr;
-}
-
-
-//Xbv`FC̍쐬
-HRESULT D3D12Manager::CreateSwapChain(){
-	HRESULT hr{};
-	DXGI_SWAP_CHAIN_DESC swap_chain_desc{};
-	ComPtr<IDXGISwapChain> swap_chain{};
-
-	swap_chain_desc.BufferDesc.Width	= window_width_;
-	swap_chain_desc.BufferDesc.Height	= window_height_;
-	swap_chain_desc.OutputWindow		= window_handle_;
-	swap_chain_desc.Windowed			= TRUE;
-	swap_chain_desc.BufferUsage			= DXGI_USAGE_RENDER_TARGET_OUTPUT;
-	swap_chain_desc.BufferCount			= RTV_NUM;//ƕ\łQ肽̂2w肷
-	swap_chain_desc.SwapEffect			= DXGI_SWAP_EFFECT_FLIP_DISCARD;
-	swap_chain_desc.Flags				= DXGI_SWAP_CHAIN_FLAG_ALLOW_MODE_SWITCH;
-	swap_chain_desc.BufferDesc.RefreshRate.Numerator   = 60;
-	swap_chain_desc.BufferDesc.RefreshRate.Denominator = 1;
-	swap_chain_desc.BufferDesc.Format			= DXGI_FORMAT_B8G8R8A8_UNORM;
-	swap_chain_desc.BufferDesc.ScanlineOrdering = DXGI_MODE_SCANLINE_ORDER_UNSPECIFIED;
-	swap_chain_desc.BufferDesc.Scaling			= DXGI_MODE_SCALING_UNSPECIFIED;
-	swap_chain_desc.SampleDesc.Count   = 1;
-	swap_chain_desc.SampleDesc.Quality = 0;
-	
-
-	hr = factory_->CreateSwapChain(command_queue_.Get(), &swap_chain_desc, swap_chain.GetAddressOf());
-	if(FAILED(hr)){
-		return hr;
-	}
-
-	hr = swap_chain->QueryInterface(swap_chain_.GetAddressOf());
-	if(FAILED(hr)){
-		return hr;
-	}
-
-	//Jg̃obNobt@̃CfbNX擾
-	rtv_index_ = swap_chain_->GetCurrentBackBufferIndex();
-
-	return S_OK;
-}
-
-
-//_[^[Qbg̍쐬
-HRESULT D3D12Manager::CreateRenderTargetView(){
-	HRESULT hr{};
-	D3D12_DESCRIPTOR_HEAP_DESC heap_desc{};
-
-	//RTVpfXNv^q[v̍쐬
-	heap_desc.NumDescriptors	= RTV_NUM;
-	heap_desc.Type				= D3D12_DESCRIPTOR_HEAP_TYPE_RTV;
-	heap_desc.Flags				= D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
-	heap_desc.NodeMask			= 0;
-	hr = device_->CreateDescriptorHeap(&heap_desc, IID_PPV_ARGS(dh_rtv_.GetAddressOf()));
-	if (FAILED(hr)) {
-		return hr;
-	}
-
-	//_[^[Qbg쐬鏈
-	UINT size = device_->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_RTV);
-	for(UINT i = 0; i < RTV_NUM; ++i){
-		//Xbv`FCobt@󂯎
-		hr = swap_chain_->GetBuffer(i, IID_PPV_ARGS(&render_target_[i]));
-		if(FAILED(hr)){
-			return hr;
-		}
-
-		//RenderTargetView쐬ăq[vfXNv^ɓo^
-		rtv_handle_[i] = dh_rtv_->GetCPUDescriptorHandleForHeapStart();
-		rtv_handle_[i].ptr += size * i;
-		device_->CreateRenderTargetView(render_target_[i].Get(), nullptr, rtv_handle_[i]);
-	}
-
-	return hr;
-}
-
-
-//[xobt@̍쐬
-HRESULT D3D12Manager::CreateDepthStencilBuffer(){
-	HRESULT hr;
-
-	//[xobt@p̃fXNv^q[v̍쐬
-	D3D12_DESCRIPTOR_HEAP_DESC descriptor_heap_desc{};
-	descriptor_heap_desc.NumDescriptors = 1; 
-	descriptor_heap_desc.Type			= D3D12_DESCRIPTOR_HEAP_TYPE_DSV; 
-	descriptor_heap_desc.Flags			= D3D12_DESCRIPTOR_HEAP_FLAG_NONE; 
-	descriptor_heap_desc.NodeMask		= 0;
-	hr = device_->CreateDescriptorHeap(&descriptor_heap_desc, IID_PPV_ARGS(&dh_dsv_));
-	if(FAILED(hr)){
-		return hr;
-	}
-
-
-	//[xobt@̍쐬
-	D3D12_HEAP_PROPERTIES heap_properties{};
-	D3D12_RESOURCE_DESC resource_desc{};
-	D3D12_CLEAR_VALUE clear_value{};
-
-	heap_properties.Type					= D3D12_HEAP_TYPE_DEFAULT;
-	heap_properties.CPUPageProperty			= D3D12_CPU_PAGE_PROPERTY_UNKNOWN;
-	heap_properties.MemoryPoolPreference	= D3D12_MEMORY_POOL_UNKNOWN;
-	heap_properties.CreationNodeMask		= 0;
-	heap_properties.VisibleNodeMask			= 0;
-
-	resource_desc.Dimension				= D3D12_RESOURCE_DIMENSION_TEXTURE2D;
-	resource_desc.Width					= window_width_;
-	resource_desc.Height				= window_height_;
-	resource_desc.DepthOrArraySize		= 1;
-	resource_desc.MipLevels				= 0;
-	resource_desc.Format				= DXGI_FORMAT_R32_TYPELESS;
-	resource_desc.Layout				= D3D12_TEXTURE_LAYOUT_UNKNOWN;
-	resource_desc.SampleDesc.Count		= 1;
-	resource_desc.SampleDesc.Quality	= 0;
-	resource_desc.Flags					= D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL;
-
-	clear_value.Format					= DXGI_FORMAT_D32_FLOAT;
-	clear_value.DepthStencil.Depth		= 1.0f;
-	clear_value.DepthStencil.Stencil	= 0;
-
-	hr = device_->CreateCommittedResource(&heap_properties, D3D12_HEAP_FLAG_NONE, &resource_desc, D3D12_RESOURCE_STATE_DEPTH_WRITE, &clear_value, IID_PPV_ARGS(&depth_buffer_));
-	if(FAILED(hr)){
-		return hr;
-	}
-
-
-	//[xobt@̃r[̍쐬
-	D3D12_DEPTH_STENCIL_VIEW_DESC dsv_desc{};
-
-	dsv_desc.ViewDimension		= D3D12_DSV_DIMENSION_TEXTURE2D;
-	dsv_desc.Format				= DXGI_FORMAT_D32_FLOAT;
-	dsv_desc.Texture2D.MipSlice = 0;
-	dsv_desc.Flags				= D3D12_DSV_FLAG_NONE;
-
-	dsv_handle_ = dh_dsv_->GetCPUDescriptorHandleForHeapStart();
-
-	device_->CreateDepthStencilView(depth_buffer_.Get(), &dsv_desc, dsv_handle_);
-
-	return hr;
-}
-
-//R}hXg̍쐬
-HRESULT D3D12Manager::CreateCommandList(){
-	HRESULT hr;
-
-	//R}hAP[^̍쐬
-	hr = device_->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(&command_allocator_));
-	if (FAILED(hr)) {
-		return hr;
-	}
-
-	//R}hAP[^ƃoChăR}hXg쐬
-	hr = device_->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, command_allocator_.Get(), nullptr, IID_PPV_ARGS(&command_list_));
-	
-	return hr;
-}
-
-
-//ʏ`p̃[gVOl`̍쐬
-HRESULT D3D12Manager::CreateRootSignature(){
-	HRESULT hr{};
-	D3D12_DESCRIPTOR_RANGE		range[2]{};
-	D3D12_ROOT_PARAMETER		root_parameters[4]{};
-	D3D12_ROOT_SIGNATURE_DESC	root_signature_desc{};
-	D3D12_STATIC_SAMPLER_DESC	sampler_desc[2]{};
-	ComPtr<ID3DBlob> blob{};
-
-	//ϊsp̒萔obt@	
-	root_parameters[0].ParameterType				= D3D12_ROOT_PARAMETER_TYPE_CBV;
-	root_parameters[0].ShaderVisibility				= D3D12_SHADER_VISIBILITY_ALL;
-	root_parameters[0].Descriptor.ShaderRegister	= 0;
-	root_parameters[0].Descriptor.RegisterSpace		= 0;
-
-	//Cgp̒萔obt@
-	root_parameters[1].ParameterType				= D3D12_ROOT_PARAMETER_TYPE_CBV;
-	root_parameters[1].ShaderVisibility				= D3D12_SHADER_VISIBILITY_ALL;
-	root_parameters[1].Descriptor.ShaderRegister	= 1;
-	root_parameters[1].Descriptor.RegisterSpace		= 0;
-
-
-	//eNX`
-	range[0].NumDescriptors     = 2;
-	range[0].BaseShaderRegister = 0;
-	range[0].RangeType          = D3D12_DESCRIPTOR_RANGE_TYPE_SRV;
-	range[0].OffsetInDescriptorsFromTableStart = D3D12_DESCRIPTOR_RANGE_OFFSET_APPEND;
-
-	root_parameters[2].ParameterType				= D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE;
-	root_parameters[2].ShaderVisibility				= D3D12_SHADER_VISIBILITY_ALL;
-	root_parameters[2].DescriptorTable.NumDescriptorRanges = 1;
-	root_parameters[2].DescriptorTable.pDescriptorRanges   = &range[0];
-
-
-	//Tv
-	sampler_desc[0].Filter				= D3D12_FILTER_MIN_MAG_MIP_LINEAR;
-	sampler_desc[0].AddressU			= D3D12_TEXTURE_ADDRESS_MODE_WRAP;
-	sampler_desc[0].AddressV			= D3D12_TEXTURE_ADDRESS_MODE_WRAP;
-	sampler_desc[0].AddressW			= D3D12_TEXTURE_ADDRESS_MODE_WRAP;
-	sampler_desc[0].MipLODBias			= 0.0f;
-	sampler_desc[0].MaxAnisotropy		= 16;
-	sampler_desc[0].ComparisonFunc		= D3D12_COMPARISON_FUNC_NEVER;
-	sampler_desc[0].BorderColor			= D3D12_STATIC_BORDER_COLOR_TRANSPARENT_BLACK;
-	sampler_desc[0].MinLOD				= 0.0f;
-	sampler_desc[0].MaxLOD				= D3D12_FLOAT32_MAX;
-	sampler_desc[0].ShaderRegister		= 0;
-	sampler_desc[0].RegisterSpace		= 0;
-	sampler_desc[0].ShaderVisibility	= D3D12_SHADER_VISIBILITY_ALL;
-
-	sampler_desc[1].Filter				= D3D12_FILTER_MIN_MAG_MIP_LINEAR;
-	sampler_desc[1].AddressU			= D3D12_TEXTURE_ADDRESS_MODE_BORDER;
-	sampler_desc[1].AddressV			= D3D12_TEXTURE_ADDRESS_MODE_BORDER;
-	sampler_desc[1].AddressW			= D3D12_TEXTURE_ADDRESS_MODE_BORDER;
-	sampler_desc[1].MipLODBias			= 0.0f;
-	sampler_desc[1].MaxAnisotropy		= 16;
-	sampler_desc[1].ComparisonFunc		= D3D12_COMPARISON_FUNC_NEVER;
-	sampler_desc[1].BorderColor			= D3D12_STATIC_BORDER_COLOR_OPAQUE_WHITE;
-	sampler_desc[1].MinLOD				= 0.0f;
-	sampler_desc[1].MaxLOD				= D3D12_FLOAT32_MAX;
-	sampler_desc[1].ShaderRegister		= 1;
-	sampler_desc[1].RegisterSpace		= 0;
-	sampler_desc[1].ShaderVisibility	= D3D12_SHADER_VISIBILITY_ALL;
-
-
-	root_signature_desc.Flags				= D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT;
-	root_signature_desc.NumParameters		= _countof(root_parameters);
-	root_signature_desc.pParameters			= root_parameters;
-	root_signature_desc.NumStaticSamplers	= _countof(sampler_desc);
-	root_signature_desc.pStaticSamplers		= sampler_desc;
-
-	hr = D3D12SerializeRootSignature(&root_signature_desc, D3D_ROOT_SIGNATURE_VERSION_1, &blob, nullptr);
-	if(FAILED(hr)){
-		return hr;
-	}
-	hr = device_->CreateRootSignature(0, blob->GetBufferPointer(), blob->GetBufferSize(), IID_PPV_ARGS(&root_sugnature_));
-	
-	return hr;
-}
-
-
-//ʏ`p̃pCvCXe[g̍쐬
-HRESULT D3D12Manager::CreatePipelineStateObject(){
-	HRESULT hr;
-	ComPtr<ID3DBlob> vertex_shader{};
-	ComPtr<ID3DBlob> pixel_shader{};
-
-#if defined(_DEBUG)
-	UINT compile_flag = D3DCOMPILE_DEBUG | D3DCOMPILE_SKIP_OPTIMIZATION;
-#else
-	UINT compile_flag = 0;
-#endif
-
-	hr = D3DCompileFromFile(L"Shaders.hlsl", nullptr, nullptr, "VSMain", "vs_5_0", compile_flag, 0, vertex_shader.GetAddressOf(), nullptr);
-	if(FAILED(hr)){
-		return hr;
-	}
-
-	hr = D3DCompileFromFile(L"Shaders.hlsl", nullptr, nullptr, "PSMain", "ps_5_0", compile_flag, 0, &pixel_shader, nullptr);
-	if(FAILED(hr)){
-		return hr;
-	}
-
-
-	// _CAEg.
-	D3D12_INPUT_ELEMENT_DESC InputElementDesc[] = {
-		{ "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0,  0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
-		{ "NORMAL",   0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 12, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
-		{ "TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT,    0, 24, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
-	};
-
-	D3D12_GRAPHICS_PIPELINE_STATE_DESC pipeline_state_desc{};
-
-	//VF[_[̐ݒ
-	pipeline_state_desc.VS.pShaderBytecode = vertex_shader->GetBufferPointer();
-	pipeline_state_desc.VS.BytecodeLength  = vertex_shader->GetBufferSize();
-	pipeline_state_desc.PS.pShaderBytecode = pixel_shader->GetBufferPointer();
-	pipeline_state_desc.PS.BytecodeLength  = pixel_shader->GetBufferSize();
-
-
-	//CvbgCAEg̐ݒ
-	pipeline_state_desc.InputLayout.pInputElementDescs	= InputElementDesc;
-	pipeline_state_desc.InputLayout.NumElements			= _countof(InputElementDesc);
-
-
-	//Tvn̐ݒ
-	pipeline_state_desc.SampleDesc.Count	= 1;
-	pipeline_state_desc.SampleDesc.Quality	= 0;
-	pipeline_state_desc.SampleMask			= UINT_MAX;
-
-	//_[^[Qbg̐ݒ
-	pipeline_state_desc.NumRenderTargets = 1;
-	pipeline_state_desc.RTVFormats[0]    = DXGI_FORMAT_B8G8R8A8_UNORM;
-
-	//Op`ɐݒ
-	pipeline_state_desc.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
-
-
-	//[gVOl`
-	pipeline_state_desc.pRootSignature = root_sugnature_.Get();
-
-
-	//X^CUXe[g̐ݒ
-	pipeline_state_desc.RasterizerState.CullMode				= D3D12_CULL_MODE_BACK;
-	pipeline_state_desc.RasterizerState.FillMode				= D3D12_FILL_MODE_SOLID;
-	pipeline_state_desc.RasterizerState.FrontCounterClockwise	= FALSE;
-	pipeline_state_desc.RasterizerState.DepthBias				= 0;
-	pipeline_state_desc.RasterizerState.DepthBiasClamp			= 0;
-	pipeline_state_desc.RasterizerState.SlopeScaledDepthBias	= 0;
-	pipeline_state_desc.RasterizerState.DepthClipEnable			= TRUE;
-	pipeline_state_desc.RasterizerState.ConservativeRaster		= D3D12_CONSERVATIVE_RASTERIZATION_MODE_OFF;
-	pipeline_state_desc.RasterizerState.AntialiasedLineEnable	= FALSE;
-	pipeline_state_desc.RasterizerState.MultisampleEnable		= FALSE;
-
-
-	//uhXe[g̐ݒ
-	for(int i = 0; i < _countof(pipeline_state_desc.BlendState.RenderTarget); ++i){
-		pipeline_state_desc.BlendState.RenderTarget[i].BlendEnable				= FALSE;
-		pipeline_state_desc.BlendState.RenderTarget[i].SrcBlend					= D3D12_BLEND_ONE;
-		pipeline_state_desc.BlendState.RenderTarget[i].DestBlend				= D3D12_BLEND_ZERO;
-		pipeline_state_desc.BlendState.RenderTarget[i].BlendOp					= D3D12_BLEND_OP_ADD;
-		pipeline_state_desc.BlendState.RenderTarget[i].SrcBlendAlpha			= D3D12_BLEND_ONE;
-		pipeline_state_desc.BlendState.RenderTarget[i].DestBlendAlpha			= D3D12_BLEND_ZERO;
-		pipeline_state_desc.BlendState.RenderTarget[i].BlendOpAlpha				= D3D12_BLEND_OP_ADD;
-		pipeline_state_desc.BlendState.RenderTarget[i].RenderTargetWriteMask	= D3D12_COLOR_WRITE_ENABLE_ALL;
-		pipeline_state_desc.BlendState.RenderTarget[i].LogicOpEnable			= FALSE;
-		pipeline_state_desc.BlendState.RenderTarget[i].LogicOp					= D3D12_LOGIC_OP_CLEAR;
-	}
-	pipeline_state_desc.BlendState.AlphaToCoverageEnable  = FALSE;
-	pipeline_state_desc.BlendState.IndependentBlendEnable = FALSE;
-
-
-	//fvXXeVXe[g̐ݒ
-	pipeline_state_desc.DepthStencilState.DepthEnable		= TRUE;								//[xeXg
-	pipeline_state_desc.DepthStencilState.DepthFunc			= D3D12_COMPARISON_FUNC_LESS_EQUAL;
-	pipeline_state_desc.DepthStencilState.DepthWriteMask	= D3D12_DEPTH_WRITE_MASK_ALL;
-	pipeline_state_desc.DepthStencilState.StencilEnable		= FALSE;							//XeVeXgȂ
-	pipeline_state_desc.DepthStencilState.StencilReadMask	= D3D12_DEFAULT_STENCIL_READ_MASK;
-	pipeline_state_desc.DepthStencilState.StencilWriteMask	= D3D12_DEFAULT_STENCIL_WRITE_MASK;
-
-	pipeline_state_desc.DepthStencilState.FrontFace.StencilFailOp		= D3D12_STENCIL_OP_KEEP;
-	pipeline_state_desc.DepthStencilState.FrontFace.StencilDepthFailOp	= D3D12_STENCIL_OP_KEEP;
-	pipeline_state_desc.DepthStencilState.FrontFace.StencilPassOp		= D3D12_STENCIL_OP_KEEP;
-	pipeline_state_desc.DepthStencilState.FrontFace.StencilFunc			= D3D12_COMPARISON_FUNC_ALWAYS;
-
-	pipeline_state_desc.DepthStencilState.BackFace.StencilFailOp		= D3D12_STENCIL_OP_KEEP;
-	pipeline_state_desc.DepthStencilState.BackFace.StencilDepthFailOp	= D3D12_STENCIL_OP_KEEP;
-	pipeline_state_desc.DepthStencilState.BackFace.StencilPassOp		= D3D12_STENCIL_OP_KEEP;
-	pipeline_state_desc.DepthStencilState.BackFace.StencilFunc			= D3D12_COMPARISON_FUNC_ALWAYS;
-
-	pipeline_state_desc.DSVFormat = DXGI_FORMAT_D32_FLOAT;
-
-	hr = device_->CreateGraphicsPipelineState(&pipeline_state_desc, IID_PPV_ARGS(&pipeline_state_));
-	
-	return hr;
-}
-
-
-//Cgp萔obt@̍쐬
-HRESULT D3D12Manager::CreateLightBuffer(){
-	HRESULT hr{};
-	D3D12_HEAP_PROPERTIES heap_properties{};
-	D3D12_RESOURCE_DESC   resource_desc{};
-
-	heap_properties.Type					= D3D12_HEAP_TYPE_UPLOAD;
-	heap_properties.CPUPageProperty			= D3D12_CPU_PAGE_PROPERTY_UNKNOWN;
-	heap_properties.MemoryPoolPreference	= D3D12_MEMORY_POOL_UNKNOWN;
-	heap_properties.CreationNodeMask		= 0;
-	heap_properties.VisibleNodeMask			= 0;
-
-	resource_desc.Dimension				= D3D12_RESOURCE_DIMENSION_BUFFER;
-	resource_desc.Width					= 256;
-	resource_desc.Height				= 1;
-	resource_desc.DepthOrArraySize		= 1;
-	resource_desc.MipLevels				= 1;
-	resource_desc.Format				= DXGI_FORMAT_UNKNOWN;
-	resource_desc.Layout				= D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
-	resource_desc.SampleDesc.Count		= 1;
-	resource_desc.SampleDesc.Quality	= 0;
-
-
-	hr = device_->CreateCommittedResource(&heap_properties, D3D12_HEAP_FLAG_NONE, &resource_desc, D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(&light_buffer_));
-	if(FAILED(hr)){
-		return hr;
-	}
-
-
-	viewport_sm_.TopLeftX	= 0.f; 
-	viewport_sm_.TopLeftY	= 0.f;
-	viewport_sm_.Width		= 1024.0f;
-	viewport_sm_.Height		= 1024.0f;
-	viewport_sm_.MinDepth	= 0.f;
-	viewport_sm_.MaxDepth	= 1.f;
-
-	scissor_rect_sm_.top    = 0;
-	scissor_rect_sm_.left   = 0;
-	scissor_rect_sm_.right  = 1024;
-	scissor_rect_sm_.bottom = 1024;
-
-
-	struct Light{
-		XMFLOAT4X4 light_vp;
-		XMFLOAT4 color;
-		XMFLOAT3 dir;
-	};
-
-	Light *p{};
-	hr = light_buffer_->Map(0, nullptr, (void**)&p);
-	if(FAILED(hr)){
-		return hr;
-	}
-
-	light_pos_ = {2.0f, 6.5f, -1.0f};
-	light_dst_ = {0.0f, 0.0f, 0.0f};
-	light_dir_ = {
-		light_pos_.x - light_dst_.x,
-		light_pos_.y - light_dst_.y,
-		light_pos_.z - light_dst_.z
-	};
-	iight_color_ = {1.0f, 1.0f, 1.0f, 1.0f};
-	XMMATRIX view = XMMatrixLookAtLH(
-		{light_pos_.x, light_pos_.y, light_pos_.z},
-		{light_dst_.x, light_dst_.y, light_dst_.z},
-		{0.0f, 1.0f, 0.0f}
-	);
-
-	XMMATRIX projection = XMMatrixPerspectiveFovLH(XMConvertToRadians(45.0f), 1.0f, 1.0f, 15.0f);
-	XMFLOAT4X4 mat;
-	XMStoreFloat4x4(&mat, XMMatrixTranspose(view * projection));
-
-
-	p->light_vp = mat;
-	p->dir = light_dir_;
-	p->color = iight_color_;
-	
-
-	light_buffer_->Unmap(0, nullptr);
-	p = nullptr;
-
-	return hr;
-}
-
-
-//Vh[}bsOp̐[xobt@̍쐬
-HRESULT D3D12Manager::CreateShadowBuffer(){
-	HRESULT hr;
-
-
-	D3D12_DESCRIPTOR_HEAP_DESC descriptor_heap_desc{};
-	descriptor_heap_desc.NumDescriptors = 1; 
-	descriptor_heap_desc.Type			= D3D12_DESCRIPTOR_HEAP_TYPE_DSV; 
-	descriptor_heap_desc.Flags			= D3D12_DESCRIPTOR_HEAP_FLAG_NONE; 
-	descriptor_heap_desc.NodeMask		= 0;
-	hr = device_->CreateDescriptorHeap(&descriptor_heap_desc, IID_PPV_ARGS(&dh_shadow_buffer_));
-	if(FAILED(hr)){
-		return hr;
-	}
-
-	descriptor_heap_desc.Type			= D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV; 
-	descriptor_heap_desc.Flags			= D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE; 
-	hr = device_->CreateDescriptorHeap(&descriptor_heap_desc, IID_PPV_ARGS(&dh_shadow_texture_));
-	if(FAILED(hr)){
-		return hr;
-	}
-
-
-	D3D12_HEAP_PROPERTIES heap_properties{};
-	D3D12_RESOURCE_DESC resource_desc{};
-	D3D12_CLEAR_VALUE clear_value{};
-	heap_properties.Type					= D3D12_HEAP_TYPE_DEFAULT;
-	heap_properties.CPUPageProperty			= D3D12_CPU_PAGE_PROPERTY_UNKNOWN;
-	heap_properties.MemoryPoolPreference	= D3D12_MEMORY_POOL_UNKNOWN;
-	heap_properties.CreationNodeMask		= 0;
-	heap_properties.VisibleNodeMask			= 0;
-
-
-	resource_desc.Dimension				= D3D12_RESOURCE_DIMENSION_TEXTURE2D;
-	resource_desc.Width					= 1024;
-	resource_desc.Height				= 1024;
-	resource_desc.DepthOrArraySize		= 1;
-	resource_desc.MipLevels				= 0;
-	resource_desc.Format				= DXGI_FORMAT_R32_TYPELESS;
-	resource_desc.Layout				= D3D12_TEXTURE_LAYOUT_UNKNOWN;
-	resource_desc.SampleDesc.Count		= 1;
-	resource_desc.SampleDesc.Quality	= 0;
-	resource_desc.Flags					= D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL;
-
-	clear_value.Format					= DXGI_FORMAT_D32_FLOAT;
-	clear_value.DepthStencil.Depth		= 1.0f;
-	clear_value.DepthStencil.Stencil	= 0;
-
-	hr = device_->CreateCommittedResource(&heap_properties, D3D12_HEAP_FLAG_NONE, &resource_desc, D3D12_RESOURCE_STATE_GENERIC_READ, &clear_value, IID_PPV_ARGS(&shadow_buffer_));
-	if(FAILED(hr)){
-		return hr;
-	}
-
-
-	//[xobt@̃r[̍쐬
-	D3D12_DEPTH_STENCIL_VIEW_DESC dsv_desc{};
-	dsv_desc.ViewDimension		= D3D12_DSV_DIMENSION_TEXTURE2D;
-	dsv_desc.Format				= DXGI_FORMAT_D32_FLOAT;
-	dsv_desc.Texture2D.MipSlice = 0;
-	dsv_desc.Flags				= D3D12_DSV_FLAG_NONE;
-	device_->CreateDepthStencilView(shadow_buffer_.Get(), &dsv_desc, dh_shadow_buffer_->GetCPUDescriptorHandleForHeapStart());
-
-
-
-	D3D12_SHADER_RESOURCE_VIEW_DESC resourct_view_desc{};
-	resourct_view_desc.Format							= DXGI_FORMAT_R32_FLOAT;
-	resourct_view_desc.ViewDimension					= D3D12_SRV_DIMENSION_TEXTURE2D;
-	resourct_view_desc.Texture2D.MipLevels				= 1;
-	resourct_view_desc.Texture2D.MostDetailedMip		= 0;
-	resourct_view_desc.Texture2D.PlaneSlice				= 0;
-	resourct_view_desc.Texture2D.ResourceMinLODClamp	= 0.0F;
-	resourct_view_desc.Shader4ComponentMapping			= D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
-	device_->CreateShaderResourceView(shadow_buffer_.Get(), &resourct_view_desc, dh_shadow_texture_->GetCPUDescriptorHandleForHeapStart());
-
-	return hr;
-}
-
-
-//Vh[}bsOp̃pCvCXe[g̍쐬
-HRESULT D3D12Manager::CreateShadowMapPipelineState(){
-	HRESULT hr;
-	ComPtr<ID3DBlob> vertex_shader{};
-
-#if defined(_DEBUG)
-	UINT compile_flag = D3DCOMPILE_DEBUG | D3DCOMPILE_SKIP_OPTIMIZATION;
-#else
-	UINT compile_flag = 0;
-#endif
-
-	hr = D3DCompileFromFile(L"Shaders.hlsl", nullptr, nullptr, "VSShadowMap", "vs_5_0", compile_flag, 0, vertex_shader.GetAddressOf(), nullptr);
-	if(FAILED(hr)){
-		return hr;
-	}
-
-
-	// _CAEg.
-	D3D12_INPUT_ELEMENT_DESC InputElementDesc[] = {
-		{ "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0,  0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
-		{ "NORMAL",   0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 12, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
-		{ "TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT,    0, 24, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
-	};
-
-	D3D12_GRAPHICS_PIPELINE_STATE_DESC pipeline_state_desc{};
-
-	//VF[_[̐ݒ
-	pipeline_state_desc.VS.pShaderBytecode = vertex_shader->GetBufferPointer();
-	pipeline_state_desc.VS.BytecodeLength  = vertex_shader->GetBufferSize();
-
-
-	//CvbgCAEg̐ݒ
-	pipeline_state_desc.InputLayout.pInputElementDescs	= InputElementDesc;
-	pipeline_state_desc.InputLayout.NumElements			= _countof(InputElementDesc);
-
-
-	//Tvn̐ݒ
-	pipeline_state_desc.SampleDesc.Count	= 1;
-	pipeline_state_desc.SampleDesc.Quality	= 0;
-	pipeline_state_desc.SampleMask			= UINT_MAX;
-
-	//Op`ɐݒ
-	pipeline_state_desc.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
-
-
-	//[gVOl`
-	pipeline_state_desc.pRootSignature = root_sugnature_.Get();
-
-
-	//X^CUXe[g̐ݒ
-	pipeline_state_desc.RasterizerState.CullMode				= D3D12_CULL_MODE_NONE;//D3D12_CULL_MODE_BACK;
-	pipeline_state_desc.RasterizerState.FillMode				= D3D12_FILL_MODE_SOLID;
-	pipeline_state_desc.RasterizerState.FrontCounterClockwise	= FALSE;
-	pipeline_state_desc.RasterizerState.DepthBias				= 0;
-	pipeline_state_desc.RasterizerState.DepthBiasClamp			= 0;
-	pipeline_state_desc.RasterizerState.SlopeScaledDepthBias	= 0;
-	pipeline_state_desc.RasterizerState.DepthClipEnable			= TRUE;
-	pipeline_state_desc.RasterizerState.ConservativeRaster		= D3D12_CONSERVATIVE_RASTERIZATION_MODE_OFF;
-	pipeline_state_desc.RasterizerState.AntialiasedLineEnable	= FALSE;
-	pipeline_state_desc.RasterizerState.MultisampleEnable		= FALSE;
-
-
-	//uhXe[g̐ݒ
-	pipeline_state_desc.BlendState.RenderTarget[0].BlendEnable				= FALSE;
-	pipeline_state_desc.BlendState.RenderTarget[0].SrcBlend					= D3D12_BLEND_ONE;
-	pipeline_state_desc.BlendState.RenderTarget[0].DestBlend				= D3D12_BLEND_ZERO;
-	pipeline_state_desc.BlendState.RenderTarget[0].BlendOp					= D3D12_BLEND_OP_ADD;
-	pipeline_state_desc.BlendState.RenderTarget[0].SrcBlendAlpha			= D3D12_BLEND_ONE;
-	pipeline_state_desc.BlendState.RenderTarget[0].DestBlendAlpha			= D3D12_BLEND_ZERO;
-	pipeline_state_desc.BlendState.RenderTarget[0].BlendOpAlpha				= D3D12_BLEND_OP_ADD;
-	pipeline_state_desc.BlendState.RenderTarget[0].RenderTargetWriteMask	= D3D12_COLOR_WRITE_ENABLE_ALL;
-	pipeline_state_desc.BlendState.RenderTarget[0].LogicOpEnable			= FALSE;
-	pipeline_state_desc.BlendState.RenderTarget[0].LogicOp					= D3D12_LOGIC_OP_CLEAR;
-	
-	pipeline_state_desc.BlendState.AlphaToCoverageEnable  = FALSE;
-	pipeline_state_desc.BlendState.IndependentBlendEnable = FALSE;
-
-
-	//fvXXeVXe[g̐ݒ
-	pipeline_state_desc.DepthStencilState.DepthEnable		= TRUE;								//[xeXg
-	pipeline_state_desc.DepthStencilState.DepthFunc			= D3D12_COMPARISON_FUNC_LESS_EQUAL;
-	pipeline_state_desc.DepthStencilState.DepthWriteMask	= D3D12_DEPTH_WRITE_MASK_ALL;
-	pipeline_state_desc.DepthStencilState.StencilEnable		= FALSE;							//XeVeXgȂ
-	pipeline_state_desc.DepthStencilState.StencilReadMask	= D3D12_DEFAULT_STENCIL_READ_MASK;
-	pipeline_state_desc.DepthStencilState.StencilWriteMask	= D3D12_DEFAULT_STENCIL_WRITE_MASK;
-
-	pipeline_state_desc.DepthStencilState.FrontFace.StencilFailOp		= D3D12_STENCIL_OP_KEEP;
-	pipeline_state_desc.DepthStencilState.FrontFace.StencilDepthFailOp	= D3D12_STENCIL_OP_KEEP;
-	pipeline_state_desc.DepthStencilState.FrontFace.StencilPassOp		= D3D12_STENCIL_OP_KEEP;
-	pipeline_state_desc.DepthStencilState.FrontFace.StencilFunc			= D3D12_COMPARISON_FUNC_ALWAYS;
-
-	pipeline_state_desc.DepthStencilState.BackFace.StencilFailOp		= D3D12_STENCIL_OP_KEEP;
-	pipeline_state_desc.DepthStencilState.BackFace.StencilDepthFailOp	= D3D12_STENCIL_OP_KEEP;
-	pipeline_state_desc.DepthStencilState.BackFace.StencilPassOp		= D3D12_STENCIL_OP_KEEP;
-	pipeline_state_desc.DepthStencilState.BackFace.StencilFunc			= D3D12_COMPARISON_FUNC_ALWAYS;
-
-	pipeline_state_desc.DSVFormat = DXGI_FORMAT_D32_FLOAT;
-
-	hr = device_->CreateGraphicsPipelineState(&pipeline_state_desc, IID_PPV_ARGS(&shadow_map_pso_));
-
-	return hr;
-}
-
-
-//`̏I҂
-HRESULT D3D12Manager::WaitForPreviousFrame(){
-	HRESULT hr;
-	
-	++frames_;
-	const UINT64 fence = frames_;
-
-
-	hr = command_queue_->Signal(queue_fence_.Get(), fence);
-	if(FAILED(hr)){
-		return hr; 
-	}
-
-	if (queue_fence_->GetCompletedValue() < fence){
-		hr = queue_fence_->SetEventOnCompletion(fence, fence_event_);
-		if(FAILED(hr)){
-			return hr; 
-		}
-
-		WaitForSingleObject(fence_event_, INFINITE);
-	}
-	return S_OK;
-}
-
-//\[X̐ݒύXp
-HRESULT D3D12Manager::SetResourceBarrier(ID3D12Resource* resource, D3D12_RESOURCE_STATES BeforeState, D3D12_RESOURCE_STATES AfterState){
-	D3D12_RESOURCE_BARRIER resource_barrier{};
-	
-	resource_barrier.Type  = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
-	resource_barrier.Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
-	resource_barrier.Transition.pResource   = resource;
-	resource_barrier.Transition.Subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES;
-	resource_barrier.Transition.StateBefore = BeforeState;
-	resource_barrier.Transition.StateAfter  = AfterState;
-
-	command_list_->ResourceBarrier(1, &resource_barrier);
-	return S_OK;
-}
-
-
-//`R}hς
-HRESULT D3D12Manager::PopulateCommandList(){
-	HRESULT hr;
-	
-	FLOAT clear_color[4] = {0.0f, 0.0f, 0.0f, 1.0f};
-
-	sphere_.Update();
-	plane_.Update();
-
-	//Vh[}bvp̐[xobt@̕`------------------------------------------------------------------------------------------
-
-	//Vh[}bvp̃eNX`[x݂ɐݒ
-	SetResourceBarrier(shadow_buffer_.Get(), D3D12_RESOURCE_STATE_GENERIC_READ, D3D12_RESOURCE_STATE_DEPTH_WRITE);
-
-	//Vh[}bvp̐[xobt@NA
-	command_list_->ClearDepthStencilView(dh_shadow_buffer_->GetCPUDescriptorHandleForHeapStart(), D3D12_CLEAR_FLAG_DEPTH, 1.0f, 0, 0, nullptr);
-
-
-	//[gVOl`PSO̐ݒ
-	command_list_->SetGraphicsRootSignature(root_sugnature_.Get());
-	command_list_->SetPipelineState(shadow_map_pso_.Get());
-
-
-	//r[|[gƃVU[`̐ݒ
-	command_list_->RSSetViewports(1, &viewport_sm_);
-	command_list_->RSSetScissorRects(1, &scissor_rect_sm_);
-
-
-	//[xobt@̐ݒ
-	command_list_->OMSetRenderTargets(0, nullptr, FALSE, &dh_shadow_buffer_->GetCPUDescriptorHandleForHeapStart());
-
-
-	//Cg̐ݒ
-	command_list_->SetGraphicsRootConstantBufferView(1, light_buffer_->GetGPUVirtualAddress());
-
-
-	//̕`
-	sphere_.Draw(command_list_.Get());
-
-
-	//|̕`
-	plane_.Draw(command_list_.Get());
-
-
-	//Vh[}bvp̃eNX`WFlbN[hɐݒ(̂Ɛݒ肷)
-	SetResourceBarrier(shadow_buffer_.Get(), D3D12_RESOURCE_STATE_DEPTH_WRITE, D3D12_RESOURCE_STATE_GENERIC_READ);
-	
-	hr = command_list_->Close();
-	ExecuteCommandList();
-
-
-
-
-	//ʏ̃f̕`------------------------------------------------------------------------------------------------------------
-	
-	
-	//\[X̏Ԃv[gp烌_[^[QbgpɕύX
-	SetResourceBarrier(render_target_[rtv_index_].Get(), D3D12_RESOURCE_STATE_PRESENT, D3D12_RESOURCE_STATE_RENDER_TARGET);
-
-
-	//[xobt@ƃ_[^[Qbg̃NA
-	command_list_->ClearDepthStencilView(dsv_handle_, D3D12_CLEAR_FLAG_DEPTH, 1.0f, 0, 0, nullptr);
-	command_list_->ClearRenderTargetView(rtv_handle_[rtv_index_], clear_color, 0, nullptr);
-	
-	//[gVOl`PSO̐ݒ
-	command_list_->SetGraphicsRootSignature(root_sugnature_.Get());
-	command_list_->SetPipelineState(pipeline_state_.Get());
-	
-	//r[|[gƃVU[`̐ݒ
-	command_list_->RSSetViewports(1, &viewport_);
-	command_list_->RSSetScissorRects(1, &scissor_rect_);
-
-	//_[^[Qbg̐ݒ
-	command_list_->OMSetRenderTargets(1, &rtv_handle_[rtv_index_], TRUE, &dsv_handle_);
-
-	//Cg̐ݒ
-	command_list_->SetGraphicsRootConstantBufferView(1, light_buffer_->GetGPUVirtualAddress());
-
-
-	//̕`
-	sphere_.Draw(command_list_.Get());
-	
-	hr = command_list_->Close();
-	ExecuteCommandList();
-
-
-
-
-
-
-	//[gVOl`PSO̐ݒ
-	command_list_->SetGraphicsRootSignature(root_sugnature_.Get());
-	command_list_->SetPipelineState(pipeline_state_.Get());
-
-	//r[|[gƃVU[`̐ݒ
-	command_list_->RSSetViewports(1, &viewport_);
-	command_list_->RSSetScissorRects(1, &scissor_rect_);
-
-	//_[^[Qbg̐ݒ
-	command_list_->OMSetRenderTargets(1, &rtv_handle_[rtv_index_], TRUE, &dsv_handle_);
-
-	//Cg̐ݒ
-	command_list_->SetGraphicsRootConstantBufferView(1, light_buffer_->GetGPUVirtualAddress());
-
-
-	//|̕`
-	plane_.Draw(command_list_.Get());
-	
-	hr = command_list_->Close();
-	ExecuteCommandList();
-
-
-	//[gVOl`PSO̐ݒ
-	command_list_->SetGraphicsRootSignature(root_sugnature_.Get());
-	command_list_->SetPipelineState(pipeline_state_.Get());
-
-	//r[|[gƃVU[`̐ݒ
-	command_list_->RSSetViewports(1, &viewport_);
-	command_list_->RSSetScissorRects(1, &scissor_rect_);
-
-	//_[^[Qbg̐ݒ
-	command_list_->OMSetRenderTargets(1, &rtv_handle_[rtv_index_], TRUE, &dsv_handle_);
-
-
-	//VhE}bṽfobO\
-	sm_debug_.Draw(command_list_.Get(), dh_shadow_texture_.Get());
-
-
-	//\[X̏Ԃ_[^[Qbgv[gpɕύX
-	SetResourceBarrier(render_target_[rtv_index_].Get(), D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PRESENT);
-
-	hr = command_list_->Close();
-	ExecuteCommandList();
-
-	return hr;
-}
-
-HRESULT D3D12Manager::ExecuteCommandList(){
-	HRESULT hr;
-
-	ID3D12CommandList *const command_lists = command_list_.Get();
-	command_queue_->ExecuteCommandLists(1, &command_lists);
-
-	//sR}h̏I҂
-	WaitForPreviousFrame();
-
-
-	hr = command_allocator_->Reset();
-	if(FAILED(hr)){
-		return hr; 
-	}
-
-	hr = command_list_->Reset(command_allocator_.Get(), nullptr);
-	if(FAILED(hr)){
-		return hr; 
-	}
-
-	return hr;
-}
-
-
-//ʂtbv
-HRESULT D3D12Manager::Render(){
-	HRESULT hr;
-
-
-	PopulateCommandList();
-
-
-	hr = swap_chain_->Present(1, 0);
-	if(FAILED(hr)){
-		return hr;
-	}
-
-	//Jg̃obNobt@̃CfbNX擾
-	rtv_index_ = swap_chain_->GetCurrentBackBufferIndex();
-
-	return S_OK;
-}
-
+#include <cmath>
+#include <fstream>
+#include "D3D12Manager.h"
+
+namespace{
+//深度バッファ・シャドウマップのリソースの設定(DSVとSRVの両方で使うためTYPELESSにする)
+D3D12_RESOURCE_DESC GetDepthBufferDesc(UINT64 width, UINT height, UINT16 array_size = 1){
+	D3D12_RESOURCE_DESC resource_desc{};
+	resource_desc.Dimension				= D3D12_RESOURCE_DIMENSION_TEXTURE2D;
+	resource_desc.Width					= width;
+	resource_desc.Height				= height;
+	resource_desc.DepthOrArraySize		= array_size;
+	resource_desc.MipLevels				= 0;
+	resource_desc.Format				= DXGI_FORMAT_R32_TYPELESS;
+	resource_desc.Layout				= D3D12_TEXTURE_LAYOUT_UNKNOWN;
+	resource_desc.SampleDesc.Count		= 1;
+	resource_desc.SampleDesc.Quality	= 0;
+	resource_desc.Flags					= D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL;
+	return resource_desc;
+}
+
+//EVSMのモーメントは32bitでないと正の指数の2次のモーメントが溢れる
+constexpr DXGI_FORMAT SHADOW_MOMENTS_FORMAT = DXGI_FORMAT_R32G32B32A32_FLOAT;
+
+//EVSMのモーメントのリソースの設定(シャドウマップと同じ大きさ・スライス数のレンダーターゲット)
+D3D12_RESOURCE_DESC GetShadowMomentsDesc(UINT64 width, UINT height, UINT16 array_size){
+	D3D12_RESOURCE_DESC resource_desc{};
+	resource_desc.Dimension				= D3D12_RESOURCE_DIMENSION_TEXTURE2D;
+	resource_desc.Width					= width;
+	resource_desc.Height				= height;
+	resource_desc.DepthOrArraySize		= array_size;
+	resource_desc.MipLevels				= 1;
+	resource_desc.Format				= SHADOW_MOMENTS_FORMAT;
+	resource_desc.Layout				= D3D12_TEXTURE_LAYOUT_UNKNOWN;
+	resource_desc.SampleDesc.Count		= 1;
+	resource_desc.SampleDesc.Quality	= 0;
+	resource_desc.Flags					= D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET;
+	return resource_desc;
+}
+
+//モーメントの配列のスライスごとのRTVと、配列全体のSRVを作る
+void CreateShadowMomentsViews(ID3D12Device *device, ID3D12Resource *resource, UINT array_size, const D3D12_CPU_DESCRIPTOR_HANDLE *rtv_handles, D3D12_CPU_DESCRIPTOR_HANDLE srv_handle){
+	D3D12_RENDER_TARGET_VIEW_DESC rtv_desc{};
+	rtv_desc.Format							= SHADOW_MOMENTS_FORMAT;
+	rtv_desc.ViewDimension					= D3D12_RTV_DIMENSION_TEXTURE2DARRAY;
+	rtv_desc.Texture2DArray.MipSlice		= 0;
+	rtv_desc.Texture2DArray.ArraySize		= 1;
+	rtv_desc.Texture2DArray.PlaneSlice		= 0;
+	for(UINT i = 0; i < array_size; ++i){
+		rtv_desc.Texture2DArray.FirstArraySlice = i;
+		device->CreateRenderTargetView(resource, &rtv_desc, rtv_handles[i]);
+	}
+
+	D3D12_SHADER_RESOURCE_VIEW_DESC srv_desc{};
+	srv_desc.Format								= SHADOW_MOMENTS_FORMAT;
+	srv_desc.ViewDimension						= D3D12_SRV_DIMENSION_TEXTURE2DARRAY;
+	srv_desc.Texture2DArray.MipLevels			= 1;
+	srv_desc.Texture2DArray.MostDetailedMip		= 0;
+	srv_desc.Texture2DArray.FirstArraySlice		= 0;
+	srv_desc.Texture2DArray.ArraySize			= array_size;
+	srv_desc.Texture2DArray.PlaneSlice			= 0;
+	srv_desc.Texture2DArray.ResourceMinLODClamp	= 0.0F;
+	srv_desc.Shader4ComponentMapping			= D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+	device->CreateShaderResourceView(resource, &srv_desc, srv_handle);
+}
+
+//まとめたバリアを1回で記録する
+void RecordBarriers(RenderCommandList *command_list, const std::vector<RenderBarrier> &barriers){
+	if(!barriers.empty()){
+		command_list->ResourceBarriers(static_cast<int>(barriers.size()), barriers.data());
+	}
+}
+
+//インスタンス描画の頂点レイアウト(スロット1にインスタンスごとのデータ)
+const D3D12_INPUT_ELEMENT_DESC INSTANCED_INPUT_ELEMENT_DESC[] = {
+	{ "POSITION",      0, DXGI_FORMAT_R32G32B32_FLOAT,    0,  0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA,   0 },
+	{ "NORMAL",        0, DXGI_FORMAT_R32G32B32_FLOAT,    0, 12, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA,   0 },
+	{ "TEXCOORD",      0, DXGI_FORMAT_R32G32_FLOAT,       0, 24, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA,   0 },
+	{ "WORLD",         0, DXGI_FORMAT_R32G32B32A32_FLOAT, 1,  0, D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA, 1 },
+	{ "WORLD",         1, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, 16, D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA, 1 },
+	{ "WORLD",         2, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, 32, D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA, 1 },
+	{ "TEXTURE_INDEX", 0, DXGI_FORMAT_R32_UINT,           1, 48, D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA, 1 },
+};
+}
+
+D3D12Manager::D3D12Manager(HWND hwnd, int window_width, int window_height):
+	window_handle_(hwnd),
+	window_width_(window_width),
+	window_height_(window_height),
+	rtv_index_{},
+	fence_event_{},
+	parallel_recording_(true),
+	graph_passes_{},
+	graph_resources_{},
+	frame_graph_dirty_(false),
+	pass_enabled_{},
+	show_shadow_map_(true),
+	transient_heap_size_{},
+	transient_offsets_{},
+	pipeline_state_(PipelineStateManager::INVALID_HANDLE),
+	pipeline_state_instanced_(PipelineStateManager::INVALID_HANDLE),
+	shadow_map_pso_(PipelineStateManager::INVALID_HANDLE),
+	shadow_map_instanced_pso_(PipelineStateManager::INVALID_HANDLE),
+	shadow_filter_(DEFAULT_SHADOW_FILTER),
+	shadow_blur_rtv_handles_{},
+	shadow_moments_rtv_handles_{},
+	shadow_blur_index_{},
+	shadow_moments_index_{},
+	shadow_blur_x_pso_(PipelineStateManager::INVALID_HANDLE),
+	shadow_blur_y_pso_(PipelineStateManager::INVALID_HANDLE),
+	light_constants_{},
+	camera_{},
+	shadow_dsv_handles_{},
+	shadow_cache_dsv_handles_{},
+	shadow_map_index_{},
+	shadow_casters_{},
+	frustums_{},
+	object_culler_{},
+	object_visible_{},
+	scene_{},
+	occlusion_culler_{},
+	frame_scheduler_(RTV_NUM),
+	io_jobs_(STREAM_THREAD_NUM){
+
+	StageTimer &t = startup_timer_;
+
+	//コンパイル済みシェーダのキャッシュ(なければ空のキャッシュとして始める)
+	t.Measure("ShaderCache::Open", [&]{return shader_cache_.Open(SHADER_CACHE_FILE);});
+
+	//デバイスに依存しない読み込み処理はワーカースレッドで先に始めておく
+	std::future<HRESULT> shader_job = jobs_.Push([&]{return t.Measure("CompileShaders", [&]{return CompileShaders();});});
+	std::future<HRESULT> plane_job  = jobs_.Push([&]{return t.Measure("Plane::Load", [&]{return plane_.Load();});});
+	std::future<HRESULT> sphere_job = jobs_.Push([&]{return t.Measure("Sphere::Load", [&]{return sphere_.Load();});});
+	std::future<HRESULT> debug_job  = jobs_.Push([&]{return t.Measure("ShadowMapDebug::Load", [&]{return sm_debug_.Load(&shader_cache_);});});
+
+	t.Measure("CreateFactory", [&]{return CreateFactory();});
+	t.Measure("CreateDevice", [&]{return CreateDevice();});
+	t.Measure("CreatePipelineStateManager", [&]{return CreatePipelineStateManager();});
+	t.Measure("CreateCommandQueue", [&]{return CreateCommandQueue();});
+	t.Measure("CreateUploader", [&]{return CreateUploader();});
+
+	//テクスチャは小さいレベルだけを転送して描画を始め、残りは描画しながら転送する
+	stream_target_.Initialize(&uploader_, command_queue_.Get(), queue_fence_.Get());
+	streamer_.Initialize(&stream_target_, &io_jobs_, STREAM_FRAME_BUDGET);
+	plane_.SetTextureStreamer(&streamer_);
+	sphere_.SetTextureStreamer(&streamer_);
+	t.Measure("CreateSwapChain", [&]{return CreateSwapChain();});
+	t.Measure("CreateRenderTargetView", [&]{return CreateRenderTargetView();});
+	t.Measure("CreateDepthStencilBuffer", [&]{return CreateDepthStencilBuffer();});
+	t.Measure("CreateCommandList", [&]{return CreateCommandList();});
+	t.Measure("CreateUploadBuffer", [&]{return CreateUploadBuffer();});
+	t.Measure("CreateBindlessHeap", [&]{return CreateBindlessHeap();});
+	t.Measure("CreateRootSignature", [&]{return CreateRootSignature();});
+	t.Measure("CreateLightBuffer", [&]{return CreateLightBuffer();});
+	t.Measure("CreateShadowBuffer", [&]{return CreateShadowBuffer();});
+	t.Measure("CreateFrameGraph", [&]{return CreateFrameGraph();});
+
+	//PSOの作成にはコンパイル済みのシェーダが必要
+	shader_job.get();
+	t.Measure("CreatePipelineStateObject", [&]{return CreatePipelineStateObject();});
+	t.Measure("CreateShadowMapPipelineState", [&]{return CreateShadowMapPipelineState();});
+	t.Measure("CreateShadowFilterPipelineState", [&]{return CreateShadowFilterPipelineState();});
+
+	viewport_.x			= 0.f; 
+	viewport_.y			= 0.f;
+	viewport_.width		= (FLOAT)window_width_;
+	viewport_.height	= (FLOAT)window_height_;
+	viewport_.min_depth	= 0.f;
+	viewport_.max_depth	= 1.f;
+
+	scissor_rect_.top    = 0;
+	scissor_rect_.left   = 0;
+	scissor_rect_.right  = window_width_;
+	scissor_rect_.bottom = window_height_;
+
+	//読み込みが終わったものから順にGPUのリソースを作成する
+	plane_job.get();
+	t.Measure("Plane::Initialize", [&]{return plane_.Initialize(device_.Get(), &uploader_, &bindless_heap_);});
+	sphere_job.get();
+	t.Measure("Sphere::Initialize", [&]{return sphere_.Initialize(device_.Get(), &uploader_, &bindless_heap_);});
+
+	//板ポリ・球の変換はシーンでまとめて求める
+	plane_.AddToScene(&scene_);
+	sphere_.AddToScene(&scene_);
+	debug_job.get();
+	t.Measure("ShadowMapDebug::Initialize", [&]{return sm_debug_.Initialize(device_.Get(), &uploader_, &pipeline_states_, SHADOW_CASCADE_NUM);});
+
+	//記録した転送をコピーキューに提出し、最初のフレームの描画はその完了をGPU側で待つ
+	uploader_.Flush();
+	t.Measure("CopyUploader::WaitOnQueue", [&]{return uploader_.WaitOnQueue(command_queue_.Get());});
+
+	//コンパイルしたシェーダがあれば次回の起動のために書き出す
+	if(shader_cache_.IsDirty()){
+		t.Measure("ShaderCache::Save", [&]{return shader_cache_.Save(SHADER_CACHE_FILE);});
+	}
+
+	t.Report("startup");
+}
+
+D3D12Manager::~D3D12Manager(){
+	//GPUが使用中のリソースを解放しないように、提出済みのフレームの完了を待つ
+	if(command_queue_ && queue_fence_ && fence_event_ != NULL){
+		WaitForGpu();
+	}
+
+	//作成中のPSOを待ち、新しく作成したものがあれば次回の起動のために書き出す
+	pipeline_states_.Save();
+
+	if(fence_event_ != NULL){
+		CloseHandle(fence_event_);
+	}
+}
+
+
+//ファクトリの作成
+HRESULT D3D12Manager::CreateFactory(){
+	HRESULT hr{};
+	UINT flag{};
+
+	//デバッグモードの場合はデバッグレイヤーを有効にする
+#if defined(_DEBUG)
+	{
+		ComPtr<ID3D12Debug> debug;
+		hr = D3D12GetDebugInterface(IID_PPV_ARGS(debug.GetAddressOf()));
+		if(FAILED(hr)){
+			return hr;
+		}
+		debug->EnableDebugLayer();
+	}
+
+	flag |= DXGI_CREATE_FACTORY_DEBUG;
+#endif
+
+	//ファクトリの作成
+	hr = CreateDXGIFactory2(flag, IID_PPV_ARGS(factory_.GetAddressOf()));
+
+	return hr;
+}
+
+
+//デバイスの作成
+HRESULT D3D12Manager::CreateDevice(){
+	HRESULT hr{};
+
+	//最初に見つかったアダプターを使用する
+	hr = factory_->EnumAdapters(0, (IDXGIAdapter**)adapter_.GetAddressOf());
+	
+	if(SUCCEEDED(hr)){
+
+		//見つかったアダプタを使用してデバイスを作成する
+		hr = D3D12CreateDevice(adapter_.Get(), D3D_FEATURE_LEVEL_11_1, IID_PPV_ARGS(&device_));
+
+	}
+
+	return hr;
+}
+
+
+//PSOの管理の初期化(前回の起動で保存したライブラリを読み込む)
+HRESULT D3D12Manager::CreatePipelineStateManager(){
+	return pipeline_states_.Initialize(device_.Get(), PIPELINE_LIBRARY_FILE, &jobs_);
+}
+
+
+//コマンドキューの作成
+HRESULT D3D12Manager::CreateCommandQueue(){
+	HRESULT hr{};
+	D3D12_COMMAND_QUEUE_DESC command_queue_desc{};
+
+	// コマンドキューを生成.
+	command_queue_desc.Type			= D3D12_COMMAND_LIST_TYPE_DIRECT;
+	command_queue_desc.Priority		= 0;
+	command_queue_desc.Flags		= D3D12_COMMAND_QUEUE_FLAG_NONE;
+	command_queue_desc.NodeMask		= 0;
+	hr = device_->CreateCommandQueue(&command_queue_desc, IID_PPV_ARGS(command_queue_.GetAddressOf()));
+	if (FAILED(hr)) {
+		return hr;
+	}
+
+	//コマンドキュー用のフェンスの生成
+	fence_event_ = CreateEventEx(nullptr, FALSE, FALSE, EVENT_ALL_ACCESS);
+	if(fence_event_ == NULL ){
+		return E_FAIL;
+	}
+	hr = device_->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(queue_fence_.GetAddressOf()));
+	
+	return hr;
+}
+
+
+//コピーキューとステージングの作成
+HRESULT D3D12Manager::CreateUploader(){
+	HRESULT hr;
+
+	//バッファ・テクスチャはブロック単位で確保したヒープに置く(ステージング自体は1つの大きなバッファなので別に作る)
+	//ブロックは予算を超えそうなときに使っていないものから退避する
+	residency_target_.Initialize(device_.Get(), adapter_.Get());
+	residency_.Initialize(&residency_target_);
+	hr = memory_allocator_.Initialize(device_.Get(), GpuMemoryAllocator::DEFAULT_BLOCK_SIZE, &residency_);
+	if(FAILED(hr)){
+		return hr;
+	}
+
+	return uploader_.Initialize(device_.Get(), STAGING_BUFFER_SIZE, &memory_allocator_);
+}
+
+
+//スワップチェインの作成
+HRESULT D3D12Manager::CreateSwapChain(){
+	HRESULT hr{};
+	DXGI_SWAP_CHAIN_DESC swap_chain_desc{};
+	ComPtr<IDXGISwapChain> swap_chain{};
+
+	swap_chain_desc.BufferDesc.Width	= window_width_;
+	swap_chain_desc.BufferDesc.Height	= window_height_;
+	swap_chain_desc.OutputWindow		= window_handle_;
+	swap_chain_desc.Windowed			= TRUE;
+	swap_chain_desc.BufferUsage			= DXGI_USAGE_RENDER_TARGET_OUTPUT;
+	swap_chain_desc.BufferCount			= RTV_NUM;//裏と表で２枚作りたいので2を指定する
+	swap_chain_desc.SwapEffect			= DXGI_SWAP_EFFECT_FLIP_DISCARD;
+	swap_chain_desc.Flags				= DXGI_SWAP_CHAIN_FLAG_ALLOW_MODE_SWITCH;
+	swap_chain_desc.BufferDesc.RefreshRate.Numerator   = 60;
+	swap_chain_desc.BufferDesc.RefreshRate.Denominator = 1;
+	swap_chain_desc.BufferDesc.Format			= DXGI_FORMAT_B8G8R8A8_UNORM;
+	swap_chain_desc.BufferDesc.ScanlineOrdering = DXGI_MODE_SCANLINE_ORDER_UNSPECIFIED;
+	swap_chain_desc.BufferDesc.Scaling			= DXGI_MODE_SCALING_UNSPECIFIED;
+	swap_chain_desc.SampleDesc.Count   = 1;
+	swap_chain_desc.SampleDesc.Quality = 0;
+	
+
+	hr = factory_->CreateSwapChain(command_queue_.Get(), &swap_chain_desc, swap_chain.GetAddressOf());
+	if(FAILED(hr)){
+		return hr;
+	}
+
+	hr = swap_chain->QueryInterface(swap_chain_.GetAddressOf());
+	if(FAILED(hr)){
+		return hr;
+	}
+
+	//カレントのバックバッファのインデックスを取得する
+	rtv_index_ = swap_chain_->GetCurrentBackBufferIndex();
+
+	return S_OK;
+}
+
+
+//レンダーターゲットの作成
+HRESULT D3D12Manager::CreateRenderTargetView(){
+	HRESULT hr{};
+	D3D12_DESCRIPTOR_HEAP_DESC heap_desc{};
+
+	//RTV用デスクリプタヒープの作成
+	heap_desc.NumDescriptors	= RTV_NUM;
+	heap_desc.Type				= D3D12_DESCRIPTOR_HEAP_TYPE_RTV;
+	heap_desc.Flags				= D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
+	heap_desc.NodeMask			= 0;
+	hr = device_->CreateDescriptorHeap(&heap_desc, IID_PPV_ARGS(dh_rtv_.GetAddressOf()));
+	if (FAILED(hr)) {
+		return hr;
+	}
+
+	//レンダーターゲットを作成する処理
+	UINT size = device_->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_RTV);
+	for(UINT i = 0; i < RTV_NUM; ++i){
+		//スワップチェインからバッファを受け取る
+		hr = swap_chain_->GetBuffer(i, IID_PPV_ARGS(&render_target_[i]));
+		if(FAILED(hr)){
+			return hr;
+		}
+
+		//RenderTargetViewを作成してヒープデスクリプタに登録
+		rtv_handle_[i] = dh_rtv_->GetCPUDescriptorHandleForHeapStart();
+		rtv_handle_[i].ptr += size * i;
+		device_->CreateRenderTargetView(render_target_[i].Get(), nullptr, rtv_handle_[i]);
+		state_tracker_.Register(ToRenderResource(render_target_[i].Get()), RENDER_STATE_PRESENT);
+	}
+
+	return hr;
+}
+
+
+//深度バッファの作成
+HRESULT D3D12Manager::CreateDepthStencilBuffer(){
+	HRESULT hr;
+
+	//深度バッファ用のデスクリプタヒープの作成
+	D3D12_DESCRIPTOR_HEAP_DESC descriptor_heap_desc{};
+	descriptor_heap_desc.NumDescriptors = 1; 
+	descriptor_heap_desc.Type			= D3D12_DESCRIPTOR_HEAP_TYPE_DSV; 
+	descriptor_heap_desc.Flags			= D3D12_DESCRIPTOR_HEAP_FLAG_NONE; 
+	descriptor_heap_desc.NodeMask		= 0;
+	hr = device_->CreateDescriptorHeap(&descriptor_heap_desc, IID_PPV_ARGS(&dh_dsv_));
+	if(FAILED(hr)){
+		return hr;
+	}
+
+
+	//深度バッファは一時リソースのヒープに置くので、作成はCreateTransientResourcesで行う
+	dsv_handle_ = dh_dsv_->GetCPUDescriptorHandleForHeapStart();
+
+	return hr;
+}
+
+//コマンドリストの作成
+HRESULT D3D12Manager::CreateCommandList(){
+	HRESULT hr;
+
+	//パスごとにバックバッファの数だけアロケータを持つコマンドリストを作成する
+	for(int i = 0; i < PASS_NUM; ++i){
+		hr = pass_targets_[i].Initialize(device_.Get(), RTV_NUM);
+		if (FAILED(hr)) {
+			return hr;
+		}
+	}
+
+	//記録処理の登録はフレームグラフのコンパイル後に行う(CompileFrameGraph)
+	return S_OK;
+}
+
+
+//フレームごとの定数用のリングバッファの作成
+HRESULT D3D12Manager::CreateUploadBuffer(){
+	return upload_buffer_.Initialize(device_.Get(), UPLOAD_BUFFER_SIZE);
+}
+
+
+//全てのテクスチャのSRVを置くシェーダから見えるデスクリプタヒープの作成
+HRESULT D3D12Manager::CreateBindlessHeap(){
+	return bindless_heap_.Initialize(device_.Get(), BINDLESS_HEAP_SIZE);
+}
+
+
+//通常描画用のルートシグネチャの作成
+HRESULT D3D12Manager::CreateRootSignature(){
+	HRESULT hr{};
+	D3D12_DESCRIPTOR_RANGE		range[3]{};
+	D3D12_ROOT_PARAMETER		root_parameters[4]{};
+	D3D12_ROOT_SIGNATURE_DESC	root_signature_desc{};
+	D3D12_STATIC_SAMPLER_DESC	sampler_desc[3]{};
+	ComPtr<ID3DBlob> blob{};
+
+	//変換行列用の定数バッファ	
+	root_parameters[0].ParameterType				= D3D12_ROOT_PARAMETER_TYPE_CBV;
+	root_parameters[0].ShaderVisibility				= D3D12_SHADER_VISIBILITY_ALL;
+	root_parameters[0].Descriptor.ShaderRegister	= 0;
+	root_parameters[0].Descriptor.RegisterSpace		= 0;
+
+	//ライト用の定数バッファ
+	root_parameters[1].ParameterType				= D3D12_ROOT_PARAMETER_TYPE_CBV;
+	root_parameters[1].ShaderVisibility				= D3D12_SHADER_VISIBILITY_ALL;
+	root_parameters[1].Descriptor.ShaderRegister	= 1;
+	root_parameters[1].Descriptor.RegisterSpace		= 0;
+
+
+	//テクスチャ・シャドウマップのヒープ上の添字とシャドウマップのフィルタの設定(ルート定数)
+	root_parameters[2].ParameterType				= D3D12_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS;
+	root_parameters[2].ShaderVisibility				= D3D12_SHADER_VISIBILITY_PIXEL;
+	root_parameters[2].Constants.ShaderRegister		= 2;
+	root_parameters[2].Constants.RegisterSpace		= 0;
+	root_parameters[2].Constants.Num32BitValues		= DESCRIPTOR_INDEX_NUM;
+
+
+	//全てのテクスチャ(ヒープ全体を1つのテーブルにする)
+	range[0].NumDescriptors     = BINDLESS_HEAP_SIZE;
+	range[0].BaseShaderRegister = 0;
+	range[0].RangeType          = D3D12_DESCRIPTOR_RANGE_TYPE_SRV;
+	range[0].OffsetInDescriptorsFromTableStart = 0;
+
+	//同じヒープを配列のテクスチャとしてspace1からも見る(カスケードのシャドウマップ)
+	range[1].NumDescriptors     = BINDLESS_HEAP_SIZE;
+	range[1].BaseShaderRegister = 0;
+	range[1].RegisterSpace      = 1;
+	range[1].RangeType          = D3D12_DESCRIPTOR_RANGE_TYPE_SRV;
+	range[1].OffsetInDescriptorsFromTableStart = 0;
+
+	//同じヒープを4成分の配列のテクスチャとしてspace2からも見る(EVSMのモーメント)
+	range[2].NumDescriptors     = BINDLESS_HEAP_SIZE;
+	range[2].BaseShaderRegister = 0;
+	range[2].RegisterSpace      = 2;
+	range[2].RangeType          = D3D12_DESCRIPTOR_RANGE_TYPE_SRV;
+	range[2].OffsetInDescriptorsFromTableStart = 0;
+
+	root_parameters[3].ParameterType				= D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE;
+	root_parameters[3].ShaderVisibility				= D3D12_SHADER_VISIBILITY_PIXEL;
+	root_parameters[3].DescriptorTable.NumDescriptorRanges = _countof(range);
+	root_parameters[3].DescriptorTable.pDescriptorRanges   = &range[0];
+
+
+	//サンプラ
+	sampler_desc[0].Filter				= D3D12_FILTER_MIN_MAG_MIP_LINEAR;
+	sampler_desc[0].AddressU			= D3D12_TEXTURE_ADDRESS_MODE_WRAP;
+	sampler_desc[0].AddressV			= D3D12_TEXTURE_ADDRESS_MODE_WRAP;
+	sampler_desc[0].AddressW			= D3D12_TEXTURE_ADDRESS_MODE_WRAP;
+	sampler_desc[0].MipLODBias			= 0.0f;
+	sampler_desc[0].MaxAnisotropy		= 16;
+	sampler_desc[0].ComparisonFunc		= D3D12_COMPARISON_FUNC_NEVER;
+	sampler_desc[0].BorderColor			= D3D12_STATIC_BORDER_COLOR_TRANSPARENT_BLACK;
+	sampler_desc[0].MinLOD				= 0.0f;
+	sampler_desc[0].MaxLOD				= D3D12_FLOAT32_MAX;
+	sampler_desc[0].ShaderRegister		= 0;
+	sampler_desc[0].RegisterSpace		= 0;
+	sampler_desc[0].ShaderVisibility	= D3D12_SHADER_VISIBILITY_ALL;
+
+	//シャドウマップの比較サンプラ(2x2のテクセルと比べた結果を双線形補間する。外は深度1で光が当たる)
+	sampler_desc[1].Filter				= D3D12_FILTER_COMPARISON_MIN_MAG_LINEAR_MIP_POINT;
+	sampler_desc[1].AddressU			= D3D12_TEXTURE_ADDRESS_MODE_BORDER;
+	sampler_desc[1].AddressV			= D3D12_TEXTURE_ADDRESS_MODE_BORDER;
+	sampler_desc[1].AddressW			= D3D12_TEXTURE_ADDRESS_MODE_BORDER;
+	sampler_desc[1].MipLODBias			= 0.0f;
+	sampler_desc[1].MaxAnisotropy		= 16;
+	sampler_desc[1].ComparisonFunc		= D3D12_COMPARISON_FUNC_LESS_EQUAL;
+	sampler_desc[1].BorderColor			= D3D12_STATIC_BORDER_COLOR_OPAQUE_WHITE;
+	sampler_desc[1].MinLOD				= 0.0f;
+	sampler_desc[1].MaxLOD				= D3D12_FLOAT32_MAX;
+	sampler_desc[1].ShaderRegister		= 1;
+	sampler_desc[1].RegisterSpace		= 0;
+	sampler_desc[1].ShaderVisibility	= D3D12_SHADER_VISIBILITY_ALL;
+
+	//EVSMのモーメントのサンプラ(外は端のテクセルを延ばす)
+	sampler_desc[2].Filter				= D3D12_FILTER_MIN_MAG_MIP_LINEAR;
+	sampler_desc[2].AddressU			= D3D12_TEXTURE_ADDRESS_MODE_CLAMP;
+	sampler_desc[2].AddressV			= D3D12_TEXTURE_ADDRESS_MODE_CLAMP;
+	sampler_desc[2].AddressW			= D3D12_TEXTURE_ADDRESS_MODE_CLAMP;
+	sampler_desc[2].MipLODBias			= 0.0f;
+	sampler_desc[2].MaxAnisotropy		= 16;
+	sampler_desc[2].ComparisonFunc		= D3D12_COMPARISON_FUNC_NEVER;
+	sampler_desc[2].BorderColor			= D3D12_STATIC_BORDER_COLOR_OPAQUE_WHITE;
+	sampler_desc[2].MinLOD				= 0.0f;
+	sampler_desc[2].MaxLOD				= D3D12_FLOAT32_MAX;
+	sampler_desc[2].ShaderRegister		= 2;
+	sampler_desc[2].RegisterSpace		= 0;
+	sampler_desc[2].ShaderVisibility	= D3D12_SHADER_VISIBILITY_ALL;
+
+
+	root_signature_desc.Flags				= D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT;
+	root_signature_desc.NumParameters		= _countof(root_parameters);
+	root_signature_desc.pParameters			= root_parameters;
+	root_signature_desc.NumStaticSamplers	= _countof(sampler_desc);
+	root_signature_desc.pStaticSamplers		= sampler_desc;
+
+	hr = D3D12SerializeRootSignature(&root_signature_desc, D3D_ROOT_SIGNATURE_VERSION_1, &blob, nullptr);
+	if(FAILED(hr)){
+		return hr;
+	}
+	hr = device_->CreateRootSignature(0, blob->GetBufferPointer(), blob->GetBufferSize(), IID_PPV_ARGS(&root_sugnature_));
+	if(FAILED(hr)){
+		return hr;
+	}
+
+	//PSOのキーにはシリアライズした内容を使う
+	pipeline_states_.RegisterRootSignature(root_sugnature_.Get(), blob->GetBufferPointer(), blob->GetBufferSize());
+
+	return hr;
+}
+
+
+//シェーダのコンパイル(ワーカースレッドから呼ばれる)
+//キャッシュにあるものはコンパイルしない
+HRESULT D3D12Manager::CompileShaders(){
+	HRESULT hr;
+
+	//Shaders.hlslはシャドウマップを配列のテクスチャとして見るためにレジスタ空間を使うので、頂点シェーダも5.1でコンパイルする
+
+	hr = CompileShader(&shader_cache_, "Shaders.hlsl", "VSMain", "vs_5_1", vs_main_.ReleaseAndGetAddressOf());
+	if(FAILED(hr)){
+		return hr;
+	}
+
+	hr = CompileShader(&shader_cache_, "Shaders.hlsl", "PSMain", "ps_5_1", ps_main_.ReleaseAndGetAddressOf());
+	if(FAILED(hr)){
+		return hr;
+	}
+
+	hr = CompileShader(&shader_cache_, "Shaders.hlsl", "VSShadowMap", "vs_5_1", vs_shadow_map_.ReleaseAndGetAddressOf());
+	if(FAILED(hr)){
+		return hr;
+	}
+
+	//インスタンス描画用
+	hr = CompileShader(&shader_cache_, "Shaders.hlsl", "VSMainInstanced", "vs_5_1", vs_main_instanced_.ReleaseAndGetAddressOf());
+	if(FAILED(hr)){
+		return hr;
+	}
+
+	hr = CompileShader(&shader_cache_, "Shaders.hlsl", "PSMainInstanced", "ps_5_1", ps_main_instanced_.ReleaseAndGetAddressOf());
+	if(FAILED(hr)){
+		return hr;
+	}
+
+	hr = CompileShader(&shader_cache_, "Shaders.hlsl", "VSShadowMapInstanced", "vs_5_1", vs_shadow_map_instanced_.ReleaseAndGetAddressOf());
+	if(FAILED(hr)){
+		return hr;
+	}
+
+	//EVSMの前処理用
+	hr = CompileShader(&shader_cache_, "Shaders.hlsl", "VSFullscreen", "vs_5_1", vs_fullscreen_.ReleaseAndGetAddressOf());
+	if(FAILED(hr)){
+		return hr;
+	}
+
+	hr = CompileShader(&shader_cache_, "Shaders.hlsl", "PSEvsmBlurX", "ps_5_1", ps_evsm_blur_x_.ReleaseAndGetAddressOf());
+	if(FAILED(hr)){
+		return hr;
+	}
+
+	hr = CompileShader(&shader_cache_, "Shaders.hlsl", "PSEvsmBlurY", "ps_5_1", ps_evsm_blur_y_.ReleaseAndGetAddressOf());
+
+	return hr;
+}
+
+
+//通常描画用のパイプラインステートの作成
+HRESULT D3D12Manager::CreatePipelineStateObject(){
+
+	if(vs_main_ == nullptr || ps_main_ == nullptr){
+		return E_FAIL;
+	}
+
+
+	// 頂点レイアウト.
+	D3D12_INPUT_ELEMENT_DESC InputElementDesc[] = {
+		{ "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0,  0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+		{ "NORMAL",   0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 12, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+		{ "TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT,    0, 24, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+	};
+
+	D3D12_GRAPHICS_PIPELINE_STATE_DESC pipeline_state_desc{};
+
+	//シェーダーの設定
+	pipeline_state_desc.VS.pShaderBytecode = vs_main_->GetBufferPointer();
+	pipeline_state_desc.VS.BytecodeLength  = vs_main_->GetBufferSize();
+	pipeline_state_desc.PS.pShaderBytecode = ps_main_->GetBufferPointer();
+	pipeline_state_desc.PS.BytecodeLength  = ps_main_->GetBufferSize();
+
+
+	//インプットレイアウトの設定
+	pipeline_state_desc.InputLayout.pInputElementDescs	= InputElementDesc;
+	pipeline_state_desc.InputLayout.NumElements			= _countof(InputElementDesc);
+
+
+	//サンプル系の設定
+	pipeline_state_desc.SampleDesc.Count	= 1;
+	pipeline_state_desc.SampleDesc.Quality	= 0;
+	pipeline_state_desc.SampleMask			= UINT_MAX;
+
+	//レンダーターゲットの設定
+	pipeline_state_desc.NumRenderTargets = 1;
+	pipeline_state_desc.RTVFormats[0]    = DXGI_FORMAT_B8G8R8A8_UNORM;
+
+	//三角形に設定
+	pipeline_state_desc.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
+
+
+	//ルートシグネチャ
+	pipeline_state_desc.pRootSignature = root_sugnature_.Get();
+
+
+	//ラスタライザステートの設定
+	pipeline_state_desc.RasterizerState.CullMode				= D3D12_CULL_MODE_BACK;
+	pipeline_state_desc.RasterizerState.FillMode				= D3D12_FILL_MODE_SOLID;
+	pipeline_state_desc.RasterizerState.FrontCounterClockwise	= FALSE;
+	pipeline_state_desc.RasterizerState.DepthBias				= 0;
+	pipeline_state_desc.RasterizerState.DepthBiasClamp			= 0;
+	pipeline_state_desc.RasterizerState.SlopeScaledDepthBias	= 0;
+	pipeline_state_desc.RasterizerState.DepthClipEnable			= TRUE;
+	pipeline_state_desc.RasterizerState.ConservativeRaster		= D3D12_CONSERVATIVE_RASTERIZATION_MODE_OFF;
+	pipeline_state_desc.RasterizerState.AntialiasedLineEnable	= FALSE;
+	pipeline_state_desc.RasterizerState.MultisampleEnable		= FALSE;
+
+
+	//ブレンドステートの設定
+	for(int i = 0; i < _countof(pipeline_state_desc.BlendState.RenderTarget); ++i){
+		pipeline_state_desc.BlendState.RenderTarget[i].BlendEnable				= FALSE;
+		pipeline_state_desc.BlendState.RenderTarget[i].SrcBlend					= D3D12_BLEND_ONE;
+		pipeline_state_desc.BlendState.RenderTarget[i].DestBlend				= D3D12_BLEND_ZERO;
+		pipeline_state_desc.BlendState.RenderTarget[i].BlendOp					= D3D12_BLEND_OP_ADD;
+		pipeline_state_desc.BlendState.RenderTarget[i].SrcBlendAlpha			= D3D12_BLEND_ONE;
+		pipeline_state_desc.BlendState.RenderTarget[i].DestBlendAlpha			= D3D12_BLEND_ZERO;
+		pipeline_state_desc.BlendState.RenderTarget[i].BlendOpAlpha				= D3D12_BLEND_OP_ADD;
+		pipeline_state_desc.BlendState.RenderTarget[i].RenderTargetWriteMask	= D3D12_COLOR_WRITE_ENABLE_ALL;
+		pipeline_state_desc.BlendState.RenderTarget[i].LogicOpEnable			= FALSE;
+		pipeline_state_desc.BlendState.RenderTarget[i].LogicOp					= D3D12_LOGIC_OP_CLEAR;
+	}
+	pipeline_state_desc.BlendState.AlphaToCoverageEnable  = FALSE;
+	pipeline_state_desc.BlendState.IndependentBlendEnable = FALSE;
+
+
+	//デプスステンシルステートの設定
+	pipeline_state_desc.DepthStencilState.DepthEnable		= TRUE;								//深度テストあり
+	pipeline_state_desc.DepthStencilState.DepthFunc			= D3D12_COMPARISON_FUNC_LESS_EQUAL;
+	pipeline_state_desc.DepthStencilState.DepthWriteMask	= D3D12_DEPTH_WRITE_MASK_ALL;
+	pipeline_state_desc.DepthStencilState.StencilEnable		= FALSE;							//ステンシルテストなし
+	pipeline_state_desc.DepthStencilState.StencilReadMask	= D3D12_DEFAULT_STENCIL_READ_MASK;
+	pipeline_state_desc.DepthStencilState.StencilWriteMask	= D3D12_DEFAULT_STENCIL_WRITE_MASK;
+
+	pipeline_state_desc.DepthStencilState.FrontFace.StencilFailOp		= D3D12_STENCIL_OP_KEEP;
+	pipeline_state_desc.DepthStencilState.FrontFace.StencilDepthFailOp	= D3D12_STENCIL_OP_KEEP;
+	pipeline_state_desc.DepthStencilState.FrontFace.StencilPassOp		= D3D12_STENCIL_OP_KEEP;
+	pipeline_state_desc.DepthStencilState.FrontFace.StencilFunc			= D3D12_COMPARISON_FUNC_ALWAYS;
+
+	pipeline_state_desc.DepthStencilState.BackFace.StencilFailOp		= D3D12_STENCIL_OP_KEEP;
+	pipeline_state_desc.DepthStencilState.BackFace.StencilDepthFailOp	= D3D12_STENCIL_OP_KEEP;
+	pipeline_state_desc.DepthStencilState.BackFace.StencilPassOp		= D3D12_STENCIL_OP_KEEP;
+	pipeline_state_desc.DepthStencilState.BackFace.StencilFunc			= D3D12_COMPARISON_FUNC_ALWAYS;
+
+	pipeline_state_desc.DSVFormat = DXGI_FORMAT_D32_FLOAT;
+
+	pipeline_state_ = pipeline_states_.Request(pipeline_state_desc, false);
+	if(!pipeline_states_.IsReady(pipeline_state_)){
+		return E_FAIL;
+	}
+
+
+	//インスタンス描画用(シェーダと頂点レイアウト以外は同じ)
+	//ワーカースレッドで作成し、できるまでは通常描画用のPSOで描く
+	if(vs_main_instanced_ == nullptr || ps_main_instanced_ == nullptr){
+		return E_FAIL;
+	}
+	pipeline_state_desc.VS.pShaderBytecode = vs_main_instanced_->GetBufferPointer();
+	pipeline_state_desc.VS.BytecodeLength  = vs_main_instanced_->GetBufferSize();
+	pipeline_state_desc.PS.pShaderBytecode = ps_main_instanced_->GetBufferPointer();
+	pipeline_state_desc.PS.BytecodeLength  = ps_main_instanced_->GetBufferSize();
+	pipeline_state_desc.InputLayout.pInputElementDescs	= INSTANCED_INPUT_ELEMENT_DESC;
+	pipeline_state_desc.InputLayout.NumElements			= _countof(INSTANCED_INPUT_ELEMENT_DESC);
+
+	pipeline_state_instanced_ = pipeline_states_.Request(pipeline_state_desc, true, pipeline_state_);
+
+	return S_OK;
+}
+
+
+//ライトとカスケードシャドウマップの設定
+//ライトの定数はカメラに合わせてカスケードを求め直すので、フレームごとにUpdateLightで書き込む
+HRESULT D3D12Manager::CreateLightBuffer(){
+
+	viewport_sm_.x			= 0.f; 
+	viewport_sm_.y			= 0.f;
+	viewport_sm_.width		= static_cast<float>(SHADOW_MAP_SIZE);
+	viewport_sm_.height		= static_cast<float>(SHADOW_MAP_SIZE);
+	viewport_sm_.min_depth	= 0.f;
+	viewport_sm_.max_depth	= 1.f;
+
+	scissor_rect_sm_.top    = 0;
+	scissor_rect_sm_.left   = 0;
+	scissor_rect_sm_.right  = SHADOW_MAP_SIZE;
+	scissor_rect_sm_.bottom = SHADOW_MAP_SIZE;
+
+
+	light_pos_ = {2.0f, 6.5f, -1.0f};
+	light_dst_ = {0.0f, 0.0f, 0.0f};
+	light_dir_ = {
+		light_pos_.x - light_dst_.x,
+		light_pos_.y - light_dst_.y,
+		light_pos_.z - light_dst_.z
+	};
+	iight_color_ = {1.0f, 1.0f, 1.0f, 1.0f};
+
+
+	//カメラの行列はシーンで求め、板ポリ・球・視錐台で同じものを使う
+	camera_ = {{1.0f, 1.0f, -6.0f}, {0.0f, 0.0f, 0.0f}, {0.0f, 1.0f, 0.0f}, XMConvertToRadians(60.0f), 640.0f / 480.0f, 1.0f, 20.0f};
+	scene_.SetCamera(camera_);
+
+	//影を落とすもの・受けるものの範囲(回転する板ポリの外接円とインスタンス描画の球の格子が収まる)
+	static const float SCENE_MIN[3] = {-4.5f, -3.0f, -4.5f};
+	static const float SCENE_MAX[3] = { 4.5f,  3.0f,  4.5f};
+	if(!cascades_.Initialize(SHADOW_CASCADE_NUM, SHADOW_MAP_SIZE)){
+		return E_INVALIDARG;
+	}
+	cascades_.SetSceneBounds(SCENE_MIN, SCENE_MAX);
+
+	//遮蔽カリング用の深度バッファ(画面の半分の解像度)
+	if(!occlusion_culler_.Initialize(OcclusionCuller::DEFAULT_WIDTH, OcclusionCuller::DEFAULT_HEIGHT)){
+		return E_INVALIDARG;
+	}
+
+	return S_OK;
+}
+
+
+//カメラに合わせてカスケードを求め、今フレームのライトの定数を書き込む
+//先頭は通常の描画用で全てのカスケードの行列を持ち、続いてカスケードごとにそのカスケードの行列をLightVPに入れたものを書く
+HRESULT D3D12Manager::UpdateLight(){
+	static_assert(SHADOW_CASCADE_NUM <= ShadowCascades::MAX_CASCADE_NUM && SHADOW_CASCADE_NUM <= 4, "cascade splits are passed in one float4");
+
+	//シェーダのcbLightと同じ並び
+	struct Light{
+		XMFLOAT4X4	light_vp;
+		XMFLOAT4	color;
+		XMFLOAT3	dir;
+		float		padding;
+		XMFLOAT4X4	cascade_vp[SHADOW_CASCADE_NUM];
+		float		cascade_splits[4];
+	};
+
+	const float light_dir[3] = {light_dir_.x, light_dir_.y, light_dir_.z};
+	cascades_.Update(camera_, light_dir, SHADOW_DISTANCE);
+
+	Light light{};
+	light.color	= iight_color_;
+	light.dir	= light_dir_;
+	for(UINT i = 0; i < SHADOW_CASCADE_NUM; ++i){
+		const ShadowCascades::Cascade &cascade = cascades_.GetCascade(i);
+		light.cascade_vp[i]		= XMFLOAT4X4(&cascade.view_proj.Transposed().m[0][0]);
+		light.cascade_splits[i]	= cascade.split_far;
+		shadow_cache_.SetView(i, &cascade.view_proj.m[0][0]);
+	}
+
+	for(UINT i = 0; i <= SHADOW_CASCADE_NUM; ++i){
+		light.light_vp = light.cascade_vp[(i == 0) ? 0 : i - 1];
+
+		RenderUploadHeap::Allocation allocation{};
+		if(!upload_buffer_.AllocateConstant(sizeof(Light), &allocation)){
+			return E_OUTOFMEMORY;
+		}
+		memcpy(allocation.cpu_address, &light, sizeof(Light));
+		light_constants_[i] = allocation.gpu_address;
+	}
+
+	return S_OK;
+}
+
+
+//カメラと各カスケードのライトの視錐台を作る(カメラの行列はシーンで求めたもの)
+void D3D12Manager::UpdateFrustums(){
+	frustums_[0] = FrustumCuller::Frustum::FromMatrix(scene_.ViewProj().m);
+
+	for(UINT i = 0; i < SHADOW_CASCADE_NUM; ++i){
+		frustums_[i + 1] = FrustumCuller::Frustum::FromMatrix(cascades_.GetCascade(i).view_proj.m);
+	}
+}
+
+
+//板ポリを遮蔽物としてカメラから見た深度バッファに描く(三角形が少ないのでジョブには分けない)
+//板ポリは背面カリングして描くので、裏から見ているときは遮蔽物にしない
+void D3D12Manager::RasterizeOccluders(){
+	static const float PLANE_VERTICES[4 * 3] = {-1.0f, 1.0f, 0.0f,  1.0f, 1.0f, 0.0f,  -1.0f, -1.0f, 0.0f,  1.0f, -1.0f, 0.0f};
+	static const uint32_t PLANE_INDICES[2 * 3] = {0, 1, 2,  2, 1, 3};
+
+	//world_は転置してあるので行ベクトルに掛ける並びに戻す
+	const XMFLOAT4X4 &transposed = plane_.World();
+	float world[4][4];
+	for(int i = 0; i < 4; ++i){
+		for(int j = 0; j < 4; ++j){
+			world[i][j] = transposed.m[j][i];
+		}
+	}
+
+	occlusion_culler_.BeginFrame(scene_.ViewProj().m);
+	occlusion_culler_.AddOccluder(PLANE_VERTICES, PLANE_INDICES, 2, world);
+	occlusion_culler_.Rasterize();
+}
+
+
+//板ポリ・球の今フレームの境界を各視錐台で調べる
+//インスタンス描画の球はSphere::Updateでインスタンスごとに調べているので、ここでは常に描く
+void D3D12Manager::CullObjects(){
+	//球の頂点は半径1(world_は転置してあるので平行移動は4列目)
+	const XMFLOAT4X4 &sphere = sphere_.World();
+	const float sphere_center[3] = {sphere._14, sphere._24, sphere._34};
+	object_culler_.SetSphere(SHADOW_CASTER_SPHERE, sphere_center, 1.0f);
+
+	//板ポリの頂点は xy が[-1, 1]・zが0なので、ワールドの各軸の幅は1・2列目の絶対値の和
+	const XMFLOAT4X4 &plane = plane_.World();
+	const float plane_center[3] = {plane._14, plane._24, plane._34};
+	float plane_extents[3];
+	for(int i = 0; i < 3; ++i){
+		plane_extents[i] = std::fabs(plane.m[i][0]) + std::fabs(plane.m[i][1]);
+	}
+	object_culler_.SetBox(SHADOW_CASTER_PLANE, plane_center, plane_extents);
+
+	object_culler_.Cull(frustums_, SHADOW_CASCADE_NUM + 1);
+
+	//カメラの視錐台に掛かる球は、板ポリの後ろに隠れていれば描かない
+	const float sphere_min[3] = {sphere_center[0] - 1.0f, sphere_center[1] - 1.0f, sphere_center[2] - 1.0f};
+	const float sphere_max[3] = {sphere_center[0] + 1.0f, sphere_center[1] + 1.0f, sphere_center[2] + 1.0f};
+	const bool sphere_occluded = (occlusion_culler_.TestBox(sphere_min, sphere_max) != OcclusionCuller::RESULT_VISIBLE);
+
+	for(UINT v = 0; v <= SHADOW_CASCADE_NUM; ++v){
+		for(int i = 0; i < SHADOW_CASTER_NUM; ++i){
+			object_visible_[v][i] = false;
+		}
+		const uint32_t *visible = object_culler_.Visible(v);
+		for(int i = 0; i < object_culler_.VisibleNum(v); ++i){
+			object_visible_[v][visible[i]] = true;
+		}
+		if(sphere_.IsInstanced()){
+			object_visible_[v][SHADOW_CASTER_SPHERE] = true;
+		}else if(v == 0 && sphere_occluded){
+			object_visible_[v][SHADOW_CASTER_SPHERE] = false;
+		}
+	}
+}
+
+
+//シャドーマッピング用の深度バッファの作成
+//描き直さないフレームは前のフレームの内容を使うので、シャドウマップとキャッシュは一時リソースのヒープに置かない
+HRESULT D3D12Manager::CreateShadowBuffer(){
+	HRESULT hr;
+
+
+	D3D12_DESCRIPTOR_HEAP_DESC descriptor_heap_desc{};
+	descriptor_heap_desc.NumDescriptors = SHADOW_CASCADE_NUM * 2; 
+	descriptor_heap_desc.Type			= D3D12_DESCRIPTOR_HEAP_TYPE_DSV; 
+	descriptor_heap_desc.Flags			= D3D12_DESCRIPTOR_HEAP_FLAG_NONE; 
+	descriptor_heap_desc.NodeMask		= 0;
+	hr = device_->CreateDescriptorHeap(&descriptor_heap_desc, IID_PPV_ARGS(&dh_shadow_buffer_));
+	if(FAILED(hr)){
+		return hr;
+	}
+
+	//カスケードごとのスライスに書き込むDSV(シャドウマップ、キャッシュの順に並べる)
+	const UINT dsv_size = device_->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_DSV);
+	for(UINT i = 0; i < SHADOW_CASCADE_NUM; ++i){
+		shadow_dsv_handles_[i] = dh_shadow_buffer_->GetCPUDescriptorHandleForHeapStart();
+		shadow_dsv_handles_[i].ptr += static_cast<SIZE_T>(dsv_size) * i;
+		shadow_cache_dsv_handles_[i] = shadow_dsv_handles_[i];
+		shadow_cache_dsv_handles_[i].ptr += static_cast<SIZE_T>(dsv_size) * SHADOW_CASCADE_NUM;
+	}
+
+
+	D3D12_HEAP_PROPERTIES heap_properties{};
+	heap_properties.Type					= D3D12_HEAP_TYPE_DEFAULT;
+	heap_properties.CPUPageProperty			= D3D12_CPU_PAGE_PROPERTY_UNKNOWN;
+	heap_properties.MemoryPoolPreference	= D3D12_MEMORY_POOL_UNKNOWN;
+	heap_properties.CreationNodeMask		= 0;
+	heap_properties.VisibleNodeMask			= 0;
+
+	D3D12_CLEAR_VALUE clear_value{};
+	clear_value.Format					= DXGI_FORMAT_D32_FLOAT;
+	clear_value.DepthStencil.Depth		= 1.0f;
+	clear_value.DepthStencil.Stencil	= 0;
+
+	const D3D12_RESOURCE_DESC shadow_desc = GetDepthBufferDesc(SHADOW_MAP_SIZE, SHADOW_MAP_SIZE, SHADOW_CASCADE_NUM);
+	hr = device_->CreateCommittedResource(&heap_properties, D3D12_HEAP_FLAG_NONE, &shadow_desc, D3D12_RESOURCE_STATE_DEPTH_WRITE, &clear_value, IID_PPV_ARGS(&shadow_buffer_));
+	if(FAILED(hr)){
+		return hr;
+	}
+	hr = device_->CreateCommittedResource(&heap_properties, D3D12_HEAP_FLAG_NONE, &shadow_desc, D3D12_RESOURCE_STATE_DEPTH_WRITE, &clear_value, IID_PPV_ARGS(&shadow_cache_buffer_));
+	if(FAILED(hr)){
+		return hr;
+	}
+	state_tracker_.Register(ToRenderResource(shadow_buffer_.Get()), RENDER_STATE_DEPTH_WRITE);
+	state_tracker_.Register(ToRenderResource(shadow_cache_buffer_.Get()), RENDER_STATE_DEPTH_WRITE);
+
+
+	D3D12_DEPTH_STENCIL_VIEW_DESC dsv_desc{};
+	dsv_desc.ViewDimension					= D3D12_DSV_DIMENSION_TEXTURE2DARRAY;
+	dsv_desc.Format							= DXGI_FORMAT_D32_FLOAT;
+	dsv_desc.Flags							= D3D12_DSV_FLAG_NONE;
+	dsv_desc.Texture2DArray.MipSlice		= 0;
+	dsv_desc.Texture2DArray.ArraySize		= 1;
+	for(UINT i = 0; i < SHADOW_CASCADE_NUM; ++i){
+		dsv_desc.Texture2DArray.FirstArraySlice = i;
+		device_->CreateDepthStencilView(shadow_buffer_.Get(), &dsv_desc, shadow_dsv_handles_[i]);
+		device_->CreateDepthStencilView(shadow_cache_buffer_.Get(), &dsv_desc, shadow_cache_dsv_handles_[i]);
+	}
+
+
+	//シャドウマップのSRV(シェーダでは配列のテクスチャとして見る。キャッシュはコピー元にするだけなのでSRVは作らない)
+	hr = bindless_heap_.Allocate(1, &shadow_map_index_);
+	if(FAILED(hr)){
+		return hr;
+	}
+
+	D3D12_SHADER_RESOURCE_VIEW_DESC resourct_view_desc{};
+	resourct_view_desc.Format								= DXGI_FORMAT_R32_FLOAT;
+	resourct_view_desc.ViewDimension						= D3D12_SRV_DIMENSION_TEXTURE2DARRAY;
+	resourct_view_desc.Texture2DArray.MipLevels				= 1;
+	resourct_view_desc.Texture2DArray.MostDetailedMip		= 0;
+	resourct_view_desc.Texture2DArray.FirstArraySlice		= 0;
+	resourct_view_desc.Texture2DArray.ArraySize				= SHADOW_CASCADE_NUM;
+	resourct_view_desc.Texture2DArray.PlaneSlice			= 0;
+	resourct_view_desc.Texture2DArray.ResourceMinLODClamp	= 0.0F;
+	resourct_view_desc.Shader4ComponentMapping				= D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+	device_->CreateShaderResourceView(shadow_buffer_.Get(), &resourct_view_desc, bindless_heap_.CpuHandle(shadow_map_index_));
+
+
+	//EVSMのモーメントのRTV(横にぼかしたもの、ぼかしたものの順に並べる)とSRVの置き場所
+	//リソースは使うときに作る(横にぼかしたものはフレームグラフの一時リソース、ぼかしたものはSetShadowFilterでEVSMにしたとき)
+	descriptor_heap_desc.NumDescriptors = SHADOW_CASCADE_NUM * 2;
+	descriptor_heap_desc.Type			= D3D12_DESCRIPTOR_HEAP_TYPE_RTV;
+	hr = device_->CreateDescriptorHeap(&descriptor_heap_desc, IID_PPV_ARGS(&dh_shadow_rtv_));
+	if(FAILED(hr)){
+		return hr;
+	}
+
+	const UINT rtv_size = device_->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_RTV);
+	for(UINT i = 0; i < SHADOW_CASCADE_NUM; ++i){
+		shadow_blur_rtv_handles_[i] = dh_shadow_rtv_->GetCPUDescriptorHandleForHeapStart();
+		shadow_blur_rtv_handles_[i].ptr += static_cast<SIZE_T>(rtv_size) * i;
+		shadow_moments_rtv_handles_[i] = shadow_blur_rtv_handles_[i];
+		shadow_moments_rtv_handles_[i].ptr += static_cast<SIZE_T>(rtv_size) * SHADOW_CASCADE_NUM;
+	}
+
+	hr = bindless_heap_.Allocate(1, &shadow_blur_index_);
+	if(FAILED(hr)){
+		return hr;
+	}
+	hr = bindless_heap_.Allocate(1, &shadow_moments_index_);
+	if(FAILED(hr)){
+		return hr;
+	}
+
+
+	//キャスターは全て動いたかを調べる(最初のフレームでキャッシュを描く)
+	shadow_cache_.Initialize(SHADOW_CASCADE_NUM);
+	for(int i = 0; i < SHADOW_CASTER_NUM; ++i){
+		shadow_casters_[i] = shadow_cache_.AddCaster();
+	}
+	object_culler_.Resize(SHADOW_CASTER_NUM);
+
+	return S_OK;
+}
+
+
+//シャドーマッピング用のパイプラインステートの作成
+HRESULT D3D12Manager::CreateShadowMapPipelineState(){
+
+	if(vs_shadow_map_ == nullptr){
+		return E_FAIL;
+	}
+
+
+	// 頂点レイアウト.
+	D3D12_INPUT_ELEMENT_DESC InputElementDesc[] = {
+		{ "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0,  0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+		{ "NORMAL",   0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 12, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+		{ "TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT,    0, 24, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+	};
+
+	D3D12_GRAPHICS_PIPELINE_STATE_DESC pipeline_state_desc{};
+
+	//シェーダーの設定
+	pipeline_state_desc.VS.pShaderBytecode = vs_shadow_map_->GetBufferPointer();
+	pipeline_state_desc.VS.BytecodeLength  = vs_shadow_map_->GetBufferSize();
+
+
+	//インプットレイアウトの設定
+	pipeline_state_desc.InputLayout.pInputElementDescs	= InputElementDesc;
+	pipeline_state_desc.InputLayout.NumElements			= _countof(InputElementDesc);
+
+
+	//サンプル系の設定
+	pipeline_state_desc.SampleDesc.Count	= 1;
+	pipeline_state_desc.SampleDesc.Quality	= 0;
+	pipeline_state_desc.SampleMask			= UINT_MAX;
+
+	//三角形に設定
+	pipeline_state_desc.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
+
+
+	//ルートシグネチャ
+	pipeline_state_desc.pRootSignature = root_sugnature_.Get();
+
+
+	//ラスタライザステートの設定
+	pipeline_state_desc.RasterizerState.CullMode				= D3D12_CULL_MODE_NONE;//D3D12_CULL_MODE_BACK;
+	pipeline_state_desc.RasterizerState.FillMode				= D3D12_FILL_MODE_SOLID;
+	pipeline_state_desc.RasterizerState.FrontCounterClockwise	= FALSE;
+	pipeline_state_desc.RasterizerState.DepthBias				= 0;
+	pipeline_state_desc.RasterizerState.DepthBiasClamp			= 0;
+	pipeline_state_desc.RasterizerState.SlopeScaledDepthBias	= 0;
+	pipeline_state_desc.RasterizerState.DepthClipEnable			= TRUE;
+	pipeline_state_desc.RasterizerState.ConservativeRaster		= D3D12_CONSERVATIVE_RASTERIZATION_MODE_OFF;
+	pipeline_state_desc.RasterizerState.AntialiasedLineEnable	= FALSE;
+	pipeline_state_desc.RasterizerState.MultisampleEnable		= FALSE;
+
+
+	//ブレンドステートの設定
+	pipeline_state_desc.BlendState.RenderTarget[0].BlendEnable				= FALSE;
+	pipeline_state_desc.BlendState.RenderTarget[0].SrcBlend					= D3D12_BLEND_ONE;
+	pipeline_state_desc.BlendState.RenderTarget[0].DestBlend				= D3D12_BLEND_ZERO;
+	pipeline_state_desc.BlendState.RenderTarget[0].BlendOp					= D3D12_BLEND_OP_ADD;
+	pipeline_state_desc.BlendState.RenderTarget[0].SrcBlendAlpha			= D3D12_BLEND_ONE;
+	pipeline_state_desc.BlendState.RenderTarget[0].DestBlendAlpha			= D3D12_BLEND_ZERO;
+	pipeline_state_desc.BlendState.RenderTarget[0].BlendOpAlpha				= D3D12_BLEND_OP_ADD;
+	pipeline_state_desc.BlendState.RenderTarget[0].RenderTargetWriteMask	= D3D12_COLOR_WRITE_ENABLE_ALL;
+	pipeline_state_desc.BlendState.RenderTarget[0].LogicOpEnable			= FALSE;
+	pipeline_state_desc.BlendState.RenderTarget[0].LogicOp					= D3D12_LOGIC_OP_CLEAR;
+	
+	pipeline_state_desc.BlendState.AlphaToCoverageEnable  = FALSE;
+	pipeline_state_desc.BlendState.IndependentBlendEnable = FALSE;
+
+
+	//デプスステンシルステートの設定
+	pipeline_state_desc.DepthStencilState.DepthEnable		= TRUE;								//深度テストあり
+	pipeline_state_desc.DepthStencilState.DepthFunc			= D3D12_COMPARISON_FUNC_LESS_EQUAL;
+	pipeline_state_desc.DepthStencilState.DepthWriteMask	= D3D12_DEPTH_WRITE_MASK_ALL;
+	pipeline_state_desc.DepthStencilState.StencilEnable		= FALSE;							//ステンシルテストなし
+	pipeline_state_desc.DepthStencilState.StencilReadMask	= D3D12_DEFAULT_STENCIL_READ_MASK;
+	pipeline_state_desc.DepthStencilState.StencilWriteMask	= D3D12_DEFAULT_STENCIL_WRITE_MASK;
+
+	pipeline_state_desc.DepthStencilState.FrontFace.StencilFailOp		= D3D12_STENCIL_OP_KEEP;
+	pipeline_state_desc.DepthStencilState.FrontFace.StencilDepthFailOp	= D3D12_STENCIL_OP_KEEP;
+	pipeline_state_desc.DepthStencilState.FrontFace.StencilPassOp		= D3D12_STENCIL_OP_KEEP;
+	pipeline_state_desc.DepthStencilState.FrontFace.StencilFunc			= D3D12_COMPARISON_FUNC_ALWAYS;
+
+	pipeline_state_desc.DepthStencilState.BackFace.StencilFailOp		= D3D12_STENCIL_OP_KEEP;
+	pipeline_state_desc.DepthStencilState.BackFace.StencilDepthFailOp	= D3D12_STENCIL_OP_KEEP;
+	pipeline_state_desc.DepthStencilState.BackFace.StencilPassOp		= D3D12_STENCIL_OP_KEEP;
+	pipeline_state_desc.DepthStencilState.BackFace.StencilFunc			= D3D12_COMPARISON_FUNC_ALWAYS;
+
+	pipeline_state_desc.DSVFormat = DXGI_FORMAT_D32_FLOAT;
+
+	shadow_map_pso_ = pipeline_states_.Request(pipeline_state_desc, false);
+	if(!pipeline_states_.IsReady(shadow_map_pso_)){
+		return E_FAIL;
+	}
+
+
+	//インスタンス描画用(シェーダと頂点レイアウト以外は同じ)
+	if(vs_shadow_map_instanced_ == nullptr){
+		return E_FAIL;
+	}
+	pipeline_state_desc.VS.pShaderBytecode = vs_shadow_map_instanced_->GetBufferPointer();
+	pipeline_state_desc.VS.BytecodeLength  = vs_shadow_map_instanced_->GetBufferSize();
+	pipeline_state_desc.InputLayout.pInputElementDescs	= INSTANCED_INPUT_ELEMENT_DESC;
+	pipeline_state_desc.InputLayout.NumElements			= _countof(INSTANCED_INPUT_ELEMENT_DESC);
+
+	shadow_map_instanced_pso_ = pipeline_states_.Request(pipeline_state_desc, true, shadow_map_pso_);
+
+	return S_OK;
+}
+
+
+//EVSMのぼかしたモーメントの作成(EVSMにしたときに1回だけ呼ぶ)
+//シャドウマップと同じく描き直さないフレームは前の内容を使うので、一時リソースのヒープに置かない
+HRESULT D3D12Manager::CreateShadowMomentsBuffer(){
+	HRESULT hr;
+
+	D3D12_HEAP_PROPERTIES heap_properties{};
+	heap_properties.Type					= D3D12_HEAP_TYPE_DEFAULT;
+	heap_properties.CPUPageProperty			= D3D12_CPU_PAGE_PROPERTY_UNKNOWN;
+	heap_properties.MemoryPoolPreference	= D3D12_MEMORY_POOL_UNKNOWN;
+	heap_properties.CreationNodeMask		= 0;
+	heap_properties.VisibleNodeMask			= 0;
+
+	const D3D12_RESOURCE_DESC moments_desc = GetShadowMomentsDesc(SHADOW_MAP_SIZE, SHADOW_MAP_SIZE, SHADOW_CASCADE_NUM);
+	hr = device_->CreateCommittedResource(&heap_properties, D3D12_HEAP_FLAG_NONE, &moments_desc, D3D12_RESOURCE_STATE_RENDER_TARGET, nullptr, IID_PPV_ARGS(&shadow_moments_buffer_));
+	if(FAILED(hr)){
+		return hr;
+	}
+	state_tracker_.Register(ToRenderResource(shadow_moments_buffer_.Get()), RENDER_STATE_RENDER_TARGET);
+
+	CreateShadowMomentsViews(device_.Get(), shadow_moments_buffer_.Get(), SHADOW_CASCADE_NUM, shadow_moments_rtv_handles_, bindless_heap_.CpuHandle(shadow_moments_index_));
+
+	return S_OK;
+}
+
+
+//EVSMの前処理(全画面の三角形で、カスケードごとのスライスをぼかす)のパイプラインステートの作成
+HRESULT D3D12Manager::CreateShadowFilterPipelineState(){
+
+	if(vs_fullscreen_ == nullptr || ps_evsm_blur_x_ == nullptr || ps_evsm_blur_y_ == nullptr){
+		return E_FAIL;
+	}
+
+	D3D12_GRAPHICS_PIPELINE_STATE_DESC pipeline_state_desc{};
+
+	//シェーダーの設定(頂点はSV_VertexIDから作るので頂点レイアウトはない)
+	pipeline_state_desc.VS.pShaderBytecode = vs_fullscreen_->GetBufferPointer();
+	pipeline_state_desc.VS.BytecodeLength  = vs_fullscreen_->GetBufferSize();
+	pipeline_state_desc.PS.pShaderBytecode = ps_evsm_blur_x_->GetBufferPointer();
+	pipeline_state_desc.PS.BytecodeLength  = ps_evsm_blur_x_->GetBufferSize();
+
+
+	//サンプル系の設定
+	pipeline_state_desc.SampleDesc.Count	= 1;
+	pipeline_state_desc.SampleDesc.Quality	= 0;
+	pipeline_state_desc.SampleMask			= UINT_MAX;
+
+	//レンダーターゲットの設定
+	pipeline_state_desc.NumRenderTargets = 1;
+	pipeline_state_desc.RTVFormats[0]    = SHADOW_MOMENTS_FORMAT;
+
+	//三角形に設定
+	pipeline_state_desc.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
+
+
+	//ルートシグネチャ
+	pipeline_state_desc.pRootSignature = root_sugnature_.Get();
+
+
+	//ラスタライザステートの設定
+	pipeline_state_desc.RasterizerState.CullMode				= D3D12_CULL_MODE_NONE;
+	pipeline_state_desc.RasterizerState.FillMode				= D3D12_FILL_MODE_SOLID;
+	pipeline_state_desc.RasterizerState.FrontCounterClockwise	= FALSE;
+	pipeline_state_desc.RasterizerState.DepthBias				= 0;
+	pipeline_state_desc.RasterizerState.DepthBiasClamp			= 0;
+	pipeline_state_desc.RasterizerState.SlopeScaledDepthBias	= 0;
+	pipeline_state_desc.RasterizerState.DepthClipEnable			= TRUE;
+	pipeline_state_desc.RasterizerState.ConservativeRaster		= D3D12_CONSERVATIVE_RASTERIZATION_MODE_OFF;
+	pipeline_state_desc.RasterizerState.AntialiasedLineEnable	= FALSE;
+	pipeline_state_desc.RasterizerState.MultisampleEnable		= FALSE;
+
+
+	//ブレンドステートの設定
+	pipeline_state_desc.BlendState.RenderTarget[0].BlendEnable				= FALSE;
+	pipeline_state_desc.BlendState.RenderTarget[0].SrcBlend					= D3D12_BLEND_ONE;
+	pipeline_state_desc.BlendState.RenderTarget[0].DestBlend				= D3D12_BLEND_ZERO;
+	pipeline_state_desc.BlendState.RenderTarget[0].BlendOp					= D3D12_BLEND_OP_ADD;
+	pipeline_state_desc.BlendState.RenderTarget[0].SrcBlendAlpha			= D3D12_BLEND_ONE;
+	pipeline_state_desc.BlendState.RenderTarget[0].DestBlendAlpha			= D3D12_BLEND_ZERO;
+	pipeline_state_desc.BlendState.RenderTarget[0].BlendOpAlpha				= D3D12_BLEND_OP_ADD;
+	pipeline_state_desc.BlendState.RenderTarget[0].RenderTargetWriteMask	= D3D12_COLOR_WRITE_ENABLE_ALL;
+	pipeline_state_desc.BlendState.RenderTarget[0].LogicOpEnable			= FALSE;
+	pipeline_state_desc.BlendState.RenderTarget[0].LogicOp					= D3D12_LOGIC_OP_CLEAR;
+
+	pipeline_state_desc.BlendState.AlphaToCoverageEnable  = FALSE;
+	pipeline_state_desc.BlendState.IndependentBlendEnable = FALSE;
+
+
+	//深度バッファは使わない
+	pipeline_state_desc.DepthStencilState.DepthEnable		= FALSE;
+	pipeline_state_desc.DepthStencilState.StencilEnable		= FALSE;
+	pipeline_state_desc.DSVFormat = DXGI_FORMAT_UNKNOWN;
+
+	shadow_blur_x_pso_ = pipeline_states_.Request(pipeline_state_desc, false);
+	if(!pipeline_states_.IsReady(shadow_blur_x_pso_)){
+		return E_FAIL;
+	}
+
+
+	//縦方向(ピクセルシェーダ以外は同じ)
+	pipeline_state_desc.PS.pShaderBytecode = ps_evsm_blur_y_->GetBufferPointer();
+	pipeline_state_desc.PS.BytecodeLength  = ps_evsm_blur_y_->GetBufferSize();
+
+	shadow_blur_y_pso_ = pipeline_states_.Request(pipeline_state_desc, false);
+	if(!pipeline_states_.IsReady(shadow_blur_y_pso_)){
+		return E_FAIL;
+	}
+
+	return S_OK;
+}
+
+
+//フレームグラフの作成
+//パスが読み書きするリソースを宣言し、実行順と一時リソース(深度バッファ・横にぼかしたモーメント)の置き場所を決める
+HRESULT D3D12Manager::CreateFrameGraph(){
+	const D3D12_RESOURCE_DESC depth_desc = GetDepthBufferDesc(window_width_, window_height_);
+	const D3D12_RESOURCE_ALLOCATION_INFO depth_info = device_->GetResourceAllocationInfo(0, 1, &depth_desc);
+	const D3D12_RESOURCE_DESC blur_desc = GetShadowMomentsDesc(SHADOW_MAP_SIZE, SHADOW_MAP_SIZE, SHADOW_CASCADE_NUM);
+	const D3D12_RESOURCE_ALLOCATION_INFO blur_info = device_->GetResourceAllocationInfo(0, 1, &blur_desc);
+
+	//宣言し直した場合は、置き場所が変わらなければ(CompileFrameGraphで作り直さなければ)今の一時リソースを使う
+	RendererGraphDesc desc{};
+	desc.resources[GRAPH_SCENE_DEPTH]		= ToRenderResource(depth_buffer_.Get());
+	desc.resources[GRAPH_SHADOW_MAP]		= ToRenderResource(shadow_buffer_.Get());
+	desc.resources[GRAPH_SHADOW_CACHE]		= ToRenderResource(shadow_cache_buffer_.Get());
+	desc.resources[GRAPH_SHADOW_BLUR]		= ToRenderResource(shadow_blur_buffer_.Get());
+	desc.resources[GRAPH_SHADOW_MOMENTS]	= ToRenderResource(shadow_moments_buffer_.Get());
+	desc.scene_depth_size		= depth_info.SizeInBytes;
+	desc.scene_depth_alignment	= depth_info.Alignment;
+	desc.shadow_blur_size		= blur_info.SizeInBytes;
+	desc.shadow_blur_alignment	= blur_info.Alignment;
+	desc.evsm					= (shadow_filter_ == SHADOW_FILTER_EVSM);
+	DeclareRendererGraph(&frame_graph_, desc, graph_passes_, graph_resources_);
+
+	return CompileFrameGraph();
+}
+
+//フレームグラフのコンパイル
+//一時リソースの置き場所が変わった場合はヒープとリソースを作り直し、残ったパスを提出順に記録処理として登録する
+HRESULT D3D12Manager::CompileFrameGraph(){
+	HRESULT hr;
+
+	for(int i = 0; i < PASS_NUM; ++i){
+		pass_enabled_[i] = IsPassEnabled(i);
+		frame_graph_.SetPassEnabled(graph_passes_[i], pass_enabled_[i]);
+	}
+	if(!frame_graph_.Compile()){
+		OutputDebugStringA(("[framegraph] " + frame_graph_.Error() + "\n").c_str());
+		return E_FAIL;
+	}
+	frame_graph_dirty_ = false;
+
+	//横にぼかしたモーメントはEVSMでシャドウマップを描き直すフレームグラフでだけ置く
+	const bool blur_used = pass_enabled_[PASS_SHADOW_BLUR_X];
+	const bool relocated = (transient_heap_ == nullptr || frame_graph_.TransientSize() > transient_heap_size_ ||
+		frame_graph_.TransientOffset(graph_resources_[GRAPH_SCENE_DEPTH]) != transient_offsets_[GRAPH_SCENE_DEPTH] ||
+		(blur_used && (shadow_blur_buffer_ == nullptr || frame_graph_.TransientOffset(graph_resources_[GRAPH_SHADOW_BLUR]) != transient_offsets_[GRAPH_SHADOW_BLUR])));
+	if(relocated){
+		//作り直すリソースは提出済みのフレームが使っているので完了を待つ
+		if(transient_heap_ != nullptr){
+			hr = WaitForGpu();
+			if(FAILED(hr)){
+				return hr;
+			}
+		}
+		hr = CreateTransientResources();
+		if(FAILED(hr)){
+			return hr;
+		}
+	}
+
+	//グラフのパスをこのクラスのパスに対応させる
+	scheduled_passes_.clear();
+	record_scheduler_.Clear();
+	for(int graph_pass : frame_graph_.Order()){
+		for(int i = 0; i < PASS_NUM; ++i){
+			if(graph_passes_[i] != graph_pass){
+				continue;
+			}
+
+			D3D12RecordTarget *target = &pass_targets_[i];
+			scheduled_passes_.push_back(i);
+			switch(i){
+				case PASS_SHADOW_CACHE:	record_scheduler_.AddPass(target, [this, target](RecordTarget*){return SUCCEEDED(RecordShadowCachePass(target->GetRenderCommandList()));}); break;
+				case PASS_SHADOW_COPY:	record_scheduler_.AddPass(target, [this, target](RecordTarget*){return SUCCEEDED(RecordShadowCopyPass(target->GetRenderCommandList()));}); break;
+				case PASS_SHADOW:	record_scheduler_.AddPass(target, [this, target](RecordTarget*){return SUCCEEDED(RecordShadowPass(target->GetRenderCommandList()));}); break;
+				case PASS_SHADOW_BLUR_X:	record_scheduler_.AddPass(target, [this, target](RecordTarget*){return SUCCEEDED(RecordShadowBlurPass(target->GetRenderCommandList(), false));}); break;
+				case PASS_SHADOW_BLUR_Y:	record_scheduler_.AddPass(target, [this, target](RecordTarget*){return SUCCEEDED(RecordShadowBlurPass(target->GetRenderCommandList(), true));}); break;
+				case PASS_MAIN:		record_scheduler_.AddPass(target, [this, target](RecordTarget*){return SUCCEEDED(RecordMainPass(target->GetRenderCommandList()));}); break;
+				default:			record_scheduler_.AddPass(target, [this, target](RecordTarget*){return SUCCEEDED(RecordDebugPass(target->GetRenderCommandList()));}); break;
+			}
+		}
+	}
+
+	return S_OK;
+}
+
+//一時リソースのヒープを作成し、フレームグラフが決めた位置に深度バッファ(と横にぼかしたモーメント)を置く
+HRESULT D3D12Manager::CreateTransientResources(){
+	HRESULT hr;
+
+	//古いリソースの状態の追跡をやめる
+	state_tracker_.Unregister(ToRenderResource(depth_buffer_.Get()));
+	state_tracker_.Unregister(ToRenderResource(shadow_blur_buffer_.Get()));
+	depth_buffer_.Reset();
+	shadow_blur_buffer_.Reset();
+	transient_heap_.Reset();
+
+
+	D3D12_HEAP_DESC heap_desc{};
+	heap_desc.SizeInBytes						= frame_graph_.TransientSize();
+	heap_desc.Properties.Type					= D3D12_HEAP_TYPE_DEFAULT;
+	heap_desc.Properties.CPUPageProperty		= D3D12_CPU_PAGE_PROPERTY_UNKNOWN;
+	heap_desc.Properties.MemoryPoolPreference	= D3D12_MEMORY_POOL_UNKNOWN;
+	heap_desc.Alignment							= D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
+	heap_desc.Flags								= D3D12_HEAP_FLAG_ALLOW_ONLY_RT_DS_TEXTURES;
+	hr = device_->CreateHeap(&heap_desc, IID_PPV_ARGS(&transient_heap_));
+	if(FAILED(hr)){
+		return hr;
+	}
+	transient_heap_size_ = heap_desc.SizeInBytes;
+
+
+	D3D12_CLEAR_VALUE clear_value{};
+	clear_value.Format					= DXGI_FORMAT_D32_FLOAT;
+	clear_value.DepthStencil.Depth		= 1.0f;
+	clear_value.DepthStencil.Stencil	= 0;
+
+	const D3D12_RESOURCE_DESC depth_desc = GetDepthBufferDesc(window_width_, window_height_);
+	transient_offsets_[GRAPH_SCENE_DEPTH] = frame_graph_.TransientOffset(graph_resources_[GRAPH_SCENE_DEPTH]);
+	hr = device_->CreatePlacedResource(transient_heap_.Get(), transient_offsets_[GRAPH_SCENE_DEPTH], &depth_desc, D3D12_RESOURCE_STATE_DEPTH_WRITE, &clear_value, IID_PPV_ARGS(&depth_buffer_));
+	if(FAILED(hr)){
+		return hr;
+	}
+
+	state_tracker_.Register(ToRenderResource(depth_buffer_.Get()), RENDER_STATE_DEPTH_WRITE);
+	frame_graph_.SetResource(graph_resources_[GRAPH_SCENE_DEPTH], ToRenderResource(depth_buffer_.Get()));
+
+
+	//深度バッファのビューの作成
+	D3D12_DEPTH_STENCIL_VIEW_DESC dsv_desc{};
+	dsv_desc.ViewDimension		= D3D12_DSV_DIMENSION_TEXTURE2D;
+	dsv_desc.Format				= DXGI_FORMAT_D32_FLOAT;
+	dsv_desc.Texture2D.MipSlice = 0;
+	dsv_desc.Flags				= D3D12_DSV_FLAG_NONE;
+	device_->CreateDepthStencilView(depth_buffer_.Get(), &dsv_desc, dsv_handle_);
+
+
+	//横にぼかしたモーメント(ぼかしのパスを使うフレームグラフのみ)
+	if(pass_enabled_[PASS_SHADOW_BLUR_X]){
+		const D3D12_RESOURCE_DESC blur_desc = GetShadowMomentsDesc(SHADOW_MAP_SIZE, SHADOW_MAP_SIZE, SHADOW_CASCADE_NUM);
+		transient_offsets_[GRAPH_SHADOW_BLUR] = frame_graph_.TransientOffset(graph_resources_[GRAPH_SHADOW_BLUR]);
+		hr = device_->CreatePlacedResource(transient_heap_.Get(), transient_offsets_[GRAPH_SHADOW_BLUR], &blur_desc, D3D12_RESOURCE_STATE_RENDER_TARGET, nullptr, IID_PPV_ARGS(&shadow_blur_buffer_));
+		if(FAILED(hr)){
+			return hr;
+		}
+
+		state_tracker_.Register(ToRenderResource(shadow_blur_buffer_.Get()), RENDER_STATE_RENDER_TARGET);
+		frame_graph_.SetResource(graph_resources_[GRAPH_SHADOW_BLUR], ToRenderResource(shadow_blur_buffer_.Get()));
+
+		CreateShadowMomentsViews(device_.Get(), shadow_blur_buffer_.Get(), SHADOW_CASCADE_NUM, shadow_blur_rtv_handles_, bindless_heap_.CpuHandle(shadow_blur_index_));
+	}
+
+	return S_OK;
+}
+
+
+//指定したフェンス値までGPUの処理が進むのを待つ
+HRESULT D3D12Manager::WaitForFence(UINT64 fence_value){
+	HRESULT hr;
+
+	if (queue_fence_->GetCompletedValue() < fence_value){
+		hr = queue_fence_->SetEventOnCompletion(fence_value, fence_event_);
+		if(FAILED(hr)){
+			return hr; 
+		}
+
+		WaitForSingleObject(fence_event_, INFINITE);
+	}
+	return S_OK;
+}
+
+//提出済みのすべてのコマンドの終了待ち(終了時などに使う)
+HRESULT D3D12Manager::WaitForGpu(){
+	HRESULT hr;
+
+	const UINT64 fence = frame_scheduler_.Submit(rtv_index_);
+
+	hr = command_queue_->Signal(queue_fence_.Get(), fence);
+	if(FAILED(hr)){
+		return hr; 
+	}
+
+	hr = WaitForFence(fence);
+	if(FAILED(hr)){
+		return hr; 
+	}
+
+	upload_buffer_.ReleaseCompletedFrames(queue_fence_->GetCompletedValue());
+	return S_OK;
+}
+
+//このフレームの提出を記録して次のバックバッファに進む
+//次のバックバッファのアロケータをGPUがまだ使っている場合のみ待つ
+HRESULT D3D12Manager::MoveToNextFrame(){
+	HRESULT hr;
+
+	const UINT64 fence = frame_scheduler_.Submit(rtv_index_);
+
+	hr = command_queue_->Signal(queue_fence_.Get(), fence);
+	if(FAILED(hr)){
+		return hr; 
+	}
+
+	//このフレームで使った定数の領域は、このフェンスの完了後に再利用する
+	upload_buffer_.FinishFrame(fence);
+
+	//カレントのバックバッファのインデックスを取得する
+	rtv_index_ = swap_chain_->GetCurrentBackBufferIndex();
+
+	hr = WaitForFence(frame_scheduler_.WaitValue(rtv_index_));
+	if(FAILED(hr)){
+		return hr; 
+	}
+
+	upload_buffer_.ReleaseCompletedFrames(queue_fence_->GetCompletedValue());
+	return S_OK;
+}
+
+//シャドウマップのどのパスを使うか
+//キャッシュは静的なキャスターがある場合だけ使い、ない場合はシャドウマップのパスでクリアする
+//EVSMのモーメントはシャドウマップを描き直したフレームだけ作り直す
+bool D3D12Manager::IsPassEnabled(int pass) const{
+	RendererPassState state{};
+	state.redraw				= shadow_cache_.LastRedraw();
+	state.has_static_caster		= shadow_cache_.HasStaticCaster();
+	state.has_dynamic_caster	= shadow_cache_.HasDynamicCaster();
+	state.evsm					= (shadow_filter_ == SHADOW_FILTER_EVSM);
+	state.show_shadow_map		= show_shadow_map_;
+	return IsRendererPassEnabled(pass, state);
+}
+
+//キャスターとライトが前のフレームから動いたかを調べ、今フレームでシャドウマップを描き直す範囲を決める
+HRESULT D3D12Manager::UpdateShadowCache(){
+	float transform[17];
+
+	//インスタンス描画の球は時刻からインスタンスごとの変換を求めるので時刻も比べる
+	memcpy(transform, &sphere_.World(), sizeof(XMFLOAT4X4));
+	transform[16] = sphere_.IsInstanced() ? sphere_.Time() : 0.0f;
+	shadow_cache_.SetTransform(shadow_casters_[SHADOW_CASTER_SPHERE], transform, 17);
+
+	memcpy(transform, &plane_.World(), sizeof(XMFLOAT4X4));
+	shadow_cache_.SetTransform(shadow_casters_[SHADOW_CASTER_PLANE], transform, 16);
+
+	shadow_cache_.Update();
+
+	//使うパスが変わったらフレームグラフをコンパイルし直す
+	for(int i = 0; i < PASS_NUM; ++i){
+		if(IsPassEnabled(i) != pass_enabled_[i]){
+			frame_graph_dirty_ = true;
+		}
+	}
+
+	return S_OK;
+}
+
+//シャドウマップの各カスケードのスライスに、静的なキャスター(static_castersがtrueの場合)か動的なキャスターを描く
+void D3D12Manager::DrawShadowCasters(RenderCommandList *command_list, const D3D12_CPU_DESCRIPTOR_HANDLE *dsv_handles, bool static_casters, bool clear){
+	const bool draw_sphere	= (shadow_cache_.IsStatic(shadow_casters_[SHADOW_CASTER_SPHERE]) == static_casters);
+	const bool draw_plane	= (shadow_cache_.IsStatic(shadow_casters_[SHADOW_CASTER_PLANE]) == static_casters);
+
+
+	//ルートシグネチャとPSOの設定
+	command_list->SetRootSignature(ToRenderRootSignature(root_sugnature_.Get()));
+	command_list->SetPipeline(ToRenderPipeline(pipeline_states_.Get(shadow_map_pso_)));
+
+
+	//ビューポートとシザー矩形の設定
+	command_list->SetViewport(viewport_sm_);
+	command_list->SetScissorRect(scissor_rect_sm_);
+
+
+	for(UINT i = 0; i < SHADOW_CASCADE_NUM; ++i){
+		const RenderTargetView shadow_dsv = ToRenderTargetView(dsv_handles[i]);
+
+		//スライスを深度バッファに設定(キャッシュをコピーした場合はクリアしない)
+		if(clear){
+			command_list->ClearDepth(shadow_dsv, 1.0f);
+		}
+		command_list->SetRenderTargets(0, nullptr, shadow_dsv);
+
+
+		//ライトの設定(LightVPがこのカスケードの行列になっているもの)
+		command_list->SetConstantBuffer(1, light_constants_[i + 1]);
+
+
+		//球の描画(インスタンス描画の場合はPSOを切り替える)
+		//視錐台はカメラの次からカスケードの順なので、このカスケードの視錐台に掛かるものだけを描く
+		const int view = i + 1;
+		if(draw_sphere && IsVisible(view, SHADOW_CASTER_SPHERE)){
+			if(sphere_.IsInstanced()){
+				command_list->SetPipeline(ToRenderPipeline(pipeline_states_.Get(shadow_map_instanced_pso_)));
+				sphere_.Draw(command_list, view);
+				command_list->SetPipeline(ToRenderPipeline(pipeline_states_.Get(shadow_map_pso_)));
+			}else{
+				sphere_.Draw(command_list, view);
+			}
+		}
+
+
+		//板ポリの描画
+		if(draw_plane && IsVisible(view, SHADOW_CASTER_PLANE)){
+			plane_.Draw(command_list);
+		}
+	}
+}
+
+//静的なキャスターだけをキャッシュに描く(キャスターが静的・動的の間で切り替わったか、ライトが動いたフレームのみ)
+HRESULT D3D12Manager::RecordShadowCachePass(RenderCommandList *command_list){
+	RecordBarriers(command_list, frame_graph_.BeginBarriers(graph_passes_[PASS_SHADOW_CACHE]));
+	DrawShadowCasters(command_list, shadow_cache_dsv_handles_, true, true);
+	RecordBarriers(command_list, frame_graph_.EndBarriers(graph_passes_[PASS_SHADOW_CACHE]));
+
+	return S_OK;
+}
+
+//キャッシュをシャドウマップにコピーする(動的なキャスターはこの上に描く)
+HRESULT D3D12Manager::RecordShadowCopyPass(RenderCommandList *command_list){
+	RecordBarriers(command_list, frame_graph_.BeginBarriers(graph_passes_[PASS_SHADOW_COPY]));
+	command_list->CopyResource(ToRenderResource(shadow_buffer_.Get()), ToRenderResource(shadow_cache_buffer_.Get()));
+	RecordBarriers(command_list, frame_graph_.EndBarriers(graph_passes_[PASS_SHADOW_COPY]));
+
+	return S_OK;
+}
+
+//シャドーマップ用の深度バッファの描画(カスケードごとに配列のスライスへ動的なキャスターを描く)
+HRESULT D3D12Manager::RecordShadowPass(RenderCommandList *command_list){
+
+	//シャドーマップ用のテクスチャを深度書き込みに設定
+	RecordBarriers(command_list, frame_graph_.BeginBarriers(graph_passes_[PASS_SHADOW]));
+
+	//キャッシュをコピーしていなければクリアしてから描く
+	DrawShadowCasters(command_list, shadow_dsv_handles_, false, !shadow_cache_.HasStaticCaster());
+
+	//シェーダリソースへの遷移は読む側のパスの先頭で行う
+	RecordBarriers(command_list, frame_graph_.EndBarriers(graph_passes_[PASS_SHADOW]));
+
+	return S_OK;
+}
+
+//EVSMのモーメントを作り、カスケードごとのスライスをぼかす(全画面の三角形を描く)
+//横方向はシャドウマップの深度を歪めてぼかし、縦方向は横にぼかしたものをさらにぼかす
+HRESULT D3D12Manager::RecordShadowBlurPass(RenderCommandList *command_list, bool vertical){
+	const int pass = vertical ? PASS_SHADOW_BLUR_Y : PASS_SHADOW_BLUR_X;
+	const D3D12_CPU_DESCRIPTOR_HANDLE *rtv_handles = vertical ? shadow_moments_rtv_handles_ : shadow_blur_rtv_handles_;
+	const FLOAT clear_color[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+
+	RecordBarriers(command_list, frame_graph_.BeginBarriers(graph_passes_[pass]));
+
+	//ルートシグネチャとPSOの設定
+	command_list->SetRootSignature(ToRenderRootSignature(root_sugnature_.Get()));
+	command_list->SetPipeline(ToRenderPipeline(pipeline_states_.Get(vertical ? shadow_blur_y_pso_ : shadow_blur_x_pso_)));
+
+	//ビューポートとシザー矩形の設定
+	command_list->SetViewport(viewport_sm_);
+	command_list->SetScissorRect(scissor_rect_sm_);
+
+	//読むテクスチャの添字(横方向はシャドウマップ、縦方向は横にぼかしたモーメント)
+	const uint32_t indices[2] = {shadow_blur_index_, shadow_map_index_};
+	command_list->SetDescriptorHeap(ToRenderDescriptorHeap(bindless_heap_.GetHeap()));
+	command_list->SetDescriptorTable(3, ToRenderDescriptorTable(bindless_heap_.GpuHandle(0)));
+	command_list->SetRootConstants(2, 2, indices, DESCRIPTOR_INDEX_TEXTURE);
+	command_list->SetTopology(RENDER_TOPOLOGY_TRIANGLE_LIST);
+
+	for(UINT i = 0; i < SHADOW_CASCADE_NUM; ++i){
+		const RenderTargetView rtv = ToRenderTargetView(rtv_handles[i]);
+
+		//横にぼかしたものは深度バッファとメモリを共有するので、書き込む前にクリアして内容を確定させる
+		if(!vertical){
+			command_list->ClearRenderTarget(rtv, clear_color);
+		}
+		command_list->SetRenderTargets(1, &rtv, RenderTargetView{});
+		command_list->SetRootConstants(2, 1, &i, DESCRIPTOR_INDEX_SHADOW_SLICE);
+		command_list->Draw(3, 1, 0, 0);
+	}
+
+	RecordBarriers(command_list, frame_graph_.EndBarriers(graph_passes_[pass]));
+
+	return S_OK;
+}
+
+
+//通常のモデルの描画
+HRESULT D3D12Manager::RecordMainPass(RenderCommandList *command_list){
+	FLOAT clear_color[4] = {0.0f, 0.0f, 0.0f, 1.0f};
+	const RenderTargetView rtv = ToRenderTargetView(rtv_handle_[rtv_index_]);
+	const RenderTargetView dsv = ToRenderTargetView(dsv_handle_);
+	
+	//シャドウマップをシェーダリソースに、バックバッファをレンダーターゲットに変更(1回のバリアにまとめる)
+	RecordBarriers(command_list, frame_graph_.BeginBarriers(graph_passes_[PASS_MAIN]));
+
+
+	//深度バッファとレンダーターゲットのクリア
+	command_list->ClearDepth(dsv, 1.0f);
+	command_list->ClearRenderTarget(rtv, clear_color);
+	
+	//ルートシグネチャとPSOの設定
+	command_list->SetRootSignature(ToRenderRootSignature(root_sugnature_.Get()));
+	command_list->SetPipeline(ToRenderPipeline(pipeline_states_.Get(pipeline_state_)));
+	
+	//ビューポートとシザー矩形の設定
+	command_list->SetViewport(viewport_);
+	command_list->SetScissorRect(scissor_rect_);
+
+	//レンダーターゲットの設定
+	command_list->SetRenderTargets(1, &rtv, dsv);
+
+	//ライトの設定(全てのカスケードの行列と境界)
+	command_list->SetConstantBuffer(1, light_constants_[0]);
+
+	//全てのテクスチャのヒープはこのパスで1回だけ設定し、各オブジェクトはテクスチャの添字だけを設定する
+	//シャドウマップのフィルタの段階も定数で渡す(シェーダは全てのピクセルで同じ方へ分岐する)
+	const uint32_t shadow_indices[3] = {shadow_map_index_, shadow_moments_index_, static_cast<uint32_t>(shadow_filter_)};
+	command_list->SetDescriptorHeap(ToRenderDescriptorHeap(bindless_heap_.GetHeap()));
+	command_list->SetDescriptorTable(3, ToRenderDescriptorTable(bindless_heap_.GpuHandle(0)));
+	command_list->SetRootConstants(2, 3, shadow_indices, DESCRIPTOR_INDEX_SHADOW_MAP);
+
+
+	//球の描画(インスタンス描画の場合はPSOを切り替える)
+	//カメラの視錐台の外にあるものは描かない
+	if(IsVisible(0, SHADOW_CASTER_SPHERE)){
+		if(sphere_.IsInstanced()){
+			command_list->SetPipeline(ToRenderPipeline(pipeline_states_.Get(pipeline_state_instanced_)));
+			sphere_.Draw(command_list, 0);
+			command_list->SetPipeline(ToRenderPipeline(pipeline_states_.Get(pipeline_state_)));
+		}else{
+			sphere_.Draw(command_list, 0);
+		}
+	}
+
+
+	//板ポリの描画
+	if(IsVisible(0, SHADOW_CASTER_PLANE)){
+		plane_.Draw(command_list);
+	}
+
+	RecordBarriers(command_list, frame_graph_.EndBarriers(graph_passes_[PASS_MAIN]));
+
+	return S_OK;
+}
+
+
+//シャドウマップのデバッグ表示
+HRESULT D3D12Manager::RecordDebugPass(RenderCommandList *command_list){
+	const RenderTargetView rtv = ToRenderTargetView(rtv_handle_[rtv_index_]);
+
+	RecordBarriers(command_list, frame_graph_.BeginBarriers(graph_passes_[PASS_DEBUG]));
+
+	//ビューポートとシザー矩形の設定
+	command_list->SetViewport(viewport_);
+	command_list->SetScissorRect(scissor_rect_);
+
+	//レンダーターゲットの設定
+	command_list->SetRenderTargets(1, &rtv, ToRenderTargetView(dsv_handle_));
+
+
+	//シャドウマップのデバッグ表示(SRVは全てのテクスチャのヒープにあるものを使う)
+	command_list->SetDescriptorHeap(ToRenderDescriptorHeap(bindless_heap_.GetHeap()));
+	sm_debug_.Draw(command_list, ToRenderDescriptorTable(bindless_heap_.GpuHandle(shadow_map_index_)));
+
+
+	//リソースの状態をレンダーターゲットからプレゼント用に変更
+	RecordBarriers(command_list, frame_graph_.EndBarriers(graph_passes_[PASS_DEBUG]));
+
+	return S_OK;
+}
+
+
+//描画コマンドを積む
+HRESULT D3D12Manager::PopulateCommandList(){
+	HRESULT hr;
+
+	//定数の書き込みは記録を始める前にメインスレッドで済ませておく
+	//アニメーションを進めてシーンの変換を求め、カスケードを求めてから視錐台を作り、板ポリを遮蔽物として描いてから球のインスタンスと板ポリ・球をそれぞれの視錐台で調べる
+	plane_.Animate();
+	sphere_.Animate();
+	scene_.Update(&jobs_);
+	hr = UpdateLight();
+	if(FAILED(hr)){
+		return hr;
+	}
+	UpdateFrustums();
+
+	//アップロード用のリングが空いていない場合は定数が前のフレームの(解放済みの)領域を指したままなので、このフレームは記録しない
+	hr = plane_.Update(&upload_buffer_);
+	if(FAILED(hr)){
+		return hr;
+	}
+	RasterizeOccluders();
+	hr = sphere_.Update(&upload_buffer_, frustums_, SHADOW_CASCADE_NUM + 1, &occlusion_culler_);
+	if(FAILED(hr)){
+		return hr;
+	}
+	CullObjects();
+	hr = UpdateShadowCache();
+	if(FAILED(hr)){
+		return hr;
+	}
+
+	//ここから先でこのフレームを記録しない場合は、ShadowCache::Updateで消費した描き直しを次のフレームで行わせる
+	//表示の切り替えやシャドウマップの描き直しの範囲でパスが変わった場合はフレームグラフをコンパイルし直す
+	//一時リソースを作り直すときはWaitForGpuでフェンス値を1つ進めるので、このフレームのフェンス値を使う前に済ませる
+	if(frame_graph_dirty_){
+		hr = CompileFrameGraph();
+		if(FAILED(hr)){
+			shadow_cache_.Invalidate();
+			return hr;
+		}
+	}
+
+	//今フレームの要求でテクスチャのストリーミングを進める(このフレームの描画は転送の完了をGPU側で待つ)
+	stream_target_.SetLastFrameFence(frame_scheduler_.LastSubmitted());
+	streamer_.Update();
+
+	//今フレームで使うブロックを伝え、予算を超えそうなら使っていないブロックを退避する(退避していたものは提出前に常駐させる)
+	residency_.BeginFrame(frame_scheduler_.LastSubmitted() + 1);
+	plane_.UseMemory(&memory_allocator_);
+	sphere_.UseMemory(&memory_allocator_);
+	if(show_shadow_map_){
+		sm_debug_.UseMemory(&memory_allocator_);
+	}
+	//常駐させられなかった場合は退避したヒープを使うコマンドを提出しないように、このフレームは記録しない(次のフレームでやり直す)
+	if(!residency_.Update(queue_fence_->GetCompletedValue())){
+		shadow_cache_.Invalidate();
+		return E_OUTOFMEMORY;
+	}
+
+	//パスごとのバリアは提出順に状態をたどって求めておく(パスはワーカースレッドで並行して記録する)
+	frame_graph_.SetResource(graph_resources_[GRAPH_BACK_BUFFER], ToRenderResource(render_target_[rtv_index_].Get()));
+	frame_graph_.BuildBarriers(&state_tracker_);
+
+	//各パスをそれぞれのコマンドリストに記録する
+	//アロケータはrtv_index_のものを使う(MoveToNextFrameでGPUの完了を確認済み)
+	if(!record_scheduler_.Record(static_cast<int>(rtv_index_), parallel_recording_ ? &jobs_ : nullptr)){
+		shadow_cache_.Invalidate();
+		return E_FAIL;
+	}
+
+	return ExecuteCommandList();
+}
+
+//記録したコマンドリストをまとめてキューに積む(完了は待たない)
+HRESULT D3D12Manager::ExecuteCommandList(){
+	ID3D12CommandList *command_lists[PASS_NUM];
+	const UINT list_num = static_cast<UINT>(scheduled_passes_.size());
+	for(UINT i = 0; i < list_num; ++i){
+		command_lists[i] = pass_targets_[scheduled_passes_[i]].GetCommandList();
+	}
+	command_queue_->ExecuteCommandLists(list_num, command_lists);
+
+	return S_OK;
+}
+
+
+//画面をフリップする
+HRESULT D3D12Manager::Render(){
+	HRESULT hr;
+
+
+	hr = PopulateCommandList();
+	if(FAILED(hr)){
+		return hr;
+	}
+
+	hr = swap_chain_->Present(1, 0);
+	if(FAILED(hr)){
+		return hr;
+	}
+
+	//次のバックバッファに進む(GPUは最大RTV_NUMフレーム分先行して処理できる)
+	return MoveToNextFrame();
+}
+
+//シャドウマップのフィルタの段階を変える
+//EVSMにしたときはぼかしたモーメントを作り、メインのパスが読むものが変わるのでフレームグラフを宣言し直す
+HRESULT D3D12Manager::SetShadowFilter(ShadowFilterTier tier){
+	HRESULT hr;
+
+	if(tier < 0 || tier >= SHADOW_FILTER_NUM){
+		return E_INVALIDARG;
+	}
+	if(tier == shadow_filter_){
+		return S_OK;
+	}
+
+	if(tier == SHADOW_FILTER_EVSM && shadow_moments_buffer_ == nullptr){
+		hr = CreateShadowMomentsBuffer();
+		if(FAILED(hr)){
+			return hr;
+		}
+	}
+	shadow_filter_ = tier;
+
+	//モーメントは描き直したフレームでだけ作るので、次のフレームでシャドウマップを描き直させる
+	shadow_cache_.Invalidate();
+
+	return CreateFrameGraph();
+}
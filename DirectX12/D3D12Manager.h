@@ -1,102 +1,268 @@
-#ifndef DEF_D3D12MANAGER_H
-#define DEF_D3D12MANAGER_H
-
-#include <Windows.h>
-#include <d3d12.h>
-#include <d3d12shader.h>
-#include <dxgi1_4.h>
-#include <d3dcompiler.h>
-#include <DirectXMath.h>
-#include <wrl/client.h>
-#include "Plane.h"
-#include "Sphere.h"
-#include "ShadowMapDebug.h"
-
-
-using namespace DirectX;
-using namespace Microsoft::WRL;
-
-struct Vertex3D{
-	XMFLOAT3 Position;	//ʒu
-	XMFLOAT3 Normal;	//@
-	XMFLOAT2 UV;		//UVW
-};
-
-
-class D3D12Manager{
-public:
-	static constexpr int RTV_NUM = 2;
-
-public:
-	D3D12Manager(HWND hwnd, int window_width, int window_height);
-	~D3D12Manager();
-	HRESULT CreateFactory();
-	HRESULT CreateDevice();
-	HRESULT CreateCommandQueue();
-	HRESULT CreateSwapChain();
-	HRESULT CreateRenderTargetView();
-	HRESULT CreateDepthStencilBuffer();
-	HRESULT CreateCommandList();
-	HRESULT CreateRootSignature();
-	HRESULT CreatePipelineStateObject();
-	HRESULT CreateLightBuffer();
-	HRESULT CreateShadowBuffer();
-	HRESULT CreateShadowMapPipelineState();
-	HRESULT WaitForPreviousFrame();
-	HRESULT SetResourceBarrier(ID3D12Resource* resource, D3D12_RESOURCE_STATES BeforeState, D3D12_RESOURCE_STATES AfterState);
-	HRESULT PopulateCommandList();
-	HRESULT ExecuteCommandList();
-	HRESULT Render();
-
-private:
-	HWND window_handle_;
-	int window_width_;
-	int window_height_;
-	
-	UINT64 frames_;
-	UINT rtv_index_;
-
-	ComPtr<IDXGIFactory4>				factory_;
-	ComPtr<IDXGIAdapter3>				adapter_;
-	ComPtr<ID3D12Device>				device_;
-	ComPtr<ID3D12CommandQueue>			command_queue_;
-	HANDLE								fence_event_;
-	ComPtr<ID3D12Fence>					queue_fence_;
-	ComPtr<IDXGISwapChain3>				swap_chain_;
-	ComPtr<ID3D12GraphicsCommandList>	command_list_;
-	ComPtr<ID3D12CommandAllocator>		command_allocator_;
-	ComPtr<ID3D12Resource>				render_target_[RTV_NUM];
-	ComPtr<ID3D12DescriptorHeap>		dh_rtv_;
-	D3D12_CPU_DESCRIPTOR_HANDLE			rtv_handle_[RTV_NUM];
-	ComPtr<ID3D12Resource>				depth_buffer_;
-	ComPtr<ID3D12DescriptorHeap>		dh_dsv_;
-	D3D12_CPU_DESCRIPTOR_HANDLE			dsv_handle_;
-	ComPtr<ID3D12PipelineState>			pipeline_state_;
-	ComPtr<ID3D12RootSignature>			root_sugnature_;
-	
-	
-	ComPtr<ID3D12Resource>				light_buffer_;		//Cgp̒萔obt@
-	ComPtr<ID3D12DescriptorHeap>		dh_shadow_buffer_;	//VhE}bvp[xobt@pfXNv^q[v
-	ComPtr<ID3D12DescriptorHeap>		dh_shadow_texture_;	//VhE}bvp[xeNX`pfXNv^q[v
-	ComPtr<ID3D12Resource>				shadow_buffer_;		//VhE}bvp[xobt@
-	ComPtr<ID3D12PipelineState>			shadow_map_pso_;	//VhE}bvp̃pCvC
-	D3D12_RECT							scissor_rect_sm_;
-	D3D12_VIEWPORT						viewport_sm_;
-
-
-	XMFLOAT3							light_pos_;			//Cg̈ʒu
-	XMFLOAT3							light_dst_;			//Cg̒_
-	XMFLOAT3							light_dir_;			//fBNViCǧ
-	XMFLOAT4							iight_color_;		//fBNViCg̐F
-	
-	
-	D3D12_RECT							scissor_rect_;
-	D3D12_VIEWPORT						viewport_;
-
-	Plane plane_;
-	Sphere sphere_;
-	ShadowMapDebug sm_debug_;
-
-};
-
-#endif
+#ifndef DEF_D3D12MANAGER_H
+#define DEF_D3D12MANAGER_H
+
+#include <Windows.h>
+#include <d3d12.h>
+#include <d3d12shader.h>
+#include <dxgi1_4.h>
+#include <d3dcompiler.h>
+#include <DirectXMath.h>
+#include <wrl/client.h>
+#include "Vertex3D.h"
+#include "TextureContainer.h"
+#include "JobSystem.h"
+#include "StageTimer.h"
+#include "ShaderCache.h"
+#include "ShaderCompiler.h"
+#include "PipelineStateManager.h"
+#include "UploadRingBuffer.h"
+#include "GpuMemoryAllocator.h"
+#include "ResidencyManager.h"
+#include "D3D12ResidencyTarget.h"
+#include "CopyUploader.h"
+#include "BindlessHeap.h"
+#include "ResourceStateTracker.h"
+#include "RenderGraph.h"
+#include "RendererGraph.h"
+#include "ShadowCascades.h"
+#include "ShadowCache.h"
+#include "ShadowFilter.h"
+#include "FrustumCuller.h"
+#include "OcclusionCuller.h"
+#include "Scene.h"
+#include "TextureStreamer.h"
+#include "D3D12StreamTarget.h"
+#include "FrameScheduler.h"
+#include "RecordScheduler.h"
+#include "D3D12RecordTarget.h"
+#include "Plane.h"
+#include "Sphere.h"
+#include "ShadowMapDebug.h"
+
+
+using namespace DirectX;
+using namespace Microsoft::WRL;
+
+inline DXGI_FORMAT GetDXGIFormat(TextureFormat format){
+	switch(format){
+		case TEXTURE_FORMAT_BC1: return DXGI_FORMAT_BC1_UNORM;
+		case TEXTURE_FORMAT_BC3: return DXGI_FORMAT_BC3_UNORM;
+		default:				 return DXGI_FORMAT_B8G8R8A8_UNORM;
+	}
+}
+
+class D3D12Manager{
+public:
+	static constexpr int RTV_NUM = 2;
+	static constexpr UINT64 UPLOAD_BUFFER_SIZE = 64 * 1024 * 1024;	//フレームごとの定数・インスタンスデータ用(インスタンスデータは視錐台ごとに書く)
+	static constexpr UINT64 STAGING_BUFFER_SIZE = 32 * 1024 * 1024;	//頂点・テクスチャをDEFAULTヒープへ転送するためのステージング
+	static constexpr UINT SHADOW_MAP_SIZE = 1024;		//カスケード1枚の大きさ
+	static constexpr UINT SHADOW_CASCADE_NUM = 3;		//シャドウマップの配列のスライス数(シェーダのSHADOW_CASCADE_NUMと合わせる)
+	static constexpr float SHADOW_DISTANCE = 12.0f;		//カメラからこの奥行きまでをカスケードに分けて影を描く
+	static constexpr UINT BINDLESS_HEAP_SIZE = 1024;	//全てのテクスチャのSRVを置くヒープの大きさ(シェーダのBINDLESS_TEXTURE_NUMと合わせる)
+	static constexpr UINT64 STREAM_FRAME_BUDGET = TextureStreamer::DEFAULT_FRAME_BUDGET;	//テクスチャのストリーミングで1フレームに転送するバイト数
+	static constexpr unsigned int STREAM_THREAD_NUM = 2;	//テクスチャのストリーミングの読み込み用
+	static constexpr const char *PIPELINE_LIBRARY_FILE = "pipelines.cache";	//ドライバがコンパイルしたPSOの保存先
+	static constexpr ShadowFilterTier DEFAULT_SHADOW_FILTER = SHADOW_FILTER_PCF;	//シャドウマップのフィルタの段階(SetShadowFilterで変える)
+
+	//ルート定数で渡すデスクリプタの添字とシャドウマップのフィルタの設定(シェーダのcbDescriptorIndexと合わせる)
+	enum DescriptorIndex{
+		DESCRIPTOR_INDEX_TEXTURE,
+		DESCRIPTOR_INDEX_SHADOW_MAP,
+		DESCRIPTOR_INDEX_SHADOW_MOMENTS,
+		DESCRIPTOR_INDEX_SHADOW_FILTER,		//ShadowFilterTier(添字ではない)
+		DESCRIPTOR_INDEX_SHADOW_SLICE,		//EVSMのぼかしで描く配列のスライス
+		DESCRIPTOR_INDEX_NUM,
+	};
+
+	//影を落とすもの(シャドウマップのキャッシュで動いたかを調べる単位)
+	enum ShadowCaster{
+		SHADOW_CASTER_SPHERE,
+		SHADOW_CASTER_PLANE,
+		SHADOW_CASTER_NUM,
+	};
+
+public:
+	D3D12Manager(HWND hwnd, int window_width, int window_height);
+	~D3D12Manager();
+	HRESULT CreateFactory();
+	HRESULT CreateDevice();
+	HRESULT CreatePipelineStateManager();
+	HRESULT CreateCommandQueue();
+	HRESULT CreateUploader();
+	HRESULT CreateSwapChain();
+	HRESULT CreateRenderTargetView();
+	HRESULT CreateDepthStencilBuffer();
+	HRESULT CreateCommandList();
+	HRESULT CreateUploadBuffer();
+	HRESULT CreateBindlessHeap();
+	HRESULT CreateRootSignature();
+	HRESULT CompileShaders();
+	HRESULT CreatePipelineStateObject();
+	HRESULT CreateLightBuffer();
+	HRESULT CreateShadowBuffer();
+	HRESULT CreateShadowMapPipelineState();
+	HRESULT CreateShadowFilterPipelineState();
+	HRESULT CreateShadowMomentsBuffer();
+	HRESULT CreateFrameGraph();
+	HRESULT CompileFrameGraph();
+	HRESULT CreateTransientResources();
+	HRESULT WaitForFence(UINT64 fence_value);
+	HRESULT WaitForGpu();
+	HRESULT MoveToNextFrame();
+	HRESULT UpdateLight();
+	void UpdateFrustums();
+	void RasterizeOccluders();
+	void CullObjects();
+	HRESULT UpdateShadowCache();
+	HRESULT RecordShadowCachePass(RenderCommandList *command_list);
+	HRESULT RecordShadowCopyPass(RenderCommandList *command_list);
+	HRESULT RecordShadowPass(RenderCommandList *command_list);
+	HRESULT RecordShadowBlurPass(RenderCommandList *command_list, bool vertical);
+	HRESULT RecordMainPass(RenderCommandList *command_list);
+	HRESULT RecordDebugPass(RenderCommandList *command_list);
+	HRESULT PopulateCommandList();
+	HRESULT ExecuteCommandList();
+	HRESULT Render();
+
+	//球の数(2以上ならインスタンス描画になる)
+	void SetSphereInstanceNum(int num){sphere_.SetInstanceNum(num);}
+
+	//テクスチャのストリーミングで1フレームに転送するバイト数(0なら制限しない)
+	void SetStreamingBudget(UINT64 bytes){streamer_.SetFrameBudget(bytes);}
+
+	//シャドウマップのデバッグ表示(表示しない場合はフレームグラフからパスを外す)
+	void SetShadowMapDebug(bool show){show_shadow_map_ = show; frame_graph_dirty_ = true;}
+
+	//板ポリ・球のアニメーションを止める(止めたものは静的なキャスターとしてシャドウマップのキャッシュに描く)
+	void PauseAnimation(bool plane, bool sphere){plane_.SetPaused(plane); sphere_.SetPaused(sphere);}
+
+	//シャドウマップのフィルタの段階(EVSMにしたときにモーメントのリソースを作り、フレームグラフを宣言し直す)
+	HRESULT SetShadowFilter(ShadowFilterTier tier);
+	ShadowFilterTier GetShadowFilter() const{return shadow_filter_;}
+
+	//シャドウマップを描き直したフレーム・描き直さなかったフレームの数
+	const ShadowCache::Stats& GetShadowCacheStats() const{return shadow_cache_.GetStats();}
+
+	//GPUメモリの予算・使用量と、退避・常駐させ直した量
+	const ResidencyManager::Stats& GetResidencyStats() const{return residency_.GetStats();}
+
+private:
+	bool IsPassEnabled(int pass) const;
+	bool IsVisible(int view, ShadowCaster caster) const{return object_visible_[view][caster];}
+	void DrawShadowCasters(RenderCommandList *command_list, const D3D12_CPU_DESCRIPTOR_HANDLE *dsv_handles, bool static_casters, bool clear);
+
+private:
+	HWND window_handle_;
+	int window_width_;
+	int window_height_;
+	
+	UINT rtv_index_;
+
+	ComPtr<IDXGIFactory4>				factory_;
+	ComPtr<IDXGIAdapter3>				adapter_;
+	ComPtr<ID3D12Device>				device_;
+	ComPtr<ID3D12CommandQueue>			command_queue_;
+	HANDLE								fence_event_;
+	ComPtr<ID3D12Fence>					queue_fence_;
+	ComPtr<IDXGISwapChain3>				swap_chain_;
+	D3D12RecordTarget					pass_targets_[PASS_NUM];	//パスごとのコマンドリストとアロケータ
+	RecordScheduler						record_scheduler_;			//パスの記録をワーカースレッドに振り分ける
+	ResourceStateTracker				state_tracker_;				//フレームグラフのリソースの状態
+	RenderGraph							frame_graph_;				//パスの依存・実行順・一時リソースのメモリの割り当て
+	int									graph_passes_[PASS_NUM];
+	int									graph_resources_[GRAPH_RESOURCE_NUM];
+	std::vector<int>					scheduled_passes_;			//コンパイルで残ったパス(提出順)
+	bool								frame_graph_dirty_;			//次のフレームの前にコンパイルし直す
+	bool								pass_enabled_[PASS_NUM];	//コンパイルしたときにパスを有効にしたか
+	bool								show_shadow_map_;
+	ComPtr<ID3D12Heap>					transient_heap_;			//一時リソースを置くヒープ(使う間が重ならないものは同じ位置に置く)
+	UINT64								transient_heap_size_;
+	UINT64								transient_offsets_[GRAPH_RESOURCE_NUM];	//今のヒープで一時リソースを置いた位置
+	bool								parallel_recording_;		//falseならメインスレッドで順に記録する
+	ComPtr<ID3D12Resource>				render_target_[RTV_NUM];
+	ComPtr<ID3D12DescriptorHeap>		dh_rtv_;
+	D3D12_CPU_DESCRIPTOR_HANDLE			rtv_handle_[RTV_NUM];
+	ComPtr<ID3D12Resource>				depth_buffer_;
+	ComPtr<ID3D12DescriptorHeap>		dh_dsv_;
+	D3D12_CPU_DESCRIPTOR_HANDLE			dsv_handle_;
+	PipelineStateManager::Handle		pipeline_state_;	//通常描画用のパイプライン
+	ComPtr<ID3D12RootSignature>			root_sugnature_;
+	ComPtr<ID3DBlob>					vs_main_;			//通常描画用の頂点シェーダ
+	ComPtr<ID3DBlob>					ps_main_;			//通常描画用のピクセルシェーダ
+	ComPtr<ID3DBlob>					vs_shadow_map_;		//シャドウマップ用の頂点シェーダ
+	ComPtr<ID3DBlob>					vs_main_instanced_;			//インスタンス描画用の頂点シェーダ
+	ComPtr<ID3DBlob>					ps_main_instanced_;			//インスタンス描画用のピクセルシェーダ
+	ComPtr<ID3DBlob>					vs_shadow_map_instanced_;	//インスタンス描画のシャドウマップ用の頂点シェーダ
+	PipelineStateManager::Handle		pipeline_state_instanced_;	//インスタンス描画用のパイプライン(作成中は通常描画用を使う)
+	
+	
+	RenderGpuAddress					light_constants_[SHADOW_CASCADE_NUM + 1];	//今フレームのライトの定数(先頭は通常の描画用、続いてカスケードごとのシャドウマップの描画用)
+	ShadowCascades						cascades_;			//カスケードの分割とライトの行列
+	ShadowCascades::Camera				camera_;			//scene_に渡したカメラ(カスケードの分割にも使う)
+	ComPtr<ID3D12DescriptorHeap>		dh_shadow_buffer_;	//シャドウマップ用深度バッファ用デスクリプタヒープ(シャドウマップ・キャッシュのカスケードごとのDSV)
+	D3D12_CPU_DESCRIPTOR_HANDLE			shadow_dsv_handles_[SHADOW_CASCADE_NUM];
+	D3D12_CPU_DESCRIPTOR_HANDLE			shadow_cache_dsv_handles_[SHADOW_CASCADE_NUM];
+	UINT								shadow_map_index_;	//シャドウマップのSRVのbindless_heap_上の添字
+	ComPtr<ID3D12Resource>				shadow_buffer_;		//シャドウマップ用深度バッファ(Texture2DArray)
+	ComPtr<ID3D12Resource>				shadow_cache_buffer_;	//静的なキャスターだけを描いたシャドウマップ(shadow_buffer_と同じ形)
+	ShadowCache							shadow_cache_;		//キャスター・ライトが動いたかを調べて描き直す範囲を決める
+	int									shadow_casters_[SHADOW_CASTER_NUM];
+	FrustumCuller::Frustum				frustums_[SHADOW_CASCADE_NUM + 1];	//今フレームの視錐台(先頭はカメラ、続いてカスケードごとのライト)
+	FrustumCuller						object_culler_;		//板ポリ・球の境界(ShadowCasterの順)
+	bool								object_visible_[SHADOW_CASCADE_NUM + 1][SHADOW_CASTER_NUM];	//視錐台ごとに描くか
+	Scene								scene_;				//板ポリ・球の変換とカメラの行列(変わったものだけをフレームに1回求める)
+	OcclusionCuller						occlusion_culler_;	//板ポリを遮蔽物として描いたCPUの深度バッファ(カメラの視錐台でのみ使う)
+	PipelineStateManager::Handle		shadow_map_pso_;	//シャドウマップ用のパイプライン
+	PipelineStateManager::Handle		shadow_map_instanced_pso_;	//インスタンス描画のシャドウマップ用のパイプライン(作成中は通常のものを使う)
+	ShadowFilterTier					shadow_filter_;		//シャドウマップのフィルタの段階
+	ComPtr<ID3D12DescriptorHeap>		dh_shadow_rtv_;		//EVSMのモーメント用のRTVのデスクリプタヒープ(横にぼかしたもの、ぼかしたもののカスケードごとのRTV)
+	D3D12_CPU_DESCRIPTOR_HANDLE			shadow_blur_rtv_handles_[SHADOW_CASCADE_NUM];
+	D3D12_CPU_DESCRIPTOR_HANDLE			shadow_moments_rtv_handles_[SHADOW_CASCADE_NUM];
+	UINT								shadow_blur_index_;		//横にぼかしたモーメントのSRVのbindless_heap_上の添字
+	UINT								shadow_moments_index_;	//ぼかしたモーメントのSRVのbindless_heap_上の添字
+	ComPtr<ID3D12Resource>				shadow_blur_buffer_;	//横にぼかしたモーメント(一時リソース。使うフレームグラフでのみ作成する)
+	ComPtr<ID3D12Resource>				shadow_moments_buffer_;	//ぼかしたモーメント(EVSMにしたときに作成する)
+	ComPtr<ID3DBlob>					vs_fullscreen_;			//全画面の三角形の頂点シェーダ
+	ComPtr<ID3DBlob>					ps_evsm_blur_x_;		//EVSMの横方向のぼかし
+	ComPtr<ID3DBlob>					ps_evsm_blur_y_;		//EVSMの縦方向のぼかし
+	PipelineStateManager::Handle		shadow_blur_x_pso_;
+	PipelineStateManager::Handle		shadow_blur_y_pso_;
+	RenderRect							scissor_rect_sm_;
+	RenderViewport						viewport_sm_;
+
+
+	XMFLOAT3							light_pos_;			//ライトの位置
+	XMFLOAT3							light_dst_;			//ライトの注視点
+	XMFLOAT3							light_dir_;			//ディレクショナルライトの向き
+	XMFLOAT4							iight_color_;		//ディレクショナルライトの色
+	
+	
+	RenderRect							scissor_rect_;
+	RenderViewport						viewport_;
+
+	FrameScheduler						frame_scheduler_;	//バックバッファごとのフェンス値
+	UploadRingBuffer					upload_buffer_;		//フレームごとの定数用のリングバッファ
+	D3D12ResidencyTarget				residency_target_;
+	ResidencyManager					residency_;			//memory_allocator_のブロックの常駐の管理
+	GpuMemoryAllocator					memory_allocator_;	//バッファ・テクスチャを置くヒープ(それらを持つplane_などより後に破棄する)
+	CopyUploader						uploader_;			//頂点・テクスチャの転送用のコピーキュー
+	BindlessHeap						bindless_heap_;		//全てのテクスチャのSRV(シェーダから見えるヒープはこれだけ)
+
+	Plane plane_;
+	Sphere sphere_;
+	ShadowMapDebug sm_debug_;
+
+	StageTimer startup_timer_;	//起動処理の各ステージの所要時間
+	ShaderCache shader_cache_;	//コンパイル済みシェーダ(ワーカースレッドから参照する)
+	JobSystem jobs_;			//アセット読み込みなどを行うワーカースレッド
+	PipelineStateManager pipeline_states_;	//PSOの作成とキャッシュ(jobs_で非同期に作成する)
+
+	//テクスチャのストリーミング(plane_・sphere_のアセットを読むので、それらより先に破棄する)
+	JobSystem io_jobs_;
+	D3D12StreamTarget stream_target_;
+	TextureStreamer streamer_;
+
+};
+
+#endif
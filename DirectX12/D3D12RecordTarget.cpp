@@ -0,0 +1,50 @@
+#include "D3D12RecordTarget.h"
+
+D3D12RecordTarget::D3D12RecordTarget():
+	frame_num_{},
+	command_allocator_{},
+	command_list_{},
+	render_command_list_{}{}
+
+HRESULT D3D12RecordTarget::Initialize(ID3D12Device *device, int frame_num){
+	HRESULT hr{};
+
+	if(frame_num < 1 || frame_num > MAX_FRAME_NUM){
+		return E_INVALIDARG;
+	}
+	frame_num_ = frame_num;
+
+	//コマンドアロケータの作成(GPUが前のフレームを実行中でも記録できるようにフレームごとに持つ)
+	for(int i = 0; i < frame_num_; ++i){
+		hr = device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(&command_allocator_[i]));
+		if(FAILED(hr)){
+			return hr;
+		}
+	}
+
+	//コマンドアロケータとバインドしてコマンドリストを作成する
+	hr = device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, command_allocator_[0].Get(), nullptr, IID_PPV_ARGS(&command_list_));
+	if(FAILED(hr)){
+		return hr;
+	}
+	render_command_list_.SetCommandList(command_list_.Get());
+
+	//記録はBeginでリセットしてから行うので、いったん閉じておく
+	return command_list_->Close();
+}
+
+bool D3D12RecordTarget::Begin(int frame_index){
+	if(frame_index < 0 || frame_index >= frame_num_){
+		return false;
+	}
+
+	if(FAILED(command_allocator_[frame_index]->Reset())){
+		return false;
+	}
+
+	return SUCCEEDED(command_list_->Reset(command_allocator_[frame_index].Get(), nullptr));
+}
+
+bool D3D12RecordTarget::End(){
+	return SUCCEEDED(command_list_->Close());
+}
@@ -0,0 +1,35 @@
+#ifndef D3D12_RECORD_TARGET_HEADER_
+#define D3D12_RECORD_TARGET_HEADER_
+
+#include <d3d12.h>
+#include <wrl/client.h>
+#include "RecordScheduler.h"
+#include "D3D12CommandList.h"
+
+using namespace Microsoft::WRL;
+
+//フレームごとのコマンドアロケータとコマンドリストの組
+//1つのパスを1つのスレッドで記録するので、スレッド間でアロケータを共有しない
+class D3D12RecordTarget : public RecordTarget{
+public:
+	static constexpr int MAX_FRAME_NUM = 4;
+
+public:
+	D3D12RecordTarget();
+	~D3D12RecordTarget(){}
+	HRESULT Initialize(ID3D12Device *device, int frame_num);
+
+	bool Begin(int frame_index) override;
+	bool End() override;
+
+	ID3D12GraphicsCommandList* GetCommandList() const{return command_list_.Get();}
+	RenderCommandList* GetRenderCommandList(){return &render_command_list_;}
+
+private:
+	int									frame_num_;
+	ComPtr<ID3D12CommandAllocator>		command_allocator_[MAX_FRAME_NUM];
+	ComPtr<ID3D12GraphicsCommandList>	command_list_;
+	D3D12CommandList					render_command_list_;	//command_list_への転送用
+};
+
+#endif
@@ -0,0 +1,45 @@
+#include "D3D12ResidencyTarget.h"
+
+D3D12ResidencyTarget::D3D12ResidencyTarget():
+	device_(nullptr),
+	adapter_(nullptr),
+	pageables_{}{}
+
+void D3D12ResidencyTarget::Initialize(ID3D12Device *device, IDXGIAdapter3 *adapter){
+	device_		= device;
+	adapter_	= adapter;
+}
+
+bool D3D12ResidencyTarget::QueryBudget(MemorySegment segment, MemoryBudget *budget){
+	const DXGI_MEMORY_SEGMENT_GROUP group = (segment == MEMORY_SEGMENT_LOCAL) ? DXGI_MEMORY_SEGMENT_GROUP_LOCAL : DXGI_MEMORY_SEGMENT_GROUP_NON_LOCAL;
+
+	DXGI_QUERY_VIDEO_MEMORY_INFO info{};
+	if(adapter_ == nullptr || FAILED(adapter_->QueryVideoMemoryInfo(0, group, &info))){
+		return false;
+	}
+
+	//UMAのGPUではNON_LOCALの予算が0になる(LOCALだけで管理する)
+	if(info.Budget == 0){
+		return false;
+	}
+	budget->budget	= info.Budget;
+	budget->usage	= info.CurrentUsage;
+	return true;
+}
+
+bool D3D12ResidencyTarget::MakeResident(const RenderResource *objects, int num){
+	ToPageables(objects, num);
+	return SUCCEEDED(device_->MakeResident(static_cast<UINT>(num), pageables_.data()));
+}
+
+bool D3D12ResidencyTarget::Evict(const RenderResource *objects, int num){
+	ToPageables(objects, num);
+	return SUCCEEDED(device_->Evict(static_cast<UINT>(num), pageables_.data()));
+}
+
+void D3D12ResidencyTarget::ToPageables(const RenderResource *objects, int num){
+	pageables_.resize(num);
+	for(int i = 0; i < num; ++i){
+		pageables_[i] = reinterpret_cast<ID3D12Pageable*>(objects[i].value);
+	}
+}
@@ -0,0 +1,32 @@
+#ifndef D3D12_RESIDENCY_TARGET_HEADER_
+#define D3D12_RESIDENCY_TARGET_HEADER_
+
+#include <vector>
+#include <d3d12.h>
+#include <dxgi1_4.h>
+#include "ResidencyManager.h"
+
+//RenderResourceにはID3D12Pageable(ヒープ・コミットしたリソース)を入れる
+inline RenderResource ToResidencyObject(ID3D12Pageable *pageable){return {reinterpret_cast<uint64_t>(pageable)};}
+
+//予算はアダプタのQueryVideoMemoryInfo、常駐の切り替えはデバイスのMakeResident/Evictで行う
+class D3D12ResidencyTarget : public ResidencyTarget{
+public:
+	D3D12ResidencyTarget();
+	~D3D12ResidencyTarget(){}
+	void Initialize(ID3D12Device *device, IDXGIAdapter3 *adapter);
+
+	bool QueryBudget(MemorySegment segment, MemoryBudget *budget) override;
+	bool MakeResident(const RenderResource *objects, int num) override;
+	bool Evict(const RenderResource *objects, int num) override;
+
+private:
+	void ToPageables(const RenderResource *objects, int num);
+
+private:
+	ID3D12Device					*device_;
+	IDXGIAdapter3					*adapter_;
+	std::vector<ID3D12Pageable*>	pageables_;
+};
+
+#endif
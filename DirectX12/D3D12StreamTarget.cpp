@@ -0,0 +1,37 @@
+#include "D3D12StreamTarget.h"
+
+D3D12StreamTarget::D3D12StreamTarget():
+	uploader_(nullptr),
+	direct_queue_(nullptr),
+	direct_fence_(nullptr),
+	last_frame_fence_{}{}
+
+void D3D12StreamTarget::Initialize(CopyUploader *uploader, ID3D12CommandQueue *direct_queue, ID3D12Fence *direct_fence){
+	uploader_		= uploader;
+	direct_queue_	= direct_queue;
+	direct_fence_	= direct_fence;
+}
+
+bool D3D12StreamTarget::UploadRows(RenderResource resource, TextureFormat format, int level, const TextureLevel &pixels, int first_row, int row_num){
+	ID3D12Resource *texture = reinterpret_cast<ID3D12Resource*>(resource.value);
+	return SUCCEEDED(uploader_->UploadTextureRows(texture, format, level, pixels, first_row, row_num));
+}
+
+uint64_t D3D12StreamTarget::Submit(){
+
+	//テクスチャは全てのサブリソースを描画で参照するので、直前のフレームの完了を待ってから書き込む
+	if(direct_fence_ != nullptr && last_frame_fence_ > 0){
+		uploader_->WaitForQueue(direct_fence_, last_frame_fence_);
+	}
+	const UINT64 fence_value = uploader_->Flush();
+
+	//次に実行するフレームは転送の完了を待つ(GPU側で待つのでCPUは止まらない)
+	if(direct_queue_ != nullptr){
+		uploader_->WaitOnQueue(direct_queue_);
+	}
+	return fence_value;
+}
+
+uint64_t D3D12StreamTarget::CompletedValue(){
+	return uploader_->GetFence()->GetCompletedValue();
+}
@@ -0,0 +1,31 @@
+#ifndef D3D12_STREAM_TARGET_HEADER_
+#define D3D12_STREAM_TARGET_HEADER_
+
+#include <d3d12.h>
+#include "TextureStreamer.h"
+#include "CopyUploader.h"
+
+//ストリーミングの転送をコピーキューで行う
+//同じテクスチャを描画中のフレームと転送が重ならないように、コピーキューは直前のフレームを待ち、
+//描画用のキューは転送の完了を待ってから次のフレームを実行する
+class D3D12StreamTarget : public TextureStreamTarget{
+public:
+	D3D12StreamTarget();
+	~D3D12StreamTarget(){}
+	void Initialize(CopyUploader *uploader, ID3D12CommandQueue *direct_queue, ID3D12Fence *direct_fence);
+
+	//描画用のキューに最後にシグナルしたフェンス値(TextureStreamer::Updateの前に設定する)
+	void SetLastFrameFence(UINT64 fence_value){last_frame_fence_ = fence_value;}
+
+	bool UploadRows(RenderResource resource, TextureFormat format, int level, const TextureLevel &pixels, int first_row, int row_num) override;
+	uint64_t Submit() override;
+	uint64_t CompletedValue() override;
+
+private:
+	CopyUploader		*uploader_;
+	ID3D12CommandQueue	*direct_queue_;
+	ID3D12Fence			*direct_fence_;
+	UINT64				last_frame_fence_;
+};
+
+#endif
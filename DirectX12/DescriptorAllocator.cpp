@@ -0,0 +1,113 @@
+#include "DescriptorAllocator.h"
+
+DescriptorAllocator::DescriptorAllocator():
+	DescriptorAllocator(0){}
+
+DescriptorAllocator::DescriptorAllocator(uint32_t capacity):
+	capacity_{},
+	allocated_num_{},
+	failed_num_{},
+	free_by_first_{},
+	free_by_count_{},
+	pending_{}{
+	Reset(capacity);
+}
+
+void DescriptorAllocator::Reset(uint32_t capacity){
+	capacity_		= capacity;
+	allocated_num_	= 0;
+	failed_num_		= 0;
+	free_by_first_.clear();
+	free_by_count_.clear();
+	pending_.clear();
+	if(capacity > 0){
+		InsertFreeRange(0, capacity);
+	}
+}
+
+uint32_t DescriptorAllocator::Allocate(uint32_t count){
+	if(count == 0){
+		return INVALID_INDEX;
+	}
+
+	//count以上で最も小さい空き範囲(同じ大きさなら先に空いたもの)
+	auto fit = free_by_count_.lower_bound(count);
+	if(fit == free_by_count_.end()){
+		++failed_num_;
+		return INVALID_INDEX;
+	}
+
+	const uint32_t first = fit->second;
+	const uint32_t range = fit->first;
+	EraseFreeRange(free_by_first_.find(first));
+
+	//余りは空き範囲に戻す
+	if(range > count){
+		InsertFreeRange(first + count, range - count);
+	}
+	allocated_num_ += count;
+	return first;
+}
+
+void DescriptorAllocator::Free(uint32_t first, uint32_t count, uint64_t fence_value){
+	if(count == 0 || first == INVALID_INDEX){
+		return;
+	}
+	if(fence_value > 0){
+		pending_.push_back({first, count, fence_value});
+		return;
+	}
+
+	allocated_num_ -= count;
+
+	//前後の空き範囲と結合する
+	auto next = free_by_first_.lower_bound(first);
+	if(next != free_by_first_.end() && next->first == first + count){
+		count += next->second;
+		EraseFreeRange(next);
+	}
+	auto prev = free_by_first_.lower_bound(first);
+	if(prev != free_by_first_.begin()){
+		--prev;
+		if(prev->first + prev->second == first){
+			first = prev->first;
+			count += prev->second;
+			EraseFreeRange(prev);
+		}
+	}
+	InsertFreeRange(first, count);
+}
+
+void DescriptorAllocator::ReleaseCompleted(uint64_t completed_fence_value){
+	while(!pending_.empty() && pending_.front().fence_value <= completed_fence_value){
+		const Pending pending = pending_.front();
+		pending_.pop_front();
+		Free(pending.first, pending.count, 0);
+	}
+}
+
+DescriptorAllocator::Stats DescriptorAllocator::GetStats() const{
+	Stats stats{};
+	stats.allocated_num			= allocated_num_;
+	stats.free_range_num		= static_cast<uint32_t>(free_by_first_.size());
+	stats.largest_free_range	= free_by_count_.empty() ? 0 : free_by_count_.rbegin()->first;
+	stats.pending_num			= static_cast<uint32_t>(pending_.size());
+	stats.failed_num			= failed_num_;
+	return stats;
+}
+
+void DescriptorAllocator::InsertFreeRange(uint32_t first, uint32_t count){
+	free_by_first_.emplace(first, count);
+	free_by_count_.emplace(count, first);
+}
+
+void DescriptorAllocator::EraseFreeRange(std::map<uint32_t, uint32_t>::iterator it){
+	auto range = free_by_count_.equal_range(it->second);
+	for(auto c = range.first; c != range.second; ++c){
+		if(c->second == it->first){
+			free_by_count_.erase(c);
+			break;
+		}
+	}
+	free_by_first_.erase(it);
+}
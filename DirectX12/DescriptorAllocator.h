@@ -0,0 +1,61 @@
+#ifndef DESCRIPTOR_ALLOCATOR_HEADER_
+#define DESCRIPTOR_ALLOCATOR_HEADER_
+
+#include <cstdint>
+#include <deque>
+#include <map>
+
+//デスクリプタヒープ上の連続した範囲の割り当て(添字の管理のみで、ヒープ自体は持たない)
+//空き範囲を先頭の添字順と大きさ順の2つで持ち、要求に合う最も小さい空き範囲から切り出す(best-fit)
+//解放した範囲は隣の空き範囲と結合する。GPUが参照中の範囲はフェンスを通過するまで再利用しない
+class DescriptorAllocator{
+public:
+	static constexpr uint32_t INVALID_INDEX = ~0u;
+
+	struct Stats{
+		uint32_t	allocated_num;		//割り当て中のデスクリプタの数(解放待ちを含む)
+		uint32_t	free_range_num;		//空き範囲の数(断片化の目安)
+		uint32_t	largest_free_range;	//一度に割り当てられる最大の数
+		uint32_t	pending_num;		//フェンスの通過を待っている解放の数
+		uint64_t	failed_num;			//空きがなく割り当てに失敗した回数
+	};
+
+public:
+	DescriptorAllocator();
+	explicit DescriptorAllocator(uint32_t capacity);
+	~DescriptorAllocator(){}
+
+	void Reset(uint32_t capacity);
+
+	//count個の連続した範囲の先頭の添字を返す(空きがなければINVALID_INDEX)
+	uint32_t Allocate(uint32_t count);
+
+	//fence_valueのフレームまでGPUが参照する範囲を解放する(0ならすぐに再利用してよい)
+	void Free(uint32_t first, uint32_t count, uint64_t fence_value = 0);
+
+	//completed_fence_value以下のフレームで解放した範囲を再利用できるようにする
+	void ReleaseCompleted(uint64_t completed_fence_value);
+
+	uint32_t Capacity() const{return capacity_;}
+	Stats GetStats() const;
+
+private:
+	struct Pending{
+		uint32_t	first;
+		uint32_t	count;
+		uint64_t	fence_value;
+	};
+
+	void InsertFreeRange(uint32_t first, uint32_t count);
+	void EraseFreeRange(std::map<uint32_t, uint32_t>::iterator it);
+
+private:
+	uint32_t								capacity_;
+	uint32_t								allocated_num_;
+	uint64_t								failed_num_;
+	std::map<uint32_t, uint32_t>			free_by_first_;	//先頭の添字 -> 数
+	std::multimap<uint32_t, uint32_t>		free_by_count_;	//数 -> 先頭の添字
+	std::deque<Pending>						pending_;		//解放待ち(フェンス値の順)
+};
+
+#endif
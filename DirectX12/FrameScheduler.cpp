@@ -0,0 +1,31 @@
+#include "FrameScheduler.h"
+
+FrameScheduler::FrameScheduler():
+	FrameScheduler(1){}
+
+FrameScheduler::FrameScheduler(int frame_num):
+	frame_num_{},
+	last_value_{},
+	fence_values_{}{
+	Reset(frame_num);
+}
+
+void FrameScheduler::Reset(int frame_num){
+	if(frame_num < 1){
+		frame_num = 1;
+	}else if(frame_num > MAX_FRAME_NUM){
+		frame_num = MAX_FRAME_NUM;
+	}
+
+	frame_num_	= frame_num;
+	last_value_	= 0;
+	for(uint64_t &v : fence_values_){
+		v = 0;
+	}
+}
+
+uint64_t FrameScheduler::Submit(int frame_index){
+	++last_value_;
+	fence_values_[frame_index] = last_value_;
+	return last_value_;
+}
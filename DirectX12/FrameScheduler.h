@@ -0,0 +1,37 @@
+#ifndef FRAME_SCHEDULER_HEADER_
+#define FRAME_SCHEDULER_HEADER_
+
+#include <cstdint>
+
+//フレームごとのフェンス値の管理(キューへの依存はないのでD3D12なしでも動く)
+//フレームのリソース(コマンドアロケータなど)を再利用する前に待つべきフェンス値を返す
+class FrameScheduler{
+public:
+	static constexpr int MAX_FRAME_NUM = 4;
+
+public:
+	FrameScheduler();
+	explicit FrameScheduler(int frame_num);
+	~FrameScheduler(){}
+
+	void Reset(int frame_num);
+
+	//frame_indexのリソースを再利用する前に完了している必要があるフェンス値(0なら待つ必要はない)
+	uint64_t WaitValue(int frame_index) const{return fence_values_[frame_index];}
+
+	//completed_fence_valueの時点でframe_indexのリソースを再利用できるか
+	bool IsAvailable(int frame_index, uint64_t completed_fence_value) const{return fence_values_[frame_index] <= completed_fence_value;}
+
+	//frame_indexのフレームを提出する。キューにシグナルするフェンス値を返す
+	uint64_t Submit(int frame_index);
+
+	int FrameNum() const{return frame_num_;}
+	uint64_t LastSubmitted() const{return last_value_;}
+
+private:
+	int			frame_num_;
+	uint64_t	last_value_;					//最後にシグナルしたフェンス値
+	uint64_t	fence_values_[MAX_FRAME_NUM];	//各フレームが最後に提出されたときのフェンス値
+};
+
+#endif
@@ -0,0 +1,272 @@
+#include <algorithm>
+#include <cmath>
+#include "FrustumCuller.h"
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#define FRUSTUM_CULLER_AVX
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define FRUSTUM_CULLER_SSE2
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define FRUSTUM_CULLER_NEON
+#endif
+
+namespace{
+//LANE_NUM個のオブジェクト分の値を持つベクトル。比較の結果はマスクとして持ち、MoveMaskでレーンごとのビットにする
+#if defined(FRUSTUM_CULLER_AVX)
+constexpr int LANE_NUM = 8;
+struct FloatN{
+	__m256 v;
+};
+inline FloatN Load(const float *src){return {_mm256_loadu_ps(src)};}
+inline FloatN Splat(float a){return {_mm256_set1_ps(a)};}
+inline FloatN operator+(FloatN a, FloatN b){return {_mm256_add_ps(a.v, b.v)};}
+inline FloatN operator*(FloatN a, FloatN b){return {_mm256_mul_ps(a.v, b.v)};}
+inline FloatN Min(FloatN a, FloatN b){return {_mm256_min_ps(a.v, b.v)};}
+inline FloatN GreaterEqual(FloatN a, FloatN b){return {_mm256_cmp_ps(a.v, b.v, _CMP_GE_OQ)};}
+inline FloatN And(FloatN a, FloatN b){return {_mm256_and_ps(a.v, b.v)};}
+inline int MoveMask(FloatN mask){return _mm256_movemask_ps(mask.v);}
+#elif defined(FRUSTUM_CULLER_SSE2)
+constexpr int LANE_NUM = 4;
+struct FloatN{
+	__m128 v;
+};
+inline FloatN Load(const float *src){return {_mm_loadu_ps(src)};}
+inline FloatN Splat(float a){return {_mm_set1_ps(a)};}
+inline FloatN operator+(FloatN a, FloatN b){return {_mm_add_ps(a.v, b.v)};}
+inline FloatN operator*(FloatN a, FloatN b){return {_mm_mul_ps(a.v, b.v)};}
+inline FloatN Min(FloatN a, FloatN b){return {_mm_min_ps(a.v, b.v)};}
+inline FloatN GreaterEqual(FloatN a, FloatN b){return {_mm_cmpge_ps(a.v, b.v)};}
+inline FloatN And(FloatN a, FloatN b){return {_mm_and_ps(a.v, b.v)};}
+inline int MoveMask(FloatN mask){return _mm_movemask_ps(mask.v);}
+#elif defined(FRUSTUM_CULLER_NEON)
+constexpr int LANE_NUM = 4;
+struct FloatN{
+	float32x4_t v;
+};
+inline FloatN Load(const float *src){return {vld1q_f32(src)};}
+inline FloatN Splat(float a){return {vdupq_n_f32(a)};}
+inline FloatN operator+(FloatN a, FloatN b){return {vaddq_f32(a.v, b.v)};}
+inline FloatN operator*(FloatN a, FloatN b){return {vmulq_f32(a.v, b.v)};}
+inline FloatN Min(FloatN a, FloatN b){return {vminq_f32(a.v, b.v)};}
+inline FloatN GreaterEqual(FloatN a, FloatN b){return {vreinterpretq_f32_u32(vcgeq_f32(a.v, b.v))};}
+inline FloatN And(FloatN a, FloatN b){return {vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(a.v), vreinterpretq_u32_f32(b.v)))};}
+inline int MoveMask(FloatN mask){
+	static const uint32_t bits[4] = {1, 2, 4, 8};
+	return static_cast<int>(vaddvq_u32(vandq_u32(vreinterpretq_u32_f32(mask.v), vld1q_u32(bits))));
+}
+#else
+constexpr int LANE_NUM = 4;
+//マスクは1.0/0.0で表す
+struct FloatN{
+	float v[4];
+};
+inline FloatN Load(const float *src){return {{src[0], src[1], src[2], src[3]}};}
+inline FloatN Splat(float a){return {{a, a, a, a}};}
+inline FloatN operator+(FloatN a, FloatN b){return {{a.v[0] + b.v[0], a.v[1] + b.v[1], a.v[2] + b.v[2], a.v[3] + b.v[3]}};}
+inline FloatN operator*(FloatN a, FloatN b){return {{a.v[0] * b.v[0], a.v[1] * b.v[1], a.v[2] * b.v[2], a.v[3] * b.v[3]}};}
+inline FloatN Min(FloatN a, FloatN b){return {{std::min(a.v[0], b.v[0]), std::min(a.v[1], b.v[1]), std::min(a.v[2], b.v[2]), std::min(a.v[3], b.v[3])}};}
+inline FloatN GreaterEqual(FloatN a, FloatN b){
+	return {{a.v[0] >= b.v[0] ? 1.0f : 0.0f, a.v[1] >= b.v[1] ? 1.0f : 0.0f, a.v[2] >= b.v[2] ? 1.0f : 0.0f, a.v[3] >= b.v[3] ? 1.0f : 0.0f}};
+}
+inline FloatN And(FloatN a, FloatN b){return a * b;}
+inline int MoveMask(FloatN mask){
+	return (mask.v[0] != 0.0f ? 1 : 0) | (mask.v[1] != 0.0f ? 2 : 0) | (mask.v[2] != 0.0f ? 4 : 0) | (mask.v[3] != 0.0f ? 8 : 0);
+}
+#endif
+static_assert(FrustumCuller::SIMD_WIDTH % LANE_NUM == 0, "padding must be a multiple of the lane count");
+
+//平面の係数を全てのレーンに広げたもの(法線の絶対値は箱を射影した幅に使う)
+struct PlaneN{
+	FloatN	n[3];
+	FloatN	abs_n[3];
+	FloatN	d;
+};
+}
+
+
+FrustumCuller::Frustum FrustumCuller::Frustum::FromMatrix(const float m[4][4]){
+	//クリップ座標の列(x, y, z, w)を行ベクトルに掛けたときの係数
+	float columns[4][4];
+	for(int j = 0; j < 4; ++j){
+		for(int i = 0; i < 4; ++i){
+			columns[j][i] = m[i][j];
+		}
+	}
+
+	//-w <= x <= w, -w <= y <= w, 0 <= z <= w
+	Frustum f{};
+	for(int i = 0; i < 4; ++i){
+		f.planes[0][i] = columns[3][i] + columns[0][i];
+		f.planes[1][i] = columns[3][i] - columns[0][i];
+		f.planes[2][i] = columns[3][i] + columns[1][i];
+		f.planes[3][i] = columns[3][i] - columns[1][i];
+		f.planes[4][i] = columns[2][i];
+		f.planes[5][i] = columns[3][i] - columns[2][i];
+	}
+
+	for(int p = 0; p < PLANE_NUM; ++p){
+		const float len = std::sqrt(f.planes[p][0] * f.planes[p][0] + f.planes[p][1] * f.planes[p][1] + f.planes[p][2] * f.planes[p][2]);
+		if(len > 0.0f){
+			for(int i = 0; i < 4; ++i){
+				f.planes[p][i] /= len;
+			}
+		}
+	}
+	return f;
+}
+
+
+FrustumCuller::FrustumCuller():
+	num_{},
+	view_num_{},
+	x_{},
+	y_{},
+	z_{},
+	radius_{},
+	extent_x_{},
+	extent_y_{},
+	extent_z_{},
+	visible_{},
+	visible_num_{}{}
+
+void FrustumCuller::Resize(int num){
+	num_ = num > 0 ? num : 0;
+
+	//SIMDで端数を気にせず読めるように切り上げる(余りの要素は結果に含めない)
+	const size_t padded = static_cast<size_t>((num_ + SIMD_WIDTH - 1) / SIMD_WIDTH * SIMD_WIDTH);
+	x_.assign(padded, 0.0f);
+	y_.assign(padded, 0.0f);
+	z_.assign(padded, 0.0f);
+	radius_.assign(padded, 0.0f);
+	extent_x_.assign(padded, 0.0f);
+	extent_y_.assign(padded, 0.0f);
+	extent_z_.assign(padded, 0.0f);
+	for(int v = 0; v < MAX_VIEW_NUM; ++v){
+		visible_[v].clear();
+		visible_num_[v] = 0;
+	}
+	view_num_ = 0;
+}
+
+void FrustumCuller::Clear(){
+	Resize(0);
+}
+
+void FrustumCuller::SetSphere(int index, const float center[3], float radius){
+	x_[index]			= center[0];
+	y_[index]			= center[1];
+	z_[index]			= center[2];
+	radius_[index]		= radius;
+	extent_x_[index]	= radius;
+	extent_y_[index]	= radius;
+	extent_z_[index]	= radius;
+}
+
+void FrustumCuller::SetBox(int index, const float center[3], const float extents[3]){
+	x_[index]			= center[0];
+	y_[index]			= center[1];
+	z_[index]			= center[2];
+	radius_[index]		= std::sqrt(extents[0] * extents[0] + extents[1] * extents[1] + extents[2] * extents[2]);
+	extent_x_[index]	= extents[0];
+	extent_y_[index]	= extents[1];
+	extent_z_[index]	= extents[2];
+}
+
+//結果の列は書き込みの余白を含めて確保しておく(レーンごとに分岐せずに書き込む)
+void FrustumCuller::PrepareViews(int view_num){
+	view_num_ = std::min(std::max(view_num, 0), static_cast<int>(MAX_VIEW_NUM));
+	for(int v = 0; v < view_num_; ++v){
+		visible_[v].resize(static_cast<size_t>(num_) + SIMD_WIDTH);
+		visible_num_[v] = 0;
+	}
+}
+
+//平面ごとに 中心までの距離 + 近い方の境界の幅 >= 0 なら内側に掛かる。6平面全てで掛かれば見える
+void FrustumCuller::Cull(const Frustum *frustums, int view_num){
+	PrepareViews(view_num);
+
+	PlaneN planes[MAX_VIEW_NUM][PLANE_NUM];
+	for(int v = 0; v < view_num_; ++v){
+		for(int p = 0; p < PLANE_NUM; ++p){
+			const float *plane = frustums[v].planes[p];
+			for(int k = 0; k < 3; ++k){
+				planes[v][p].n[k]		= Splat(plane[k]);
+				planes[v][p].abs_n[k]	= Splat(std::fabs(plane[k]));
+			}
+			planes[v][p].d = Splat(plane[3]);
+		}
+	}
+
+	const FloatN zero = Splat(0.0f);
+	for(int i = 0; i < num_; i += LANE_NUM){
+		const FloatN x			= Load(&x_[i]);
+		const FloatN y			= Load(&y_[i]);
+		const FloatN z			= Load(&z_[i]);
+		const FloatN radius		= Load(&radius_[i]);
+		const FloatN extent_x	= Load(&extent_x_[i]);
+		const FloatN extent_y	= Load(&extent_y_[i]);
+		const FloatN extent_z	= Load(&extent_z_[i]);
+
+		//端数のグループは余りのレーンを除く
+		const int valid = (num_ - i >= LANE_NUM) ? (1 << LANE_NUM) - 1 : (1 << (num_ - i)) - 1;
+
+		for(int v = 0; v < view_num_; ++v){
+			const PlaneN *view_planes = planes[v];
+			FloatN inside = GreaterEqual(zero, zero);
+			for(int p = 0; p < PLANE_NUM; ++p){
+				const PlaneN &plane = view_planes[p];
+				const FloatN dist	= x * plane.n[0] + y * plane.n[1] + z * plane.n[2] + plane.d;
+				const FloatN extent	= extent_x * plane.abs_n[0] + extent_y * plane.abs_n[1] + extent_z * plane.abs_n[2];
+				inside = And(inside, GreaterEqual(dist + Min(radius, extent), zero));
+			}
+
+			//見えるものだけが詰まるように、全てのレーンを書いて見えるものの数だけ進める
+			const int bits = MoveMask(inside) & valid;
+			uint32_t *out = visible_[v].data() + visible_num_[v];
+			int n = 0;
+			for(int k = 0; k < LANE_NUM; ++k){
+				out[n] = static_cast<uint32_t>(i + k);
+				n += (bits >> k) & 1;
+			}
+			visible_num_[v] += n;
+		}
+	}
+}
+
+void FrustumCuller::CullScalar(const Frustum *frustums, int view_num){
+	PrepareViews(view_num);
+
+	for(int i = 0; i < num_; ++i){
+		for(int v = 0; v < view_num_; ++v){
+			bool inside = true;
+			for(int p = 0; p < PLANE_NUM && inside; ++p){
+				const float *plane = frustums[v].planes[p];
+				const float dist	= x_[i] * plane[0] + y_[i] * plane[1] + z_[i] * plane[2] + plane[3];
+				const float extent	= extent_x_[i] * std::fabs(plane[0]) + extent_y_[i] * std::fabs(plane[1]) + extent_z_[i] * std::fabs(plane[2]);
+				inside = (dist + std::min(radius_[i], extent) >= 0.0f);
+			}
+			if(inside){
+				visible_[v][visible_num_[v]++] = static_cast<uint32_t>(i);
+			}
+		}
+	}
+}
+
+const char* FrustumCuller::InstructionSet(){
+#if defined(FRUSTUM_CULLER_AVX)
+	return "AVX";
+#elif defined(FRUSTUM_CULLER_SSE2)
+	return "SSE2";
+#elif defined(FRUSTUM_CULLER_NEON)
+	return "NEON";
+#else
+	return "scalar";
+#endif
+}
+
+int FrustumCuller::LaneNum(){
+	return LANE_NUM;
+}
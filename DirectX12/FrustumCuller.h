@@ -0,0 +1,73 @@
+#ifndef FRUSTUM_CULLER_HEADER_
+#define FRUSTUM_CULLER_HEADER_
+
+#include <cstdint>
+#include <vector>
+
+//視錐台カリング
+//オブジェクトの境界(球と軸に平行な箱)をSoAで持ち、SIMDで4個(AVXでは8個)ずつ視錐台の6平面と比べる
+//・平面ごとに、球の半径と箱を平面の法線に射影した幅の小さい方を使う(球は箱で、箱は球で包んで両方を持つ)
+//・複数の視錐台(カメラとシャドウマップのカスケードなど)を1回の走査で調べ、視錐台ごとに見えるオブジェクトの添字の列を作る
+//・判定は保守的で、外と判定したものは必ず視錐台の外にある(角の近くでは外にあっても見えると判定することがある)
+//
+//使い方: Resize → SetSphere/SetBox → Cull → VisibleNum/Visible
+class FrustumCuller{
+public:
+	static constexpr int PLANE_NUM		= 6;
+	static constexpr int MAX_VIEW_NUM	= 8;
+	static constexpr int SIMD_WIDTH		= 8;	//配列の長さはこの倍数に切り上げる(SSE・NEONでは4個ずつ調べる)
+
+	//視錐台の平面(内側で nx * x + ny * y + nz * z + d >= 0。法線は正規化する)
+	struct Frustum{
+		float planes[PLANE_NUM][4];
+
+		//ビュー・プロジェクション行列(行ベクトルに右から掛ける並び、zは[0, 1])から左・右・下・上・手前・奥の平面を求める
+		static Frustum FromMatrix(const float m[4][4]);
+	};
+
+public:
+	FrustumCuller();
+	~FrustumCuller(){}
+
+	//num個のオブジェクトを用意する(境界は原点の点)
+	void Resize(int num);
+	void Clear();
+
+	void SetSphere(int index, const float center[3], float radius);
+
+	//extentsは中心から各軸の面までの距離
+	void SetBox(int index, const float center[3], const float extents[3]);
+
+	int Num() const{return num_;}
+
+	//view_num個の視錐台で調べ、視錐台ごとに見えるものの添字を昇順に並べる
+	void Cull(const Frustum *frustums, int view_num);
+
+	//比較用に1オブジェクトずつ調べる(結果はCullと同じ)
+	void CullScalar(const Frustum *frustums, int view_num);
+
+	int VisibleNum(int view) const{return visible_num_[view];}
+	const uint32_t* Visible(int view) const{return visible_[view].data();}
+
+	//Cullで使う命令セット(AVX, SSE2, NEON, scalar)と1回に調べる数
+	static const char* InstructionSet();
+	static int LaneNum();
+
+private:
+	void PrepareViews(int view_num);
+
+private:
+	int						num_;
+	int						view_num_;
+	std::vector<float>		x_;			//以下はSIMD_WIDTHの倍数に切り上げた長さを持つ
+	std::vector<float>		y_;
+	std::vector<float>		z_;
+	std::vector<float>		radius_;
+	std::vector<float>		extent_x_;
+	std::vector<float>		extent_y_;
+	std::vector<float>		extent_z_;
+	std::vector<uint32_t>	visible_[MAX_VIEW_NUM];	//見えるものの添字(書き込みの余白にSIMD_WIDTH個多く持つ)
+	int						visible_num_[MAX_VIEW_NUM];
+};
+
+#endif
@@ -0,0 +1,290 @@
+#include <algorithm>
+#include "GpuMemoryAllocator.h"
+#include "D3D12ResidencyTarget.h"
+
+namespace{
+UINT64 AlignUp(UINT64 value, UINT64 alignment){
+	return (value + alignment - 1) & ~(alignment - 1);
+}
+}
+
+GpuMemoryAllocator::GpuMemoryAllocator():
+	mutex_{},
+	device_{},
+	residency_(nullptr),
+	block_size_{},
+	blocks_{},
+	resource_num_{},
+	range_num_{}{}
+
+HRESULT GpuMemoryAllocator::Initialize(ID3D12Device *device, UINT64 block_size, ResidencyManager *residency){
+	device_		= device;
+	residency_	= residency;
+	block_size_	= AlignUp(block_size, D3D12_DEFAULT_MSAA_RESOURCE_PLACEMENT_ALIGNMENT);
+	return S_OK;
+}
+
+
+HRESULT GpuMemoryAllocator::AllocateBuffer(D3D12_HEAP_TYPE heap_type, UINT64 size, UINT64 alignment, BufferRange *range){
+	HRESULT hr;
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	const Pool pool = (heap_type == D3D12_HEAP_TYPE_UPLOAD) ? POOL_UPLOAD_BUFFER : POOL_BUFFER;
+	Allocation allocation{};
+	hr = Allocate(pool, size, alignment, &allocation);
+	if(FAILED(hr)){
+		return hr;
+	}
+
+	const Block &block = blocks_[pool][allocation.block];
+	range->resource		= block.buffer.Get();
+	range->offset		= allocation.offset;
+	range->size			= size;
+	range->gpu_address	= block.buffer->GetGPUVirtualAddress() + allocation.offset;
+	range->cpu_address	= (block.cpu_address != nullptr) ? block.cpu_address + allocation.offset : nullptr;
+	range->allocation	= allocation;
+
+	++range_num_;
+	return S_OK;
+}
+
+HRESULT GpuMemoryAllocator::CreateTexture(const D3D12_RESOURCE_DESC &desc, D3D12_RESOURCE_STATES state, const D3D12_CLEAR_VALUE *clear_value, ID3D12Resource **texture, Allocation *allocation){
+	HRESULT hr;
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	//小さいテクスチャは4KBのアライメントで置けるか試す(置けなければドライバの決めたアライメントにする)
+	D3D12_RESOURCE_DESC placed_desc = desc;
+	placed_desc.Alignment = (desc.SampleDesc.Count > 1) ? 0 : D3D12_SMALL_RESOURCE_PLACEMENT_ALIGNMENT;
+	D3D12_RESOURCE_ALLOCATION_INFO info = device_->GetResourceAllocationInfo(0, 1, &placed_desc);
+	if(placed_desc.Alignment != 0 && info.Alignment != placed_desc.Alignment){
+		placed_desc.Alignment = 0;
+		info = device_->GetResourceAllocationInfo(0, 1, &placed_desc);
+	}
+	if(info.SizeInBytes == UINT64_MAX){
+		return E_INVALIDARG;
+	}
+
+	Allocation a{};
+	hr = Allocate(POOL_TEXTURE, info.SizeInBytes, info.Alignment, &a);
+	if(FAILED(hr)){
+		return hr;
+	}
+
+	hr = device_->CreatePlacedResource(blocks_[POOL_TEXTURE][a.block].heap.Get(), a.offset, &placed_desc, state, clear_value, IID_PPV_ARGS(texture));
+	if(FAILED(hr)){
+		blocks_[POOL_TEXTURE][a.block].ranges.Free(a.offset);
+		ReleaseDedicatedBlock(POOL_TEXTURE, a.block);
+		return hr;
+	}
+
+	if(allocation != nullptr){
+		*allocation = a;
+	}
+	++resource_num_;
+	return S_OK;
+}
+
+
+void GpuMemoryAllocator::Free(const Allocation &allocation, UINT64 fence_value){
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	if(allocation.pool < 0){
+		return;
+	}
+	const Pool pool = static_cast<Pool>(allocation.pool);
+	blocks_[pool][allocation.block].ranges.Free(allocation.offset, fence_value);
+	if(pool == POOL_TEXTURE){
+		--resource_num_;
+	}else{
+		--range_num_;
+	}
+	ReleaseDedicatedBlock(pool, allocation.block);
+}
+
+void GpuMemoryAllocator::ReleaseCompleted(UINT64 completed_fence_value){
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	for(int pool = 0; pool < POOL_NUM; ++pool){
+		for(int i = 0; i < static_cast<int>(blocks_[pool].size()); ++i){
+			blocks_[pool][i].ranges.ReleaseCompleted(completed_fence_value);
+			ReleaseDedicatedBlock(static_cast<Pool>(pool), i);
+		}
+	}
+}
+
+
+void GpuMemoryAllocator::Use(const Allocation &allocation){
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	if(residency_ == nullptr || allocation.pool < 0 || allocation.block >= static_cast<int>(blocks_[allocation.pool].size())){
+		return;
+	}
+	residency_->Use(blocks_[allocation.pool][allocation.block].residency);
+}
+
+
+GpuMemoryAllocator::Stats GpuMemoryAllocator::GetStats() const{
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	Stats stats{};
+	stats.resource_num	= resource_num_;
+	stats.range_num		= range_num_;
+	for(int pool = 0; pool < POOL_NUM; ++pool){
+		for(const Block &block : blocks_[pool]){
+			if(block.heap == nullptr){
+				continue;
+			}
+			const TlsfAllocator::Stats range = block.ranges.GetStats();
+			++stats.block_num;
+			stats.reserved_size		+= range.size;
+			stats.used_size			+= range.used_size;
+			stats.max_fragmentation	= std::max(stats.max_fragmentation, range.Fragmentation());
+		}
+	}
+	return stats;
+}
+
+std::vector<GpuMemoryAllocator::BlockStats> GpuMemoryAllocator::GetBlockStats() const{
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	std::vector<BlockStats> stats;
+	for(int pool = 0; pool < POOL_NUM; ++pool){
+		for(const Block &block : blocks_[pool]){
+			if(block.heap != nullptr){
+				stats.push_back({static_cast<Pool>(pool), block.dedicated, block.ranges.GetStats()});
+			}
+		}
+	}
+	return stats;
+}
+
+
+//共有のブロックから順に探し、どこにも入らなければブロックを追加する
+HRESULT GpuMemoryAllocator::Allocate(Pool pool, UINT64 size, UINT64 alignment, Allocation *allocation){
+	HRESULT hr;
+
+	if(device_ == nullptr){
+		return E_FAIL;
+	}
+
+	std::vector<Block> &blocks = blocks_[pool];
+	int index = -1;
+	UINT64 offset = TlsfAllocator::INVALID_OFFSET;
+
+	if(size <= block_size_ / 2){
+		for(int i = 0; i < static_cast<int>(blocks.size()) && offset == TlsfAllocator::INVALID_OFFSET; ++i){
+			if(blocks[i].heap != nullptr && !blocks[i].dedicated){
+				index	= i;
+				offset	= blocks[i].ranges.Allocate(size, alignment);
+			}
+		}
+		if(offset == TlsfAllocator::INVALID_OFFSET){
+			hr = CreateBlock(pool, block_size_, false, &index);
+			if(FAILED(hr)){
+				return hr;
+			}
+			offset = blocks[index].ranges.Allocate(size, alignment);
+		}
+	}else{
+		hr = CreateBlock(pool, AlignUp(size, D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT), true, &index);
+		if(FAILED(hr)){
+			return hr;
+		}
+		offset = blocks[index].ranges.Allocate(size, alignment);
+	}
+
+	if(offset == TlsfAllocator::INVALID_OFFSET){
+		return E_OUTOFMEMORY;
+	}
+
+	allocation->pool	= pool;
+	allocation->block	= index;
+	allocation->offset	= offset;
+	return S_OK;
+}
+
+HRESULT GpuMemoryAllocator::CreateBlock(Pool pool, UINT64 size, bool dedicated, int *index){
+	HRESULT hr;
+
+	//テクスチャのブロックはMSAAのテクスチャも置けるように4MBで揃える
+	D3D12_HEAP_DESC heap_desc{};
+	heap_desc.SizeInBytes						= size;
+	heap_desc.Properties.Type					= (pool == POOL_UPLOAD_BUFFER) ? D3D12_HEAP_TYPE_UPLOAD : D3D12_HEAP_TYPE_DEFAULT;
+	heap_desc.Properties.CPUPageProperty		= D3D12_CPU_PAGE_PROPERTY_UNKNOWN;
+	heap_desc.Properties.MemoryPoolPreference	= D3D12_MEMORY_POOL_UNKNOWN;
+	heap_desc.Properties.CreationNodeMask		= 0;
+	heap_desc.Properties.VisibleNodeMask		= 0;
+	heap_desc.Alignment							= (pool == POOL_TEXTURE) ? D3D12_DEFAULT_MSAA_RESOURCE_PLACEMENT_ALIGNMENT : D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
+	heap_desc.Flags								= (pool == POOL_TEXTURE) ? D3D12_HEAP_FLAG_ALLOW_ONLY_NON_RT_DS_TEXTURES : D3D12_HEAP_FLAG_ALLOW_ONLY_BUFFERS;
+
+	Block block{};
+	block.dedicated = dedicated;
+	hr = device_->CreateHeap(&heap_desc, IID_PPV_ARGS(&block.heap));
+	if(FAILED(hr)){
+		return hr;
+	}
+
+	//バッファのブロックはヒープ全体を1つのバッファにして、その範囲を割り当てる
+	if(pool != POOL_TEXTURE){
+		D3D12_RESOURCE_DESC resource_desc{};
+		resource_desc.Dimension				= D3D12_RESOURCE_DIMENSION_BUFFER;
+		resource_desc.Width					= size;
+		resource_desc.Height				= 1;
+		resource_desc.DepthOrArraySize		= 1;
+		resource_desc.MipLevels				= 1;
+		resource_desc.Format				= DXGI_FORMAT_UNKNOWN;
+		resource_desc.Layout				= D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
+		resource_desc.SampleDesc.Count		= 1;
+		resource_desc.SampleDesc.Quality	= 0;
+
+		//UPLOADヒープはGENERIC_READのまま、DEFAULTヒープはCOMMONから暗黙に遷移させる
+		const D3D12_RESOURCE_STATES state = (pool == POOL_UPLOAD_BUFFER) ? D3D12_RESOURCE_STATE_GENERIC_READ : D3D12_RESOURCE_STATE_COMMON;
+		hr = device_->CreatePlacedResource(block.heap.Get(), 0, &resource_desc, state, nullptr, IID_PPV_ARGS(&block.buffer));
+		if(FAILED(hr)){
+			return hr;
+		}
+
+		if(pool == POOL_UPLOAD_BUFFER){
+			D3D12_RANGE read_range{0, 0};
+			hr = block.buffer->Map(0, &read_range, reinterpret_cast<void**>(&block.cpu_address));
+			if(FAILED(hr)){
+				return hr;
+			}
+		}
+	}
+
+	block.ranges.Reset(size);
+
+	//UPLOADヒープはシステムメモリに置かれる
+	block.residency = ResidencyManager::INVALID_HANDLE;
+	if(residency_ != nullptr){
+		block.residency = residency_->Register(ToResidencyObject(block.heap.Get()), size, (pool == POOL_UPLOAD_BUFFER) ? MEMORY_SEGMENT_NON_LOCAL : MEMORY_SEGMENT_LOCAL);
+	}
+
+	//破棄した専用のブロックの場所があれば使う(他のブロックの添字を変えない)
+	std::vector<Block> &blocks = blocks_[pool];
+	auto it = std::find_if(blocks.begin(), blocks.end(), [](const Block &b){return b.heap == nullptr;});
+	if(it != blocks.end()){
+		*it = std::move(block);
+		*index = static_cast<int>(it - blocks.begin());
+	}else{
+		blocks.push_back(std::move(block));
+		*index = static_cast<int>(blocks.size()) - 1;
+	}
+	return S_OK;
+}
+
+//専用のブロックは解放待ちもなくなったら破棄する
+void GpuMemoryAllocator::ReleaseDedicatedBlock(Pool pool, int index){
+	Block &block = blocks_[pool][index];
+	if(!block.dedicated || block.heap == nullptr || !block.ranges.IsEmpty()){
+		return;
+	}
+	if(block.cpu_address != nullptr){
+		block.buffer->Unmap(0, nullptr);
+	}
+	if(residency_ != nullptr){
+		residency_->Unregister(block.residency);
+	}
+	block = Block{};
+}
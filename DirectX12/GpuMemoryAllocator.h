@@ -0,0 +1,108 @@
+#ifndef GPU_MEMORY_ALLOCATOR_HEADER_
+#define GPU_MEMORY_ALLOCATOR_HEADER_
+
+#include <mutex>
+#include <vector>
+#include <d3d12.h>
+#include <wrl/client.h>
+#include "TlsfAllocator.h"
+#include "ResidencyManager.h"
+
+using namespace Microsoft::WRL;
+
+//GPUメモリの割り当て
+//大きなID3D12Heapをブロックとして確保し、その中の範囲をブロックごとのTlsfAllocatorで割り当てる
+//・バッファはブロック全体を覆う1つのバッファの範囲として返す(小さな定数バッファでも64KBを使わない)
+//・テクスチャはブロックのヒープに配置する(小さいものは4KB、それ以外は64KB・MSAAは4MBのアライメント)
+//・ブロックの半分を超えるものは専用のブロックを作り、解放したらブロックごと破棄する
+//・常駐はブロック単位で管理する(ブロック内のどれかを使うフレームではブロック全体を常駐させる)
+class GpuMemoryAllocator{
+public:
+	static constexpr UINT64 DEFAULT_BLOCK_SIZE = 64 * 1024 * 1024;
+
+	enum Pool{
+		POOL_BUFFER,			//DEFAULTヒープのバッファ
+		POOL_UPLOAD_BUFFER,		//UPLOADヒープのバッファ(Map済み)
+		POOL_TEXTURE,			//DEFAULTヒープのテクスチャ(レンダーターゲット・深度バッファを除く)
+		POOL_NUM,
+	};
+
+	struct Allocation{
+		int			pool;		//割り当てていなければ-1
+		int			block;
+		UINT64		offset;
+	};
+
+	//バッファの範囲(resourceはアロケータが持つので解放しない)
+	struct BufferRange{
+		ID3D12Resource				*resource;
+		UINT64						offset;
+		UINT64						size;
+		D3D12_GPU_VIRTUAL_ADDRESS	gpu_address;
+		unsigned char				*cpu_address;	//UPLOADヒープの場合のみ
+		Allocation					allocation;
+	};
+
+	struct BlockStats{
+		Pool					pool;
+		bool					dedicated;
+		TlsfAllocator::Stats	range;
+	};
+
+	struct Stats{
+		uint32_t	block_num;
+		UINT64		reserved_size;		//確保したヒープの合計
+		UINT64		used_size;
+		uint64_t	resource_num;		//配置したテクスチャの数
+		uint64_t	range_num;			//割り当てたバッファの範囲の数
+		float		max_fragmentation;	//ブロックごとの断片化の最大
+	};
+
+public:
+	GpuMemoryAllocator();
+	~GpuMemoryAllocator(){}
+	//residencyを渡すとブロックを作成・破棄するときに登録・解除する
+	HRESULT Initialize(ID3D12Device *device, UINT64 block_size = DEFAULT_BLOCK_SIZE, ResidencyManager *residency = nullptr);
+
+	//heap_typeはDEFAULTかUPLOAD。alignmentは2のべきであること
+	HRESULT AllocateBuffer(D3D12_HEAP_TYPE heap_type, UINT64 size, UINT64 alignment, BufferRange *range);
+
+	//テクスチャをヒープに配置する(allocationはnullptrでもよい。その場合は解放しない)
+	HRESULT CreateTexture(const D3D12_RESOURCE_DESC &desc, D3D12_RESOURCE_STATES state, const D3D12_CLEAR_VALUE *clear_value, ID3D12Resource **texture, Allocation *allocation);
+
+	//fence_valueのフレームまでGPUが参照する範囲を解放する(0ならすぐに再利用してよい)
+	//テクスチャはリソースを破棄してから呼ぶこと
+	void Free(const Allocation &allocation, UINT64 fence_value = 0);
+	void ReleaseCompleted(UINT64 completed_fence_value);
+
+	//今フレームでallocationを使う(そのブロックを常駐させる)
+	void Use(const Allocation &allocation);
+
+	Stats GetStats() const;
+	std::vector<BlockStats> GetBlockStats() const;
+
+private:
+	struct Block{
+		ComPtr<ID3D12Heap>		heap;		//破棄した専用のブロックはnullptr
+		ComPtr<ID3D12Resource>	buffer;		//バッファのブロックならヒープ全体を覆うバッファ
+		unsigned char			*cpu_address;
+		TlsfAllocator			ranges;
+		bool					dedicated;
+		int						residency;	//ResidencyManagerのハンドル
+	};
+
+	HRESULT Allocate(Pool pool, UINT64 size, UINT64 alignment, Allocation *allocation);
+	HRESULT CreateBlock(Pool pool, UINT64 size, bool dedicated, int *index);
+	void ReleaseDedicatedBlock(Pool pool, int index);
+
+private:
+	mutable std::mutex			mutex_;
+	ComPtr<ID3D12Device>		device_;
+	ResidencyManager			*residency_;
+	UINT64						block_size_;
+	std::vector<Block>			blocks_[POOL_NUM];
+	uint64_t					resource_num_;
+	uint64_t					range_num_;
+};
+
+#endif
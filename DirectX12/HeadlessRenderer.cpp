@@ -0,0 +1,673 @@
+#include <algorithm>
+#include <cinttypes>
+#include "HeadlessRenderer.h"
+
+namespace{
+const char* GetStateName(uint64_t state){
+	static const char *names[RENDER_STATE_NUM] = {
+		"COMMON",
+		"VERTEX_AND_CONSTANT_BUFFER",
+		"INDEX_BUFFER",
+		"RENDER_TARGET",
+		"DEPTH_WRITE",
+		"DEPTH_READ",
+		"SHADER_RESOURCE",
+		"COPY_DEST",
+		"COPY_SOURCE",
+		"GENERIC_READ",
+	};
+	return state < RENDER_STATE_NUM ? names[state] : "UNKNOWN";
+}
+
+std::string FormatStateError(const char *where, uint64_t resource, uint64_t expected, uint64_t before){
+	char buffer[256];
+	snprintf(buffer, sizeof(buffer), "%s: resource 0x%" PRIx64 " is %s but barrier expects %s",
+		where, resource, GetStateName(expected), GetStateName(before));
+	return buffer;
+}
+
+std::string FormatSplitError(const char *where, uint64_t resource, const char *message){
+	char buffer[256];
+	snprintf(buffer, sizeof(buffer), "%s: resource 0x%" PRIx64 " %s", where, resource, message);
+	return buffer;
+}
+
+//状態を追跡するキー(リソース全体はリソースの値そのもの、サブリソースは上位ビットに番号を入れる)
+constexpr uint64_t RESOURCE_KEY_MASK = (1ull << 48) - 1;
+
+uint64_t GetStateKey(uint64_t resource, uint32_t subresource){
+	if(subresource == RENDER_ALL_SUBRESOURCES){
+		return resource;
+	}
+	return resource ^ (static_cast<uint64_t>(subresource + 1) << 48);
+}
+
+bool IsSubresourceKey(uint64_t key, uint64_t resource){
+	const uint64_t diff = key ^ resource;
+	return diff != 0 && (diff & RESOURCE_KEY_MASK) == 0;
+}
+
+//barrierを追跡中の状態に適用する。遷移前の状態が食い違っていればfalseを返し、actualに追跡中の状態を入れる
+//サブリソースの状態がなければリソース全体の状態と比べ、全体の遷移ではサブリソースごとの状態をまとめる
+bool ApplyBarrier(std::unordered_map<uint64_t, RenderResourceState> *states, const RenderBarrier &barrier, RenderResourceState *actual){
+	const uint64_t resource = barrier.resource.value;
+	const uint64_t key = GetStateKey(resource, barrier.subresource);
+	bool matched = true;
+
+	auto it = states->find(key);
+	if(it == states->end() && barrier.subresource != RENDER_ALL_SUBRESOURCES){
+		it = states->find(resource);
+	}
+	if(it != states->end() && it->second != barrier.before){
+		*actual = it->second;
+		matched = false;
+	}
+
+	if(barrier.subresource == RENDER_ALL_SUBRESOURCES){
+		for(auto s = states->begin(); s != states->end();){
+			if(!IsSubresourceKey(s->first, resource)){
+				++s;
+				continue;
+			}
+			if(matched && s->second != barrier.before){
+				*actual = s->second;
+				matched = false;
+			}
+			s = states->erase(s);
+		}
+	}
+
+	(*states)[key] = barrier.after;
+	return matched;
+}
+}
+
+
+HeadlessStats& HeadlessStats::operator+=(const HeadlessStats &other){
+	command_num			+= other.command_num;
+	draw_num			+= other.draw_num;
+	barrier_num			+= other.barrier_num;
+	barrier_batch_num	+= other.barrier_batch_num;
+	state_change_num	+= other.state_change_num;
+	error_num			+= other.error_num;
+	return *this;
+}
+
+
+HeadlessCommandList::HeadlessCommandList():
+	recording_(false),
+	commands_{},
+	errors_{},
+	stats_{},
+	root_signature_set_(false),
+	pipeline_set_(false),
+	viewport_set_(false),
+	scissor_set_(false),
+	target_set_(false),
+	heap_set_(false),
+	index_buffer_set_(false),
+	topology_(RENDER_TOPOLOGY_UNDEFINED),
+	states_{},
+	splits_{}{}
+
+bool HeadlessCommandList::Begin(int){
+	if(recording_){
+		Error("Begin: already recording");
+		return false;
+	}
+
+	//D3D12と同じく、リセットで設定はすべて初期状態に戻る
+	recording_			= true;
+	commands_.clear();
+	errors_.clear();
+	stats_				= {};
+	root_signature_set_	= false;
+	pipeline_set_		= false;
+	viewport_set_		= false;
+	scissor_set_		= false;
+	target_set_			= false;
+	heap_set_			= false;
+	index_buffer_set_	= false;
+	topology_			= RENDER_TOPOLOGY_UNDEFINED;
+	states_.clear();
+	splits_.clear();
+
+	return true;
+}
+
+bool HeadlessCommandList::End(){
+	if(!recording_){
+		Error("End: not recording");
+		return false;
+	}
+
+	recording_ = false;
+	return true;
+}
+
+void HeadlessCommandList::ResourceBarriers(int num, const RenderBarrier *barriers){
+	if(num > 0){
+		++stats_.barrier_batch_num;
+	}
+
+	for(int i = 0; i < num; ++i){
+		const RenderBarrier &barrier = barriers[i];
+		Push(HEADLESS_BARRIER, barrier.resource.value, barrier.before, barrier.after, barrier.subresource | (static_cast<uint64_t>(barrier.type) << 32));
+		++stats_.barrier_num;
+
+		if(!barrier.resource.IsValid()){
+			Error("ResourceBarrier: invalid resource");
+			continue;
+		}
+		if(barrier.type == RENDER_BARRIER_ALIASING){
+			continue;
+		}
+		if(barrier.before == barrier.after){
+			Error("ResourceBarrier: before and after are the same state");
+		}
+
+		//分割バリアの終了は、このリストで開始したものなら開始時に検証済み(前のリストで開始したものはキューで検証する)
+		const uint64_t key = GetStateKey(barrier.resource.value, barrier.subresource);
+		if(barrier.type == RENDER_BARRIER_END){
+			auto split = splits_.find(key);
+			if(split == splits_.end()){
+				states_[key] = barrier.after;
+			}else{
+				if(split->second != barrier.after){
+					errors_.push_back(FormatSplitError("ResourceBarrier", barrier.resource.value, "ends a split barrier with a different state"));
+					++stats_.error_num;
+				}
+				splits_.erase(split);
+			}
+			continue;
+		}
+		if(splits_.count(key) > 0){
+			errors_.push_back(FormatSplitError("ResourceBarrier", barrier.resource.value, "is transitioned during a split barrier"));
+			++stats_.error_num;
+		}
+
+		RenderResourceState actual{};
+		if(!ApplyBarrier(&states_, barrier, &actual)){
+			errors_.push_back(FormatStateError("ResourceBarrier", barrier.resource.value, actual, barrier.before));
+			++stats_.error_num;
+		}
+		if(barrier.type == RENDER_BARRIER_BEGIN){
+			splits_[key] = barrier.after;
+		}
+	}
+}
+
+void HeadlessCommandList::ClearRenderTarget(RenderTargetView rtv, const float color[4]){
+	Push(HEADLESS_CLEAR_RENDER_TARGET, rtv.value);
+	if(!rtv.IsValid()){
+		Error("ClearRenderTarget: invalid view");
+	}
+	(void)color;
+}
+
+void HeadlessCommandList::ClearDepth(RenderTargetView dsv, float depth){
+	Push(HEADLESS_CLEAR_DEPTH, dsv.value);
+	if(!dsv.IsValid()){
+		Error("ClearDepth: invalid view");
+	}
+	if(depth < 0.0f || depth > 1.0f){
+		Error("ClearDepth: depth out of range");
+	}
+}
+
+void HeadlessCommandList::CopyResource(RenderResource dst, RenderResource src){
+	Push(HEADLESS_COPY_RESOURCE, dst.value, src.value);
+	if(!dst.IsValid() || !src.IsValid()){
+		Error("CopyResource: invalid resource");
+		return;
+	}
+	if(dst.value == src.value){
+		Error("CopyResource: source and destination are the same resource");
+	}
+	ValidateState("CopyResource", dst, RENDER_STATE_COPY_DEST);
+	ValidateState("CopyResource", src, RENDER_STATE_COPY_SOURCE);
+}
+
+void HeadlessCommandList::SetRenderTargets(int rtv_num, const RenderTargetView *rtvs, RenderTargetView dsv){
+	Push(HEADLESS_SET_RENDER_TARGETS, static_cast<uint64_t>(rtv_num), rtv_num > 0 ? rtvs[0].value : 0, dsv.value);
+	if(rtv_num == 0 && !dsv.IsValid()){
+		Error("SetRenderTargets: no render target and no depth buffer");
+	}
+	target_set_ = true;
+}
+
+void HeadlessCommandList::SetViewport(const RenderViewport &viewport){
+	Push(HEADLESS_SET_VIEWPORT, static_cast<uint64_t>(viewport.width), static_cast<uint64_t>(viewport.height));
+	if(viewport.width <= 0.0f || viewport.height <= 0.0f){
+		Error("SetViewport: empty viewport");
+	}
+	viewport_set_ = true;
+}
+
+void HeadlessCommandList::SetScissorRect(const RenderRect &rect){
+	Push(HEADLESS_SET_SCISSOR_RECT, static_cast<uint64_t>(rect.right - rect.left), static_cast<uint64_t>(rect.bottom - rect.top));
+	scissor_set_ = true;
+}
+
+void HeadlessCommandList::SetRootSignature(RenderRootSignature root_signature){
+	Push(HEADLESS_SET_ROOT_SIGNATURE, root_signature.value);
+	++stats_.state_change_num;
+	root_signature_set_ = root_signature.IsValid();
+}
+
+void HeadlessCommandList::SetPipeline(RenderPipeline pipeline){
+	Push(HEADLESS_SET_PIPELINE, pipeline.value);
+	++stats_.state_change_num;
+	pipeline_set_ = pipeline.IsValid();
+}
+
+void HeadlessCommandList::SetConstantBuffer(int slot, RenderGpuAddress address){
+	Push(HEADLESS_SET_CONSTANT_BUFFER, static_cast<uint64_t>(slot), address);
+	if(!root_signature_set_){
+		Error("SetConstantBuffer: no root signature");
+	}
+	if(address % RenderUploadHeap::CONSTANT_ALIGNMENT != 0){
+		Error("SetConstantBuffer: address is not 256-byte aligned");
+	}
+}
+
+void HeadlessCommandList::SetRootConstants(int slot, uint32_t num, const uint32_t *values, uint32_t offset){
+	Push(HEADLESS_SET_ROOT_CONSTANTS, static_cast<uint64_t>(slot), num, offset, num > 0 ? values[0] : 0);
+	if(!root_signature_set_){
+		Error("SetRootConstants: no root signature");
+	}
+}
+
+void HeadlessCommandList::SetDescriptorHeap(RenderDescriptorHeap heap){
+	Push(HEADLESS_SET_DESCRIPTOR_HEAP, heap.value);
+	++stats_.state_change_num;
+	heap_set_ = heap.IsValid();
+}
+
+void HeadlessCommandList::SetDescriptorTable(int slot, RenderDescriptorTable table){
+	Push(HEADLESS_SET_DESCRIPTOR_TABLE, static_cast<uint64_t>(slot), table.value);
+	if(!root_signature_set_){
+		Error("SetDescriptorTable: no root signature");
+	}
+	if(!heap_set_){
+		Error("SetDescriptorTable: no descriptor heap");
+	}
+}
+
+void HeadlessCommandList::SetTopology(RenderTopology topology){
+	Push(HEADLESS_SET_TOPOLOGY, topology);
+	topology_ = topology;
+}
+
+void HeadlessCommandList::SetVertexBuffer(int slot, RenderGpuAddress address, uint32_t size, uint32_t stride){
+	Push(HEADLESS_SET_VERTEX_BUFFER, static_cast<uint64_t>(slot), address, size, stride);
+	if(address == 0 || stride == 0 || size % stride != 0){
+		Error("SetVertexBuffer: invalid view");
+	}
+}
+
+void HeadlessCommandList::SetIndexBuffer(RenderGpuAddress address, uint32_t size, RenderIndexFormat format){
+	Push(HEADLESS_SET_INDEX_BUFFER, address, size, format);
+	if(address == 0 || size == 0){
+		Error("SetIndexBuffer: invalid view");
+	}
+	index_buffer_set_ = true;
+}
+
+void HeadlessCommandList::Draw(uint32_t vertex_num, uint32_t instance_num, uint32_t start_vertex, uint32_t start_instance){
+	Push(HEADLESS_DRAW, vertex_num, instance_num, start_vertex, start_instance);
+	ValidateDraw(false);
+}
+
+void HeadlessCommandList::DrawIndexed(uint32_t index_num, uint32_t instance_num, uint32_t start_index, int32_t base_vertex, uint32_t start_instance){
+	Push(HEADLESS_DRAW_INDEXED, index_num, instance_num, start_index, static_cast<uint64_t>(static_cast<int64_t>(base_vertex)));
+	(void)start_instance;
+	ValidateDraw(true);
+}
+
+void HeadlessCommandList::Push(HeadlessCommandType type, uint64_t a0, uint64_t a1, uint64_t a2, uint64_t a3){
+	if(!recording_){
+		Error("command recorded outside Begin/End");
+	}
+
+	commands_.push_back({type, {a0, a1, a2, a3}});
+	++stats_.command_num;
+}
+
+void HeadlessCommandList::Error(const char *message){
+	errors_.push_back(message);
+	++stats_.error_num;
+}
+
+void HeadlessCommandList::ValidateDraw(bool indexed){
+	++stats_.draw_num;
+
+	if(!root_signature_set_){
+		Error("Draw: no root signature");
+	}
+	if(!pipeline_set_){
+		Error("Draw: no pipeline");
+	}
+	if(!viewport_set_ || !scissor_set_){
+		Error("Draw: no viewport or scissor rect");
+	}
+	if(!target_set_){
+		Error("Draw: no render target");
+	}
+	if(topology_ == RENDER_TOPOLOGY_UNDEFINED){
+		Error("Draw: no topology");
+	}
+	if(indexed && !index_buffer_set_){
+		Error("DrawIndexed: no index buffer");
+	}
+}
+
+//このリストで遷移したリソースの状態を確かめる(リストの前からの状態はキューがバリアで検証する)
+void HeadlessCommandList::ValidateState(const char *where, RenderResource resource, RenderResourceState expected){
+	auto it = states_.find(resource.value);
+	if(it != states_.end() && it->second != expected){
+		char buffer[256];
+		snprintf(buffer, sizeof(buffer), "%s: resource 0x%" PRIx64 " is %s but must be %s", where, resource.value, GetStateName(it->second), GetStateName(expected));
+		Error(buffer);
+	}
+}
+
+void HeadlessCommandList::Dump(FILE *fp) const{
+	for(const HeadlessCommand &c : commands_){
+		if(c.type == HEADLESS_BARRIER){
+			static const char *types[] = {"", " (begin)", " (end)", " (aliasing)"};
+			const uint32_t subresource = static_cast<uint32_t>(c.args[3]);
+			const uint32_t type = static_cast<uint32_t>(c.args[3] >> 32);
+			fprintf(fp, "%s 0x%" PRIx64 " %s -> %s%s", GetCommandName(c.type), c.args[0], GetStateName(c.args[1]), GetStateName(c.args[2]), type < 4 ? types[type] : "");
+			if(subresource != RENDER_ALL_SUBRESOURCES){
+				fprintf(fp, " subresource %u", subresource);
+			}
+			fputc('\n', fp);
+		}else{
+			fprintf(fp, "%s 0x%" PRIx64 " 0x%" PRIx64 " 0x%" PRIx64 " 0x%" PRIx64 "\n", GetCommandName(c.type), c.args[0], c.args[1], c.args[2], c.args[3]);
+		}
+	}
+	for(const std::string &e : errors_){
+		fprintf(fp, "error: %s\n", e.c_str());
+	}
+}
+
+const char* HeadlessCommandList::GetCommandName(HeadlessCommandType type){
+	static const char *names[HEADLESS_COMMAND_NUM] = {
+		"ResourceBarrier",
+		"ClearRenderTarget",
+		"ClearDepth",
+		"SetRenderTargets",
+		"SetViewport",
+		"SetScissorRect",
+		"SetRootSignature",
+		"SetPipeline",
+		"SetConstantBuffer",
+		"SetRootConstants",
+		"SetDescriptorHeap",
+		"SetDescriptorTable",
+		"SetTopology",
+		"SetVertexBuffer",
+		"SetIndexBuffer",
+		"Draw",
+		"DrawIndexed",
+		"CopyResource",
+	};
+	return type < HEADLESS_COMMAND_NUM ? names[type] : "Unknown";
+}
+
+
+HeadlessQueue::HeadlessQueue():
+	fence_value_{},
+	states_{},
+	splits_{},
+	errors_{},
+	stats_{}{}
+
+void HeadlessQueue::SetResourceState(RenderResource resource, RenderResourceState state){
+	states_[resource.value] = state;
+}
+
+bool HeadlessQueue::GetResourceState(RenderResource resource, RenderResourceState *state) const{
+	auto it = states_.find(resource.value);
+	if(it == states_.end()){
+		return false;
+	}
+
+	*state = it->second;
+	return true;
+}
+
+void HeadlessQueue::Execute(int list_num, HeadlessCommandList *const *lists){
+	for(int i = 0; i < list_num; ++i){
+		const HeadlessCommandList *list = lists[i];
+		if(list->IsRecording()){
+			errors_.push_back("Execute: command list is not closed");
+			++stats_.error_num;
+		}
+
+		//提出順にバリアを適用してリストをまたいだ状態を追跡する
+		for(const HeadlessCommand &c : list->Commands()){
+			if(c.type != HEADLESS_BARRIER || c.args[0] == 0 || (c.args[3] >> 32) == RENDER_BARRIER_ALIASING){
+				continue;
+			}
+
+			const RenderBarrier barrier{{c.args[0]}, static_cast<uint32_t>(c.args[3]), static_cast<RenderResourceState>(c.args[1]),
+				static_cast<RenderResourceState>(c.args[2]), static_cast<RenderBarrierType>(c.args[3] >> 32)};
+			const uint64_t key = GetStateKey(barrier.resource.value, barrier.subresource);
+
+			//分割バリアは開始と終了が対になっていること(リストをまたいでもよい)
+			if(barrier.type == RENDER_BARRIER_END){
+				auto split = splits_.find(key);
+				if(split == splits_.end()){
+					errors_.push_back(FormatSplitError("Execute", barrier.resource.value, "ends a split barrier that was not begun"));
+					++stats_.error_num;
+				}else{
+					splits_.erase(split);
+				}
+				continue;
+			}
+			if(splits_.count(key) > 0){
+				errors_.push_back(FormatSplitError("Execute", barrier.resource.value, "is transitioned during a split barrier"));
+				++stats_.error_num;
+			}
+
+			RenderResourceState actual{};
+			if(!ApplyBarrier(&states_, barrier, &actual)){
+				errors_.push_back(FormatStateError("Execute", barrier.resource.value, actual, barrier.before));
+				++stats_.error_num;
+			}
+			if(barrier.type == RENDER_BARRIER_BEGIN){
+				splits_[key] = barrier.after;
+			}
+		}
+
+		stats_ += list->Stats();
+	}
+}
+
+void HeadlessQueue::ResetStats(){
+	errors_.clear();
+	stats_ = {};
+}
+
+
+HeadlessUploadHeap::HeadlessUploadHeap():
+	HeadlessUploadHeap(0){}
+
+HeadlessUploadHeap::HeadlessUploadHeap(uint64_t size):
+	memory_{},
+	allocator_{},
+	uploaded_bytes_{},
+	allocation_num_{},
+	failed_num_{}{
+	Initialize(size);
+}
+
+void HeadlessUploadHeap::Initialize(uint64_t size){
+	memory_.assign(static_cast<size_t>(size), 0);
+	allocator_.Reset(size);
+	ResetStats();
+}
+
+bool HeadlessUploadHeap::Allocate(uint64_t size, uint64_t alignment, Allocation *allocation){
+	const uint64_t offset = allocator_.Allocate(size, alignment);
+	if(offset == RingAllocator::INVALID_OFFSET){
+		++failed_num_;
+		return false;
+	}
+
+	allocation->cpu_address	= memory_.data() + offset;
+	allocation->gpu_address	= GPU_ADDRESS_BASE + offset;
+	allocation->offset		= offset;
+
+	uploaded_bytes_ += size;
+	++allocation_num_;
+
+	return true;
+}
+
+void HeadlessUploadHeap::ResetStats(){
+	uploaded_bytes_	= 0;
+	allocation_num_	= 0;
+	failed_num_		= 0;
+}
+
+
+HeadlessStreamTarget::HeadlessStreamTarget():
+	memory_{},
+	allocator_{},
+	latency_{},
+	frame_{},
+	fence_value_{},
+	completed_value_{},
+	pending_{},
+	uploaded_bytes_{},
+	failed_num_{}{}
+
+void HeadlessStreamTarget::Initialize(uint64_t staging_size, int latency){
+	memory_.assign(static_cast<size_t>(staging_size), 0);
+	allocator_.Reset(staging_size);
+	latency_			= latency;
+	frame_				= 0;
+	fence_value_		= 0;
+	completed_value_	= 0;
+	pending_.clear();
+	uploaded_bytes_		= 0;
+	failed_num_			= 0;
+}
+
+bool HeadlessStreamTarget::UploadRows(RenderResource, TextureFormat format, int, const TextureLevel &pixels, int first_row, int row_num){
+	CopyFootprint footprint{};
+	CalcCopyFootprints(format, pixels.width, pixels.height, 0, 1, 0, &footprint);
+
+	CopyFootprint slice = SliceCopyFootprint(format, footprint, first_row, row_num);
+	if(slice.row_num <= 0){
+		return true;
+	}
+	const uint64_t size = static_cast<uint64_t>(slice.row_pitch) * (slice.row_num - 1) + slice.row_size;
+
+	slice.offset = allocator_.Allocate(size, CopyFootprint::PLACEMENT_ALIGNMENT);
+	if(slice.offset == RingAllocator::INVALID_OFFSET){
+		++failed_num_;
+		return false;
+	}
+
+	//D3D12と同じレイアウトでステージングに書き込む
+	CopyFootprintRows(slice, pixels.pixels + static_cast<size_t>(first_row) * pixels.row_pitch, pixels.row_pitch, memory_.data());
+	uploaded_bytes_ += size;
+	return true;
+}
+
+uint64_t HeadlessStreamTarget::Submit(){
+	++fence_value_;
+	allocator_.FinishFrame(fence_value_);
+	pending_.push_back({fence_value_, frame_});
+	return fence_value_;
+}
+
+void HeadlessStreamTarget::EndFrame(){
+	++frame_;
+	while(!pending_.empty() && pending_.front().frame + latency_ <= frame_){
+		completed_value_ = pending_.front().fence_value;
+		pending_.pop_front();
+	}
+	allocator_.ReleaseCompletedFrames(completed_value_);
+}
+
+
+HeadlessResidencyTarget::HeadlessResidencyTarget():
+	objects_{},
+	budgets_{},
+	external_usage_{},
+	usage_{},
+	completed_value_{},
+	error_num_{},
+	make_resident_failure_num_{}{}
+
+void HeadlessResidencyTarget::Add(RenderResource object, uint64_t size, MemorySegment segment){
+	objects_[object.value] = {size, segment, true, 0};
+	usage_[segment] += size;
+}
+
+void HeadlessResidencyTarget::Remove(RenderResource object){
+	auto it = objects_.find(object.value);
+	if(it == objects_.end()){
+		++error_num_;
+		return;
+	}
+	if(it->second.resident){
+		usage_[it->second.segment] -= it->second.size;
+	}
+	objects_.erase(it);
+}
+
+void HeadlessResidencyTarget::Access(RenderResource object, uint64_t fence_value){
+	auto it = objects_.find(object.value);
+	if(it == objects_.end() || !it->second.resident){
+		++error_num_;
+		return;
+	}
+	it->second.last_access = std::max(it->second.last_access, fence_value);
+}
+
+bool HeadlessResidencyTarget::QueryBudget(MemorySegment segment, MemoryBudget *budget){
+	budget->budget	= budgets_[segment];
+	budget->usage	= Usage(segment);
+	return true;
+}
+
+bool HeadlessResidencyTarget::MakeResident(const RenderResource *objects, int num){
+	if(make_resident_failure_num_ > 0){
+		--make_resident_failure_num_;
+		return false;
+	}
+	for(int i = 0; i < num; ++i){
+		auto it = objects_.find(objects[i].value);
+		if(it == objects_.end() || it->second.resident){
+			++error_num_;
+			continue;
+		}
+		it->second.resident = true;
+		usage_[it->second.segment] += it->second.size;
+	}
+	return true;
+}
+
+bool HeadlessResidencyTarget::Evict(const RenderResource *objects, int num){
+	for(int i = 0; i < num; ++i){
+		auto it = objects_.find(objects[i].value);
+		if(it == objects_.end() || !it->second.resident || it->second.last_access > completed_value_){
+			++error_num_;
+			continue;
+		}
+		it->second.resident = false;
+		usage_[it->second.segment] -= it->second.size;
+	}
+	return true;
+}
+
+bool HeadlessResidencyTarget::IsResident(RenderResource object) const{
+	auto it = objects_.find(object.value);
+	return it != objects_.end() && it->second.resident;
+}
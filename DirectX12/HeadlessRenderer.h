@@ -0,0 +1,276 @@
+#ifndef HEADLESS_RENDERER_HEADER_
+#define HEADLESS_RENDERER_HEADER_
+
+#include <cstdio>
+#include <deque>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "RenderCommandList.h"
+#include "RenderUploadHeap.h"
+#include "RecordScheduler.h"
+#include "RingAllocator.h"
+#include "TextureStreamer.h"
+#include "ResidencyManager.h"
+
+//GPUなしで動くバックエンド
+//コマンドを記録して検証し、コマンド数・バリア数・アップロード量などを数える(CIでのCPU側の計測用)
+
+enum HeadlessCommandType : uint32_t{
+	HEADLESS_BARRIER,
+	HEADLESS_CLEAR_RENDER_TARGET,
+	HEADLESS_CLEAR_DEPTH,
+	HEADLESS_SET_RENDER_TARGETS,
+	HEADLESS_SET_VIEWPORT,
+	HEADLESS_SET_SCISSOR_RECT,
+	HEADLESS_SET_ROOT_SIGNATURE,
+	HEADLESS_SET_PIPELINE,
+	HEADLESS_SET_CONSTANT_BUFFER,
+	HEADLESS_SET_ROOT_CONSTANTS,
+	HEADLESS_SET_DESCRIPTOR_HEAP,
+	HEADLESS_SET_DESCRIPTOR_TABLE,
+	HEADLESS_SET_TOPOLOGY,
+	HEADLESS_SET_VERTEX_BUFFER,
+	HEADLESS_SET_INDEX_BUFFER,
+	HEADLESS_DRAW,
+	HEADLESS_DRAW_INDEXED,
+	HEADLESS_COPY_RESOURCE,
+	HEADLESS_COMMAND_NUM,
+};
+
+//記録したコマンド(引数の意味は種類ごとに異なる)
+//バリアは[リソース, 遷移前, 遷移後, サブリソース | 種類 << 32]
+struct HeadlessCommand{
+	HeadlessCommandType	type;
+	uint64_t			args[4];
+};
+
+struct HeadlessStats{
+	uint64_t	command_num;
+	uint64_t	draw_num;
+	uint64_t	barrier_num;
+	uint64_t	barrier_batch_num;	//ResourceBarriersの呼び出し回数
+	uint64_t	state_change_num;	//PSO・ルートシグネチャ・デスクリプタヒープの切り替え
+	uint64_t	error_num;
+
+	HeadlessStats& operator+=(const HeadlessStats &other);
+};
+
+
+//コマンドを記録するコマンドリスト
+//記録時にコマンドの順序(描画前のPSOの設定など)とリスト内のリソースの状態遷移を検証する
+class HeadlessCommandList : public RenderCommandList, public RecordTarget{
+public:
+	HeadlessCommandList();
+	~HeadlessCommandList(){}
+
+	bool Begin(int frame_index) override;
+	bool End() override;
+
+	void ResourceBarriers(int num, const RenderBarrier *barriers) override;
+
+	void ClearRenderTarget(RenderTargetView rtv, const float color[4]) override;
+	void ClearDepth(RenderTargetView dsv, float depth) override;
+	void CopyResource(RenderResource dst, RenderResource src) override;
+
+	void SetRenderTargets(int rtv_num, const RenderTargetView *rtvs, RenderTargetView dsv) override;
+	void SetViewport(const RenderViewport &viewport) override;
+	void SetScissorRect(const RenderRect &rect) override;
+
+	void SetRootSignature(RenderRootSignature root_signature) override;
+	void SetPipeline(RenderPipeline pipeline) override;
+	void SetConstantBuffer(int slot, RenderGpuAddress address) override;
+	void SetRootConstants(int slot, uint32_t num, const uint32_t *values, uint32_t offset) override;
+	void SetDescriptorHeap(RenderDescriptorHeap heap) override;
+	void SetDescriptorTable(int slot, RenderDescriptorTable table) override;
+
+	void SetTopology(RenderTopology topology) override;
+	void SetVertexBuffer(int slot, RenderGpuAddress address, uint32_t size, uint32_t stride) override;
+	void SetIndexBuffer(RenderGpuAddress address, uint32_t size, RenderIndexFormat format) override;
+
+	void Draw(uint32_t vertex_num, uint32_t instance_num, uint32_t start_vertex, uint32_t start_instance) override;
+	void DrawIndexed(uint32_t index_num, uint32_t instance_num, uint32_t start_index, int32_t base_vertex, uint32_t start_instance) override;
+
+	bool IsRecording() const{return recording_;}
+	const std::vector<HeadlessCommand>& Commands() const{return commands_;}
+	const std::vector<std::string>& Errors() const{return errors_;}
+	const HeadlessStats& Stats() const{return stats_;}
+
+	//記録したコマンドを1行ずつ書き出す
+	void Dump(FILE *fp) const;
+
+	static const char* GetCommandName(HeadlessCommandType type);
+
+private:
+	void Push(HeadlessCommandType type, uint64_t a0 = 0, uint64_t a1 = 0, uint64_t a2 = 0, uint64_t a3 = 0);
+	void Error(const char *message);
+	void ValidateDraw(bool indexed);
+	void ValidateState(const char *where, RenderResource resource, RenderResourceState expected);
+
+private:
+	bool							recording_;
+	std::vector<HeadlessCommand>	commands_;
+	std::vector<std::string>		errors_;
+	HeadlessStats					stats_;
+
+	//描画の検証に使う現在の設定
+	bool							root_signature_set_;
+	bool							pipeline_set_;
+	bool							viewport_set_;
+	bool							scissor_set_;
+	bool							target_set_;
+	bool							heap_set_;
+	bool							index_buffer_set_;
+	RenderTopology					topology_;
+
+	std::unordered_map<uint64_t, RenderResourceState>	states_;	//このリスト内での各リソース(サブリソース)の状態
+	std::unordered_map<uint64_t, RenderResourceState>	splits_;	//このリスト内で開始した分割バリアの遷移後の状態
+};
+
+
+//コマンドリストの実行を模したキュー
+//提出順にバリアをたどってリソースの状態を追跡し、リストをまたいだ状態の不一致を検出する
+class HeadlessQueue{
+public:
+	HeadlessQueue();
+	~HeadlessQueue(){}
+
+	//リソースの作成時の状態を登録する(未登録のリソースは最初のバリアのbeforeを正とする)
+	void SetResourceState(RenderResource resource, RenderResourceState state);
+	bool GetResourceState(RenderResource resource, RenderResourceState *state) const;
+
+	void Execute(int list_num, HeadlessCommandList *const *lists);
+
+	//GPUの処理は即座に完了したものとして扱う
+	uint64_t Signal(){return ++fence_value_;}
+	uint64_t CompletedValue() const{return fence_value_;}
+
+	const std::vector<std::string>& Errors() const{return errors_;}
+	const HeadlessStats& Stats() const{return stats_;}
+	void ResetStats();
+
+private:
+	uint64_t											fence_value_;
+	std::unordered_map<uint64_t, RenderResourceState>	states_;
+	std::unordered_map<uint64_t, RenderResourceState>	splits_;	//開始して終了していない分割バリア
+	std::vector<std::string>							errors_;
+	HeadlessStats										stats_;
+};
+
+
+//CPUのメモリ上に確保するアップロードヒープ
+class HeadlessUploadHeap : public RenderUploadHeap{
+public:
+	static constexpr RenderGpuAddress GPU_ADDRESS_BASE = 0x100000000ull;	//ダミーのGPUアドレスの先頭
+
+public:
+	HeadlessUploadHeap();
+	explicit HeadlessUploadHeap(uint64_t size);
+	~HeadlessUploadHeap(){}
+
+	void Initialize(uint64_t size);
+
+	bool Allocate(uint64_t size, uint64_t alignment, Allocation *allocation) override;
+	void FinishFrame(uint64_t fence_value) override{allocator_.FinishFrame(fence_value);}
+	void ReleaseCompletedFrames(uint64_t completed_fence_value) override{allocator_.ReleaseCompletedFrames(completed_fence_value);}
+
+	uint64_t UploadedBytes() const{return uploaded_bytes_;}
+	uint64_t AllocationNum() const{return allocation_num_;}
+	uint64_t FailedNum() const{return failed_num_;}
+	uint64_t UsedSize() const{return allocator_.UsedSize();}
+	void ResetStats();
+
+private:
+	std::vector<unsigned char>	memory_;
+	RingAllocator				allocator_;
+	uint64_t					uploaded_bytes_;
+	uint64_t					allocation_num_;
+	uint64_t					failed_num_;
+};
+
+
+//テクスチャのストリーミングの転送先を模したキュー
+//行をステージングのレイアウトでCPUのメモリに書き込み、提出からlatencyフレーム後に完了したものとする
+class HeadlessStreamTarget : public TextureStreamTarget{
+public:
+	HeadlessStreamTarget();
+	~HeadlessStreamTarget(){}
+
+	void Initialize(uint64_t staging_size, int latency);
+
+	bool UploadRows(RenderResource resource, TextureFormat format, int level, const TextureLevel &pixels, int first_row, int row_num) override;
+	uint64_t Submit() override;
+	uint64_t CompletedValue() override{return completed_value_;}
+
+	//フレームを進め、latencyフレーム前までに提出したものを完了させる
+	void EndFrame();
+
+	uint64_t UploadedBytes() const{return uploaded_bytes_;}
+	uint64_t FailedNum() const{return failed_num_;}
+
+private:
+	struct Pending{
+		uint64_t	fence_value;
+		uint64_t	frame;
+	};
+
+	std::vector<unsigned char>	memory_;
+	RingAllocator				allocator_;
+	int							latency_;
+	uint64_t					frame_;
+	uint64_t					fence_value_;
+	uint64_t					completed_value_;
+	std::deque<Pending>			pending_;
+	uint64_t					uploaded_bytes_;
+	uint64_t					failed_num_;
+};
+
+
+//常駐の切り替え先を模したもの
+//使用量は常駐しているものの合計に、管理外の使用量(他のアプリなどを模す)を足したものとする
+//GPUが使っている間に退避したもの・常駐していないのにGPUが使ったものをエラーとして数える
+class HeadlessResidencyTarget : public ResidencyTarget{
+public:
+	HeadlessResidencyTarget();
+	~HeadlessResidencyTarget(){}
+
+	void SetBudget(MemorySegment segment, uint64_t budget){budgets_[segment] = budget;}
+	void SetExternalUsage(MemorySegment segment, uint64_t usage){external_usage_[segment] = usage;}
+
+	//作成したもの(常駐している)・破棄したものを伝える
+	void Add(RenderResource object, uint64_t size, MemorySegment segment);
+	void Remove(RenderResource object);
+
+	//GPUがfence_valueのフレームでobjectを使う・completed_fence_valueまでのフレームが完了した
+	void Access(RenderResource object, uint64_t fence_value);
+	void Complete(uint64_t completed_fence_value){completed_value_ = completed_fence_value;}
+
+	//この後のcount回のMakeResidentを失敗させる(デバイスのメモリ不足を模す)
+	void FailMakeResident(int count){make_resident_failure_num_ = count;}
+
+	bool QueryBudget(MemorySegment segment, MemoryBudget *budget) override;
+	bool MakeResident(const RenderResource *objects, int num) override;
+	bool Evict(const RenderResource *objects, int num) override;
+
+	bool IsResident(RenderResource object) const;
+	uint64_t Usage(MemorySegment segment) const{return usage_[segment] + external_usage_[segment];}
+	uint64_t ErrorNum() const{return error_num_;}
+
+private:
+	struct Object{
+		uint64_t		size;
+		MemorySegment	segment;
+		bool			resident;
+		uint64_t		last_access;	//GPUが最後に使うフレームのフェンス値
+	};
+
+	std::unordered_map<uint64_t, Object>	objects_;
+	uint64_t								budgets_[MEMORY_SEGMENT_NUM];
+	uint64_t								external_usage_[MEMORY_SEGMENT_NUM];
+	uint64_t								usage_[MEMORY_SEGMENT_NUM];
+	uint64_t								completed_value_;
+	uint64_t								error_num_;
+	int										make_resident_failure_num_;
+};
+
+#endif
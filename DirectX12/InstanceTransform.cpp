@@ -0,0 +1,229 @@
+#include <cmath>
+#include <cstring>
+#include "InstanceTransform.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define INSTANCE_TRANSFORM_SSE2
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define INSTANCE_TRANSFORM_NEON
+#endif
+
+namespace{
+typedef InstanceTransform::InstanceData InstanceData;
+
+constexpr float PI			= 3.14159265358979323846f;
+constexpr float TWO_PI		= 2.0f * PI;
+constexpr float HALF_PI		= 0.5f * PI;
+constexpr float INV_TWO_PI	= 1.0f / TWO_PI;
+constexpr float TWO_PI_HI	= 6.28125f;						//2πを2つに分けて折り返しの誤差を減らす
+constexpr float TWO_PI_LO	= 1.9353071795864769253e-3f;
+
+//4インスタンス分の値を持つベクトル
+#if defined(INSTANCE_TRANSFORM_SSE2)
+struct Float4{
+	__m128 v;
+};
+inline Float4 Load(const float *src){return {_mm_loadu_ps(src)};}
+inline Float4 Splat(float a){return {_mm_set1_ps(a)};}
+inline Float4 operator+(Float4 a, Float4 b){return {_mm_add_ps(a.v, b.v)};}
+inline Float4 operator-(Float4 a, Float4 b){return {_mm_sub_ps(a.v, b.v)};}
+inline Float4 operator*(Float4 a, Float4 b){return {_mm_mul_ps(a.v, b.v)};}
+inline Float4 Round(Float4 a){return {_mm_cvtepi32_ps(_mm_cvtps_epi32(a.v))};}
+inline Float4 Greater(Float4 a, Float4 b){return {_mm_cmpgt_ps(a.v, b.v)};}
+inline Float4 Less(Float4 a, Float4 b){return {_mm_cmplt_ps(a.v, b.v)};}
+inline Float4 Or(Float4 a, Float4 b){return {_mm_or_ps(a.v, b.v)};}
+inline Float4 Select(Float4 mask, Float4 a, Float4 b){return {_mm_or_ps(_mm_and_ps(mask.v, a.v), _mm_andnot_ps(mask.v, b.v))};}
+
+//a,b,c,dを転置して4つの行として書き出す(dst[k] = {a[k], b[k], c[k], d[k]})
+inline void StoreTransposed(float *const dst[4], Float4 a, Float4 b, Float4 c, Float4 d){
+	_MM_TRANSPOSE4_PS(a.v, b.v, c.v, d.v);
+	_mm_storeu_ps(dst[0], a.v);
+	_mm_storeu_ps(dst[1], b.v);
+	_mm_storeu_ps(dst[2], c.v);
+	_mm_storeu_ps(dst[3], d.v);
+}
+#elif defined(INSTANCE_TRANSFORM_NEON)
+struct Float4{
+	float32x4_t v;
+};
+inline Float4 Load(const float *src){return {vld1q_f32(src)};}
+inline Float4 Splat(float a){return {vdupq_n_f32(a)};}
+inline Float4 operator+(Float4 a, Float4 b){return {vaddq_f32(a.v, b.v)};}
+inline Float4 operator-(Float4 a, Float4 b){return {vsubq_f32(a.v, b.v)};}
+inline Float4 operator*(Float4 a, Float4 b){return {vmulq_f32(a.v, b.v)};}
+inline Float4 Round(Float4 a){return {vrndnq_f32(a.v)};}
+inline Float4 Greater(Float4 a, Float4 b){return {vreinterpretq_f32_u32(vcgtq_f32(a.v, b.v))};}
+inline Float4 Less(Float4 a, Float4 b){return {vreinterpretq_f32_u32(vcltq_f32(a.v, b.v))};}
+inline Float4 Or(Float4 a, Float4 b){return {vreinterpretq_f32_u32(vorrq_u32(vreinterpretq_u32_f32(a.v), vreinterpretq_u32_f32(b.v)))};}
+inline Float4 Select(Float4 mask, Float4 a, Float4 b){return {vbslq_f32(vreinterpretq_u32_f32(mask.v), a.v, b.v)};}
+
+inline void StoreTransposed(float *const dst[4], Float4 a, Float4 b, Float4 c, Float4 d){
+	const float32x4x2_t ab = vtrnq_f32(a.v, b.v);
+	const float32x4x2_t cd = vtrnq_f32(c.v, d.v);
+	vst1q_f32(dst[0], vcombine_f32(vget_low_f32(ab.val[0]), vget_low_f32(cd.val[0])));
+	vst1q_f32(dst[1], vcombine_f32(vget_low_f32(ab.val[1]), vget_low_f32(cd.val[1])));
+	vst1q_f32(dst[2], vcombine_f32(vget_high_f32(ab.val[0]), vget_high_f32(cd.val[0])));
+	vst1q_f32(dst[3], vcombine_f32(vget_high_f32(ab.val[1]), vget_high_f32(cd.val[1])));
+}
+#else
+struct Float4{
+	float v[4];
+};
+inline Float4 Load(const float *src){return {{src[0], src[1], src[2], src[3]}};}
+inline Float4 Splat(float a){return {{a, a, a, a}};}
+inline Float4 operator+(Float4 a, Float4 b){return {{a.v[0] + b.v[0], a.v[1] + b.v[1], a.v[2] + b.v[2], a.v[3] + b.v[3]}};}
+inline Float4 operator-(Float4 a, Float4 b){return {{a.v[0] - b.v[0], a.v[1] - b.v[1], a.v[2] - b.v[2], a.v[3] - b.v[3]}};}
+inline Float4 operator*(Float4 a, Float4 b){return {{a.v[0] * b.v[0], a.v[1] * b.v[1], a.v[2] * b.v[2], a.v[3] * b.v[3]}};}
+inline Float4 Round(Float4 a){return {{std::nearbyint(a.v[0]), std::nearbyint(a.v[1]), std::nearbyint(a.v[2]), std::nearbyint(a.v[3])}};}
+//マスクは1.0/0.0で表す
+inline Float4 Greater(Float4 a, Float4 b){
+	return {{a.v[0] > b.v[0] ? 1.0f : 0.0f, a.v[1] > b.v[1] ? 1.0f : 0.0f, a.v[2] > b.v[2] ? 1.0f : 0.0f, a.v[3] > b.v[3] ? 1.0f : 0.0f}};
+}
+inline Float4 Less(Float4 a, Float4 b){return Greater(b, a);}
+inline Float4 Or(Float4 a, Float4 b){
+	return {{(a.v[0] + b.v[0]) > 0.0f ? 1.0f : 0.0f, (a.v[1] + b.v[1]) > 0.0f ? 1.0f : 0.0f, (a.v[2] + b.v[2]) > 0.0f ? 1.0f : 0.0f, (a.v[3] + b.v[3]) > 0.0f ? 1.0f : 0.0f}};
+}
+inline Float4 Select(Float4 mask, Float4 a, Float4 b){
+	return {{mask.v[0] != 0.0f ? a.v[0] : b.v[0], mask.v[1] != 0.0f ? a.v[1] : b.v[1], mask.v[2] != 0.0f ? a.v[2] : b.v[2], mask.v[3] != 0.0f ? a.v[3] : b.v[3]}};
+}
+
+inline void StoreTransposed(float *const dst[4], Float4 a, Float4 b, Float4 c, Float4 d){
+	for(int k = 0; k < 4; ++k){
+		dst[k][0] = a.v[k];
+		dst[k][1] = b.v[k];
+		dst[k][2] = c.v[k];
+		dst[k][3] = d.v[k];
+	}
+}
+#endif
+
+//4要素のsinとcosをまとめて求める(DirectXMathのXMVectorSinCosと同じ多項式近似)
+inline void SinCos(Float4 a, Float4 *s, Float4 *c){
+
+	//[-π, π]に折り返す
+	const Float4 q = Round(a * Splat(INV_TWO_PI));
+	Float4 x = (a - q * Splat(TWO_PI_HI)) - q * Splat(TWO_PI_LO);
+
+	//[-π/2, π/2]に折り返す(cosの符号が反転する)
+	const Float4 over	= Greater(x, Splat(HALF_PI));
+	const Float4 under	= Less(x, Splat(-HALF_PI));
+	x = Select(over, Splat(PI) - x, x);
+	x = Select(under, Splat(-PI) - x, x);
+	const Float4 sign = Select(Or(over, under), Splat(-1.0f), Splat(1.0f));
+
+	const Float4 x2 = x * x;
+
+	Float4 ps = Splat(-2.3889859e-08f);
+	ps = ps * x2 + Splat(2.7525562e-06f);
+	ps = ps * x2 + Splat(-0.00019840874f);
+	ps = ps * x2 + Splat(0.0083333310f);
+	ps = ps * x2 + Splat(-0.16666667f);
+	ps = ps * x2 + Splat(1.0f);
+	*s = ps * x;
+
+	Float4 pc = Splat(-2.6051615e-07f);
+	pc = pc * x2 + Splat(2.4760495e-05f);
+	pc = pc * x2 + Splat(-0.0013888378f);
+	pc = pc * x2 + Splat(0.041666638f);
+	pc = pc * x2 + Splat(-0.5f);
+	pc = pc * x2 + Splat(1.0f);
+	*c = pc * sign;
+}
+}
+
+
+InstanceTransform::InstanceTransform():
+	num_{},
+	x_{},
+	y_{},
+	z_{},
+	scale_{},
+	yaw_{},
+	yaw_speed_{},
+	texture_index_{}{}
+
+void InstanceTransform::Resize(int num){
+	num_ = num > 0 ? num : 0;
+
+	//SIMDで端数を気にせず読めるように切り上げる(余りの要素は書き出さない)
+	const size_t padded = static_cast<size_t>((num_ + SIMD_WIDTH - 1) / SIMD_WIDTH * SIMD_WIDTH);
+	x_.assign(padded, 0.0f);
+	y_.assign(padded, 0.0f);
+	z_.assign(padded, 0.0f);
+	scale_.assign(padded, 1.0f);
+	yaw_.assign(padded, 0.0f);
+	yaw_speed_.assign(padded, 0.0f);
+	texture_index_.assign(padded, 0);
+}
+
+void InstanceTransform::Clear(){
+	Resize(0);
+}
+
+void InstanceTransform::Set(int index, float x, float y, float z, float scale, float yaw, float yaw_speed, uint32_t texture_index){
+	x_[index]				= x;
+	y_[index]				= y;
+	z_[index]				= z;
+	scale_[index]			= scale;
+	yaw_[index]				= yaw;
+	yaw_speed_[index]		= yaw_speed;
+	texture_index_[index]	= texture_index;
+}
+
+//ワールド変換行列はスケール * Y軸回転 * 平行移動
+//転置した上3行は (s*cos, 0, s*sin, x) (0, s, 0, y) (-s*sin, 0, s*cos, z)
+void InstanceTransform::Write(float time, InstanceData *dst) const{
+	const Float4 t		= Splat(time);
+	const Float4 zero	= Splat(0.0f);
+
+	for(int i = 0; i < num_; i += SIMD_WIDTH){
+		const Float4 scale	= Load(&scale_[i]);
+		const Float4 yaw	= Load(&yaw_[i]) + Load(&yaw_speed_[i]) * t;
+
+		Float4 s, c;
+		SinCos(yaw, &s, &c);
+		const Float4 sc = scale * c;
+		const Float4 ss = scale * s;
+
+		//端数のグループは一時領域に書いてから必要な分だけコピーする
+		const int n = (num_ - i < SIMD_WIDTH) ? num_ - i : SIMD_WIDTH;
+		InstanceData tail[SIMD_WIDTH];
+		InstanceData *out = (n == SIMD_WIDTH) ? dst + i : tail;
+
+		float *rows[3][SIMD_WIDTH];
+		for(int k = 0; k < SIMD_WIDTH; ++k){
+			rows[0][k] = out[k].world[0];
+			rows[1][k] = out[k].world[1];
+			rows[2][k] = out[k].world[2];
+		}
+		StoreTransposed(rows[0], sc, zero, ss, Load(&x_[i]));
+		StoreTransposed(rows[1], zero, scale, zero, Load(&y_[i]));
+		StoreTransposed(rows[2], zero - ss, zero, sc, Load(&z_[i]));
+
+		for(int k = 0; k < SIMD_WIDTH; ++k){
+			out[k].texture_index = texture_index_[i + k];
+			out[k].reserved[0] = out[k].reserved[1] = out[k].reserved[2] = 0;
+		}
+
+		if(out == tail){
+			memcpy(dst + i, tail, sizeof(InstanceData) * n);
+		}
+	}
+}
+
+void InstanceTransform::WriteScalar(float time, InstanceData *dst) const{
+	for(int i = 0; i < num_; ++i){
+		const float yaw = yaw_[i] + yaw_speed_[i] * time;
+		const float s = sinf(yaw) * scale_[i];
+		const float c = cosf(yaw) * scale_[i];
+
+		InstanceData &out = dst[i];
+		out.world[0][0] = c;	out.world[0][1] = 0.0f;			out.world[0][2] = s;	out.world[0][3] = x_[i];
+		out.world[1][0] = 0.0f;	out.world[1][1] = scale_[i];	out.world[1][2] = 0.0f;	out.world[1][3] = y_[i];
+		out.world[2][0] = -s;	out.world[2][1] = 0.0f;			out.world[2][2] = c;	out.world[2][3] = z_[i];
+		out.texture_index = texture_index_[i];
+		out.reserved[0] = out.reserved[1] = out.reserved[2] = 0;
+	}
+}
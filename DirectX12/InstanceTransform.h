@@ -0,0 +1,50 @@
+#ifndef INSTANCE_TRANSFORM_HEADER_
+#define INSTANCE_TRANSFORM_HEADER_
+
+#include <cstdint>
+#include <vector>
+
+//インスタンスごとの変換(位置・スケール・Y軸回転)をSoAで持ち、シェーダに渡す形式に書き出す
+//書き出しは4インスタンスずつSIMDで行う
+class InstanceTransform{
+public:
+	static constexpr int SIMD_WIDTH = 4;
+
+	//シェーダに渡すインスタンスごとのデータ(インスタンス用の頂点バッファの1要素)
+	struct InstanceData{
+		float		world[3][4];	//ワールド変換行列を転置した上3行(位置はdot(world[i], float4(pos, 1)))
+		uint32_t	texture_index;
+		uint32_t	reserved[3];
+	};
+	static_assert(sizeof(InstanceData) == 64, "instance data size");
+
+public:
+	InstanceTransform();
+	~InstanceTransform(){}
+
+	void Resize(int num);
+	void Clear();
+
+	//yawは時刻0での回転角、yaw_speedは時刻1あたりの回転角(ラジアン)
+	void Set(int index, float x, float y, float z, float scale, float yaw, float yaw_speed, uint32_t texture_index);
+
+	int Num() const{return num_;}
+
+	//時刻timeでの変換をdstに書き出す(dstはNum()個)
+	void Write(float time, InstanceData *dst) const;
+
+	//比較用に1インスタンスずつsin/cosを呼んで書き出す
+	void WriteScalar(float time, InstanceData *dst) const;
+
+private:
+	int						num_;
+	std::vector<float>		x_;			//以下はSIMD_WIDTHの倍数に切り上げた長さを持つ
+	std::vector<float>		y_;
+	std::vector<float>		z_;
+	std::vector<float>		scale_;
+	std::vector<float>		yaw_;
+	std::vector<float>		yaw_speed_;
+	std::vector<uint32_t>	texture_index_;
+};
+
+#endif
@@ -0,0 +1,56 @@
+#include "JobSystem.h"
+
+JobSystem::JobSystem(unsigned int thread_num):
+	threads_{},
+	jobs_{},
+	quit_(false){
+
+	//指定がなければ論理コア数-1(メインスレッドの分)だけ起動する
+	if(thread_num == 0){
+		const unsigned int hw = std::thread::hardware_concurrency();
+		thread_num = (hw > 1) ? hw - 1 : 1;
+	}
+
+	threads_.reserve(thread_num);
+	for(unsigned int i = 0; i < thread_num; ++i){
+		threads_.emplace_back(&JobSystem::WorkerMain, this);
+	}
+}
+
+JobSystem::~JobSystem(){
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		quit_ = true;
+	}
+	cv_.notify_all();
+
+	for(auto &t : threads_){
+		t.join();
+	}
+}
+
+void JobSystem::Enqueue(std::function<void()> job){
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		jobs_.push_back(std::move(job));
+	}
+	cv_.notify_one();
+}
+
+void JobSystem::WorkerMain(){
+	for(;;){
+		std::function<void()> job;
+		{
+			std::unique_lock<std::mutex> lock(mutex_);
+			cv_.wait(lock, [this]{return quit_ || !jobs_.empty();});
+
+			//終了時も積まれているジョブは全て処理する
+			if(jobs_.empty()){
+				return;
+			}
+			job = std::move(jobs_.front());
+			jobs_.pop_front();
+		}
+		job();
+	}
+}
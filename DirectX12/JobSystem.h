@@ -0,0 +1,45 @@
+#ifndef JOB_SYSTEM_HEADER_
+#define JOB_SYSTEM_HEADER_
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//ワーカースレッドでジョブを実行するスレッドプール
+class JobSystem{
+public:
+	explicit JobSystem(unsigned int thread_num = 0);
+	~JobSystem();
+	JobSystem(const JobSystem&) = delete;
+	JobSystem& operator=(const JobSystem&) = delete;
+
+	//ジョブを積み、結果を受け取るfutureを返す
+	template<class F>
+	auto Push(F func) -> std::future<decltype(func())>{
+		typedef decltype(func()) Result;
+		auto task = std::make_shared<std::packaged_task<Result()>>(std::move(func));
+		std::future<Result> result = task->get_future();
+		Enqueue([task]{(*task)();});
+		return result;
+	}
+
+	unsigned int ThreadNum() const{return static_cast<unsigned int>(threads_.size());}
+
+private:
+	void Enqueue(std::function<void()> job);
+	void WorkerMain();
+
+private:
+	std::vector<std::thread>			threads_;
+	std::deque<std::function<void()>>	jobs_;
+	std::mutex							mutex_;
+	std::condition_variable				cv_;
+	bool								quit_;
+};
+
+#endif
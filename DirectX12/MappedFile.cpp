@@ -0,0 +1,116 @@
+#include "MappedFile.h"
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile():
+#if defined(_WIN32)
+	file_(INVALID_HANDLE_VALUE),
+	mapping_(NULL),
+#else
+	fd_(-1),
+#endif
+	data_(nullptr),
+	size_{}{}
+
+MappedFile::~MappedFile(){
+	Close();
+}
+
+
+#if defined(_WIN32)
+
+bool MappedFile::Open(const char *file_name){
+	Close();
+
+	file_ = CreateFileA(file_name, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if(file_ == INVALID_HANDLE_VALUE){
+		return false;
+	}
+
+	LARGE_INTEGER size{};
+	if(!GetFileSizeEx(file_, &size) || size.QuadPart == 0){
+		Close();
+		return false;
+	}
+
+	//ファイル全体を読み込み専用でマップする
+	mapping_ = CreateFileMappingA(file_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if(mapping_ == NULL){
+		Close();
+		return false;
+	}
+
+	data_ = static_cast<const byte*>(MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0));
+	if(data_ == nullptr){
+		Close();
+		return false;
+	}
+	size_ = static_cast<size_t>(size.QuadPart);
+
+	return true;
+}
+
+void MappedFile::Close(){
+	if(data_ != nullptr){
+		UnmapViewOfFile(data_);
+		data_ = nullptr;
+	}
+	if(mapping_ != NULL){
+		CloseHandle(mapping_);
+		mapping_ = NULL;
+	}
+	if(file_ != INVALID_HANDLE_VALUE){
+		CloseHandle(file_);
+		file_ = INVALID_HANDLE_VALUE;
+	}
+	size_ = 0;
+}
+
+#else
+
+bool MappedFile::Open(const char *file_name){
+	Close();
+
+	fd_ = open(file_name, O_RDONLY);
+	if(fd_ < 0){
+		return false;
+	}
+
+	struct stat st{};
+	if(fstat(fd_, &st) != 0 || st.st_size == 0){
+		Close();
+		return false;
+	}
+
+	//ファイル全体を読み込み専用でマップする
+	void *p = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd_, 0);
+	if(p == MAP_FAILED){
+		Close();
+		return false;
+	}
+	madvise(p, static_cast<size_t>(st.st_size), MADV_SEQUENTIAL);
+
+	data_ = static_cast<const byte*>(p);
+	size_ = static_cast<size_t>(st.st_size);
+
+	return true;
+}
+
+void MappedFile::Close(){
+	if(data_ != nullptr){
+		munmap(const_cast<byte*>(data_), size_);
+		data_ = nullptr;
+	}
+	if(fd_ >= 0){
+		close(fd_);
+		fd_ = -1;
+	}
+	size_ = 0;
+}
+
+#endif
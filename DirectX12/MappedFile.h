@@ -0,0 +1,39 @@
+#ifndef MAPPED_FILE_HEADER_
+#define MAPPED_FILE_HEADER_
+
+#include <cstddef>
+
+#if defined(_WIN32)
+#include <Windows.h>
+#endif
+
+//ファイルを読み込み専用でメモリマップする
+class MappedFile{
+public:
+	typedef unsigned char byte;
+
+public:
+	MappedFile();
+	~MappedFile();
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	bool Open(const char *file_name);
+	void Close();
+
+	const byte* Data() const{return data_;}
+	size_t Size() const{return size_;}
+	bool IsOpen() const{return data_ != nullptr;}
+
+private:
+#if defined(_WIN32)
+	HANDLE		file_;
+	HANDLE		mapping_;
+#else
+	int			fd_;
+#endif
+	const byte	*data_;
+	size_t		size_;
+};
+
+#endif
@@ -0,0 +1,357 @@
+#include <algorithm>
+#include <cmath>
+#include "MipChain.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define MIP_CHAIN_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define MIP_CHAIN_SSE2
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define MIP_CHAIN_NEON
+#endif
+
+namespace{
+typedef MipChain::byte byte;
+
+//線形空間の値をsRGBに戻すテーブルの分割数
+constexpr int SRGB_TABLE_SCALE = 4096;
+
+//1画素に平均する元の画素の最大数(縦横3個ずつ)
+constexpr int MAX_TAP_NUM = 9;
+
+struct ColorTable{
+	float	to_linear[256];
+	byte	to_srgb[SRGB_TABLE_SCALE + 4];		//AVX2は4バイト単位で引くので3バイト余分に持つ
+	float	sum_to_index[MAX_TAP_NUM + 1][4];	//n画素の合計をテーブルの添字(アルファは値そのもの)に変換する係数
+
+	ColorTable(){
+		for(int i = 0; i < 256; ++i){
+			const float c = i / 255.0f;
+			to_linear[i] = (c <= 0.04045f) ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+		}
+		for(int i = 0; i <= SRGB_TABLE_SCALE; ++i){
+			const float l = i / static_cast<float>(SRGB_TABLE_SCALE);
+			const float c = (l <= 0.0031308f) ? l * 12.92f : 1.055f * std::pow(l, 1.0f / 2.4f) - 0.055f;
+			to_srgb[i] = static_cast<byte>(std::min(255.0f, std::max(0.0f, c * 255.0f + 0.5f)));
+		}
+		for(int i = SRGB_TABLE_SCALE + 1; i < SRGB_TABLE_SCALE + 4; ++i){
+			to_srgb[i] = 0;
+		}
+		for(int n = 1; n <= MAX_TAP_NUM; ++n){
+			sum_to_index[n][0] = SRGB_TABLE_SCALE / static_cast<float>(n);
+			sum_to_index[n][1] = SRGB_TABLE_SCALE / static_cast<float>(n);
+			sum_to_index[n][2] = SRGB_TABLE_SCALE / static_cast<float>(n);
+			sum_to_index[n][3] = 255.0f / static_cast<float>(n);
+		}
+		sum_to_index[0][0] = sum_to_index[0][1] = sum_to_index[0][2] = sum_to_index[0][3] = 0.0f;
+	}
+};
+
+const ColorTable& GetColorTable(){
+	static const ColorTable table;
+	return table;
+}
+
+//縮小後のindex番目の画素に平均する元の画素の数(横・縦それぞれ)
+//元が奇数なら最後の画素は3個を均等に平均し、最後の行・列を落とさない
+int GetTapNum(int src_size, int dst_index, int dst_size){
+	if(src_size == 1){
+		return 1;
+	}
+	return (src_size % 2 == 1 && dst_index == dst_size - 1) ? 3 : 2;
+}
+
+//縦に足した行(画素ごとにBGRAのfloat)のx番目の画素をtap_num個足して書き込む
+void StorePixel(const float *sum, int x, int tap_num, const float *factor, const ColorTable &table, byte *dst){
+	const float *p = sum + x * 2 * MipChain::PIXEL_SIZE;
+	int index[4];
+	for(int c = 0; c < 4; ++c){
+		float s = p[c];
+		if(tap_num > 1){
+			s += p[MipChain::PIXEL_SIZE + c];
+		}
+		if(tap_num > 2){
+			s += p[MipChain::PIXEL_SIZE * 2 + c];
+		}
+		index[c] = static_cast<int>(std::nearbyint(s * factor[c]));
+	}
+	dst[0] = table.to_srgb[index[0]];
+	dst[1] = table.to_srgb[index[1]];
+	dst[2] = table.to_srgb[index[2]];
+	dst[3] = static_cast<byte>(index[3]);
+}
+
+
+//比較用のスカラー実装
+//・ToLinear: 1行分のBGRA8を線形空間のfloatに変換する
+//・Add: 行を足す(dstはaと同じでよい)
+//・Store: 2個ずつ平均する画素を先頭からnum個まで書き込み、書き込んだ数を返す(残りはStorePixelで書き込む)
+struct ScalarKernel{
+	static void ToLinear(const byte *src, int width, float *dst, const ColorTable &table){
+		for(int x = 0; x < width; ++x){
+			dst[0] = table.to_linear[src[0]];
+			dst[1] = table.to_linear[src[1]];
+			dst[2] = table.to_linear[src[2]];
+			dst[3] = src[3] * (1.0f / 255.0f);
+			src += MipChain::PIXEL_SIZE;
+			dst += MipChain::PIXEL_SIZE;
+		}
+	}
+
+	static void Add(const float *a, const float *b, int count, float *dst){
+		for(int i = 0; i < count; ++i){
+			dst[i] = a[i] + b[i];
+		}
+	}
+
+	static int Store(const float*, int, const float*, const ColorTable&, byte*){
+		return 0;
+	}
+};
+
+
+#if defined(MIP_CHAIN_AVX2)
+//AVX2: テーブルはgatherで引き、縮小後の4画素をまとめて書き込む
+struct SimdKernel{
+	static void ToLinear(const byte *src, int width, float *dst, const ColorTable &table){
+		const __m256 alpha_scale = _mm256_set1_ps(1.0f / 255.0f);
+		int x = 0;
+		for(; x + 2 <= width; x += 2){
+			const __m256i index = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(src + x * MipChain::PIXEL_SIZE)));
+			const __m256 color = _mm256_i32gather_ps(table.to_linear, index, 4);
+			const __m256 alpha = _mm256_mul_ps(_mm256_cvtepi32_ps(index), alpha_scale);
+			_mm256_storeu_ps(dst + x * MipChain::PIXEL_SIZE, _mm256_blend_ps(color, alpha, 0x88));
+		}
+		ScalarKernel::ToLinear(src + x * MipChain::PIXEL_SIZE, width - x, dst + x * MipChain::PIXEL_SIZE, table);
+	}
+
+	static void Add(const float *a, const float *b, int count, float *dst){
+		int i = 0;
+		for(; i + 8 <= count; i += 8){
+			_mm256_storeu_ps(dst + i, _mm256_add_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i)));
+		}
+		ScalarKernel::Add(a + i, b + i, count - i, dst + i);
+	}
+
+	//縮小後の2画素分の添字(sumの先頭から2x2個の画素を横に2個ずつ足す)
+	static __m256i Index(const float *sum, __m256 factor, const ColorTable &table){
+		const __m256 a = _mm256_loadu_ps(sum);
+		const __m256 b = _mm256_loadu_ps(sum + 8);
+		const __m256 s = _mm256_add_ps(_mm256_permute2f128_ps(a, b, 0x20), _mm256_permute2f128_ps(a, b, 0x31));
+		const __m256i index = _mm256_cvtps_epi32(_mm256_mul_ps(s, factor));
+		const __m256i srgb = _mm256_and_si256(_mm256_i32gather_epi32(reinterpret_cast<const int*>(table.to_srgb), index, 1), _mm256_set1_epi32(0xff));
+		return _mm256_blend_epi32(srgb, index, 0x88);
+	}
+
+	static int Store(const float *sum, int num, const float *factor, const ColorTable &table, byte *dst){
+		const __m256 f = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(factor));
+		const __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 0, 4, 1, 5);
+		int x = 0;
+		for(; x + 4 <= num; x += 4){
+			const float *p = sum + x * 2 * MipChain::PIXEL_SIZE;
+			const __m256i v0 = Index(p, f, table);
+			const __m256i v1 = Index(p + 16, f, table);
+
+			//128bitごとに詰めると(x, x + 2)・(x + 1, x + 3)の順になるので並べ替える
+			const __m256i w = _mm256_packs_epi32(v0, v1);
+			const __m256i packed = _mm256_permutevar8x32_epi32(_mm256_packus_epi16(w, w), order);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x * MipChain::PIXEL_SIZE), _mm256_castsi256_si128(packed));
+		}
+		return x;
+	}
+};
+#elif defined(MIP_CHAIN_SSE2)
+//SSE2: gatherがないのでテーブルは1要素ずつ引き、足し算・添字への変換・書き込みを4画素ずつ行う
+struct SimdKernel{
+	static void ToLinear(const byte *src, int width, float *dst, const ColorTable &table){
+		ScalarKernel::ToLinear(src, width, dst, table);
+	}
+
+	static void Add(const float *a, const float *b, int count, float *dst){
+		int i = 0;
+		for(; i + 4 <= count; i += 4){
+			_mm_storeu_ps(dst + i, _mm_add_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+		}
+		ScalarKernel::Add(a + i, b + i, count - i, dst + i);
+	}
+
+	static int Store(const float *sum, int num, const float *factor, const ColorTable &table, byte *dst){
+		const __m128 f = _mm_loadu_ps(factor);
+		int x = 0;
+		for(; x + 4 <= num; x += 4){
+			alignas(16) int index[16];
+			for(int i = 0; i < 4; ++i){
+				const float *p = sum + (x + i) * 2 * MipChain::PIXEL_SIZE;
+				const __m128 s = _mm_add_ps(_mm_loadu_ps(p), _mm_loadu_ps(p + MipChain::PIXEL_SIZE));
+				_mm_store_si128(reinterpret_cast<__m128i*>(index + i * 4), _mm_cvtps_epi32(_mm_mul_ps(s, f)));
+			}
+			__m128i color[4];
+			for(int i = 0; i < 4; ++i){
+				const int *n = index + i * 4;
+				color[i] = _mm_setr_epi32(table.to_srgb[n[0]], table.to_srgb[n[1]], table.to_srgb[n[2]], n[3]);
+			}
+			const __m128i packed = _mm_packus_epi16(_mm_packs_epi32(color[0], color[1]), _mm_packs_epi32(color[2], color[3]));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x * MipChain::PIXEL_SIZE), packed);
+		}
+		return x;
+	}
+};
+#elif defined(MIP_CHAIN_NEON)
+//NEON: gatherがないのでテーブルは1要素ずつ引き、足し算・添字への変換・書き込みを4画素ずつ行う
+struct SimdKernel{
+	static void ToLinear(const byte *src, int width, float *dst, const ColorTable &table){
+		ScalarKernel::ToLinear(src, width, dst, table);
+	}
+
+	static void Add(const float *a, const float *b, int count, float *dst){
+		int i = 0;
+		for(; i + 4 <= count; i += 4){
+			vst1q_f32(dst + i, vaddq_f32(vld1q_f32(a + i), vld1q_f32(b + i)));
+		}
+		ScalarKernel::Add(a + i, b + i, count - i, dst + i);
+	}
+
+	static int Store(const float *sum, int num, const float *factor, const ColorTable &table, byte *dst){
+		const float32x4_t f = vld1q_f32(factor);
+		int x = 0;
+		for(; x + 4 <= num; x += 4){
+			int32_t index[16];
+			for(int i = 0; i < 4; ++i){
+				const float *p = sum + (x + i) * 2 * MipChain::PIXEL_SIZE;
+				const float32x4_t s = vaddq_f32(vld1q_f32(p), vld1q_f32(p + MipChain::PIXEL_SIZE));
+				vst1q_s32(index + i * 4, vcvtnq_s32_f32(vmulq_f32(s, f)));
+			}
+			int16x4_t color[4];
+			for(int i = 0; i < 4; ++i){
+				const int32_t *n = index + i * 4;
+				const int32_t c[4] = {table.to_srgb[n[0]], table.to_srgb[n[1]], table.to_srgb[n[2]], n[3]};
+				color[i] = vqmovn_s32(vld1q_s32(c));
+			}
+			const uint8x16_t packed = vcombine_u8(vqmovun_s16(vcombine_s16(color[0], color[1])), vqmovun_s16(vcombine_s16(color[2], color[3])));
+			vst1q_u8(dst + x * MipChain::PIXEL_SIZE, packed);
+		}
+		return x;
+	}
+};
+#else
+typedef ScalarKernel SimdKernel;
+#endif
+
+
+//行単位で縮小する
+//元の行を線形空間に変換して縦に足し(奇数の最後の行は3行)、縮小後の画素ごとに横に足して平均する
+//足す順序はどの実装でも同じなので、結果はスカラー実装と一致する
+template<class Kernel>
+void DownsampleRows(const byte *src, int src_width, int src_height, int src_pitch, byte *dst, int dst_pitch){
+	const ColorTable &table = GetColorTable();
+	const int dst_width  = std::max(1, src_width / 2);
+	const int dst_height = std::max(1, src_height / 2);
+	const int count = src_width * MipChain::PIXEL_SIZE;
+
+	//横に2個ずつ足す画素の数(奇数の最後の画素・幅1の画素は除く)
+	const int pair_num = (src_width == 1) ? 0 : (src_width % 2 == 1) ? dst_width - 1 : dst_width;
+
+	std::vector<float> rows[3];
+	for(std::vector<float> &row : rows){
+		row.resize(count);
+	}
+
+	for(int y = 0; y < dst_height; ++y){
+		const int row_num = GetTapNum(src_height, y, dst_height);
+		for(int i = 0; i < row_num; ++i){
+			Kernel::ToLinear(src + (y * 2 + i) * src_pitch, src_width, rows[i].data(), table);
+		}
+		for(int i = 1; i < row_num; ++i){
+			Kernel::Add(rows[0].data(), rows[i].data(), count, rows[0].data());
+		}
+
+		const float *sum = rows[0].data();
+		byte *d = dst + y * dst_pitch;
+		int x = Kernel::Store(sum, pair_num, table.sum_to_index[2 * row_num], table, d);
+		for(; x < dst_width; ++x){
+			const int tap_num = GetTapNum(src_width, x, dst_width);
+			StorePixel(sum, x, tap_num, table.sum_to_index[tap_num * row_num], table, d + x * MipChain::PIXEL_SIZE);
+		}
+	}
+}
+}
+
+MipChain::MipChain():
+	buffer_{},
+	levels_{}{}
+
+int MipChain::CalcLevelNum(int width, int height){
+	int num = 1;
+	while(width > 1 || height > 1){
+		width  = std::max(1, width / 2);
+		height = std::max(1, height / 2);
+		++num;
+	}
+	return num;
+}
+
+bool MipChain::Generate(const byte *src, int width, int height, int row_pitch){
+	Clear();
+	if(src == nullptr || width <= 0 || height <= 0){
+		return false;
+	}
+
+	//レベル1以降に必要なサイズを計算してまとめて確保する
+	const int level_num = CalcLevelNum(width, height);
+	size_t total{};
+	for(int i = 1, w = width, h = height; i < level_num; ++i){
+		w = std::max(1, w / 2);
+		h = std::max(1, h / 2);
+		total += static_cast<size_t>(w) * h * PIXEL_SIZE;
+	}
+	buffer_.resize(total);
+
+	levels_.reserve(level_num);
+	levels_.push_back({width, height, row_pitch, src});
+
+	byte *dst = buffer_.data();
+	for(int i = 1; i < level_num; ++i){
+		const Level &prev = levels_.back();
+		Level level{};
+		level.width		= std::max(1, prev.width / 2);
+		level.height	= std::max(1, prev.height / 2);
+		level.row_pitch	= level.width * PIXEL_SIZE;
+		level.pixels	= dst;
+
+		Downsample(prev.pixels, prev.width, prev.height, prev.row_pitch, dst, level.row_pitch);
+
+		dst += static_cast<size_t>(level.row_pitch) * level.height;
+		levels_.push_back(level);
+	}
+
+	return true;
+}
+
+void MipChain::Clear(){
+	levels_.clear();
+	std::vector<byte>().swap(buffer_);
+}
+
+
+void MipChain::DownsampleScalar(const byte *src, int src_width, int src_height, int src_pitch, byte *dst, int dst_pitch){
+	DownsampleRows<ScalarKernel>(src, src_width, src_height, src_pitch, dst, dst_pitch);
+}
+
+void MipChain::Downsample(const byte *src, int src_width, int src_height, int src_pitch, byte *dst, int dst_pitch){
+	DownsampleRows<SimdKernel>(src, src_width, src_height, src_pitch, dst, dst_pitch);
+}
+
+const char* MipChain::InstructionSet(){
+#if defined(MIP_CHAIN_AVX2)
+	return "AVX2";
+#elif defined(MIP_CHAIN_SSE2)
+	return "SSE2";
+#elif defined(MIP_CHAIN_NEON)
+	return "NEON";
+#else
+	return "scalar";
+#endif
+}
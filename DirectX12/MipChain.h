@@ -0,0 +1,47 @@
+#ifndef MIP_CHAIN_HEADER_
+#define MIP_CHAIN_HEADER_
+
+#include <cstddef>
+#include <vector>
+
+//BGRA8の画像からミップマップチェインを作成する
+//縮小はsRGBを線形空間に戻してから2x2の平均をとる(アルファは線形のまま)
+//幅・高さが奇数なら最後の列・行は3画素の平均にして、端の画素を落とさない
+class MipChain{
+public:
+	typedef unsigned char byte;
+	static constexpr int PIXEL_SIZE = 4;
+
+	struct Level{
+		int			width;
+		int			height;
+		int			row_pitch;
+		const byte	*pixels;
+	};
+
+public:
+	MipChain();
+	~MipChain(){}
+
+	//レベル0はsrcをそのまま参照するので、srcはMipChainより長く生存している必要がある
+	bool Generate(const byte *src, int width, int height, int row_pitch);
+	void Clear();
+
+	int LevelNum() const{return static_cast<int>(levels_.size());}
+	const Level& GetLevel(int level) const{return levels_[level];}
+
+	static int CalcLevelNum(int width, int height);
+
+	//1段階の縮小(dstのサイズはmax(1, width/2) x max(1, height/2))
+	static void Downsample(const byte *src, int src_width, int src_height, int src_pitch, byte *dst, int dst_pitch);
+	static void DownsampleScalar(const byte *src, int src_width, int src_height, int src_pitch, byte *dst, int dst_pitch);
+
+	//Downsampleが使う命令セット
+	static const char* InstructionSet();
+
+private:
+	std::vector<byte>	buffer_;	//レベル1以降の画素
+	std::vector<Level>	levels_;
+};
+
+#endif
@@ -0,0 +1,486 @@
+#include <algorithm>
+#include <cmath>
+#include <future>
+#include "JobSystem.h"
+#include "OcclusionCuller.h"
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#define OCCLUSION_CULLER_AVX
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define OCCLUSION_CULLER_SSE2
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define OCCLUSION_CULLER_NEON
+#endif
+
+namespace{
+//LANE_NUM行分の値を持つベクトル
+#if defined(OCCLUSION_CULLER_AVX)
+constexpr int LANE_NUM = 8;
+struct FloatN{
+	__m256 v;
+};
+inline FloatN Load(const float *src){return {_mm256_loadu_ps(src)};}
+inline FloatN Splat(float a){return {_mm256_set1_ps(a)};}
+inline FloatN operator+(FloatN a, FloatN b){return {_mm256_add_ps(a.v, b.v)};}
+inline FloatN operator-(FloatN a, FloatN b){return {_mm256_sub_ps(a.v, b.v)};}
+inline FloatN operator*(FloatN a, FloatN b){return {_mm256_mul_ps(a.v, b.v)};}
+inline FloatN Min(FloatN a, FloatN b){return {_mm256_min_ps(a.v, b.v)};}
+inline FloatN Max(FloatN a, FloatN b){return {_mm256_max_ps(a.v, b.v)};}
+inline void StoreTruncated(int32_t *dst, FloatN a){_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst), _mm256_cvttps_epi32(a.v));}
+#elif defined(OCCLUSION_CULLER_SSE2)
+constexpr int LANE_NUM = 4;
+struct FloatN{
+	__m128 v;
+};
+inline FloatN Load(const float *src){return {_mm_loadu_ps(src)};}
+inline FloatN Splat(float a){return {_mm_set1_ps(a)};}
+inline FloatN operator+(FloatN a, FloatN b){return {_mm_add_ps(a.v, b.v)};}
+inline FloatN operator-(FloatN a, FloatN b){return {_mm_sub_ps(a.v, b.v)};}
+inline FloatN operator*(FloatN a, FloatN b){return {_mm_mul_ps(a.v, b.v)};}
+inline FloatN Min(FloatN a, FloatN b){return {_mm_min_ps(a.v, b.v)};}
+inline FloatN Max(FloatN a, FloatN b){return {_mm_max_ps(a.v, b.v)};}
+inline void StoreTruncated(int32_t *dst, FloatN a){_mm_storeu_si128(reinterpret_cast<__m128i*>(dst), _mm_cvttps_epi32(a.v));}
+#elif defined(OCCLUSION_CULLER_NEON)
+constexpr int LANE_NUM = 4;
+struct FloatN{
+	float32x4_t v;
+};
+inline FloatN Load(const float *src){return {vld1q_f32(src)};}
+inline FloatN Splat(float a){return {vdupq_n_f32(a)};}
+inline FloatN operator+(FloatN a, FloatN b){return {vaddq_f32(a.v, b.v)};}
+inline FloatN operator-(FloatN a, FloatN b){return {vsubq_f32(a.v, b.v)};}
+inline FloatN operator*(FloatN a, FloatN b){return {vmulq_f32(a.v, b.v)};}
+inline FloatN Min(FloatN a, FloatN b){return {vminq_f32(a.v, b.v)};}
+inline FloatN Max(FloatN a, FloatN b){return {vmaxq_f32(a.v, b.v)};}
+inline void StoreTruncated(int32_t *dst, FloatN a){vst1q_s32(dst, vcvtq_s32_f32(a.v));}
+#else
+constexpr int LANE_NUM = 4;
+struct FloatN{
+	float v[4];
+};
+inline FloatN Load(const float *src){return {{src[0], src[1], src[2], src[3]}};}
+inline FloatN Splat(float a){return {{a, a, a, a}};}
+inline FloatN operator+(FloatN a, FloatN b){return {{a.v[0] + b.v[0], a.v[1] + b.v[1], a.v[2] + b.v[2], a.v[3] + b.v[3]}};}
+inline FloatN operator-(FloatN a, FloatN b){return {{a.v[0] - b.v[0], a.v[1] - b.v[1], a.v[2] - b.v[2], a.v[3] - b.v[3]}};}
+inline FloatN operator*(FloatN a, FloatN b){return {{a.v[0] * b.v[0], a.v[1] * b.v[1], a.v[2] * b.v[2], a.v[3] * b.v[3]}};}
+inline FloatN Min(FloatN a, FloatN b){return {{std::min(a.v[0], b.v[0]), std::min(a.v[1], b.v[1]), std::min(a.v[2], b.v[2]), std::min(a.v[3], b.v[3])}};}
+inline FloatN Max(FloatN a, FloatN b){return {{std::max(a.v[0], b.v[0]), std::max(a.v[1], b.v[1]), std::max(a.v[2], b.v[2]), std::max(a.v[3], b.v[3])}};}
+inline void StoreTruncated(int32_t *dst, FloatN a){
+	for(int i = 0; i < 4; ++i){
+		dst[i] = static_cast<int32_t>(a.v[i]);
+	}
+}
+#endif
+static_assert(OcclusionCuller::TILE_HEIGHT % LANE_NUM == 0, "tile rows must be a multiple of the lane count");
+
+//タイルの中の行の番号
+const float ROW_OFFSETS[OcclusionCuller::TILE_HEIGHT] = {0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f};
+
+//使わない辺の範囲(左端は十分に左、右端は十分に右)
+constexpr float UNBOUNDED = 1.0e30f;
+
+constexpr uint32_t FULL_ROW = 0xffffffffu;
+
+//行ベクトルに右から掛ける
+void Transform(const float p[3], const float m[4][4], float out[4]){
+	for(int j = 0; j < 4; ++j){
+		out[j] = p[0] * m[0][j] + p[1] * m[1][j] + p[2] * m[2][j] + m[3][j];
+	}
+}
+
+void Multiply(const float a[4][4], const float b[4][4], float out[4][4]){
+	for(int i = 0; i < 4; ++i){
+		for(int j = 0; j < 4; ++j){
+			out[i][j] = a[i][0] * b[0][j] + a[i][1] * b[1][j] + a[i][2] * b[2][j] + a[i][3] * b[3][j];
+		}
+	}
+}
+
+//ピクセル[first, last)のビット
+uint32_t RowMask(int first, int last){
+	if(last <= first){
+		return 0;
+	}
+	return static_cast<uint32_t>(((uint64_t{1} << last) - 1) & ~((uint64_t{1} << first) - 1));
+}
+}
+
+
+OcclusionCuller::OcclusionCuller():
+	width_{},
+	height_{},
+	tile_num_x_{},
+	tile_num_y_{},
+	view_proj_{},
+	tiles_{},
+	triangles_{}{}
+
+bool OcclusionCuller::Initialize(int width, int height){
+	if(width <= 0 || height <= 0 || width % TILE_WIDTH != 0 || height % TILE_HEIGHT != 0){
+		return false;
+	}
+
+	width_		= width;
+	height_		= height;
+	tile_num_x_	= width / TILE_WIDTH;
+	tile_num_y_	= height / TILE_HEIGHT;
+	tiles_.resize(static_cast<size_t>(tile_num_x_) * tile_num_y_);
+
+	const float identity[4][4] = {{1, 0, 0, 0}, {0, 1, 0, 0}, {0, 0, 1, 0}, {0, 0, 0, 1}};
+	BeginFrame(identity);
+	return true;
+}
+
+void OcclusionCuller::BeginFrame(const float view_proj[4][4]){
+	for(int i = 0; i < 4; ++i){
+		for(int j = 0; j < 4; ++j){
+			view_proj_[i][j] = view_proj[i][j];
+		}
+	}
+
+	//何も描いていないタイルは全体が最も奥
+	for(Tile &tile : tiles_){
+		std::fill(tile.mask, tile.mask + TILE_HEIGHT, 0u);
+		tile.z_max[0] = 1.0f;
+		tile.z_max[1] = 0.0f;
+	}
+	triangles_.clear();
+}
+
+//クリップ座標で近クリップ面(z >= 0)の手前を切り落とし、残った多角形を三角形に分ける
+void OcclusionCuller::AddOccluder(const float *vertices, const uint32_t *indices, int triangle_num, const float world[4][4], bool two_sided){
+	float world_view_proj[4][4];
+	if(world != nullptr){
+		Multiply(world, view_proj_, world_view_proj);
+	}
+	const float (*m)[4] = (world != nullptr) ? world_view_proj : view_proj_;
+
+	for(int t = 0; t < triangle_num; ++t){
+		float in[3][4];
+		int front_num = 0;
+		for(int k = 0; k < 3; ++k){
+			Transform(&vertices[indices[t * 3 + k] * 3], m, in[k]);
+			front_num += (in[k][2] >= 0.0f) ? 1 : 0;
+		}
+		if(front_num == 0){
+			continue;
+		}
+		if(front_num == 3){
+			SetupTriangle(in, two_sided);
+			continue;
+		}
+
+		//三角形を1つの平面で切ると多くて4頂点になる
+		float out[4][4];
+		int out_num = 0;
+		for(int k = 0; k < 3; ++k){
+			const float *a = in[k];
+			const float *b = in[(k + 1) % 3];
+			if(a[2] >= 0.0f){
+				std::copy(a, a + 4, out[out_num++]);
+			}
+			if((a[2] >= 0.0f) != (b[2] >= 0.0f)){
+				const float s = a[2] / (a[2] - b[2]);
+				for(int c = 0; c < 4; ++c){
+					out[out_num][c] = a[c] + (b[c] - a[c]) * s;
+				}
+				out[out_num][2] = 0.0f;
+				++out_num;
+			}
+		}
+		for(int k = 1; k + 1 < out_num; ++k){
+			const float clip[3][4] = {
+				{out[0][0], out[0][1], out[0][2], out[0][3]},
+				{out[k][0], out[k][1], out[k][2], out[k][3]},
+				{out[k + 1][0], out[k + 1][1], out[k + 1][2], out[k + 1][3]},
+			};
+			SetupTriangle(clip, two_sided);
+		}
+	}
+}
+
+//辺の式 a * x + b * y + c >= 0 (内側が正)を、行ごとの左端・右端の式に直す
+//ピクセルは中心が三角形の中にあれば塗る(隣り合う三角形の間に隙間ができない)
+void OcclusionCuller::SetupTriangle(const float clip[3][4], bool two_sided){
+	float x[3], y[3], z[3];
+	for(int k = 0; k < 3; ++k){
+		if(clip[k][3] <= 0.0f){
+			return;
+		}
+		const float inv_w = 1.0f / clip[k][3];
+		x[k] = (clip[k][0] * inv_w * 0.5f + 0.5f) * width_;
+		y[k] = (0.5f - clip[k][1] * inv_w * 0.5f) * height_;
+		z[k] = clip[k][2] * inv_w;
+	}
+
+	//画面はyが下向きなので、時計回り(表向き)なら正になる
+	const float area = (x[1] - x[0]) * (y[2] - y[0]) - (x[2] - x[0]) * (y[1] - y[0]);
+	if(area == 0.0f || (!two_sided && area < 0.0f)){
+		return;
+	}
+
+	//中心が外接矩形の中にあるピクセル
+	const float min_x = std::max(std::min(std::min(x[0], x[1]), x[2]), 0.0f);
+	const float max_x = std::min(std::max(std::max(x[0], x[1]), x[2]), static_cast<float>(width_));
+	const float min_y = std::max(std::min(std::min(y[0], y[1]), y[2]), 0.0f);
+	const float max_y = std::min(std::max(std::max(y[0], y[1]), y[2]), static_cast<float>(height_));
+	const int pixel_x0 = static_cast<int>(std::ceil(min_x - 0.5f));
+	const int pixel_x1 = static_cast<int>(std::floor(max_x - 0.5f)) + 1;
+	int pixel_y0 = static_cast<int>(std::ceil(min_y - 0.5f));
+	int pixel_y1 = static_cast<int>(std::floor(max_y - 0.5f)) + 1;
+	if(pixel_x0 >= pixel_x1 || pixel_y0 >= pixel_y1){
+		return;
+	}
+
+	Triangle tri{};
+	int left_num = 0;
+	int right_num = 0;
+
+	//内側が正になる向きにそろえる
+	const float sign = (area > 0.0f) ? -1.0f : 1.0f;
+	for(int k = 0; k < 3; ++k){
+		const int n = (k + 1) % 3;
+		const float a = sign * (y[n] - y[k]);
+		const float b = -sign * (x[n] - x[k]);
+		const float c = -(a * x[k] + b * y[k]);
+
+		if(a > 0.0f){
+			tri.left[left_num][0]	= -c / a;
+			tri.left[left_num][1]	= -b / a;
+			++left_num;
+		}else if(a < 0.0f){
+			tri.right[right_num][0]	= -c / a;
+			tri.right[right_num][1]	= -b / a;
+			++right_num;
+		}else{
+			//水平な辺は行の中心のyの範囲を制限する
+			const float bound = -c / b;
+			const float row = (b > 0.0f) ? std::ceil(std::min(std::max(bound - 0.5f, -1.0f), static_cast<float>(height_)))
+										 : std::floor(std::min(std::max(bound - 0.5f, -1.0f), static_cast<float>(height_))) + 1.0f;
+			if(b > 0.0f){
+				pixel_y0 = std::max(pixel_y0, static_cast<int>(row));
+			}else{
+				pixel_y1 = std::min(pixel_y1, static_cast<int>(row));
+			}
+		}
+	}
+	if(pixel_y0 >= pixel_y1){
+		return;
+	}
+	for(int k = left_num; k < 3; ++k){
+		tri.left[k][0]	= -UNBOUNDED;
+		tri.left[k][1]	= 0.0f;
+	}
+	for(int k = right_num; k < 3; ++k){
+		tri.right[k][0]	= UNBOUNDED;
+		tri.right[k][1]	= 0.0f;
+	}
+
+	//深度は画面上で線形
+	tri.z[0]	= ((z[1] - z[0]) * (y[2] - y[0]) - (z[2] - z[0]) * (y[1] - y[0])) / area;
+	tri.z[1]	= ((x[1] - x[0]) * (z[2] - z[0]) - (x[2] - x[0]) * (z[1] - z[0])) / area;
+	tri.z[2]	= z[0] - tri.z[0] * x[0] - tri.z[1] * y[0];
+	tri.z_max	= std::max(std::max(z[0], z[1]), z[2]);
+
+	tri.row_begin	= pixel_y0;
+	tri.row_end		= pixel_y1;
+	tri.tile_x0		= pixel_x0 / TILE_WIDTH;
+	tri.tile_x1		= (pixel_x1 - 1) / TILE_WIDTH + 1;
+	tri.tile_y0		= pixel_y0 / TILE_HEIGHT;
+	tri.tile_y1		= (pixel_y1 - 1) / TILE_HEIGHT + 1;
+	triangles_.push_back(tri);
+}
+
+void OcclusionCuller::Rasterize(JobSystem *jobs){
+	if(triangles_.empty()){
+		return;
+	}
+
+	if(jobs == nullptr || triangles_.size() < MIN_PARALLEL_TRIANGLE_NUM || tile_num_y_ < 2){
+		RasterizeTiles(0, tile_num_y_);
+	}else{
+		//タイルの行を帯に分け、スレッド数の数倍にして負荷を均す
+		const int band_num	= std::min(tile_num_y_, static_cast<int>(jobs->ThreadNum()) * 2);
+		const int band_rows	= (tile_num_y_ + band_num - 1) / band_num;
+
+		std::vector<std::future<void>> results;
+		for(int begin = 0; begin < tile_num_y_; begin += band_rows){
+			const int end = std::min(tile_num_y_, begin + band_rows);
+			results.push_back(jobs->Push([this, begin, end]{RasterizeTiles(begin, end);}));
+		}
+		for(auto &r : results){
+			r.get();
+		}
+	}
+
+	triangles_.clear();
+}
+
+//タイルごとの三角形の順は溜めた順のまま(帯に分けても結果は変わらない)
+void OcclusionCuller::RasterizeTiles(int tile_y_begin, int tile_y_end){
+	for(const Triangle &tri : triangles_){
+		const int y0 = std::max(tri.tile_y0, tile_y_begin);
+		const int y1 = std::min(tri.tile_y1, tile_y_end);
+		for(int ty = y0; ty < y1; ++ty){
+			for(int tx = tri.tile_x0; tx < tri.tile_x1; ++tx){
+				RasterizeTile(tri, tx, ty);
+			}
+		}
+	}
+}
+
+void OcclusionCuller::RasterizeTile(const Triangle &tri, int tile_x, int tile_y){
+	const int base_x = tile_x * TILE_WIDTH;
+	const int base_y = tile_y * TILE_HEIGHT;
+
+	//行ごとに 左端の最大 <= ピクセルの中心 <= 右端の最小 となるピクセルの範囲を求める
+	int32_t first[TILE_HEIGHT];
+	int32_t last[TILE_HEIGHT];
+	const FloatN center_x	= Splat(base_x + 0.5f);
+	const FloatN zero		= Splat(0.0f);
+	const FloatN one		= Splat(1.0f);
+	const FloatN width		= Splat(static_cast<float>(TILE_WIDTH));
+	for(int r = 0; r < TILE_HEIGHT; r += LANE_NUM){
+		const FloatN y = Splat(base_y + 0.5f) + Load(&ROW_OFFSETS[r]);
+
+		FloatN start	= Splat(tri.left[0][0]) + Splat(tri.left[0][1]) * y;
+		FloatN end		= Splat(tri.right[0][0]) + Splat(tri.right[0][1]) * y;
+		for(int k = 1; k < 3; ++k){
+			start	= Max(start, Splat(tri.left[k][0]) + Splat(tri.left[k][1]) * y);
+			end		= Min(end, Splat(tri.right[k][0]) + Splat(tri.right[k][1]) * y);
+		}
+
+		//タイルの中の位置にして、切り上げ・切り捨てを正の値の切り捨てで行う
+		const FloatN s = Min(Max(start - center_x, zero), width);
+		const FloatN e = Min(Max(end - center_x, zero - one), width - one);
+		StoreTruncated(&first[r], width - s);
+		StoreTruncated(&last[r], e + one);
+	}
+
+	uint32_t coverage[TILE_HEIGHT];
+	uint32_t covered = 0;
+	for(int r = 0; r < TILE_HEIGHT; ++r){
+		const int row = base_y + r;
+		coverage[r] = (row >= tri.row_begin && row < tri.row_end) ? RowMask(TILE_WIDTH - first[r], last[r]) : 0;
+		covered |= coverage[r];
+	}
+	if(covered == 0){
+		return;
+	}
+
+	//タイルの範囲での深度の最大(平面は角で最大になる)
+	const float corner_x = (tri.z[0] > 0.0f) ? static_cast<float>(base_x + TILE_WIDTH) : static_cast<float>(base_x);
+	const float corner_y = (tri.z[1] > 0.0f) ? static_cast<float>(base_y + TILE_HEIGHT) : static_cast<float>(base_y);
+	const float z = std::min(tri.z_max, tri.z[0] * corner_x + tri.z[1] * corner_y + tri.z[2]);
+
+	Tile &tile = tiles_[static_cast<size_t>(tile_y) * tile_num_x_ + tile_x];
+	if(z >= tile.z_max[0]){
+		return;
+	}
+
+	//三角形が作業中の層から離れている方が作業中の層と参照の層の間より遠ければ、作業中の層を捨てて三角形だけにする
+	if(z - tile.z_max[1] > tile.z_max[0] - tile.z_max[1]){
+		std::fill(tile.mask, tile.mask + TILE_HEIGHT, 0u);
+		tile.z_max[1] = 0.0f;
+	}
+
+	tile.z_max[1] = std::max(tile.z_max[1], z);
+	uint32_t full = FULL_ROW;
+	for(int r = 0; r < TILE_HEIGHT; ++r){
+		tile.mask[r] |= coverage[r];
+		full &= tile.mask[r];
+	}
+
+	//作業中の層でタイルが埋まったら参照の層にする
+	if(full == FULL_ROW){
+		tile.z_max[0] = tile.z_max[1];
+		tile.z_max[1] = 0.0f;
+		std::fill(tile.mask, tile.mask + TILE_HEIGHT, 0u);
+	}
+}
+
+OcclusionCuller::Result OcclusionCuller::TestBox(const float min[3], const float max[3]) const{
+	float x0 = UNBOUNDED, y0 = UNBOUNDED, x1 = -UNBOUNDED, y1 = -UNBOUNDED, z_min = UNBOUNDED;
+	int front_num = 0;
+	for(int i = 0; i < 8; ++i){
+		const float p[3] = {(i & 1) ? max[0] : min[0], (i & 2) ? max[1] : min[1], (i & 4) ? max[2] : min[2]};
+		float clip[4];
+		Transform(p, view_proj_, clip);
+		if(clip[2] < 0.0f || clip[3] <= 0.0f){
+			continue;
+		}
+		++front_num;
+
+		const float inv_w = 1.0f / clip[3];
+		const float sx = (clip[0] * inv_w * 0.5f + 0.5f) * width_;
+		const float sy = (0.5f - clip[1] * inv_w * 0.5f) * height_;
+		x0		= std::min(x0, sx);
+		x1		= std::max(x1, sx);
+		y0		= std::min(y0, sy);
+		y1		= std::max(y1, sy);
+		z_min	= std::min(z_min, clip[2] * inv_w);
+	}
+
+	//全ての角が近クリップ面の手前なら見えない。一部だけなら画面上の範囲が求まらないので見えるとする
+	if(front_num == 0){
+		return RESULT_VIEW_CULLED;
+	}
+	if(front_num < 8){
+		return RESULT_VISIBLE;
+	}
+	return TestRect(x0, y0, x1, y1, z_min);
+}
+
+//矩形の掛かるピクセルの深度の上限のどれかより手前なら見える
+OcclusionCuller::Result OcclusionCuller::TestRect(float x0, float y0, float x1, float y1, float z_min) const{
+	if(x1 < 0.0f || y1 < 0.0f || x0 >= width_ || y0 >= height_ || x1 < x0 || y1 < y0 || z_min > 1.0f){
+		return RESULT_VIEW_CULLED;
+	}
+
+	const int pixel_x0 = std::max(static_cast<int>(std::floor(x0)), 0);
+	const int pixel_x1 = std::min(static_cast<int>(std::floor(x1)) + 1, width_);
+	const int pixel_y0 = std::max(static_cast<int>(std::floor(y0)), 0);
+	const int pixel_y1 = std::min(static_cast<int>(std::floor(y1)) + 1, height_);
+
+	for(int ty = pixel_y0 / TILE_HEIGHT; ty <= (pixel_y1 - 1) / TILE_HEIGHT; ++ty){
+		const int row0 = std::max(pixel_y0 - ty * TILE_HEIGHT, 0);
+		const int row1 = std::min(pixel_y1 - ty * TILE_HEIGHT, TILE_HEIGHT);
+		for(int tx = pixel_x0 / TILE_WIDTH; tx <= (pixel_x1 - 1) / TILE_WIDTH; ++tx){
+			const Tile &tile = tiles_[static_cast<size_t>(ty) * tile_num_x_ + tx];
+
+			//タイル全体の上限より奥なら、中のピクセルを調べなくてよい
+			if(z_min > tile.z_max[0]){
+				continue;
+			}
+
+			const uint32_t columns = RowMask(std::max(pixel_x0 - tx * TILE_WIDTH, 0), std::min(pixel_x1 - tx * TILE_WIDTH, TILE_WIDTH));
+			const bool in_front_of_mask = (z_min <= tile.z_max[1]);
+			for(int r = row0; r < row1; ++r){
+				if((columns & ~tile.mask[r]) != 0 || (in_front_of_mask && (columns & tile.mask[r]) != 0)){
+					return RESULT_VISIBLE;
+				}
+			}
+		}
+	}
+	return RESULT_OCCLUDED;
+}
+
+float OcclusionCuller::DepthBound(int x, int y) const{
+	const Tile &tile = tiles_[static_cast<size_t>(y / TILE_HEIGHT) * tile_num_x_ + x / TILE_WIDTH];
+	return ((tile.mask[y % TILE_HEIGHT] >> (x % TILE_WIDTH)) & 1) ? tile.z_max[1] : tile.z_max[0];
+}
+
+const char* OcclusionCuller::InstructionSet(){
+#if defined(OCCLUSION_CULLER_AVX)
+	return "AVX";
+#elif defined(OCCLUSION_CULLER_SSE2)
+	return "SSE2";
+#elif defined(OCCLUSION_CULLER_NEON)
+	return "NEON";
+#else
+	return "scalar";
+#endif
+}
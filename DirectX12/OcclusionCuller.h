@@ -0,0 +1,102 @@
+#ifndef OCCLUSION_CULLER_HEADER_
+#define OCCLUSION_CULLER_HEADER_
+
+#include <cstdint>
+#include <vector>
+
+class JobSystem;
+
+//CPUの低解像度の深度バッファによる遮蔽カリング(Masked Occlusion Culling の形)
+//・画面を32x8ピクセルのタイルに分け、タイルごとに全体の深度の上限(参照の層)と、
+//  ビットマスクで示すピクセルだけの深度の上限(作業中の層)の2つを持つ。作業中の層でタイルが埋まれば参照の層に移す
+//・遮蔽物の三角形は中心が中に入るピクセルを塗り、深度はタイルの範囲での最も奥を使う(深度は保守的)
+//  遮蔽物の輪郭から1ピクセル未満はみ出すだけのものは、遮蔽されたと判定することがある
+//・三角形の左右の辺からタイルの行ごとの範囲をSIMDで求め、行のビットマスクにする
+//・遮蔽物の描画は画面を横長の帯に分けてジョブで並列に行う(帯ごとに担当するタイルが別なので結果は1スレッドと同じ)
+//
+//行列はDirectXMathと同じく行ベクトルに右から掛ける並びで、深度は[0, 1](小さい方が手前)
+//使い方: BeginFrame → AddOccluder(遮蔽物ごと) → Rasterize → TestBox
+class OcclusionCuller{
+public:
+	static constexpr int TILE_WIDTH		= 32;	//タイルの1行をuint32_tのビットマスクで持つ
+	static constexpr int TILE_HEIGHT	= 8;
+	static constexpr int DEFAULT_WIDTH	= 320;
+	static constexpr int DEFAULT_HEIGHT	= 240;
+	static constexpr int MIN_PARALLEL_TRIANGLE_NUM = 256;	//これより少ない三角形はジョブに分けない
+
+	enum Result{
+		RESULT_VISIBLE,		//見える(遮蔽されていると言い切れない)
+		RESULT_OCCLUDED,	//遮蔽物の後ろにある
+		RESULT_VIEW_CULLED,	//画面の外にある
+	};
+
+public:
+	OcclusionCuller();
+	~OcclusionCuller(){}
+
+	//幅はTILE_WIDTH、高さはTILE_HEIGHTの倍数
+	bool Initialize(int width = DEFAULT_WIDTH, int height = DEFAULT_HEIGHT);
+
+	//深度バッファを空にし、今フレームのビュー・プロジェクション行列を設定する
+	void BeginFrame(const float view_proj[4][4]);
+
+	//verticesは3つずつの座標、indicesは三角形ごとに3つの添字。worldはnullptrなら単位行列
+	//近クリップ面で切り、画面上の三角形にして溜めておく
+	//表向きはD3D12の既定と同じく画面上で時計回りで、two_sidedがfalseなら裏向きの三角形は捨てる(背面カリングして描くものに合わせる)
+	void AddOccluder(const float *vertices, const uint32_t *indices, int triangle_num, const float world[4][4] = nullptr, bool two_sided = false);
+
+	//溜めた三角形を深度バッファに描く(jobsがnullptrなら1スレッドで行う)
+	void Rasterize(JobSystem *jobs = nullptr);
+
+	//ワールド座標の軸に平行な箱を調べる。近クリップ面に掛かるものは見えるとする
+	Result TestBox(const float min[3], const float max[3]) const;
+
+	//画面上の矩形(ピクセル単位)のうち最も手前の深度がz_minのものを調べる
+	Result TestRect(float x0, float y0, float x1, float y1, float z_min) const;
+
+	//ピクセルの深度の上限(これより奥は遮蔽されている)
+	float DepthBound(int x, int y) const;
+
+	int Width() const{return width_;}
+	int Height() const{return height_;}
+	int TriangleNum() const{return static_cast<int>(triangles_.size());}
+
+	//行の範囲を求めるのに使う命令セット(AVX, SSE2, NEON, scalar)
+	static const char* InstructionSet();
+
+private:
+	//タイルの深度(z_max[0]はタイル全体、z_max[1]はmaskのピクセルの上限。maskが空なら0)
+	struct Tile{
+		uint32_t	mask[TILE_HEIGHT];
+		float		z_max[2];
+	};
+
+	//画面上の三角形。辺は行の中心のyに対する左端・右端の x = offset + slope * y として持つ(使わないものは範囲を制限しない値)
+	struct Triangle{
+		float	left[3][2];
+		float	right[3][2];
+		float	z[3];			//深度の平面 z = z[0] * x + z[1] * y + z[2]
+		float	z_max;			//頂点の深度の最大
+		int		row_begin;		//塗る行の範囲(水平な辺で決まる)
+		int		row_end;
+		int		tile_x0;		//掛かるタイルの範囲
+		int		tile_y0;
+		int		tile_x1;
+		int		tile_y1;
+	};
+
+	void SetupTriangle(const float clip[3][4], bool two_sided);
+	void RasterizeTiles(int tile_y_begin, int tile_y_end);
+	void RasterizeTile(const Triangle &tri, int tile_x, int tile_y);
+
+private:
+	int						width_;
+	int						height_;
+	int						tile_num_x_;
+	int						tile_num_y_;
+	float					view_proj_[4][4];
+	std::vector<Tile>		tiles_;
+	std::vector<Triangle>	triangles_;
+};
+
+#endif
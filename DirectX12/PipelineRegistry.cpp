@@ -0,0 +1,111 @@
+#include <cstring>
+#include "PipelineRegistry.h"
+
+void PipelineKeyBuilder::AddBytes(const void *data, size_t size){
+	const unsigned char *p = static_cast<const unsigned char*>(data);
+	for(size_t i = 0; i < size; ++i){
+		hash_ ^= p[i];
+		hash_ *= 1099511628211ull;
+	}
+}
+
+void PipelineKeyBuilder::AddString(const char *str){
+	if(str == nullptr){
+		AddBytes("", 1);
+		return;
+	}
+	AddBytes(str, strlen(str) + 1);
+}
+
+
+PipelineRegistry::PipelineRegistry():
+	mutex_{},
+	entries_{},
+	index_{},
+	stats_{}{}
+
+PipelineRegistry::Handle PipelineRegistry::Register(uint64_t key, Handle fallback, bool *added){
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	++stats_.request_num;
+	const auto it = index_.find(key);
+	if(it != index_.end()){
+		++stats_.dedup_num;
+		*added = false;
+		return it->second;
+	}
+
+	//フォールバックは登録済みのものに限る(循環しないように)
+	if(fallback >= entries_.size()){
+		fallback = INVALID_HANDLE;
+	}
+	const Handle handle = static_cast<Handle>(entries_.size());
+	entries_.push_back({key, fallback, STATE_PENDING});
+	index_.emplace(key, handle);
+	*added = true;
+	return handle;
+}
+
+void PipelineRegistry::Clear(){
+	std::lock_guard<std::mutex> lock(mutex_);
+	entries_.clear();
+	index_.clear();
+	stats_ = {};
+}
+
+void PipelineRegistry::SetState(Handle handle, State state){
+	std::lock_guard<std::mutex> lock(mutex_);
+	if(handle < entries_.size()){
+		entries_[handle].state = state;
+	}
+}
+
+PipelineRegistry::State PipelineRegistry::GetState(Handle handle) const{
+	std::lock_guard<std::mutex> lock(mutex_);
+	return (handle < entries_.size()) ? entries_[handle].state : STATE_FAILED;
+}
+
+uint64_t PipelineRegistry::GetKey(Handle handle) const{
+	std::lock_guard<std::mutex> lock(mutex_);
+	return (handle < entries_.size()) ? entries_[handle].key : 0;
+}
+
+PipelineRegistry::Handle PipelineRegistry::Find(uint64_t key) const{
+	std::lock_guard<std::mutex> lock(mutex_);
+	const auto it = index_.find(key);
+	return (it != index_.end()) ? it->second : INVALID_HANDLE;
+}
+
+PipelineRegistry::Handle PipelineRegistry::Resolve(Handle handle){
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	for(int depth = 0; depth <= MAX_FALLBACK_DEPTH && handle < entries_.size(); ++depth){
+		if(entries_[handle].state == STATE_READY){
+			if(depth > 0){
+				++stats_.fallback_num;
+			}
+			return handle;
+		}
+		handle = entries_[handle].fallback;
+	}
+	return INVALID_HANDLE;
+}
+
+int PipelineRegistry::Num() const{
+	std::lock_guard<std::mutex> lock(mutex_);
+	return static_cast<int>(entries_.size());
+}
+
+int PipelineRegistry::PendingNum() const{
+	std::lock_guard<std::mutex> lock(mutex_);
+	int num{};
+	for(const Entry &e : entries_){
+		num += (e.state == STATE_PENDING) ? 1 : 0;
+	}
+	return num;
+}
+
+PipelineRegistry::Stats PipelineRegistry::GetStats() const{
+	std::lock_guard<std::mutex> lock(mutex_);
+	return stats_;
+}
@@ -0,0 +1,82 @@
+#ifndef PIPELINE_REGISTRY_HEADER_
+#define PIPELINE_REGISTRY_HEADER_
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+//PSOの記述からキーを作る(FNV-1a 64bit)
+//ポインタの先は呼び出し側で中身を加えること(実行ごとに変わるアドレスをキーに含めない)
+class PipelineKeyBuilder{
+public:
+	PipelineKeyBuilder():hash_(14695981039346656037ull){}
+
+	void AddBytes(const void *data, size_t size);
+	void AddString(const char *str);	//終端の0まで含める
+	void AddU32(uint32_t v){AddBytes(&v, sizeof(v));}
+	void AddU64(uint64_t v){AddBytes(&v, sizeof(v));}
+
+	uint64_t Value() const{return hash_;}
+
+private:
+	uint64_t	hash_;
+};
+
+
+//キーで重複を除いたPSOの登録表(D3D12に依存しない部分)
+//作成が終わるまではフォールバックとして登録したPSOを代わりに使う
+class PipelineRegistry{
+public:
+	typedef uint32_t Handle;
+	static constexpr Handle INVALID_HANDLE = ~0u;
+	static constexpr int MAX_FALLBACK_DEPTH = 8;
+
+	enum State{
+		STATE_PENDING,	//作成中(ワーカースレッド)
+		STATE_READY,
+		STATE_FAILED,
+	};
+
+	struct Stats{
+		uint64_t	request_num;	//Registerの呼び出し回数
+		uint64_t	dedup_num;		//登録済みのキーだったもの
+		uint64_t	fallback_num;	//Resolveでフォールバックを返した回数
+	};
+
+public:
+	PipelineRegistry();
+	~PipelineRegistry(){}
+
+	//キーが登録済みなら既存のハンドルを返し、*addedをfalseにする
+	Handle Register(uint64_t key, Handle fallback, bool *added);
+	void Clear();
+
+	void SetState(Handle handle, State state);
+	State GetState(Handle handle) const;
+	uint64_t GetKey(Handle handle) const;
+	Handle Find(uint64_t key) const;
+
+	//使えるPSOのハンドルを返す(作成中・失敗ならフォールバックをたどる。なければINVALID_HANDLE)
+	Handle Resolve(Handle handle);
+
+	int Num() const;
+	int PendingNum() const;
+	Stats GetStats() const;
+
+private:
+	struct Entry{
+		uint64_t	key;
+		Handle		fallback;
+		State		state;
+	};
+
+private:
+	mutable std::mutex						mutex_;
+	std::vector<Entry>						entries_;
+	std::unordered_map<uint64_t, Handle>	index_;	//キーからハンドルを引く
+	Stats									stats_;
+};
+
+#endif
@@ -0,0 +1,342 @@
+#include <cstdio>
+#include <cwchar>
+#include "PipelineStateManager.h"
+#include "JobSystem.h"
+
+namespace{
+void AddShader(PipelineKeyBuilder *key, const D3D12_SHADER_BYTECODE &shader){
+	key->AddU64(shader.BytecodeLength);
+	if(shader.BytecodeLength > 0){
+		key->AddBytes(shader.pShaderBytecode, shader.BytecodeLength);
+	}
+}
+
+void AddStencilOp(PipelineKeyBuilder *key, const D3D12_DEPTH_STENCILOP_DESC &op){
+	key->AddU32(op.StencilFailOp);
+	key->AddU32(op.StencilDepthFailOp);
+	key->AddU32(op.StencilPassOp);
+	key->AddU32(op.StencilFunc);
+}
+
+//ライブラリ内の名前(キーの16進表記)
+void MakeLibraryName(uint64_t key, wchar_t (&name)[17]){
+	swprintf(name, 17, L"%016llx", static_cast<unsigned long long>(key));
+}
+
+bool ReadWholeFile(const char *file_name, std::vector<unsigned char> *data){
+	FILE *fp = fopen(file_name, "rb");
+	if(fp == nullptr){
+		return false;
+	}
+
+	bool ok = fseek(fp, 0, SEEK_END) == 0;
+	const long size = ok ? ftell(fp) : -1;
+	ok = ok && size > 0 && fseek(fp, 0, SEEK_SET) == 0;
+	if(ok){
+		data->resize(static_cast<size_t>(size));
+		ok = fread(data->data(), 1, data->size(), fp) == data->size();
+	}
+	fclose(fp);
+
+	if(!ok){
+		data->clear();
+	}
+	return ok;
+}
+}
+
+
+PipelineStateManager::PipelineStateManager():
+	device_{},
+	library_data_{},
+	library_{},
+	library_file_{},
+	library_dirty_(false),
+	jobs_(nullptr),
+	registry_{},
+	mutex_{},
+	pipelines_{},
+	root_signature_keys_{},
+	jobs_pending_{},
+	library_hit_num_{},
+	compile_num_{}{}
+
+PipelineStateManager::~PipelineStateManager(){
+	//ワーカースレッドがまだ作成中のPSOを待ってから解放する
+	WaitIdle();
+}
+
+HRESULT PipelineStateManager::Initialize(ID3D12Device *device, const char *library_file, JobSystem *jobs){
+	HRESULT hr;
+
+	device_ = device;
+	jobs_ = jobs;
+	library_file_ = (library_file != nullptr) ? library_file : "";
+
+	//パイプラインライブラリに対応していない場合はライブラリなしで続ける
+	ComPtr<ID3D12Device1> device1{};
+	if(FAILED(device->QueryInterface(IID_PPV_ARGS(&device1)))){
+		return S_OK;
+	}
+
+	//ファイルのライブラリはドライバやアダプタが変わると使えない(その場合は作り直す)
+	if(!library_file_.empty() && ReadWholeFile(library_file_.c_str(), &library_data_)){
+		hr = device1->CreatePipelineLibrary(library_data_.data(), library_data_.size(), IID_PPV_ARGS(&library_));
+		if(SUCCEEDED(hr)){
+			return S_OK;
+		}
+		library_data_.clear();
+	}
+
+	hr = device1->CreatePipelineLibrary(nullptr, 0, IID_PPV_ARGS(&library_));
+	if(FAILED(hr)){
+		library_.Reset();
+	}
+	return S_OK;
+}
+
+void PipelineStateManager::RegisterRootSignature(ID3D12RootSignature *root_signature, const void *serialized, size_t size){
+	PipelineKeyBuilder key;
+	key.AddBytes(serialized, size);
+
+	std::lock_guard<std::mutex> lock(mutex_);
+	root_signature_keys_[root_signature] = key.Value();
+}
+
+
+//ポインタの先(シェーダ・入力レイアウト・ルートシグネチャ)は中身でハッシュする
+//構造体の詰め物を含めないように、メンバは1つずつ加える
+uint64_t PipelineStateManager::HashDesc(const D3D12_GRAPHICS_PIPELINE_STATE_DESC &desc) const{
+	PipelineKeyBuilder key;
+
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		const auto it = root_signature_keys_.find(desc.pRootSignature);
+		key.AddU64(it != root_signature_keys_.end() ? it->second : 0);
+	}
+
+	AddShader(&key, desc.VS);
+	AddShader(&key, desc.PS);
+	AddShader(&key, desc.DS);
+	AddShader(&key, desc.HS);
+	AddShader(&key, desc.GS);
+	key.AddU32(desc.StreamOutput.NumEntries);
+
+	key.AddU32(desc.BlendState.AlphaToCoverageEnable);
+	key.AddU32(desc.BlendState.IndependentBlendEnable);
+	for(const D3D12_RENDER_TARGET_BLEND_DESC &rt : desc.BlendState.RenderTarget){
+		key.AddU32(rt.BlendEnable);
+		key.AddU32(rt.LogicOpEnable);
+		key.AddU32(rt.SrcBlend);
+		key.AddU32(rt.DestBlend);
+		key.AddU32(rt.BlendOp);
+		key.AddU32(rt.SrcBlendAlpha);
+		key.AddU32(rt.DestBlendAlpha);
+		key.AddU32(rt.BlendOpAlpha);
+		key.AddU32(rt.LogicOp);
+		key.AddU32(rt.RenderTargetWriteMask);
+	}
+	key.AddU32(desc.SampleMask);
+
+	const D3D12_RASTERIZER_DESC &rs = desc.RasterizerState;
+	key.AddU32(rs.FillMode);
+	key.AddU32(rs.CullMode);
+	key.AddU32(rs.FrontCounterClockwise);
+	key.AddBytes(&rs.DepthBias, sizeof(rs.DepthBias));
+	key.AddBytes(&rs.DepthBiasClamp, sizeof(rs.DepthBiasClamp));
+	key.AddBytes(&rs.SlopeScaledDepthBias, sizeof(rs.SlopeScaledDepthBias));
+	key.AddU32(rs.DepthClipEnable);
+	key.AddU32(rs.MultisampleEnable);
+	key.AddU32(rs.AntialiasedLineEnable);
+	key.AddU32(rs.ForcedSampleCount);
+	key.AddU32(rs.ConservativeRaster);
+
+	const D3D12_DEPTH_STENCIL_DESC &ds = desc.DepthStencilState;
+	key.AddU32(ds.DepthEnable);
+	key.AddU32(ds.DepthWriteMask);
+	key.AddU32(ds.DepthFunc);
+	key.AddU32(ds.StencilEnable);
+	key.AddU32(ds.StencilReadMask);
+	key.AddU32(ds.StencilWriteMask);
+	AddStencilOp(&key, ds.FrontFace);
+	AddStencilOp(&key, ds.BackFace);
+
+	key.AddU32(desc.InputLayout.NumElements);
+	for(UINT i = 0; i < desc.InputLayout.NumElements; ++i){
+		const D3D12_INPUT_ELEMENT_DESC &e = desc.InputLayout.pInputElementDescs[i];
+		key.AddString(e.SemanticName);
+		key.AddU32(e.SemanticIndex);
+		key.AddU32(e.Format);
+		key.AddU32(e.InputSlot);
+		key.AddU32(e.AlignedByteOffset);
+		key.AddU32(e.InputSlotClass);
+		key.AddU32(e.InstanceDataStepRate);
+	}
+
+	key.AddU32(desc.IBStripCutValue);
+	key.AddU32(desc.PrimitiveTopologyType);
+	key.AddU32(desc.NumRenderTargets);
+	for(UINT i = 0; i < desc.NumRenderTargets && i < 8; ++i){
+		key.AddU32(desc.RTVFormats[i]);
+	}
+	key.AddU32(desc.DSVFormat);
+	key.AddU32(desc.SampleDesc.Count);
+	key.AddU32(desc.SampleDesc.Quality);
+	key.AddU32(desc.NodeMask);
+	key.AddU32(desc.Flags);
+
+	return key.Value();
+}
+
+
+PipelineStateManager::Handle PipelineStateManager::Request(const D3D12_GRAPHICS_PIPELINE_STATE_DESC &desc, bool async, Handle fallback){
+	const uint64_t key = HashDesc(desc);
+
+	bool added{};
+	const Handle handle = registry_.Register(key, fallback, &added);
+	if(!added){
+		return handle;
+	}
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		if(pipelines_.size() <= handle){
+			pipelines_.resize(handle + 1);
+		}
+	}
+
+
+	//ポインタの先をコピーして、呼び出し元の記述が破棄されても作成できるようにする
+	std::shared_ptr<DescCopy> copy = std::make_shared<DescCopy>();
+	copy->desc = desc;
+	copy->root_signature = desc.pRootSignature;
+
+	D3D12_SHADER_BYTECODE *shaders[5] = {&copy->desc.VS, &copy->desc.PS, &copy->desc.DS, &copy->desc.HS, &copy->desc.GS};
+	for(int i = 0; i < 5; ++i){
+		const unsigned char *src = static_cast<const unsigned char*>(shaders[i]->pShaderBytecode);
+		copy->shaders[i].assign(src, src + shaders[i]->BytecodeLength);
+		shaders[i]->pShaderBytecode = copy->shaders[i].empty() ? nullptr : copy->shaders[i].data();
+	}
+
+	copy->elements.assign(desc.InputLayout.pInputElementDescs, desc.InputLayout.pInputElementDescs + desc.InputLayout.NumElements);
+	copy->semantic_names.resize(copy->elements.size());
+	for(size_t i = 0; i < copy->elements.size(); ++i){
+		copy->semantic_names[i] = copy->elements[i].SemanticName;
+		copy->elements[i].SemanticName = copy->semantic_names[i].c_str();
+	}
+	copy->desc.InputLayout.pInputElementDescs = copy->elements.empty() ? nullptr : copy->elements.data();
+
+	if(!async || jobs_ == nullptr){
+		Create(handle, key, *copy);
+		return handle;
+	}
+
+	std::future<HRESULT> job = jobs_->Push([this, handle, key, copy]{return Create(handle, key, *copy);});
+	std::lock_guard<std::mutex> lock(mutex_);
+	jobs_pending_.push_back(std::move(job));
+	return handle;
+}
+
+//ライブラリにあれば読み込み、なければドライバでコンパイルしてライブラリに加える
+HRESULT PipelineStateManager::Create(Handle handle, uint64_t key, const DescCopy &copy){
+	HRESULT hr = E_FAIL;
+	ComPtr<ID3D12PipelineState> pipeline{};
+
+	wchar_t name[17];
+	MakeLibraryName(key, name);
+
+	bool loaded = false;
+	if(library_ != nullptr){
+		loaded = SUCCEEDED(library_->LoadGraphicsPipeline(name, &copy.desc, IID_PPV_ARGS(&pipeline)));
+	}
+
+	if(!loaded){
+		hr = device_->CreateGraphicsPipelineState(&copy.desc, IID_PPV_ARGS(&pipeline));
+		if(FAILED(hr)){
+			registry_.SetState(handle, PipelineRegistry::STATE_FAILED);
+			return hr;
+		}
+		if(library_ != nullptr && SUCCEEDED(library_->StorePipeline(name, pipeline.Get()))){
+			std::lock_guard<std::mutex> lock(mutex_);
+			library_dirty_ = true;
+		}
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		pipelines_[handle] = pipeline;
+		++(loaded ? library_hit_num_ : compile_num_);
+	}
+
+	//PSOを置いてから公開する
+	registry_.SetState(handle, PipelineRegistry::STATE_READY);
+	return S_OK;
+}
+
+ID3D12PipelineState* PipelineStateManager::Get(Handle handle){
+	const Handle resolved = registry_.Resolve(handle);
+	if(resolved == INVALID_HANDLE){
+		return nullptr;
+	}
+
+	std::lock_guard<std::mutex> lock(mutex_);
+	return pipelines_[resolved].Get();
+}
+
+bool PipelineStateManager::IsReady(Handle handle) const{
+	return registry_.GetState(handle) == PipelineRegistry::STATE_READY;
+}
+
+void PipelineStateManager::WaitIdle(){
+	std::vector<std::future<HRESULT>> jobs;
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		jobs.swap(jobs_pending_);
+	}
+	for(std::future<HRESULT> &job : jobs){
+		job.wait();
+	}
+}
+
+HRESULT PipelineStateManager::Save(){
+	HRESULT hr;
+
+	WaitIdle();
+
+	std::lock_guard<std::mutex> lock(mutex_);
+	if(library_ == nullptr || !library_dirty_ || library_file_.empty()){
+		return S_OK;
+	}
+
+	std::vector<unsigned char> data(library_->GetSerializedSize());
+	hr = library_->Serialize(data.data(), data.size());
+	if(FAILED(hr)){
+		return hr;
+	}
+
+	FILE *fp = fopen(library_file_.c_str(), "wb");
+	if(fp == nullptr){
+		return E_FAIL;
+	}
+	bool ok = fwrite(data.data(), 1, data.size(), fp) == data.size();
+	ok = (fclose(fp) == 0) && ok;
+	if(!ok){
+		remove(library_file_.c_str());
+		return E_FAIL;
+	}
+
+	library_dirty_ = false;
+	return S_OK;
+}
+
+PipelineStateManager::Stats PipelineStateManager::GetStats() const{
+	const PipelineRegistry::Stats registry = registry_.GetStats();
+
+	std::lock_guard<std::mutex> lock(mutex_);
+	Stats stats{};
+	stats.request_num		= registry.request_num;
+	stats.dedup_num			= registry.dedup_num;
+	stats.library_hit_num	= library_hit_num_;
+	stats.compile_num		= compile_num_;
+	stats.fallback_num		= registry.fallback_num;
+	return stats;
+}
@@ -0,0 +1,92 @@
+#ifndef PIPELINE_STATE_MANAGER_HEADER_
+#define PIPELINE_STATE_MANAGER_HEADER_
+
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <d3d12.h>
+#include <wrl/client.h>
+#include "PipelineRegistry.h"
+
+using namespace Microsoft::WRL;
+
+class JobSystem;
+
+//PSOの作成と管理
+//記述のハッシュで同じPSOをまとめ、ドライバがコンパイルした結果をID3D12PipelineLibraryでファイルに残す
+//非同期で要求したPSOはワーカースレッドで作成し、それまではフォールバックのPSOを返す
+class PipelineStateManager{
+public:
+	typedef PipelineRegistry::Handle Handle;
+	static constexpr Handle INVALID_HANDLE = PipelineRegistry::INVALID_HANDLE;
+
+	struct Stats{
+		uint64_t	request_num;	//Requestの呼び出し回数
+		uint64_t	dedup_num;		//作成済み・作成中のPSOを返したもの
+		uint64_t	library_hit_num;	//ライブラリから読み込めたもの
+		uint64_t	compile_num;	//ドライバでコンパイルしたもの
+		uint64_t	fallback_num;	//作成中のためフォールバックを返した回数
+	};
+
+public:
+	PipelineStateManager();
+	~PipelineStateManager();
+
+	//library_fileが読めない・ドライバが変わった場合は空のライブラリから始める
+	//ライブラリに対応していない環境ではファイルを使わずに毎回作成する
+	HRESULT Initialize(ID3D12Device *device, const char *library_file, JobSystem *jobs);
+
+	//ルートシグネチャはアドレスではなくシリアライズした内容でキーに含める
+	void RegisterRootSignature(ID3D12RootSignature *root_signature, const void *serialized, size_t size);
+
+	//記述はこの関数の中でコピーするので、呼び出し後に破棄してよい
+	//asyncがtrueならワーカースレッドで作成し、完了までGetはfallbackを返す
+	Handle Request(const D3D12_GRAPHICS_PIPELINE_STATE_DESC &desc, bool async, Handle fallback = INVALID_HANDLE);
+
+	//使えるPSOを返す(作成中でフォールバックもない場合・作成に失敗した場合はnullptr)
+	ID3D12PipelineState* Get(Handle handle);
+	bool IsReady(Handle handle) const;
+
+	//非同期の作成が全て終わるのを待つ
+	void WaitIdle();
+
+	//新しく作成したPSOがあればライブラリをファイルに書き出す
+	HRESULT Save();
+
+	uint64_t HashDesc(const D3D12_GRAPHICS_PIPELINE_STATE_DESC &desc) const;
+	Stats GetStats() const;
+
+private:
+	//非同期の作成まで記述のポインタの先を保持する
+	struct DescCopy{
+		D3D12_GRAPHICS_PIPELINE_STATE_DESC		desc;
+		std::vector<unsigned char>				shaders[5];
+		std::vector<D3D12_INPUT_ELEMENT_DESC>	elements;
+		std::vector<std::string>				semantic_names;
+		ComPtr<ID3D12RootSignature>				root_signature;
+	};
+
+	HRESULT Create(Handle handle, uint64_t key, const DescCopy &copy);
+
+private:
+	ComPtr<ID3D12Device>			device_;
+	std::vector<unsigned char>		library_data_;	//ライブラリが参照するので破棄するまで保持する(library_より先に宣言する)
+	ComPtr<ID3D12PipelineLibrary>	library_;
+	std::string						library_file_;
+	bool							library_dirty_;
+	JobSystem						*jobs_;
+
+	PipelineRegistry				registry_;
+
+	mutable std::mutex									mutex_;
+	std::vector<ComPtr<ID3D12PipelineState>>			pipelines_;			//ハンドルごとのPSO
+	std::unordered_map<ID3D12RootSignature*, uint64_t>	root_signature_keys_;
+	std::vector<std::future<HRESULT>>					jobs_pending_;
+	uint64_t											library_hit_num_;
+	uint64_t											compile_num_;
+};
+
+#endif
@@ -1,205 +1,204 @@
-#include <vector>
-#include <fstream>
-#include "Plane.h"
-#include "D3D12Manager.h"
-
-Plane::Plane():
-	vertex_buffer_{},
-	constant_buffer_{},
-	texture_{},
-	dh_texture_{}{}
-
-HRESULT Plane::Initialize(ID3D12Device *device, ID3D12Resource *sm){
-	HRESULT hr{};
-	D3D12_HEAP_PROPERTIES heap_properties{};
-	D3D12_RESOURCE_DESC   resource_desc{};
-	
-	heap_properties.Type					= D3D12_HEAP_TYPE_UPLOAD;
-	heap_properties.CPUPageProperty			= D3D12_CPU_PAGE_PROPERTY_UNKNOWN;
-	heap_properties.MemoryPoolPreference	= D3D12_MEMORY_POOL_UNKNOWN;
-	heap_properties.CreationNodeMask		= 0;
-	heap_properties.VisibleNodeMask			= 0;
-
-	resource_desc.Dimension				= D3D12_RESOURCE_DIMENSION_BUFFER;
-	resource_desc.Width					= 256;
-	resource_desc.Height				= 1;
-	resource_desc.DepthOrArraySize		= 1;
-	resource_desc.MipLevels				= 1;
-	resource_desc.Format				= DXGI_FORMAT_UNKNOWN;
-	resource_desc.Layout				= D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
-	resource_desc.SampleDesc.Count		= 1;
-	resource_desc.SampleDesc.Quality	= 0;
-
-	//_obt@̍쐬
-	hr = device->CreateCommittedResource(&heap_properties, D3D12_HEAP_FLAG_NONE, &resource_desc, D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(&vertex_buffer_));
-	if(FAILED(hr)){
-		return hr;
-	}
-
-	//萔obt@̍쐬
-	hr = device->CreateCommittedResource(&heap_properties, D3D12_HEAP_FLAG_NONE, &resource_desc, D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(&constant_buffer_));
-	if(FAILED(hr)){
-		return hr;
-	}
-
-
-	//_f[^̏
-	Vertex3D *buffer{};
-	hr = vertex_buffer_->Map(0, nullptr, (void**)&buffer);
-	if(FAILED(hr)){
-		return hr;
-	}
-	buffer[0].Position = {-1.0f,  1.0f, 0.0f};
-	buffer[1].Position = { 1.0f,  1.0f, 0.0f};
-	buffer[2].Position = {-1.0f, -1.0f, 0.0f};
-	buffer[3].Position = { 1.0f, -1.0f, 0.0f};
-	buffer[0].Normal = {0.0f, 0.0f, -1.0f};
-	buffer[1].Normal = {0.0f, 0.0f, -1.0f};
-	buffer[2].Normal = {0.0f, 0.0f, -1.0f};
-	buffer[3].Normal = {0.0f, 0.0f, -1.0f};
-	buffer[0].UV = {0.0f, 0.0f};
-	buffer[1].UV = {0.0f, 1.0f};
-	buffer[2].UV = {1.0f, 0.0f};
-	buffer[3].UV = {1.0f, 1.0f};
-
-	vertex_buffer_->Unmap(0, nullptr);
-	buffer = nullptr;
-
-
-
-
-
-	//摜̓ǂݍ
-	std::vector<byte> img;
-	std::fstream fs("wall", std::ios_base::in | std::ios_base::binary);
-	if(!fs){
-		return E_FAIL;
-	}
-	int width;
-	int height;
-	fs.read((char*)&width, sizeof(width));
-	fs.read((char*)&height, sizeof(height));
-	img.resize(width * height * 4);
-	fs.read((char*)&img[0], img.size());
-	fs.close();
-
-
-	//eNX`p̃\[X̍쐬
-	heap_properties.Type                 = D3D12_HEAP_TYPE_CUSTOM;
-	heap_properties.CPUPageProperty      = D3D12_CPU_PAGE_PROPERTY_WRITE_BACK;
-	heap_properties.MemoryPoolPreference = D3D12_MEMORY_POOL_L0;
-
-	resource_desc.Dimension	= D3D12_RESOURCE_DIMENSION_TEXTURE2D;
-	resource_desc.Width		= width;
-	resource_desc.Height	= height;
-	resource_desc.Format	= DXGI_FORMAT_B8G8R8A8_UNORM;
-	resource_desc.Layout	= D3D12_TEXTURE_LAYOUT_UNKNOWN;
-	hr = device->CreateCommittedResource(&heap_properties, D3D12_HEAP_FLAG_NONE, &resource_desc, D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(&texture_));
-	if(FAILED(hr)){
-		return hr;
-	}
-
-
-	//eNX`p̃fXNv^q[v̍쐬
-	D3D12_DESCRIPTOR_HEAP_DESC descriptor_heap_desc{};
-	descriptor_heap_desc.NumDescriptors = 2;
-	descriptor_heap_desc.Type			= D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
-	descriptor_heap_desc.Flags			= D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
-	descriptor_heap_desc.NodeMask		= 0;
-	hr = device->CreateDescriptorHeap(&descriptor_heap_desc, IID_PPV_ARGS(&dh_texture_));
-	if (FAILED(hr)) {
-		return hr;
-	}
-
-
-	//VF[_\[Xr[̍쐬
-	D3D12_CPU_DESCRIPTOR_HANDLE handle_srv{};
-	D3D12_SHADER_RESOURCE_VIEW_DESC resourct_view_desc{};
-
-	resourct_view_desc.Format							= DXGI_FORMAT_B8G8R8A8_UNORM;
-	resourct_view_desc.ViewDimension					= D3D12_SRV_DIMENSION_TEXTURE2D;
-	resourct_view_desc.Texture2D.MipLevels				= 1;
-	resourct_view_desc.Texture2D.MostDetailedMip		= 0;
-	resourct_view_desc.Texture2D.PlaneSlice				= 0;
-	resourct_view_desc.Texture2D.ResourceMinLODClamp	= 0.0F;
-	resourct_view_desc.Shader4ComponentMapping			= D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
-
-	handle_srv = dh_texture_->GetCPUDescriptorHandleForHeapStart();
-	device->CreateShaderResourceView(texture_.Get(), &resourct_view_desc, handle_srv);
-
-	resourct_view_desc.Format							= DXGI_FORMAT_R32_FLOAT;
-	handle_srv.ptr += device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
-	device->CreateShaderResourceView(sm, &resourct_view_desc, handle_srv);
-
-	//摜f[^̏
-	D3D12_BOX box = {0, 0, 0, (UINT)width, (UINT)height, 1};
-	hr = texture_->WriteToSubresource(0, &box, &img[0], 4 * width, 4 * width * height);
-	if(FAILED(hr)){
-		return hr;
-	}
-
-
-	return S_OK;
-}
-
-HRESULT Plane::Update(){
-	HRESULT hr;
-	static constexpr float PI = 3.14159265358979323846264338f;
-	static int cnt{};
-	++cnt;
-
-	//J̐ݒ
-	XMMATRIX view = XMMatrixLookAtLH({1.0f, 1.0f, -6.0f}, {0.0f, 0.0f, 0.0f}, {0.0f, 1.0f, 0.0f});
-	XMMATRIX projection = XMMatrixPerspectiveFovLH(XMConvertToRadians(60.0f), 640.0f / 480.0f, 1.0f, 20.0f);
-
-	//IuWFNg̉]̐ݒ
-	XMMATRIX scale = XMMatrixScaling(3.0f, 3.0f, 1.0f);
-	XMMATRIX rotate = XMMatrixRotationX(XMConvertToRadians(90.0f + 10.0f * sin(PI * (cnt % 144) / 72.0f)));
-	rotate *= XMMatrixRotationY(-PI * (cnt % 400) / 200.0f);
-	XMMATRIX trans = XMMatrixTranslation(0.0f, -2.0f, 0.0f);
-
-	XMFLOAT4X4 Mat;
-	XMStoreFloat4x4(&Mat, XMMatrixTranspose(scale * rotate * trans * view * projection));
-
-	XMFLOAT4X4 World;
-	XMStoreFloat4x4(&World, XMMatrixTranspose(scale * rotate * trans));
-
-
-	XMFLOAT4X4 *buffer{};
-	hr = constant_buffer_->Map(0, nullptr, (void**)&buffer);
-	if(FAILED(hr)){
-		return hr;
-	}
-
-	//s萔obt@ɏ
-	buffer[0] = Mat;
-	buffer[1] = World;
-
-	constant_buffer_->Unmap(0, nullptr);
-	buffer = nullptr;
-
-	return hr;
-}
-
-HRESULT Plane::Draw(ID3D12GraphicsCommandList *command_list){
-	D3D12_VERTEX_BUFFER_VIEW	 vertex_view{};
-	vertex_view.BufferLocation = vertex_buffer_->GetGPUVirtualAddress();
-	vertex_view.StrideInBytes  = sizeof(Vertex3D);
-	vertex_view.SizeInBytes    = sizeof(Vertex3D) * 4;
-
-	//萔obt@VF[_̃WX^ɃZbg
-	command_list->SetGraphicsRootConstantBufferView(0, constant_buffer_->GetGPUVirtualAddress());
-
-	//eNX`VF[_̃WX^ɃZbg
-	command_list->SetDescriptorHeaps(1, dh_texture_.GetAddressOf());
-	command_list->SetGraphicsRootDescriptorTable(2, dh_texture_->GetGPUDescriptorHandleForHeapStart());
-
-	//CfbNXgpȂgCAOXgbvŕ`
-	command_list->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP);
-	command_list->IASetVertexBuffers(0, 1, &vertex_view);
-
-	//`
-	command_list->DrawInstanced(4, 1, 0, 0);
-
-	return S_OK;
-}
+#include "Plane.h"
+#include "D3D12Manager.h"
+
+Plane::Plane():
+	vertex_buffer_{},
+	texture_{},
+	texture_allocation_{-1},
+	texture_index_{},
+	constant_address_{},
+	scene_(nullptr),
+	entity_(Scene::INVALID_ENTITY),
+	frame_{},
+	world_{},
+	paused_(false),
+	streamer_(nullptr),
+	stream_id_(-1),
+	image_{}{}
+
+
+//CPU側のデータの準備(ワーカースレッドから呼ばれる)
+HRESULT Plane::Load(){
+
+	//画像の読み込み
+	if(!image_.Load("wall")){
+		return E_FAIL;
+	}
+
+	return S_OK;
+}
+
+HRESULT Plane::Initialize(ID3D12Device *device, CopyUploader *uploader, BindlessHeap *heap){
+	HRESULT hr{};
+	D3D12_RESOURCE_DESC   resource_desc{};
+
+	//頂点データ
+	Vertex3D buffer[4]{};
+	buffer[0].Position = {-1.0f,  1.0f, 0.0f};
+	buffer[1].Position = { 1.0f,  1.0f, 0.0f};
+	buffer[2].Position = {-1.0f, -1.0f, 0.0f};
+	buffer[3].Position = { 1.0f, -1.0f, 0.0f};
+	buffer[0].Normal = {0.0f, 0.0f, -1.0f};
+	buffer[1].Normal = {0.0f, 0.0f, -1.0f};
+	buffer[2].Normal = {0.0f, 0.0f, -1.0f};
+	buffer[3].Normal = {0.0f, 0.0f, -1.0f};
+	buffer[0].UV = {0.0f, 0.0f};
+	buffer[1].UV = {0.0f, 1.0f};
+	buffer[2].UV = {1.0f, 0.0f};
+	buffer[3].UV = {1.0f, 1.0f};
+
+	//頂点バッファの作成(DEFAULTヒープにコピーキューで転送する)
+	hr = uploader->CreateBuffer(buffer, sizeof(buffer), &vertex_buffer_);
+	if(FAILED(hr)){
+		return hr;
+	}
+
+
+
+
+
+	//Loadで読み込んだ画像を使う
+	if(!image_.IsOpen()){
+		return E_FAIL;
+	}
+	const int width  = image_.Width();
+	const int height = image_.Height();
+
+
+	//テクスチャ用のリソースの作成(COMMONからコピー先・シェーダリソースへ暗黙に遷移する)
+	resource_desc.Dimension				= D3D12_RESOURCE_DIMENSION_TEXTURE2D;
+	resource_desc.Width					= width;
+	resource_desc.Height				= height;
+	resource_desc.DepthOrArraySize		= 1;
+	resource_desc.MipLevels				= image_.LevelNum();
+	resource_desc.Format				= GetDXGIFormat(image_.Format());
+	resource_desc.Layout				= D3D12_TEXTURE_LAYOUT_UNKNOWN;
+	resource_desc.SampleDesc.Count		= 1;
+	resource_desc.SampleDesc.Quality	= 0;
+	hr = uploader->CreateTexture(resource_desc, &texture_, &texture_allocation_);
+	if(FAILED(hr)){
+		return hr;
+	}
+
+
+	//シェーダリソースビューの作成
+	D3D12_SHADER_RESOURCE_VIEW_DESC resourct_view_desc{};
+
+	resourct_view_desc.Format							= GetDXGIFormat(image_.Format());
+	resourct_view_desc.ViewDimension					= D3D12_SRV_DIMENSION_TEXTURE2D;
+	resourct_view_desc.Texture2D.MipLevels				= image_.LevelNum();
+	resourct_view_desc.Texture2D.MostDetailedMip		= 0;
+	resourct_view_desc.Texture2D.PlaneSlice				= 0;
+	resourct_view_desc.Texture2D.ResourceMinLODClamp	= 0.0F;
+	resourct_view_desc.Shader4ComponentMapping			= D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+
+	hr = heap->CreateShaderResourceView(texture_.Get(), &resourct_view_desc, &texture_index_);
+	if(FAILED(hr)){
+		return hr;
+	}
+
+	//ストリーミングする場合は小さいレベルだけを転送する(詳細なレベルは描画しながら読み込む)
+	if(streamer_ != nullptr){
+		stream_id_ = streamer_->Register(&image_, ToRenderResource(texture_.Get()), TextureStreamer::DEFAULT_TAIL_SIZE);
+		return (stream_id_ < 0) ? E_FAIL : S_OK;
+	}
+
+	//画像データの転送(全てのミップレベル)
+	hr = uploader->UploadTexture(texture_.Get(), image_);
+	if(FAILED(hr)){
+		return hr;
+	}
+
+	//ステージングに書き込んだのでファイルを閉じる
+	image_.Close();
+
+	return S_OK;
+}
+
+void Plane::UseMemory(GpuMemoryAllocator *memory) const{
+	memory->Use(vertex_buffer_.allocation);
+	memory->Use(texture_allocation_);
+}
+
+void Plane::AddToScene(Scene *scene){
+	scene_ = scene;
+	entity_ = scene->Create();
+	scene_->SetScale(entity_, 3.0f, 3.0f, 1.0f);
+	scene_->SetPosition(entity_, 0.0f, -2.0f, 0.0f);
+	WriteTransform();
+}
+
+void Plane::Animate(){
+	if(paused_){
+		return;
+	}
+	++frame_;
+	WriteTransform();
+}
+
+//X軸で前後に傾けながらY軸で回す(拡大率と位置はAddToSceneで書いたまま)
+void Plane::WriteTransform(){
+	static constexpr float PI = 3.14159265358979323846264338f;
+	float rotate_x[4], rotate_y[4], rotation[4];
+	Scene::RotationX(XMConvertToRadians(90.0f + 10.0f * sin(PI * (frame_ % 144) / 72.0f)), rotate_x);
+	Scene::RotationY(-PI * (frame_ % 400) / 200.0f, rotate_y);
+	Scene::MultiplyRotation(rotate_x, rotate_y, rotation);
+	scene_->SetRotation(entity_, rotation);
+}
+
+HRESULT Plane::Update(RenderUploadHeap *upload_heap){
+
+	//ワールド変換行列(シーンの行列は行ベクトルに掛ける並びなので転置する)
+	const Scene::Matrix world = scene_->World(entity_);
+	const XMFLOAT4X4 Mat(&(world * scene_->ViewProj()).Transposed().m[0][0]);
+
+	const XMFLOAT4X4 World(&world.Transposed().m[0][0]);
+	world_ = World;
+
+
+	//テクスチャのストリーミング(拡大した平面の外接円の大きさで要求する)
+	XMFLOAT4 MinLod{};
+	if(streamer_ != nullptr){
+		float view_position[4];
+		scene_->View().TransformPoint(world.m[3], view_position);
+		const float depth = view_position[2];
+		streamer_->Request(stream_id_, TextureStreamer::ProjectedSize(3.0f * 1.41421356f, depth, scene_->GetCamera().fov_y, 480.0f));
+		MinLod.x = streamer_->MinLod(stream_id_);
+	}
+
+
+	//今フレームの定数の領域を確保する(Map済みなのでそのまま書き込める)
+	//インスタンス描画用のビュー・プロジェクション行列は使わないが、後ろの定数の位置を合わせるために領域は取る
+	RenderUploadHeap::Allocation allocation{};
+	if(!upload_heap->AllocateConstant(sizeof(XMFLOAT4X4) * 3 + sizeof(XMFLOAT4), &allocation)){
+		return E_OUTOFMEMORY;
+	}
+
+	//行列を定数バッファに書き込み
+	XMFLOAT4X4 *buffer = static_cast<XMFLOAT4X4*>(allocation.cpu_address);
+	buffer[0] = Mat;
+	buffer[1] = World;
+	*reinterpret_cast<XMFLOAT4*>(buffer + 3) = MinLod;
+	constant_address_ = allocation.gpu_address;
+
+	return S_OK;
+}
+
+HRESULT Plane::Draw(RenderCommandList *command_list){
+
+	//定数バッファをシェーダのレジスタにセット
+	command_list->SetConstantBuffer(0, constant_address_);
+
+	//テクスチャの添字をセット(ヒープとテーブルはパスの先頭で設定済み)
+	const uint32_t texture_index = texture_index_;
+	command_list->SetRootConstants(2, 1, &texture_index, D3D12Manager::DESCRIPTOR_INDEX_TEXTURE);
+
+	//インデックスを使用しないトライアングルストリップで描画
+	command_list->SetTopology(RENDER_TOPOLOGY_TRIANGLE_STRIP);
+	command_list->SetVertexBuffer(0, vertex_buffer_.gpu_address, sizeof(Vertex3D) * 4, sizeof(Vertex3D));
+
+	//描画
+	command_list->Draw(4, 1, 0, 0);
+
+	return S_OK;
+}
@@ -1,24 +1,66 @@
-#ifndef PLANE_HEADER_
-#define PLANE_HEADER_
-
-#include <d3d12.h>
-#include <wrl/client.h>
-
-using namespace Microsoft::WRL;
-
-class Plane{
-public:
-	Plane();
-	~Plane(){}
-	HRESULT Initialize(ID3D12Device *device, ID3D12Resource *sm);
-	HRESULT Update();
-	HRESULT Draw(ID3D12GraphicsCommandList *command_list);
-
-private:
-	ComPtr<ID3D12Resource>			vertex_buffer_;
-	ComPtr<ID3D12Resource>			constant_buffer_;
-	ComPtr<ID3D12Resource>			texture_;
-	ComPtr<ID3D12DescriptorHeap>	dh_texture_;
-};
-
-#endif
+#ifndef PLANE_HEADER_
+#define PLANE_HEADER_
+
+#include <d3d12.h>
+#include <DirectXMath.h>
+#include <wrl/client.h>
+#include "TextureAsset.h"
+#include "RenderCommandList.h"
+#include "RenderUploadHeap.h"
+#include "CopyUploader.h"
+#include "BindlessHeap.h"
+#include "TextureStreamer.h"
+#include "Scene.h"
+
+using namespace DirectX;
+using namespace Microsoft::WRL;
+
+class Plane{
+public:
+	Plane();
+	~Plane(){}
+	HRESULT Load();
+	HRESULT Initialize(ID3D12Device *device, CopyUploader *uploader, BindlessHeap *heap);
+
+	//シーンにエンティティを作り、最初のフレームの変換を書く(Animate・Updateの前に呼ぶ)
+	void AddToScene(Scene *scene);
+
+	//アニメーションを1フレーム進めて、シーンのローカルの変換に書く(止めている間は変えない)
+	void Animate();
+
+	//ワールド変換とカメラの行列はScene::Updateで求めたものを使う
+	HRESULT Update(RenderUploadHeap *upload_heap);
+	HRESULT Draw(RenderCommandList *command_list);
+
+	//今フレームで使うメモリを伝える(描画の前に呼ぶ)
+	void UseMemory(GpuMemoryAllocator *memory) const;
+
+	//trueならアニメーションを止める(シーンの変換を変えないので、ワールド変換も求め直さない)
+	void SetPaused(bool paused){paused_ = paused;}
+
+	//直前のUpdateのワールド変換行列(転置済み)
+	const XMFLOAT4X4& World() const{return world_;}
+
+	//Initializeの前に設定すると、テクスチャは小さいレベルだけを転送してstreamerで残りを転送する
+	void SetTextureStreamer(TextureStreamer *streamer){streamer_ = streamer;}
+
+private:
+	void WriteTransform();
+
+private:
+	GpuMemoryAllocator::BufferRange	vertex_buffer_;
+	ComPtr<ID3D12Resource>			texture_;
+	GpuMemoryAllocator::Allocation	texture_allocation_;
+	UINT							texture_index_;		//テクスチャのSRVのヒープ上の添字
+	RenderGpuAddress				constant_address_;	//今フレームの定数の位置(アップロードヒープ上)
+	Scene							*scene_;
+	Scene::Entity					entity_;
+	int								frame_;		//アニメーションのフレーム数(最初のフレームが1)
+	XMFLOAT4X4						world_;
+	bool							paused_;
+	TextureStreamer					*streamer_;
+	int								stream_id_;
+	TextureAsset					image_;	//Loadで読み込んでInitializeで転送する(ストリーミングする場合は開いたままにする)
+};
+
+#endif
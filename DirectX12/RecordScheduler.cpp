@@ -0,0 +1,52 @@
+#include <future>
+#include "RecordScheduler.h"
+#include "JobSystem.h"
+
+void RecordScheduler::AddPass(RecordTarget *target, RecordFunc func){
+	passes_.push_back({target, std::move(func)});
+}
+
+void RecordScheduler::Clear(){
+	passes_.clear();
+}
+
+bool RecordScheduler::Record(int frame_index, JobSystem *jobs){
+	if(passes_.empty()){
+		return true;
+	}
+
+	if(jobs == nullptr || passes_.size() == 1){
+		bool ok = true;
+		for(const Pass &pass : passes_){
+			ok = RecordPass(pass, frame_index) && ok;
+		}
+		return ok;
+	}
+
+	//先頭のパス以外をワーカースレッドに渡し、先頭のパスはこのスレッドで記録する
+	std::vector<std::future<bool>> results;
+	results.reserve(passes_.size() - 1);
+	for(size_t i = 1; i < passes_.size(); ++i){
+		const Pass *pass = &passes_[i];
+		results.push_back(jobs->Push([pass, frame_index]{return RecordPass(*pass, frame_index);}));
+	}
+
+	bool ok = RecordPass(passes_[0], frame_index);
+	for(auto &r : results){
+		ok = r.get() && ok;
+	}
+
+	return ok;
+}
+
+bool RecordScheduler::RecordPass(const Pass &pass, int frame_index){
+	if(!pass.target->Begin(frame_index)){
+		return false;
+	}
+
+	//記録に失敗してもリストは閉じておく
+	const bool recorded = pass.func(pass.target);
+	const bool closed = pass.target->End();
+
+	return recorded && closed;
+}
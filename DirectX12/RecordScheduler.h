@@ -0,0 +1,56 @@
+#ifndef RECORD_SCHEDULER_HEADER_
+#define RECORD_SCHEDULER_HEADER_
+
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+class JobSystem;
+
+//コマンドの記録先(コマンドリストとアロケータの組)の抽象
+//D3D12の実装のほかに、GPUなしで動く実装に差し替えられる
+class RecordTarget{
+public:
+	virtual ~RecordTarget(){}
+
+	//frame_indexのアロケータで記録を始める(アロケータはGPUの完了を確認済みであること)
+	virtual bool Begin(int frame_index) = 0;
+
+	//記録を終える(コマンドリストを閉じる)
+	virtual bool End() = 0;
+};
+
+
+//パスごとのコマンドの記録をワーカースレッドに振り分ける
+//記録はどの順で終わってもよいが、提出はAddPassした順に行う
+class RecordScheduler{
+public:
+	typedef std::function<bool(RecordTarget *target)> RecordFunc;
+
+public:
+	RecordScheduler(){}
+	~RecordScheduler(){}
+
+	void AddPass(RecordTarget *target, RecordFunc func);
+	void Clear();
+
+	//すべてのパスを記録する(jobsがnullptrなら呼び出したスレッドで順に記録する)
+	//1つでも失敗したらfalseを返す
+	bool Record(int frame_index, JobSystem *jobs);
+
+	size_t PassNum() const{return passes_.size();}
+	RecordTarget* GetTarget(size_t index) const{return passes_[index].target;}
+
+private:
+	struct Pass{
+		RecordTarget	*target;
+		RecordFunc		func;
+	};
+
+	static bool RecordPass(const Pass &pass, int frame_index);
+
+private:
+	std::vector<Pass>	passes_;
+};
+
+#endif
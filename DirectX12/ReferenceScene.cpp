@@ -0,0 +1,175 @@
+#include <cmath>
+#include "ReferenceScene.h"
+#include "BlockCompressor.h"
+
+namespace{
+typedef SoftwareRasterizer::Matrix Matrix;
+
+constexpr float PI = 3.14159265358979323846f;
+
+float ToRadians(float degree){
+	return degree * (PI / 180.0f);
+}
+}
+
+ReferenceScene::ReferenceScene():
+	sphere_vertices_{},
+	sphere_indices_{},
+	plane_vertices_{},
+	earth_{},
+	wall_{},
+	earth_pixels_{},
+	wall_pixels_{},
+	earth_texture_{},
+	wall_texture_{}{}
+
+bool ReferenceScene::Load(){
+	if(!LoadTexture("earth", &earth_, &earth_pixels_, &earth_texture_)){
+		return false;
+	}
+	if(!LoadTexture("wall", &wall_, &wall_pixels_, &wall_texture_)){
+		return false;
+	}
+
+	//球(Sphere::Loadと同じ頂点とインデックス)
+	sphere_vertices_.resize(SPHERE_VERT_NUM * SPHERE_ARC_NUM);
+	sphere_indices_.resize((SPHERE_VERT_NUM - 1) * SPHERE_ARC_NUM * 6);
+
+	const float pd = 2.0f * PI / (SPHERE_ARC_NUM - 1);
+	const float td = PI / (SPHERE_VERT_NUM - 1);
+	float phi{};
+	for(int i = 0; i < SPHERE_ARC_NUM; ++i){
+		float t{};
+		for(int j = 0; j < SPHERE_VERT_NUM; ++j){
+			SoftwareRasterizer::Vertex &v = sphere_vertices_[i * SPHERE_VERT_NUM + j];
+			v.position[0]	= sinf(t) * cosf(phi);
+			v.position[1]	= cosf(t);
+			v.position[2]	= sinf(t) * sinf(phi);
+			v.normal[0]		= v.position[0];
+			v.normal[1]		= v.position[1];
+			v.normal[2]		= v.position[2];
+			v.uv[0]			= i / (float)(SPHERE_ARC_NUM - 1);
+			v.uv[1]			= j / (float)(SPHERE_VERT_NUM - 1);
+			t += td;
+		}
+		phi += pd;
+	}
+
+	uint16_t *ib = sphere_indices_.data();
+	int idx{};
+	for(int i = 0; i < SPHERE_ARC_NUM - 1; ++i){
+		for(int j = 0; j < SPHERE_VERT_NUM - 1; ++j){
+			ib[1 + idx] = static_cast<uint16_t>(SPHERE_VERT_NUM * i + j);
+			ib[0 + idx] = static_cast<uint16_t>(SPHERE_VERT_NUM * i + j + 1);
+			ib[2 + idx] = static_cast<uint16_t>(SPHERE_VERT_NUM * (i + 1) + j);
+			ib[4 + idx] = static_cast<uint16_t>(SPHERE_VERT_NUM * (i + 1) + j);
+			ib[3 + idx] = static_cast<uint16_t>(SPHERE_VERT_NUM * i + j + 1);
+			ib[5 + idx] = static_cast<uint16_t>(SPHERE_VERT_NUM * (i + 1) + j + 1);
+			idx += 6;
+		}
+	}
+
+	//板ポリ(Plane::Initializeと同じトライアングルストリップ)
+	const SoftwareRasterizer::Vertex plane[4] = {
+		{{-1.0f,  1.0f, 0.0f}, {0.0f, 0.0f, -1.0f}, {0.0f, 0.0f}},
+		{{ 1.0f,  1.0f, 0.0f}, {0.0f, 0.0f, -1.0f}, {0.0f, 1.0f}},
+		{{-1.0f, -1.0f, 0.0f}, {0.0f, 0.0f, -1.0f}, {1.0f, 0.0f}},
+		{{ 1.0f, -1.0f, 0.0f}, {0.0f, 0.0f, -1.0f}, {1.0f, 1.0f}},
+	};
+	for(int i = 0; i < 4; ++i){
+		plane_vertices_[i] = plane[i];
+	}
+
+	return true;
+}
+
+void ReferenceScene::Build(int counter, int width, int height, SoftwareRasterizer::Scene *scene) const{
+	//カメラ
+	const float eye[3]		= {1.0f, 1.0f, -6.0f};
+	const float focus[3]	= {0.0f, 0.0f, 0.0f};
+	const float up[3]		= {0.0f, 1.0f, 0.0f};
+	const Matrix view = Matrix::LookAtLH(eye, focus, up);
+	const Matrix projection = Matrix::PerspectiveFovLH(ToRadians(60.0f), static_cast<float>(width) / static_cast<float>(height), 1.0f, 20.0f);
+
+	//ライト(カスケードに分ける前の1枚のシャドウマップの行列)
+	const float light_pos[3] = {2.0f, 6.5f, -1.0f};
+	const Matrix light_view = Matrix::LookAtLH(light_pos, focus, up);
+	scene->light_vp = light_view * Matrix::PerspectiveFovLH(ToRadians(45.0f), 1.0f, 1.0f, 15.0f);
+
+	scene->meshes.clear();
+
+	//球
+	{
+		const Matrix rotate = Matrix::RotationY(ToRadians(static_cast<float>(counter % 1800)) / 5.0f);
+		const Matrix move = Matrix::Translation(0.0f, std::sin(PI * ((counter % 240) / 120.0f)) * 0.5f, std::sin(PI * ((counter % 120) / 60.0f)) * 0.5f);
+
+		SoftwareRasterizer::Mesh mesh{};
+		mesh.vertices	= sphere_vertices_.data();
+		mesh.vertex_num	= static_cast<int>(sphere_vertices_.size());
+		mesh.indices	= sphere_indices_.data();
+		mesh.index_num	= static_cast<int>(sphere_indices_.size());
+		mesh.topology	= SoftwareRasterizer::TOPOLOGY_TRIANGLE_LIST;
+		mesh.texture	= &earth_texture_;
+		mesh.world		= rotate * move;
+		mesh.wvp		= rotate * move * view * projection;
+		scene->meshes.push_back(mesh);
+	}
+
+	//板ポリ
+	{
+		const Matrix scale = Matrix::Scaling(3.0f, 3.0f, 1.0f);
+		Matrix rotate = Matrix::RotationX(ToRadians(90.0f + 10.0f * std::sin(PI * (counter % 144) / 72.0f)));
+		rotate = rotate * Matrix::RotationY(-PI * (counter % 400) / 200.0f);
+		const Matrix trans = Matrix::Translation(0.0f, -2.0f, 0.0f);
+
+		SoftwareRasterizer::Mesh mesh{};
+		mesh.vertices	= plane_vertices_;
+		mesh.vertex_num	= 4;
+		mesh.indices	= nullptr;
+		mesh.index_num	= 0;
+		mesh.topology	= SoftwareRasterizer::TOPOLOGY_TRIANGLE_STRIP;
+		mesh.texture	= &wall_texture_;
+		mesh.world		= scale * rotate * trans;
+		mesh.wvp		= scale * rotate * trans * view * projection;
+		scene->meshes.push_back(mesh);
+	}
+}
+
+bool ReferenceScene::LoadTexture(const char *name, TextureAsset *asset, std::vector<byte> *storage, SoftwareRasterizer::Texture *texture){
+	if(!asset->Load(name)){
+		return false;
+	}
+
+	texture->levels.clear();
+	storage->clear();
+
+	if(asset->Format() == TEXTURE_FORMAT_BGRA8){
+		for(int i = 0; i < asset->LevelNum(); ++i){
+			const TextureLevel &level = asset->GetLevel(i);
+			texture->levels.push_back({level.width, level.height, level.row_pitch, level.pixels});
+		}
+		return true;
+	}
+
+	//GPUと同じ画素で比較できるように、圧縮されたミップマップをそのまま展開して使う
+	size_t total{};
+	for(int i = 0; i < asset->LevelNum(); ++i){
+		total += static_cast<size_t>(asset->GetLevel(i).width) * asset->GetLevel(i).height * 4;
+	}
+	storage->resize(total);
+
+	size_t offset{};
+	for(int i = 0; i < asset->LevelNum(); ++i){
+		const TextureLevel &level = asset->GetLevel(i);
+		byte *dst = storage->data() + offset;
+		if(!BlockCompressor::Decompress(asset->Format(), level.pixels, level.width, level.height, dst, level.width * 4)){
+			return false;
+		}
+		texture->levels.push_back({level.width, level.height, level.width * 4, dst});
+		offset += static_cast<size_t>(level.width) * level.height * 4;
+	}
+
+	//展開したので元のファイルは閉じてよい
+	asset->Close();
+	return true;
+}
@@ -0,0 +1,44 @@
+#ifndef REFERENCE_SCENE_HEADER_
+#define REFERENCE_SCENE_HEADER_
+
+#include <cstdint>
+#include <vector>
+#include "SoftwareRasterizer.h"
+#include "TextureAsset.h"
+
+//Sphere/PlaneとD3D12Managerのライトと同じシーンをSoftwareRasterizer用に用意する
+//ジオメトリと行列の計算はSphere::Load/Update, Plane::Initialize/Updateに合わせてある
+//影はカスケードに分けず、以前のD3D12Managerと同じ1枚のシャドウマップ(ライトの位置からの45度の透視投影)で描く
+class ReferenceScene{
+public:
+	typedef unsigned char byte;
+	static constexpr int SPHERE_VERT_NUM	= 32;	//Sphere::VERT_NUM
+	static constexpr int SPHERE_ARC_NUM		= 32;	//Sphere::ARC_NUM
+
+public:
+	ReferenceScene();
+	~ReferenceScene(){}
+
+	//テクスチャを読み込む(BC1/BC3はBGRA8に展開する)
+	bool Load();
+
+	//counterはSphere・PlaneのAnimateで進めるフレーム数と同じ値(最初のフレームが1)
+	void Build(int counter, int width, int height, SoftwareRasterizer::Scene *scene) const;
+
+private:
+	static bool LoadTexture(const char *name, TextureAsset *asset, std::vector<byte> *storage, SoftwareRasterizer::Texture *texture);
+
+private:
+	std::vector<SoftwareRasterizer::Vertex>	sphere_vertices_;
+	std::vector<uint16_t>					sphere_indices_;
+	SoftwareRasterizer::Vertex				plane_vertices_[4];
+
+	TextureAsset							earth_;
+	TextureAsset							wall_;
+	std::vector<byte>						earth_pixels_;	//展開した画素(BGRA8のままなら空)
+	std::vector<byte>						wall_pixels_;
+	SoftwareRasterizer::Texture				earth_texture_;
+	SoftwareRasterizer::Texture				wall_texture_;
+};
+
+#endif
@@ -0,0 +1,47 @@
+#ifndef RENDER_COMMAND_LIST_HEADER_
+#define RENDER_COMMAND_LIST_HEADER_
+
+#include "RenderTypes.h"
+
+//描画コマンドの記録先の抽象
+//D3D12に転送する実装と、GPUなしでコマンドを記録・検証する実装(Headless)がある
+class RenderCommandList{
+public:
+	virtual ~RenderCommandList(){}
+
+	//num個のバリアを1回の呼び出しで記録する
+	virtual void ResourceBarriers(int num, const RenderBarrier *barriers) = 0;
+
+	//リソース全体を1つだけ遷移する
+	void ResourceBarrier(RenderResource resource, RenderResourceState before, RenderResourceState after){
+		const RenderBarrier barrier{resource, RENDER_ALL_SUBRESOURCES, before, after, RENDER_BARRIER_FULL};
+		ResourceBarriers(1, &barrier);
+	}
+
+	virtual void ClearRenderTarget(RenderTargetView rtv, const float color[4]) = 0;
+	virtual void ClearDepth(RenderTargetView dsv, float depth) = 0;
+
+	//同じ大きさ・フォーマットのリソース全体をコピーする(dstはCOPY_DEST、srcはCOPY_SOURCEの状態であること)
+	virtual void CopyResource(RenderResource dst, RenderResource src) = 0;
+
+	//rtv_numが0なら深度のみ(dsvは無効なハンドルでもよい)
+	virtual void SetRenderTargets(int rtv_num, const RenderTargetView *rtvs, RenderTargetView dsv) = 0;
+	virtual void SetViewport(const RenderViewport &viewport) = 0;
+	virtual void SetScissorRect(const RenderRect &rect) = 0;
+
+	virtual void SetRootSignature(RenderRootSignature root_signature) = 0;
+	virtual void SetPipeline(RenderPipeline pipeline) = 0;
+	virtual void SetConstantBuffer(int slot, RenderGpuAddress address) = 0;
+	virtual void SetRootConstants(int slot, uint32_t num, const uint32_t *values, uint32_t offset) = 0;	//offsetは32bit単位
+	virtual void SetDescriptorHeap(RenderDescriptorHeap heap) = 0;
+	virtual void SetDescriptorTable(int slot, RenderDescriptorTable table) = 0;
+
+	virtual void SetTopology(RenderTopology topology) = 0;
+	virtual void SetVertexBuffer(int slot, RenderGpuAddress address, uint32_t size, uint32_t stride) = 0;
+	virtual void SetIndexBuffer(RenderGpuAddress address, uint32_t size, RenderIndexFormat format) = 0;
+
+	virtual void Draw(uint32_t vertex_num, uint32_t instance_num, uint32_t start_vertex, uint32_t start_instance) = 0;
+	virtual void DrawIndexed(uint32_t index_num, uint32_t instance_num, uint32_t start_index, int32_t base_vertex, uint32_t start_instance) = 0;
+};
+
+#endif
@@ -0,0 +1,380 @@
+#include <algorithm>
+#include "RenderGraph.h"
+#include "ResourceStateTracker.h"
+
+namespace{
+uint64_t AlignUp(uint64_t value, uint64_t alignment){
+	return (alignment > 1) ? (value + alignment - 1) / alignment * alignment : value;
+}
+
+void AddEdge(std::vector<int> *edges, int to){
+	if(std::find(edges->begin(), edges->end(), to) == edges->end()){
+		edges->push_back(to);
+	}
+}
+}
+
+RenderGraph::RenderGraph():
+	passes_{},
+	resources_{},
+	order_{},
+	error_{},
+	stats_{}{}
+
+void RenderGraph::Clear(){
+	passes_.clear();
+	resources_.clear();
+	order_.clear();
+	error_.clear();
+	stats_ = {};
+}
+
+int RenderGraph::ImportResource(const char *name, RenderResource resource, RenderResourceState final_state){
+	Resource r{};
+	r.name			= name;
+	r.resource		= resource;
+	r.imported		= true;
+	r.final_state	= final_state;
+	r.first			= -1;
+	r.last			= -1;
+	resources_.push_back(std::move(r));
+	return static_cast<int>(resources_.size()) - 1;
+}
+
+int RenderGraph::CreateTransient(const char *name, uint64_t size, uint64_t alignment){
+	Resource r{};
+	r.name		= name;
+	r.size		= size;
+	r.alignment	= alignment;
+	r.first		= -1;
+	r.last		= -1;
+	resources_.push_back(std::move(r));
+	return static_cast<int>(resources_.size()) - 1;
+}
+
+void RenderGraph::SetResource(int resource, RenderResource value){
+	resources_[resource].resource = value;
+}
+
+int RenderGraph::AddPass(const char *name){
+	Pass p{};
+	p.name		= name;
+	p.enabled	= true;
+	passes_.push_back(std::move(p));
+	return static_cast<int>(passes_.size()) - 1;
+}
+
+void RenderGraph::SetPassEnabled(int pass, bool enabled){
+	passes_[pass].enabled = enabled;
+}
+
+void RenderGraph::SetSideEffect(int pass){
+	passes_[pass].side_effect = true;
+}
+
+void RenderGraph::Read(int pass, int resource, RenderResourceState state){
+	passes_[pass].accesses.push_back({resource, state, false});
+}
+
+void RenderGraph::Write(int pass, int resource, RenderResourceState state){
+	passes_[pass].accesses.push_back({resource, state, true});
+}
+
+bool RenderGraph::Compile(){
+	error_.clear();
+	order_.clear();
+	stats_ = {};
+	stats_.pass_num = static_cast<uint32_t>(passes_.size());
+
+	for(Pass &p : passes_){
+		p.successors.clear();
+		p.consumers.clear();
+		p.alive				= false;
+		p.predecessor_num	= 0;
+		p.begin_barriers.clear();
+		p.end_barriers.clear();
+	}
+	for(Resource &r : resources_){
+		r.offset	= 0;
+		r.first		= -1;
+		r.last		= -1;
+		r.aliased	= false;
+		stats_.transient_num += r.imported ? 0 : 1;
+	}
+
+	if(!BuildDependencies()){
+		return false;
+	}
+	Cull();
+	Schedule();
+	Allocate();
+	return true;
+}
+
+//宣言順にリソースごとの最後の書き込みと、その後の読み込みをたどって依存を求める
+//読み込み・書き込みは前の書き込みの後に、書き込みはその前の読み込みの後に実行する
+bool RenderGraph::BuildDependencies(){
+	std::vector<int> writers(resources_.size(), INVALID_HANDLE);
+	std::vector<std::vector<int>> readers(resources_.size());
+
+	for(int i = 0; i < static_cast<int>(passes_.size()); ++i){
+		Pass &p = passes_[i];
+		if(!p.enabled){
+			continue;
+		}
+
+		for(size_t a = 0; a < p.accesses.size(); ++a){
+			const Access &access = p.accesses[a];
+			for(size_t b = 0; b < a; ++b){
+				if(p.accesses[b].resource == access.resource && p.accesses[b].state != access.state){
+					return Fail(p.name + " uses " + resources_[access.resource].name + " in two different states");
+				}
+			}
+
+			const int writer = writers[access.resource];
+			if(writer == INVALID_HANDLE && !access.write && !resources_[access.resource].imported){
+				return Fail(p.name + " reads " + resources_[access.resource].name + " before it is written");
+			}
+
+			//書き込みは前の内容に重ねるので、前の書き込みの出力を使うものとして扱う
+			if(writer != INVALID_HANDLE && writer != i){
+				AddEdge(&passes_[writer].successors, i);
+				AddEdge(&passes_[writer].consumers, i);
+			}
+
+			if(access.write){
+				for(int reader : readers[access.resource]){
+					if(reader != i){
+						AddEdge(&passes_[reader].successors, i);
+					}
+				}
+				readers[access.resource].clear();
+				writers[access.resource] = i;
+			}else{
+				readers[access.resource].push_back(i);
+			}
+		}
+	}
+
+	return true;
+}
+
+//外部のリソースに書き込むパスと削除しないパスから、出力をたどって使われるパスを残す
+//依存は宣言順の前から後にしか向かないので、後ろから1回たどればよい
+void RenderGraph::Cull(){
+	for(int i = static_cast<int>(passes_.size()) - 1; i >= 0; --i){
+		Pass &p = passes_[i];
+		if(!p.enabled){
+			continue;
+		}
+
+		p.alive = p.side_effect;
+		for(const Access &access : p.accesses){
+			p.alive = p.alive || (access.write && resources_[access.resource].imported);
+		}
+		for(int consumer : p.consumers){
+			p.alive = p.alive || passes_[consumer].alive;
+		}
+	}
+
+	for(const Pass &p : passes_){
+		stats_.culled_num += p.alive ? 0 : 1;
+	}
+}
+
+//依存を満たしたパスのうち、一時リソースのメモリを多く解放できる(新たに使い始めるメモリが少ない)ものから並べる
+//同じ場合は宣言順にするので、結果は宣言が同じなら常に同じになる
+void RenderGraph::Schedule(){
+	const int pass_num = static_cast<int>(passes_.size());
+
+	//残りの使用回数が0になったリソースは解放できる
+	std::vector<int> remaining(resources_.size(), 0);
+	std::vector<bool> started(resources_.size(), false);
+	std::vector<int> ready;
+
+	for(int i = 0; i < pass_num; ++i){
+		const Pass &p = passes_[i];
+		if(!p.alive){
+			continue;
+		}
+		for(int successor : p.successors){
+			passes_[successor].predecessor_num += passes_[successor].alive ? 1 : 0;
+		}
+		for(size_t a = 0; a < p.accesses.size(); ++a){
+			const int resource = p.accesses[a].resource;
+			bool counted = false;
+			for(size_t b = 0; b < a; ++b){
+				counted = counted || (p.accesses[b].resource == resource);
+			}
+			remaining[resource] += counted ? 0 : 1;
+		}
+	}
+	for(int i = 0; i < pass_num; ++i){
+		if(passes_[i].alive && passes_[i].predecessor_num == 0){
+			ready.push_back(i);
+		}
+	}
+
+	while(!ready.empty()){
+		size_t best = 0;
+		int64_t best_score = INT64_MIN;
+		for(size_t r = 0; r < ready.size(); ++r){
+			int64_t score = 0;
+			for(const Access &access : passes_[ready[r]].accesses){
+				const Resource &resource = resources_[access.resource];
+				if(resource.imported){
+					continue;
+				}
+				if(!started[access.resource]){
+					score -= static_cast<int64_t>(resource.size);
+				}
+				if(remaining[access.resource] == 1){
+					score += static_cast<int64_t>(resource.size);
+				}
+			}
+			if(score > best_score || (score == best_score && ready[r] < ready[best])){
+				best		= r;
+				best_score	= score;
+			}
+		}
+
+		const int index = ready[best];
+		ready.erase(ready.begin() + best);
+		order_.push_back(index);
+
+		const Pass &p = passes_[index];
+		for(size_t a = 0; a < p.accesses.size(); ++a){
+			const int resource = p.accesses[a].resource;
+			bool counted = false;
+			for(size_t b = 0; b < a; ++b){
+				counted = counted || (p.accesses[b].resource == resource);
+			}
+			if(!counted){
+				--remaining[resource];
+				started[resource] = true;
+			}
+		}
+		for(int successor : p.successors){
+			Pass &s = passes_[successor];
+			if(s.alive && --s.predecessor_num == 0){
+				ready.push_back(successor);
+			}
+		}
+	}
+}
+
+//一時リソースを大きいものから順に、使われる間が重なるものと重ならない最も低い位置に置く
+void RenderGraph::Allocate(){
+	for(int position = 0; position < static_cast<int>(order_.size()); ++position){
+		for(const Access &access : passes_[order_[position]].accesses){
+			Resource &r = resources_[access.resource];
+			if(r.first < 0){
+				r.first = position;
+			}
+			r.last = position;
+		}
+	}
+
+	std::vector<int> transients;
+	for(int i = 0; i < static_cast<int>(resources_.size()); ++i){
+		if(!resources_[i].imported && resources_[i].first >= 0){
+			transients.push_back(i);
+		}
+	}
+	std::sort(transients.begin(), transients.end(), [this](int a, int b){
+		return (resources_[a].size != resources_[b].size) ? resources_[a].size > resources_[b].size : a < b;
+	});
+
+	std::vector<int> placed;
+	std::vector<int> overlaps;
+	for(int index : transients){
+		Resource &r = resources_[index];
+
+		overlaps.clear();
+		for(int other : placed){
+			const Resource &o = resources_[other];
+			if(o.first <= r.last && r.first <= o.last){
+				overlaps.push_back(other);
+			}
+		}
+		std::sort(overlaps.begin(), overlaps.end(), [this](int a, int b){
+			return (resources_[a].offset != resources_[b].offset) ? resources_[a].offset < resources_[b].offset : a < b;
+		});
+
+		uint64_t offset = 0;
+		for(int other : overlaps){
+			const Resource &o = resources_[other];
+			if(AlignUp(offset, r.alignment) + r.size <= o.offset){
+				break;
+			}
+			offset = std::max(offset, o.offset + o.size);
+		}
+		r.offset = AlignUp(offset, r.alignment);
+		placed.push_back(index);
+
+		stats_.transient_size = std::max(stats_.transient_size, r.offset + r.size);
+		stats_.unaliased_size = AlignUp(stats_.unaliased_size, r.alignment) + r.size;
+	}
+
+	//メモリの範囲が重なるものは使い始めに切り替えが要る
+	for(size_t a = 0; a < placed.size(); ++a){
+		for(size_t b = a + 1; b < placed.size(); ++b){
+			Resource &ra = resources_[placed[a]];
+			Resource &rb = resources_[placed[b]];
+			if(ra.offset < rb.offset + rb.size && rb.offset < ra.offset + ra.size){
+				ra.aliased = true;
+				rb.aliased = true;
+			}
+		}
+	}
+	for(int index : placed){
+		stats_.aliased_num += resources_[index].aliased ? 1 : 0;
+	}
+}
+
+void RenderGraph::BuildBarriers(ResourceStateTracker *tracker){
+	for(Pass &p : passes_){
+		p.begin_barriers.clear();
+		p.end_barriers.clear();
+	}
+	if(order_.empty()){
+		return;
+	}
+
+	for(int position = 0; position < static_cast<int>(order_.size()); ++position){
+		Pass &p = passes_[order_[position]];
+
+		//メモリを共有する一時リソースは、状態の遷移より先に切り替える
+		for(const Access &access : p.accesses){
+			const Resource &r = resources_[access.resource];
+			if(r.aliased && r.first == position){
+				RenderResourceState state{};
+				if(!tracker->GetState(r.resource, RENDER_ALL_SUBRESOURCES, &state)){
+					state = access.state;
+				}
+				p.begin_barriers.push_back({r.resource, RENDER_ALL_SUBRESOURCES, state, state, RENDER_BARRIER_ALIASING});
+			}
+		}
+		for(const Access &access : p.accesses){
+			tracker->Use(resources_[access.resource].resource, access.state);
+		}
+		tracker->Take(&p.begin_barriers);
+	}
+
+	//外部のリソースはフレームの最後に指定の状態に戻す
+	for(const Resource &r : resources_){
+		if(r.imported && r.first >= 0){
+			tracker->Use(r.resource, r.final_state);
+		}
+	}
+	tracker->Take(&passes_[order_.back()].end_barriers);
+}
+
+bool RenderGraph::Fail(const std::string &error){
+	error_ = error;
+	order_.clear();
+	for(Pass &p : passes_){
+		p.alive = false;
+	}
+	return false;
+}
@@ -0,0 +1,130 @@
+#ifndef RENDER_GRAPH_HEADER_
+#define RENDER_GRAPH_HEADER_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "RenderTypes.h"
+
+class ResourceStateTracker;
+
+//フレームグラフ
+//パスごとに読み書きするリソースを宣言し、Compileで実行順・不要なパスの削除・一時リソースのメモリの割り当てを求める
+//コンパイル結果はパスやリソースの宣言を変えるまで使い回し、バリアはフレームごとにBuildBarriersで求める
+//
+//・書き込みは前の内容に重ねるものとして扱う(前に書いたパスも生かす)
+//・外部のリソース(バックバッファなど)はフレームの出力なので、書き込むパスは削除しない
+//・一時リソースは使われる間(最初と最後のパスの間)が重ならないもの同士で同じメモリを共有する
+class RenderGraph{
+public:
+	static constexpr int INVALID_HANDLE = -1;
+
+	struct Stats{
+		uint32_t	pass_num;			//宣言したパスの数(無効にしたものを含む)
+		uint32_t	culled_num;			//無効にしたもの・出力が使われないため削除したパスの数
+		uint32_t	transient_num;
+		uint32_t	aliased_num;		//他の一時リソースとメモリを共有する一時リソースの数
+		uint64_t	transient_size;		//一時リソースに必要なメモリ
+		uint64_t	unaliased_size;		//共有しない場合に必要なメモリ
+	};
+
+public:
+	RenderGraph();
+	~RenderGraph(){}
+
+	//宣言を全て捨てる
+	void Clear();
+
+	//外部のリソースを使う(final_stateはフレームの最後に戻す状態)
+	int ImportResource(const char *name, RenderResource resource, RenderResourceState final_state);
+
+	//グラフがメモリを割り当てる一時リソース(実体はTransientOffsetの位置に呼び出し側で作成し、SetResourceで渡す)
+	int CreateTransient(const char *name, uint64_t size, uint64_t alignment);
+
+	//リソースの実体を差し替える(フレームごとに変わるバックバッファなど。コンパイルし直す必要はない)
+	void SetResource(int resource, RenderResource value);
+
+	//パスは宣言した順に提出してよいものとして依存を求める
+	int AddPass(const char *name);
+
+	//無効にしたパスは宣言しなかったものとして扱う(そのパスにしか使われないパスも削除される)
+	void SetPassEnabled(int pass, bool enabled);
+
+	//出力を使うパスがなくても削除しない
+	void SetSideEffect(int pass);
+
+	void Read(int pass, int resource, RenderResourceState state);
+	void Write(int pass, int resource, RenderResourceState state);
+
+	//失敗した場合(書き込まれていない一時リソースを読む・1つのパスで同じリソースを別の状態で使うなど)はfalseを返す
+	bool Compile();
+	const std::string& Error() const{return error_;}
+
+	//コンパイル結果
+	const std::vector<int>& Order() const{return order_;}
+	bool IsCulled(int pass) const{return !passes_[pass].alive;}
+	uint64_t TransientSize() const{return stats_.transient_size;}
+	uint64_t TransientOffset(int resource) const{return resources_[resource].offset;}
+	const Stats& GetStats() const{return stats_;}
+
+	//trackerの状態から、実行順に各パスの先頭で記録するバリアと、最後のパスの末尾で記録するバリアを求める
+	//一時リソースはメモリを共有する場合、最初に使うパスで切り替えのバリアを入れる
+	//trackerには全てのリソースの実体を登録しておくこと
+	void BuildBarriers(ResourceStateTracker *tracker);
+	const std::vector<RenderBarrier>& BeginBarriers(int pass) const{return passes_[pass].begin_barriers;}
+	const std::vector<RenderBarrier>& EndBarriers(int pass) const{return passes_[pass].end_barriers;}
+
+	int PassNum() const{return static_cast<int>(passes_.size());}
+	int ResourceNum() const{return static_cast<int>(resources_.size());}
+	const char* PassName(int pass) const{return passes_[pass].name.c_str();}
+	const char* ResourceName(int resource) const{return resources_[resource].name.c_str();}
+
+private:
+	struct Access{
+		int					resource;
+		RenderResourceState	state;
+		bool				write;
+	};
+
+	struct Pass{
+		std::string					name;
+		std::vector<Access>			accesses;
+		bool						enabled;
+		bool						side_effect;
+		bool						alive;
+		std::vector<int>			successors;		//このパスの後に実行しなければならないパス
+		std::vector<int>			consumers;		//このパスの出力を使うパス
+		int							predecessor_num;
+		std::vector<RenderBarrier>	begin_barriers;
+		std::vector<RenderBarrier>	end_barriers;
+	};
+
+	struct Resource{
+		std::string			name;
+		RenderResource		resource;
+		bool				imported;
+		RenderResourceState	final_state;
+		uint64_t			size;
+		uint64_t			alignment;
+		uint64_t			offset;
+		int					first;		//実行順で最初に使う位置(使われなければ-1)
+		int					last;
+		bool				aliased;
+	};
+
+	bool BuildDependencies();
+	void Cull();
+	void Schedule();
+	void Allocate();
+	bool Fail(const std::string &error);
+
+private:
+	std::vector<Pass>		passes_;
+	std::vector<Resource>	resources_;
+	std::vector<int>		order_;
+	std::string				error_;
+	Stats					stats_;
+};
+
+#endif
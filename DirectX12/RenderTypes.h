@@ -0,0 +1,87 @@
+#ifndef RENDER_TYPES_HEADER_
+#define RENDER_TYPES_HEADER_
+
+#include <cstdint>
+
+//バックエンドに依存しないハンドル(中身の値はバックエンドが決める。0は無効)
+template<class Tag>
+struct RenderHandle{
+	uint64_t value;
+
+	bool IsValid() const{return value != 0;}
+	bool operator==(const RenderHandle &other) const{return value == other.value;}
+	bool operator!=(const RenderHandle &other) const{return value != other.value;}
+};
+
+typedef RenderHandle<struct RenderResourceTag>			RenderResource;			//バッファ・テクスチャ(バリアの対象)
+typedef RenderHandle<struct RenderPipelineTag>			RenderPipeline;			//パイプラインステート
+typedef RenderHandle<struct RenderRootSignatureTag>		RenderRootSignature;	//ルートシグネチャ
+typedef RenderHandle<struct RenderDescriptorHeapTag>	RenderDescriptorHeap;	//シェーダから見えるデスクリプタヒープ
+typedef RenderHandle<struct RenderTargetViewTag>		RenderTargetView;		//RTV・DSV(CPU側のデスクリプタ)
+typedef RenderHandle<struct RenderDescriptorTableTag>	RenderDescriptorTable;	//デスクリプタテーブルの先頭(GPU側のデスクリプタ)
+
+typedef uint64_t RenderGpuAddress;	//バッファのGPU仮想アドレス
+
+//リソースの状態
+enum RenderResourceState : uint32_t{
+	RENDER_STATE_COMMON = 0,
+	RENDER_STATE_PRESENT = RENDER_STATE_COMMON,
+	RENDER_STATE_VERTEX_AND_CONSTANT_BUFFER,
+	RENDER_STATE_INDEX_BUFFER,
+	RENDER_STATE_RENDER_TARGET,
+	RENDER_STATE_DEPTH_WRITE,
+	RENDER_STATE_DEPTH_READ,
+	RENDER_STATE_SHADER_RESOURCE,
+	RENDER_STATE_COPY_DEST,
+	RENDER_STATE_COPY_SOURCE,
+	RENDER_STATE_GENERIC_READ,
+	RENDER_STATE_NUM,
+};
+
+//リソースの全てのサブリソース
+constexpr uint32_t RENDER_ALL_SUBRESOURCES = 0xffffffff;
+
+enum RenderBarrierType : uint32_t{
+	RENDER_BARRIER_FULL = 0,	//その場で遷移する
+	RENDER_BARRIER_BEGIN,		//分割バリアの開始(ENDまでの間は他の処理と重ねて遷移できるが、リソースは使えない)
+	RENDER_BARRIER_END,			//分割バリアの終了
+	RENDER_BARRIER_ALIASING,	//同じメモリに置いた別のリソースからresourceに切り替える(状態は変えない)
+};
+
+//状態遷移のバリア
+struct RenderBarrier{
+	RenderResource		resource;
+	uint32_t			subresource;	//RENDER_ALL_SUBRESOURCESなら全て
+	RenderResourceState	before;
+	RenderResourceState	after;
+	RenderBarrierType	type;
+};
+
+enum RenderTopology : uint32_t{
+	RENDER_TOPOLOGY_UNDEFINED = 0,
+	RENDER_TOPOLOGY_TRIANGLE_LIST,
+	RENDER_TOPOLOGY_TRIANGLE_STRIP,
+};
+
+enum RenderIndexFormat : uint32_t{
+	RENDER_INDEX_16 = 0,
+	RENDER_INDEX_32,
+};
+
+struct RenderViewport{
+	float	x;
+	float	y;
+	float	width;
+	float	height;
+	float	min_depth;
+	float	max_depth;
+};
+
+struct RenderRect{
+	int32_t	left;
+	int32_t	top;
+	int32_t	right;
+	int32_t	bottom;
+};
+
+#endif
@@ -0,0 +1,30 @@
+#ifndef RENDER_UPLOAD_HEAP_HEADER_
+#define RENDER_UPLOAD_HEAP_HEADER_
+
+#include "RenderTypes.h"
+
+//フレームごとの定数などを書き込むCPUから見えるメモリの抽象
+//割り当てた領域はFinishFrameで渡したフェンスをGPUが通過するまで使用中になる
+class RenderUploadHeap{
+public:
+	static constexpr uint64_t CONSTANT_ALIGNMENT = 256;
+
+	struct Allocation{
+		void				*cpu_address;
+		RenderGpuAddress	gpu_address;
+		uint64_t			offset;
+	};
+
+public:
+	virtual ~RenderUploadHeap(){}
+
+	//空きがなければfalseを返す(alignmentは2のべき乗)
+	virtual bool Allocate(uint64_t size, uint64_t alignment, Allocation *allocation) = 0;
+	bool AllocateConstant(uint64_t size, Allocation *allocation){return Allocate(size, CONSTANT_ALIGNMENT, allocation);}
+
+	//フレームの割り当てを締め、GPUが完了したフレームの領域を解放する
+	virtual void FinishFrame(uint64_t fence_value) = 0;
+	virtual void ReleaseCompletedFrames(uint64_t completed_fence_value) = 0;
+};
+
+#endif
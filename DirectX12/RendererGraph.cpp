@@ -0,0 +1,70 @@
+#include "RendererGraph.h"
+
+//シャドウマップとキャッシュ・ぼかしたモーメントはフレームをまたいで内容を使うので外部のリソースとして渡す
+void DeclareRendererGraph(RenderGraph *g, const RendererGraphDesc &desc, int passes[PASS_NUM], int resources[GRAPH_RESOURCE_NUM]){
+	g->Clear();
+	resources[GRAPH_BACK_BUFFER]	= g->ImportResource("back buffer", desc.resources[GRAPH_BACK_BUFFER], RENDER_STATE_PRESENT);
+	resources[GRAPH_SCENE_DEPTH]	= g->CreateTransient("scene depth", desc.scene_depth_size, desc.scene_depth_alignment);
+	resources[GRAPH_SHADOW_MAP]		= g->ImportResource("shadow map", desc.resources[GRAPH_SHADOW_MAP], RENDER_STATE_SHADER_RESOURCE);
+	resources[GRAPH_SHADOW_CACHE]	= g->ImportResource("shadow cache", desc.resources[GRAPH_SHADOW_CACHE], RENDER_STATE_COPY_SOURCE);
+	resources[GRAPH_SHADOW_BLUR]	= g->CreateTransient("shadow blur", desc.shadow_blur_size, desc.shadow_blur_alignment);
+	resources[GRAPH_SHADOW_MOMENTS]	= g->ImportResource("shadow moments", desc.resources[GRAPH_SHADOW_MOMENTS], RENDER_STATE_SHADER_RESOURCE);
+
+	g->SetResource(resources[GRAPH_SCENE_DEPTH], desc.resources[GRAPH_SCENE_DEPTH]);
+	g->SetResource(resources[GRAPH_SHADOW_BLUR], desc.resources[GRAPH_SHADOW_BLUR]);
+
+	const int back_buffer		= resources[GRAPH_BACK_BUFFER];
+	const int scene_depth		= resources[GRAPH_SCENE_DEPTH];
+	const int shadow_map		= resources[GRAPH_SHADOW_MAP];
+	const int shadow_cache		= resources[GRAPH_SHADOW_CACHE];
+	const int shadow_blur		= resources[GRAPH_SHADOW_BLUR];
+	const int shadow_moments	= resources[GRAPH_SHADOW_MOMENTS];
+
+	//キャッシュは静的なキャスターが変わったフレームだけ描き、動的なキャスターが動いたフレームはコピーした上に描く
+	passes[PASS_SHADOW_CACHE] = g->AddPass("shadow cache");
+	g->Write(passes[PASS_SHADOW_CACHE], shadow_cache, RENDER_STATE_DEPTH_WRITE);
+
+	passes[PASS_SHADOW_COPY] = g->AddPass("shadow cache copy");
+	g->Read(passes[PASS_SHADOW_COPY], shadow_cache, RENDER_STATE_COPY_SOURCE);
+	g->Write(passes[PASS_SHADOW_COPY], shadow_map, RENDER_STATE_COPY_DEST);
+
+	passes[PASS_SHADOW] = g->AddPass("shadow");
+	g->Write(passes[PASS_SHADOW], shadow_map, RENDER_STATE_DEPTH_WRITE);
+
+	//EVSMではシャドウマップを描き直したフレームだけモーメントを作り直す
+	//横にぼかしたものは縦にぼかした後は使わないので、深度バッファとメモリを共有する
+	passes[PASS_SHADOW_BLUR_X] = g->AddPass("shadow blur x");
+	g->Read(passes[PASS_SHADOW_BLUR_X], shadow_map, RENDER_STATE_SHADER_RESOURCE);
+	g->Write(passes[PASS_SHADOW_BLUR_X], shadow_blur, RENDER_STATE_RENDER_TARGET);
+
+	passes[PASS_SHADOW_BLUR_Y] = g->AddPass("shadow blur y");
+	g->Read(passes[PASS_SHADOW_BLUR_Y], shadow_blur, RENDER_STATE_SHADER_RESOURCE);
+	g->Write(passes[PASS_SHADOW_BLUR_Y], shadow_moments, RENDER_STATE_RENDER_TARGET);
+
+	passes[PASS_MAIN] = g->AddPass("main");
+	g->Read(passes[PASS_MAIN], shadow_map, RENDER_STATE_SHADER_RESOURCE);
+	if(desc.evsm){
+		g->Read(passes[PASS_MAIN], shadow_moments, RENDER_STATE_SHADER_RESOURCE);
+	}
+	g->Write(passes[PASS_MAIN], scene_depth, RENDER_STATE_DEPTH_WRITE);
+	g->Write(passes[PASS_MAIN], back_buffer, RENDER_STATE_RENDER_TARGET);
+
+	passes[PASS_DEBUG] = g->AddPass("shadow map debug");
+	g->Read(passes[PASS_DEBUG], shadow_map, RENDER_STATE_SHADER_RESOURCE);
+	g->Write(passes[PASS_DEBUG], scene_depth, RENDER_STATE_DEPTH_WRITE);
+	g->Write(passes[PASS_DEBUG], back_buffer, RENDER_STATE_RENDER_TARGET);
+}
+
+//シャドウマップの描き直しの範囲で、キャッシュ・シャドウマップ・ぼかしのパスを使うかが決まる
+bool IsRendererPassEnabled(int pass, const RendererPassState &state){
+	const ShadowCache::Redraw redraw = state.redraw;
+	switch(pass){
+		case PASS_SHADOW_CACHE:	return redraw == ShadowCache::REDRAW_FULL && state.has_static_caster;
+		case PASS_SHADOW_COPY:	return redraw != ShadowCache::REDRAW_NONE && state.has_static_caster;
+		case PASS_SHADOW:		return redraw != ShadowCache::REDRAW_NONE && (state.has_dynamic_caster || !state.has_static_caster);
+		case PASS_SHADOW_BLUR_X:
+		case PASS_SHADOW_BLUR_Y:	return state.evsm && redraw != ShadowCache::REDRAW_NONE;
+		case PASS_DEBUG:		return state.show_shadow_map;
+		default:				return true;
+	}
+}
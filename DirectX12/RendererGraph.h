@@ -0,0 +1,57 @@
+#ifndef RENDERER_GRAPH_HEADER_
+#define RENDERER_GRAPH_HEADER_
+
+#include <cstdint>
+#include "RenderGraph.h"
+#include "ShadowCache.h"
+
+//D3D12Managerのフレームグラフ(パスとリソースの宣言と、今フレームで使うパスの判定)
+//D3D12を使わないので、検証でもアプリと同じグラフを組み立てる
+
+//コマンドリストを分けて記録するパス(提出順はフレームグラフで決める)
+enum RendererPass{
+	PASS_SHADOW_CACHE,	//静的なキャスターだけのシャドウマップ(キャッシュ)
+	PASS_SHADOW_COPY,	//キャッシュをシャドウマップにコピー
+	PASS_SHADOW,		//シャドウマップ(動的なキャスター)
+	PASS_SHADOW_BLUR_X,	//EVSMのモーメントを作って横にぼかす
+	PASS_SHADOW_BLUR_Y,	//EVSMのモーメントを縦にぼかす
+	PASS_MAIN,		//通常のモデル
+	PASS_DEBUG,		//シャドウマップのデバッグ表示
+	PASS_NUM,
+};
+
+//フレームグラフで使うリソース
+enum RendererResource{
+	GRAPH_BACK_BUFFER,	//フレームごとに差し替える
+	GRAPH_SCENE_DEPTH,	//一時リソース
+	GRAPH_SHADOW_MAP,	//カスケードごとのスライスを持つ配列(描き直さないフレームは前の内容を使うので一時リソースにしない)
+	GRAPH_SHADOW_CACHE,	//静的なキャスターだけを描いたGRAPH_SHADOW_MAPと同じ形の配列
+	GRAPH_SHADOW_BLUR,	//一時リソース(横にぼかしたEVSMのモーメント)
+	GRAPH_SHADOW_MOMENTS,	//ぼかしたEVSMのモーメント(シャドウマップと同じく描き直さないフレームは前の内容を使う)
+	GRAPH_RESOURCE_NUM,
+};
+
+struct RendererGraphDesc{
+	RenderResource	resources[GRAPH_RESOURCE_NUM];	//一時リソースは今のもの(置き場所が変わらなければそのまま使う)
+	uint64_t		scene_depth_size;
+	uint64_t		scene_depth_alignment;
+	uint64_t		shadow_blur_size;
+	uint64_t		shadow_blur_alignment;
+	bool			evsm;		//フィルタがEVSM(通常の描画がぼかしたモーメントを読む)
+};
+
+//今フレームで使うパスを決めるもの
+struct RendererPassState{
+	ShadowCache::Redraw	redraw;
+	bool				has_static_caster;
+	bool				has_dynamic_caster;
+	bool				evsm;
+	bool				show_shadow_map;
+};
+
+//gを空にしてパスとリソースを宣言し、それぞれの添字をpasses・resourcesに返す
+void DeclareRendererGraph(RenderGraph *g, const RendererGraphDesc &desc, int passes[PASS_NUM], int resources[GRAPH_RESOURCE_NUM]);
+
+bool IsRendererPassEnabled(int pass, const RendererPassState &state);
+
+#endif
@@ -0,0 +1,213 @@
+#include <algorithm>
+#include "ResidencyManager.h"
+
+ResidencyManager::ResidencyManager():
+	target_(nullptr),
+	target_ratio_(DEFAULT_TARGET_RATIO),
+	frame_{},
+	objects_{},
+	unused_handles_{},
+	heads_{INVALID_HANDLE, INVALID_HANDLE},
+	tails_{INVALID_HANDLE, INVALID_HANDLE},
+	requests_{},
+	evictions_{},
+	batch_{},
+	stats_{}{}
+
+void ResidencyManager::Initialize(ResidencyTarget *target, float target_ratio){
+	target_			= target;
+	target_ratio_	= target_ratio;
+}
+
+int ResidencyManager::Register(RenderResource object, uint64_t size, MemorySegment segment){
+	int handle;
+	if(!unused_handles_.empty()){
+		handle = unused_handles_.back();
+		unused_handles_.pop_back();
+	}else{
+		objects_.emplace_back();
+		handle = static_cast<int>(objects_.size()) - 1;
+	}
+
+	Object &o = objects_[handle];
+	o.object		= object;
+	o.size			= size;
+	o.segment		= segment;
+	o.last_used		= frame_;
+	o.resident		= true;
+	o.requested		= false;
+	o.registered	= true;
+	PushBack(handle);
+
+	++stats_.object_num;
+	stats_.resident_size[segment] += size;
+	return handle;
+}
+
+void ResidencyManager::Unregister(int handle){
+	if(handle == INVALID_HANDLE || !objects_[handle].registered){
+		return;
+	}
+
+	Object &o = objects_[handle];
+	if(o.resident){
+		Remove(handle);
+		stats_.resident_size[o.segment] -= o.size;
+	}else{
+		stats_.evicted_size[o.segment] -= o.size;
+		--stats_.evicted_num;
+	}
+	o.registered	= false;
+	o.requested		= false;
+	--stats_.object_num;
+	unused_handles_.push_back(handle);
+}
+
+void ResidencyManager::BeginFrame(uint64_t frame_fence_value){
+	frame_ = frame_fence_value;
+}
+
+void ResidencyManager::Use(int handle){
+	if(handle == INVALID_HANDLE){
+		return;
+	}
+
+	Object &o = objects_[handle];
+	if(o.last_used == frame_){
+		return;
+	}
+	o.last_used = frame_;
+
+	//使った順のリストの末尾に移す
+	if(o.resident){
+		Remove(handle);
+		PushBack(handle);
+	}else if(!o.requested){
+		o.requested = true;
+		requests_.push_back(handle);
+	}
+}
+
+bool ResidencyManager::Update(uint64_t completed_fence_value){
+	bool succeeded = true;
+
+	//常駐させ直す分も使用量に含めて、予算の割合を超える分を退避する
+	uint64_t incoming[MEMORY_SEGMENT_NUM]{};
+	for(int handle : requests_){
+		if(objects_[handle].requested){
+			incoming[objects_[handle].segment] += objects_[handle].size;
+		}
+	}
+
+	bool over_budget = false;
+	for(int s = 0; s < MEMORY_SEGMENT_NUM; ++s){
+		MemoryBudget &budget = stats_.budget[s];
+		if(target_ == nullptr || !target_->QueryBudget(static_cast<MemorySegment>(s), &budget)){
+			continue;
+		}
+
+		const uint64_t limit = static_cast<uint64_t>(static_cast<double>(budget.budget) * target_ratio_);
+		uint64_t projected = budget.usage + incoming[s];
+
+		//先頭から古い順にたどり、今フレームで使うもの・GPUがまだ使っているものに当たったら止める
+		evictions_.clear();
+		batch_.clear();
+		for(int handle = heads_[s]; handle != INVALID_HANDLE && projected > limit;){
+			const Object &o = objects_[handle];
+			if(o.last_used >= frame_ || o.last_used > completed_fence_value){
+				break;
+			}
+			evictions_.push_back(handle);
+			batch_.push_back(o.object);
+			projected -= std::min(projected, o.size);
+			handle = o.next;
+		}
+
+		if(!batch_.empty()){
+			if(target_->Evict(batch_.data(), static_cast<int>(batch_.size()))){
+				for(int handle : evictions_){
+					Object &o = objects_[handle];
+					Remove(handle);
+					o.resident = false;
+					stats_.resident_size[s]	-= o.size;
+					stats_.evicted_size[s]	+= o.size;
+					++stats_.evicted_num;
+					++stats_.evict_num;
+					stats_.evict_bytes += o.size;
+				}
+			}else{
+				++stats_.failed_num;
+				projected = budget.usage + incoming[s];
+			}
+		}
+		over_budget = over_budget || (projected > budget.budget);
+	}
+	stats_.over_budget_frame_num += over_budget ? 1 : 0;
+
+	//今フレームで使うもので退避していたものをまとめて常駐させる
+	evictions_.clear();
+	batch_.clear();
+	for(int handle : requests_){
+		if(objects_[handle].requested){
+			evictions_.push_back(handle);
+			batch_.push_back(objects_[handle].object);
+		}
+	}
+	requests_.clear();
+
+	if(!batch_.empty()){
+		const bool resident = target_ != nullptr && target_->MakeResident(batch_.data(), static_cast<int>(batch_.size()));
+		for(int handle : evictions_){
+			Object &o = objects_[handle];
+
+			//失敗したものは要求を残し、次のUpdateで常駐させ直す
+			if(!resident){
+				requests_.push_back(handle);
+				continue;
+			}
+			o.requested = false;
+			o.resident = true;
+			PushBack(handle);
+			stats_.resident_size[o.segment]	+= o.size;
+			stats_.evicted_size[o.segment]	-= o.size;
+			--stats_.evicted_num;
+			++stats_.make_resident_num;
+			stats_.make_resident_bytes += o.size;
+		}
+		if(!resident){
+			++stats_.failed_num;
+			succeeded = false;
+		}
+	}
+
+	return succeeded;
+}
+
+
+void ResidencyManager::PushBack(int handle){
+	Object &o = objects_[handle];
+	o.prev = tails_[o.segment];
+	o.next = INVALID_HANDLE;
+	if(o.prev != INVALID_HANDLE){
+		objects_[o.prev].next = handle;
+	}else{
+		heads_[o.segment] = handle;
+	}
+	tails_[o.segment] = handle;
+}
+
+void ResidencyManager::Remove(int handle){
+	Object &o = objects_[handle];
+	if(o.prev != INVALID_HANDLE){
+		objects_[o.prev].next = o.next;
+	}else{
+		heads_[o.segment] = o.next;
+	}
+	if(o.next != INVALID_HANDLE){
+		objects_[o.next].prev = o.prev;
+	}else{
+		tails_[o.segment] = o.prev;
+	}
+	o.prev = INVALID_HANDLE;
+	o.next = INVALID_HANDLE;
+}
@@ -0,0 +1,117 @@
+#ifndef RESIDENCY_MANAGER_HEADER_
+#define RESIDENCY_MANAGER_HEADER_
+
+#include <cstdint>
+#include <vector>
+#include "RenderTypes.h"
+
+//メモリの種類(ディスクリートGPUではLOCALがビデオメモリ、NON_LOCALがシステムメモリ)
+enum MemorySegment{
+	MEMORY_SEGMENT_LOCAL,
+	MEMORY_SEGMENT_NON_LOCAL,
+	MEMORY_SEGMENT_NUM,
+};
+
+struct MemoryBudget{
+	uint64_t	budget;		//OSがこのプロセスに割り当てた予算
+	uint64_t	usage;		//このプロセスの現在の使用量
+};
+
+//常駐の切り替え先(D3D12ではデバイスのMakeResident/Evict、計測では予算と使用量を模したもの)
+class ResidencyTarget{
+public:
+	virtual ~ResidencyTarget(){}
+
+	virtual bool QueryBudget(MemorySegment segment, MemoryBudget *budget) = 0;
+
+	//戻るまでに常駐させる(GPUがこれから使う)
+	virtual bool MakeResident(const RenderResource *objects, int num) = 0;
+
+	//GPUが使い終わったものだけを渡す
+	virtual bool Evict(const RenderResource *objects, int num) = 0;
+};
+
+
+//メモリの常駐の管理
+//登録したもの(ヒープなど)の大きさと最後に使ったフレームを持ち、使用量が予算に近づいたら最も長く使っていないものから退避する
+//退避したものは、次に使うフレームの提出前に常駐させ直す
+//
+//1フレームの流れ: BeginFrame → 描画で使うものをUse → 提出の前にUpdate
+class ResidencyManager{
+public:
+	static constexpr int INVALID_HANDLE = -1;
+	static constexpr float DEFAULT_TARGET_RATIO = 0.9f;	//予算に対してこの割合を超えたら退避する
+
+	struct Stats{
+		MemoryBudget	budget[MEMORY_SEGMENT_NUM];			//直前のUpdateで問い合わせた値
+		uint64_t		resident_size[MEMORY_SEGMENT_NUM];	//登録したもののうち常駐しているものの合計
+		uint64_t		evicted_size[MEMORY_SEGMENT_NUM];
+		uint32_t		object_num;
+		uint32_t		evicted_num;
+		uint64_t		evict_num;				//これまでに退避した回数
+		uint64_t		evict_bytes;
+		uint64_t		make_resident_num;		//これまでに常駐させ直した回数
+		uint64_t		make_resident_bytes;
+		uint64_t		over_budget_frame_num;	//退避しても予算を超えていたフレームの数
+		uint64_t		failed_num;				//切り替えに失敗した回数
+	};
+
+public:
+	ResidencyManager();
+	~ResidencyManager(){}
+
+	void Initialize(ResidencyTarget *target, float target_ratio = DEFAULT_TARGET_RATIO);
+	void SetTargetRatio(float target_ratio){target_ratio_ = target_ratio;}
+
+	//常駐しているものとして登録する(今フレームで使ったものとして扱う)
+	int Register(RenderResource object, uint64_t size, MemorySegment segment);
+
+	//GPUが使い終わってから破棄する前に呼ぶ
+	void Unregister(int handle);
+
+	//frame_fence_valueはこのフレームの完了を表すフェンス値
+	void BeginFrame(uint64_t frame_fence_value);
+
+	//今フレームで使う(退避していればUpdateで常駐させ直す)
+	void Use(int handle);
+
+	//予算を問い合わせ、超えそうならcompleted_fence_valueまでに使い終わったものを古い順に退避し、
+	//今フレームで使うもので退避しているものを常駐させる。常駐に失敗した場合はfalseを返す
+	//失敗したものは要求を残して次のUpdateで常駐させ直すので、falseの場合はこのフレームのコマンドを提出せずにやり直す
+	bool Update(uint64_t completed_fence_value);
+
+	bool IsResident(int handle) const{return objects_[handle].resident;}
+	uint64_t LastUsed(int handle) const{return objects_[handle].last_used;}
+	const Stats& GetStats() const{return stats_;}
+
+private:
+	struct Object{
+		RenderResource	object;
+		uint64_t		size;
+		MemorySegment	segment;
+		uint64_t		last_used;
+		int				prev;		//常駐しているものの使った順のリスト(古いものが先頭)
+		int				next;
+		bool			resident;
+		bool			requested;	//今フレームで常駐させ直す
+		bool			registered;
+	};
+
+	void PushBack(int handle);
+	void Remove(int handle);
+
+private:
+	ResidencyTarget					*target_;
+	float							target_ratio_;
+	uint64_t						frame_;
+	std::vector<Object>				objects_;
+	std::vector<int>				unused_handles_;
+	int								heads_[MEMORY_SEGMENT_NUM];
+	int								tails_[MEMORY_SEGMENT_NUM];
+	std::vector<int>				requests_;		//今フレームで常駐させ直すもの
+	std::vector<int>				evictions_;		//退避するもの(作業用)
+	std::vector<RenderResource>		batch_;			//まとめて切り替える作業用
+	Stats							stats_;
+};
+
+#endif
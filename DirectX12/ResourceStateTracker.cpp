@@ -0,0 +1,143 @@
+#include "ResourceStateTracker.h"
+
+ResourceStateTracker::ResourceStateTracker():
+	resources_{},
+	pending_{},
+	stats_{}{}
+
+void ResourceStateTracker::Register(RenderResource resource, RenderResourceState state, uint32_t subresource_num){
+	Resource &r = resources_[resource.value];
+	r.states.assign(subresource_num > 0 ? subresource_num : 1, state);
+	r.splits.assign(r.states.size(), NO_SPLIT);
+}
+
+void ResourceStateTracker::Unregister(RenderResource resource){
+	resources_.erase(resource.value);
+}
+
+bool ResourceStateTracker::GetState(RenderResource resource, uint32_t subresource, RenderResourceState *state) const{
+	auto it = resources_.find(resource.value);
+	if(it == resources_.end()){
+		return false;
+	}
+
+	const Resource &r = it->second;
+	if(subresource == RENDER_ALL_SUBRESOURCES){
+		if(!IsUniform(r)){
+			return false;
+		}
+		subresource = 0;
+	}
+	if(subresource >= r.states.size()){
+		return false;
+	}
+
+	*state = r.states[subresource];
+	return true;
+}
+
+void ResourceStateTracker::Use(RenderResource resource, RenderResourceState state, uint32_t subresource){
+	auto it = resources_.find(resource.value);
+	if(it == resources_.end()){
+		++stats_.untracked_num;
+		return;
+	}
+
+	Transition(resource, &it->second, subresource, state, false);
+}
+
+void ResourceStateTracker::BeginUse(RenderResource resource, RenderResourceState state, uint32_t subresource){
+	auto it = resources_.find(resource.value);
+	if(it == resources_.end()){
+		++stats_.untracked_num;
+		return;
+	}
+
+	Transition(resource, &it->second, subresource, state, true);
+}
+
+void ResourceStateTracker::Flush(RenderCommandList *command_list){
+	if(pending_.empty()){
+		return;
+	}
+
+	command_list->ResourceBarriers(static_cast<int>(pending_.size()), pending_.data());
+	pending_.clear();
+	++stats_.batch_num;
+}
+
+void ResourceStateTracker::Take(std::vector<RenderBarrier> *barriers){
+	if(pending_.empty()){
+		return;
+	}
+
+	barriers->insert(barriers->end(), pending_.begin(), pending_.end());
+	pending_.clear();
+	++stats_.batch_num;
+}
+
+void ResourceStateTracker::Transition(RenderResource resource, Resource *r, uint32_t subresource, RenderResourceState state, bool begin){
+	const uint32_t num = static_cast<uint32_t>(r->states.size());
+	const RenderBarrierType type = begin ? RENDER_BARRIER_BEGIN : RENDER_BARRIER_FULL;
+
+	//全てのサブリソースが同じ状態なら1つのバリアでまとめて遷移する
+	if(subresource == RENDER_ALL_SUBRESOURCES && IsUniform(*r)){
+		if(r->splits[0] != NO_SPLIT){
+			pending_.push_back({resource, RENDER_ALL_SUBRESOURCES, r->states[0], r->splits[0], RENDER_BARRIER_END});
+			r->states.assign(num, r->splits[0]);
+			r->splits.assign(num, NO_SPLIT);
+		}
+		if(r->states[0] == state){
+			++stats_.redundant_num;
+			return;
+		}
+
+		pending_.push_back({resource, RENDER_ALL_SUBRESOURCES, r->states[0], state, type});
+		++stats_.transition_num;
+		stats_.split_num += begin ? 1 : 0;
+		if(begin){
+			r->splits.assign(num, state);
+		}else{
+			r->states.assign(num, state);
+		}
+		return;
+	}
+
+	//サブリソースごとに遷移する
+	const uint32_t first = (subresource == RENDER_ALL_SUBRESOURCES) ? 0 : subresource;
+	const uint32_t last = (subresource == RENDER_ALL_SUBRESOURCES) ? num : subresource + 1;
+	if(last > num){
+		++stats_.untracked_num;
+		return;
+	}
+
+	for(uint32_t i = first; i < last; ++i){
+		if(r->splits[i] != NO_SPLIT){
+			pending_.push_back({resource, i, r->states[i], r->splits[i], RENDER_BARRIER_END});
+			r->states[i] = r->splits[i];
+			r->splits[i] = NO_SPLIT;
+		}
+		if(r->states[i] == state){
+			++stats_.redundant_num;
+			continue;
+		}
+
+		pending_.push_back({resource, i, r->states[i], state, type});
+		++stats_.transition_num;
+		stats_.split_num += begin ? 1 : 0;
+		if(begin){
+			r->splits[i] = state;
+		}else{
+			r->states[i] = state;
+		}
+	}
+}
+
+bool ResourceStateTracker::IsUniform(const Resource &r){
+	for(size_t i = 1; i < r.states.size(); ++i){
+		if(r.states[i] != r.states[0] || r.splits[i] != r.splits[0]){
+			return false;
+		}
+	}
+	return true;
+}
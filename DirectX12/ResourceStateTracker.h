@@ -0,0 +1,67 @@
+#ifndef RESOURCE_STATE_TRACKER_HEADER_
+#define RESOURCE_STATE_TRACKER_HEADER_
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include "RenderTypes.h"
+#include "RenderCommandList.h"
+
+//リソース(サブリソース)の現在の状態を追跡し、使い方の宣言から必要なバリアを求める
+//求めたバリアは溜めておき、Flushで1回の呼び出しにまとめて記録する
+//同じ状態への遷移は記録せず、分割バリア(BeginUse)の途中で使えば終了のバリアを記録する
+//状態はコマンドの提出順に宣言すること(別のスレッドで記録するパスは、記録の前にメインスレッドで宣言してTakeで渡す)
+class ResourceStateTracker{
+public:
+	struct Stats{
+		uint64_t	transition_num;		//記録したバリアの数
+		uint64_t	redundant_num;		//既にその状態で、バリアが要らなかった宣言の数
+		uint64_t	split_num;			//分割バリアの数(開始と終了で1つ)
+		uint64_t	batch_num;			//Flush・Takeでまとめて渡した回数
+		uint64_t	untracked_num;		//登録していないリソースの宣言の数
+	};
+
+public:
+	ResourceStateTracker();
+	~ResourceStateTracker(){}
+
+	//作成時の状態を登録する(subresource_numはミップ数×配列数など)
+	void Register(RenderResource resource, RenderResourceState state, uint32_t subresource_num = 1);
+	void Unregister(RenderResource resource);
+	bool GetState(RenderResource resource, uint32_t subresource, RenderResourceState *state) const;
+
+	//resourceをstateで使うことを宣言する(必要なバリアを溜める)
+	void Use(RenderResource resource, RenderResourceState state, uint32_t subresource = RENDER_ALL_SUBRESOURCES);
+
+	//stateへの遷移を開始だけしておく(次のUseで終了する。間の処理と遷移を重ねられる)
+	void BeginUse(RenderResource resource, RenderResourceState state, uint32_t subresource = RENDER_ALL_SUBRESOURCES);
+
+	//溜めたバリアをまとめて記録する
+	void Flush(RenderCommandList *command_list);
+
+	//溜めたバリアをbarriersの後ろに移す(別のスレッドで記録するコマンドリストに渡す場合)
+	void Take(std::vector<RenderBarrier> *barriers);
+
+	size_t PendingNum() const{return pending_.size();}
+	const Stats& GetStats() const{return stats_;}
+	void ResetStats(){stats_ = {};}
+
+private:
+	static constexpr RenderResourceState NO_SPLIT = RENDER_STATE_NUM;
+
+	struct Resource{
+		std::vector<RenderResourceState>	states;		//サブリソースごとの状態
+		std::vector<RenderResourceState>	splits;		//分割バリアの遷移後の状態(NO_SPLITなら遷移中でない)
+	};
+
+	void Transition(RenderResource resource, Resource *r, uint32_t subresource, RenderResourceState state, bool begin);
+	static bool IsUniform(const Resource &r);
+
+private:
+	std::unordered_map<uint64_t, Resource>	resources_;
+	std::vector<RenderBarrier>				pending_;
+	Stats									stats_;
+};
+
+#endif
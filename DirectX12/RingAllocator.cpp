@@ -0,0 +1,86 @@
+#include "RingAllocator.h"
+
+namespace{
+uint64_t AlignUp(uint64_t v, uint64_t alignment){
+	return (v + alignment - 1) & ~(alignment - 1);
+}
+}
+
+RingAllocator::RingAllocator():
+	RingAllocator(0){}
+
+RingAllocator::RingAllocator(uint64_t size):
+	size_(size),
+	head_{},
+	tail_{},
+	used_{},
+	frame_size_{},
+	frames_{}{}
+
+void RingAllocator::Reset(uint64_t size){
+	size_		= size;
+	head_		= 0;
+	tail_		= 0;
+	used_		= 0;
+	frame_size_	= 0;
+	frames_.clear();
+}
+
+uint64_t RingAllocator::Allocate(uint64_t size, uint64_t alignment){
+	if(size == 0 || size > size_ || IsFull()){
+		return INVALID_OFFSET;
+	}
+
+	//空のときは先頭に戻して断片化を防ぐ(締めていない割り当てがないときのみ)
+	if(IsEmpty() && frames_.empty()){
+		head_ = 0;
+		tail_ = 0;
+	}
+
+	const uint64_t aligned = AlignUp(head_, alignment);
+
+	if(head_ >= tail_){
+		//空き領域は[head, size)と[0, tail)
+		if(aligned + size <= size_){
+			const uint64_t consumed = aligned + size - head_;
+			used_		+= consumed;
+			frame_size_	+= consumed;
+			head_		 = aligned + size;
+			return aligned;
+		}
+
+		//末尾に収まらなければ先頭に回り込む(末尾の残りは捨てる)
+		if(size <= tail_){
+			const uint64_t consumed = (size_ - head_) + size;
+			used_		+= consumed;
+			frame_size_	+= consumed;
+			head_		 = size;
+			return 0;
+		}
+	}else{
+		//空き領域は[head, tail)
+		if(aligned + size <= tail_){
+			const uint64_t consumed = aligned + size - head_;
+			used_		+= consumed;
+			frame_size_	+= consumed;
+			head_		 = aligned + size;
+			return aligned;
+		}
+	}
+
+	return INVALID_OFFSET;
+}
+
+void RingAllocator::FinishFrame(uint64_t fence_value){
+	frames_.push_back({fence_value, head_, frame_size_});
+	frame_size_ = 0;
+}
+
+void RingAllocator::ReleaseCompletedFrames(uint64_t completed_fence_value){
+	while(!frames_.empty() && frames_.front().fence_value <= completed_fence_value){
+		const FrameMark &mark = frames_.front();
+		tail_  = mark.end;
+		used_ -= mark.size;
+		frames_.pop_front();
+	}
+}
@@ -0,0 +1,54 @@
+#ifndef RING_ALLOCATOR_HEADER_
+#define RING_ALLOCATOR_HEADER_
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+
+//リングバッファ上の領域の割り当て(オフセットの管理のみで、メモリ自体は持たない)
+//フレームごとにフェンス値を記録し、GPUがそのフェンスを通過したら領域を解放する
+class RingAllocator{
+public:
+	static constexpr uint64_t INVALID_OFFSET = ~0ull;
+
+	struct FrameMark{
+		uint64_t	fence_value;
+		uint64_t	end;		//フレーム終了時のhead
+		uint64_t	size;		//フレーム中に消費したサイズ(アライメントの詰め物を含む)
+	};
+
+public:
+	RingAllocator();
+	explicit RingAllocator(uint64_t size);
+	~RingAllocator(){}
+
+	void Reset(uint64_t size);
+
+	//割り当てたオフセットを返す(空きがなければINVALID_OFFSET)
+	//alignmentは2のべき乗であること
+	uint64_t Allocate(uint64_t size, uint64_t alignment);
+
+	//これまでの割り当てをfence_valueのフレームのものとして締める
+	void FinishFrame(uint64_t fence_value);
+
+	//completed_fence_value以下のフレームの領域を解放する
+	void ReleaseCompletedFrames(uint64_t completed_fence_value);
+
+	uint64_t Size() const{return size_;}
+	uint64_t UsedSize() const{return used_;}
+	uint64_t Head() const{return head_;}
+	uint64_t Tail() const{return tail_;}
+	bool IsEmpty() const{return used_ == 0;}
+	bool IsFull() const{return used_ == size_;}
+	size_t PendingFrameNum() const{return frames_.size();}
+
+private:
+	uint64_t				size_;
+	uint64_t				head_;		//次に割り当てる位置
+	uint64_t				tail_;		//GPUが使用中の最も古い位置
+	uint64_t				used_;
+	uint64_t				frame_size_;
+	std::deque<FrameMark>	frames_;
+};
+
+#endif
@@ -0,0 +1,549 @@
+#include <algorithm>
+#include <cmath>
+#include <future>
+#include "Scene.h"
+#include "JobSystem.h"
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#define SCENE_AVX
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SCENE_SSE2
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define SCENE_NEON
+#endif
+
+namespace{
+//LANE_NUM個のエンティティ分の値を持つベクトル
+#if defined(SCENE_AVX)
+constexpr int LANE_NUM = 8;
+struct FloatN{
+	__m256 v;
+};
+inline FloatN Load(const float *src){return {_mm256_loadu_ps(src)};}
+inline void Store(float *dst, FloatN a){_mm256_storeu_ps(dst, a.v);}
+inline FloatN Splat(float a){return {_mm256_set1_ps(a)};}
+inline FloatN operator+(FloatN a, FloatN b){return {_mm256_add_ps(a.v, b.v)};}
+inline FloatN operator-(FloatN a, FloatN b){return {_mm256_sub_ps(a.v, b.v)};}
+inline FloatN operator*(FloatN a, FloatN b){return {_mm256_mul_ps(a.v, b.v)};}
+#elif defined(SCENE_SSE2)
+constexpr int LANE_NUM = 4;
+struct FloatN{
+	__m128 v;
+};
+inline FloatN Load(const float *src){return {_mm_loadu_ps(src)};}
+inline void Store(float *dst, FloatN a){_mm_storeu_ps(dst, a.v);}
+inline FloatN Splat(float a){return {_mm_set1_ps(a)};}
+inline FloatN operator+(FloatN a, FloatN b){return {_mm_add_ps(a.v, b.v)};}
+inline FloatN operator-(FloatN a, FloatN b){return {_mm_sub_ps(a.v, b.v)};}
+inline FloatN operator*(FloatN a, FloatN b){return {_mm_mul_ps(a.v, b.v)};}
+#elif defined(SCENE_NEON)
+constexpr int LANE_NUM = 4;
+struct FloatN{
+	float32x4_t v;
+};
+inline FloatN Load(const float *src){return {vld1q_f32(src)};}
+inline void Store(float *dst, FloatN a){vst1q_f32(dst, a.v);}
+inline FloatN Splat(float a){return {vdupq_n_f32(a)};}
+inline FloatN operator+(FloatN a, FloatN b){return {vaddq_f32(a.v, b.v)};}
+inline FloatN operator-(FloatN a, FloatN b){return {vsubq_f32(a.v, b.v)};}
+inline FloatN operator*(FloatN a, FloatN b){return {vmulq_f32(a.v, b.v)};}
+#else
+constexpr int LANE_NUM = 4;
+struct FloatN{
+	float v[4];
+};
+inline FloatN Load(const float *src){return {{src[0], src[1], src[2], src[3]}};}
+inline void Store(float *dst, FloatN a){dst[0] = a.v[0]; dst[1] = a.v[1]; dst[2] = a.v[2]; dst[3] = a.v[3];}
+inline FloatN Splat(float a){return {{a, a, a, a}};}
+inline FloatN operator+(FloatN a, FloatN b){return {{a.v[0] + b.v[0], a.v[1] + b.v[1], a.v[2] + b.v[2], a.v[3] + b.v[3]}};}
+inline FloatN operator-(FloatN a, FloatN b){return {{a.v[0] - b.v[0], a.v[1] - b.v[1], a.v[2] - b.v[2], a.v[3] - b.v[3]}};}
+inline FloatN operator*(FloatN a, FloatN b){return {{a.v[0] * b.v[0], a.v[1] * b.v[1], a.v[2] * b.v[2], a.v[3] * b.v[3]}};}
+#endif
+static_assert(Scene::SIMD_WIDTH % LANE_NUM == 0, "padding must be a multiple of the lane count");
+
+//SIMDで端数を気にせず読めるように、深さの途中から読み始めても配列の外に出ない長さにする
+size_t PaddedSize(int num){
+	return static_cast<size_t>((num + Scene::SIMD_WIDTH - 1) / Scene::SIMD_WIDTH * Scene::SIMD_WIDTH + Scene::SIMD_WIDTH);
+}
+
+//配列上の位置を入れ替える(dst[order[i]] = src[i])
+template<typename T>
+void Permute(std::vector<T> *values, const std::vector<uint32_t> &order, int num){
+	std::vector<T> permuted(*values);
+	for(int i = 0; i < num; ++i){
+		permuted[order[i]] = (*values)[i];
+	}
+	values->swap(permuted);
+}
+}
+
+
+Scene::Scene():
+	parents_{},
+	slots_{},
+	entities_{},
+	parent_slots_{},
+	level_begin_{0},
+	local_{},
+	world_{},
+	local_dirty_{},
+	world_dirty_{},
+	hierarchy_dirty_{},
+	camera_{},
+	camera_dirty_{},
+	view_{},
+	projection_{},
+	view_proj_{},
+	updated_num_{}{}
+
+//エンティティを全て消す(カメラはそのまま)
+void Scene::Clear(){
+	parents_.clear();
+	slots_.clear();
+	entities_.clear();
+	parent_slots_.clear();
+	level_begin_.assign(1, 0);
+	for(auto &l : local_){
+		l.clear();
+	}
+	for(auto &w : world_){
+		w.clear();
+	}
+	local_dirty_.clear();
+	world_dirty_.clear();
+	hierarchy_dirty_ = false;
+	updated_num_ = 0;
+}
+
+Scene::Entity Scene::Create(Entity parent){
+	const int num = Num();
+	const Entity entity = static_cast<Entity>(num);
+
+	//末尾に根として加え、深さの順に並べ直すのは次のUpdateで行う
+	parents_.push_back(INVALID_ENTITY);
+	slots_.push_back(static_cast<uint32_t>(num));
+	entities_.push_back(entity);
+	parent_slots_.push_back(INVALID_ENTITY);
+	local_dirty_.push_back(1);
+	world_dirty_.push_back(0);
+
+	const size_t padded = PaddedSize(num + 1);
+	for(auto &l : local_){
+		l.resize(padded, 0.0f);
+	}
+	for(auto &w : world_){
+		w.resize(padded, 0.0f);
+	}
+	local_[LOCAL_ROTATION_W][num]	= 1.0f;
+	local_[LOCAL_SCALE_X][num]		= 1.0f;
+	local_[LOCAL_SCALE_Y][num]		= 1.0f;
+	local_[LOCAL_SCALE_Z][num]		= 1.0f;
+	hierarchy_dirty_ = true;
+
+	if(parent != INVALID_ENTITY){
+		SetParent(entity, parent);
+	}
+	return entity;
+}
+
+bool Scene::SetParent(Entity entity, Entity parent){
+	if(parents_[entity] == parent){
+		return true;
+	}
+
+	//親をたどって自分に着けば輪になる
+	for(Entity a = parent; a != INVALID_ENTITY; a = parents_[a]){
+		if(a == entity){
+			return false;
+		}
+	}
+
+	parents_[entity] = parent;
+	local_dirty_[slots_[entity]] = 1;
+	hierarchy_dirty_ = true;
+	return true;
+}
+
+void Scene::SetPosition(Entity entity, float x, float y, float z){
+	const uint32_t slot = slots_[entity];
+	local_[LOCAL_POSITION_X][slot] = x;
+	local_[LOCAL_POSITION_Y][slot] = y;
+	local_[LOCAL_POSITION_Z][slot] = z;
+	local_dirty_[slot] = 1;
+}
+
+void Scene::SetRotation(Entity entity, const float quaternion[4]){
+	const uint32_t slot = slots_[entity];
+	for(int i = 0; i < 4; ++i){
+		local_[LOCAL_ROTATION_X + i][slot] = quaternion[i];
+	}
+	local_dirty_[slot] = 1;
+}
+
+void Scene::SetScale(Entity entity, float x, float y, float z){
+	const uint32_t slot = slots_[entity];
+	local_[LOCAL_SCALE_X][slot] = x;
+	local_[LOCAL_SCALE_Y][slot] = y;
+	local_[LOCAL_SCALE_Z][slot] = z;
+	local_dirty_[slot] = 1;
+}
+
+void Scene::SetCamera(const Camera &camera){
+	camera_ = camera;
+	camera_dirty_ = true;
+}
+
+
+//エンティティを深さの順に並べ直す
+//根から幅優先にたどり、兄弟を続けて並べる(親のワールド変換を前から順に読むようになる)。兄弟の中では今の並びを保つ
+void Scene::Rebuild(){
+	const int num = Num();
+
+	//今の並びの順に、エンティティごとの子の列を作る
+	std::vector<int> child_begin(num + 1, 0);
+	for(int e = 0; e < num; ++e){
+		if(parents_[e] != INVALID_ENTITY){
+			++child_begin[parents_[e] + 1];
+		}
+	}
+	for(int e = 0; e < num; ++e){
+		child_begin[e + 1] += child_begin[e];
+	}
+	std::vector<int> cursors(child_begin.begin(), child_begin.end() - 1);
+	std::vector<Entity> children(num);
+	std::vector<Entity> sorted;
+	sorted.reserve(num);
+	for(int s = 0; s < num; ++s){
+		const Entity e = entities_[s];
+		if(parents_[e] == INVALID_ENTITY){
+			sorted.push_back(e);
+		}else{
+			children[cursors[parents_[e]]++] = e;
+		}
+	}
+
+	//1つ浅い深さのものの子を順に加える
+	level_begin_.assign(1, 0);
+	while(level_begin_.back() < static_cast<int>(sorted.size())){
+		const int begin = level_begin_.back();
+		const int end = static_cast<int>(sorted.size());
+		level_begin_.push_back(end);
+		for(int i = begin; i < end; ++i){
+			const Entity e = sorted[i];
+			sorted.insert(sorted.end(), children.begin() + child_begin[e], children.begin() + child_begin[e + 1]);
+		}
+	}
+
+	//今の位置ごとの新しい位置
+	std::vector<uint32_t> order(num);
+	for(int s = 0; s < num; ++s){
+		order[slots_[sorted[s]]] = static_cast<uint32_t>(s);
+	}
+
+	for(auto &l : local_){
+		Permute(&l, order, num);
+	}
+	for(auto &w : world_){
+		Permute(&w, order, num);
+	}
+	Permute(&local_dirty_, order, num);
+	Permute(&world_dirty_, order, num);
+	Permute(&entities_, order, num);
+
+	for(int s = 0; s < num; ++s){
+		slots_[entities_[s]] = static_cast<uint32_t>(s);
+	}
+	for(int s = 0; s < num; ++s){
+		const Entity parent = parents_[entities_[s]];
+		parent_slots_[s] = (parent == INVALID_ENTITY) ? INVALID_ENTITY : slots_[parent];
+	}
+	hierarchy_dirty_ = false;
+}
+
+void Scene::UpdateCamera(){
+	view_		= Matrix::LookAtLH(camera_.eye, camera_.focus, camera_.up);
+	projection_	= Matrix::PerspectiveFovLH(camera_.fov_y, camera_.aspect, camera_.near_z, camera_.far_z);
+	view_proj_	= view_ * projection_;
+	camera_dirty_ = false;
+}
+
+
+//範囲の印を決める(ローカルの変換を変えたか、親のワールド変換が変わったもの)。1つでもあればtrue
+bool Scene::PropagateDirty(int begin, int end){
+	uint8_t any = 0;
+	for(int s = begin; s < end; ++s){
+		uint8_t dirty = local_dirty_[s];
+		const uint32_t parent = parent_slots_[s];
+		if(parent != INVALID_ENTITY){
+			dirty |= world_dirty_[parent];
+		}
+		world_dirty_[s] = dirty;
+		local_dirty_[s] = 0;
+		any |= dirty;
+	}
+	return any != 0;
+}
+
+//同じ深さの範囲をLANE_NUM個ずつ求める
+int Scene::UpdateRange(int begin, int end){
+	if(!PropagateDirty(begin, end)){
+		return 0;
+	}
+
+	//深さ0は根だけ、それ以外は全て親を持つ
+	const bool root = (parent_slots_[begin] == INVALID_ENTITY);
+	const FloatN one = Splat(1.0f);
+
+	int updated = 0;
+	for(int g = begin; g < end; g += LANE_NUM){
+		const int n = std::min(LANE_NUM, end - g);
+		int dirty_num = 0;
+		for(int i = 0; i < n; ++i){
+			dirty_num += world_dirty_[g + i];
+		}
+		if(dirty_num == 0){
+			continue;
+		}
+		updated += dirty_num;
+
+		//四元数から回転行列を作り、行ごとに拡大率を掛ける(最後の行は平行移動)
+		const FloatN qx = Load(&local_[LOCAL_ROTATION_X][g]);
+		const FloatN qy = Load(&local_[LOCAL_ROTATION_Y][g]);
+		const FloatN qz = Load(&local_[LOCAL_ROTATION_Z][g]);
+		const FloatN qw = Load(&local_[LOCAL_ROTATION_W][g]);
+		const FloatN x2 = qx + qx;
+		const FloatN y2 = qy + qy;
+		const FloatN z2 = qz + qz;
+		const FloatN xx = qx * x2, yy = qy * y2, zz = qz * z2;
+		const FloatN xy = qx * y2, xz = qx * z2, yz = qy * z2;
+		const FloatN wx = qw * x2, wy = qw * y2, wz = qw * z2;
+
+		const FloatN sx = Load(&local_[LOCAL_SCALE_X][g]);
+		const FloatN sy = Load(&local_[LOCAL_SCALE_Y][g]);
+		const FloatN sz = Load(&local_[LOCAL_SCALE_Z][g]);
+		const FloatN local[4][3] = {
+			{sx * (one - (yy + zz)), sx * (xy + wz), sx * (xz - wy)},
+			{sy * (xy - wz), sy * (one - (xx + zz)), sy * (yz + wx)},
+			{sz * (xz + wy), sz * (yz - wx), sz * (one - (xx + yy))},
+			{Load(&local_[LOCAL_POSITION_X][g]), Load(&local_[LOCAL_POSITION_Y][g]), Load(&local_[LOCAL_POSITION_Z][g])},
+		};
+
+		FloatN world[4][3];
+		if(root){
+			for(int r = 0; r < 4; ++r){
+				for(int c = 0; c < 3; ++c){
+					world[r][c] = local[r][c];
+				}
+			}
+		}else{
+			//親のワールド変換をレーンに集める(端数のレーンは使わない)
+			float gathered[WORLD_COMPONENT_NUM][LANE_NUM] = {};
+			for(int i = 0; i < n; ++i){
+				const uint32_t parent = parent_slots_[g + i];
+				for(int c = 0; c < WORLD_COMPONENT_NUM; ++c){
+					gathered[c][i] = world_[c][parent];
+				}
+			}
+			FloatN p[4][3];
+			for(int r = 0; r < 4; ++r){
+				for(int c = 0; c < 3; ++c){
+					p[r][c] = Load(gathered[r * 3 + c]);
+				}
+			}
+
+			for(int r = 0; r < 4; ++r){
+				for(int c = 0; c < 3; ++c){
+					world[r][c] = local[r][0] * p[0][c] + local[r][1] * p[1][c] + local[r][2] * p[2][c];
+				}
+			}
+			for(int c = 0; c < 3; ++c){
+				world[3][c] = world[3][c] + p[3][c];
+			}
+		}
+
+		//端数の組は次の深さに書き込まないように、使うレーンだけを書き写す
+		if(n == LANE_NUM){
+			for(int r = 0; r < 4; ++r){
+				for(int c = 0; c < 3; ++c){
+					Store(&world_[r * 3 + c][g], world[r][c]);
+				}
+			}
+		}else{
+			float lanes[LANE_NUM];
+			for(int r = 0; r < 4; ++r){
+				for(int c = 0; c < 3; ++c){
+					Store(lanes, world[r][c]);
+					std::copy(lanes, lanes + n, &world_[r * 3 + c][g]);
+				}
+			}
+		}
+	}
+	return updated;
+}
+
+int Scene::UpdateRangeScalar(int begin, int end){
+	if(!PropagateDirty(begin, end)){
+		return 0;
+	}
+
+	int updated = 0;
+	for(int s = begin; s < end; ++s){
+		if(world_dirty_[s] == 0){
+			continue;
+		}
+		++updated;
+
+		const float qx = local_[LOCAL_ROTATION_X][s];
+		const float qy = local_[LOCAL_ROTATION_Y][s];
+		const float qz = local_[LOCAL_ROTATION_Z][s];
+		const float qw = local_[LOCAL_ROTATION_W][s];
+		const float sx = local_[LOCAL_SCALE_X][s];
+		const float sy = local_[LOCAL_SCALE_Y][s];
+		const float sz = local_[LOCAL_SCALE_Z][s];
+		const float local[4][3] = {
+			{sx * (1.0f - 2.0f * (qy * qy + qz * qz)), sx * 2.0f * (qx * qy + qz * qw), sx * 2.0f * (qx * qz - qy * qw)},
+			{sy * 2.0f * (qx * qy - qz * qw), sy * (1.0f - 2.0f * (qx * qx + qz * qz)), sy * 2.0f * (qy * qz + qx * qw)},
+			{sz * 2.0f * (qx * qz + qy * qw), sz * 2.0f * (qy * qz - qx * qw), sz * (1.0f - 2.0f * (qx * qx + qy * qy))},
+			{local_[LOCAL_POSITION_X][s], local_[LOCAL_POSITION_Y][s], local_[LOCAL_POSITION_Z][s]},
+		};
+
+		const uint32_t parent = parent_slots_[s];
+		for(int r = 0; r < 4; ++r){
+			for(int c = 0; c < 3; ++c){
+				float value = local[r][c];
+				if(parent != INVALID_ENTITY){
+					value = local[r][0] * world_[c][parent] + local[r][1] * world_[3 + c][parent] + local[r][2] * world_[6 + c][parent];
+					if(r == 3){
+						value += world_[9 + c][parent];
+					}
+				}
+				world_[r * 3 + c][s] = value;
+			}
+		}
+	}
+	return updated;
+}
+
+int Scene::Update(JobSystem *jobs){
+	if(hierarchy_dirty_){
+		Rebuild();
+	}
+	if(camera_dirty_){
+		UpdateCamera();
+	}
+
+	//親の深さを求め終えてから子の深さを求める
+	updated_num_ = 0;
+	for(int l = 0; l < LevelNum(); ++l){
+		const int begin = level_begin_[l];
+		const int end = level_begin_[l + 1];
+		const int count = end - begin;
+		if(jobs == nullptr || count < MIN_JOB_ENTITY_NUM * 2){
+			updated_num_ += UpdateRange(begin, end);
+			continue;
+		}
+
+		//深さの中をスレッド数の数倍に分けて負荷を均す(区切りはSIMD_WIDTHの倍数にして、端数の組は深さの最後だけにする)
+		const int chunk_num = std::min(count / MIN_JOB_ENTITY_NUM, static_cast<int>(jobs->ThreadNum()) * 4);
+		const int chunk_size = ((count + chunk_num - 1) / chunk_num + SIMD_WIDTH - 1) / SIMD_WIDTH * SIMD_WIDTH;
+
+		std::vector<std::future<int>> results;
+		for(int b = begin; b < end; b += chunk_size){
+			const int e = std::min(end, b + chunk_size);
+			results.push_back(jobs->Push([=]{return UpdateRange(b, e);}));
+		}
+		for(auto &r : results){
+			updated_num_ += r.get();
+		}
+	}
+	return updated_num_;
+}
+
+int Scene::UpdateScalar(){
+	if(hierarchy_dirty_){
+		Rebuild();
+	}
+	if(camera_dirty_){
+		UpdateCamera();
+	}
+
+	updated_num_ = 0;
+	for(int l = 0; l < LevelNum(); ++l){
+		updated_num_ += UpdateRangeScalar(level_begin_[l], level_begin_[l + 1]);
+	}
+	return updated_num_;
+}
+
+
+Scene::Matrix Scene::World(Entity entity) const{
+	const uint32_t slot = slots_[entity];
+	Matrix m{};
+	for(int r = 0; r < 4; ++r){
+		for(int c = 0; c < 3; ++c){
+			m.m[r][c] = world_[r * 3 + c][slot];
+		}
+	}
+	m.m[3][3] = 1.0f;
+	return m;
+}
+
+void Scene::WorldPosition(Entity entity, float position[3]) const{
+	const uint32_t slot = slots_[entity];
+	for(int c = 0; c < 3; ++c){
+		position[c] = world_[9 + c][slot];
+	}
+}
+
+
+void Scene::RotationX(float angle, float quaternion[4]){
+	quaternion[0] = std::sin(0.5f * angle);
+	quaternion[1] = 0.0f;
+	quaternion[2] = 0.0f;
+	quaternion[3] = std::cos(0.5f * angle);
+}
+
+void Scene::RotationY(float angle, float quaternion[4]){
+	quaternion[0] = 0.0f;
+	quaternion[1] = std::sin(0.5f * angle);
+	quaternion[2] = 0.0f;
+	quaternion[3] = std::cos(0.5f * angle);
+}
+
+void Scene::RotationZ(float angle, float quaternion[4]){
+	quaternion[0] = 0.0f;
+	quaternion[1] = 0.0f;
+	quaternion[2] = std::sin(0.5f * angle);
+	quaternion[3] = std::cos(0.5f * angle);
+}
+
+//行ベクトルに掛ける並びではaを先に回すので、積はb * aになる
+void Scene::MultiplyRotation(const float a[4], const float b[4], float quaternion[4]){
+	const float x = b[3] * a[0] + a[3] * b[0] + (b[1] * a[2] - b[2] * a[1]);
+	const float y = b[3] * a[1] + a[3] * b[1] + (b[2] * a[0] - b[0] * a[2]);
+	const float z = b[3] * a[2] + a[3] * b[2] + (b[0] * a[1] - b[1] * a[0]);
+	const float w = b[3] * a[3] - (b[0] * a[0] + b[1] * a[1] + b[2] * a[2]);
+	quaternion[0] = x;
+	quaternion[1] = y;
+	quaternion[2] = z;
+	quaternion[3] = w;
+}
+
+
+const char* Scene::InstructionSet(){
+#if defined(SCENE_AVX)
+	return "AVX";
+#elif defined(SCENE_SSE2)
+	return "SSE2";
+#elif defined(SCENE_NEON)
+	return "NEON";
+#else
+	return "scalar";
+#endif
+}
+
+int Scene::LaneNum(){
+	return LANE_NUM;
+}
@@ -0,0 +1,119 @@
+#ifndef SCENE_HEADER_
+#define SCENE_HEADER_
+
+#include <cstdint>
+#include <vector>
+#include "ShadowCascades.h"
+
+class JobSystem;
+
+//シーンのオブジェクトの変換をデータ指向で持つ
+//・エンティティは番号だけで、ローカルの変換(位置・回転の四元数・拡大率)とワールド変換行列を成分ごとの配列(SoA)で持つ
+//・配列は階層の深さの順に並べる(親は必ず子より前の深さにある)。深さごとにSIMDで4個(AVXでは8個)ずつ親のワールド変換を掛ける
+//・ローカルの変換を変えたものに印を付け、深さの順に子へ伝える。印の付いたものが1つもないSIMDの組は求め直さない
+//・同じ深さのエンティティは互いに依存しないので、多ければジョブに分けて並列に求める
+//・カメラのビュー・プロジェクション行列はフレームに1回だけ(カメラを変えたときだけ)求める
+//
+//行列はDirectXMathと同じく行ベクトルに右から掛ける並びで、ワールド = 拡大 * 回転 * 平行移動 * 親のワールド
+//回転の四元数は(x, y, z, w)で、XMQuaternionRotationRollPitchYawなどと同じ向き
+//使い方: Create/SetParent → SetPosition/SetRotation/SetScale(フレームごと) → Update → World
+class Scene{
+public:
+	typedef uint32_t Entity;
+	typedef ShadowCascades::Matrix Matrix;
+	typedef ShadowCascades::Camera Camera;
+
+	static constexpr Entity INVALID_ENTITY = 0xffffffff;
+	static constexpr int SIMD_WIDTH = 8;				//配列の長さはこの倍数に切り上げる(SSE・NEONでは4個ずつ求める)
+	static constexpr int MIN_JOB_ENTITY_NUM = 8192;		//ジョブ1つに任せる最小の数(これの2倍より少ない深さはジョブに分けない)
+
+public:
+	Scene();
+	~Scene(){}
+
+	void Clear();
+
+	//ローカルの変換は単位(原点・回転なし・拡大率1)
+	Entity Create(Entity parent = INVALID_ENTITY);
+
+	//parentをINVALID_ENTITYにすると根にする。自分や子孫を親にしようとした場合はfalse
+	bool SetParent(Entity entity, Entity parent);
+	Entity Parent(Entity entity) const{return parents_[entity];}
+	int Num() const{return static_cast<int>(parents_.size());}
+
+	void SetPosition(Entity entity, float x, float y, float z);
+	void SetRotation(Entity entity, const float quaternion[4]);
+	void SetScale(Entity entity, float x, float y, float z);
+
+	//カメラを変えたときだけ次のUpdateで行列を求め直す
+	void SetCamera(const Camera &camera);
+	const Camera& GetCamera() const{return camera_;}
+
+	//変えたものとその子孫のワールド変換を求める(jobsがnullptrなら1スレッドで行う)。求め直した数を返す
+	int Update(JobSystem *jobs = nullptr);
+
+	//比較用に1エンティティずつ求める(結果はUpdateと同じ)
+	int UpdateScalar();
+
+	//直前のUpdateで求めたワールド変換(4列目は(0, 0, 0, 1))
+	Matrix World(Entity entity) const;
+	void WorldPosition(Entity entity, float position[3]) const;
+
+	//直前のUpdateでワールド変換が変わったか
+	bool WorldChanged(Entity entity) const{return world_dirty_[slots_[entity]] != 0;}
+
+	const Matrix& View() const{return view_;}
+	const Matrix& Projection() const{return projection_;}
+	const Matrix& ViewProj() const{return view_proj_;}
+
+	int UpdatedNum() const{return updated_num_;}
+	int LevelNum() const{return static_cast<int>(level_begin_.size()) - 1;}
+
+	//回転の四元数を作る(angleはラジアン)
+	static void RotationX(float angle, float quaternion[4]);
+	static void RotationY(float angle, float quaternion[4]);
+	static void RotationZ(float angle, float quaternion[4]);
+
+	//aで回してからbで回す四元数(XMQuaternionMultiply(a, b)と同じ)
+	static void MultiplyRotation(const float a[4], const float b[4], float quaternion[4]);
+
+	//Updateで使う命令セット(AVX, SSE2, NEON, scalar)と1回に求める数
+	static const char* InstructionSet();
+	static int LaneNum();
+
+private:
+	//ローカルの変換とワールド変換(3x4。4列目は常に(0, 0, 0, 1)なので持たない)の成分
+	enum LocalComponent{
+		LOCAL_POSITION_X, LOCAL_POSITION_Y, LOCAL_POSITION_Z,
+		LOCAL_ROTATION_X, LOCAL_ROTATION_Y, LOCAL_ROTATION_Z, LOCAL_ROTATION_W,
+		LOCAL_SCALE_X, LOCAL_SCALE_Y, LOCAL_SCALE_Z,
+		LOCAL_COMPONENT_NUM,
+	};
+	static constexpr int WORLD_COMPONENT_NUM = 12;	//行ごとに3つ(m[0][0], m[0][1], m[0][2], m[1][0], ...)
+
+	void Rebuild();
+	void UpdateCamera();
+	bool PropagateDirty(int begin, int end);
+	int UpdateRange(int begin, int end);
+	int UpdateRangeScalar(int begin, int end);
+
+private:
+	std::vector<Entity>		parents_;		//エンティティごとの親
+	std::vector<uint32_t>	slots_;			//エンティティごとの配列上の位置
+	std::vector<Entity>		entities_;		//配列上の位置ごとのエンティティ(以下は配列上の位置の順)
+	std::vector<uint32_t>	parent_slots_;	//親の位置(根はINVALID_ENTITY)
+	std::vector<int>		level_begin_;	//深さごとの先頭の位置(最後に全体の数を持つ)
+	std::vector<float>		local_[LOCAL_COMPONENT_NUM];	//SIMD_WIDTHの倍数に切り上げた長さを持つ
+	std::vector<float>		world_[WORLD_COMPONENT_NUM];
+	std::vector<uint8_t>	local_dirty_;	//ローカルの変換を変えた
+	std::vector<uint8_t>	world_dirty_;	//ワールド変換を求め直す(ローカルの変換か親のワールド変換が変わった)
+	bool					hierarchy_dirty_;
+	Camera					camera_;
+	bool					camera_dirty_;
+	Matrix					view_;
+	Matrix					projection_;
+	Matrix					view_proj_;
+	int						updated_num_;
+};
+
+#endif
@@ -0,0 +1,290 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include "ShaderCache.h"
+
+namespace{
+typedef ShaderCache::byte byte;
+
+uint64_t AlignUp(uint64_t v, uint64_t alignment){
+	return (v + alignment - 1) / alignment * alignment;
+}
+
+bool ReadFile(const std::string &file_name, std::string *text){
+	MappedFile file;
+	if(!file.Open(file_name.c_str())){
+		return false;
+	}
+	text->assign(reinterpret_cast<const char*>(file.Data()), file.Size());
+	return true;
+}
+
+//file_nameのディレクトリ部分(区切り文字を含む)
+std::string DirectoryOf(const std::string &file_name){
+	const size_t pos = file_name.find_last_of("/\\");
+	return (pos == std::string::npos) ? std::string() : file_name.substr(0, pos + 1);
+}
+
+//行頭の#include "name"を順に取り出す(<...>はシステムのヘッダとみなして無視する)
+void ParseIncludes(const std::string &text, std::vector<std::string> *names){
+	size_t pos = 0;
+	while(pos < text.size()){
+		size_t end = text.find('\n', pos);
+		if(end == std::string::npos){
+			end = text.size();
+		}
+
+		size_t p = text.find_first_not_of(" \t", pos);
+		if(p < end && text[p] == '#'){
+			p = text.find_first_not_of(" \t", p + 1);
+			if(p < end && text.compare(p, 7, "include") == 0){
+				const size_t open = text.find('"', p + 7);
+				const size_t close = (open < end) ? text.find('"', open + 1) : std::string::npos;
+				if(close < end){
+					names->push_back(text.substr(open + 1, close - open - 1));
+				}
+			}
+		}
+		pos = end + 1;
+	}
+}
+
+bool CollectIncludes(const std::string &file_name, const std::string &text, int depth, ShaderCache::Source *source){
+	if(depth > ShaderCache::MAX_INCLUDE_DEPTH){
+		return false;
+	}
+
+	std::vector<std::string> names;
+	ParseIncludes(text, &names);
+
+	const std::string dir = DirectoryOf(file_name);
+	for(const std::string &name : names){
+		const std::string path = dir + name;
+
+		//同じファイルは1度だけ数える(インクルードガードのあるヘッダ)
+		if(std::find(source->include_names.begin(), source->include_names.end(), path) != source->include_names.end()){
+			continue;
+		}
+
+		std::string include_text;
+		if(!ReadFile(path, &include_text)){
+			return false;
+		}
+		source->include_names.push_back(path);
+		source->include_texts.push_back(include_text);
+
+		if(!CollectIncludes(path, include_text, depth + 1, source)){
+			return false;
+		}
+	}
+	return true;
+}
+}
+
+
+ShaderCache::ShaderCache():
+	mutex_{},
+	file_{},
+	entries_{},
+	entry_num_{},
+	pending_{}{}
+
+bool ShaderCache::Open(const char *file_name){
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	pending_.clear();
+	entries_ = nullptr;
+	entry_num_ = 0;
+	if(!file_.Open(file_name)){
+		return false;
+	}
+
+	//ヘッダとエントリ表の確認
+	Header header{};
+	if(file_.Size() < sizeof(header)){
+		file_.Close();
+		return false;
+	}
+	memcpy(&header, file_.Data(), sizeof(header));
+	if(header.magic != MAGIC || header.version != VERSION
+		|| (file_.Size() - sizeof(Header)) / sizeof(Entry) < header.entry_num){
+		file_.Close();
+		return false;
+	}
+
+	//バイトコードはエントリ表の後ろにあり、ファイルに収まって中身がハッシュと一致すること
+	const uint64_t data_begin = AlignUp(sizeof(Header) + sizeof(Entry) * header.entry_num, DATA_ALIGNMENT);
+	const Entry *entries = reinterpret_cast<const Entry*>(file_.Data() + sizeof(Header));
+	for(uint32_t i = 0; i < header.entry_num; ++i){
+		const Entry &e = entries[i];
+		if((i > 0 && entries[i - 1].key >= e.key)
+			|| e.offset < data_begin || e.offset % DATA_ALIGNMENT != 0
+			|| e.offset > file_.Size() || file_.Size() - e.offset < e.size
+			|| Hash(file_.Data() + e.offset, static_cast<size_t>(e.size)) != e.hash){
+			file_.Close();
+			return false;
+		}
+	}
+
+	entries_ = entries;
+	entry_num_ = header.entry_num;
+	return true;
+}
+
+void ShaderCache::Close(){
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	pending_.clear();
+	entries_ = nullptr;
+	entry_num_ = 0;
+	file_.Close();
+}
+
+const ShaderCache::Entry* ShaderCache::FindEntry(uint64_t key) const{
+	const Entry *end = entries_ + entry_num_;
+	const Entry *it = std::lower_bound(entries_, end, key, [](const Entry &e, uint64_t k){return e.key < k;});
+	return (it != end && it->key == key) ? it : nullptr;
+}
+
+bool ShaderCache::Find(uint64_t key, const byte **data, size_t *size) const{
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	const Entry *entry = FindEntry(key);
+	if(entry != nullptr){
+		*data = file_.Data() + entry->offset;
+		*size = static_cast<size_t>(entry->size);
+		return true;
+	}
+
+	for(const Pending &p : pending_){
+		if(p.key == key){
+			*data = p.data.data();
+			*size = p.data.size();
+			return true;
+		}
+	}
+	return false;
+}
+
+void ShaderCache::Add(uint64_t key, const void *data, size_t size){
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	if(FindEntry(key) != nullptr){
+		return;
+	}
+	for(const Pending &p : pending_){
+		if(p.key == key){
+			return;
+		}
+	}
+
+	const byte *src = static_cast<const byte*>(data);
+	pending_.push_back({key, std::vector<byte>(src, src + size)});
+}
+
+bool ShaderCache::Save(const char *file_name){
+	std::vector<Pending> all;
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+
+		//書き出し先をマップしたままでは上書きできないので、先に全てコピーする
+		all.reserve(entry_num_ + pending_.size());
+		for(uint32_t i = 0; i < entry_num_; ++i){
+			const byte *src = file_.Data() + entries_[i].offset;
+			all.push_back({entries_[i].key, std::vector<byte>(src, src + entries_[i].size)});
+		}
+		for(Pending &p : pending_){
+			all.push_back(std::move(p));
+		}
+		pending_.clear();
+		entries_ = nullptr;
+		entry_num_ = 0;
+		file_.Close();
+	}
+	std::sort(all.begin(), all.end(), [](const Pending &a, const Pending &b){return a.key < b.key;});
+
+	Header header{};
+	header.magic		= MAGIC;
+	header.version		= VERSION;
+	header.entry_num	= static_cast<uint32_t>(all.size());
+
+	//各バイトコードの配置を決める
+	std::vector<Entry> table(all.size());
+	uint64_t offset = AlignUp(sizeof(Header) + sizeof(Entry) * all.size(), DATA_ALIGNMENT);
+	for(size_t i = 0; i < all.size(); ++i){
+		table[i].key	= all[i].key;
+		table[i].offset	= offset;
+		table[i].size	= all[i].data.size();
+		table[i].hash	= Hash(all[i].data.data(), all[i].data.size());
+		offset = AlignUp(offset + table[i].size, DATA_ALIGNMENT);
+	}
+
+	FILE *fp = fopen(file_name, "wb");
+	if(fp == nullptr){
+		return false;
+	}
+
+	bool ok = fwrite(&header, sizeof(header), 1, fp) == 1;
+	ok = ok && (table.empty() || fwrite(table.data(), sizeof(Entry), table.size(), fp) == table.size());
+
+	static const byte zero[DATA_ALIGNMENT]{};
+	for(size_t i = 0; ok && i < all.size(); ++i){
+		const long pad = static_cast<long>(table[i].offset) - ftell(fp);
+		ok = ok && (pad == 0 || fwrite(zero, 1, pad, fp) == static_cast<size_t>(pad));
+		ok = ok && (all[i].data.empty() || fwrite(all[i].data.data(), 1, all[i].data.size(), fp) == all[i].data.size());
+	}
+
+	ok = (fclose(fp) == 0) && ok;
+	if(!ok){
+		remove(file_name);
+		return false;
+	}
+
+	return Open(file_name);
+}
+
+bool ShaderCache::IsDirty() const{
+	std::lock_guard<std::mutex> lock(mutex_);
+	return !pending_.empty();
+}
+
+int ShaderCache::EntryNum() const{
+	std::lock_guard<std::mutex> lock(mutex_);
+	return static_cast<int>(entry_num_ + pending_.size());
+}
+
+
+uint64_t ShaderCache::Hash(const void *data, size_t size, uint64_t hash){
+	const byte *p = static_cast<const byte*>(data);
+	for(size_t i = 0; i < size; ++i){
+		hash ^= p[i];
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
+
+//文字列は終端の0まで含めてハッシュし、隣り合う要素の境界がずれても同じキーにならないようにする
+uint64_t ShaderCache::MakeKey(const Source &source, const char *entry, const char *profile, uint32_t flags){
+	const uint32_t version = VERSION;
+	uint64_t hash = Hash(&version, sizeof(version));
+	hash = Hash(source.text.c_str(), source.text.size() + 1, hash);
+	for(size_t i = 0; i < source.include_names.size(); ++i){
+		hash = Hash(source.include_names[i].c_str(), source.include_names[i].size() + 1, hash);
+		hash = Hash(source.include_texts[i].c_str(), source.include_texts[i].size() + 1, hash);
+	}
+	hash = Hash(entry, strlen(entry) + 1, hash);
+	hash = Hash(profile, strlen(profile) + 1, hash);
+	hash = Hash(&flags, sizeof(flags), hash);
+	return hash;
+}
+
+bool ShaderCache::ReadSource(const char *file_name, Source *source){
+	source->text.clear();
+	source->include_names.clear();
+	source->include_texts.clear();
+
+	if(!ReadFile(file_name, &source->text)){
+		return false;
+	}
+	return CollectIncludes(file_name, source->text, 0, source);
+}
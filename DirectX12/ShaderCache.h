@@ -0,0 +1,87 @@
+#ifndef SHADER_CACHE_HEADER_
+#define SHADER_CACHE_HEADER_
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "MappedFile.h"
+
+//コンパイル済みシェーダのキャッシュ
+//キーはソース(インクルードするファイルを含む)・エントリポイント・プロファイル・フラグのハッシュ
+//ファイルはヘッダ・キー順のエントリ表・バイトコードの順に並び、読み込み時はマップして直接参照する
+//途中で切れたファイルや書き換わったバイトコードは、エントリ表の範囲とバイトコードのハッシュで見つけて開かない
+class ShaderCache{
+public:
+	typedef unsigned char byte;
+	static constexpr uint32_t MAGIC				= 0x43444853;	//"SHDC"
+	static constexpr uint32_t VERSION			= 2;
+	static constexpr uint32_t DATA_ALIGNMENT	= 16;
+	static constexpr int MAX_INCLUDE_DEPTH		= 16;
+
+	struct Header{
+		uint32_t	magic;
+		uint32_t	version;
+		uint32_t	entry_num;
+		uint32_t	reserved;
+	};
+
+	struct Entry{
+		uint64_t	key;
+		uint64_t	offset;		//ファイル先頭からのオフセット
+		uint64_t	size;
+		uint64_t	hash;		//バイトコードのHash
+	};
+
+	//キャッシュのキーの元になるソース(インクルードしたファイルは見つかった順に並ぶ)
+	struct Source{
+		std::string					text;
+		std::vector<std::string>	include_names;
+		std::vector<std::string>	include_texts;
+	};
+
+public:
+	ShaderCache();
+	~ShaderCache(){}
+	ShaderCache(const ShaderCache&) = delete;
+	ShaderCache& operator=(const ShaderCache&) = delete;
+
+	//ファイルがない・壊れている場合はfalseを返し、空のキャッシュとして使える
+	bool Open(const char *file_name);
+	void Close();
+
+	//見つかった場合、dataはClose・Saveを呼ぶまで有効(複数のスレッドから呼んでよい)
+	bool Find(uint64_t key, const byte **data, size_t *size) const;
+	void Add(uint64_t key, const void *data, size_t size);
+
+	//ファイルの内容と追加したものをまとめて書き出し、書き出したファイルを開き直す
+	bool Save(const char *file_name);
+
+	bool IsDirty() const;
+	int EntryNum() const;
+
+	//FNV-1a(64bit)
+	static uint64_t Hash(const void *data, size_t size, uint64_t hash = 14695981039346656037ull);
+	static uint64_t MakeKey(const Source &source, const char *entry, const char *profile, uint32_t flags);
+
+	//ソースを読み込み、#include "..."で参照するファイルを再帰的に集める(パスはインクルード元からの相対)
+	static bool ReadSource(const char *file_name, Source *source);
+
+private:
+	struct Pending{
+		uint64_t			key;
+		std::vector<byte>	data;
+	};
+
+	const Entry* FindEntry(uint64_t key) const;
+
+private:
+	mutable std::mutex		mutex_;
+	MappedFile				file_;
+	const Entry				*entries_;	//マップしたファイル内のエントリ表(キー順)
+	uint32_t				entry_num_;
+	std::vector<Pending>	pending_;	//Openの後に追加したもの
+};
+
+#endif
@@ -0,0 +1,82 @@
+#include <cstring>
+#include <wrl/client.h>
+#include "ShaderCompiler.h"
+
+using namespace Microsoft::WRL;
+
+namespace{
+struct ShaderDesc{
+	const char	*file_name;
+	const char	*entry;
+	const char	*profile;
+};
+
+//D3D12Manager::CompileShadersとShadowMapDebug::Loadでコンパイルするもの(シェーダを増やしたらここにも加える)
+const ShaderDesc SHADER_LIST[] = {
+	{"Shaders.hlsl",		"VSMain",				"vs_5_1"},
+	{"Shaders.hlsl",		"PSMain",				"ps_5_1"},
+	{"Shaders.hlsl",		"VSShadowMap",			"vs_5_1"},
+	{"Shaders.hlsl",		"VSMainInstanced",		"vs_5_1"},
+	{"Shaders.hlsl",		"PSMainInstanced",		"ps_5_1"},
+	{"Shaders.hlsl",		"VSShadowMapInstanced",	"vs_5_1"},
+	{"Shaders.hlsl",		"VSFullscreen",			"vs_5_1"},
+	{"Shaders.hlsl",		"PSEvsmBlurX",			"ps_5_1"},
+	{"Shaders.hlsl",		"PSEvsmBlurY",			"ps_5_1"},
+	{"ShadowMapDebug.hlsl",	"VSMain",				"vs_5_0"},
+	{"ShadowMapDebug.hlsl",	"PSMain",				"ps_5_0"},
+};
+}
+
+HRESULT CompileShader(ShaderCache *cache, const char *file_name, const char *entry, const char *profile, ID3DBlob **blob){
+	HRESULT hr;
+
+	//キーの計算のためにソースとインクルードするファイルを読む
+	ShaderCache::Source source;
+	if(!ShaderCache::ReadSource(file_name, &source)){
+		return E_FAIL;
+	}
+	const uint64_t key = ShaderCache::MakeKey(source, entry, profile, SHADER_COMPILE_FLAGS);
+
+
+	//キャッシュにあればコピーして返す
+	const ShaderCache::byte *data{};
+	size_t size{};
+	if(cache != nullptr && cache->Find(key, &data, &size)){
+		hr = D3DCreateBlob(size, blob);
+		if(FAILED(hr)){
+			return hr;
+		}
+		memcpy((*blob)->GetBufferPointer(), data, size);
+		return S_OK;
+	}
+
+
+	//読み込んだソースをそのままコンパイルする(インクルードはソースのあるディレクトリから探す)
+	ComPtr<ID3DBlob> errors{};
+	hr = D3DCompile(source.text.data(), source.text.size(), file_name, nullptr, D3D_COMPILE_STANDARD_FILE_INCLUDE,
+		entry, profile, SHADER_COMPILE_FLAGS, 0, blob, &errors);
+	if(FAILED(hr)){
+		if(errors != nullptr){
+			OutputDebugStringA(static_cast<const char*>(errors->GetBufferPointer()));
+		}
+		return hr;
+	}
+
+	if(cache != nullptr){
+		cache->Add(key, (*blob)->GetBufferPointer(), (*blob)->GetBufferSize());
+	}
+	return S_OK;
+}
+
+HRESULT PrecompileShaders(ShaderCache *cache){
+	HRESULT hr;
+
+	for(const ShaderDesc &desc : SHADER_LIST){
+		ComPtr<ID3DBlob> blob{};
+		hr = CompileShader(cache, desc.file_name, desc.entry, desc.profile, &blob);
+		if(FAILED(hr)){
+			return hr;
+		}
+	}
+	return S_OK;
+}
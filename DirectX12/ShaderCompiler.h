@@ -0,0 +1,23 @@
+#ifndef SHADER_COMPILER_HEADER_
+#define SHADER_COMPILER_HEADER_
+
+#include <Windows.h>
+#include <d3dcompiler.h>
+#include "ShaderCache.h"
+
+#if defined(_DEBUG)
+constexpr UINT SHADER_COMPILE_FLAGS = D3DCOMPILE_DEBUG | D3DCOMPILE_SKIP_OPTIMIZATION;
+#else
+constexpr UINT SHADER_COMPILE_FLAGS = 0;
+#endif
+
+constexpr const char *SHADER_CACHE_FILE = "shaders.cache";
+
+//キャッシュにあればそのバイトコードを、なければコンパイルしてキャッシュに追加する
+//cacheがnullptrの場合は毎回コンパイルする(ワーカースレッドから呼んでよい)
+HRESULT CompileShader(ShaderCache *cache, const char *file_name, const char *entry, const char *profile, ID3DBlob **blob);
+
+//アプリで使う全てのシェーダをコンパイルしてキャッシュに入れる(-precompile)
+HRESULT PrecompileShaders(ShaderCache *cache);
+
+#endif
@@ -1,69 +1,289 @@
-cbuffer cbTansMatrix : register(b0){
-	float4x4 WVP;
-	float4x4 World;
-};
-
-cbuffer cbLight : register(b1){
-	float4x4	LightVP;
-	float4		LightColor;
-	float3		LightDir;
-};
-
-Texture2D<float4> tex0 : register(t0);
-Texture2D<float> shadow_map : register(t1);
-SamplerState samp0 : register(s0);
-SamplerState samp1 : register(s1);
-
-struct VS_INPUT{
-	float3 Position : POSITION;
-	float3 Normal	: NORMAL;
-	float2 UV		: TEXCOORD;
-};
-
-struct PS_INPUT{//(VS_OUTPUT)
-	float4 Position : SV_POSITION;
-	float4 PosSM	: POSITION_SM;
-	float4 Normal	: NORMAL;
-	float2 UV		: TEXCOORD;
-};
-
-
-PS_INPUT VSMain(VS_INPUT input){
-	PS_INPUT output;
-
-	float4 Pos = float4(input.Position, 1.0f);
-	float4 Nrm = float4(input.Normal, 0.0f);
-	output.Position = mul(Pos, WVP);
-	output.Normal = mul(Nrm, World);
-	output.UV = input.UV;
-
-	Pos = mul(Pos, World);
-	Pos = mul(Pos, LightVP);
-	Pos.xyz = Pos.xyz / Pos.w;
-	output.PosSM.x = (1.0f + Pos.x) / 2.0f;
-	output.PosSM.y = (1.0f - Pos.y) / 2.0f;
-	output.PosSM.z = Pos.z;
-
-	return output;
-}
-
-
-float4 PSMain(PS_INPUT input) : SV_TARGET{
-
-	float sm = shadow_map.Sample(samp1, input.PosSM.xy);
-	float sma = (input.PosSM.z - 0.005f < sm) ? 1.0f : 0.5f;
-	
-	return tex0.Sample(samp0, input.UV) * sma;
-}
-
-
-//Vh[}bvvZp_VF[_
-float4 VSShadowMap(VS_INPUT input) : SV_POSITION{
-
-	float4 Pos = float4(input.Position, 1.0f);
-	Pos = mul(Pos, World);
-	Pos = mul(Pos, LightVP);
-
-	return Pos;
-}
-
+#define BINDLESS_TEXTURE_NUM 1024	//D3D12Manager::BINDLESS_HEAP_SIZEと合わせる
+#define SHADOW_CASCADE_NUM 3		//D3D12Manager::SHADOW_CASCADE_NUMと合わせる
+#define SHADOW_MAP_SIZE 1024		//D3D12Manager::SHADOW_MAP_SIZEと合わせる
+#define SHADOW_BIAS 0.005f
+
+//シャドウマップのフィルタの段階とその設定(ShadowFilter.hと合わせる)
+#define SHADOW_FILTER_HARD		0
+#define SHADOW_FILTER_PCF		1
+#define SHADOW_FILTER_POISSON	2
+#define SHADOW_FILTER_EVSM		3
+#define POISSON_TAP_NUM 16
+#define POISSON_RADIUS 2.0f
+#define EVSM_EXPONENTS float2(40.0f, 5.0f)
+#define EVSM_BLUR_RADIUS 2
+#define EVSM_VARIANCE_BIAS 0.0001f
+#define EVSM_LIGHT_BLEEDING_REDUCTION 0.25f
+
+cbuffer cbTansMatrix : register(b0){
+	float4x4 WVP;
+	float4x4 World;
+	float4x4 ViewProj;	//インスタンス描画用
+	float4 TextureMinLod;	//ストリーミングで転送済みの最も詳細なレベル(インスタンス描画ではテクスチャの添字の成分を使う)
+};
+
+cbuffer cbLight : register(b1){
+	float4x4	LightVP;		//シャドウマップの描画では描くカスケードの行列
+	float4		LightColor;
+	float3		LightDir;
+	float4x4	CascadeVP[SHADOW_CASCADE_NUM];
+	float4		CascadeSplits;	//カスケードごとの遠い側の境界(カメラのビュー空間の奥行き)
+};
+
+//描画するテクスチャとシャドウマップのヒープ上の添字・シャドウマップのフィルタの設定(ルート定数)
+cbuffer cbDescriptorIndex : register(b2){
+	uint TextureIndex;			//インスタンス描画では先頭で、インスタンスごとの添字を足す。EVSMの縦のぼかしでは横にぼかした配列
+	uint ShadowMapIndex;
+	uint ShadowMomentsIndex;	//EVSMのぼかしたモーメント
+	uint ShadowFilter;			//SHADOW_FILTER_*(添字ではない)
+	uint ShadowSlice;			//EVSMのぼかしで描く配列のスライス
+};
+
+//全てのテクスチャ
+Texture2D<float4> textures[BINDLESS_TEXTURE_NUM] : register(t0);
+
+//同じヒープを配列のテクスチャとして見たもの(カスケードのシャドウマップはスライスごとにrに深度が入る)
+Texture2DArray<float> texture_arrays[BINDLESS_TEXTURE_NUM] : register(t0, space1);
+
+//同じヒープを4成分の配列のテクスチャとして見たもの(EVSMのモーメント)
+Texture2DArray<float4> moment_arrays[BINDLESS_TEXTURE_NUM] : register(t0, space2);
+
+SamplerState samp0 : register(s0);
+SamplerComparisonState shadow_sampler : register(s1);	//2x2のテクセルと比べた結果を双線形補間する(外は光が当たる)
+SamplerState moment_sampler : register(s2);				//モーメントの双線形補間(外は端のテクセルを延ばす)
+
+//半径1程度に散らした点(ShadowFilter::POISSON_DISKと合わせる)
+static const float2 POISSON_DISK[POISSON_TAP_NUM] = {
+	float2(-0.94201624f, -0.39906216f),
+	float2( 0.94558609f, -0.76890725f),
+	float2(-0.09418410f, -0.92938870f),
+	float2( 0.34495938f,  0.29387760f),
+	float2(-0.91588581f,  0.45771432f),
+	float2(-0.81544232f, -0.87912464f),
+	float2(-0.38277543f,  0.27676845f),
+	float2( 0.97484398f,  0.75648379f),
+	float2( 0.44323325f, -0.97511554f),
+	float2( 0.53742981f, -0.47373420f),
+	float2(-0.26496911f, -0.41893023f),
+	float2( 0.79197514f,  0.19090188f),
+	float2(-0.24188840f,  0.99706507f),
+	float2(-0.81409955f,  0.91437590f),
+	float2( 0.19984126f,  0.78641367f),
+	float2( 0.14383161f, -0.14100790f),
+};
+
+struct VS_INPUT{
+	float3 Position : POSITION;
+	float3 Normal	: NORMAL;
+	float2 UV		: TEXCOORD;
+};
+
+struct PS_INPUT{//(VS_OUTPUT)
+	float4 Position		: SV_POSITION;
+	float3 WorldPos		: WORLD_POSITION;
+	float  ViewDepth	: VIEW_DEPTH;
+	float4 Normal		: NORMAL;
+	float2 UV			: TEXCOORD;
+};
+
+//インスタンス描画用(ワールド変換行列は転置した上3行で渡す)
+struct VS_INSTANCE_INPUT{
+	float3 Position		: POSITION;
+	float3 Normal		: NORMAL;
+	float2 UV			: TEXCOORD;
+	float4 World0		: WORLD0;
+	float4 World1		: WORLD1;
+	float4 World2		: WORLD2;
+	uint TextureIndex	: TEXTURE_INDEX;
+};
+
+struct PS_INSTANCE_INPUT{
+	float4 Position						: SV_POSITION;
+	float3 WorldPos						: WORLD_POSITION;
+	float  ViewDepth					: VIEW_DEPTH;
+	float4 Normal						: NORMAL;
+	float2 UV							: TEXCOORD;
+	nointerpolation uint TextureIndex	: TEXTURE_INDEX;
+};
+
+
+float3 TransformInstance(VS_INSTANCE_INPUT input, float4 v){
+	return float3(dot(input.World0, v), dot(input.World1, v), dot(input.World2, v));
+}
+
+//深度を[-1, 1]に広げてから正と負の指数で歪めたモーメント(ShadowFilter::WarpDepth)
+float4 WarpDepth(float depth){
+	float d = 2.0f * depth - 1.0f;
+	float pos = exp(EVSM_EXPONENTS.x * d);
+	float neg = -exp(-EVSM_EXPONENTS.y * d);
+	return float4(pos, pos * pos, neg, neg * neg);
+}
+
+//チェビシェフの不等式で光が当たる割合の上限を見積もり、小さな見積もりは影にする
+float ChebyshevUpperBound(float2 moments, float t, float min_variance){
+	float variance = max(moments.y - moments.x * moments.x, min_variance);
+	float d = t - moments.x;
+	float p = variance / (variance + d * d);
+	p = saturate((p - EVSM_LIGHT_BLEEDING_REDUCTION) / (1.0f - EVSM_LIGHT_BLEEDING_REDUCTION));
+	return (t <= moments.x) ? 1.0f : p;
+}
+
+//ポアソンディスクを回す角度を決めるノイズ(画面上の位置ごとに[0, 1))
+float InterleavedGradientNoise(float2 ScreenPos){
+	return frac(52.9829189f * frac(dot(ScreenPos, float2(0.06711056f, 0.00583715f))));
+}
+
+//シャドウマップ上の座標UV・深度zで光が当たる割合をShadowFilterの段階で求める(ShadowFilter::Visibility)
+float FilterShadow(float2 UV, uint cascade, float z, float2 ScreenPos){
+	if(ShadowFilter == SHADOW_FILTER_EVSM){
+		float4 moments = moment_arrays[ShadowMomentsIndex].SampleLevel(moment_sampler, float3(UV, cascade), 0.0f);
+		float4 warped = WarpDepth(z);
+		float2 depth_scale = EVSM_VARIANCE_BIAS * EVSM_EXPONENTS * warped.xz;
+		float2 min_variance = depth_scale * depth_scale;
+		return min(ChebyshevUpperBound(moments.xy, warped.x, min_variance.x), ChebyshevUpperBound(moments.zw, warped.z, min_variance.y));
+	}
+
+	z -= SHADOW_BIAS;
+	if(ShadowFilter == SHADOW_FILTER_POISSON){
+		float angle = 6.2831853f * InterleavedGradientNoise(ScreenPos);
+		float2 rotation = float2(cos(angle), sin(angle));
+		float sum = 0.0f;
+		[unroll]
+		for(uint i = 0; i < POISSON_TAP_NUM; ++i){
+			float2 p = POISSON_DISK[i];
+			float2 offset = float2(rotation.x * p.x - rotation.y * p.y, rotation.y * p.x + rotation.x * p.y) * (POISSON_RADIUS / SHADOW_MAP_SIZE);
+			sum += texture_arrays[ShadowMapIndex].SampleCmpLevelZero(shadow_sampler, float3(UV + offset, cascade), z);
+		}
+		return sum / POISSON_TAP_NUM;
+	}
+	if(ShadowFilter == SHADOW_FILTER_PCF){
+		return texture_arrays[ShadowMapIndex].SampleCmpLevelZero(shadow_sampler, float3(UV, cascade), z);
+	}
+
+	//最も近いテクセルだけと比べる(外は光が当たる)
+	if(any(UV < 0.0f) || any(UV >= 1.0f)){
+		return 1.0f;
+	}
+	float sm = texture_arrays[ShadowMapIndex].Load(int4(UV * SHADOW_MAP_SIZE, cascade, 0));
+	return (z <= sm) ? 1.0f : 0.0f;
+}
+
+//カメラからの奥行きでカスケードを選び、そのシャドウマップでフィルタした割合だけ暗くする(最も遠いカスケードより先は影にしない)
+float ShadowFactor(float3 WorldPos, float ViewDepth, float2 ScreenPos){
+	if(ViewDepth > CascadeSplits[SHADOW_CASCADE_NUM - 1]){
+		return 1.0f;
+	}
+
+	uint cascade = 0;
+	[unroll]
+	for(uint i = 0; i < SHADOW_CASCADE_NUM - 1; ++i){
+		cascade += (ViewDepth > CascadeSplits[i]) ? 1 : 0;
+	}
+
+	//正射影なのでwで割らない
+	float4 Pos = mul(float4(WorldPos, 1.0f), CascadeVP[cascade]);
+	float2 UV = float2(1.0f + Pos.x, 1.0f - Pos.y) / 2.0f;
+	return lerp(0.5f, 1.0f, FilterShadow(UV, cascade, Pos.z, ScreenPos));
+}
+
+
+PS_INPUT VSMain(VS_INPUT input){
+	PS_INPUT output;
+
+	float4 Pos = float4(input.Position, 1.0f);
+	float4 Nrm = float4(input.Normal, 0.0f);
+	output.Position = mul(Pos, WVP);
+	output.WorldPos = mul(Pos, World).xyz;
+	output.ViewDepth = output.Position.w;
+	output.Normal = mul(Nrm, World);
+	output.UV = input.UV;
+
+	return output;
+}
+
+
+//ピクセルシェーダ(テクスチャの配列を添字で引くのでps_5_1でコンパイルする)
+float4 PSMain(PS_INPUT input) : SV_TARGET{
+
+	float sma = ShadowFactor(input.WorldPos, input.ViewDepth, input.Position.xy);
+	
+	return textures[TextureIndex].Sample(samp0, input.UV, int2(0, 0), TextureMinLod.x) * sma;
+}
+
+
+//シャドーマップ計算用頂点シェーダ(LightVPは描くカスケードの行列)
+float4 VSShadowMap(VS_INPUT input) : SV_POSITION{
+
+	float4 Pos = float4(input.Position, 1.0f);
+	Pos = mul(Pos, World);
+	Pos = mul(Pos, LightVP);
+
+	return Pos;
+}
+
+
+//インスタンス描画用頂点シェーダ
+PS_INSTANCE_INPUT VSMainInstanced(VS_INSTANCE_INPUT input){
+	PS_INSTANCE_INPUT output;
+
+	float4 Pos = float4(TransformInstance(input, float4(input.Position, 1.0f)), 1.0f);
+	output.Position = mul(Pos, ViewProj);
+	output.WorldPos = Pos.xyz;
+	output.ViewDepth = output.Position.w;
+	output.Normal = float4(TransformInstance(input, float4(input.Normal, 0.0f)), 0.0f);
+	output.UV = input.UV;
+	output.TextureIndex = input.TextureIndex;
+
+	return output;
+}
+
+
+//インスタンス描画用ピクセルシェーダ(テクスチャの配列を添字で引くのでps_5_1でコンパイルする)
+float4 PSMainInstanced(PS_INSTANCE_INPUT input) : SV_TARGET{
+
+	float sma = ShadowFactor(input.WorldPos, input.ViewDepth, input.Position.xy);
+
+	return textures[NonUniformResourceIndex(TextureIndex + input.TextureIndex)].Sample(samp0, input.UV, int2(0, 0), TextureMinLod[input.TextureIndex]) * sma;
+}
+
+
+//インスタンス描画のシャドーマップ計算用頂点シェーダ
+float4 VSShadowMapInstanced(VS_INSTANCE_INPUT input) : SV_POSITION{
+
+	float4 Pos = float4(TransformInstance(input, float4(input.Position, 1.0f)), 1.0f);
+	return mul(Pos, LightVP);
+}
+
+
+
+//全画面を覆う三角形(頂点バッファを使わない)
+float4 VSFullscreen(uint id : SV_VertexID) : SV_POSITION{
+	float2 uv = float2((id << 1) & 2, id & 2);
+	return float4(uv * float2(2.0f, -2.0f) + float2(-1.0f, 1.0f), 0.0f, 1.0f);
+}
+
+
+//EVSMの前処理の横方向: シャドウマップのShadowSliceのスライスの深度をモーメントにしながらぼかす(ShadowFilter::Prefilter)
+float4 PSEvsmBlurX(float4 Position : SV_POSITION) : SV_TARGET{
+	int2 p = int2(Position.xy);
+	float4 sum = 0.0f;
+	[unroll]
+	for(int i = -EVSM_BLUR_RADIUS; i <= EVSM_BLUR_RADIUS; ++i){
+		int x = clamp(p.x + i, 0, SHADOW_MAP_SIZE - 1);
+		sum += WarpDepth(texture_arrays[ShadowMapIndex].Load(int4(x, p.y, ShadowSlice, 0)));
+	}
+	return sum / (2 * EVSM_BLUR_RADIUS + 1);
+}
+
+
+//EVSMの前処理の縦方向: 横にぼかしたモーメント(TextureIndexの配列)をぼかす
+float4 PSEvsmBlurY(float4 Position : SV_POSITION) : SV_TARGET{
+	int2 p = int2(Position.xy);
+	float4 sum = 0.0f;
+	[unroll]
+	for(int i = -EVSM_BLUR_RADIUS; i <= EVSM_BLUR_RADIUS; ++i){
+		int y = clamp(p.y + i, 0, SHADOW_MAP_SIZE - 1);
+		sum += moment_arrays[TextureIndex].Load(int4(p.x, y, ShadowSlice, 0));
+	}
+	return sum / (2 * EVSM_BLUR_RADIUS + 1);
+}
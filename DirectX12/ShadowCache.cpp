@@ -0,0 +1,101 @@
+#include <algorithm>
+#include "ShadowCache.h"
+
+ShadowCache::ShadowCache():
+	layer_num_(1),
+	static_frame_num_(DEFAULT_STATIC_FRAME_NUM),
+	casters_{},
+	views_(16, 0.0f),
+	view_changed_(false),
+	cache_valid_(false),
+	static_num_{},
+	last_redraw_(REDRAW_FULL),
+	stats_{}{}
+
+void ShadowCache::Initialize(int layer_num, uint32_t static_frame_num){
+	layer_num_			= layer_num;
+	static_frame_num_	= static_frame_num;
+	casters_.clear();
+	views_.assign(static_cast<size_t>(layer_num) * 16, 0.0f);
+	view_changed_		= false;
+	cache_valid_		= false;
+	static_num_			= 0;
+	last_redraw_		= REDRAW_FULL;
+	stats_				= {};
+}
+
+int ShadowCache::AddCaster(){
+	Caster caster{};
+	caster.is_static		= true;
+	caster.still_frame_num	= static_frame_num_;
+	casters_.push_back(caster);
+	++static_num_;
+	cache_valid_ = false;
+	return static_cast<int>(casters_.size()) - 1;
+}
+
+void ShadowCache::SetTransform(int caster, const float *values, int num){
+	Caster &c = casters_[caster];
+	if(c.transform.size() == static_cast<size_t>(num) && std::equal(values, values + num, c.transform.begin())){
+		return;
+	}
+	//最初に設定した変換は動いたものとしない(最初のUpdateではキャッシュごと描く)
+	c.moved = c.moved || !c.transform.empty();
+	c.transform.assign(values, values + num);
+}
+
+void ShadowCache::SetView(int layer, const float view_proj[16]){
+	float *view = &views_[static_cast<size_t>(layer) * 16];
+	if(std::equal(view_proj, view_proj + 16, view)){
+		return;
+	}
+	std::copy(view_proj, view_proj + 16, view);
+	view_changed_ = true;
+}
+
+ShadowCache::Redraw ShadowCache::Update(){
+	//ライトが動いたら全ての層を描き直す
+	bool rebuild = !cache_valid_ || view_changed_;
+	bool dynamic_moved = false;
+
+	static_num_ = 0;
+	for(Caster &c : casters_){
+		c.still_frame_num = c.moved ? 0 : std::min(c.still_frame_num + 1, static_frame_num_);
+		const bool is_static = (c.still_frame_num >= static_frame_num_);
+
+		//静的・動的が入れ替わったら、キャッシュに描くものが変わる
+		if(is_static != c.is_static){
+			c.is_static	= is_static;
+			rebuild		= true;
+		}else if(c.moved){
+			rebuild			= rebuild || is_static;
+			dynamic_moved	= dynamic_moved || !is_static;
+		}
+		static_num_ += is_static ? 1 : 0;
+		c.moved = false;
+	}
+
+	const Redraw redraw = rebuild ? REDRAW_FULL : (dynamic_moved ? REDRAW_DYNAMIC : REDRAW_NONE);
+	cache_valid_	= true;
+	view_changed_	= false;
+	last_redraw_	= redraw;
+
+
+	//描いたキャスターの数は層ごとに数える
+	const uint64_t layer_num	= static_cast<uint64_t>(layer_num_);
+	const uint64_t all_draws	= static_cast<uint64_t>(casters_.size()) * layer_num;
+	const uint64_t static_draws	= (redraw == REDRAW_FULL) ? static_cast<uint64_t>(static_num_) * layer_num : 0;
+	const uint64_t dynamic_draws	= (redraw != REDRAW_NONE) ? static_cast<uint64_t>(casters_.size() - static_num_) * layer_num : 0;
+
+	++stats_.frame_num;
+	switch(redraw){
+		case REDRAW_NONE:		++stats_.skipped_num; break;
+		case REDRAW_DYNAMIC:	++stats_.dynamic_num; break;
+		default:				++stats_.full_num; break;
+	}
+	stats_.static_draw_num	+= static_draws;
+	stats_.dynamic_draw_num	+= dynamic_draws;
+	stats_.skipped_draw_num	+= all_draws - static_draws - dynamic_draws;
+
+	return redraw;
+}
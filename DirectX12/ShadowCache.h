@@ -0,0 +1,91 @@
+#ifndef SHADOW_CACHE_HEADER_
+#define SHADOW_CACHE_HEADER_
+
+#include <cstdint>
+#include <vector>
+
+//シャドウマップの描き直しの判定
+//影を落とすもの(キャスター)の変換とライトの行列をフレームごとに前回と比べ、描き直す範囲を決める
+//・しばらく動いていないキャスターは静的なものとして、静的なものだけを描いた層(キャッシュ)に描いておく
+//・動いているキャスターは動的なものとして、キャッシュをシャドウマップにコピーした上に毎フレーム描く
+//・動的なキャスターが動かず、キャッシュも使えるならシャドウマップはそのまま使う(描き直さない)
+//・キャスターが静的・動的の間で切り替わるか、ライトの行列が変わったらキャッシュを描き直す
+//
+//1フレームの流れ: キャスターごとにSetTransform・層ごとにSetView → Update → 結果に従って描く
+class ShadowCache{
+public:
+	static constexpr int INVALID_HANDLE = -1;
+	static constexpr uint32_t DEFAULT_STATIC_FRAME_NUM = 30;	//この数のフレームの間動かなければ静的なものとして扱う
+
+	//今フレームでシャドウマップに行う処理
+	enum Redraw{
+		REDRAW_NONE,		//前のフレームのシャドウマップをそのまま使う
+		REDRAW_DYNAMIC,		//キャッシュをコピーして(静的なものがなければクリアして)動的なキャスターを描く
+		REDRAW_FULL,		//キャッシュを描き直してから、REDRAW_DYNAMICと同じ処理を行う
+	};
+
+	struct Stats{
+		uint64_t	frame_num;
+		uint64_t	skipped_num;			//描き直さなかったフレームの数
+		uint64_t	dynamic_num;			//動的なキャスターだけを描いたフレームの数
+		uint64_t	full_num;				//キャッシュを描き直したフレームの数
+		uint64_t	static_draw_num;		//キャッシュに描いたキャスターの数(層ごとに数える)
+		uint64_t	dynamic_draw_num;		//シャドウマップに描いたキャスターの数(層ごとに数える)
+		uint64_t	skipped_draw_num;		//毎フレーム全て描く場合と比べて描かずに済んだキャスターの数
+	};
+
+public:
+	ShadowCache();
+	~ShadowCache(){}
+
+	//layer_numはシャドウマップの層(カスケード)の数
+	void Initialize(int layer_num, uint32_t static_frame_num = DEFAULT_STATIC_FRAME_NUM);
+
+	//キャスターを登録する(最初は静的なものとして扱い、動いたら動的なものにする)
+	int AddCaster();
+
+	//キャスターの変換(行列・アニメーションの時刻など、影の形を決める値)を設定する。前回と1つでも違えば動いたものとする
+	void SetTransform(int caster, const float *values, int num);
+
+	//層のライトのビュー・プロジェクション行列を設定する
+	void SetView(int layer, const float view_proj[16]);
+
+	//シャドウマップを作り直した場合・Updateの後でフレームを記録しなかった場合などに、次のUpdateでキャッシュを描き直させる
+	void Invalidate(){cache_valid_ = false;}
+
+	//今フレームの処理を決めて統計に数える
+	Redraw Update();
+
+	Redraw LastRedraw() const{return last_redraw_;}
+
+	//キャッシュに描くものならtrue(Updateの結果で決まる)
+	bool IsStatic(int caster) const{return casters_[caster].is_static;}
+
+	//キャッシュに描くものがあるか(なければキャッシュのコピーの代わりにクリアすればよい)
+	bool HasStaticCaster() const{return static_num_ > 0;}
+	bool HasDynamicCaster() const{return static_num_ < CasterNum();}
+
+	int CasterNum() const{return static_cast<int>(casters_.size());}
+	const Stats& GetStats() const{return stats_;}
+
+private:
+	struct Caster{
+		std::vector<float>	transform;
+		bool				moved;			//前回のUpdateの後で変換が変わった
+		bool				is_static;
+		uint32_t			still_frame_num;	//動かなかったフレームの数
+	};
+
+private:
+	int						layer_num_;
+	uint32_t				static_frame_num_;
+	std::vector<Caster>		casters_;
+	std::vector<float>		views_;			//層ごとの行列(16個ずつ)
+	bool					view_changed_;
+	bool					cache_valid_;
+	int						static_num_;
+	Redraw					last_redraw_;
+	Stats					stats_;
+};
+
+#endif
@@ -0,0 +1,260 @@
+#include <algorithm>
+#include <cmath>
+#include "ShadowCascades.h"
+
+namespace{
+typedef ShadowCascades::Matrix Matrix;
+
+float Dot(const float a[3], const float b[3]){
+	return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+}
+
+void Cross(const float a[3], const float b[3], float out[3]){
+	out[0] = a[1] * b[2] - a[2] * b[1];
+	out[1] = a[2] * b[0] - a[0] * b[2];
+	out[2] = a[0] * b[1] - a[1] * b[0];
+}
+
+void Normalize(float v[3]){
+	const float len = std::sqrt(Dot(v, v));
+	v[0] /= len;
+	v[1] /= len;
+	v[2] /= len;
+}
+
+float Distance(const float a[3], const float b[3]){
+	const float d[3] = {a[0] - b[0], a[1] - b[1], a[2] - b[2]};
+	return std::sqrt(Dot(d, d));
+}
+}
+
+
+Matrix ShadowCascades::Matrix::operator*(const Matrix &other) const{
+	Matrix r{};
+	for(int i = 0; i < 4; ++i){
+		for(int j = 0; j < 4; ++j){
+			r.m[i][j] = m[i][0] * other.m[0][j] + m[i][1] * other.m[1][j] + m[i][2] * other.m[2][j] + m[i][3] * other.m[3][j];
+		}
+	}
+	return r;
+}
+
+Matrix ShadowCascades::Matrix::Transposed() const{
+	Matrix r{};
+	for(int i = 0; i < 4; ++i){
+		for(int j = 0; j < 4; ++j){
+			r.m[i][j] = m[j][i];
+		}
+	}
+	return r;
+}
+
+void ShadowCascades::Matrix::TransformPoint(const float p[3], float out[4]) const{
+	for(int i = 0; i < 4; ++i){
+		out[i] = p[0] * m[0][i] + p[1] * m[1][i] + p[2] * m[2][i] + m[3][i];
+	}
+}
+
+Matrix ShadowCascades::Matrix::LookAtLH(const float eye[3], const float focus[3], const float up[3]){
+	float z[3] = {focus[0] - eye[0], focus[1] - eye[1], focus[2] - eye[2]};
+	Normalize(z);
+	float x[3];
+	Cross(up, z, x);
+	Normalize(x);
+	float y[3];
+	Cross(z, x, y);
+
+	Matrix r{};
+	for(int i = 0; i < 3; ++i){
+		r.m[i][0] = x[i];
+		r.m[i][1] = y[i];
+		r.m[i][2] = z[i];
+	}
+	r.m[3][0] = -Dot(x, eye);
+	r.m[3][1] = -Dot(y, eye);
+	r.m[3][2] = -Dot(z, eye);
+	r.m[3][3] = 1.0f;
+	return r;
+}
+
+//XMMatrixOrthographicOffCenterLHと同じ
+Matrix ShadowCascades::Matrix::OrthographicOffCenterLH(float left, float right, float bottom, float top, float near_z, float far_z){
+	Matrix r{};
+	r.m[0][0] = 2.0f / (right - left);
+	r.m[1][1] = 2.0f / (top - bottom);
+	r.m[2][2] = 1.0f / (far_z - near_z);
+	r.m[3][0] = -(left + right) / (right - left);
+	r.m[3][1] = -(top + bottom) / (top - bottom);
+	r.m[3][2] = -near_z / (far_z - near_z);
+	r.m[3][3] = 1.0f;
+	return r;
+}
+
+//XMMatrixPerspectiveFovLHと同じ
+Matrix ShadowCascades::Matrix::PerspectiveFovLH(float fov_y, float aspect, float near_z, float far_z){
+	const float height = 1.0f / std::tan(0.5f * fov_y);
+	const float range = far_z / (far_z - near_z);
+
+	Matrix r{};
+	r.m[0][0] = height / aspect;
+	r.m[1][1] = height;
+	r.m[2][2] = range;
+	r.m[2][3] = 1.0f;
+	r.m[3][2] = -range * near_z;
+	return r;
+}
+
+
+ShadowCascades::ShadowCascades():
+	cascade_num_(1),
+	resolution_(1024),
+	split_lambda_(DEFAULT_SPLIT_LAMBDA),
+	has_scene_bounds_(false),
+	scene_min_{},
+	scene_max_{},
+	light_view_{},
+	cascades_{}{}
+
+bool ShadowCascades::Initialize(int cascade_num, int resolution, float split_lambda){
+	if(cascade_num < 1 || cascade_num > MAX_CASCADE_NUM || resolution < 2){
+		return false;
+	}
+	cascade_num_	= cascade_num;
+	resolution_		= resolution;
+	split_lambda_	= split_lambda;
+	return true;
+}
+
+void ShadowCascades::SetSceneBounds(const float min[3], const float max[3]){
+	for(int i = 0; i < 3; ++i){
+		scene_min_[i] = min[i];
+		scene_max_[i] = max[i];
+	}
+	has_scene_bounds_ = true;
+}
+
+void ShadowCascades::Update(const Camera &camera, const float light_dir[3], float shadow_distance){
+	const float far_z = (shadow_distance > 0.0f) ? std::min(shadow_distance, camera.far_z) : camera.far_z;
+	float splits[MAX_CASCADE_NUM + 1];
+	ComputeSplits(camera.near_z, far_z, cascade_num_, split_lambda_, splits);
+
+
+	//ライトのビューは回転だけにする(テクセルの格子がワールドに固定される)
+	static const float ORIGIN[3] = {0.0f, 0.0f, 0.0f};
+	static const float UP_Y[3] = {0.0f, 1.0f, 0.0f};
+	static const float UP_X[3] = {1.0f, 0.0f, 0.0f};
+	float forward[3] = {-light_dir[0], -light_dir[1], -light_dir[2]};
+	Normalize(forward);
+	light_view_ = Matrix::LookAtLH(ORIGIN, forward, (std::fabs(forward[1]) > 0.99f) ? UP_X : UP_Y);
+
+
+	//シーンの範囲のライト空間での箱
+	float scene_lo[3]{};
+	float scene_hi[3]{};
+	if(has_scene_bounds_){
+		for(int k = 0; k < 3; ++k){
+			scene_lo[k] = HUGE_VALF;
+			scene_hi[k] = -HUGE_VALF;
+		}
+		for(int i = 0; i < 8; ++i){
+			const float p[3] = {(i & 1) ? scene_max_[0] : scene_min_[0], (i & 2) ? scene_max_[1] : scene_min_[1], (i & 4) ? scene_max_[2] : scene_min_[2]};
+			float v[4];
+			light_view_.TransformPoint(p, v);
+			for(int k = 0; k < 3; ++k){
+				scene_lo[k] = std::min(scene_lo[k], v[k]);
+				scene_hi[k] = std::max(scene_hi[k], v[k]);
+			}
+		}
+	}
+
+	for(int c = 0; c < cascade_num_; ++c){
+		Cascade &cascade = cascades_[c];
+		cascade.split_near	= splits[c];
+		cascade.split_far	= splits[c + 1];
+
+		float corners[8][3];
+		FrustumCorners(camera, cascade.split_near, cascade.split_far, corners);
+
+		//区間の頂点のライト空間での箱と、頂点間の最大の距離(カメラの向きによらない)
+		float lo[3] = {HUGE_VALF, HUGE_VALF, HUGE_VALF};
+		float hi[3] = {-HUGE_VALF, -HUGE_VALF, -HUGE_VALF};
+		float diameter = 0.0f;
+		for(int i = 0; i < 8; ++i){
+			float v[4];
+			light_view_.TransformPoint(corners[i], v);
+			for(int k = 0; k < 3; ++k){
+				lo[k] = std::min(lo[k], v[k]);
+				hi[k] = std::max(hi[k], v[k]);
+			}
+			for(int j = i + 1; j < 8; ++j){
+				diameter = std::max(diameter, Distance(corners[i], corners[j]));
+			}
+		}
+
+		//シーンの外は影を受けるものがないので、幅はシーンの広さまでに縮めてよい(ライトが動かなければ一定)
+		float extent = diameter;
+		if(has_scene_bounds_){
+			extent = std::min(extent, std::max(scene_hi[0] - scene_lo[0], scene_hi[1] - scene_lo[1]));
+			for(int k = 0; k < 2; ++k){
+				const float a = std::max(lo[k], scene_lo[k]);
+				const float b = std::min(hi[k], scene_hi[k]);
+				lo[k] = (a <= b) ? a : b;
+				hi[k] = (a <= b) ? b : a;
+			}
+			lo[2] = std::min(lo[2], scene_lo[2]);
+			hi[2] = std::min(hi[2], scene_hi[2]);
+		}
+
+		//テクセル1つ分を足した幅にして、左下をテクセルの単位に切り捨てても箱がはみ出さないようにする
+		cascade.texel_size	= extent / static_cast<float>(resolution_ - 1);
+		cascade.width		= cascade.texel_size * static_cast<float>(resolution_);
+		const float left	= std::floor((0.5f * (lo[0] + hi[0] - extent)) / cascade.texel_size) * cascade.texel_size;
+		const float bottom	= std::floor((0.5f * (lo[1] + hi[1] - extent)) / cascade.texel_size) * cascade.texel_size;
+		const float z_far	= std::max(hi[2], lo[2] + 1.0e-3f);
+
+		cascade.view_proj = light_view_ * Matrix::OrthographicOffCenterLH(left, left + cascade.width, bottom, bottom + cascade.width, lo[2], z_far);
+	}
+}
+
+int ShadowCascades::Select(float view_depth) const{
+	for(int c = 0; c < cascade_num_; ++c){
+		if(view_depth <= cascades_[c].split_far){
+			return c;
+		}
+	}
+	return -1;
+}
+
+void ShadowCascades::ComputeSplits(float near_z, float far_z, int num, float lambda, float *splits){
+	splits[0] = near_z;
+	for(int i = 1; i < num; ++i){
+		const float t = static_cast<float>(i) / static_cast<float>(num);
+		const float log_split = near_z * std::pow(far_z / near_z, t);
+		const float uniform_split = near_z + (far_z - near_z) * t;
+		splits[i] = lambda * log_split + (1.0f - lambda) * uniform_split;
+	}
+	splits[num] = far_z;
+}
+
+void ShadowCascades::FrustumCorners(const Camera &camera, float near_z, float far_z, float corners[8][3]){
+	float z[3] = {camera.focus[0] - camera.eye[0], camera.focus[1] - camera.eye[1], camera.focus[2] - camera.eye[2]};
+	Normalize(z);
+	float x[3];
+	Cross(camera.up, z, x);
+	Normalize(x);
+	float y[3];
+	Cross(z, x, y);
+
+	const float tan_y = std::tan(camera.fov_y * 0.5f);
+	const float tan_x = tan_y * camera.aspect;
+	const float depths[2] = {near_z, far_z};
+	for(int d = 0; d < 2; ++d){
+		for(int i = 0; i < 4; ++i){
+			const float sx = ((i & 1) ? 1.0f : -1.0f) * tan_x * depths[d];
+			const float sy = ((i & 2) ? -1.0f : 1.0f) * tan_y * depths[d];
+			for(int k = 0; k < 3; ++k){
+				corners[d * 4 + i][k] = camera.eye[k] + z[k] * depths[d] + x[k] * sx + y[k] * sy;
+			}
+		}
+	}
+}
@@ -0,0 +1,87 @@
+#ifndef SHADOW_CASCADES_HEADER_
+#define SHADOW_CASCADES_HEADER_
+
+//カスケードシャドウマップの分割と、カスケードごとのライトの行列の計算
+//・カメラの視錐台を対数分割と均等分割を混ぜた位置(practical split)で奥行き方向に分ける
+//・各区間の視錐台をライトの向きの正射影で囲む。幅は区間の最も離れた頂点間の距離(シーンの範囲が狭ければそちら)に固定し、
+//  左下をテクセルの単位にそろえる(カメラが回っても動いても影の縁のテクセルが揺れない)
+//・奥行きはシーンの範囲までライト側に広げる(区間の外にある、影を落とすものも描く)
+//
+//行列はDirectXMathと同じく行ベクトルに右から掛ける並びで、シャドウマップ上の座標はxyが[-1, 1]・zが[0, 1]
+class ShadowCascades{
+public:
+	static constexpr int MAX_CASCADE_NUM = 4;
+	static constexpr float DEFAULT_SPLIT_LAMBDA = 0.5f;	//1なら対数分割、0なら均等分割
+
+	struct Matrix{
+		float m[4][4];
+
+		Matrix operator*(const Matrix &other) const;
+		Matrix Transposed() const;
+
+		//(p, 1)を変換する(wで割らない)
+		void TransformPoint(const float p[3], float out[4]) const;
+
+		static Matrix LookAtLH(const float eye[3], const float focus[3], const float up[3]);
+		static Matrix OrthographicOffCenterLH(float left, float right, float bottom, float top, float near_z, float far_z);
+		static Matrix PerspectiveFovLH(float fov_y, float aspect, float near_z, float far_z);
+	};
+
+	//XMMatrixLookAtLH・XMMatrixPerspectiveFovLHの引数と同じ形で持つ(fov_yはラジアン。Sceneのカメラにも使う)
+	struct Camera{
+		float	eye[3];
+		float	focus[3];
+		float	up[3];
+		float	fov_y;
+		float	aspect;
+		float	near_z;
+		float	far_z;
+	};
+
+	struct Cascade{
+		Matrix	view_proj;		//ワールド座標からシャドウマップの座標への変換
+		float	split_near;		//カメラのビュー空間での奥行きの範囲
+		float	split_far;
+		float	width;			//正射影の幅と高さ(ワールドの単位)
+		float	texel_size;		//width / 解像度
+	};
+
+public:
+	ShadowCascades();
+	~ShadowCascades(){}
+
+	//cascade_numは1からMAX_CASCADE_NUM、resolutionはシャドウマップの1辺のテクセル数
+	bool Initialize(int cascade_num, int resolution, float split_lambda = DEFAULT_SPLIT_LAMBDA);
+
+	//影を落とすもの・受けるものが収まる範囲(設定しなければカメラの視錐台だけで決める)
+	void SetSceneBounds(const float min[3], const float max[3]);
+
+	//light_dirは光が来る向き(ライトの方を向く)。shadow_distanceまでを分割する(0以下ならカメラのfar_z)
+	void Update(const Camera &camera, const float light_dir[3], float shadow_distance = 0.0f);
+
+	int CascadeNum() const{return cascade_num_;}
+	int Resolution() const{return resolution_;}
+	const Cascade& GetCascade(int index) const{return cascades_[index];}
+	const Matrix& LightView() const{return light_view_;}
+
+	//ビュー空間の奥行きに対して使うカスケード(シェーダと同じ選び方)。最も遠いカスケードより先なら-1
+	int Select(float view_depth) const;
+
+	//splitsにnum + 1個の境界を書き出す(splits[0] = near_z, splits[num] = far_z)
+	static void ComputeSplits(float near_z, float far_z, int num, float lambda, float *splits);
+
+	//カメラの視錐台のうち奥行きがnear_zからfar_zの部分の頂点(手前の4つ・奥の4つの順)
+	static void FrustumCorners(const Camera &camera, float near_z, float far_z, float corners[8][3]);
+
+private:
+	int			cascade_num_;
+	int			resolution_;
+	float		split_lambda_;
+	bool		has_scene_bounds_;
+	float		scene_min_[3];
+	float		scene_max_[3];
+	Matrix		light_view_;
+	Cascade		cascades_[MAX_CASCADE_NUM];
+};
+
+#endif
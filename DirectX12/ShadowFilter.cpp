@@ -0,0 +1,227 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include "ShadowFilter.h"
+
+const float ShadowFilter::POISSON_DISK[POISSON_TAP_NUM][2] = {
+	{-0.94201624f, -0.39906216f},
+	{ 0.94558609f, -0.76890725f},
+	{-0.09418410f, -0.92938870f},
+	{ 0.34495938f,  0.29387760f},
+	{-0.91588581f,  0.45771432f},
+	{-0.81544232f, -0.87912464f},
+	{-0.38277543f,  0.27676845f},
+	{ 0.97484398f,  0.75648379f},
+	{ 0.44323325f, -0.97511554f},
+	{ 0.53742981f, -0.47373420f},
+	{-0.26496911f, -0.41893023f},
+	{ 0.79197514f,  0.19090188f},
+	{-0.24188840f,  0.99706507f},
+	{-0.81409955f,  0.91437590f},
+	{ 0.19984126f,  0.78641367f},
+	{ 0.14383161f, -0.14100790f},
+};
+
+namespace{
+//チェビシェフの不等式で、深度の分布(1次・2次のモーメント)に対してtより奥が光を受ける割合の上限を見積もる
+float ChebyshevUpperBound(float mean, float mean_sq, float t, float min_variance){
+	if(t <= mean){
+		return 1.0f;
+	}
+	const float variance = std::max(mean_sq - mean * mean, min_variance);
+	const float d = t - mean;
+	const float p = variance / (variance + d * d);
+
+	//小さな見積もりは影にして、残りを[0, 1]に伸ばす
+	const float a = ShadowFilter::EVSM_LIGHT_BLEEDING_REDUCTION;
+	return std::min(std::max((p - a) / (1.0f - a), 0.0f), 1.0f);
+}
+}
+
+ShadowFilter::ShadowFilter():
+	width_{},
+	height_{},
+	depth_{},
+	moments_{},
+	work_{}{}
+
+void ShadowFilter::SetDepthMap(const float *depth, int width, int height){
+	width_	= width;
+	height_	= height;
+	depth_.assign(depth, depth + static_cast<size_t>(width) * height);
+	moments_.clear();
+}
+
+void ShadowFilter::Prefilter(int blur_radius){
+	const size_t texel_num = static_cast<size_t>(width_) * height_;
+	const float weight = 1.0f / (2 * blur_radius + 1);
+	moments_.assign(texel_num * 4, 0.0f);
+	work_.assign(texel_num * 4, 0.0f);
+
+	//横方向: 深度をモーメントにしながらぼかす(シェーダのPSEvsmBlurX)
+	for(int y = 0; y < height_; ++y){
+		for(int x = 0; x < width_; ++x){
+			float *out = &work_[(static_cast<size_t>(y) * width_ + x) * 4];
+			for(int i = -blur_radius; i <= blur_radius; ++i){
+				const int sx = std::min(std::max(x + i, 0), width_ - 1);
+				float m[4];
+				WarpDepth(depth_[static_cast<size_t>(y) * width_ + sx], m);
+				for(int c = 0; c < 4; ++c){
+					out[c] += m[c];
+				}
+			}
+			for(int c = 0; c < 4; ++c){
+				out[c] *= weight;
+			}
+		}
+	}
+
+	//縦方向(シェーダのPSEvsmBlurY)
+	for(int y = 0; y < height_; ++y){
+		for(int x = 0; x < width_; ++x){
+			float *out = &moments_[(static_cast<size_t>(y) * width_ + x) * 4];
+			for(int i = -blur_radius; i <= blur_radius; ++i){
+				const int sy = std::min(std::max(y + i, 0), height_ - 1);
+				const float *m = &work_[(static_cast<size_t>(sy) * width_ + x) * 4];
+				for(int c = 0; c < 4; ++c){
+					out[c] += m[c];
+				}
+			}
+			for(int c = 0; c < 4; ++c){
+				out[c] *= weight;
+			}
+		}
+	}
+}
+
+float ShadowFilter::Visibility(ShadowFilterTier tier, float u, float v, float z, float angle) const{
+	switch(tier){
+		case SHADOW_FILTER_HARD:	return Hard(u, v, z);
+		case SHADOW_FILTER_PCF:		return Pcf(u, v, z);
+		case SHADOW_FILTER_POISSON:	return Poisson(u, v, z, angle);
+		default:					return Evsm(u, v, z);
+	}
+}
+
+//テクセルの中で最も近いものと比べる(シェーダではLoad)
+float ShadowFilter::Hard(float u, float v, float z) const{
+	const int x = static_cast<int>(std::floor(u * width_));
+	const int y = static_cast<int>(std::floor(v * height_));
+	return (z <= Depth(x, y)) ? 1.0f : 0.0f;
+}
+
+//座標を囲む2x2のテクセルとそれぞれ比べ、結果を双線形補間する(比較サンプラのLINEARのフィルタ)
+float ShadowFilter::Pcf(float u, float v, float z) const{
+	const float fx = u * width_ - 0.5f;
+	const float fy = v * height_ - 0.5f;
+	const int x = static_cast<int>(std::floor(fx));
+	const int y = static_cast<int>(std::floor(fy));
+	const float wx = fx - x;
+	const float wy = fy - y;
+
+	const float c00 = (z <= Depth(x, y)) ? 1.0f : 0.0f;
+	const float c10 = (z <= Depth(x + 1, y)) ? 1.0f : 0.0f;
+	const float c01 = (z <= Depth(x, y + 1)) ? 1.0f : 0.0f;
+	const float c11 = (z <= Depth(x + 1, y + 1)) ? 1.0f : 0.0f;
+
+	const float top		= c00 + (c10 - c00) * wx;
+	const float bottom	= c01 + (c11 - c01) * wx;
+	return top + (bottom - top) * wy;
+}
+
+//ポアソンディスクの各点(半径radiusテクセル、angleだけ回す)でPCFを行って平均する
+float ShadowFilter::Poisson(float u, float v, float z, float angle, float radius) const{
+	const float c = std::cos(angle);
+	const float s = std::sin(angle);
+	const float scale_u = radius / width_;
+	const float scale_v = radius / height_;
+
+	float sum = 0.0f;
+	for(const float *p : POISSON_DISK){
+		const float du = (c * p[0] - s * p[1]) * scale_u;
+		const float dv = (s * p[0] + c * p[1]) * scale_v;
+		sum += Pcf(u + du, v + dv, z);
+	}
+	return sum / POISSON_TAP_NUM;
+}
+
+//ぼかしたモーメントを双線形補間し、正と負の指数のそれぞれで見積もった小さい方を使う
+float ShadowFilter::Evsm(float u, float v, float z) const{
+	const float fx = u * width_ - 0.5f;
+	const float fy = v * height_ - 0.5f;
+	const int x = static_cast<int>(std::floor(fx));
+	const int y = static_cast<int>(std::floor(fy));
+	const float wx = fx - x;
+	const float wy = fy - y;
+
+	float m00[4], m10[4], m01[4], m11[4];
+	Moments(x, y, m00);
+	Moments(x + 1, y, m10);
+	Moments(x, y + 1, m01);
+	Moments(x + 1, y + 1, m11);
+
+	float m[4];
+	for(int c = 0; c < 4; ++c){
+		const float top		= m00[c] + (m10[c] - m00[c]) * wx;
+		const float bottom	= m01[c] + (m11[c] - m01[c]) * wx;
+		m[c] = top + (bottom - top) * wy;
+	}
+
+	float warped[4];
+	WarpDepth(z, warped);
+	const float pos_scale = EVSM_VARIANCE_BIAS * EVSM_POSITIVE_EXPONENT * warped[0];
+	const float neg_scale = EVSM_VARIANCE_BIAS * EVSM_NEGATIVE_EXPONENT * warped[2];
+	const float pos = ChebyshevUpperBound(m[0], m[1], warped[0], pos_scale * pos_scale);
+	const float neg = ChebyshevUpperBound(m[2], m[3], warped[2], neg_scale * neg_scale);
+	return std::min(pos, neg);
+}
+
+//範囲の外は端のテクセルを使う(シェーダではCLAMPのサンプラ)
+void ShadowFilter::Moments(int x, int y, float moments[4]) const{
+	x = std::min(std::max(x, 0), width_ - 1);
+	y = std::min(std::max(y, 0), height_ - 1);
+	memcpy(moments, &moments_[(static_cast<size_t>(y) * width_ + x) * 4], sizeof(float) * 4);
+}
+
+//深度を[-1, 1]に広げてから正と負の指数で歪める(負の方は奥ほど大きくなるように符号を反転する)
+void ShadowFilter::WarpDepth(float depth, float moments[4]){
+	const float d = 2.0f * depth - 1.0f;
+	const float pos = std::exp(EVSM_POSITIVE_EXPONENT * d);
+	const float neg = -std::exp(-EVSM_NEGATIVE_EXPONENT * d);
+	moments[0] = pos;
+	moments[1] = pos * pos;
+	moments[2] = neg;
+	moments[3] = neg * neg;
+}
+
+int ShadowFilter::TexelReadNum(ShadowFilterTier tier){
+	switch(tier){
+		case SHADOW_FILTER_HARD:	return 1;
+		case SHADOW_FILTER_PCF:		return 4;
+		case SHADOW_FILTER_POISSON:	return 4 * POISSON_TAP_NUM;
+		default:					return 4;
+	}
+}
+
+const char* ShadowFilter::TierName(ShadowFilterTier tier){
+	static const char *names[SHADOW_FILTER_NUM] = {"hard", "pcf", "poisson", "evsm"};
+	return (tier >= 0 && tier < SHADOW_FILTER_NUM) ? names[tier] : "";
+}
+
+bool ShadowFilter::ParseTier(const char *name, ShadowFilterTier *tier){
+	for(int i = 0; i < SHADOW_FILTER_NUM; ++i){
+		if(strcmp(name, TierName(static_cast<ShadowFilterTier>(i))) == 0){
+			*tier = static_cast<ShadowFilterTier>(i);
+			return true;
+		}
+	}
+	return false;
+}
+
+//シャドウマップの外は光が当たる(比較サンプラの境界色が白)
+float ShadowFilter::Depth(int x, int y) const{
+	if(x < 0 || y < 0 || x >= width_ || y >= height_){
+		return 1.0f;
+	}
+	return depth_[static_cast<size_t>(y) * width_ + x];
+}
@@ -0,0 +1,81 @@
+#ifndef SHADOW_FILTER_HEADER_
+#define SHADOW_FILTER_HEADER_
+
+#include <vector>
+
+//シャドウマップのフィルタ(影の縁をぼかす方法)の段階。後のものほどGPUの負荷が大きく、縁がなめらかになる
+enum ShadowFilterTier{
+	SHADOW_FILTER_HARD,		//1テクセルと比べる(縁がテクセルの形に欠ける)
+	SHADOW_FILTER_PCF,		//比較サンプラで2x2のテクセルと比べた結果を双線形補間する(ハードウェアPCF)
+	SHADOW_FILTER_POISSON,	//ポアソンディスク上の点でハードウェアPCFを行って平均する(点の並びはピクセルごとに回す)
+	SHADOW_FILTER_EVSM,		//指数で歪めた深度のモーメントを分離可能なぼかしで前処理し、チェビシェフの不等式で見積もる
+	SHADOW_FILTER_NUM,
+};
+
+//シャドウマップのフィルタのCPUでの参照実装(Shaders.hlslのShadowFactorと同じ計算)
+//・深度は[0, 1]で、比較はシェーダの比較サンプラ(LESS_EQUAL)と同じく 受ける側の深度 <= シャドウマップの深度 なら光が当たる
+//・シャドウマップの外は深度1(光が当たる)として扱う。EVSMのモーメントは端のテクセルを延ばす
+//・結果は光が当たる割合(0なら影)
+//
+//使い方: SetDepthMapで深度を渡す(EVSMはさらにPrefilterでモーメントを作る) → Visibilityなどで調べる
+class ShadowFilter{
+public:
+	static constexpr int POISSON_TAP_NUM = 16;
+	static constexpr float POISSON_RADIUS = 2.0f;			//ポアソンディスクの半径(テクセル)
+	static constexpr float EVSM_POSITIVE_EXPONENT = 40.0f;	//32bit浮動小数点のモーメントで2乗しても溢れない大きさ
+	static constexpr float EVSM_NEGATIVE_EXPONENT = 5.0f;
+	static constexpr int EVSM_BLUR_RADIUS = 2;				//ぼかしの幅は2 * EVSM_BLUR_RADIUS + 1テクセル
+	static constexpr float EVSM_VARIANCE_BIAS = 0.0001f;		//分散の下限は(これ * 指数 * 歪めた深度)の2乗(深度の誤差で自分に影を落とさない)
+	static constexpr float EVSM_LIGHT_BLEEDING_REDUCTION = 0.25f;	//これ以下の見積もりを影とする(重なった影の光漏れを抑える)
+
+	//半径1程度に散らした点(シェーダのPOISSON_DISKと合わせる)
+	static const float POISSON_DISK[POISSON_TAP_NUM][2];
+
+public:
+	ShadowFilter();
+	~ShadowFilter(){}
+
+	//depthはwidth * height個の深度(行ごと)。Prefilterで作ったモーメントは捨てる
+	void SetDepthMap(const float *depth, int width, int height);
+
+	//EVSMのモーメントを作り、横・縦の順にぼかす
+	void Prefilter(int blur_radius = EVSM_BLUR_RADIUS);
+
+	int Width() const{return width_;}
+	int Height() const{return height_;}
+
+	//u, vはシャドウマップ上の座標([0, 1])、zは受ける側の深度(比べる段階ではバイアスを引いたもの)
+	//angleはポアソンディスクを回す角度(シェーダではピクセルごとのノイズで決める)
+	float Visibility(ShadowFilterTier tier, float u, float v, float z, float angle = 0.0f) const;
+
+	float Hard(float u, float v, float z) const;
+	float Pcf(float u, float v, float z) const;
+	float Poisson(float u, float v, float z, float angle = 0.0f, float radius = POISSON_RADIUS) const;
+	float Evsm(float u, float v, float z) const;
+
+	//ぼかした後のテクセルのモーメント(正の指数の1次・2次、負の指数の1次・2次)
+	void Moments(int x, int y, float moments[4]) const;
+
+	//深度を指数で歪めたモーメント
+	static void WarpDepth(float depth, float moments[4]);
+
+	//段階ごとにシャドウマップのテクセルを読む数(EVSMは前処理でテクセルごとに読む数を含めない)
+	static int TexelReadNum(ShadowFilterTier tier);
+
+	static const char* TierName(ShadowFilterTier tier);
+
+	//コマンドラインの名前(hard, pcf, poisson, evsm)から段階を求める
+	static bool ParseTier(const char *name, ShadowFilterTier *tier);
+
+private:
+	float Depth(int x, int y) const;
+
+private:
+	int					width_;
+	int					height_;
+	std::vector<float>	depth_;
+	std::vector<float>	moments_;	//テクセルごとに4つ(Prefilterを呼ぶまでは空)
+	std::vector<float>	work_;		//横方向にぼかした結果
+};
+
+#endif
@@ -1,28 +1,42 @@
-#ifndef SHADOW_MAP_DEBUG_HEADER_
-#define SHADOW_MAP_DEBUG_HEADER_
-
-#include <d3d12.h>
-#include <wrl/client.h>
-
-using namespace Microsoft::WRL;
-
-class ShadowMapDebug{
-public:
-	ShadowMapDebug();
-	~ShadowMapDebug(){}
-	HRESULT Initialize(ID3D12Device *device);
-	HRESULT Draw(ID3D12GraphicsCommandList *command_list, ID3D12DescriptorHeap *dh_sm);
-
-private:
-	HRESULT CreateRootSignature(ID3D12Device *device);
-	HRESULT CreatePSO(ID3D12Device *device);
-
-private:
-	ComPtr<ID3D12RootSignature>		root_sugnature_;
-	ComPtr<ID3D12PipelineState>		pso_;
-	ComPtr<ID3D12Resource>			vertex_buffer_;
-	ComPtr<ID3D12Resource>			constant_buffer_;
-
-};
-
-#endif
+#ifndef SHADOW_MAP_DEBUG_HEADER_
+#define SHADOW_MAP_DEBUG_HEADER_
+
+#include <d3d12.h>
+#include <wrl/client.h>
+#include "RenderCommandList.h"
+#include "ShaderCache.h"
+#include "PipelineStateManager.h"
+#include "CopyUploader.h"
+
+using namespace Microsoft::WRL;
+
+class ShadowMapDebug{
+public:
+	ShadowMapDebug();
+	~ShadowMapDebug(){}
+	HRESULT Load(ShaderCache *shader_cache);
+	//cascade_numはシャドウマップの配列のスライス数(横に並べて表示する)
+	HRESULT Initialize(ID3D12Device *device, CopyUploader *uploader, PipelineStateManager *pipeline_states, int cascade_num = 1);
+
+	//今フレームで使うメモリを伝える(描画の前に呼ぶ)
+	void UseMemory(GpuMemoryAllocator *memory) const;
+
+	//sm_tableはシャドウマップのSRV(そのデスクリプタヒープは呼び出し側で設定しておく)
+	HRESULT Draw(RenderCommandList *command_list, RenderDescriptorTable sm_table);
+
+private:
+	HRESULT CreateRootSignature(ID3D12Device *device);
+	HRESULT CreatePSO();
+
+private:
+	ComPtr<ID3D12RootSignature>		root_sugnature_;
+	PipelineStateManager			*pipeline_states_;
+	PipelineStateManager::Handle	pso_;
+	GpuMemoryAllocator::BufferRange	vertex_buffer_;
+	GpuMemoryAllocator::BufferRange	constant_buffer_;
+	ComPtr<ID3DBlob>				vertex_shader_;
+	ComPtr<ID3DBlob>				pixel_shader_;
+
+};
+
+#endif
@@ -1,40 +1,45 @@
-cbuffer cbTansMatrix : register(b0){
-	float4x4 WVP;
-};
-
-Texture2D<float> tex0 : register(t0);
-SamplerState samp0 : register(s0);
-
-
-struct VS_INPUT{
-	float3 Position : POSITION;
-	float3 Normal	: NORMAL;
-	float2 UV		: TEXCOORD;
-};
-
-
-struct PS_INPUT{//(VS_OUTPUT)
-	float4 Position : SV_POSITION;
-	float2 UV		: TEXCOORD;
-};
-
-
-PS_INPUT VSMain(VS_INPUT input){
-	PS_INPUT output;
-
-	float4 Pos = float4(input.Position, 1.0f);
-	output.Position = mul(Pos, WVP);
-	output.UV.x = input.UV.x;
-	output.UV.y = 1.0f - input.UV.y;
-
-	return output;
-}
-
-
-float4 PSMain(PS_INPUT input) : SV_TARGET{
-	float color = tex0.Sample(samp0, input.UV);
-	return float4(color, color, color, 1.0f);
-}
-
-
-
+cbuffer cbTansMatrix : register(b0){
+	float4x4 WVP;
+};
+
+Texture2DArray<float> tex0 : register(t0);	//カスケードのシャドウマップ
+SamplerState samp0 : register(s0);
+
+
+struct VS_INPUT{
+	float3 Position : POSITION;
+	float3 Normal	: NORMAL;
+	float2 UV		: TEXCOORD;
+};
+
+
+struct PS_INPUT{//(VS_OUTPUT)
+	float4 Position : SV_POSITION;
+	float2 UV		: TEXCOORD;
+};
+
+
+PS_INPUT VSMain(VS_INPUT input){
+	PS_INPUT output;
+
+	float4 Pos = float4(input.Position, 1.0f);
+	output.Position = mul(Pos, WVP);
+	output.UV.x = input.UV.x;
+	output.UV.y = 1.0f - input.UV.y;
+
+	return output;
+}
+
+
+//カスケードを左から順に横に並べて表示する
+float4 PSMain(PS_INPUT input) : SV_TARGET{
+	uint width, height, elements;
+	tex0.GetDimensions(width, height, elements);
+	float t = (1.0f - input.UV.y) * elements;
+	float slice = min(floor(t), elements - 1);
+	float color = tex0.Sample(samp0, float3(input.UV.x, 1.0f - (t - slice), slice));
+	return float4(color, color, color, 1.0f);
+}
+
+
+
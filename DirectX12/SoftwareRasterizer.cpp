@@ -0,0 +1,726 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <future>
+#include "SoftwareRasterizer.h"
+#include "JobSystem.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SOFTWARE_RASTERIZER_SSE2
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define SOFTWARE_RASTERIZER_NEON
+#endif
+
+namespace{
+typedef SoftwareRasterizer::byte byte;
+typedef SoftwareRasterizer::Matrix Matrix;
+
+constexpr float SUBPIXEL = 256.0f;	//D3D12と同じく8bitの精度で頂点をスナップする
+constexpr float GUARD_BAND = 16384.0f;	//スクリーン座標がこの範囲に収まるようにクリップする
+constexpr int MAX_CLIP_VERTEX = 3 + 6;
+
+//2x2画素をまとめて処理するための4要素のベクトル(レーンの並びは左上・右上・左下・右下)
+#if defined(SOFTWARE_RASTERIZER_SSE2)
+struct Float4{
+	__m128 v;
+};
+inline Float4 Splat(float a){return {_mm_set1_ps(a)};}
+inline Float4 Set(float a, float b, float c, float d){return {_mm_setr_ps(a, b, c, d)};}
+inline Float4 operator+(Float4 a, Float4 b){return {_mm_add_ps(a.v, b.v)};}
+inline Float4 operator-(Float4 a, Float4 b){return {_mm_sub_ps(a.v, b.v)};}
+inline Float4 operator*(Float4 a, Float4 b){return {_mm_mul_ps(a.v, b.v)};}
+inline Float4 operator/(Float4 a, Float4 b){return {_mm_div_ps(a.v, b.v)};}
+inline int MaskGreater(Float4 a, Float4 b){return _mm_movemask_ps(_mm_cmpgt_ps(a.v, b.v));}
+inline int MaskGreaterEqual(Float4 a, Float4 b){return _mm_movemask_ps(_mm_cmpge_ps(a.v, b.v));}
+inline int MaskLessEqual(Float4 a, Float4 b){return _mm_movemask_ps(_mm_cmple_ps(a.v, b.v));}
+inline void Store(float *dst, Float4 a){_mm_storeu_ps(dst, a.v);}
+#elif defined(SOFTWARE_RASTERIZER_NEON)
+struct Float4{
+	float32x4_t v;
+};
+inline Float4 Splat(float a){return {vdupq_n_f32(a)};}
+inline Float4 Set(float a, float b, float c, float d){const float t[4] = {a, b, c, d}; return {vld1q_f32(t)};}
+inline Float4 operator+(Float4 a, Float4 b){return {vaddq_f32(a.v, b.v)};}
+inline Float4 operator-(Float4 a, Float4 b){return {vsubq_f32(a.v, b.v)};}
+inline Float4 operator*(Float4 a, Float4 b){return {vmulq_f32(a.v, b.v)};}
+inline Float4 operator/(Float4 a, Float4 b){return {vdivq_f32(a.v, b.v)};}
+inline int ToMask(uint32x4_t m){
+	const uint32_t bits[4] = {1, 2, 4, 8};
+	return static_cast<int>(vaddvq_u32(vandq_u32(m, vld1q_u32(bits))));
+}
+inline int MaskGreater(Float4 a, Float4 b){return ToMask(vcgtq_f32(a.v, b.v));}
+inline int MaskGreaterEqual(Float4 a, Float4 b){return ToMask(vcgeq_f32(a.v, b.v));}
+inline int MaskLessEqual(Float4 a, Float4 b){return ToMask(vcleq_f32(a.v, b.v));}
+inline void Store(float *dst, Float4 a){vst1q_f32(dst, a.v);}
+#else
+struct Float4{
+	float v[4];
+};
+inline Float4 Splat(float a){return {{a, a, a, a}};}
+inline Float4 Set(float a, float b, float c, float d){return {{a, b, c, d}};}
+inline Float4 operator+(Float4 a, Float4 b){return {{a.v[0] + b.v[0], a.v[1] + b.v[1], a.v[2] + b.v[2], a.v[3] + b.v[3]}};}
+inline Float4 operator-(Float4 a, Float4 b){return {{a.v[0] - b.v[0], a.v[1] - b.v[1], a.v[2] - b.v[2], a.v[3] - b.v[3]}};}
+inline Float4 operator*(Float4 a, Float4 b){return {{a.v[0] * b.v[0], a.v[1] * b.v[1], a.v[2] * b.v[2], a.v[3] * b.v[3]}};}
+inline Float4 operator/(Float4 a, Float4 b){return {{a.v[0] / b.v[0], a.v[1] / b.v[1], a.v[2] / b.v[2], a.v[3] / b.v[3]}};}
+inline int MaskGreater(Float4 a, Float4 b){
+	return (a.v[0] > b.v[0] ? 1 : 0) | (a.v[1] > b.v[1] ? 2 : 0) | (a.v[2] > b.v[2] ? 4 : 0) | (a.v[3] > b.v[3] ? 8 : 0);
+}
+inline int MaskGreaterEqual(Float4 a, Float4 b){
+	return (a.v[0] >= b.v[0] ? 1 : 0) | (a.v[1] >= b.v[1] ? 2 : 0) | (a.v[2] >= b.v[2] ? 4 : 0) | (a.v[3] >= b.v[3] ? 8 : 0);
+}
+inline int MaskLessEqual(Float4 a, Float4 b){
+	return (a.v[0] <= b.v[0] ? 1 : 0) | (a.v[1] <= b.v[1] ? 2 : 0) | (a.v[2] <= b.v[2] ? 4 : 0) | (a.v[3] <= b.v[3] ? 8 : 0);
+}
+inline void Store(float *dst, Float4 a){memcpy(dst, a.v, sizeof(a.v));}
+#endif
+
+
+//行ベクトル * 行列
+void Transform(const float v[4], const Matrix &m, float out[4]){
+	for(int i = 0; i < 4; ++i){
+		out[i] = v[0] * m.m[0][i] + v[1] * m.m[1][i] + v[2] * m.m[2][i] + v[3] * m.m[3][i];
+	}
+}
+
+//クリップ空間の頂点と属性
+struct ClipVertex{
+	float	pos[4];
+	float	attr[5];
+};
+
+//クリップ面(dot(plane, pos) >= 0が内側)
+struct ClipPlane{
+	float	p[4];
+};
+
+float PlaneDistance(const ClipPlane &plane, const ClipVertex &v){
+	return plane.p[0] * v.pos[0] + plane.p[1] * v.pos[1] + plane.p[2] * v.pos[2] + plane.p[3] * v.pos[3];
+}
+
+//Sutherland-Hodgmanで多角形を1枚の面で切る
+int ClipPolygon(const ClipPlane &plane, const ClipVertex *src, int src_num, ClipVertex *dst){
+	int dst_num = 0;
+	for(int i = 0; i < src_num; ++i){
+		const ClipVertex &a = src[i];
+		const ClipVertex &b = src[(i + 1) % src_num];
+		const float da = PlaneDistance(plane, a);
+		const float db = PlaneDistance(plane, b);
+
+		if(da >= 0.0f){
+			dst[dst_num++] = a;
+		}
+		if((da >= 0.0f) != (db >= 0.0f)){
+			const float t = da / (da - db);
+			ClipVertex &v = dst[dst_num++];
+			for(int j = 0; j < 4; ++j){
+				v.pos[j] = a.pos[j] + (b.pos[j] - a.pos[j]) * t;
+			}
+			for(int j = 0; j < 5; ++j){
+				v.attr[j] = a.attr[j] + (b.attr[j] - a.attr[j]) * t;
+			}
+		}
+	}
+	return dst_num;
+}
+
+float Snap(float v){
+	return std::floor(v * SUBPIXEL + 0.5f) / SUBPIXEL;
+}
+
+int WrapCoord(int v, int size){
+	v %= size;
+	return v < 0 ? v + size : v;
+}
+
+//ラップ・バイリニアでBGRA8の1レベルを読む(0～1の値)
+void SampleBilinear(const SoftwareRasterizer::TextureLevel &level, float u, float v, float out[4]){
+	const float tx = u * level.width - 0.5f;
+	const float ty = v * level.height - 0.5f;
+	const float fx0 = std::floor(tx);
+	const float fy0 = std::floor(ty);
+	const float fx = tx - fx0;
+	const float fy = ty - fy0;
+	const int x0 = WrapCoord(static_cast<int>(fx0), level.width);
+	const int y0 = WrapCoord(static_cast<int>(fy0), level.height);
+	const int x1 = (x0 + 1 == level.width) ? 0 : x0 + 1;
+	const int y1 = (y0 + 1 == level.height) ? 0 : y0 + 1;
+
+	const byte *r0 = level.pixels + y0 * level.row_pitch;
+	const byte *r1 = level.pixels + y1 * level.row_pitch;
+	const byte *p00 = r0 + x0 * 4;
+	const byte *p10 = r0 + x1 * 4;
+	const byte *p01 = r1 + x0 * 4;
+	const byte *p11 = r1 + x1 * 4;
+	for(int c = 0; c < 4; ++c){
+		const float top		= p00[c] + (p10[c] - p00[c]) * fx;
+		const float bottom	= p01[c] + (p11[c] - p01[c]) * fx;
+		out[c] = (top + (bottom - top) * fy) * (1.0f / 255.0f);
+	}
+}
+
+//トライリニアでテクスチャを読む(samp0: MIN_MAG_MIP_LINEAR, WRAP)
+void SampleTexture(const SoftwareRasterizer::Texture &texture, float u, float v, float lod, float out[4]){
+	const int level_num = static_cast<int>(texture.levels.size());
+	if(lod <= 0.0f || level_num == 1){
+		SampleBilinear(texture.levels[0], u, v, out);
+		return;
+	}
+
+	lod = std::min(lod, static_cast<float>(level_num - 1));
+	const int l0 = static_cast<int>(lod);
+	const int l1 = std::min(l0 + 1, level_num - 1);
+	const float f = lod - l0;
+
+	SampleBilinear(texture.levels[l0], u, v, out);
+	if(f > 0.0f && l1 != l0){
+		float next[4];
+		SampleBilinear(texture.levels[l1], u, v, next);
+		for(int c = 0; c < 4; ++c){
+			out[c] += (next[c] - out[c]) * f;
+		}
+	}
+}
+
+//バイリニアでシャドウマップを読む(samp1: BORDER、境界色は白なので外側は深度1)
+float SampleShadowMap(const float *shadow_map, float u, float v){
+	const int size = SoftwareRasterizer::SHADOW_MAP_SIZE;
+	const float tx = u * size - 0.5f;
+	const float ty = v * size - 0.5f;
+	const float fx0 = std::floor(tx);
+	const float fy0 = std::floor(ty);
+	const float fx = tx - fx0;
+	const float fy = ty - fy0;
+
+	//範囲外の座標でも整数に変換できるように丸めておく(境界の外は値を読まない)
+	const int x0 = static_cast<int>(std::max(-2.0f, std::min(fx0, static_cast<float>(size + 1))));
+	const int y0 = static_cast<int>(std::max(-2.0f, std::min(fy0, static_cast<float>(size + 1))));
+	const auto fetch = [&](int x, int y){
+		return (x < 0 || y < 0 || x >= size || y >= size) ? 1.0f : shadow_map[y * size + x];
+	};
+
+	const float top		= fetch(x0, y0) + (fetch(x0 + 1, y0) - fetch(x0, y0)) * fx;
+	const float bottom	= fetch(x0, y0 + 1) + (fetch(x0 + 1, y0 + 1) - fetch(x0, y0 + 1)) * fx;
+	return top + (bottom - top) * fy;
+}
+
+byte ToUnorm8(float v){
+	v = std::max(0.0f, std::min(1.0f, v));
+	return static_cast<byte>(v * 255.0f + 0.5f);
+}
+}
+
+
+SoftwareRasterizer::Matrix SoftwareRasterizer::Matrix::operator*(const Matrix &other) const{
+	Matrix r{};
+	for(int i = 0; i < 4; ++i){
+		for(int j = 0; j < 4; ++j){
+			r.m[i][j] = m[i][0] * other.m[0][j] + m[i][1] * other.m[1][j] + m[i][2] * other.m[2][j] + m[i][3] * other.m[3][j];
+		}
+	}
+	return r;
+}
+
+SoftwareRasterizer::Matrix SoftwareRasterizer::Matrix::Identity(){
+	return Scaling(1.0f, 1.0f, 1.0f);
+}
+
+SoftwareRasterizer::Matrix SoftwareRasterizer::Matrix::Scaling(float x, float y, float z){
+	Matrix r{};
+	r.m[0][0] = x;
+	r.m[1][1] = y;
+	r.m[2][2] = z;
+	r.m[3][3] = 1.0f;
+	return r;
+}
+
+SoftwareRasterizer::Matrix SoftwareRasterizer::Matrix::Translation(float x, float y, float z){
+	Matrix r = Identity();
+	r.m[3][0] = x;
+	r.m[3][1] = y;
+	r.m[3][2] = z;
+	return r;
+}
+
+SoftwareRasterizer::Matrix SoftwareRasterizer::Matrix::RotationX(float angle){
+	const float s = std::sin(angle);
+	const float c = std::cos(angle);
+	Matrix r = Identity();
+	r.m[1][1] = c;
+	r.m[1][2] = s;
+	r.m[2][1] = -s;
+	r.m[2][2] = c;
+	return r;
+}
+
+SoftwareRasterizer::Matrix SoftwareRasterizer::Matrix::RotationY(float angle){
+	const float s = std::sin(angle);
+	const float c = std::cos(angle);
+	Matrix r = Identity();
+	r.m[0][0] = c;
+	r.m[0][2] = -s;
+	r.m[2][0] = s;
+	r.m[2][2] = c;
+	return r;
+}
+
+SoftwareRasterizer::Matrix SoftwareRasterizer::Matrix::LookAtLH(const float eye[3], const float focus[3], const float up[3]){
+	const auto normalize = [](float v[3]){
+		const float len = std::sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+		v[0] /= len;
+		v[1] /= len;
+		v[2] /= len;
+	};
+
+	float z[3] = {focus[0] - eye[0], focus[1] - eye[1], focus[2] - eye[2]};
+	normalize(z);
+	float x[3] = {up[1] * z[2] - up[2] * z[1], up[2] * z[0] - up[0] * z[2], up[0] * z[1] - up[1] * z[0]};
+	normalize(x);
+	const float y[3] = {z[1] * x[2] - z[2] * x[1], z[2] * x[0] - z[0] * x[2], z[0] * x[1] - z[1] * x[0]};
+
+	Matrix r{};
+	for(int i = 0; i < 3; ++i){
+		r.m[i][0] = x[i];
+		r.m[i][1] = y[i];
+		r.m[i][2] = z[i];
+	}
+	r.m[3][0] = -(x[0] * eye[0] + x[1] * eye[1] + x[2] * eye[2]);
+	r.m[3][1] = -(y[0] * eye[0] + y[1] * eye[1] + y[2] * eye[2]);
+	r.m[3][2] = -(z[0] * eye[0] + z[1] * eye[1] + z[2] * eye[2]);
+	r.m[3][3] = 1.0f;
+	return r;
+}
+
+SoftwareRasterizer::Matrix SoftwareRasterizer::Matrix::PerspectiveFovLH(float fov_y, float aspect, float near_z, float far_z){
+	const float h = std::cos(fov_y * 0.5f) / std::sin(fov_y * 0.5f);
+	const float range = far_z / (far_z - near_z);
+
+	Matrix r{};
+	r.m[0][0] = h / aspect;
+	r.m[1][1] = h;
+	r.m[2][2] = range;
+	r.m[2][3] = 1.0f;
+	r.m[3][2] = -range * near_z;
+	return r;
+}
+
+
+SoftwareRasterizer::SoftwareRasterizer():
+	jobs_(nullptr),
+	width_{},
+	height_{},
+	color_{},
+	depth_{},
+	shadow_map_(SHADOW_MAP_SIZE * SHADOW_MAP_SIZE, 1.0f),
+	triangles_{},
+	bins_{},
+	shadow_stats_{},
+	main_stats_{}{}
+
+bool SoftwareRasterizer::Resize(int width, int height){
+	if(width <= 0 || height <= 0 || width > MAX_SIZE || height > MAX_SIZE){
+		return false;
+	}
+
+	width_	= width;
+	height_	= height;
+	color_.assign(static_cast<size_t>(width) * height, 0xff000000);
+	depth_.assign(static_cast<size_t>(width) * height, 1.0f);
+	return true;
+}
+
+void SoftwareRasterizer::Render(const Scene &scene){
+	if(width_ == 0){
+		return;
+	}
+
+	//シャドウマップを先に作り、通常の描画で参照する
+	RenderPass(scene, true, &shadow_stats_);
+	RenderPass(scene, false, &main_stats_);
+}
+
+void SoftwareRasterizer::RenderPass(const Scene &scene, bool shadow_pass, Stats *stats){
+	Target target{};
+	if(shadow_pass){
+		target.width	= SHADOW_MAP_SIZE;
+		target.height	= SHADOW_MAP_SIZE;
+		target.depth	= shadow_map_.data();
+		target.color	= nullptr;
+		target.cull_back = false;	//シャドウマップ用のPSOはカリングなし
+		std::fill(shadow_map_.begin(), shadow_map_.end(), 1.0f);
+	}else{
+		target.width	= width_;
+		target.height	= height_;
+		target.depth	= depth_.data();
+		target.color	= color_.data();
+		target.cull_back = true;
+		std::fill(depth_.begin(), depth_.end(), 1.0f);
+		std::fill(color_.begin(), color_.end(), 0xff000000);
+	}
+	target.tile_x_num = (target.width + TILE_SIZE - 1) / TILE_SIZE;
+	target.tile_y_num = (target.height + TILE_SIZE - 1) / TILE_SIZE;
+
+	*stats = {};
+	triangles_.clear();
+	bins_.resize(static_cast<size_t>(target.tile_x_num) * target.tile_y_num);
+	for(auto &bin : bins_){
+		bin.clear();
+	}
+
+	//頂点処理とセットアップは提出順に行い、ビンの中の順序を保つ
+	for(const Mesh &mesh : scene.meshes){
+		SetupMesh(mesh, scene.light_vp, shadow_pass, target, stats);
+	}
+
+	RasterizeTiles(target, shadow_pass, stats);
+}
+
+void SoftwareRasterizer::SetupMesh(const Mesh &mesh, const Matrix &light_vp, bool shadow_pass, const Target &target, Stats *stats){
+	//頂点シェーダ(VSShadowMap/VSMain)
+	std::vector<ClipVertex> vertices(mesh.vertex_num);
+	for(int i = 0; i < mesh.vertex_num; ++i){
+		const Vertex &src = mesh.vertices[i];
+		const float pos[4] = {src.position[0], src.position[1], src.position[2], 1.0f};
+		float world[4];
+		Transform(pos, mesh.world, world);
+
+		ClipVertex &v = vertices[i];
+		if(shadow_pass){
+			Transform(world, light_vp, v.pos);
+			continue;
+		}
+
+		Transform(pos, mesh.wvp, v.pos);
+
+		float sm[4];
+		Transform(world, light_vp, sm);
+		v.attr[0] = src.uv[0];
+		v.attr[1] = src.uv[1];
+		v.attr[2] = (1.0f + sm[0] / sm[3]) / 2.0f;
+		v.attr[3] = (1.0f - sm[1] / sm[3]) / 2.0f;
+		v.attr[4] = sm[2] / sm[3];
+	}
+
+	//ガードバンドはスクリーン座標が±GUARD_BANDに収まる範囲
+	const float guard_x = 2.0f * GUARD_BAND / target.width - 1.0f;
+	const float guard_y = 2.0f * GUARD_BAND / target.height - 1.0f;
+	const ClipPlane planes[6] = {
+		{{0.0f, 0.0f, 1.0f, 0.0f}},		//z >= 0
+		{{0.0f, 0.0f, -1.0f, 1.0f}},	//z <= w
+		{{1.0f, 0.0f, 0.0f, guard_x}},
+		{{-1.0f, 0.0f, 0.0f, guard_x}},
+		{{0.0f, 1.0f, 0.0f, guard_y}},
+		{{0.0f, -1.0f, 0.0f, guard_y}},
+	};
+
+	const int index_num = mesh.indices != nullptr ? mesh.index_num : mesh.vertex_num;
+	const int triangle_num = (mesh.topology == TOPOLOGY_TRIANGLE_LIST) ? index_num / 3 : std::max(0, index_num - 2);
+	stats->triangle_num += triangle_num;
+
+	for(int t = 0; t < triangle_num; ++t){
+		//ストリップの奇数番目は向きを揃えるために入れ替える
+		int idx[3];
+		if(mesh.topology == TOPOLOGY_TRIANGLE_LIST){
+			idx[0] = t * 3;
+			idx[1] = t * 3 + 1;
+			idx[2] = t * 3 + 2;
+		}else if(t % 2 == 0){
+			idx[0] = t;
+			idx[1] = t + 1;
+			idx[2] = t + 2;
+		}else{
+			idx[0] = t + 1;
+			idx[1] = t;
+			idx[2] = t + 2;
+		}
+		if(mesh.indices != nullptr){
+			for(int &i : idx){
+				i = mesh.indices[i];
+			}
+		}
+
+		ClipVertex polygon[2][MAX_CLIP_VERTEX];
+		int polygon_num = 3;
+		for(int i = 0; i < 3; ++i){
+			polygon[0][i] = vertices[idx[i]];
+		}
+
+		//全頂点がどれかの面の外側なら捨て、面をまたぐ場合だけクリップする
+		int cur = 0;
+		bool rejected = false;
+		for(const ClipPlane &plane : planes){
+			int outside = 0;
+			for(int i = 0; i < polygon_num; ++i){
+				outside += PlaneDistance(plane, polygon[cur][i]) < 0.0f ? 1 : 0;
+			}
+			if(outside == polygon_num){
+				rejected = true;
+				break;
+			}
+			if(outside > 0){
+				polygon_num = ClipPolygon(plane, polygon[cur], polygon_num, polygon[cur ^ 1]);
+				cur ^= 1;
+			}
+		}
+		if(rejected || polygon_num < 3){
+			continue;
+		}
+
+		//ビューポート変換とスナップ
+		float sx[MAX_CLIP_VERTEX];
+		float sy[MAX_CLIP_VERTEX];
+		float sz[MAX_CLIP_VERTEX];
+		float siw[MAX_CLIP_VERTEX];
+		for(int i = 0; i < polygon_num; ++i){
+			const ClipVertex &v = polygon[cur][i];
+			const float inv_w = 1.0f / v.pos[3];
+			sx[i] = Snap((v.pos[0] * inv_w + 1.0f) * 0.5f * target.width);
+			sy[i] = Snap((1.0f - v.pos[1] * inv_w) * 0.5f * target.height);
+			sz[i] = v.pos[2] * inv_w;
+			siw[i] = inv_w;
+		}
+
+		//クリップでできた多角形を扇形に分割する
+		for(int k = 1; k + 1 < polygon_num; ++k){
+			int order[3] = {0, k, k + 1};
+
+			//画面上で時計回り(y下向き)を表とする
+			double area = (static_cast<double>(sx[order[1]]) - sx[order[0]]) * (static_cast<double>(sy[order[2]]) - sy[order[0]])
+						- (static_cast<double>(sx[order[2]]) - sx[order[0]]) * (static_cast<double>(sy[order[1]]) - sy[order[0]]);
+			if(area == 0.0 || (area < 0.0 && target.cull_back)){
+				continue;
+			}
+			if(area < 0.0){
+				std::swap(order[1], order[2]);
+				area = -area;
+			}
+
+			Triangle tri{};
+			float min_x = 1e30f, min_y = 1e30f, max_x = -1e30f, max_y = -1e30f;
+			for(int i = 0; i < 3; ++i){
+				const int j = order[i];
+				tri.x[i]		= sx[j];
+				tri.y[i]		= sy[j];
+				tri.z[i]		= sz[j];
+				tri.inv_w[i]	= siw[j];
+				for(int a = 0; a < ATTRIBUTE_NUM; ++a){
+					tri.attr[i][a] = polygon[cur][j].attr[a] * siw[j];
+				}
+				min_x = std::min(min_x, sx[j]);
+				min_y = std::min(min_y, sy[j]);
+				max_x = std::max(max_x, sx[j]);
+				max_y = std::max(max_y, sy[j]);
+			}
+
+			//辺iは頂点i+1から頂点i+2へ向かう。原点は2頂点のうち(y, x)の小さいほうにして
+			//辺を共有する三角形どうしで符号だけが反転した同じ値になるようにする
+			for(int i = 0; i < 3; ++i){
+				const int a = (i + 1) % 3;
+				const int b = (i + 2) % 3;
+				tri.edge_dx[i] = tri.x[b] - tri.x[a];
+				tri.edge_dy[i] = tri.y[b] - tri.y[a];
+				const bool a_first = (tri.y[a] < tri.y[b]) || (tri.y[a] == tri.y[b] && tri.x[a] < tri.x[b]);
+				tri.edge_ox[i] = a_first ? tri.x[a] : tri.x[b];
+				tri.edge_oy[i] = a_first ? tri.y[a] : tri.y[b];
+				tri.top_left[i] = (tri.edge_dy[i] < 0.0f) || (tri.edge_dy[i] == 0.0f && tri.edge_dx[i] > 0.0f);
+			}
+			tri.inv_area = static_cast<float>(1.0 / area);
+			tri.texture = mesh.texture;
+
+			//画素の中心(+0.5)が含まれうる範囲
+			tri.min_x = std::max(0, static_cast<int>(std::floor(min_x - 0.5f)));
+			tri.min_y = std::max(0, static_cast<int>(std::floor(min_y - 0.5f)));
+			tri.max_x = std::min(target.width - 1, static_cast<int>(std::ceil(max_x - 0.5f)));
+			tri.max_y = std::min(target.height - 1, static_cast<int>(std::ceil(max_y - 0.5f)));
+			if(tri.min_x > tri.max_x || tri.min_y > tri.max_y){
+				continue;
+			}
+
+			//重なるタイルに振り分ける
+			const uint32_t index = static_cast<uint32_t>(triangles_.size());
+			triangles_.push_back(tri);
+			++stats->visible_num;
+			for(int ty = tri.min_y / TILE_SIZE; ty <= tri.max_y / TILE_SIZE; ++ty){
+				for(int tx = tri.min_x / TILE_SIZE; tx <= tri.max_x / TILE_SIZE; ++tx){
+					bins_[ty * target.tile_x_num + tx].push_back(index);
+					++stats->binned_num;
+				}
+			}
+		}
+	}
+}
+
+void SoftwareRasterizer::RasterizeTiles(const Target &target, bool shadow_pass, Stats *stats){
+	const int tile_num = target.tile_x_num * target.tile_y_num;
+
+	if(jobs_ == nullptr){
+		for(int i = 0; i < tile_num; ++i){
+			RasterizeTile(target, shadow_pass, i, &stats->shaded_quad_num);
+		}
+		return;
+	}
+
+	//タイルは互いに重ならないので、タイルの行単位でワーカースレッドに渡す
+	std::vector<std::future<uint64_t>> results;
+	results.reserve(target.tile_y_num);
+	for(int ty = 0; ty < target.tile_y_num; ++ty){
+		results.push_back(jobs_->Push([this, &target, shadow_pass, ty]{
+			uint64_t quad_num{};
+			for(int tx = 0; tx < target.tile_x_num; ++tx){
+				RasterizeTile(target, shadow_pass, ty * target.tile_x_num + tx, &quad_num);
+			}
+			return quad_num;
+		}));
+	}
+	for(auto &r : results){
+		stats->shaded_quad_num += r.get();
+	}
+}
+
+void SoftwareRasterizer::RasterizeTile(const Target &target, bool shadow_pass, int tile_index, uint64_t *shaded_quad_num) const{
+	const int tile_x0 = (tile_index % target.tile_x_num) * TILE_SIZE;
+	const int tile_y0 = (tile_index / target.tile_x_num) * TILE_SIZE;
+	const int tile_x1 = std::min(tile_x0 + TILE_SIZE, target.width) - 1;
+	const int tile_y1 = std::min(tile_y0 + TILE_SIZE, target.height) - 1;
+	const Float4 zero = Splat(0.0f);
+	const Float4 lane_x = Set(0.5f, 1.5f, 0.5f, 1.5f);
+	const Float4 lane_y = Set(0.5f, 0.5f, 1.5f, 1.5f);
+
+	for(uint32_t index : bins_[tile_index]){
+		const Triangle &tri = triangles_[index];
+
+		//2x2画素の単位で走査するので開始位置は偶数に揃える
+		const int x_begin = std::max(tri.min_x, tile_x0) & ~1;
+		const int y_begin = std::max(tri.min_y, tile_y0) & ~1;
+		const int x_end = std::min(tri.max_x, tile_x1);
+		const int y_end = std::min(tri.max_y, tile_y1);
+
+		const Float4 inv_area = Splat(tri.inv_area);
+
+		for(int y = y_begin; y <= y_end; y += 2){
+			const Float4 py = Splat(static_cast<float>(y)) + lane_y;
+			for(int x = x_begin; x <= x_end; x += 2){
+				const Float4 px = Splat(static_cast<float>(x)) + lane_x;
+
+				//辺の式の評価(左上ルールの辺は0を含む)
+				Float4 edge[3];
+				int mask = 0xf;
+				for(int i = 0; i < 3; ++i){
+					edge[i] = (py - Splat(tri.edge_oy[i])) * Splat(tri.edge_dx[i]) - (px - Splat(tri.edge_ox[i])) * Splat(tri.edge_dy[i]);
+					mask &= tri.top_left[i] ? MaskGreaterEqual(edge[i], zero) : MaskGreater(edge[i], zero);
+				}
+
+				//描画先の外の画素(幅・高さが奇数の場合)
+				if(x + 1 > tile_x1){
+					mask &= ~(2 | 8);
+				}
+				if(y + 1 > tile_y1){
+					mask &= ~(4 | 8);
+				}
+				if(mask == 0){
+					continue;
+				}
+
+				//重心座標と深度(z/wはスクリーン上で線形)
+				const Float4 l0 = edge[0] * inv_area;
+				const Float4 l1 = edge[1] * inv_area;
+				const Float4 l2 = edge[2] * inv_area;
+				const Float4 z = l0 * Splat(tri.z[0]) + l1 * Splat(tri.z[1]) + l2 * Splat(tri.z[2]);
+
+				float depth[4];
+				for(int lane = 0; lane < 4; ++lane){
+					const int lx = x + (lane & 1);
+					const int ly = y + (lane >> 1);
+					depth[lane] = (mask & (1 << lane)) ? target.depth[ly * target.width + lx] : 0.0f;
+				}
+				float zv[4];
+				Store(zv, z);
+
+				//深度テスト(LESS_EQUAL)
+				mask &= MaskLessEqual(z, Set(depth[0], depth[1], depth[2], depth[3]));
+				if(mask == 0){
+					continue;
+				}
+
+				++*shaded_quad_num;
+				for(int lane = 0; lane < 4; ++lane){
+					if(mask & (1 << lane)){
+						target.depth[(y + (lane >> 1)) * target.width + x + (lane & 1)] = zv[lane];
+					}
+				}
+				if(shadow_pass){
+					continue;
+				}
+
+				//パースペクティブ補正した属性(範囲外のレーンも微分のために計算する)
+				const Float4 w = Splat(1.0f) / (l0 * Splat(tri.inv_w[0]) + l1 * Splat(tri.inv_w[1]) + l2 * Splat(tri.inv_w[2]));
+				float attr[ATTRIBUTE_NUM][4];
+				for(int a = 0; a < ATTRIBUTE_NUM; ++a){
+					Store(attr[a], (l0 * Splat(tri.attr[0][a]) + l1 * Splat(tri.attr[1][a]) + l2 * Splat(tri.attr[2][a])) * w);
+				}
+
+				//2x2画素の差分からミップレベルを決める
+				const TextureLevel &base = tri.texture->levels[0];
+				const float dudx = (attr[0][1] - attr[0][0]) * base.width;
+				const float dvdx = (attr[1][1] - attr[1][0]) * base.height;
+				const float dudy = (attr[0][2] - attr[0][0]) * base.width;
+				const float dvdy = (attr[1][2] - attr[1][0]) * base.height;
+				const float rho2 = std::max(dudx * dudx + dvdx * dvdx, dudy * dudy + dvdy * dvdy);
+				const float lod = rho2 > 0.0f ? 0.5f * std::log2(rho2) : 0.0f;
+
+				//PSMain
+				for(int lane = 0; lane < 4; ++lane){
+					if(!(mask & (1 << lane))){
+						continue;
+					}
+
+					const float sm = SampleShadowMap(shadow_map_.data(), attr[2][lane], attr[3][lane]);
+					const float sma = (attr[4][lane] - SHADOW_BIAS < sm) ? 1.0f : 0.5f;
+
+					float color[4];
+					SampleTexture(*tri.texture, attr[0][lane], attr[1][lane], lod, color);
+
+					byte *dst = reinterpret_cast<byte*>(&target.color[(y + (lane >> 1)) * target.width + x + (lane & 1)]);
+					dst[0] = ToUnorm8(color[0] * sma);
+					dst[1] = ToUnorm8(color[1] * sma);
+					dst[2] = ToUnorm8(color[2] * sma);
+					dst[3] = ToUnorm8(color[3] * sma);
+				}
+			}
+		}
+	}
+}
+
+bool SoftwareRasterizer::SaveBMP(const char *file_name) const{
+	if(width_ == 0){
+		return false;
+	}
+
+	const uint32_t image_size = static_cast<uint32_t>(width_) * height_ * 4;
+	byte header[54]{};
+	const auto put16 = [&](int offset, uint32_t v){header[offset] = v & 0xff; header[offset + 1] = (v >> 8) & 0xff;};
+	const auto put32 = [&](int offset, uint32_t v){put16(offset, v & 0xffff); put16(offset + 2, v >> 16);};
+	header[0] = 'B';
+	header[1] = 'M';
+	put32(2, sizeof(header) + image_size);
+	put32(10, sizeof(header));
+	put32(14, 40);
+	put32(18, static_cast<uint32_t>(width_));
+	put32(22, static_cast<uint32_t>(-height_));	//負の高さで上から下の順に並べる
+	put16(26, 1);
+	put16(28, 32);
+	put32(34, image_size);
+
+	FILE *fp = fopen(file_name, "wb");
+	if(fp == nullptr){
+		return false;
+	}
+
+	bool ok = fwrite(header, sizeof(header), 1, fp) == 1;
+	ok = ok && fwrite(color_.data(), 1, image_size, fp) == image_size;
+	ok = (fclose(fp) == 0) && ok;
+
+	return ok;
+}
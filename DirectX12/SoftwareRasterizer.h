@@ -0,0 +1,159 @@
+#ifndef SOFTWARE_RASTERIZER_HEADER_
+#define SOFTWARE_RASTERIZER_HEADER_
+
+#include <cstdint>
+#include <vector>
+
+class JobSystem;
+
+//CPUでシーンを描画するラスタライザ(GPUのない環境での描画と、比較用の正解画像の作成に使う)
+//Shaders.hlslのVSShadowMapによるシャドウマップの深度パスと、VSMain/PSMainの描画を同じ計算で再現する
+//画面を64x64のタイルに分け、タイルごとにワーカースレッドで2x2画素単位(SIMDの4レーン)に処理する
+class SoftwareRasterizer{
+public:
+	typedef unsigned char byte;
+	static constexpr int TILE_SIZE			= 64;
+	static constexpr int SHADOW_MAP_SIZE	= 1024;
+	static constexpr int MAX_SIZE			= 8192;		//描画先の最大の幅・高さ
+	static constexpr float SHADOW_BIAS		= 0.005f;	//PSMainと同じ値
+
+	//行ベクトルに右から掛ける行列(DirectXMathのXMMATRIXと同じ並び)
+	struct Matrix{
+		float m[4][4];
+
+		Matrix operator*(const Matrix &other) const;
+
+		static Matrix Identity();
+		static Matrix Scaling(float x, float y, float z);
+		static Matrix Translation(float x, float y, float z);
+		static Matrix RotationX(float angle);
+		static Matrix RotationY(float angle);
+		static Matrix LookAtLH(const float eye[3], const float focus[3], const float up[3]);
+		static Matrix PerspectiveFovLH(float fov_y, float aspect, float near_z, float far_z);
+	};
+
+	//Vertex3Dと同じ並び
+	struct Vertex{
+		float	position[3];
+		float	normal[3];
+		float	uv[2];
+	};
+
+	//BGRA8のミップマップチェイン
+	struct TextureLevel{
+		int			width;
+		int			height;
+		int			row_pitch;
+		const byte	*pixels;
+	};
+
+	struct Texture{
+		std::vector<TextureLevel>	levels;
+	};
+
+	enum Topology{
+		TOPOLOGY_TRIANGLE_LIST,
+		TOPOLOGY_TRIANGLE_STRIP,
+	};
+
+	struct Mesh{
+		const Vertex	*vertices;
+		int				vertex_num;
+		const uint16_t	*indices;		//nullptrならインデックスを使わない
+		int				index_num;
+		Topology		topology;
+		const Texture	*texture;
+		Matrix			world;
+		Matrix			wvp;
+	};
+
+	struct Scene{
+		std::vector<Mesh>	meshes;
+		Matrix				light_vp;
+	};
+
+	//パスごとの処理量
+	struct Stats{
+		uint64_t	triangle_num;		//入力された三角形
+		uint64_t	visible_num;		//クリップ・カリング後に残った三角形
+		uint64_t	binned_num;			//タイルに振り分けた延べ数
+		uint64_t	shaded_quad_num;	//深度テストを通って書き込んだ2x2画素
+	};
+
+public:
+	SoftwareRasterizer();
+	~SoftwareRasterizer(){}
+
+	//jobsがnullptrなら呼び出したスレッドだけで描画する
+	void SetJobSystem(JobSystem *jobs){jobs_ = jobs;}
+	bool Resize(int width, int height);
+
+	//シャドウマップの深度パスと通常の描画を行う
+	void Render(const Scene &scene);
+
+	int Width() const{return width_;}
+	int Height() const{return height_;}
+	int RowPitch() const{return width_ * 4;}
+	const byte* Pixels() const{return reinterpret_cast<const byte*>(color_.data());}
+	const float* ShadowMap() const{return shadow_map_.data();}
+	const Stats& ShadowStats() const{return shadow_stats_;}
+	const Stats& MainStats() const{return main_stats_;}
+
+	//描画結果を32bitのBMPとして保存する
+	bool SaveBMP(const char *file_name) const;
+
+private:
+	static constexpr int ATTRIBUTE_NUM = 5;	//UVとシャドウマップ上の座標(PS_INPUTのUVとPosSM.xyz)
+
+	//セットアップ済みの三角形
+	struct Triangle{
+		float			x[3];				//1/256画素にスナップしたスクリーン座標
+		float			y[3];
+		float			z[3];
+		float			inv_w[3];
+		float			attr[3][ATTRIBUTE_NUM];	//属性 / w
+		float			edge_dx[3];			//辺iは頂点iの対辺
+		float			edge_dy[3];
+		float			edge_ox[3];			//辺の式の原点(隣の三角形と同じ値になるように選ぶ)
+		float			edge_oy[3];
+		bool			top_left[3];		//左上ルールで辺上の画素を含むか
+		float			inv_area;
+		int				min_x;
+		int				min_y;
+		int				max_x;
+		int				max_y;
+		const Texture	*texture;
+	};
+
+	//パスの描画先
+	struct Target{
+		int			width;
+		int			height;
+		int			tile_x_num;
+		int			tile_y_num;
+		float		*depth;
+		uint32_t	*color;		//深度パスではnullptr
+		bool		cull_back;
+	};
+
+private:
+	void RenderPass(const Scene &scene, bool shadow_pass, Stats *stats);
+	void SetupMesh(const Mesh &mesh, const Matrix &light_vp, bool shadow_pass, const Target &target, Stats *stats);
+	void RasterizeTiles(const Target &target, bool shadow_pass, Stats *stats);
+	void RasterizeTile(const Target &target, bool shadow_pass, int tile_index, uint64_t *shaded_quad_num) const;
+
+private:
+	JobSystem							*jobs_;
+	int									width_;
+	int									height_;
+	std::vector<uint32_t>				color_;			//BGRA8
+	std::vector<float>					depth_;
+	std::vector<float>					shadow_map_;	//SHADOW_MAP_SIZE x SHADOW_MAP_SIZE
+
+	std::vector<Triangle>				triangles_;		//セットアップ済みの三角形(パスごとに作り直す)
+	std::vector<std::vector<uint32_t>>	bins_;			//タイルごとの三角形の番号(提出順)
+	Stats								shadow_stats_;
+	Stats								main_stats_;
+};
+
+#endif
@@ -1,263 +1,367 @@
-#include <fstream>
-#include <vector>
-#include "Sphere.h"
-#include "D3D12Manager.h"
-
-namespace{
-constexpr float PI = 3.14159265358979323846f;
-}
-
-Sphere::Sphere():
-	vertex_buffer_{},
-	index_buffer_{},
-	constant_buffer_{},
-	texture_{},
-	dh_texture_{}{}
-
-HRESULT Sphere::Initialize(ID3D12Device *device, ID3D12Resource *sm){
-	HRESULT hr{};
-	D3D12_HEAP_PROPERTIES heap_properties{};
-	D3D12_RESOURCE_DESC   resource_desc{};
-
-	heap_properties.Type					= D3D12_HEAP_TYPE_UPLOAD;
-	heap_properties.CPUPageProperty			= D3D12_CPU_PAGE_PROPERTY_UNKNOWN;
-	heap_properties.MemoryPoolPreference	= D3D12_MEMORY_POOL_UNKNOWN;
-	heap_properties.CreationNodeMask		= 0;
-	heap_properties.VisibleNodeMask			= 0;
-
-	resource_desc.Dimension				= D3D12_RESOURCE_DIMENSION_BUFFER;
-	resource_desc.Width					= 256;
-	resource_desc.Height				= 1;
-	resource_desc.DepthOrArraySize		= 1;
-	resource_desc.MipLevels				= 1;
-	resource_desc.Format				= DXGI_FORMAT_UNKNOWN;
-	resource_desc.Layout				= D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
-	resource_desc.SampleDesc.Count		= 1;
-	resource_desc.SampleDesc.Quality	= 0;
-
-
-	//萔obt@̍쐬
-	hr = device->CreateCommittedResource(&heap_properties, D3D12_HEAP_FLAG_NONE, &resource_desc, D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(&constant_buffer_));
-	if(FAILED(hr)){
-		return hr;
-	}
-	
-	
-	//_obt@̍쐬
-	resource_desc.Width = sizeof(Vertex3D) * VERT_NUM * ARC_NUM;
-	hr = device->CreateCommittedResource(&heap_properties, D3D12_HEAP_FLAG_NONE, &resource_desc, D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(&vertex_buffer_));
-	if(FAILED(hr)){
-		return hr;
-	}
-
-	//CfbNXobt@̍쐬
-	resource_desc.Width = sizeof(uint16) * (VERT_NUM - 1) * ARC_NUM * 6;
-	hr = device->CreateCommittedResource(&heap_properties, D3D12_HEAP_FLAG_NONE, &resource_desc, D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(&index_buffer_));
-	if(FAILED(hr)){
-		return hr;
-	}
-
-	
-	
-	Vertex3D *vb{};
-	hr = vertex_buffer_->Map(0, nullptr, (void**)&vb);
-	if(FAILED(hr)){
-		return hr;
-	}
-
-	uint16 *ib{};
-	hr = index_buffer_->Map(0, nullptr, (void**)&ib);
-	if(FAILED(hr)){
-		return hr;
-	}
-
-
-	const float pd = 2.0f * PI / (ARC_NUM - 1);
-	const float td = PI / (VERT_NUM - 1);
-	float phi{};
-
-	//_f[^̏
-	for(int i = 0; i < ARC_NUM; ++i){
-		float t{};
-		for(int j = 0; j < VERT_NUM; ++j){
-			vb[i * VERT_NUM + j].Position = {sinf(t) * cosf(phi), cosf(t), sinf(t) * sinf(phi)};
-			vb[i * VERT_NUM + j].Normal = vb[i * VERT_NUM + j].Position;
-			vb[i * VERT_NUM + j].UV = {i / (float)(ARC_NUM - 1), j / (float)(VERT_NUM - 1)};
-			t += td;
-		}
-
-		phi += pd;
-	}
-
-
-	//CfbNX̏
-	int idx{};
-	for(int i = 0; i < ARC_NUM - 1; ++i){
-		for(int j = 0; j < VERT_NUM - 1; ++j){
-			ib[1 + idx] = (VERT_NUM * i + j);
-			ib[0 + idx] = (VERT_NUM * i + j + 1);
-			ib[2 + idx] = (VERT_NUM * (i + 1) + j);
-			ib[4 + idx] = (VERT_NUM * (i + 1) + j);
-			ib[3 + idx] = (VERT_NUM * i + j + 1);
-			ib[5 + idx] = (VERT_NUM * (i + 1) + j + 1);
-			idx += 6;
-		}
-	}
-	
-
-	index_buffer_->Unmap(0, nullptr);
-	ib = nullptr;
-
-	vertex_buffer_->Unmap(0, nullptr);
-	vb = nullptr;
-
-
-
-
-	//摜̓ǂݍ
-	std::vector<byte> img;
-	std::fstream fs("earth", std::ios_base::in | std::ios_base::binary);
-	if(!fs){
-		return E_FAIL;
-	}
-	int width;
-	int height;
-	fs.read((char*)&width, sizeof(width));
-	fs.read((char*)&height, sizeof(height));
-	img.resize(width * height * 4);
-	fs.read((char*)&img[0], img.size());
-	fs.close();
-
-
-	//eNX`p̃\[X̍쐬
-	heap_properties.Type                 = D3D12_HEAP_TYPE_CUSTOM;
-	heap_properties.CPUPageProperty      = D3D12_CPU_PAGE_PROPERTY_WRITE_BACK;
-	heap_properties.MemoryPoolPreference = D3D12_MEMORY_POOL_L0;
-
-	resource_desc.Dimension	= D3D12_RESOURCE_DIMENSION_TEXTURE2D;
-	resource_desc.Width		= width;
-	resource_desc.Height	= height;
-	resource_desc.Format	= DXGI_FORMAT_B8G8R8A8_UNORM;
-	resource_desc.Layout	= D3D12_TEXTURE_LAYOUT_UNKNOWN;
-	hr = device->CreateCommittedResource(&heap_properties, D3D12_HEAP_FLAG_NONE, &resource_desc, D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(&texture_));
-	if(FAILED(hr)){
-		return hr;
-	}
-
-
-	//eNX`p̃fXNv^q[v̍쐬
-	D3D12_DESCRIPTOR_HEAP_DESC descriptor_heap_desc{};
-	descriptor_heap_desc.NumDescriptors = 2;
-	descriptor_heap_desc.Type			= D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
-	descriptor_heap_desc.Flags			= D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
-	descriptor_heap_desc.NodeMask		= 0;
-	hr = device->CreateDescriptorHeap(&descriptor_heap_desc, IID_PPV_ARGS(&dh_texture_));
-	if (FAILED(hr)) {
-		return hr;
-	}
-
-
-	//VF[_\[Xr[̍쐬
-	D3D12_CPU_DESCRIPTOR_HANDLE handle_srv{};
-	D3D12_SHADER_RESOURCE_VIEW_DESC resourct_view_desc{};
-
-	resourct_view_desc.Format							= DXGI_FORMAT_B8G8R8A8_UNORM;
-	resourct_view_desc.ViewDimension					= D3D12_SRV_DIMENSION_TEXTURE2D;
-	resourct_view_desc.Texture2D.MipLevels				= 1;
-	resourct_view_desc.Texture2D.MostDetailedMip		= 0;
-	resourct_view_desc.Texture2D.PlaneSlice				= 0;
-	resourct_view_desc.Texture2D.ResourceMinLODClamp	= 0.0F;
-	resourct_view_desc.Shader4ComponentMapping			= D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
-
-	handle_srv = dh_texture_->GetCPUDescriptorHandleForHeapStart();
-	device->CreateShaderResourceView(texture_.Get(), &resourct_view_desc, handle_srv);
-
-	resourct_view_desc.Format							= DXGI_FORMAT_R32_FLOAT;
-	handle_srv.ptr += device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
-	device->CreateShaderResourceView(sm, &resourct_view_desc, handle_srv);
-
-
-	//摜f[^̏
-	D3D12_BOX box = {0, 0, 0, (UINT)width, (UINT)height, 1};
-	hr = texture_->WriteToSubresource(0, &box, &img[0], 4 * width, 4 * width * height);
-	if(FAILED(hr)){
-		return hr;
-	}
-
-	return S_OK;
-}
-
-HRESULT Sphere::Update(){
-	HRESULT hr;
-	static int Cnt{};
-	++Cnt;
-
-	//J̐ݒ
-	XMMATRIX view = XMMatrixLookAtLH({1.0f, 1.0f, -6.0f}, {0.0f, 0.0f, 0.0f}, {0.0f, 1.0f, 0.0f});
-	XMMATRIX projection = XMMatrixPerspectiveFovLH(XMConvertToRadians(60.0f), 640.0f / 480.0f, 1.0f, 20.0f);
-
-	//IuWFNg̉]̐ݒ
-	XMMATRIX rotate = XMMatrixRotationY(XMConvertToRadians(static_cast<float>(Cnt % 1800)) / 5.0f);
-	XMMATRIX move = XMMatrixTranslation(0.0f, sin(PI * ((Cnt % 240) / 120.0f)) * 0.5f, sin(PI * ((Cnt % 120) / 60.0f)) * 0.5f);
-
-	//[hϊs
-	XMFLOAT4X4 World;
-	XMStoreFloat4x4(&World, XMMatrixTranspose(rotate * move));
-
-	//SĂ̕ϊs
-	XMFLOAT4X4 Mat;
-	XMStoreFloat4x4(&Mat, XMMatrixTranspose(rotate * move * view * projection));
-
-
-	XMFLOAT4X4 *buffer{};
-	hr = constant_buffer_->Map(0, nullptr, (void**)&buffer);
-	if(FAILED(hr)){
-		return hr;
-	}
-
-	//s萔obt@ɏ
-	buffer[0] = Mat;
-	buffer[1] = World;
-
-	constant_buffer_->Unmap(0, nullptr);
-	buffer = nullptr;
-
-	return hr;
-}
-
-HRESULT Sphere::Draw(ID3D12GraphicsCommandList *command_list){
-
-	D3D12_VERTEX_BUFFER_VIEW vertex_view{};
-	vertex_view.BufferLocation	= vertex_buffer_->GetGPUVirtualAddress();
-	vertex_view.StrideInBytes	= sizeof(Vertex3D);
-	vertex_view.SizeInBytes		= sizeof(Vertex3D) * VERT_NUM * ARC_NUM;
-
-	
-	D3D12_INDEX_BUFFER_VIEW index_view{};
-	index_view.BufferLocation	= index_buffer_->GetGPUVirtualAddress();
-	index_view.SizeInBytes		= sizeof(uint16) * (VERT_NUM - 1) * ARC_NUM * 6;
-	index_view.Format			= DXGI_FORMAT_R16_UINT;
-
-
-
-	//萔obt@VF[_̃WX^ɃZbg
-	command_list->SetGraphicsRootConstantBufferView(0, constant_buffer_->GetGPUVirtualAddress());
-
-
-	//eNX`VF[_̃WX^ɃZbg
-	command_list->SetDescriptorHeaps(1, dh_texture_.GetAddressOf());
-	command_list->SetGraphicsRootDescriptorTable(2, dh_texture_->GetGPUDescriptorHandleForHeapStart());
-
-
-	//CfbNXgpAgCAOXg`
-	command_list->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-	command_list->IASetVertexBuffers(0, 1, &vertex_view);
-	command_list->IASetIndexBuffer(&index_view);
-
-	//`
-	command_list->DrawIndexedInstanced((VERT_NUM - 1) * ARC_NUM * 6, 1, 0, 0, 0);
-
-	return S_OK;
-}
-
-
+#include "Sphere.h"
+#include "D3D12Manager.h"
+
+namespace{
+constexpr float PI = 3.14159265358979323846f;
+const char *TEXTURE_NAMES[Sphere::TEXTURE_NUM] = {"earth", "wall"};
+}
+
+Sphere::Sphere():
+	vertex_buffer_{},
+	index_buffer_{},
+	texture_{},
+	texture_allocations_{},
+	texture_index_{},
+	constant_address_{},
+	instance_addresses_{},
+	instance_nums_{},
+	view_num_{},
+	instances_{},
+	instance_culler_{},
+	instance_data_{},
+	scene_(nullptr),
+	entity_(Scene::INVALID_ENTITY),
+	frame_{},
+	world_{},
+	time_{},
+	paused_(false),
+	streamer_(nullptr),
+	stream_ids_{},
+	vertices_{},
+	indices_{},
+	images_{}{}
+
+
+//CPU側のデータの準備(ワーカースレッドから呼ばれる)
+HRESULT Sphere::Load(){
+
+	//画像の読み込み
+	for(int i = 0; i < TEXTURE_NUM; ++i){
+		if(!images_[i].Load(TEXTURE_NAMES[i])){
+			return E_FAIL;
+		}
+	}
+
+
+	vertices_.resize(VERT_NUM * ARC_NUM);
+	indices_.resize((VERT_NUM - 1) * ARC_NUM * 6);
+	Vertex3D *vb = vertices_.data();
+	uint16 *ib = indices_.data();
+
+	const float pd = 2.0f * PI / (ARC_NUM - 1);
+	const float td = PI / (VERT_NUM - 1);
+	float phi{};
+
+	//頂点データの書き込み
+	for(int i = 0; i < ARC_NUM; ++i){
+		float t{};
+		for(int j = 0; j < VERT_NUM; ++j){
+			vb[i * VERT_NUM + j].Position = {sinf(t) * cosf(phi), cosf(t), sinf(t) * sinf(phi)};
+			vb[i * VERT_NUM + j].Normal = vb[i * VERT_NUM + j].Position;
+			vb[i * VERT_NUM + j].UV = {i / (float)(ARC_NUM - 1), j / (float)(VERT_NUM - 1)};
+			t += td;
+		}
+
+		phi += pd;
+	}
+
+
+	//インデックスの書き込み
+	int idx{};
+	for(int i = 0; i < ARC_NUM - 1; ++i){
+		for(int j = 0; j < VERT_NUM - 1; ++j){
+			ib[1 + idx] = (VERT_NUM * i + j);
+			ib[0 + idx] = (VERT_NUM * i + j + 1);
+			ib[2 + idx] = (VERT_NUM * (i + 1) + j);
+			ib[4 + idx] = (VERT_NUM * (i + 1) + j);
+			ib[3 + idx] = (VERT_NUM * i + j + 1);
+			ib[5 + idx] = (VERT_NUM * (i + 1) + j + 1);
+			idx += 6;
+		}
+	}
+
+	return S_OK;
+}
+
+HRESULT Sphere::Initialize(ID3D12Device *device, CopyUploader *uploader, BindlessHeap *heap){
+	HRESULT hr{};
+	D3D12_RESOURCE_DESC   resource_desc{};
+
+	//Loadで作成した頂点とインデックスをDEFAULTヒープのバッファに転送する
+	hr = uploader->CreateBuffer(vertices_.data(), sizeof(Vertex3D) * vertices_.size(), &vertex_buffer_);
+	if(FAILED(hr)){
+		return hr;
+	}
+
+	hr = uploader->CreateBuffer(indices_.data(), sizeof(uint16) * indices_.size(), &index_buffer_);
+	if(FAILED(hr)){
+		return hr;
+	}
+
+
+
+
+	//テクスチャ用のリソースの作成(Loadで読み込んだ画像を使う)
+	resource_desc.DepthOrArraySize		= 1;
+	resource_desc.Layout				= D3D12_TEXTURE_LAYOUT_UNKNOWN;
+	resource_desc.SampleDesc.Count		= 1;
+	resource_desc.SampleDesc.Quality	= 0;
+
+	for(int i = 0; i < TEXTURE_NUM; ++i){
+		if(!images_[i].IsOpen()){
+			return E_FAIL;
+		}
+
+		resource_desc.Dimension	= D3D12_RESOURCE_DIMENSION_TEXTURE2D;
+		resource_desc.Width		= images_[i].Width();
+		resource_desc.Height	= images_[i].Height();
+		resource_desc.MipLevels	= images_[i].LevelNum();
+		resource_desc.Format	= GetDXGIFormat(images_[i].Format());
+		hr = uploader->CreateTexture(resource_desc, &texture_[i], &texture_allocations_[i]);
+		if(FAILED(hr)){
+			return hr;
+		}
+	}
+
+
+	//シェーダリソースビューの作成
+	//インスタンス描画ではインスタンスごとの添字を足して引くので、全てのテクスチャを連続して並べる
+	hr = heap->Allocate(TEXTURE_NUM, &texture_index_);
+	if(FAILED(hr)){
+		return hr;
+	}
+
+	D3D12_SHADER_RESOURCE_VIEW_DESC resourct_view_desc{};
+	resourct_view_desc.ViewDimension					= D3D12_SRV_DIMENSION_TEXTURE2D;
+	resourct_view_desc.Texture2D.MostDetailedMip		= 0;
+	resourct_view_desc.Texture2D.PlaneSlice				= 0;
+	resourct_view_desc.Texture2D.ResourceMinLODClamp	= 0.0F;
+	resourct_view_desc.Shader4ComponentMapping			= D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+
+	for(int i = 0; i < TEXTURE_NUM; ++i){
+		resourct_view_desc.Format				= GetDXGIFormat(images_[i].Format());
+		resourct_view_desc.Texture2D.MipLevels	= images_[i].LevelNum();
+		device->CreateShaderResourceView(texture_[i].Get(), &resourct_view_desc, heap->CpuHandle(texture_index_ + i));
+	}
+
+
+	//画像データの転送
+	for(int i = 0; i < TEXTURE_NUM; ++i){
+
+		//ストリーミングする場合は小さいレベルだけ(詳細なレベルは描画しながら読み込む)
+		if(streamer_ != nullptr){
+			stream_ids_[i] = streamer_->Register(&images_[i], ToRenderResource(texture_[i].Get()), TextureStreamer::DEFAULT_TAIL_SIZE);
+			if(stream_ids_[i] < 0){
+				return E_FAIL;
+			}
+			continue;
+		}
+
+		//全てのミップレベル
+		hr = uploader->UploadTexture(texture_[i].Get(), images_[i]);
+		if(FAILED(hr)){
+			return hr;
+		}
+
+		//ステージングに書き込んだのでCPU側のデータは解放する
+		images_[i].Close();
+	}
+	std::vector<Vertex3D>().swap(vertices_);
+	std::vector<uint16>().swap(indices_);
+
+	return S_OK;
+}
+
+void Sphere::UseMemory(GpuMemoryAllocator *memory) const{
+	memory->Use(vertex_buffer_.allocation);
+	memory->Use(index_buffer_.allocation);
+	for(int i = 0; i < TEXTURE_NUM; ++i){
+		memory->Use(texture_allocations_[i]);
+	}
+}
+
+void Sphere::AddToScene(Scene *scene){
+	scene_ = scene;
+	entity_ = scene->Create();
+	WriteTransform();
+}
+
+void Sphere::Animate(){
+	if(paused_){
+		return;
+	}
+	++frame_;
+	WriteTransform();
+}
+
+//Y軸で回しながら上下・前後に揺らす
+void Sphere::WriteTransform(){
+	float rotation[4];
+	Scene::RotationY(XMConvertToRadians(static_cast<float>(frame_ % 1800)) / 5.0f, rotation);
+	scene_->SetRotation(entity_, rotation);
+	scene_->SetPosition(entity_, 0.0f, sin(PI * ((frame_ % 240) / 120.0f)) * 0.5f, sin(PI * ((frame_ % 120) / 60.0f)) * 0.5f);
+}
+
+HRESULT Sphere::Update(RenderUploadHeap *upload_heap, const FrustumCuller::Frustum *frustums, int view_num, const OcclusionCuller *occlusion){
+	time_ = static_cast<float>(frame_);
+
+	//ワールド変換行列(シーンの行列は行ベクトルに掛ける並びなので転置する)
+	const Scene::Matrix world = scene_->World(entity_);
+	const XMFLOAT4X4 World(&world.Transposed().m[0][0]);
+	world_ = World;
+
+	//全ての変換行列
+	const XMFLOAT4X4 Mat(&(world * scene_->ViewProj()).Transposed().m[0][0]);
+
+
+	//インスタンス描画ではビュー・プロジェクション行列をシェーダ側で掛ける
+	const XMFLOAT4X4 ViewProj(&scene_->ViewProj().Transposed().m[0][0]);
+
+
+	//テクスチャのストリーミング
+	//テクスチャは球を一周するので、画面上の直径のπ倍の解像度があれば足りる
+	XMFLOAT4 MinLod{};
+	if(streamer_ != nullptr){
+		float view_position[4];
+		scene_->View().TransformPoint(world.m[3], view_position);
+		const float depth = view_position[2];
+		const float screen_size = PI * TextureStreamer::ProjectedSize(1.0f, depth, scene_->GetCamera().fov_y, 480.0f);
+		for(int i = 0; i < (IsInstanced() ? TEXTURE_NUM : 1); ++i){
+			streamer_->Request(stream_ids_[i], screen_size);
+		}
+		MinLod = {streamer_->MinLod(stream_ids_[0]), streamer_->MinLod(stream_ids_[1]), 0.0f, 0.0f};
+	}
+
+
+	//今フレームの定数の領域を確保する(Map済みなのでそのまま書き込める)
+	RenderUploadHeap::Allocation allocation{};
+	if(!upload_heap->AllocateConstant(sizeof(XMFLOAT4X4) * 3 + sizeof(XMFLOAT4), &allocation)){
+		return E_OUTOFMEMORY;
+	}
+
+	//行列を定数バッファに書き込み
+	XMFLOAT4X4 *buffer = static_cast<XMFLOAT4X4*>(allocation.cpu_address);
+	buffer[0] = Mat;
+	buffer[1] = World;
+	buffer[2] = ViewProj;
+	*reinterpret_cast<XMFLOAT4*>(buffer + 3) = MinLod;
+	constant_address_ = allocation.gpu_address;
+
+
+	//インスタンスごとのワールド変換行列をまとめて求め、視錐台ごとに中に掛かるものだけを書き込む
+	//途中で確保に失敗しても前のフレームの(解放済みの)領域を描かないように、先に全ての視錐台を空にしておく
+	view_num_ = 0;
+	for(int v = 0; v < FrustumCuller::MAX_VIEW_NUM; ++v){
+		instance_nums_[v] = 0;
+	}
+	if(IsInstanced()){
+		instances_.Write(time_, instance_data_.data());
+		instance_culler_.Cull(frustums, view_num);
+		view_num_ = (view_num < FrustumCuller::MAX_VIEW_NUM) ? view_num : FrustumCuller::MAX_VIEW_NUM;
+
+		for(int v = 0; v < view_num_; ++v){
+			const int visible_num = instance_culler_.VisibleNum(v);
+			if(visible_num == 0){
+				continue;
+			}
+			if(!upload_heap->Allocate(sizeof(InstanceTransform::InstanceData) * visible_num, 16, &allocation)){
+				return E_OUTOFMEMORY;
+			}
+
+			//カメラの視錐台では遮蔽物の後ろのものを除く(インスタンスはY軸で回るだけなので、拡大率はworld[1][1])
+			InstanceTransform::InstanceData *dst = static_cast<InstanceTransform::InstanceData*>(allocation.cpu_address);
+			const uint32_t *visible = instance_culler_.Visible(v);
+			int num = 0;
+			for(int i = 0; i < visible_num; ++i){
+				const InstanceTransform::InstanceData &data = instance_data_[visible[i]];
+				if(v == 0 && occlusion != nullptr){
+					const float scale = data.world[1][1];
+					const float min[3] = {data.world[0][3] - scale, data.world[1][3] - scale, data.world[2][3] - scale};
+					const float max[3] = {data.world[0][3] + scale, data.world[1][3] + scale, data.world[2][3] + scale};
+					if(occlusion->TestBox(min, max) != OcclusionCuller::RESULT_VISIBLE){
+						continue;
+					}
+				}
+				dst[num++] = data;
+			}
+			instance_nums_[v] = num;
+			instance_addresses_[v] = allocation.gpu_address;
+		}
+	}
+
+	return S_OK;
+}
+
+HRESULT Sphere::Draw(RenderCommandList *command_list, int view){
+
+	//インスタンス描画で視錐台に掛かるものがなければ何も積まない
+	if(IsInstanced() && (view >= view_num_ || instance_nums_[view] == 0)){
+		return S_OK;
+	}
+
+	//定数バッファをシェーダのレジスタにセット
+	command_list->SetConstantBuffer(0, constant_address_);
+
+
+	//テクスチャの添字をセット(ヒープとテーブルはパスの先頭で設定済み)
+	const uint32_t texture_index = texture_index_;
+	command_list->SetRootConstants(2, 1, &texture_index, D3D12Manager::DESCRIPTOR_INDEX_TEXTURE);
+
+
+	//インデックスを使用し、トライアングルリストを描画
+	command_list->SetTopology(RENDER_TOPOLOGY_TRIANGLE_LIST);
+	command_list->SetVertexBuffer(0, vertex_buffer_.gpu_address, sizeof(Vertex3D) * VERT_NUM * ARC_NUM, sizeof(Vertex3D));
+	command_list->SetIndexBuffer(index_buffer_.gpu_address, sizeof(uint16) * (VERT_NUM - 1) * ARC_NUM * 6, RENDER_INDEX_16);
+
+	//インスタンス描画の場合はインスタンスデータもセットして、視錐台に掛かる球を1回で描画
+	if(IsInstanced()){
+		const int visible_num = instance_nums_[view];
+		command_list->SetVertexBuffer(1, instance_addresses_[view], sizeof(InstanceTransform::InstanceData) * visible_num, sizeof(InstanceTransform::InstanceData));
+		command_list->DrawIndexed((VERT_NUM - 1) * ARC_NUM * 6, visible_num, 0, 0, 0);
+		return S_OK;
+	}
+
+	//描画
+	command_list->DrawIndexed((VERT_NUM - 1) * ARC_NUM * 6, 1, 0, 0, 0);
+
+	return S_OK;
+}
+
+
+//球を立方体状に並べる(中心は原点、全体の大きさは元の球と同程度)
+void Sphere::SetInstanceNum(int num){
+	num = (num < 1) ? 1 : (num > MAX_INSTANCE_NUM ? MAX_INSTANCE_NUM : num);
+	if(num == 1){
+		instances_.Clear();
+		instance_culler_.Clear();
+		instance_data_.clear();
+		return;
+	}
+
+	int side = 1;
+	while(side * side * side < num){
+		++side;
+	}
+	const float spacing = 4.0f / side;
+	const float origin = -0.5f * spacing * (side - 1);
+
+	instances_.Resize(num);
+	instance_culler_.Resize(num);
+	instance_data_.resize(num);
+	for(int i = 0; i < num; ++i){
+		const int x = i % side;
+		const int y = (i / side) % side;
+		const int z = i / (side * side);
+
+		//回転の速さは元の球(1フレームに1/5度)を基準に少しずつずらす
+		const float yaw_speed = XMConvertToRadians(0.2f) * (1.0f + 0.25f * (i % 5));
+		const float center[3] = {origin + spacing * x, origin + spacing * y, origin + spacing * z};
+		const float scale = spacing * 0.4f;
+		instances_.Set(i, center[0], center[1], center[2], scale, 0.5f * i, yaw_speed, i % TEXTURE_NUM);
+
+		//球の頂点は半径1なので、境界の半径はスケールと同じ
+		instance_culler_.SetSphere(i, center, scale);
+	}
+}
+
+
@@ -1,33 +1,105 @@
-#ifndef SPHERE_HEADER_
-#define SPHERE_HEADER_
-
-#include <d3d12.h>
-#include <DirectXMath.h>
-#include <wrl/client.h>
-
-using namespace DirectX;
-using namespace Microsoft::WRL;
-
-class Sphere{
-public:
-	typedef unsigned char byte;
-	typedef unsigned short uint16;
-	static constexpr int VERT_NUM = 32;//̌ʂ钸_̐
-	static constexpr int ARC_NUM = 32;//ʂ̐
-
-public:
-	Sphere();
-	~Sphere(){}
-	HRESULT Initialize(ID3D12Device *device, ID3D12Resource *sm);
-	HRESULT Update();
-	HRESULT Draw(ID3D12GraphicsCommandList *command_list);
-	
-private:
-	ComPtr<ID3D12Resource>			vertex_buffer_;
-	ComPtr<ID3D12Resource>			index_buffer_;
-	ComPtr<ID3D12Resource>			constant_buffer_;
-	ComPtr<ID3D12Resource>			texture_;
-	ComPtr<ID3D12DescriptorHeap>	dh_texture_;
-};
-
-#endif
+#ifndef SPHERE_HEADER_
+#define SPHERE_HEADER_
+
+#include <vector>
+#include <d3d12.h>
+#include <DirectXMath.h>
+#include <wrl/client.h>
+#include "Vertex3D.h"
+#include "TextureAsset.h"
+#include "InstanceTransform.h"
+#include "FrustumCuller.h"
+#include "OcclusionCuller.h"
+#include "Scene.h"
+#include "RenderCommandList.h"
+#include "RenderUploadHeap.h"
+#include "CopyUploader.h"
+#include "BindlessHeap.h"
+#include "TextureStreamer.h"
+
+using namespace DirectX;
+using namespace Microsoft::WRL;
+
+class Sphere{
+public:
+	typedef unsigned char byte;
+	typedef unsigned short uint16;
+	static constexpr int VERT_NUM = 32;//一つの弧を作る頂点の数
+	static constexpr int ARC_NUM = 32;//球を作る弧の数
+	static constexpr int TEXTURE_NUM = 2;//インスタンスごとに選べるテクスチャの数
+	static constexpr int MAX_INSTANCE_NUM = 100000;
+
+public:
+	Sphere();
+	~Sphere(){}
+	HRESULT Load();
+	HRESULT Initialize(ID3D12Device *device, CopyUploader *uploader, BindlessHeap *heap);
+
+	//シーンにエンティティを作り、最初のフレームの変換を書く(Animate・Updateの前に呼ぶ)
+	void AddToScene(Scene *scene);
+
+	//アニメーションを1フレーム進めて、シーンのローカルの変換に書く(止めている間は変えない)
+	void Animate();
+
+	//ワールド変換とカメラの行列はScene::Updateで求めたものを使う
+	//frustumsは描画する視錐台(0番はカメラ、続いてシャドウマップのカスケード)
+	//インスタンス描画では視錐台ごとに中に掛かるインスタンスだけのデータを書く
+	//occlusionを渡すとカメラの視錐台では遮蔽物の後ろにあるインスタンスも除く(影は落とすのでカスケードでは除かない)
+	HRESULT Update(RenderUploadHeap *upload_heap, const FrustumCuller::Frustum *frustums, int view_num, const OcclusionCuller *occlusion = nullptr);
+
+	//viewはUpdateに渡した視錐台の番号(インスタンス描画でなければ使わない)
+	HRESULT Draw(RenderCommandList *command_list, int view = 0);
+
+	//2以上ならインスタンス描画に切り替えて、num個の球を1回の描画で並べる
+	void SetInstanceNum(int num);
+	int InstanceNum() const{return instances_.Num() > 0 ? instances_.Num() : 1;}
+	bool IsInstanced() const{return instances_.Num() > 1;}
+
+	//直前のUpdateで視錐台ごとに描くことにしたインスタンスの数
+	int VisibleInstanceNum(int view) const{return instance_nums_[view];}
+
+	//今フレームで使うメモリを伝える(描画の前に呼ぶ)
+	void UseMemory(GpuMemoryAllocator *memory) const;
+
+	//trueならアニメーションを止める(シーンの変換を変えないので、ワールド変換も求め直さない)
+	void SetPaused(bool paused){paused_ = paused;}
+
+	//直前のUpdateのワールド変換行列(転置済み)と、インスタンスの変換を求めた時刻(Animateで進めたフレーム数)
+	const XMFLOAT4X4& World() const{return world_;}
+	float Time() const{return time_;}
+
+	//Initializeの前に設定すると、テクスチャは小さいレベルだけを転送してstreamerで残りを転送する
+	void SetTextureStreamer(TextureStreamer *streamer){streamer_ = streamer;}
+	
+private:
+	void WriteTransform();
+
+private:
+	GpuMemoryAllocator::BufferRange	vertex_buffer_;
+	GpuMemoryAllocator::BufferRange	index_buffer_;
+	ComPtr<ID3D12Resource>			texture_[TEXTURE_NUM];	//0番は通常の描画でも使う
+	GpuMemoryAllocator::Allocation	texture_allocations_[TEXTURE_NUM];
+	UINT							texture_index_;			//テクスチャのSRVのヒープ上の添字(TEXTURE_NUM個を連続して割り当てる)
+	RenderGpuAddress				constant_address_;	//今フレームの定数の位置(アップロードヒープ上)
+	RenderGpuAddress				instance_addresses_[FrustumCuller::MAX_VIEW_NUM];	//今フレームの視錐台ごとのインスタンスデータの位置(アップロードヒープ上)
+	int								instance_nums_[FrustumCuller::MAX_VIEW_NUM];
+	int								view_num_;
+	InstanceTransform				instances_;
+	FrustumCuller					instance_culler_;	//インスタンスの境界(インスタンスは回るだけで動かないのでSetInstanceNumで設定する)
+	std::vector<InstanceTransform::InstanceData>	instance_data_;	//全てのインスタンスの今フレームのデータ(視錐台ごとに必要なものを書き写す)
+	Scene							*scene_;
+	Scene::Entity					entity_;
+	int								frame_;		//アニメーションのフレーム数(最初のフレームが1)
+	XMFLOAT4X4						world_;
+	float							time_;
+	bool							paused_;
+	TextureStreamer					*streamer_;
+	int								stream_ids_[TEXTURE_NUM];
+
+	//Loadで用意してInitializeでGPUに転送するデータ
+	std::vector<Vertex3D>			vertices_;
+	std::vector<uint16>				indices_;
+	TextureAsset					images_[TEXTURE_NUM];	//ストリーミングする場合は開いたままにする
+};
+
+#endif
@@ -0,0 +1,50 @@
+#include <cstdio>
+#include "StageTimer.h"
+
+#if defined(_WIN32)
+#include <Windows.h>
+#endif
+
+namespace{
+double ToMs(StageTimer::Clock::duration d){
+	return std::chrono::duration<double, std::milli>(d).count();
+}
+
+void Print(const char *str){
+#if defined(_WIN32)
+	OutputDebugStringA(str);
+#else
+	fputs(str, stderr);
+#endif
+}
+}
+
+StageTimer::StageTimer():
+	origin_(Clock::now()),
+	stages_{}{}
+
+void StageTimer::Add(const char *name, Clock::time_point begin, Clock::time_point end){
+	std::lock_guard<std::mutex> lock(mutex_);
+	stages_.push_back({name, ToMs(begin - origin_), ToMs(end - begin)});
+}
+
+double StageTimer::ElapsedMs() const{
+	return ToMs(Clock::now() - origin_);
+}
+
+std::vector<StageTimer::Stage> StageTimer::Stages() const{
+	std::lock_guard<std::mutex> lock(mutex_);
+	return stages_;
+}
+
+void StageTimer::Report(const char *title) const{
+	char line[256];
+
+	snprintf(line, sizeof(line), "[%s] total %.2f ms\n", title, ElapsedMs());
+	Print(line);
+
+	for(const Stage &s : Stages()){
+		snprintf(line, sizeof(line), "[%s]   %-28s start %8.2f ms  time %8.2f ms\n", title, s.name.c_str(), s.begin_ms, s.time_ms);
+		Print(line);
+	}
+}
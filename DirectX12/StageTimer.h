@@ -0,0 +1,47 @@
+#ifndef STAGE_TIMER_HEADER_
+#define STAGE_TIMER_HEADER_
+
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <vector>
+
+//起動処理などの各ステージにかかった時間を記録する
+//複数のスレッドから同時に記録してよい
+class StageTimer{
+public:
+	typedef std::chrono::steady_clock Clock;
+
+	struct Stage{
+		std::string	name;
+		double		begin_ms;	//計測開始からの経過時間
+		double		time_ms;	//ステージの所要時間
+	};
+
+public:
+	StageTimer();
+	~StageTimer(){}
+
+	//funcを実行してその所要時間をnameで記録する
+	template<class F>
+	auto Measure(const char *name, F func) -> decltype(func()){
+		const Clock::time_point begin = Clock::now();
+		auto result = func();
+		Add(name, begin, Clock::now());
+		return result;
+	}
+
+	void Add(const char *name, Clock::time_point begin, Clock::time_point end);
+	double ElapsedMs() const;
+	std::vector<Stage> Stages() const;
+
+	//記録したステージをデバッグ出力に書き出す
+	void Report(const char *title) const;
+
+private:
+	Clock::time_point	origin_;
+	mutable std::mutex	mutex_;
+	std::vector<Stage>	stages_;
+};
+
+#endif
@@ -0,0 +1,47 @@
+#include "TextureAsset.h"
+
+TextureAsset::TextureAsset():
+	container_{},
+	raw_{},
+	mips_{},
+	format_(TEXTURE_FORMAT_BGRA8),
+	levels_{}{}
+
+bool TextureAsset::Load(const char *name){
+	Close();
+
+	//クック済みのファイル
+	const std::string cooked = std::string(name) + COOKED_EXTENSION;
+	if(container_.Open(cooked.c_str())){
+		format_ = container_.Format();
+		for(int i = 0; i < container_.LevelNum(); ++i){
+			levels_.push_back(container_.GetLevel(i));
+		}
+		return true;
+	}
+
+	//生のファイルからミップマップを作成する
+	if(!raw_.Open(name)){
+		return false;
+	}
+	if(!mips_.Generate(raw_.Pixels(), raw_.Width(), raw_.Height(), raw_.RowPitch())){
+		Close();
+		return false;
+	}
+
+	format_ = TEXTURE_FORMAT_BGRA8;
+	for(int i = 0; i < mips_.LevelNum(); ++i){
+		const MipChain::Level &src = mips_.GetLevel(i);
+		levels_.push_back({src.width, src.height, src.row_pitch, src.height, src.pixels});
+	}
+
+	return true;
+}
+
+void TextureAsset::Close(){
+	levels_.clear();
+	mips_.Clear();
+	raw_.Close();
+	container_.Close();
+	format_ = TEXTURE_FORMAT_BGRA8;
+}
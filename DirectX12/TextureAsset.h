@@ -0,0 +1,38 @@
+#ifndef TEXTURE_ASSET_HEADER_
+#define TEXTURE_ASSET_HEADER_
+
+#include <string>
+#include <vector>
+#include "TextureContainer.h"
+#include "TextureFile.h"
+#include "MipChain.h"
+
+//テクスチャの読み込み
+//クック済みの"<name>.tex"があればそれを使い、なければ生のBGRA8ファイルからミップマップを作る
+class TextureAsset{
+public:
+	static constexpr const char *COOKED_EXTENSION = ".tex";
+
+public:
+	TextureAsset();
+	~TextureAsset(){}
+
+	bool Load(const char *name);
+	void Close();
+
+	bool IsOpen() const{return !levels_.empty();}
+	TextureFormat Format() const{return format_;}
+	int Width() const{return levels_[0].width;}
+	int Height() const{return levels_[0].height;}
+	int LevelNum() const{return static_cast<int>(levels_.size());}
+	const TextureLevel& GetLevel(int level) const{return levels_[level];}
+
+private:
+	TextureContainer			container_;
+	TextureFile					raw_;
+	MipChain					mips_;
+	TextureFormat				format_;
+	std::vector<TextureLevel>	levels_;
+};
+
+#endif
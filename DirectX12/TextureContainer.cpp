@@ -0,0 +1,146 @@
+#include <cstdio>
+#include <cstring>
+#include "TextureContainer.h"
+
+namespace{
+bool IsValidFormat(uint32_t format){
+	return format == TEXTURE_FORMAT_BGRA8 || format == TEXTURE_FORMAT_BC1 || format == TEXTURE_FORMAT_BC3;
+}
+
+uint64_t AlignUp(uint64_t v, uint64_t alignment){
+	return (v + alignment - 1) / alignment * alignment;
+}
+}
+
+int CalcTextureRowPitch(TextureFormat format, int width){
+	switch(format){
+		case TEXTURE_FORMAT_BC1: return ((width + 3) / 4) * 8;
+		case TEXTURE_FORMAT_BC3: return ((width + 3) / 4) * 16;
+		default:				 return width * 4;
+	}
+}
+
+int CalcTextureRowNum(TextureFormat format, int height){
+	switch(format){
+		case TEXTURE_FORMAT_BC1:
+		case TEXTURE_FORMAT_BC3: return (height + 3) / 4;
+		default:				 return height;
+	}
+}
+
+
+TextureContainer::TextureContainer():
+	file_{},
+	format_(TEXTURE_FORMAT_BGRA8),
+	levels_{}{}
+
+bool TextureContainer::Open(const char *file_name){
+	Close();
+
+	if(!file_.Open(file_name)){
+		return false;
+	}
+
+	//ヘッダの確認
+	Header header{};
+	if(file_.Size() < sizeof(header)){
+		Close();
+		return false;
+	}
+	memcpy(&header, file_.Data(), sizeof(header));
+	if(header.magic != MAGIC || header.version != VERSION || !IsValidFormat(header.format)
+		|| header.level_num == 0 || header.level_num > MAX_LEVEL){
+		Close();
+		return false;
+	}
+
+	const uint64_t table_end = sizeof(Header) + sizeof(LevelEntry) * static_cast<uint64_t>(header.level_num);
+	if(file_.Size() < table_end){
+		Close();
+		return false;
+	}
+
+	//ミップテーブルの読み込みと範囲の確認
+	format_ = static_cast<TextureFormat>(header.format);
+	levels_.resize(header.level_num);
+	for(uint32_t i = 0; i < header.level_num; ++i){
+		LevelEntry entry{};
+		memcpy(&entry, file_.Data() + sizeof(Header) + sizeof(LevelEntry) * i, sizeof(entry));
+
+		const uint32_t expect_w = (header.width >> i) > 0 ? (header.width >> i) : 1;
+		const uint32_t expect_h = (header.height >> i) > 0 ? (header.height >> i) : 1;
+		if(entry.width != expect_w || entry.height != expect_h){
+			Close();
+			return false;
+		}
+
+		TextureLevel &level = levels_[i];
+		level.width		= static_cast<int>(entry.width);
+		level.height	= static_cast<int>(entry.height);
+		level.row_pitch	= CalcTextureRowPitch(format_, level.width);
+		level.row_num	= CalcTextureRowNum(format_, level.height);
+
+		if(entry.size != static_cast<uint64_t>(level.row_pitch) * level.row_num
+			|| entry.offset < table_end || entry.offset > file_.Size() || file_.Size() - entry.offset < entry.size){
+			Close();
+			return false;
+		}
+		level.pixels = file_.Data() + entry.offset;
+	}
+
+	return true;
+}
+
+void TextureContainer::Close(){
+	levels_.clear();
+	format_ = TEXTURE_FORMAT_BGRA8;
+	file_.Close();
+}
+
+
+bool TextureContainer::Write(const char *file_name, TextureFormat format, const std::vector<TextureLevel> &levels){
+	if(levels.empty() || levels.size() > MAX_LEVEL || !IsValidFormat(format)){
+		return false;
+	}
+
+	Header header{};
+	header.magic		= MAGIC;
+	header.version		= VERSION;
+	header.format		= format;
+	header.width		= levels[0].width;
+	header.height		= levels[0].height;
+	header.level_num	= static_cast<uint32_t>(levels.size());
+
+	//各レベルの配置を決める
+	std::vector<LevelEntry> table(levels.size());
+	uint64_t offset = AlignUp(sizeof(Header) + sizeof(LevelEntry) * levels.size(), DATA_ALIGNMENT);
+	for(size_t i = 0; i < levels.size(); ++i){
+		table[i].offset	= offset;
+		table[i].size	= static_cast<uint64_t>(levels[i].row_pitch) * levels[i].row_num;
+		table[i].width	= levels[i].width;
+		table[i].height	= levels[i].height;
+		offset = AlignUp(offset + table[i].size, DATA_ALIGNMENT);
+	}
+
+	FILE *fp = fopen(file_name, "wb");
+	if(fp == nullptr){
+		return false;
+	}
+
+	bool ok = fwrite(&header, sizeof(header), 1, fp) == 1;
+	ok = ok && fwrite(table.data(), sizeof(LevelEntry), table.size(), fp) == table.size();
+
+	static const unsigned char zero[DATA_ALIGNMENT]{};
+	for(size_t i = 0; ok && i < levels.size(); ++i){
+		const long pad = static_cast<long>(table[i].offset) - ftell(fp);
+		ok = ok && (pad == 0 || fwrite(zero, 1, pad, fp) == static_cast<size_t>(pad));
+		ok = ok && fwrite(levels[i].pixels, 1, static_cast<size_t>(table[i].size), fp) == table[i].size;
+	}
+
+	ok = (fclose(fp) == 0) && ok;
+	if(!ok){
+		remove(file_name);
+	}
+
+	return ok;
+}
@@ -0,0 +1,73 @@
+#ifndef TEXTURE_CONTAINER_HEADER_
+#define TEXTURE_CONTAINER_HEADER_
+
+#include <cstdint>
+#include <vector>
+#include "MappedFile.h"
+
+enum TextureFormat : uint32_t{
+	TEXTURE_FORMAT_BGRA8	= 0,	//非圧縮
+	TEXTURE_FORMAT_BC1		= 1,	//4x4ブロックあたり8バイト(アルファなし)
+	TEXTURE_FORMAT_BC3		= 2,	//4x4ブロックあたり16バイト
+};
+
+//1つのミップレベルの画素
+struct TextureLevel{
+	int					width;
+	int					height;
+	int					row_pitch;	//1行(BCの場合はブロック1行)のバイト数
+	int					row_num;	//行数(BCの場合はブロックの行数)
+	const unsigned char	*pixels;
+};
+
+int CalcTextureRowPitch(TextureFormat format, int width);
+int CalcTextureRowNum(TextureFormat format, int height);
+
+
+//クック済みテクスチャのファイル(ヘッダ・ミップテーブル・画素データ)
+//読み込み時はファイルをマップして画素データを直接参照する
+class TextureContainer{
+public:
+	static constexpr uint32_t MAGIC		= 0x43584554;	//"TEXC"
+	static constexpr uint32_t VERSION	= 1;
+	static constexpr uint32_t MAX_LEVEL	= 16;
+	static constexpr uint32_t DATA_ALIGNMENT = 16;
+
+	struct Header{
+		uint32_t	magic;
+		uint32_t	version;
+		uint32_t	format;
+		uint32_t	width;
+		uint32_t	height;
+		uint32_t	level_num;
+		uint32_t	reserved[2];
+	};
+
+	struct LevelEntry{
+		uint64_t	offset;		//ファイル先頭からのオフセット
+		uint64_t	size;
+		uint32_t	width;
+		uint32_t	height;
+	};
+
+public:
+	TextureContainer();
+	~TextureContainer(){}
+
+	bool Open(const char *file_name);
+	void Close();
+
+	bool IsOpen() const{return file_.IsOpen();}
+	TextureFormat Format() const{return format_;}
+	int LevelNum() const{return static_cast<int>(levels_.size());}
+	const TextureLevel& GetLevel(int level) const{return levels_[level];}
+
+	static bool Write(const char *file_name, TextureFormat format, const std::vector<TextureLevel> &levels);
+
+private:
+	MappedFile					file_;
+	TextureFormat				format_;
+	std::vector<TextureLevel>	levels_;
+};
+
+#endif
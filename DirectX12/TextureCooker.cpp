@@ -0,0 +1,46 @@
+#include "TextureCooker.h"
+#include "TextureFile.h"
+#include "MipChain.h"
+#include "BlockCompressor.h"
+
+bool CookTexture(const char *src_file, const char *dst_file, TextureFormat format, JobSystem *jobs){
+	TextureFile image;
+	if(!image.Open(src_file)){
+		return false;
+	}
+
+	//BCはブロック単位なので最上位のレベルは4の倍数である必要がある
+	if(format != TEXTURE_FORMAT_BGRA8 && (image.Width() % 4 != 0 || image.Height() % 4 != 0)){
+		return false;
+	}
+
+	MipChain mips;
+	if(!mips.Generate(image.Pixels(), image.Width(), image.Height(), image.RowPitch())){
+		return false;
+	}
+
+	//各レベルを圧縮する
+	std::vector<std::vector<unsigned char>> buffers(mips.LevelNum());
+	std::vector<TextureLevel> levels(mips.LevelNum());
+	for(int i = 0; i < mips.LevelNum(); ++i){
+		const MipChain::Level &src = mips.GetLevel(i);
+		TextureLevel &dst = levels[i];
+		dst.width		= src.width;
+		dst.height		= src.height;
+		dst.row_pitch	= CalcTextureRowPitch(format, src.width);
+		dst.row_num		= CalcTextureRowNum(format, src.height);
+
+		if(format == TEXTURE_FORMAT_BGRA8){
+			dst.pixels = src.pixels;
+			continue;
+		}
+
+		buffers[i].resize(static_cast<size_t>(dst.row_pitch) * dst.row_num);
+		if(!BlockCompressor::Compress(format, src.pixels, src.width, src.height, src.row_pitch, buffers[i].data(), jobs)){
+			return false;
+		}
+		dst.pixels = buffers[i].data();
+	}
+
+	return TextureContainer::Write(dst_file, format, levels);
+}
@@ -0,0 +1,12 @@
+#ifndef TEXTURE_COOKER_HEADER_
+#define TEXTURE_COOKER_HEADER_
+
+#include "TextureContainer.h"
+
+class JobSystem;
+
+//生のBGRA8テクスチャ(幅・高さ+画素)からミップマップを作成し、
+//指定の形式に圧縮してTextureContainerの形式で書き出す
+bool CookTexture(const char *src_file, const char *dst_file, TextureFormat format, JobSystem *jobs);
+
+#endif
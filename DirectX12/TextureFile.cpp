@@ -0,0 +1,53 @@
+#include <cstring>
+#include <cstdint>
+#include "TextureFile.h"
+
+namespace{
+//D3D12のテクスチャの最大サイズ
+constexpr int MAX_TEXTURE_SIZE = 16384;
+}
+
+TextureFile::TextureFile():
+	file_{},
+	width_{},
+	height_{}{}
+
+bool TextureFile::Open(const char *file_name){
+	Close();
+
+	if(!file_.Open(file_name)){
+		return false;
+	}
+
+	//ヘッダの読み込み
+	if(file_.Size() < HEADER_SIZE){
+		Close();
+		return false;
+	}
+	int32_t width;
+	int32_t height;
+	memcpy(&width, file_.Data(), sizeof(width));
+	memcpy(&height, file_.Data() + sizeof(width), sizeof(height));
+
+	//ヘッダとファイルサイズが食い違っていないか確認する
+	if(width <= 0 || height <= 0 || width > MAX_TEXTURE_SIZE || height > MAX_TEXTURE_SIZE){
+		Close();
+		return false;
+	}
+	const uint64_t pixels_size = static_cast<uint64_t>(width) * height * PIXEL_SIZE;
+	if(file_.Size() - HEADER_SIZE < pixels_size){
+		Close();
+		return false;
+	}
+
+	width_  = width;
+	height_ = height;
+
+	return true;
+}
+
+void TextureFile::Close(){
+	file_.Close();
+	width_  = 0;
+	height_ = 0;
+}
@@ -0,0 +1,34 @@
+#ifndef TEXTURE_FILE_HEADER_
+#define TEXTURE_FILE_HEADER_
+
+#include "MappedFile.h"
+
+//幅・高さ(各4バイト)に続いてBGRA8の画素が並ぶテクスチャファイル
+//画素データはマップしたファイルを直接指すのでコピーは発生しない
+class TextureFile{
+public:
+	typedef unsigned char byte;
+	static constexpr size_t HEADER_SIZE = 8;
+	static constexpr int PIXEL_SIZE = 4;
+
+public:
+	TextureFile();
+	~TextureFile(){}
+
+	bool Open(const char *file_name);
+	void Close();
+
+	bool IsOpen() const{return file_.IsOpen();}
+	int Width() const{return width_;}
+	int Height() const{return height_;}
+	int RowPitch() const{return width_ * PIXEL_SIZE;}
+	size_t PixelsSize() const{return static_cast<size_t>(RowPitch()) * height_;}
+	const byte* Pixels() const{return file_.Data() + HEADER_SIZE;}
+
+private:
+	MappedFile	file_;
+	int			width_;
+	int			height_;
+};
+
+#endif
@@ -0,0 +1,248 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include "TextureStreamer.h"
+#include "JobSystem.h"
+
+TextureStreamer::TextureStreamer():
+	target_(nullptr),
+	io_jobs_(nullptr),
+	frame_budget_(DEFAULT_FRAME_BUDGET),
+	textures_{},
+	order_{},
+	stats_{}{}
+
+TextureStreamer::~TextureStreamer(){
+	//I/Oスレッドがassetを参照しているので読み込みの終了を待つ
+	WaitIdle();
+}
+
+void TextureStreamer::Initialize(TextureStreamTarget *target, JobSystem *io_jobs, uint64_t frame_budget){
+	target_			= target;
+	io_jobs_		= io_jobs;
+	frame_budget_	= frame_budget;
+}
+
+int TextureStreamer::Register(const TextureAsset *asset, RenderResource resource, int tail_size){
+	if(target_ == nullptr || asset == nullptr || !asset->IsOpen()){
+		return -1;
+	}
+
+	//tail_size以下の最初のレベル
+	const int level_num = asset->LevelNum();
+	int tail = level_num - 1;
+	for(int i = 0; i < level_num; ++i){
+		const TextureLevel &level = asset->GetLevel(i);
+		if(std::max(level.width, level.height) <= tail_size){
+			tail = i;
+			break;
+		}
+	}
+
+	for(int i = tail; i < level_num; ++i){
+		const TextureLevel &level = asset->GetLevel(i);
+		if(!target_->UploadRows(resource, asset->Format(), i, level, 0, level.row_num)){
+			return -1;
+		}
+
+		CopyFootprint footprint{};
+		CalcCopyFootprints(asset->Format(), level.width, level.height, 0, 1, 0, &footprint);
+		stats_.upload_bytes += static_cast<uint64_t>(footprint.row_pitch) * footprint.row_num;
+	}
+
+	Texture texture{};
+	texture.asset			= asset;
+	texture.resource		= resource;
+	texture.resident_level	= tail;
+	texture.desired_level	= tail;
+	texture.state			= STATE_IDLE;
+	textures_.push_back(std::move(texture));
+
+	return static_cast<int>(textures_.size()) - 1;
+}
+
+void TextureStreamer::Request(int texture, float screen_size){
+	Texture &t = textures_[texture];
+	t.screen_size = std::max(t.screen_size, screen_size);
+}
+
+void TextureStreamer::Update(){
+	stats_.frame_upload_bytes = 0;
+
+	//転送が完了したレベルを使えるようにする
+	const uint64_t completed = target_->CompletedValue();
+	for(Texture &t : textures_){
+		if(t.state == STATE_SUBMITTED && t.fence <= completed){
+			t.resident_level -= 1;
+			t.state = STATE_IDLE;
+		}
+	}
+
+	//今フレームの要求から必要なレベルと優先度を決める
+	//優先度は画面上の大きさに対して今の解像度がどれだけ足りないか(要求がなければ前の値を使う)
+	for(Texture &t : textures_){
+		if(t.screen_size > 0.0f){
+			const TextureLevel &level0 = t.asset->GetLevel(0);
+			const TextureLevel &resident = t.asset->GetLevel(t.resident_level);
+			t.desired_level	= CalcDesiredLevel(level0.width, level0.height, t.asset->LevelNum(), t.screen_size);
+			t.priority		= t.screen_size / static_cast<float>(std::max(resident.width, resident.height));
+			t.screen_size	= 0.0f;
+		}
+	}
+
+	order_.clear();
+	for(int i = 0; i < static_cast<int>(textures_.size()); ++i){
+		order_.push_back(i);
+	}
+	std::stable_sort(order_.begin(), order_.end(), [this](int a, int b){return textures_[a].priority > textures_[b].priority;});
+
+	StartReads();
+	UploadReady();
+
+	stats_.max_frame_upload_bytes = std::max(stats_.max_frame_upload_bytes, stats_.frame_upload_bytes);
+}
+
+//足りないテクスチャの次のレベルを優先度順に読み込み始める
+void TextureStreamer::StartReads(){
+	int reading = 0;
+	for(const Texture &t : textures_){
+		reading += (t.state == STATE_READING) ? 1 : 0;
+	}
+
+	for(int index : order_){
+		if(reading >= MAX_READ_NUM){
+			break;
+		}
+
+		Texture &t = textures_[index];
+		if(t.state != STATE_IDLE || t.resident_level <= t.desired_level){
+			continue;
+		}
+
+		//ファイルからの読み込み(マップしたファイルのページがここで読まれる)はI/Oスレッドで行う
+		const TextureLevel level = t.asset->GetLevel(t.resident_level - 1);
+		auto read = [level]{
+			const size_t size = static_cast<size_t>(level.row_pitch) * level.row_num;
+			std::vector<unsigned char> data(size);
+			memcpy(data.data(), level.pixels, size);
+			return data;
+		};
+		if(io_jobs_ != nullptr){
+			t.read = io_jobs_->Push(read);
+		}else{
+			std::promise<std::vector<unsigned char>> promise;
+			promise.set_value(read());
+			t.read = promise.get_future();
+		}
+		t.state = STATE_READING;
+		++reading;
+	}
+}
+
+//読み込めたレベルを優先度順に予算の範囲で転送する(予算に収まらないレベルは行で分けて次のフレームに回す)
+void TextureStreamer::UploadReady(){
+	uint64_t used = 0;
+	bool submit = false;
+
+	for(int index : order_){
+		Texture &t = textures_[index];
+
+		if(t.state == STATE_READING){
+			if(t.read.wait_for(std::chrono::seconds(0)) != std::future_status::ready){
+				continue;
+			}
+			t.data = t.read.get();
+			t.uploaded_rows = 0;
+			t.state = STATE_UPLOADING;
+
+			const TextureLevel &level = t.asset->GetLevel(t.resident_level - 1);
+			CalcCopyFootprints(t.asset->Format(), level.width, level.height, 0, 1, 0, &t.footprint);
+			++stats_.read_num;
+			stats_.read_bytes += t.data.size();
+		}
+		if(t.state != STATE_UPLOADING){
+			continue;
+		}
+
+		//予算に収まる行数(このフレームでまだ何も転送していなければ最低1行は進める)
+		int rows = t.footprint.row_num - t.uploaded_rows;
+		if(frame_budget_ > 0){
+			const uint64_t remaining = (used < frame_budget_) ? frame_budget_ - used : 0;
+			rows = static_cast<int>(std::min<uint64_t>(rows, remaining / t.footprint.row_pitch));
+			if(rows == 0 && used == 0){
+				rows = 1;
+			}
+		}
+		if(rows <= 0){
+			continue;
+		}
+
+		TextureLevel pixels = t.asset->GetLevel(t.resident_level - 1);
+		pixels.pixels = t.data.data();
+		if(!target_->UploadRows(t.resource, t.asset->Format(), t.resident_level - 1, pixels, t.uploaded_rows, rows)){
+			break;
+		}
+
+		const uint64_t bytes = static_cast<uint64_t>(t.footprint.row_pitch) * rows;
+		used += bytes;
+		stats_.upload_bytes += bytes;
+		t.uploaded_rows += rows;
+		submit = true;
+
+		//全ての行をステージングに書き込んだら読み込んだデータは要らない
+		if(t.uploaded_rows == t.footprint.row_num){
+			t.state = STATE_SUBMITTED;
+			t.fence = 0;
+			std::vector<unsigned char>().swap(t.data);
+		}
+	}
+
+	if(!submit){
+		return;
+	}
+
+	//行の途中までのものも同じ提出に含まれるが、完了の判定は全ての行を提出したものだけ行う
+	const uint64_t fence = target_->Submit();
+	for(Texture &t : textures_){
+		if(t.state == STATE_SUBMITTED && t.fence == 0){
+			t.fence = fence;
+		}
+	}
+	stats_.frame_upload_bytes = used;
+}
+
+bool TextureStreamer::IsComplete() const{
+	for(const Texture &t : textures_){
+		if(t.state != STATE_IDLE || t.resident_level > t.desired_level){
+			return false;
+		}
+	}
+	return true;
+}
+
+void TextureStreamer::WaitIdle(){
+	for(Texture &t : textures_){
+		if(t.read.valid()){
+			t.read.wait();
+		}
+	}
+}
+
+int TextureStreamer::CalcDesiredLevel(int width, int height, int level_num, float screen_size){
+	const float size = static_cast<float>(std::max(width, height));
+	if(screen_size <= 0.0f || level_num <= 0){
+		return std::max(0, level_num - 1);
+	}
+
+	//screen_size以上の大きさを持つ最も小さいレベル
+	const int level = static_cast<int>(std::floor(std::log2(size / screen_size)));
+	return std::min(std::max(level, 0), level_num - 1);
+}
+
+float TextureStreamer::ProjectedSize(float radius, float view_depth, float fov_y, float viewport_height){
+	if(view_depth <= radius){
+		return viewport_height * 2.0f;	//カメラに接しているものは画面いっぱいとみなす
+	}
+	return radius / (view_depth * std::tan(fov_y * 0.5f)) * viewport_height;
+}
@@ -0,0 +1,123 @@
+#ifndef TEXTURE_STREAMER_HEADER_
+#define TEXTURE_STREAMER_HEADER_
+
+#include <cstdint>
+#include <future>
+#include <vector>
+#include "RenderTypes.h"
+#include "TextureAsset.h"
+#include "CopyFootprint.h"
+
+class JobSystem;
+
+//テクスチャの転送先(D3D12ではコピーキュー、計測ではGPUなしの模擬キュー)
+class TextureStreamTarget{
+public:
+	virtual ~TextureStreamTarget(){}
+
+	//resourceのlevelの行[first_row, first_row + row_num)の転送を記録する(ステージングに空きがなければfalse)
+	virtual bool UploadRows(RenderResource resource, TextureFormat format, int level, const TextureLevel &pixels, int first_row, int row_num) = 0;
+
+	//記録した転送を提出し、完了を判定するためのフェンス値を返す
+	virtual uint64_t Submit() = 0;
+	virtual uint64_t CompletedValue() = 0;
+};
+
+
+//テクスチャのストリーミング
+//登録時は小さいレベルだけを転送して描画を始め、詳細なレベルはI/Oスレッドで読み込んでから少しずつ転送する
+//1フレームに転送するバイト数は予算で抑え、画面上で大きく見えるのに解像度が足りないものから転送する
+class TextureStreamer{
+public:
+	static constexpr uint64_t DEFAULT_FRAME_BUDGET	= 1024 * 1024;
+	static constexpr int DEFAULT_TAIL_SIZE			= 64;	//この幅・高さ以下のレベルは登録時に転送する
+	static constexpr int MAX_READ_NUM				= 4;	//同時に読み込むレベルの数
+
+	struct Stats{
+		uint64_t	read_num;				//I/Oスレッドで読み込んだレベルの数
+		uint64_t	read_bytes;
+		uint64_t	upload_bytes;			//転送したバイト数(ステージング上の行の間隔で数える)
+		uint64_t	frame_upload_bytes;		//直前のUpdateで転送したバイト数
+		uint64_t	max_frame_upload_bytes;	//登録時の転送を除く1フレームの最大
+	};
+
+public:
+	TextureStreamer();
+	~TextureStreamer();
+	TextureStreamer(const TextureStreamer&) = delete;
+	TextureStreamer& operator=(const TextureStreamer&) = delete;
+
+	//frame_budgetが0なら転送量を制限しない
+	void Initialize(TextureStreamTarget *target, JobSystem *io_jobs, uint64_t frame_budget);
+	void SetFrameBudget(uint64_t frame_budget){frame_budget_ = frame_budget;}
+	uint64_t FrameBudget() const{return frame_budget_;}
+
+	//assetは詳細なレベルを読み込むので、ストリーマより長く開いたままにしておくこと
+	//tail_size以下のレベル(なければ最も小さいレベル)の転送を記録し、すぐに使えるものとして扱う
+	//呼び出し側は最初の描画の前にその転送の完了を待つこと。失敗した場合は-1を返す
+	int Register(const TextureAsset *asset, RenderResource resource, int tail_size = DEFAULT_TAIL_SIZE);
+
+	//今フレームに描画される画面上の大きさ(ピクセル)を伝える(同じテクスチャに複数回呼んだ場合は最大をとる)
+	void Request(int texture, float screen_size);
+
+	//フレームごとに1回呼ぶ
+	//完了した転送を反映し、次のレベルの読み込みを始め、読み込めたものを予算の範囲で転送する
+	void Update();
+
+	//シェーダで使ってよい最も詳細なレベル
+	float MinLod(int texture) const{return static_cast<float>(textures_[texture].resident_level);}
+	int ResidentLevel(int texture) const{return textures_[texture].resident_level;}
+	int DesiredLevel(int texture) const{return textures_[texture].desired_level;}
+	int TextureNum() const{return static_cast<int>(textures_.size());}
+
+	//全てのテクスチャが要求された解像度まで転送済みか
+	bool IsComplete() const;
+
+	//読み込み中のジョブが終わるのを待つ
+	void WaitIdle();
+
+	const Stats& GetStats() const{return stats_;}
+	void ResetStats(){stats_ = {};}
+
+	//画面上の大きさに足りる最も小さいレベル
+	static int CalcDesiredLevel(int width, int height, int level_num, float screen_size);
+
+	//半径radiusの球がビュー空間の奥行きview_depthにあるときの画面上の直径(ピクセル)
+	static float ProjectedSize(float radius, float view_depth, float fov_y, float viewport_height);
+
+private:
+	enum State{
+		STATE_IDLE,			//次のレベルは未着手
+		STATE_READING,		//I/Oスレッドで読み込み中
+		STATE_UPLOADING,	//読み込み済みで、転送の途中
+		STATE_SUBMITTED,	//全ての行を提出済みで、完了待ち
+	};
+
+	struct Texture{
+		const TextureAsset							*asset;
+		RenderResource								resource;
+		int											resident_level;	//転送が完了した最も詳細なレベル
+		int											desired_level;
+		float										screen_size;	//今フレームの要求
+		float										priority;
+		State										state;
+		std::future<std::vector<unsigned char>>		read;
+		std::vector<unsigned char>					data;			//読み込んだ次のレベル
+		CopyFootprint								footprint;
+		int											uploaded_rows;
+		uint64_t									fence;
+	};
+
+	void StartReads();
+	void UploadReady();
+
+private:
+	TextureStreamTarget		*target_;
+	JobSystem				*io_jobs_;
+	uint64_t				frame_budget_;
+	std::vector<Texture>	textures_;
+	std::vector<int>		order_;		//優先度順に並べる作業用
+	Stats					stats_;
+};
+
+#endif
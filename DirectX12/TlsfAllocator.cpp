@@ -0,0 +1,367 @@
+#include <algorithm>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#include "TlsfAllocator.h"
+
+namespace{
+//最上位・最下位の立っているビットの位置(valueは0以外)
+int FindLastSet(uint64_t value){
+#if defined(_MSC_VER)
+	unsigned long index;
+	_BitScanReverse64(&index, value);
+	return static_cast<int>(index);
+#else
+	return 63 - __builtin_clzll(value);
+#endif
+}
+
+int FindFirstSet(uint64_t value){
+#if defined(_MSC_VER)
+	unsigned long index;
+	_BitScanForward64(&index, value);
+	return static_cast<int>(index);
+#else
+	return __builtin_ctzll(value);
+#endif
+}
+
+uint64_t AlignUp(uint64_t value, uint64_t alignment){
+	return (value + alignment - 1) & ~(alignment - 1);
+}
+}
+
+TlsfAllocator::TlsfAllocator():
+	TlsfAllocator(0){}
+
+TlsfAllocator::TlsfAllocator(uint64_t size):
+	size_{},
+	used_size_{},
+	allocation_num_{},
+	free_block_num_{},
+	failed_num_{},
+	fl_bitmap_{},
+	sl_bitmap_{},
+	heads_{},
+	blocks_{},
+	unused_blocks_{},
+	allocations_{},
+	pending_{}{
+	Reset(size);
+}
+
+void TlsfAllocator::Reset(uint64_t size){
+	size_			= size;
+	used_size_		= 0;
+	allocation_num_	= 0;
+	free_block_num_	= 0;
+	failed_num_		= 0;
+	fl_bitmap_		= 0;
+	for(int fl = 0; fl < FL_INDEX_NUM; ++fl){
+		sl_bitmap_[fl] = 0;
+		for(int sl = 0; sl < SL_INDEX_NUM; ++sl){
+			heads_[fl][sl] = NIL;
+		}
+	}
+	blocks_.clear();
+	unused_blocks_.clear();
+	allocations_.clear();
+	pending_.clear();
+
+	//先頭のブロック(blocks_[0])は結合で消えることがない
+	if(size > 0){
+		InsertFreeBlock(NewBlock(0, size));
+	}
+}
+
+//大きさからリストを決める(第1レベルは2のべき、第2レベルはその範囲を16等分した位置)
+void TlsfAllocator::Mapping(uint64_t size, int *fl, int *sl){
+	*fl = FindLastSet(size);
+	if(*fl >= SL_INDEX_LOG2){
+		*sl = static_cast<int>(size >> (*fl - SL_INDEX_LOG2)) - SL_INDEX_NUM;
+	}else{
+		*sl = static_cast<int>(size << (SL_INDEX_LOG2 - *fl)) - SL_INDEX_NUM;
+	}
+}
+
+//size以上であることが保証されるリストのうち、最も小さいものの先頭のブロック
+uint32_t TlsfAllocator::FindFreeBlock(uint64_t size) const{
+	//リストの範囲の上端まで切り上げて探す(見つかったリストのブロックはどれでもsize以上になる)
+	const int size_fl = FindLastSet(size);
+	if(size_fl >= SL_INDEX_LOG2){
+		const uint64_t round = (1ull << (size_fl - SL_INDEX_LOG2)) - 1;
+		if(size > ~0ull - round){
+			return NIL;
+		}
+		size += round;
+	}
+
+	int fl, sl;
+	Mapping(size, &fl, &sl);
+
+	uint32_t sl_map = sl_bitmap_[fl] & (~0u << sl);
+	if(sl_map == 0){
+		const uint64_t fl_map = (fl + 1 < FL_INDEX_NUM) ? fl_bitmap_ & (~0ull << (fl + 1)) : 0;
+		if(fl_map == 0){
+			return NIL;
+		}
+		fl = FindFirstSet(fl_map);
+		sl_map = sl_bitmap_[fl];
+	}
+	sl = FindFirstSet(sl_map);
+
+	return heads_[fl][sl];
+}
+
+void TlsfAllocator::InsertFreeBlock(uint32_t block){
+	int fl, sl;
+	Mapping(blocks_[block].size, &fl, &sl);
+
+	Block &b = blocks_[block];
+	b.free		= true;
+	b.prev_free	= NIL;
+	b.next_free	= heads_[fl][sl];
+	if(b.next_free != NIL){
+		blocks_[b.next_free].prev_free = block;
+	}
+	heads_[fl][sl] = block;
+	fl_bitmap_ |= 1ull << fl;
+	sl_bitmap_[fl] |= 1u << sl;
+	++free_block_num_;
+}
+
+void TlsfAllocator::RemoveFreeBlock(uint32_t block){
+	int fl, sl;
+	Mapping(blocks_[block].size, &fl, &sl);
+
+	Block &b = blocks_[block];
+	if(b.prev_free != NIL){
+		blocks_[b.prev_free].next_free = b.next_free;
+	}else{
+		heads_[fl][sl] = b.next_free;
+		if(b.next_free == NIL){
+			sl_bitmap_[fl] &= ~(1u << sl);
+			if(sl_bitmap_[fl] == 0){
+				fl_bitmap_ &= ~(1ull << fl);
+			}
+		}
+	}
+	if(b.next_free != NIL){
+		blocks_[b.next_free].prev_free = b.prev_free;
+	}
+	b.free		= false;
+	b.prev_free	= NIL;
+	b.next_free	= NIL;
+	--free_block_num_;
+}
+
+uint32_t TlsfAllocator::NewBlock(uint64_t offset, uint64_t size){
+	const Block block{offset, size, NIL, NIL, NIL, NIL, false};
+	if(!unused_blocks_.empty()){
+		const uint32_t index = unused_blocks_.back();
+		unused_blocks_.pop_back();
+		blocks_[index] = block;
+		return index;
+	}
+	blocks_.push_back(block);
+	return static_cast<uint32_t>(blocks_.size()) - 1;
+}
+
+void TlsfAllocator::DeleteBlock(uint32_t block){
+	unused_blocks_.push_back(block);
+}
+
+//blockの先頭size分を残し、残りを新しいブロックにして返す(どちらも空きリストには入れない)
+uint32_t TlsfAllocator::Split(uint32_t block, uint64_t size){
+	const uint32_t rest = NewBlock(blocks_[block].offset + size, blocks_[block].size - size);
+	Block &b = blocks_[block];
+	Block &r = blocks_[rest];
+
+	r.prev_physical = block;
+	r.next_physical = b.next_physical;
+	if(b.next_physical != NIL){
+		blocks_[b.next_physical].prev_physical = rest;
+	}
+	b.next_physical = rest;
+	b.size = size;
+
+	return rest;
+}
+
+uint64_t TlsfAllocator::Allocate(uint64_t size, uint64_t alignment){
+	alignment = std::max<uint64_t>(alignment, 1);
+	if(size == 0 || size > size_){
+		++failed_num_;
+		return INVALID_OFFSET;
+	}
+
+	//揃えたときに収まるかはリストの先頭のブロックで確かめ、収まらなければアライメントの分だけ大きく探す
+	uint32_t block = FindFreeBlock(size);
+	if(block == NIL || AlignUp(blocks_[block].offset, alignment) - blocks_[block].offset + size > blocks_[block].size){
+		block = (size <= ~0ull - alignment) ? FindFreeBlock(size + alignment - 1) : NIL;
+	}
+	if(block == NIL){
+		++failed_num_;
+		return INVALID_OFFSET;
+	}
+	RemoveFreeBlock(block);
+
+	//アライメントのための前の余りは空きブロックとして残す
+	const uint64_t gap = AlignUp(blocks_[block].offset, alignment) - blocks_[block].offset;
+	if(gap > 0){
+		const uint32_t aligned = Split(block, gap);
+		InsertFreeBlock(block);
+		block = aligned;
+	}
+
+	//後ろの余りは空きブロックに戻す(前後のブロックは割り当て中なので結合しなくてよい)
+	if(blocks_[block].size > size){
+		InsertFreeBlock(Split(block, size));
+	}
+
+	const uint64_t offset = blocks_[block].offset;
+	allocations_[offset] = block;
+	used_size_ += size;
+	++allocation_num_;
+	return offset;
+}
+
+void TlsfAllocator::Free(uint64_t offset, uint64_t fence_value){
+	if(offset == INVALID_OFFSET){
+		return;
+	}
+	if(fence_value > 0){
+		pending_.push_back({offset, fence_value});
+		return;
+	}
+	Release(offset);
+}
+
+void TlsfAllocator::ReleaseCompleted(uint64_t completed_fence_value){
+	while(!pending_.empty() && pending_.front().fence_value <= completed_fence_value){
+		Release(pending_.front().offset);
+		pending_.pop_front();
+	}
+}
+
+void TlsfAllocator::Release(uint64_t offset){
+	auto it = allocations_.find(offset);
+	if(it == allocations_.end()){
+		return;
+	}
+	uint32_t block = it->second;
+	allocations_.erase(it);
+	used_size_ -= blocks_[block].size;
+	--allocation_num_;
+
+	//前後の空きブロックと結合する
+	const uint32_t prev = blocks_[block].prev_physical;
+	if(prev != NIL && blocks_[prev].free){
+		RemoveFreeBlock(prev);
+		blocks_[prev].size += blocks_[block].size;
+		blocks_[prev].next_physical = blocks_[block].next_physical;
+		if(blocks_[block].next_physical != NIL){
+			blocks_[blocks_[block].next_physical].prev_physical = prev;
+		}
+		DeleteBlock(block);
+		block = prev;
+	}
+
+	const uint32_t next = blocks_[block].next_physical;
+	if(next != NIL && blocks_[next].free){
+		RemoveFreeBlock(next);
+		blocks_[block].size += blocks_[next].size;
+		blocks_[block].next_physical = blocks_[next].next_physical;
+		if(blocks_[next].next_physical != NIL){
+			blocks_[blocks_[next].next_physical].prev_physical = block;
+		}
+		DeleteBlock(next);
+	}
+
+	InsertFreeBlock(block);
+}
+
+uint64_t TlsfAllocator::AllocationSize(uint64_t offset) const{
+	auto it = allocations_.find(offset);
+	return (it != allocations_.end()) ? blocks_[it->second].size : 0;
+}
+
+TlsfAllocator::Stats TlsfAllocator::GetStats() const{
+	Stats stats{};
+	stats.size				= size_;
+	stats.used_size			= used_size_;
+	stats.allocation_num	= allocation_num_;
+	stats.free_block_num	= free_block_num_;
+	stats.pending_num		= static_cast<uint32_t>(pending_.size());
+	stats.failed_num		= failed_num_;
+
+	//最大の空きブロックは空きのある最も大きいリストの中にある
+	if(fl_bitmap_ != 0){
+		const int fl = FindLastSet(fl_bitmap_);
+		const int sl = FindLastSet(sl_bitmap_[fl]);
+		for(uint32_t b = heads_[fl][sl]; b != NIL; b = blocks_[b].next_free){
+			stats.largest_free_size = std::max(stats.largest_free_size, blocks_[b].size);
+		}
+	}
+	return stats;
+}
+
+bool TlsfAllocator::Validate() const{
+	if(size_ == 0){
+		return blocks_.empty() && fl_bitmap_ == 0;
+	}
+
+	//アドレス順にたどって、隙間なく並び、空きブロックが隣り合っていないこと
+	uint64_t offset = 0;
+	uint64_t used = 0;
+	uint32_t free_num = 0;
+	uint32_t used_num = 0;
+	uint32_t prev = NIL;
+	for(uint32_t b = 0; b != NIL; b = blocks_[b].next_physical){
+		const Block &block = blocks_[b];
+		if(block.offset != offset || block.size == 0 || block.prev_physical != prev){
+			return false;
+		}
+		if(block.free && prev != NIL && blocks_[prev].free){
+			return false;
+		}
+		if(!block.free){
+			auto it = allocations_.find(block.offset);
+			if(it == allocations_.end() || it->second != b){
+				return false;
+			}
+		}
+		offset += block.size;
+		used += block.free ? 0 : block.size;
+		free_num += block.free ? 1 : 0;
+		used_num += block.free ? 0 : 1;
+		prev = b;
+	}
+	if(offset != size_ || used != used_size_ || free_num != free_block_num_ || used_num != allocation_num_ || allocations_.size() != allocation_num_){
+		return false;
+	}
+
+	//空きリストとビットマップが一致し、各ブロックが大きさに対応するリストにあること
+	uint32_t listed = 0;
+	for(int fl = 0; fl < FL_INDEX_NUM; ++fl){
+		if(((fl_bitmap_ >> fl) & 1) != (sl_bitmap_[fl] != 0 ? 1u : 0u)){
+			return false;
+		}
+		for(int sl = 0; sl < SL_INDEX_NUM; ++sl){
+			if(((sl_bitmap_[fl] >> sl) & 1) != (heads_[fl][sl] != NIL ? 1u : 0u)){
+				return false;
+			}
+			uint32_t prev_free = NIL;
+			for(uint32_t b = heads_[fl][sl]; b != NIL; b = blocks_[b].next_free){
+				int block_fl, block_sl;
+				Mapping(blocks_[b].size, &block_fl, &block_sl);
+				if(!blocks_[b].free || block_fl != fl || block_sl != sl || blocks_[b].prev_free != prev_free){
+					return false;
+				}
+				prev_free = b;
+				++listed;
+			}
+		}
+	}
+	return listed == free_block_num_;
+}
@@ -0,0 +1,103 @@
+#ifndef TLSF_ALLOCATOR_HEADER_
+#define TLSF_ALLOCATOR_HEADER_
+
+#include <cstdint>
+#include <deque>
+#include <unordered_map>
+#include <vector>
+
+//TLSF(Two-Level Segregated Fit)による範囲の割り当て(オフセットの管理のみで、メモリ自体は持たない)
+//空きブロックを大きさの2のべき(第1レベル)とその16分割(第2レベル)のリストに分け、ビットマップで空きのあるリストを探す
+//割り当て・解放ともにブロックの数によらない一定の手間で終わり、解放したブロックは隣の空きブロックと結合する
+class TlsfAllocator{
+public:
+	static constexpr uint64_t INVALID_OFFSET = ~0ull;
+
+	struct Stats{
+		uint64_t	size;				//管理する範囲の大きさ
+		uint64_t	used_size;			//割り当て中の大きさ(解放待ちを含む)
+		uint64_t	largest_free_size;	//一度に割り当てられる最大の大きさ(アライメントを考えない)
+		uint32_t	allocation_num;
+		uint32_t	free_block_num;		//空きブロックの数
+		uint32_t	pending_num;		//フェンスの通過を待っている解放の数
+		uint64_t	failed_num;			//空きがなく割り当てに失敗した回数
+
+		//空き容量のうち、最大の空きブロックに入らない割合(0なら断片化していない)
+		float Fragmentation() const{
+			const uint64_t free_size = size - used_size;
+			return (free_size > 0) ? 1.0f - static_cast<float>(largest_free_size) / static_cast<float>(free_size) : 0.0f;
+		}
+	};
+
+public:
+	TlsfAllocator();
+	explicit TlsfAllocator(uint64_t size);
+	~TlsfAllocator(){}
+
+	void Reset(uint64_t size);
+
+	//alignmentの倍数のオフセットを返す(空きがなければINVALID_OFFSET)。alignmentは2のべきであること
+	uint64_t Allocate(uint64_t size, uint64_t alignment = 1);
+
+	//fence_valueのフレームまでGPUが参照する範囲を解放する(0ならすぐに再利用してよい)
+	void Free(uint64_t offset, uint64_t fence_value = 0);
+
+	//completed_fence_value以下のフレームで解放した範囲を再利用できるようにする
+	void ReleaseCompleted(uint64_t completed_fence_value);
+
+	//割り当てた範囲の大きさ(割り当てていないオフセットなら0)
+	uint64_t AllocationSize(uint64_t offset) const;
+
+	uint64_t Size() const{return size_;}
+	bool IsEmpty() const{return used_size_ == 0;}
+	Stats GetStats() const;
+
+	//ブロックのつながり・空きリスト・ビットマップが整合しているか(検証用。ブロックの数に比例する時間がかかる)
+	bool Validate() const;
+
+private:
+	static constexpr int SL_INDEX_LOG2	= 4;
+	static constexpr int SL_INDEX_NUM	= 1 << SL_INDEX_LOG2;
+	static constexpr int FL_INDEX_NUM	= 64;
+	static constexpr uint32_t NIL		= ~0u;
+
+	struct Block{
+		uint64_t	offset;
+		uint64_t	size;
+		uint32_t	prev_physical;	//1つ前のブロック(アドレス順)
+		uint32_t	next_physical;
+		uint32_t	prev_free;		//同じリストの空きブロック
+		uint32_t	next_free;
+		bool		free;
+	};
+
+	struct Pending{
+		uint64_t	offset;
+		uint64_t	fence_value;
+	};
+
+	static void Mapping(uint64_t size, int *fl, int *sl);
+	uint32_t FindFreeBlock(uint64_t size) const;
+	void InsertFreeBlock(uint32_t block);
+	void RemoveFreeBlock(uint32_t block);
+	uint32_t NewBlock(uint64_t offset, uint64_t size);
+	void DeleteBlock(uint32_t block);
+	uint32_t Split(uint32_t block, uint64_t size);
+	void Release(uint64_t offset);
+
+private:
+	uint64_t								size_;
+	uint64_t								used_size_;
+	uint32_t								allocation_num_;
+	uint32_t								free_block_num_;
+	uint64_t								failed_num_;
+	uint64_t								fl_bitmap_;						//空きのある第1レベル
+	uint32_t								sl_bitmap_[FL_INDEX_NUM];		//空きのある第2レベル
+	uint32_t								heads_[FL_INDEX_NUM][SL_INDEX_NUM];	//空きリストの先頭
+	std::vector<Block>						blocks_;
+	std::vector<uint32_t>					unused_blocks_;					//再利用するblocks_の添字
+	std::unordered_map<uint64_t, uint32_t>	allocations_;					//割り当て中のオフセット -> ブロック
+	std::deque<Pending>						pending_;						//解放待ち(フェンス値の順)
+};
+
+#endif
@@ -0,0 +1,65 @@
+#include "UploadRingBuffer.h"
+
+UploadRingBuffer::UploadRingBuffer():
+	buffer_{},
+	cpu_address_(nullptr),
+	gpu_address_{},
+	allocator_{}{}
+
+UploadRingBuffer::~UploadRingBuffer(){
+	if(buffer_ != nullptr && cpu_address_ != nullptr){
+		buffer_->Unmap(0, nullptr);
+	}
+}
+
+HRESULT UploadRingBuffer::Initialize(ID3D12Device *device, UINT64 size){
+	HRESULT hr{};
+	D3D12_HEAP_PROPERTIES heap_properties{};
+	D3D12_RESOURCE_DESC   resource_desc{};
+
+	heap_properties.Type					= D3D12_HEAP_TYPE_UPLOAD;
+	heap_properties.CPUPageProperty			= D3D12_CPU_PAGE_PROPERTY_UNKNOWN;
+	heap_properties.MemoryPoolPreference	= D3D12_MEMORY_POOL_UNKNOWN;
+	heap_properties.CreationNodeMask		= 0;
+	heap_properties.VisibleNodeMask			= 0;
+
+	resource_desc.Dimension				= D3D12_RESOURCE_DIMENSION_BUFFER;
+	resource_desc.Width					= size;
+	resource_desc.Height				= 1;
+	resource_desc.DepthOrArraySize		= 1;
+	resource_desc.MipLevels				= 1;
+	resource_desc.Format				= DXGI_FORMAT_UNKNOWN;
+	resource_desc.Layout				= D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
+	resource_desc.SampleDesc.Count		= 1;
+	resource_desc.SampleDesc.Quality	= 0;
+
+	hr = device->CreateCommittedResource(&heap_properties, D3D12_HEAP_FLAG_NONE, &resource_desc, D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(buffer_.ReleaseAndGetAddressOf()));
+	if(FAILED(hr)){
+		return hr;
+	}
+
+	//アップロードヒープはMapしたままでよい(CPUからは書き込みのみ)
+	D3D12_RANGE read_range{0, 0};
+	hr = buffer_->Map(0, &read_range, (void**)&cpu_address_);
+	if(FAILED(hr)){
+		return hr;
+	}
+
+	gpu_address_ = buffer_->GetGPUVirtualAddress();
+	allocator_.Reset(size);
+
+	return S_OK;
+}
+
+bool UploadRingBuffer::Allocate(uint64_t size, uint64_t alignment, Allocation *allocation){
+	const uint64_t offset = allocator_.Allocate(size, alignment);
+	if(offset == RingAllocator::INVALID_OFFSET){
+		return false;
+	}
+
+	allocation->cpu_address	= cpu_address_ + offset;
+	allocation->gpu_address	= gpu_address_ + offset;
+	allocation->offset		= offset;
+
+	return true;
+}
@@ -0,0 +1,38 @@
+#ifndef UPLOAD_RING_BUFFER_HEADER_
+#define UPLOAD_RING_BUFFER_HEADER_
+
+#include <d3d12.h>
+#include <wrl/client.h>
+#include "RingAllocator.h"
+#include "RenderUploadHeap.h"
+
+using namespace Microsoft::WRL;
+
+//フレームごとの定数などを書き込むアップロードヒープ上のリングバッファ
+//作成時に一度だけMapし、以降はRingAllocatorで切り出して使う
+class UploadRingBuffer : public RenderUploadHeap{
+public:
+	static_assert(CONSTANT_ALIGNMENT == D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT, "constant alignment");
+
+public:
+	UploadRingBuffer();
+	~UploadRingBuffer();
+	HRESULT Initialize(ID3D12Device *device, UINT64 size);
+
+	bool Allocate(uint64_t size, uint64_t alignment, Allocation *allocation) override;
+
+	//フレームの割り当てを締め、GPUが完了したフレームの領域を解放する
+	void FinishFrame(uint64_t fence_value) override{allocator_.FinishFrame(fence_value);}
+	void ReleaseCompletedFrames(uint64_t completed_fence_value) override{allocator_.ReleaseCompletedFrames(completed_fence_value);}
+
+	ID3D12Resource* GetResource() const{return buffer_.Get();}
+	UINT64 UsedSize() const{return allocator_.UsedSize();}
+
+private:
+	ComPtr<ID3D12Resource>		buffer_;
+	unsigned char				*cpu_address_;
+	D3D12_GPU_VIRTUAL_ADDRESS	gpu_address_;
+	RingAllocator				allocator_;
+};
+
+#endif
@@ -0,0 +1,12 @@
+#ifndef VERTEX3D_HEADER_
+#define VERTEX3D_HEADER_
+
+#include <DirectXMath.h>
+
+struct Vertex3D{
+	DirectX::XMFLOAT3 Position;	//位置
+	DirectX::XMFLOAT3 Normal;	//法線
+	DirectX::XMFLOAT2 UV;		//UV座標
+};
+
+#endif
@@ -1,90 +1,194 @@
-#include <Windows.h>
-#include <tchar.h>
-#include "D3D12Manager.h"
-
-namespace{
-constexpr int WINDOW_WIDTH  = 640;
-constexpr int WINDOW_HEIGHT = 480;
-constexpr LPSTR WND_CLASS_NAME = _T("DirectX12");
-}
-
-LRESULT CALLBACK WindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam);
-
-int WINAPI WinMain(HINSTANCE hInst, HINSTANCE hPrevInst, LPSTR lpCmdLine, int nShowCmd){
-	WNDCLASSEX	wc{};
-	HWND hwnd{};
-
-	wc.cbSize			= sizeof(WNDCLASSEX);
-	wc.style			= CS_HREDRAW | CS_VREDRAW;
-	wc.lpfnWndProc		= WindowProc;
-	wc.cbClsExtra		= 0;
-	wc.cbWndExtra		= 0;
-	wc.hInstance		= hInst;
-	wc.lpszMenuName		= NULL;
-	wc.lpszClassName	= WND_CLASS_NAME;
-	wc.hIcon			= (HICON)LoadImage(NULL, IDI_APPLICATION, IMAGE_ICON, 0, 0, LR_SHARED);
-	wc.hCursor			= LoadCursor(NULL, IDC_ARROW);
-	wc.hIconSm			= (HICON)LoadImage(NULL, IDI_APPLICATION, IMAGE_ICON, 0, 0, LR_SHARED);
-	wc.hbrBackground	= (HBRUSH)GetStockObject(BLACK_BRUSH);
-
-	if(RegisterClassEx(&wc) == 0){ 
-		return -1;
-	}
-
-	hwnd = CreateWindowEx(
-		WS_EX_COMPOSITED,
-		WND_CLASS_NAME,
-		WND_CLASS_NAME,
-		WS_OVERLAPPED | WS_CAPTION | WS_SYSMENU,
-		CW_USEDEFAULT,
-		CW_USEDEFAULT,
-		WINDOW_WIDTH,
-		WINDOW_HEIGHT,
-		NULL,
-		NULL,
-		hInst,
-		NULL);
-
-	{
-		int screen_width  = GetSystemMetrics(SM_CXSCREEN);
-		int screen_height = GetSystemMetrics(SM_CYSCREEN);
-		RECT rect{};
-		GetClientRect(hwnd, &rect);
-		MoveWindow(
-			hwnd,
-			(screen_width / 2) - ((WINDOW_WIDTH + (WINDOW_WIDTH - rect.right)) / 2), //EChE
-			(screen_height / 2) - ((WINDOW_HEIGHT + (WINDOW_HEIGHT - rect.bottom)) / 2),//ɎĂ
-			WINDOW_WIDTH + (WINDOW_WIDTH - rect.right),
-			WINDOW_HEIGHT + (WINDOW_HEIGHT - rect.bottom),
-			TRUE);
-	}
-
-	ShowWindow(hwnd, SW_SHOW);
-	UpdateWindow(hwnd);
-
-	D3D12Manager direct_3d(hwnd, WINDOW_WIDTH, WINDOW_HEIGHT);
-
-	while(TRUE){
-		MSG msg{};
-		if(PeekMessage(&msg, NULL, 0, 0, PM_REMOVE)){
-			TranslateMessage(&msg);
-			DispatchMessage(&msg);
-			if(msg.message == WM_QUIT){break;}
-		}
-
-		direct_3d.Render();
-
-	}
-
-	UnregisterClass(WND_CLASS_NAME, NULL); hwnd = NULL;
-
-	return 0;
-}
-
-LRESULT CALLBACK WindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam){
-	switch (uMsg) {
-		case WM_DESTROY:PostQuitMessage(0);	return -1;
-		default:		break;
-	}
-	return DefWindowProc(hwnd, uMsg, wParam, lParam);
-}
+#include <Windows.h>
+#include <tchar.h>
+#include <cstdio>
+#include <cstring>
+#include "D3D12Manager.h"
+#include "TextureCooker.h"
+#include "JobSystem.h"
+#include "ShadowFilter.h"
+
+namespace{
+constexpr int WINDOW_WIDTH  = 640;
+constexpr int WINDOW_HEIGHT = 480;
+constexpr LPSTR WND_CLASS_NAME = _T("DirectX12");
+}
+
+LRESULT CALLBACK WindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam);
+int CookCommand(LPSTR lpCmdLine);
+int PrecompileCommand(LPSTR lpCmdLine);
+
+int WINAPI WinMain(HINSTANCE hInst, HINSTANCE hPrevInst, LPSTR lpCmdLine, int nShowCmd){
+	WNDCLASSEX	wc{};
+	HWND hwnd{};
+
+	//テクスチャのクック(ウインドウは作らない)
+	if(strncmp(lpCmdLine, "-cook", 5) == 0){
+		return CookCommand(lpCmdLine);
+	}
+
+	//シェーダのキャッシュの作成(ビルド時に実行しておくと起動時にコンパイルしない)
+	if(strncmp(lpCmdLine, "-precompile", 11) == 0){
+		return PrecompileCommand(lpCmdLine);
+	}
+
+	wc.cbSize			= sizeof(WNDCLASSEX);
+	wc.style			= CS_HREDRAW | CS_VREDRAW;
+	wc.lpfnWndProc		= WindowProc;
+	wc.cbClsExtra		= 0;
+	wc.cbWndExtra		= 0;
+	wc.hInstance		= hInst;
+	wc.lpszMenuName		= NULL;
+	wc.lpszClassName	= WND_CLASS_NAME;
+	wc.hIcon			= (HICON)LoadImage(NULL, IDI_APPLICATION, IMAGE_ICON, 0, 0, LR_SHARED);
+	wc.hCursor			= LoadCursor(NULL, IDC_ARROW);
+	wc.hIconSm			= (HICON)LoadImage(NULL, IDI_APPLICATION, IMAGE_ICON, 0, 0, LR_SHARED);
+	wc.hbrBackground	= (HBRUSH)GetStockObject(BLACK_BRUSH);
+
+	if(RegisterClassEx(&wc) == 0){ 
+		return -1;
+	}
+
+	hwnd = CreateWindowEx(
+		WS_EX_COMPOSITED,
+		WND_CLASS_NAME,
+		WND_CLASS_NAME,
+		WS_OVERLAPPED | WS_CAPTION | WS_SYSMENU,
+		CW_USEDEFAULT,
+		CW_USEDEFAULT,
+		WINDOW_WIDTH,
+		WINDOW_HEIGHT,
+		NULL,
+		NULL,
+		hInst,
+		NULL);
+
+	{
+		int screen_width  = GetSystemMetrics(SM_CXSCREEN);
+		int screen_height = GetSystemMetrics(SM_CYSCREEN);
+		RECT rect{};
+		GetClientRect(hwnd, &rect);
+		MoveWindow(
+			hwnd,
+			(screen_width / 2) - ((WINDOW_WIDTH + (WINDOW_WIDTH - rect.right)) / 2), //ウインドウを画面
+			(screen_height / 2) - ((WINDOW_HEIGHT + (WINDOW_HEIGHT - rect.bottom)) / 2),//中央に持ってくる
+			WINDOW_WIDTH + (WINDOW_WIDTH - rect.right),
+			WINDOW_HEIGHT + (WINDOW_HEIGHT - rect.bottom),
+			TRUE);
+	}
+
+	ShowWindow(hwnd, SW_SHOW);
+	UpdateWindow(hwnd);
+
+	D3D12Manager direct_3d(hwnd, WINDOW_WIDTH, WINDOW_HEIGHT);
+
+	//DirectX12.exe -instances <球の数>
+	int instance_num = 1;
+	const char *instances = strstr(lpCmdLine, "-instances");
+	if(instances != nullptr){
+		sscanf_s(instances, "-instances %d", &instance_num);
+	}
+	direct_3d.SetSphereInstanceNum(instance_num);
+
+	//DirectX12.exe -streambudget <1フレームに転送するKB数(0なら制限なし)>
+	const char *stream_budget = strstr(lpCmdLine, "-streambudget");
+	if(stream_budget != nullptr){
+		int budget_kb = 0;
+		if(sscanf_s(stream_budget, "-streambudget %d", &budget_kb) == 1 && budget_kb >= 0){
+			direct_3d.SetStreamingBudget(static_cast<UINT64>(budget_kb) * 1024);
+		}
+	}
+
+	//DirectX12.exe -noshadowdebug (シャドウマップのデバッグ表示のパスをフレームグラフから外す)
+	if(strstr(lpCmdLine, "-noshadowdebug") != nullptr){
+		direct_3d.SetShadowMapDebug(false);
+	}
+
+	//DirectX12.exe -pause [plane|sphere] (止めたものはシャドウマップのキャッシュに描き、毎フレームは描き直さない)
+	const char *pause = strstr(lpCmdLine, "-pause");
+	if(pause != nullptr){
+		char target[16]{};
+		sscanf_s(pause, "-pause %15s", target, (unsigned)_countof(target));
+		const bool plane	= (strcmp(target, "sphere") != 0);
+		const bool sphere	= (strcmp(target, "plane") != 0);
+		direct_3d.PauseAnimation(plane, sphere);
+	}
+
+	//DirectX12.exe -shadowfilter hard|pcf|poisson|evsm (シャドウマップのフィルタの段階。指定しなければpcf)
+	const char *shadow_filter = strstr(lpCmdLine, "-shadowfilter ");
+	if(shadow_filter != nullptr){
+		char name[16]{};
+		ShadowFilterTier tier = D3D12Manager::DEFAULT_SHADOW_FILTER;
+		sscanf_s(shadow_filter, "-shadowfilter %15s", name, (unsigned)_countof(name));
+		if(ShadowFilter::ParseTier(name, &tier)){
+			direct_3d.SetShadowFilter(tier);
+		}
+	}
+
+	while(TRUE){
+		MSG msg{};
+		if(PeekMessage(&msg, NULL, 0, 0, PM_REMOVE)){
+			TranslateMessage(&msg);
+			DispatchMessage(&msg);
+			if(msg.message == WM_QUIT){break;}
+		}
+
+		direct_3d.Render();
+
+	}
+
+	UnregisterClass(WND_CLASS_NAME, NULL); hwnd = NULL;
+
+	return 0;
+}
+
+LRESULT CALLBACK WindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam){
+	switch (uMsg) {
+		case WM_DESTROY:PostQuitMessage(0);	return -1;
+		default:		break;
+	}
+	return DefWindowProc(hwnd, uMsg, wParam, lParam);
+}
+
+
+//DirectX12.exe -cook <入力ファイル> <出力ファイル> [bc1|bc3|bgra8]
+int CookCommand(LPSTR lpCmdLine){
+	char src[MAX_PATH]{};
+	char dst[MAX_PATH]{};
+	char format_name[16] = "bc1";
+	if(sscanf_s(lpCmdLine, "-cook %259s %259s %15s", src, (unsigned)_countof(src), dst, (unsigned)_countof(dst), format_name, (unsigned)_countof(format_name)) < 2){
+		return -1;
+	}
+
+	TextureFormat format{};
+	if(_stricmp(format_name, "bc1") == 0){
+		format = TEXTURE_FORMAT_BC1;
+	}else if(_stricmp(format_name, "bc3") == 0){
+		format = TEXTURE_FORMAT_BC3;
+	}else if(_stricmp(format_name, "bgra8") == 0){
+		format = TEXTURE_FORMAT_BGRA8;
+	}else{
+		return -1;
+	}
+
+	JobSystem jobs;
+	return CookTexture(src, dst, format, &jobs) ? 0 : -1;
+}
+
+
+
+
+//DirectX12.exe -precompile [出力ファイル]
+//古いエントリが残らないように、既存のキャッシュは読まずに作り直す
+int PrecompileCommand(LPSTR lpCmdLine){
+	char dst[MAX_PATH]{};
+	if(sscanf_s(lpCmdLine, "-precompile %259s", dst, (unsigned)_countof(dst)) < 1){
+		strcpy_s(dst, SHADER_CACHE_FILE);
+	}
+
+	ShaderCache cache;
+	if(FAILED(PrecompileShaders(&cache))){
+		return -1;
+	}
+
+	return cache.Save(dst) ? 0 : -1;
+}
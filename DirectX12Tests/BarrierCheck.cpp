@@ -0,0 +1,236 @@
+#include <cstdio>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "HeadlessRenderer.h"
+#include "RendererGraph.h"
+#include "ResourceStateTracker.h"
+#include "TestCommon.h"
+
+namespace{
+//ヘッドレスのキューとコマンドリストで見つかったエラーを出力し、その数を返す
+uint64_t ReportBarrierErrors(const char *name, const HeadlessQueue &queue, const HeadlessCommandList *const *lists, int list_num){
+	uint64_t error_num = queue.Stats().error_num;
+	for(const std::string &error : queue.Errors()){
+		PrintLine("[barriercheck] %s: %s\n", name, error.c_str());
+	}
+	for(int i = 0; i < list_num; ++i){
+		for(const std::string &error : lists[i]->Errors()){
+			PrintLine("[barriercheck] %s: %s\n", name, error.c_str());
+		}
+	}
+	return error_num;
+}
+
+//手で書いたバリアの列を1つのリストで実行し、エラーとして検出されるか
+bool IsBarrierSequenceFlagged(const RenderBarrier *barriers, int num){
+	HeadlessQueue queue;
+	queue.SetResourceState(barriers[0].resource, barriers[0].before);
+
+	HeadlessCommandList command_list;
+	command_list.Begin(0);
+	for(int i = 0; i < num; ++i){
+		command_list.ResourceBarriers(1, &barriers[i]);
+	}
+	command_list.End();
+
+	HeadlessCommandList *lists[] = {&command_list};
+	queue.Execute(1, lists);
+	return queue.Stats().error_num > 0;
+}
+}
+
+
+//DirectX12Tests -barriercheck [フレーム数]
+//描画と同じフレームグラフ(EVSMのフィルタを使う宣言で、シャドウマップの描き直しの範囲・キャスターの有無・デバッグ表示で使うパスはフレームごとに切り替える)から求めたバリアと、
+//サブリソースごとの遷移・分割バリアを使うミップの生成をヘッドレスのキューで実行し、不整合がないかを調べる
+//あわせて、遷移の抜け・同じ状態への遷移・開始していない分割バリアの終了などの誤った列が検出されることを確かめる
+int BarrierCheckCommand(const char *command_line){
+	static const int BACK_BUFFER_NUM	= 2;
+	static const uint32_t MIP_NUM		= 6;
+
+	int frame_num = 6;
+	sscanf(command_line, "-barriercheck %d", &frame_num);
+	if(frame_num < 1){
+		return -1;
+	}
+
+	const RenderResource shadow_buffer{1};
+	const RenderResource back_buffers[BACK_BUFFER_NUM] = {{2}, {3}};
+	const RenderResource mip_texture{4};
+	const RenderResource depth_buffer{6};
+	const RenderResource shadow_cache{7};
+	const RenderResource shadow_blur{8};
+	const RenderResource shadow_moments{9};
+
+	ResourceStateTracker tracker;
+	HeadlessQueue queue;
+	for(const RenderResource &depth : {shadow_buffer, shadow_cache, depth_buffer}){
+		tracker.Register(depth, RENDER_STATE_DEPTH_WRITE);
+		queue.SetResourceState(depth, RENDER_STATE_DEPTH_WRITE);
+	}
+	for(const RenderResource &moments : {shadow_blur, shadow_moments}){
+		tracker.Register(moments, RENDER_STATE_RENDER_TARGET);
+		queue.SetResourceState(moments, RENDER_STATE_RENDER_TARGET);
+	}
+	for(const RenderResource &back_buffer : back_buffers){
+		tracker.Register(back_buffer, RENDER_STATE_PRESENT);
+		queue.SetResourceState(back_buffer, RENDER_STATE_PRESENT);
+	}
+	tracker.Register(mip_texture, RENDER_STATE_SHADER_RESOURCE, MIP_NUM);
+	queue.SetResourceState(mip_texture, RENDER_STATE_SHADER_RESOURCE);
+
+	RendererGraphDesc desc{};
+	desc.resources[GRAPH_SCENE_DEPTH]		= depth_buffer;
+	desc.resources[GRAPH_SHADOW_MAP]		= shadow_buffer;
+	desc.resources[GRAPH_SHADOW_CACHE]		= shadow_cache;
+	desc.resources[GRAPH_SHADOW_BLUR]		= shadow_blur;
+	desc.resources[GRAPH_SHADOW_MOMENTS]	= shadow_moments;
+	desc.scene_depth_size		= 2 * 1024 * 1024;
+	desc.scene_depth_alignment	= 64 * 1024;
+	desc.shadow_blur_size		= 3 * 16 * 1024 * 1024;
+	desc.shadow_blur_alignment	= 64 * 1024;
+	desc.evsm					= true;
+	RenderGraph graph;
+	int passes[PASS_NUM];
+	int resources[GRAPH_RESOURCE_NUM];
+	DeclareRendererGraph(&graph, desc, passes, resources);
+
+	const float clear_color[4] = {};
+	HeadlessCommandList pass_lists[PASS_NUM];
+	HeadlessCommandList *lists[PASS_NUM] = {};
+	uint64_t error_num = 0;
+
+	for(int frame = 0; frame < frame_num; ++frame){
+		//シャドウマップはキャッシュごと描き直す・動的なキャスターだけ描き直す・描き直さないの順に切り替える
+		//6フレームごとに、静的・動的なキャスターの両方がある・動的なものだけ・静的なものだけを切り替える
+		static const ShadowCache::Redraw REDRAWS[3] = {ShadowCache::REDRAW_FULL, ShadowCache::REDRAW_DYNAMIC, ShadowCache::REDRAW_NONE};
+		RendererPassState pass_state{};
+		pass_state.redraw				= REDRAWS[frame % 3];
+		pass_state.has_static_caster		= ((frame / 6) % 3 != 1);
+		pass_state.has_dynamic_caster	= ((frame / 6) % 3 != 2);
+		pass_state.evsm					= desc.evsm;
+		pass_state.show_shadow_map		= (frame % 2 == 0);
+		for(int pass = 0; pass < PASS_NUM; ++pass){
+			graph.SetPassEnabled(passes[pass], IsRendererPassEnabled(pass, pass_state));
+		}
+		if(!graph.Compile()){
+			PrintLine("[barriercheck] %s\n", graph.Error().c_str());
+			return 1;
+		}
+		graph.SetResource(resources[GRAPH_BACK_BUFFER], back_buffers[frame % BACK_BUFFER_NUM]);
+		graph.BuildBarriers(&tracker);
+
+		//残ったパスを提出順に記録する
+		const std::vector<int> &order = graph.Order();
+		for(size_t i = 0; i < order.size(); ++i){
+			const std::vector<RenderBarrier> &begin_barriers = graph.BeginBarriers(order[i]);
+			const std::vector<RenderBarrier> &end_barriers = graph.EndBarriers(order[i]);
+			pass_lists[i].Begin(0);
+			if(!begin_barriers.empty()){
+				pass_lists[i].ResourceBarriers(static_cast<int>(begin_barriers.size()), begin_barriers.data());
+			}
+			if(order[i] == passes[PASS_SHADOW_COPY]){
+				pass_lists[i].CopyResource(shadow_buffer, shadow_cache);
+			}
+			if(order[i] == passes[PASS_SHADOW_BLUR_X]){
+				pass_lists[i].ClearRenderTarget(RenderTargetView{shadow_blur.value}, clear_color);
+			}
+			if(!end_barriers.empty()){
+				pass_lists[i].ResourceBarriers(static_cast<int>(end_barriers.size()), end_barriers.data());
+			}
+			pass_lists[i].End();
+			lists[i] = &pass_lists[i];
+		}
+		queue.Execute(static_cast<int>(order.size()), lists);
+		error_num += ReportBarrierErrors("passes", queue, lists, static_cast<int>(order.size()));
+		queue.ResetStats();
+
+		//バックバッファは毎フレームの最後にプレゼントに戻っていること
+		RenderResourceState state{};
+		if(!queue.GetResourceState(back_buffers[frame % BACK_BUFFER_NUM], &state) || state != RENDER_STATE_PRESENT){
+			PrintLine("[barriercheck] passes: back buffer is not returned to present\n");
+			++error_num;
+		}
+	}
+
+	const ResourceStateTracker::Stats pass_stats = tracker.GetStats();
+	PrintLine("[barriercheck] passes    %3d frames  %4llu barriers  %4llu batches  %4llu redundant declarations skipped\n",
+		frame_num, static_cast<unsigned long long>(pass_stats.transition_num), static_cast<unsigned long long>(pass_stats.batch_num),
+		static_cast<unsigned long long>(pass_stats.redundant_num));
+	tracker.ResetStats();
+
+	//ミップの生成: 1つ上のレベルを読みながら次のレベルに書き込む
+	//読み終えたレベルは分割バリアでシェーダリソースに戻し始め、最後にまとめて使うときに終了する
+	//書き込みはレベルごとのビューのクリアで代用する
+	HeadlessCommandList &mip_list = pass_lists[0];
+	lists[0] = &mip_list;
+	mip_list.Begin(0);
+	for(uint32_t level = 1; level < MIP_NUM; ++level){
+		tracker.Use(mip_texture, RENDER_STATE_SHADER_RESOURCE, level - 1);
+		tracker.Use(mip_texture, RENDER_STATE_RENDER_TARGET, level);
+		tracker.Flush(&mip_list);
+		mip_list.ClearRenderTarget(RenderTargetView{level}, clear_color);
+	}
+	tracker.BeginUse(mip_texture, RENDER_STATE_SHADER_RESOURCE, MIP_NUM - 1);
+	tracker.Flush(&mip_list);
+	mip_list.ClearDepth(RenderTargetView{MIP_NUM}, 1.0f);
+	tracker.Use(mip_texture, RENDER_STATE_SHADER_RESOURCE);
+	tracker.Flush(&mip_list);
+	mip_list.End();
+	queue.Execute(1, lists);
+	error_num += ReportBarrierErrors("mips", queue, lists, 1);
+
+	RenderResourceState final_state{};
+	if(!tracker.GetState(mip_texture, RENDER_ALL_SUBRESOURCES, &final_state) || final_state != RENDER_STATE_SHADER_RESOURCE){
+		PrintLine("[barriercheck] mips: levels are not back to shader resource\n");
+		++error_num;
+	}
+
+	const ResourceStateTracker::Stats mip_stats = tracker.GetStats();
+	PrintLine("[barriercheck] mips      %3u levels  %4llu barriers  %4llu batches  %4llu split  %4llu redundant declarations skipped\n",
+		MIP_NUM, static_cast<unsigned long long>(mip_stats.transition_num), static_cast<unsigned long long>(mip_stats.batch_num),
+		static_cast<unsigned long long>(mip_stats.split_num), static_cast<unsigned long long>(mip_stats.redundant_num));
+
+	//誤ったバリアの列はエラーとして検出されること
+	const RenderResource r{5};
+	const RenderBarrier missing[] = {
+		{r, RENDER_ALL_SUBRESOURCES, RENDER_STATE_PRESENT, RENDER_STATE_RENDER_TARGET, RENDER_BARRIER_FULL},
+		{r, RENDER_ALL_SUBRESOURCES, RENDER_STATE_SHADER_RESOURCE, RENDER_STATE_PRESENT, RENDER_BARRIER_FULL},
+	};
+	const RenderBarrier redundant[] = {
+		{r, RENDER_ALL_SUBRESOURCES, RENDER_STATE_PRESENT, RENDER_STATE_PRESENT, RENDER_BARRIER_FULL},
+	};
+	const RenderBarrier unbegun[] = {
+		{r, RENDER_ALL_SUBRESOURCES, RENDER_STATE_PRESENT, RENDER_STATE_RENDER_TARGET, RENDER_BARRIER_END},
+	};
+	const RenderBarrier during_split[] = {
+		{r, RENDER_ALL_SUBRESOURCES, RENDER_STATE_PRESENT, RENDER_STATE_RENDER_TARGET, RENDER_BARRIER_BEGIN},
+		{r, 0, RENDER_STATE_PRESENT, RENDER_STATE_COPY_DEST, RENDER_BARRIER_FULL},
+	};
+	const RenderBarrier subresource[] = {
+		{r, 1, RENDER_STATE_PRESENT, RENDER_STATE_RENDER_TARGET, RENDER_BARRIER_FULL},
+		{r, RENDER_ALL_SUBRESOURCES, RENDER_STATE_PRESENT, RENDER_STATE_SHADER_RESOURCE, RENDER_BARRIER_FULL},
+	};
+	const struct{
+		const char			*name;
+		const RenderBarrier	*barriers;
+		int					num;
+	} bad_sequences[] = {
+		{"missing transition",			missing,		2},
+		{"redundant transition",		redundant,		1},
+		{"end without begin",			unbegun,		1},
+		{"transition during split",		during_split,	2},
+		{"stale subresource state",		subresource,	2},
+	};
+
+	int missed_num = 0;
+	for(const auto &sequence : bad_sequences){
+		const bool flagged = IsBarrierSequenceFlagged(sequence.barriers, sequence.num);
+		PrintLine("[barriercheck] %-24s %s\n", sequence.name, flagged ? "flagged" : "NOT flagged");
+		missed_num += flagged ? 0 : 1;
+	}
+
+	PrintLine("[barriercheck] %llu errors in generated barriers, %d bad sequences missed\n", static_cast<unsigned long long>(error_num), missed_num);
+	return (error_num == 0 && missed_num == 0) ? 0 : 1;
+}
@@ -0,0 +1,247 @@
+#include <cstdio>
+#include <cstdint>
+#include <cmath>
+#include <algorithm>
+#include "ShadowCascades.h"
+#include "TestCommon.h"
+
+//DirectX12Tests -csmcheck [カメラの数]
+//乱数のカメラ・ライト・シーンの範囲でShadowCascadesの分割と行列を確かめる
+//・分割の両端がnearと影を描く距離で単調に増え、lambdaが0なら均等・1なら等比、その間なら両者の間になる
+//・区間の視錐台(シーンの範囲を設定したらその中)の点がカスケードのxyの[-1, 1]・zの[0, 1]に収まり、シーンの点がライト側で切られない
+//・カメラを平行移動してもカスケードの幅と、ワールドの点のテクセル上の位置の端数が変わらない(影の縁が揺れない)
+//・カメラを回してもカスケードの幅が変わらない
+//最後にアプリのカメラ・ライトでのカスケードごとのテクセルの大きさを、以前の1枚のシャドウマップと比べて表示する
+int CascadeCheckCommand(const char *command_line){
+	typedef ShadowCascades::Camera Camera;
+	static constexpr float PI = 3.14159265358979323846f;
+	static constexpr int POINT_NUM = 64;	//カスケードごとに調べる点の数
+
+	int case_num = 2000;
+	sscanf(command_line, "-csmcheck %d", &case_num);
+	if(case_num < 1){
+		return -1;
+	}
+
+	Checker checker("csmcheck");
+
+	TestRandom random(2468013u);
+
+
+	//分割
+	bool split_ends = true;
+	bool split_increasing = true;
+	bool split_uniform = true;
+	bool split_log = true;
+	bool split_between = true;
+	for(int i = 0; i < case_num; ++i){
+		const int num = 1 + i % ShadowCascades::MAX_CASCADE_NUM;
+		const float near_z = random.Uniform(0.05f, 2.0f);
+		const float far_z = near_z * random.Uniform(2.0f, 1000.0f);
+		const float lambda = random.Uniform(0.0f, 1.0f);
+		float splits[ShadowCascades::MAX_CASCADE_NUM + 1];
+		float uniform_splits[ShadowCascades::MAX_CASCADE_NUM + 1];
+		float log_splits[ShadowCascades::MAX_CASCADE_NUM + 1];
+		ShadowCascades::ComputeSplits(near_z, far_z, num, lambda, splits);
+		ShadowCascades::ComputeSplits(near_z, far_z, num, 0.0f, uniform_splits);
+		ShadowCascades::ComputeSplits(near_z, far_z, num, 1.0f, log_splits);
+
+		split_ends = split_ends && splits[0] == near_z && splits[num] == far_z;
+		for(int s = 0; s < num; ++s){
+			split_increasing = split_increasing && splits[s] < splits[s + 1];
+			split_uniform = split_uniform && std::fabs((uniform_splits[s + 1] - uniform_splits[s]) - (far_z - near_z) / num) <= 1.0e-4f * far_z;
+			split_log = split_log && std::fabs(log_splits[s + 1] / log_splits[s] - std::pow(far_z / near_z, 1.0f / num)) <= 1.0e-3f * std::pow(far_z / near_z, 1.0f / num);
+		}
+		for(int s = 1; s < num; ++s){
+			const float eps = 1.0e-5f * far_z;
+			split_between = split_between && splits[s] >= log_splits[s] - eps && splits[s] <= uniform_splits[s] + eps;
+		}
+	}
+	checker.Check("splits start at near and end at the shadow distance", split_ends);
+	checker.Check("splits increase", split_increasing);
+	checker.Check("lambda 0 splits uniformly", split_uniform);
+	checker.Check("lambda 1 splits logarithmically", split_log);
+	checker.Check("practical splits lie between log and uniform", split_between);
+
+
+	//カスケードの行列
+	auto random_camera = [&random](Camera *camera){
+		float dir[3];
+		do{
+			dir[0] = random.Uniform(-1.0f, 1.0f);
+			dir[1] = random.Uniform(-0.9f, 0.9f);
+			dir[2] = random.Uniform(-1.0f, 1.0f);
+		}while(dir[0] * dir[0] + dir[2] * dir[2] < 0.1f);
+		for(int k = 0; k < 3; ++k){
+			camera->eye[k] = random.Uniform(-10.0f, 10.0f);
+			camera->focus[k] = camera->eye[k] + dir[k];
+			camera->up[k] = (k == 1) ? 1.0f : 0.0f;
+		}
+		camera->fov_y	= random.Uniform(30.0f, 90.0f) * PI / 180.0f;
+		camera->aspect	= random.Uniform(1.0f, 2.0f);
+		camera->near_z	= random.Uniform(0.1f, 1.0f);
+		camera->far_z	= random.Uniform(20.0f, 200.0f);
+	};
+	auto random_point = [&random](const float corners[8][3], float p[3]){
+		const float w[3] = {random.Uniform(0.0f, 1.0f), random.Uniform(0.0f, 1.0f), random.Uniform(0.0f, 1.0f)};
+		for(int k = 0; k < 3; ++k){
+			const float n = (corners[0][k] * (1.0f - w[0]) + corners[1][k] * w[0]) * (1.0f - w[1]) + (corners[2][k] * (1.0f - w[0]) + corners[3][k] * w[0]) * w[1];
+			const float f = (corners[4][k] * (1.0f - w[0]) + corners[5][k] * w[0]) * (1.0f - w[1]) + (corners[6][k] * (1.0f - w[0]) + corners[7][k] * w[0]) * w[1];
+			p[k] = n * (1.0f - w[2]) + f * w[2];
+		}
+	};
+	auto inside = [](const float v[4], float eps){
+		return v[0] >= -1.0f - eps && v[0] <= 1.0f + eps && v[1] >= -1.0f - eps && v[1] <= 1.0f + eps && v[2] >= -eps && v[2] <= 1.0f + eps;
+	};
+	auto texel_fraction = [](const ShadowCascades &cascades, int c, const float p[3]){
+		float v[4];
+		cascades.GetCascade(c).view_proj.TransformPoint(p, v);
+		const float u = (v[0] * 0.5f + 0.5f) * cascades.Resolution();
+		return u - std::floor(u);
+	};
+
+	int coverage_miss_num = 0;
+	int caster_clip_num = 0;
+	int select_miss_num = 0;
+	int translate_width_num = 0;
+	int translate_shimmer_num = 0;
+	int rotate_width_num = 0;
+	uint64_t point_num = 0;
+	for(int i = 0; i < case_num; ++i){
+		const bool scene_bounds = (i % 2) == 1;
+		ShadowCascades cascades;
+		cascades.Initialize(2 + i % (ShadowCascades::MAX_CASCADE_NUM - 1), (i % 3 == 0) ? 2048 : 1024, random.Uniform(0.0f, 1.0f));
+
+		float scene_min[3];
+		float scene_max[3];
+		for(int k = 0; k < 3; ++k){
+			scene_min[k] = random.Uniform(-30.0f, 0.0f);
+			scene_max[k] = random.Uniform(0.0f, 30.0f);
+		}
+		if(scene_bounds){
+			cascades.SetSceneBounds(scene_min, scene_max);
+		}
+
+		Camera camera;
+		random_camera(&camera);
+		float light_dir[3];
+		do{
+			for(int k = 0; k < 3; ++k){
+				light_dir[k] = random.Uniform(-1.0f, 1.0f);
+			}
+		}while(light_dir[0] * light_dir[0] + light_dir[1] * light_dir[1] + light_dir[2] * light_dir[2] < 0.1f);
+		const float shadow_distance = random.Uniform(0.0f, 1.0f) < 0.5f ? 0.0f : camera.far_z * random.Uniform(0.2f, 1.0f);
+		cascades.Update(camera, light_dir, shadow_distance);
+
+		//区間の点が収まる(シーンの範囲を設定したら、その中の点だけを調べる)
+		for(int c = 0; c < cascades.CascadeNum(); ++c){
+			const ShadowCascades::Cascade &cascade = cascades.GetCascade(c);
+			float corners[8][3];
+			ShadowCascades::FrustumCorners(camera, cascade.split_near, cascade.split_far, corners);
+			const float eps = 2.0f / cascades.Resolution();
+			for(int j = 0; j < POINT_NUM; ++j){
+				float p[3];
+				random_point(corners, p);
+				if(scene_bounds && (p[0] < scene_min[0] || p[1] < scene_min[1] || p[2] < scene_min[2] || p[0] > scene_max[0] || p[1] > scene_max[1] || p[2] > scene_max[2])){
+					continue;
+				}
+				float v[4];
+				cascade.view_proj.TransformPoint(p, v);
+				coverage_miss_num += inside(v, eps) ? 0 : 1;
+				++point_num;
+
+				//ビュー空間の奥行きでこのカスケードが選ばれる
+				float view[4];
+				ShadowCascades::Matrix::LookAtLH(camera.eye, camera.focus, camera.up).TransformPoint(p, view);
+				const int selected = cascades.Select(view[2]);
+				const float tolerance = 1.0e-4f * cascade.split_far;
+				const bool on_split = std::fabs(view[2] - cascade.split_near) <= tolerance || std::fabs(view[2] - cascade.split_far) <= tolerance;
+				select_miss_num += (selected == c || on_split) ? 0 : 1;
+			}
+
+			//シーンの点はライト側で切られない
+			if(scene_bounds){
+				for(int j = 0; j < 8; ++j){
+					const float p[3] = {(j & 1) ? scene_max[0] : scene_min[0], (j & 2) ? scene_max[1] : scene_min[1], (j & 4) ? scene_max[2] : scene_min[2]};
+					float v[4];
+					cascade.view_proj.TransformPoint(p, v);
+					caster_clip_num += (v[2] >= -1.0e-4f) ? 0 : 1;
+				}
+			}
+		}
+
+		//平行移動: 幅とテクセル上の端数が変わらない
+		float probe[3];
+		for(int k = 0; k < 3; ++k){
+			probe[k] = camera.focus[k] + random.Uniform(-2.0f, 2.0f);
+		}
+		float widths[ShadowCascades::MAX_CASCADE_NUM];
+		float fractions[ShadowCascades::MAX_CASCADE_NUM];
+		for(int c = 0; c < cascades.CascadeNum(); ++c){
+			widths[c] = cascades.GetCascade(c).width;
+			fractions[c] = texel_fraction(cascades, c, probe);
+		}
+		Camera moved = camera;
+		for(int k = 0; k < 3; ++k){
+			const float d = random.Uniform(-0.5f, 0.5f);
+			moved.eye[k] += d;
+			moved.focus[k] += d;
+		}
+		cascades.Update(moved, light_dir, shadow_distance);
+		for(int c = 0; c < cascades.CascadeNum(); ++c){
+			translate_width_num += (std::fabs(cascades.GetCascade(c).width - widths[c]) <= 1.0e-5f * widths[c]) ? 0 : 1;
+			const float diff = std::fabs(texel_fraction(cascades, c, probe) - fractions[c]);
+			translate_shimmer_num += (std::min(diff, 1.0f - diff) <= 0.02f) ? 0 : 1;
+		}
+
+		//回転: 幅が変わらない
+		Camera turned = camera;
+		const float yaw = random.Uniform(-PI, PI);
+		const float dx = camera.focus[0] - camera.eye[0];
+		const float dz = camera.focus[2] - camera.eye[2];
+		turned.focus[0] = camera.eye[0] + dx * std::cos(yaw) - dz * std::sin(yaw);
+		turned.focus[2] = camera.eye[2] + dx * std::sin(yaw) + dz * std::cos(yaw);
+		cascades.Update(turned, light_dir, shadow_distance);
+		for(int c = 0; c < cascades.CascadeNum(); ++c){
+			rotate_width_num += (std::fabs(cascades.GetCascade(c).width - widths[c]) <= 1.0e-4f * widths[c]) ? 0 : 1;
+		}
+	}
+
+	char name[96];
+	snprintf(name, sizeof(name), "%llu frustum points inside their cascade", static_cast<unsigned long long>(point_num));
+	checker.Check(name, coverage_miss_num == 0);
+	checker.Check("scene casters are not clipped toward the light", caster_clip_num == 0);
+	checker.Check("points select the cascade whose split contains them", select_miss_num == 0);
+	checker.Check("camera translation keeps the cascade width", translate_width_num == 0);
+	checker.Check("camera translation moves by whole texels", translate_shimmer_num == 0);
+	checker.Check("camera rotation keeps the cascade width", rotate_width_num == 0);
+
+
+	//アプリの設定(D3D12Managerの定数と、CreateLightBufferのカメラ・ライト)
+	{
+		static constexpr int CASCADE_NUM = 3;
+		static constexpr int SHADOW_MAP_SIZE = 1024;
+		static constexpr float SHADOW_DISTANCE = 12.0f;
+		const float scene_min[3] = {-4.5f, -3.0f, -4.5f};
+		const float scene_max[3] = {4.5f, 3.0f, 4.5f};
+		const float light_dir[3] = {2.0f, 6.5f, -1.0f};
+		const Camera camera = {{1.0f, 1.0f, -6.0f}, {0.0f, 0.0f, 0.0f}, {0.0f, 1.0f, 0.0f}, 60.0f * PI / 180.0f, 640.0f / 480.0f, 1.0f, 20.0f};
+
+		ShadowCascades cascades;
+		cascades.Initialize(CASCADE_NUM, SHADOW_MAP_SIZE);
+		cascades.SetSceneBounds(scene_min, scene_max);
+		cascades.Update(camera, light_dir, SHADOW_DISTANCE);
+
+		//以前のシャドウマップ(ライトの位置から原点へ45度の透視投影)の原点でのテクセルの大きさ
+		const float light_distance = std::sqrt(light_dir[0] * light_dir[0] + light_dir[1] * light_dir[1] + light_dir[2] * light_dir[2]);
+		PrintLine("[csmcheck] single %dx%d perspective map: texel %.2f mm at the origin\n",
+			SHADOW_MAP_SIZE, SHADOW_MAP_SIZE, 1000.0f * 2.0f * std::tan(22.5f * PI / 180.0f) * light_distance / SHADOW_MAP_SIZE);
+		for(int c = 0; c < cascades.CascadeNum(); ++c){
+			const ShadowCascades::Cascade &cascade = cascades.GetCascade(c);
+			PrintLine("[csmcheck] cascade %d: depth %5.2f - %5.2f  width %5.2f  texel %.2f mm\n",
+				c, cascade.split_near, cascade.split_far, cascade.width, 1000.0f * cascade.texel_size);
+		}
+	}
+
+	return checker.Result();
+}
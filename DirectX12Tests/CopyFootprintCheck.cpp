@@ -0,0 +1,340 @@
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <deque>
+#include <iterator>
+#include <vector>
+#include "CopyFootprint.h"
+#include "RingAllocator.h"
+#include "TestCommon.h"
+
+namespace{
+static constexpr unsigned char PADDING = 0xcd;	//書き込まれてはいけない詰め物の値
+
+//GetCopyableFootprintsの規則をそのまま書いたもの(ブロック単位で数え、行は256・サブリソースは512バイトに揃える)
+struct ReferenceLayout{
+	int			width;
+	int			height;
+	uint32_t	row_size;
+	uint32_t	row_pitch;
+	int			row_num;
+};
+
+ReferenceLayout GetReferenceLayout(TextureFormat format, int width, int height, int level){
+	const bool bc = (format == TEXTURE_FORMAT_BC1 || format == TEXTURE_FORMAT_BC3);
+	const int block = bc ? 4 : 1;
+	const uint32_t block_bytes = (format == TEXTURE_FORMAT_BC1) ? 8 : (format == TEXTURE_FORMAT_BC3) ? 16 : 4;
+	const int w = std::max(1, width >> level);
+	const int h = std::max(1, height >> level);
+	const int blocks_x = (w + block - 1) / block;
+	const int blocks_y = (h + block - 1) / block;
+
+	ReferenceLayout layout{};
+	layout.width		= blocks_x * block;
+	layout.height		= blocks_y * block;
+	layout.row_size		= blocks_x * block_bytes;
+	layout.row_pitch	= (layout.row_size + 255) / 256 * 256;
+	layout.row_num		= blocks_y;
+	return layout;
+}
+
+bool SameLayout(const CopyFootprint &fp, const ReferenceLayout &ref){
+	return fp.width == ref.width && fp.height == ref.height && fp.row_size == ref.row_size && fp.row_pitch == ref.row_pitch && fp.row_num == ref.row_num;
+}
+
+int GetLevelNum(int width, int height){
+	int num = 1;
+	while((width >> num) > 0 || (height >> num) > 0){
+		++num;
+	}
+	return num;
+}
+
+//footprintの最後の行の終わり
+uint64_t FootprintEnd(const CopyFootprint &fp){
+	return fp.offset + static_cast<uint64_t>(fp.row_pitch) * (fp.row_num - 1) + fp.row_size;
+}
+
+std::vector<unsigned char> MakePixels(size_t size, uint32_t seed){
+	std::vector<unsigned char> pixels(size);
+	TestRandom random(seed);
+	for(unsigned char &p : pixels){
+		p = static_cast<unsigned char>(random.Next() >> 16);
+	}
+	return pixels;
+}
+
+//バッファのfootprintの行がsrcの行と一致し、最後の行の後ろ(limitまで)を書き換えていないか
+//行の間の詰め物はGPUが読まないので、間隔が同じ場合はまとめて書き込んでよい
+bool CheckRows(const CopyFootprint &fp, const unsigned char *buffer, const unsigned char *src, size_t src_pitch, uint64_t limit){
+	for(int y = 0; y < fp.row_num; ++y){
+		if(memcmp(buffer + fp.offset + static_cast<size_t>(fp.row_pitch) * y, src + src_pitch * y, fp.row_size) != 0){
+			return false;
+		}
+	}
+	for(uint64_t i = FootprintEnd(fp); i < limit; ++i){
+		if(buffer[i] != PADDING){
+			return false;
+		}
+	}
+	return true;
+}
+}
+
+
+//DirectX12Tests -footprintcheck [回数]
+//CopyFootprintのレイアウトとステージングのリングへの書き込みを確かめる
+//・幅が256バイトの倍数にならないもの・BC1/BC3(4x4に満たない小さなミップを含む)のレイアウトがGetCopyableFootprintsの規則と一致する
+//・ミップのチェーンはサブリソースが512バイトに揃い、重ならずに並ぶ。返すサイズは最後の行の詰め物を含まない
+//・行を分けて書き込んでも、まとめて書き込んだ場合と同じ内容になり、最後の行より後ろを書き換えない
+//・CopyUploaderと同じ手順でリングに行を分けて書き込み、GPUが遅れて読む(コピーする)場合に、回り込んでも読む前の領域を上書きしない
+int CopyFootprintCheckCommand(const char *command_line){
+	static const TextureFormat formats[] = {TEXTURE_FORMAT_BGRA8, TEXTURE_FORMAT_BC1, TEXTURE_FORMAT_BC3};
+	static const char *format_names[] = {"BGRA8", "BC1", "BC3"};
+
+	int loop_num = 200;
+	sscanf(command_line, "-footprintcheck %d", &loop_num);
+	if(loop_num < 1){
+		return -1;
+	}
+
+	Checker checker("footprintcheck");
+
+	TestRandom random(24681u);
+	char name[96];
+
+
+	//決まった値
+	{
+		CopyFootprint fp{};
+		CalcCopyFootprints(TEXTURE_FORMAT_BGRA8, 100, 64, 0, 1, 0, &fp);
+		checker.Check("BGRA8 100 pixels pads 400 bytes to a 512-byte pitch", fp.row_size == 400 && fp.row_pitch == 512 && fp.row_num == 64);
+
+		CopyFootprint chain[9]{};
+		const uint64_t total = CalcCopyFootprints(TEXTURE_FORMAT_BC1, 256, 256, 0, 9, 0, chain);
+		checker.Check("BC1 256x256 chain matches GetCopyableFootprints", total == 49672 && chain[6].offset == 48640 && chain[7].offset == 49152 && chain[8].offset == 49664);
+		checker.Check("BC1 1x1 mip is one 4x4 block", chain[8].width == 4 && chain[8].height == 4 && chain[8].row_size == 8 && chain[8].row_pitch == 256 && chain[8].row_num == 1);
+
+		CalcCopyFootprints(TEXTURE_FORMAT_BC3, 6, 2, 0, 1, 0, &fp);
+		checker.Check("BC3 6x2 rounds up to 8x4", fp.width == 8 && fp.height == 4 && fp.row_size == 32 && fp.row_num == 1);
+	}
+
+
+	//1つのレベルのレイアウト
+	for(int f = 0; f < static_cast<int>(std::size(formats)); ++f){
+		static const int heights[] = {1, 2, 3, 4, 5, 7, 64, 65};
+		bool same = true;
+		for(int width = 1; width <= 300; ++width){
+			for(int height : heights){
+				CopyFootprint fp{};
+				const uint64_t size = CalcCopyFootprints(formats[f], width, height, 0, 1, 0, &fp);
+				same = same && SameLayout(fp, GetReferenceLayout(formats[f], width, height, 0)) && fp.offset == 0 && size == FootprintEnd(fp);
+			}
+		}
+		snprintf(name, sizeof(name), "%s widths 1-300 match the reference layout", format_names[f]);
+		checker.Check(name, same);
+	}
+
+	//ミップのチェーン
+	{
+		static const int sizes[][2] = {{1, 1}, {3, 3}, {5, 5}, {257, 3}, {3, 257}, {1000, 600}, {1024, 1024}, {4096, 8}};
+		static const uint64_t base_offsets[] = {0, 512 * 7, 100};
+		bool same = true;
+		bool placed = true;
+		bool total = true;
+		bool subrange = true;
+		for(const TextureFormat format : formats){
+			for(const auto &size : sizes){
+				const int level_num = GetLevelNum(size[0], size[1]);
+				for(const uint64_t base : base_offsets){
+					std::vector<CopyFootprint> chain(level_num);
+					const uint64_t bytes = CalcCopyFootprints(format, size[0], size[1], 0, level_num, base, chain.data());
+					for(int level = 0; level < level_num; ++level){
+						const CopyFootprint &fp = chain[level];
+						same = same && SameLayout(fp, GetReferenceLayout(format, size[0], size[1], level));
+						placed = placed && (fp.offset % CopyFootprint::PLACEMENT_ALIGNMENT == 0) && fp.offset >= base;
+						placed = placed && (level == 0 || fp.offset >= chain[level - 1].offset + static_cast<uint64_t>(chain[level - 1].row_pitch) * chain[level - 1].row_num);
+					}
+					total = total && (bytes == FootprintEnd(chain.back()) - base);
+
+					//途中のレベルから求めても同じ大きさになる
+					for(int first = 1; first < level_num; ++first){
+						std::vector<CopyFootprint> tail(level_num - first);
+						CalcCopyFootprints(format, size[0], size[1], first, level_num - first, base, tail.data());
+						subrange = subrange && SameLayout(tail[0], GetReferenceLayout(format, size[0], size[1], first))
+							&& (tail[0].offset == (base + CopyFootprint::PLACEMENT_ALIGNMENT - 1) / CopyFootprint::PLACEMENT_ALIGNMENT * CopyFootprint::PLACEMENT_ALIGNMENT);
+					}
+				}
+			}
+		}
+		checker.Check("every mip matches the reference layout", same);
+		checker.Check("subresources are 512-byte aligned and disjoint", placed);
+		checker.Check("total size excludes the last row padding", total);
+		checker.Check("chains starting at a later level match", subrange);
+	}
+
+
+	//行を分けた書き込み
+	{
+		bool sliced = true;
+		bool whole = true;
+		for(int loop = 0; loop < loop_num; ++loop){
+			const TextureFormat format = formats[loop % std::size(formats)];
+			const int width = 1 + random.Next() % 700;
+			const int height = 1 + random.Next() % 90;
+
+			CopyFootprint fp{};
+			CalcCopyFootprints(format, width, height, 0, 1, 0, &fp);
+			const size_t src_pitch = fp.row_size + ((loop % 2 == 0) ? 0 : 4 * (random.Next() % 16));	//半分は間隔を詰めない
+			const std::vector<unsigned char> src = MakePixels(src_pitch * fp.row_num, loop);
+
+			//まとめて書き込む(間隔が同じなら1回のコピーになる)
+			std::vector<unsigned char> buffer(static_cast<size_t>(fp.row_pitch) * fp.row_num, PADDING);
+			CopyFootprintRows(fp, src.data(), src_pitch, buffer.data());
+			whole = whole && CheckRows(fp, buffer.data(), src.data(), src_pitch, buffer.size());
+
+			const std::vector<unsigned char> pitched = buffer;
+			std::vector<unsigned char> copy(buffer.size() + CopyFootprint::PLACEMENT_ALIGNMENT, PADDING);
+			CopyFootprintRows(fp, pitched.data(), fp.row_pitch, copy.data());
+			whole = whole && CheckRows(fp, copy.data(), src.data(), src_pitch, copy.size());
+
+			//行を分け、それぞれ512バイトに揃えて並べる
+			std::vector<unsigned char> slices(buffer.size() + CopyFootprint::PLACEMENT_ALIGNMENT * (fp.row_num + 1), PADDING);
+			uint64_t offset = 0;
+			for(int row = 0; row < fp.row_num;){
+				CopyFootprint slice = SliceCopyFootprint(format, fp, row, 1 + random.Next() % 8);
+				sliced = sliced && slice.row_num > 0 && slice.height == slice.row_num * GetTextureBlockDim(format) && slice.row_pitch == fp.row_pitch;
+				slice.offset = offset;
+				CopyFootprintRows(slice, src.data() + src_pitch * row, src_pitch, slices.data());
+				sliced = sliced && CheckRows(slice, slices.data(), src.data() + src_pitch * row, src_pitch, slices.size());
+				offset = (FootprintEnd(slice) + CopyFootprint::PLACEMENT_ALIGNMENT - 1) / CopyFootprint::PLACEMENT_ALIGNMENT * CopyFootprint::PLACEMENT_ALIGNMENT;
+				row += slice.row_num;
+			}
+
+			const CopyFootprint empty = SliceCopyFootprint(format, fp, fp.row_num, 4);
+			sliced = sliced && empty.row_num == 0;
+		}
+		checker.Check("whole level copies stop at the last row", whole);
+		checker.Check("sliced copies match the source rows", sliced);
+	}
+
+
+	//ステージングのリングを回り込ませる
+	{
+		static constexpr uint64_t STAGING_SIZE = 64 * 1024;
+		static constexpr int COPIES_PER_FRAME = 3;
+		static constexpr uint64_t LATENCY = 2;	//GPUがコピーを終えるまでのフレーム数
+
+		struct Texture{
+			TextureFormat				format;
+			CopyFootprint				footprint;
+			std::vector<unsigned char>	src;
+			std::vector<unsigned char>	dst;
+		};
+		struct Copy{
+			uint64_t		fence_value;
+			CopyFootprint	slice;
+			int				texture;
+			int				first_row;
+		};
+
+		std::vector<unsigned char> staging(STAGING_SIZE, PADDING);
+		RingAllocator ring(STAGING_SIZE);
+		std::deque<Copy> copies;
+		uint64_t fence_value = 0;
+		int frame_copy_num = 0;
+		int stall_num = 0;
+		int wrap_num = 0;
+		bool overlapped = false;
+
+		//GPUのコピー(ステージングのfootprintからテクスチャの行へ)
+		std::vector<Texture> textures;
+		auto complete = [&](uint64_t completed){
+			while(!copies.empty() && copies.front().fence_value <= completed){
+				const Copy &c = copies.front();
+				Texture &t = textures[c.texture];
+				for(int y = 0; y < c.slice.row_num; ++y){
+					memcpy(t.dst.data() + static_cast<size_t>(t.footprint.row_size) * (c.first_row + y),
+						staging.data() + c.slice.offset + static_cast<size_t>(c.slice.row_pitch) * y, c.slice.row_size);
+				}
+				copies.pop_front();
+			}
+			ring.ReleaseCompletedFrames(completed);
+		};
+		auto finish_frame = [&]{
+			ring.FinishFrame(++fence_value);
+			frame_copy_num = 0;
+			if(fence_value > LATENCY){
+				complete(fence_value - LATENCY);
+			}
+		};
+
+		for(int loop = 0; loop < loop_num; ++loop){
+			Texture t;
+			t.format = formats[random.Next() % std::size(formats)];
+			CalcCopyFootprints(t.format, 1 + random.Next() % 1000, 1 + random.Next() % 40, 0, 1, 0, &t.footprint);
+			t.src = MakePixels(static_cast<size_t>(t.footprint.row_size) * t.footprint.row_num, 1000 + loop);
+			t.dst.assign(t.src.size(), 0);
+			textures.push_back(std::move(t));
+		}
+
+		for(int index = 0; index < static_cast<int>(textures.size()); ++index){
+			const Texture &t = textures[index];
+			const CopyFootprint &fp = t.footprint;
+			const int rows_per_copy = static_cast<int>(std::min<uint64_t>(STAGING_SIZE / fp.row_pitch, fp.row_num));
+			const int max_rows = std::min(rows_per_copy, 4);	//ストリーミングと同じく少しずつ転送する
+			for(int row = 0; row < fp.row_num;){
+				CopyFootprint slice = SliceCopyFootprint(t.format, fp, row, 1 + random.Next(max_rows));
+				const uint64_t size = static_cast<uint64_t>(slice.row_pitch) * (slice.row_num - 1) + slice.row_size;
+
+				//一杯なら全ての完了を待って空にする(CopyUploader::Allocateと同じ)
+				const uint64_t head = ring.Head();
+				slice.offset = ring.Allocate(size, CopyFootprint::PLACEMENT_ALIGNMENT);
+				if(slice.offset == RingAllocator::INVALID_OFFSET){
+					++stall_num;
+					if(frame_copy_num > 0){
+						ring.FinishFrame(++fence_value);
+						frame_copy_num = 0;
+					}
+					complete(fence_value);
+					slice.offset = ring.Allocate(size, CopyFootprint::PLACEMENT_ALIGNMENT);
+				}else{
+					wrap_num += (slice.offset < head) ? 1 : 0;
+				}
+				if(slice.offset == RingAllocator::INVALID_OFFSET){
+					overlapped = true;
+					break;
+				}
+
+				//GPUがまだ読んでいない領域と重ならないこと
+				for(const Copy &c : copies){
+					overlapped = overlapped || (slice.offset < FootprintEnd(c.slice) && c.slice.offset < slice.offset + size);
+				}
+
+				CopyFootprintRows(slice, t.src.data() + static_cast<size_t>(fp.row_size) * row, fp.row_size, staging.data());
+				copies.push_back({fence_value + 1, slice, index, row});
+				row += slice.row_num;
+
+				if(++frame_copy_num == COPIES_PER_FRAME){
+					finish_frame();
+				}
+			}
+		}
+		if(frame_copy_num > 0){
+			ring.FinishFrame(++fence_value);
+		}
+		complete(fence_value);
+
+		bool same = true;
+		for(const Texture &t : textures){
+			same = same && (t.dst == t.src);
+		}
+		snprintf(name, sizeof(name), "%d textures survive %d wraps and %d stalls", loop_num, wrap_num, stall_num);
+		checker.Check(name, same && !overlapped);
+		checker.Check("staging ring wrapped", wrap_num > 0);
+		checker.Check("staging ring is empty after the last fence", ring.IsEmpty() && copies.empty());
+	}
+
+	return checker.Result();
+}
@@ -0,0 +1,258 @@
+#include <cstdio>
+#include <cstdint>
+#include <chrono>
+#include <cmath>
+#include <algorithm>
+#include <vector>
+#include "FrustumCuller.h"
+#include "ShadowCascades.h"
+#include "TestCommon.h"
+
+namespace{
+//点が行列の視錐台(クリップ座標のxyが[-w, w]、zが[0, w])の中にある
+bool InsideViewProj(const ShadowCascades::Matrix &view_proj, const float p[3]){
+	float v[4];
+	view_proj.TransformPoint(p, v);
+	return v[3] > 0.0f && std::fabs(v[0]) <= v[3] && std::fabs(v[1]) <= v[3] && v[2] >= 0.0f && v[2] <= v[3];
+}
+}
+
+
+//DirectX12Tests -cullbench [オブジェクトの数]
+//乱数で置いた球と箱を、アプリと同じカメラとシャドウマップのカスケード(3枚)の視錐台でカリングして次のことを確かめる
+//・SIMDで調べた結果が1個ずつ調べる参照実装と一致し、端数のグループの余りを含まない
+//・外と判定したものは中の点(中心・箱の角・乱数の点)が全て視錐台の外にある
+//・決まった位置の球(中央・カメラの後ろ・手前の面をまたぐもの・奥の面より先・横の面のすぐ外と内)の判定
+//・カメラの視錐台の外でもライトとの間にあるものはカスケードの列に残る
+//あわせて、視錐台が1つ(カメラ)と4つ(カメラとカスケード)の場合の参照実装とSIMDの所要時間を表示する
+int CullBenchmarkCommand(const char *command_line){
+	typedef ShadowCascades::Camera Camera;
+	typedef FrustumCuller::Frustum Frustum;
+	static constexpr float PI		= 3.14159265358979323846f;
+	static const int CASCADE_NUM	= 3;
+	static const int VIEW_NUM		= 1 + CASCADE_NUM;
+	static const int REPEAT_NUM		= 5;		//所要時間は最も速かったものを使う
+	static const int SAMPLE_NUM		= 16;		//外と判定したものごとに調べる乱数の点の数
+	static const int MAX_SAMPLED	= 200000;	//中の点を調べるオブジェクトの数の上限
+	static const float SCENE_SIZE	= 15.0f;
+
+	int object_num = 1000000;
+	sscanf(command_line, "-cullbench %d", &object_num);
+	if(object_num < 1){
+		return -1;
+	}
+
+	Checker checker("cullbench");
+
+	TestRandom random(97531u);
+
+
+	//アプリと同じカメラ・ライト・影を描く距離(シーンの範囲だけ広げる)
+	const Camera camera = {{1.0f, 1.0f, -6.0f}, {0.0f, 0.0f, 0.0f}, {0.0f, 1.0f, 0.0f}, 60.0f * PI / 180.0f, 640.0f / 480.0f, 1.0f, 20.0f};
+	const float light_length = std::sqrt(2.0f * 2.0f + 6.5f * 6.5f + 1.0f * 1.0f);
+	const float light_dir[3] = {2.0f / light_length, 6.5f / light_length, -1.0f / light_length};
+	const float scene_min[3] = {-SCENE_SIZE, -SCENE_SIZE, -SCENE_SIZE};
+	const float scene_max[3] = {SCENE_SIZE, SCENE_SIZE, SCENE_SIZE};
+
+	ShadowCascades cascades;
+	cascades.Initialize(CASCADE_NUM, 1024);
+	cascades.SetSceneBounds(scene_min, scene_max);
+	cascades.Update(camera, light_dir, 12.0f);
+
+	ShadowCascades::Matrix view_projs[VIEW_NUM];
+	view_projs[0] = ShadowCascades::Matrix::LookAtLH(camera.eye, camera.focus, camera.up) * ShadowCascades::Matrix::PerspectiveFovLH(camera.fov_y, camera.aspect, camera.near_z, camera.far_z);
+	for(int c = 0; c < CASCADE_NUM; ++c){
+		view_projs[1 + c] = cascades.GetCascade(c).view_proj;
+	}
+	Frustum frustums[VIEW_NUM];
+	for(int v = 0; v < VIEW_NUM; ++v){
+		frustums[v] = Frustum::FromMatrix(view_projs[v].m);
+	}
+
+
+	//乱数のシーン(半分は球、半分は箱)。端数のグループができるように数は8の倍数からずらす
+	const int num = (object_num % FrustumCuller::SIMD_WIDTH == 0) ? object_num + 3 : object_num;
+	std::vector<float> centers(static_cast<size_t>(num) * 3);
+	std::vector<float> sizes(static_cast<size_t>(num) * 3);
+	FrustumCuller culler;
+	culler.Resize(num);
+	for(int i = 0; i < num; ++i){
+		float *center = &centers[i * 3];
+		float *size = &sizes[i * 3];
+		for(int k = 0; k < 3; ++k){
+			center[k] = random.Uniform(-SCENE_SIZE, SCENE_SIZE);
+			size[k] = random.Uniform(0.05f, 0.5f);
+		}
+		if(i % 2 == 0){
+			culler.SetSphere(i, center, size[0]);
+		}else{
+			culler.SetBox(i, center, size);
+		}
+	}
+
+	culler.CullScalar(frustums, VIEW_NUM);
+	std::vector<uint32_t> reference[VIEW_NUM];
+	for(int v = 0; v < VIEW_NUM; ++v){
+		reference[v].assign(culler.Visible(v), culler.Visible(v) + culler.VisibleNum(v));
+	}
+
+	culler.Cull(frustums, VIEW_NUM);
+	bool same = true;
+	bool in_range = true;
+	for(int v = 0; v < VIEW_NUM; ++v){
+		same = same && (culler.VisibleNum(v) == static_cast<int>(reference[v].size())) &&
+			std::equal(reference[v].begin(), reference[v].end(), culler.Visible(v));
+		for(int i = 0; i < culler.VisibleNum(v); ++i){
+			in_range = in_range && culler.Visible(v)[i] < static_cast<uint32_t>(num) && (i == 0 || culler.Visible(v)[i - 1] < culler.Visible(v)[i]);
+		}
+	}
+	checker.Check("simd lists match the scalar reference in every view", same);
+	checker.Check("lists are ascending and never include padding lanes", in_range);
+
+
+	//外と判定したものの中の点は全て視錐台の外にある
+	int inside_culled_num = 0;
+	const int sampled_num = std::min(num, MAX_SAMPLED);
+	std::vector<char> visible(sampled_num);
+	for(int v = 0; v < VIEW_NUM; ++v){
+		std::fill(visible.begin(), visible.end(), 0);
+		for(int i = 0; i < culler.VisibleNum(v) && culler.Visible(v)[i] < static_cast<uint32_t>(sampled_num); ++i){
+			visible[culler.Visible(v)[i]] = 1;
+		}
+		for(int i = 0; i < sampled_num; ++i){
+			if(visible[i]){
+				continue;
+			}
+			const float *center = &centers[i * 3];
+			const float *size = &sizes[i * 3];
+			bool inside = InsideViewProj(view_projs[v], center);
+			for(int j = 0; j < 8 + SAMPLE_NUM && !inside; ++j){
+				float p[3];
+				if(i % 2 == 0){
+					//球: 軸の方向の端と、球の中の乱数の点
+					float d[3] = {0.0f, 0.0f, 0.0f};
+					if(j < 6){
+						d[j / 2] = (j % 2 == 0) ? 1.0f : -1.0f;
+					}else{
+						do{
+							for(int k = 0; k < 3; ++k){
+								d[k] = random.Uniform(-1.0f, 1.0f);
+							}
+						}while(d[0] * d[0] + d[1] * d[1] + d[2] * d[2] > 1.0f);
+					}
+					for(int k = 0; k < 3; ++k){
+						p[k] = center[k] + d[k] * size[0];
+					}
+				}else{
+					//箱: 8つの角と、箱の中の乱数の点
+					for(int k = 0; k < 3; ++k){
+						const float t = (j < 8) ? (((j >> k) & 1) ? 1.0f : -1.0f) : random.Uniform(-1.0f, 1.0f);
+						p[k] = center[k] + t * size[k];
+					}
+				}
+				inside = InsideViewProj(view_projs[v], p);
+			}
+			inside_culled_num += inside ? 1 : 0;
+		}
+	}
+	checker.Check("culled objects lie entirely outside the frustum", inside_culled_num == 0);
+
+
+	//決まった位置の球
+	{
+		const float *eye = camera.eye;
+		float dir[3] = {camera.focus[0] - eye[0], camera.focus[1] - eye[1], camera.focus[2] - eye[2]};
+		const float dir_length = std::sqrt(dir[0] * dir[0] + dir[1] * dir[1] + dir[2] * dir[2]);
+		for(float &d : dir){
+			d /= dir_length;
+		}
+		auto along = [&](float t, float p[3]){
+			for(int k = 0; k < 3; ++k){
+				p[k] = eye[k] + dir[k] * t;
+			}
+		};
+
+		//左の面の上の点から、面の外へ半径より少し遠い・少し近い位置
+		const float *left = frustums[0].planes[0];
+		float on_left[3];
+		along(10.0f, on_left);
+		const float left_dist = on_left[0] * left[0] + on_left[1] * left[1] + on_left[2] * left[2] + left[3];
+		for(int k = 0; k < 3; ++k){
+			on_left[k] -= left[k] * left_dist;
+		}
+
+		static const float RADIUS = 0.5f;
+		struct Case{
+			const char	*name;
+			float		center[3];
+			bool		visible;
+		};
+		Case cases[6] = {{"center"}, {"behind the camera"}, {"across the near plane"}, {"beyond the far plane"}, {"just outside the left plane"}, {"just inside the left plane"}};
+		along(6.0f, cases[0].center);
+		along(-3.0f, cases[1].center);
+		along(camera.near_z, cases[2].center);
+		along(camera.far_z + 2.0f * RADIUS, cases[3].center);
+		for(int k = 0; k < 3; ++k){
+			cases[4].center[k] = on_left[k] - left[k] * (RADIUS + 0.01f);
+			cases[5].center[k] = on_left[k] - left[k] * (RADIUS - 0.01f);
+		}
+		const bool expected[6] = {true, false, true, false, false, true};
+
+		FrustumCuller small;
+		small.Resize(6);
+		for(int i = 0; i < 6; ++i){
+			small.SetSphere(i, cases[i].center, RADIUS);
+		}
+		small.Cull(frustums, 1);
+		bool known = true;
+		for(int i = 0; i < 6; ++i){
+			const bool result = std::find(small.Visible(0), small.Visible(0) + small.VisibleNum(0), static_cast<uint32_t>(i)) != small.Visible(0) + small.VisibleNum(0);
+			if(result != expected[i]){
+				PrintLine("[cullbench] %s: %s\n", cases[i].name, result ? "visible" : "culled");
+				known = false;
+			}
+		}
+		checker.Check("known spheres against the camera frustum", known);
+
+
+		//ライトとの間にある(カメラの視錐台の外の)ものは、影を落とすのでカスケードの列に残る
+		float caster[3];
+		for(int k = 0; k < 3; ++k){
+			caster[k] = camera.focus[k] + light_dir[k] * 10.0f;
+		}
+		small.Resize(1);
+		small.SetSphere(0, caster, RADIUS);
+		small.Cull(frustums, VIEW_NUM);
+		int light_visible_num = 0;
+		for(int v = 1; v < VIEW_NUM; ++v){
+			light_visible_num += small.VisibleNum(v);
+		}
+		checker.Check("casters outside the camera stay in the light lists", small.VisibleNum(0) == 0 && light_visible_num > 0);
+	}
+
+
+	//所要時間(視錐台がカメラだけの場合と、カメラとカスケードの場合)
+	for(int view_num : {1, VIEW_NUM}){
+		double scalar_ms = 1e30;
+		double simd_ms = 1e30;
+		for(int r = 0; r < REPEAT_NUM; ++r){
+			const auto start = std::chrono::high_resolution_clock::now();
+			culler.CullScalar(frustums, view_num);
+			const auto middle = std::chrono::high_resolution_clock::now();
+			culler.Cull(frustums, view_num);
+			const auto end = std::chrono::high_resolution_clock::now();
+			scalar_ms = std::min(scalar_ms, std::chrono::duration<double, std::milli>(middle - start).count());
+			simd_ms = std::min(simd_ms, std::chrono::duration<double, std::milli>(end - middle).count());
+		}
+
+		char counts[64] = "";
+		for(int v = 0, length = 0; v < view_num; ++v){
+			length += snprintf(counts + length, sizeof(counts) - length, (v == 0) ? "%d" : "/%d", culler.VisibleNum(v));
+		}
+		PrintLine("[cullbench] %7d objects  %d view%s  scalar %8.3f ms  %-6s x%d %8.3f ms  (%4.1fx, %6.1f M objects/s)  visible %s\n",
+			num, view_num, (view_num > 1) ? "s" : " ", scalar_ms, FrustumCuller::InstructionSet(), FrustumCuller::LaneNum(), simd_ms,
+			scalar_ms / simd_ms, num / simd_ms / 1000.0, counts);
+	}
+
+	return checker.Result();
+}
@@ -0,0 +1,255 @@
+#include <cstdio>
+#include <cstdint>
+#include <algorithm>
+#include <deque>
+#include <vector>
+#include "DescriptorAllocator.h"
+#include "TestCommon.h"
+
+namespace{
+//添字ごとに使用中かを持つ手元の表(空き範囲は使用中でない添字の連続)
+struct FreeRuns{
+	uint32_t	num;		//空き範囲の数
+	uint32_t	largest;	//最大の空き範囲
+	uint32_t	best;		//count以上で最も小さい空き範囲(なければ0)
+};
+
+FreeRuns GetFreeRuns(const std::vector<uint8_t> &used, uint32_t count){
+	FreeRuns runs{};
+	const uint32_t size = static_cast<uint32_t>(used.size());
+	for(uint32_t i = 0; i < size;){
+		if(used[i]){
+			++i;
+			continue;
+		}
+		uint32_t end = i;
+		while(end < size && !used[end]){
+			++end;
+		}
+		const uint32_t length = end - i;
+		++runs.num;
+		runs.largest = std::max(runs.largest, length);
+		if(length >= count && (runs.best == 0 || length < runs.best)){
+			runs.best = length;
+		}
+		i = end;
+	}
+	return runs;
+}
+
+//firstから始まる空き範囲の長さ(firstの直前が空いていれば0)
+uint32_t RunLengthAt(const std::vector<uint8_t> &used, uint32_t first){
+	if(first > 0 && !used[first - 1]){
+		return 0;
+	}
+	uint32_t end = first;
+	while(end < used.size() && !used[end]){
+		++end;
+	}
+	return end - first;
+}
+}
+
+
+//DirectX12Tests -descriptorcheck [フレーム数]
+//DescriptorAllocatorを、添字ごとの使用中の表と突き合わせて確かめる
+//・要求を満たす最も小さい空き範囲の先頭から切り出し(best-fit)、そのような空き範囲があれば失敗しない
+//・解放した範囲は前後の空き範囲と結合し、空き範囲の数・最大の空き範囲が表と一致する(断片化の目安)
+//・フェンス値を付けて解放した範囲は、そのフェンスが完了するまで再利用しない
+//・全て解放すると1つの空き範囲に戻る
+int DescriptorAllocatorCheckCommand(const char *command_line){
+	static constexpr uint32_t CAPACITY = 4096;
+	static constexpr uint64_t LATENCY = 2;	//GPUが完了するまでのフレーム数
+
+	int frame_num = 2000;
+	sscanf(command_line, "-descriptorcheck %d", &frame_num);
+	if(frame_num < 1){
+		return -1;
+	}
+
+	Checker checker("descriptorcheck");
+
+	TestRandom random(11223u);
+
+
+	//決まった手順
+	{
+		DescriptorAllocator allocator(100);
+		const uint32_t a = allocator.Allocate(10);
+		const uint32_t b = allocator.Allocate(20);
+		const uint32_t c = allocator.Allocate(30);
+		checker.Check("allocations are placed back to back", a == 0 && b == 10 && c == 30 && allocator.GetStats().allocated_num == 60);
+
+		//空きは[10, 30)の20個と[60, 100)の40個
+		allocator.Free(b, 20);
+		DescriptorAllocator::Stats stats = allocator.GetStats();
+		checker.Check("freeing a middle range leaves two free ranges", stats.free_range_num == 2 && stats.largest_free_range == 40);
+		const uint32_t d = allocator.Allocate(15);
+		const uint32_t e = allocator.Allocate(5);
+		checker.Check("best fit picks the smallest range that fits", d == 10 && e == 25);
+		checker.Check("exact fit removes the free range", allocator.GetStats().free_range_num == 1);
+		checker.Check("no range fits 41", allocator.Allocate(41) == DescriptorAllocator::INVALID_INDEX && allocator.GetStats().failed_num == 1);
+		checker.Check("zero count is rejected", allocator.Allocate(0) == DescriptorAllocator::INVALID_INDEX);
+
+		allocator.Free(a, 10);
+		allocator.Free(e, 5);
+		allocator.Free(c, 30);
+		allocator.Free(d, 15);
+		stats = allocator.GetStats();
+		checker.Check("freeing everything coalesces into one range", stats.free_range_num == 1 && stats.largest_free_range == 100 && stats.allocated_num == 0);
+		checker.Check("empty allocator restarts at index 0", allocator.Allocate(100) == 0);
+	}
+
+	//フェンス値を付けた解放
+	{
+		DescriptorAllocator allocator(16);
+		const uint32_t a = allocator.Allocate(8);
+		const uint32_t b = allocator.Allocate(8);
+		allocator.Free(a, 8, 5);
+		DescriptorAllocator::Stats stats = allocator.GetStats();
+		checker.Check("deferred free keeps the range allocated", stats.pending_num == 1 && stats.allocated_num == 16 && allocator.Allocate(1) == DescriptorAllocator::INVALID_INDEX);
+
+		allocator.ReleaseCompleted(4);
+		checker.Check("range is not reused before its fence", allocator.GetStats().pending_num == 1 && allocator.Allocate(1) == DescriptorAllocator::INVALID_INDEX);
+
+		allocator.ReleaseCompleted(5);
+		checker.Check("completed fence returns the range", allocator.GetStats().pending_num == 0 && allocator.Allocate(8) == a);
+		allocator.Free(a, 8);
+		allocator.Free(b, 8, 6);
+		allocator.ReleaseCompleted(6);
+		checker.Check("released ranges coalesce", allocator.GetStats().free_range_num == 1 && allocator.GetStats().largest_free_range == 16);
+	}
+
+	//市松模様の断片化
+	{
+		static constexpr uint32_t SIZE = 64;
+		DescriptorAllocator allocator(SIZE);
+		uint32_t firsts[SIZE];
+		for(uint32_t i = 0; i < SIZE; ++i){
+			firsts[i] = allocator.Allocate(1);
+		}
+		for(uint32_t i = 0; i < SIZE; i += 2){
+			allocator.Free(firsts[i], 1);
+		}
+		DescriptorAllocator::Stats stats = allocator.GetStats();
+		checker.Check("checkerboard frees leave 32 single ranges", stats.free_range_num == SIZE / 2 && stats.largest_free_range == 1);
+		checker.Check("fragmented heap cannot allocate 2", allocator.Allocate(2) == DescriptorAllocator::INVALID_INDEX && allocator.GetStats().failed_num == 1);
+
+		for(uint32_t i = 1; i < SIZE; i += 2){
+			allocator.Free(firsts[i], 1);
+		}
+		stats = allocator.GetStats();
+		checker.Check("filling the holes coalesces everything", stats.free_range_num == 1 && stats.largest_free_range == SIZE && stats.allocated_num == 0);
+	}
+
+
+	//乱数の割り当てと解放を手元の表と突き合わせる
+	{
+		struct Range{
+			uint32_t	first;
+			uint32_t	count;
+		};
+		struct Deferred{
+			Range		range;
+			uint64_t	fence_value;
+		};
+
+		DescriptorAllocator allocator(CAPACITY);
+		std::vector<uint8_t> used(CAPACITY, 0);	//割り当て中と解放待ち
+		std::vector<Range> live;
+		std::deque<Deferred> deferred;
+		bool inside = true;
+		bool disjoint = true;
+		bool best_fit = true;
+		bool no_false_failure = true;
+		bool stats_match = true;
+		uint64_t alloc_num = 0;
+		uint64_t fail_num = 0;
+		uint32_t max_free_range_num = 0;
+
+		for(int frame = 1; frame <= frame_num; ++frame){
+			const int op_num = 1 + random.Next() % 32;
+			for(int op = 0; op < op_num; ++op){
+				//使用量が少ないほど割り当てを多くし、ときどき大きな範囲を要求して断片化を溜める
+				const bool allocate = live.empty() || random.Next(CAPACITY) >= static_cast<uint32_t>(allocator.GetStats().allocated_num / 2);
+				if(allocate){
+					const uint32_t count = (random.Next() % 16 == 0) ? 32 + random.Next() % 256 : 1 + random.Next() % 8;
+					const FreeRuns runs = GetFreeRuns(used, count);
+					const uint32_t first = allocator.Allocate(count);
+					if(first == DescriptorAllocator::INVALID_INDEX){
+						no_false_failure = no_false_failure && (runs.best == 0);
+						++fail_num;
+						continue;
+					}
+					++alloc_num;
+					inside = inside && (first + count <= CAPACITY);
+					if(!inside){
+						continue;
+					}
+
+					//選んだ空き範囲はfirstから始まり、要求を満たす最も小さいもの
+					best_fit = best_fit && (RunLengthAt(used, first) == runs.best);
+					for(uint32_t i = first; i < first + count; ++i){
+						disjoint = disjoint && !used[i];
+						used[i] = 1;
+					}
+					live.push_back({first, count});
+				}else{
+					//半分はすぐに、残りはGPUが使い終わるまで待って解放する
+					const size_t index = random.Next() % live.size();
+					const Range range = live[index];
+					live[index] = live.back();
+					live.pop_back();
+					if(random.Next() % 2 == 0){
+						allocator.Free(range.first, range.count);
+						std::fill(used.begin() + range.first, used.begin() + range.first + range.count, 0);
+					}else{
+						allocator.Free(range.first, range.count, frame);
+						deferred.push_back({range, static_cast<uint64_t>(frame)});
+					}
+				}
+			}
+
+			//GPUはLATENCYフレーム遅れて完了する
+			if(frame > static_cast<int>(LATENCY)){
+				const uint64_t completed = frame - LATENCY;
+				allocator.ReleaseCompleted(completed);
+				while(!deferred.empty() && deferred.front().fence_value <= completed){
+					const Range range = deferred.front().range;
+					std::fill(used.begin() + range.first, used.begin() + range.first + range.count, 0);
+					deferred.pop_front();
+				}
+			}
+
+			const FreeRuns runs = GetFreeRuns(used, 1);
+			const DescriptorAllocator::Stats stats = allocator.GetStats();
+			const uint32_t used_num = static_cast<uint32_t>(std::count(used.begin(), used.end(), 1));
+			stats_match = stats_match && stats.allocated_num == used_num && stats.free_range_num == runs.num
+				&& stats.largest_free_range == runs.largest && stats.pending_num == deferred.size();
+			max_free_range_num = std::max(max_free_range_num, stats.free_range_num);
+		}
+
+		char name[96];
+		snprintf(name, sizeof(name), "%llu allocations stay inside the heap", static_cast<unsigned long long>(alloc_num));
+		checker.Check(name, inside);
+		checker.Check("allocations never overlap live or pending ranges", disjoint);
+		checker.Check("every allocation is a best fit", best_fit);
+		checker.Check("allocation fails only when no range fits", no_false_failure && fail_num > 0);
+		checker.Check("stats match the reference table", stats_match);
+
+		//全て解放する
+		for(const Range &range : live){
+			allocator.Free(range.first, range.count);
+		}
+		allocator.ReleaseCompleted(frame_num);
+		const DescriptorAllocator::Stats stats = allocator.GetStats();
+		checker.Check("freeing everything restores one full range", stats.allocated_num == 0 && stats.pending_num == 0
+			&& stats.free_range_num == 1 && stats.largest_free_range == CAPACITY);
+		checker.Check("full capacity can be allocated again", allocator.Allocate(CAPACITY) == 0);
+
+		PrintLine("[descriptorcheck] %d frames  allocations %llu  failed %llu  max free ranges %u\n",
+			frame_num, static_cast<unsigned long long>(alloc_num), static_cast<unsigned long long>(fail_num), max_free_range_num);
+	}
+
+	return checker.Result();
+}
@@ -0,0 +1,217 @@
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <chrono>
+#include <algorithm>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "MappedFile.h"
+#include "TextureFile.h"
+#include "TestCommon.h"
+
+namespace{
+typedef MappedFile::byte byte;
+
+//全てのバイトを読むためのチェックサム(8バイトずつ混ぜる)
+uint64_t Checksum(const byte *data, size_t size){
+	uint64_t sum = 0;
+	size_t i = 0;
+	for(; i + 8 <= size; i += 8){
+		uint64_t v;
+		memcpy(&v, data + i, sizeof(v));
+		sum = sum * 31 + v;
+	}
+	for(; i < size; ++i){
+		sum = sum * 31 + data[i];
+	}
+	return sum;
+}
+
+bool WriteFile(const std::string &file_name, const void *data, size_t size){
+	FILE *fp = fopen(file_name.c_str(), "wb");
+	if(fp == nullptr){
+		return false;
+	}
+	const bool ok = (size == 0 || fwrite(data, 1, size, fp) == size);
+	return (fclose(fp) == 0) && ok;
+}
+
+//幅・高さのヘッダを付けたテクスチャファイルを書く
+bool WriteTexture(const std::string &file_name, int32_t width, int32_t height, const std::vector<byte> &pixels){
+	std::vector<byte> data(TextureFile::HEADER_SIZE + pixels.size());
+	memcpy(data.data(), &width, sizeof(width));
+	memcpy(data.data() + sizeof(width), &height, sizeof(height));
+	std::copy(pixels.begin(), pixels.end(), data.begin() + TextureFile::HEADER_SIZE);
+	return WriteFile(file_name, data.data(), data.size());
+}
+
+//ファイル全体をstd::ifstreamでstd::vectorに読み込む(MappedFileを使う前の読み込み方)
+bool ReadStream(const std::string &file_name, std::vector<byte> *data){
+	std::ifstream stream(file_name, std::ios::binary);
+	if(!stream){
+		return false;
+	}
+	stream.seekg(0, std::ios::end);
+	const std::streamoff size = stream.tellg();
+	stream.seekg(0, std::ios::beg);
+	data->resize(static_cast<size_t>(size));
+	return static_cast<bool>(stream.read(reinterpret_cast<char*>(data->data()), size));
+}
+
+double ElapsedMs(std::chrono::high_resolution_clock::time_point start){
+	return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+}
+
+
+//DirectX12Tests -filebench <作業ファイルの名前> [最大のMB数] [計測の繰り返し回数]
+//MappedFile・TextureFileの読み込みを確かめ、std::ifstreamで読み込む場合とスループットを比べる
+//(作業ファイルの名前に拡張子などを付けたファイルを作る)
+//・MappedFileで読んだ内容はstd::ifstreamで読んだ内容と一致する。空のファイル・存在しないファイルは開かない
+//・TextureFileはヘッダの幅・高さと画素を返し、ヘッダとファイルサイズが食い違うファイルは開かない
+//・ファイルを開いて全てのバイトを読み終わるまでの時間を、サイズごとにmmapとstd::ifstreamで比べる
+//  (直前に書いたファイルなので、ページキャッシュに載った状態の計測になる)
+int FileBenchmarkCommand(const char *command_line){
+	char base[260]{};
+	int max_mb = 64;
+	int repeat_num = 5;
+	if(sscanf(command_line, "-filebench %259s %d %d", base, &max_mb, &repeat_num) < 1 || max_mb < 1 || repeat_num < 1){
+		return -1;
+	}
+	const std::string data_name = std::string(base) + ".bin";
+	const std::string texture_name = std::string(base) + "_texture";
+	const std::string broken_name = std::string(base) + "_broken";
+
+	Checker checker("filebench");
+
+	TestRandom random(97531u);
+
+
+	//MappedFile
+	{
+		std::vector<byte> data(12345);
+		for(byte &b : data){
+			b = static_cast<byte>(random.Next());
+		}
+		const bool written = WriteFile(data_name, data.data(), data.size());
+
+		MappedFile file;
+		const bool opened = written && file.Open(data_name.c_str());
+		checker.Check("mapped bytes match the written bytes", opened && file.Size() == data.size()
+			&& memcmp(file.Data(), data.data(), data.size()) == 0);
+		file.Close();
+		checker.Check("Close releases the mapping", !file.IsOpen() && file.Data() == nullptr && file.Size() == 0);
+
+		const bool empty_written = WriteFile(broken_name, nullptr, 0);
+		checker.Check("empty file is not opened", empty_written && !file.Open(broken_name.c_str()) && !file.IsOpen());
+		checker.Check("missing file is not opened", !file.Open((std::string(base) + "_missing").c_str()) && !file.IsOpen());
+	}
+
+	//TextureFile
+	{
+		const int32_t width = 33;
+		const int32_t height = 17;
+		std::vector<byte> pixels(width * height * TextureFile::PIXEL_SIZE);
+		for(byte &b : pixels){
+			b = static_cast<byte>(random.Next());
+		}
+
+		TextureFile texture;
+		const bool opened = WriteTexture(texture_name, width, height, pixels) && texture.Open(texture_name.c_str());
+		checker.Check("texture header and pixels are read", opened && texture.Width() == width && texture.Height() == height
+			&& texture.RowPitch() == width * 4 && texture.PixelsSize() == pixels.size()
+			&& memcmp(texture.Pixels(), pixels.data(), pixels.size()) == 0);
+
+		//ヘッダとファイルサイズが食い違うファイル
+		bool rejected = true;
+		std::vector<byte> short_pixels(pixels.begin(), pixels.end() - 1);
+		rejected = rejected && WriteTexture(broken_name, width, height, short_pixels) && !texture.Open(broken_name.c_str());
+		rejected = rejected && WriteTexture(broken_name, 0, height, pixels) && !texture.Open(broken_name.c_str());
+		rejected = rejected && WriteTexture(broken_name, width, -1, pixels) && !texture.Open(broken_name.c_str());
+		rejected = rejected && WriteTexture(broken_name, 16385, 1, std::vector<byte>(16385 * 4)) && !texture.Open(broken_name.c_str());
+		rejected = rejected && WriteFile(broken_name, pixels.data(), TextureFile::HEADER_SIZE - 1) && !texture.Open(broken_name.c_str());
+		checker.Check("mismatched headers and short files are rejected", rejected && !texture.IsOpen() && texture.Width() == 0);
+
+		//earthはstd::ifstreamで読んだ画素と一致する
+		std::vector<byte> stream;
+		const bool earth = texture.Open("earth") && ReadStream("earth", &stream) && stream.size() >= TextureFile::HEADER_SIZE + texture.PixelsSize()
+			&& memcmp(texture.Pixels(), stream.data() + TextureFile::HEADER_SIZE, texture.PixelsSize()) == 0;
+		checker.Check("earth matches the stream read", earth);
+	}
+
+
+	//計測
+	PrintLine("[filebench] %-10s %-24s %-24s %s\n", "size", "std::ifstream", "MappedFile", "speedup");
+	bool same_checksum = true;
+	for(int kb = 64; kb <= max_mb * 1024; kb *= 4){
+		const size_t size = static_cast<size_t>(kb) * 1024;
+		std::vector<byte> data(size);
+		for(size_t i = 0; i < size; i += 4){
+			const uint32_t v = random.Next();
+			memcpy(&data[i], &v, std::min<size_t>(4, size - i));
+		}
+		if(!WriteFile(data_name, data.data(), data.size())){
+			checker.Check("benchmark file is written", false);
+			break;
+		}
+		const uint64_t expected = Checksum(data.data(), data.size());
+		std::vector<byte>().swap(data);
+
+		double stream_ms = 1.0e9, mapped_ms = 1.0e9;
+		for(int r = 0; r < repeat_num; ++r){
+			//読み込み先の確保も含めて計測する
+			auto start = std::chrono::high_resolution_clock::now();
+			{
+				std::vector<byte> buffer;
+				same_checksum = same_checksum && ReadStream(data_name, &buffer) && Checksum(buffer.data(), buffer.size()) == expected;
+			}
+			stream_ms = std::min(stream_ms, ElapsedMs(start));
+
+			start = std::chrono::high_resolution_clock::now();
+			{
+				MappedFile file;
+				same_checksum = same_checksum && file.Open(data_name.c_str()) && Checksum(file.Data(), file.Size()) == expected;
+			}
+			mapped_ms = std::min(mapped_ms, ElapsedMs(start));
+		}
+
+		const double mb = size / (1024.0 * 1024.0);
+		PrintLine("[filebench] %7d KB %8.3f ms %7.0f MB/s %8.3f ms %7.0f MB/s %5.2fx\n",
+			kb, stream_ms, mb / stream_ms * 1000.0, mapped_ms, mb / mapped_ms * 1000.0, stream_ms / mapped_ms);
+	}
+	checker.Check("both reads give the same checksum", same_checksum);
+
+	//earthの読み込み(Sphereが使うもの)
+	{
+		double stream_ms = 1.0e9, mapped_ms = 1.0e9;
+		uint64_t stream_sum = 0, mapped_sum = 1;
+		for(int r = 0; r < repeat_num; ++r){
+			auto start = std::chrono::high_resolution_clock::now();
+			{
+				std::vector<byte> buffer;
+				if(ReadStream("earth", &buffer) && buffer.size() > TextureFile::HEADER_SIZE){
+					stream_sum = Checksum(buffer.data() + TextureFile::HEADER_SIZE, buffer.size() - TextureFile::HEADER_SIZE);
+				}
+			}
+			stream_ms = std::min(stream_ms, ElapsedMs(start));
+
+			start = std::chrono::high_resolution_clock::now();
+			{
+				TextureFile texture;
+				if(texture.Open("earth")){
+					mapped_sum = Checksum(texture.Pixels(), texture.PixelsSize());
+				}
+			}
+			mapped_ms = std::min(mapped_ms, ElapsedMs(start));
+		}
+		PrintLine("[filebench] %-10s %8.3f ms %12s %8.3f ms %12s %5.2fx\n", "earth", stream_ms, "", mapped_ms, "", stream_ms / mapped_ms);
+		checker.Check("earth checksums match", stream_sum == mapped_sum);
+	}
+
+	remove(data_name.c_str());
+	remove(texture_name.c_str());
+	remove(broken_name.c_str());
+
+	return checker.Result();
+}
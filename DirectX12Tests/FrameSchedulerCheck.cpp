@@ -0,0 +1,191 @@
+#include <cstdio>
+#include <cstdint>
+#include <cmath>
+#include <algorithm>
+#include <deque>
+#include "FrameScheduler.h"
+#include "TestCommon.h"
+
+namespace{
+//フレームを順に1つずつ処理する模擬のキュー(時刻はミリ秒の仮想時間で、実際には待たない)
+class MockQueue{
+public:
+	MockQueue():
+		busy_until_{},
+		completed_{}{}
+
+	//time_msの時点でgpu_msかかるフレームを提出し、終わったらvalueをシグナルする
+	void Signal(uint64_t value, double time_ms, double gpu_ms){
+		busy_until_ = std::max(busy_until_, time_ms) + gpu_ms;
+		pending_.push_back({value, busy_until_});
+	}
+
+	//time_msの時点で完了しているフェンス値
+	uint64_t CompletedValue(double time_ms){
+		while(!pending_.empty() && pending_.front().done_ms <= time_ms){
+			completed_ = pending_.front().value;
+			pending_.pop_front();
+		}
+		return completed_;
+	}
+
+	//valueが完了する時刻(完了済みなら0)
+	double CompletionTime(uint64_t value) const{
+		for(const Signaled &signaled : pending_){
+			if(signaled.value >= value){
+				return signaled.done_ms;
+			}
+		}
+		return 0.0;
+	}
+
+private:
+	struct Signaled{
+		uint64_t	value;
+		double		done_ms;
+	};
+
+	double					busy_until_;
+	uint64_t				completed_;
+	std::deque<Signaled>	pending_;
+};
+
+struct FrameLoopResult{
+	double		frame_ms;			//1フレームあたりの時間
+	int			stall_num;			//フレームのリソースが空くのを待った回数
+	int			reuse_error_num;	//GPUが使用中のリソースを再利用した回数
+	int			fence_error_num;	//フェンス値が1ずつ増えなかった回数
+	uint64_t	max_in_flight;		//提出して完了していないフレームの最大数
+};
+
+//D3D12Manager::Renderと同じ手順(フレームのリソースが空くまで待つ → 記録 → 提出)を仮想時間で回す
+//gpu_msが負ならフレームごとに乱数で決める
+FrameLoopResult RunFrameLoop(int frame_num, int loop_num, double cpu_ms, double gpu_ms, uint32_t seed){
+	FrameScheduler scheduler(frame_num);
+	MockQueue queue;
+	uint64_t resource_fences[FrameScheduler::MAX_FRAME_NUM]{};	//フレームのリソースを最後に使った提出
+	FrameLoopResult result{};
+
+	TestRandom random(seed);
+	double time = 0.0;
+	for(int loop = 0; loop < loop_num; ++loop){
+		const int index = loop % scheduler.FrameNum();
+
+		//フレームのリソースが空くまで待つ
+		const uint64_t wait_value = scheduler.WaitValue(index);
+		if(!scheduler.IsAvailable(index, queue.CompletedValue(time))){
+			time = std::max(time, queue.CompletionTime(wait_value));
+			++result.stall_num;
+		}
+		const uint64_t completed = queue.CompletedValue(time);
+		result.reuse_error_num += (resource_fences[index] > completed) ? 1 : 0;
+
+		//記録して提出する
+		time += cpu_ms;
+		const uint64_t fence = scheduler.Submit(index);
+		result.fence_error_num += (fence == static_cast<uint64_t>(loop) + 1 && scheduler.LastSubmitted() == fence) ? 0 : 1;
+		double frame_gpu_ms = gpu_ms;
+		if(frame_gpu_ms < 0.0){
+			frame_gpu_ms = 1.0 + 10.0 * random.Next() / 16777216.0;
+		}
+		queue.Signal(fence, time, frame_gpu_ms);
+		resource_fences[index] = fence;
+		result.max_in_flight = std::max(result.max_in_flight, fence - queue.CompletedValue(time));
+	}
+
+	//最後のフレームの完了まで
+	time = std::max(time, queue.CompletionTime(scheduler.LastSubmitted()));
+	result.frame_ms = time / loop_num;
+	return result;
+}
+}
+
+
+//DirectX12Tests -framecheck [回すフレームの数]
+//FrameSchedulerを、提出したフレームを仮想時間で順に処理する模擬のキューと組み合わせて確かめる
+//・フェンス値は提出ごとに1ずつ増え、待つ値は各フレームのリソースを最後に提出したときの値になる
+//・GPUが使用中のフレームのリソースを再利用せず、完了していないフレームはフレーム数を超えない
+//・フレーム数が1ならCPUとGPUの時間の和、2以上なら遅い方の時間でフレームが進む
+//・フレーム数は1からMAX_FRAME_NUMに丸める
+int FrameSchedulerCheckCommand(const char *command_line){
+	int loop_num = 1000;
+	sscanf(command_line, "-framecheck %d", &loop_num);
+	if(loop_num < 1){
+		return -1;
+	}
+
+	Checker checker("framecheck");
+
+
+	//決まった手順
+	{
+		FrameScheduler scheduler(3);
+		const bool fresh = scheduler.WaitValue(0) == 0 && scheduler.WaitValue(1) == 0 && scheduler.WaitValue(2) == 0 && scheduler.IsAvailable(2, 0);
+		const uint64_t a = scheduler.Submit(0);
+		const uint64_t b = scheduler.Submit(1);
+		const uint64_t c = scheduler.Submit(2);
+		checker.Check("unused frames need no wait", fresh);
+		checker.Check("fence values increase by one per submit", a == 1 && b == 2 && c == 3 && scheduler.LastSubmitted() == 3);
+		checker.Check("wait value is the frame's last submit", scheduler.WaitValue(0) == 1 && scheduler.WaitValue(2) == 3);
+		checker.Check("frame is available once its fence completes", !scheduler.IsAvailable(1, 1) && scheduler.IsAvailable(1, 2));
+
+		scheduler.Submit(0);
+		checker.Check("resubmitting a frame moves its wait value", scheduler.WaitValue(0) == 4 && !scheduler.IsAvailable(0, 3));
+
+		scheduler.Reset(3);
+		checker.Check("reset clears the fence values", scheduler.LastSubmitted() == 0 && scheduler.WaitValue(0) == 0);
+
+		FrameScheduler zero(0);
+		FrameScheduler many(FrameScheduler::MAX_FRAME_NUM + 3);
+		checker.Check("frame count is clamped to [1, MAX_FRAME_NUM]", zero.FrameNum() == 1 && many.FrameNum() == FrameScheduler::MAX_FRAME_NUM);
+	}
+
+
+	//模擬のキューで回す
+	static const struct{
+		double	cpu_ms;
+		double	gpu_ms;
+	} costs[] = {
+		{4.0, 6.0},		//GPUが律速
+		{6.0, 4.0},		//CPUが律速
+		{5.0, -1.0},	//GPUの時間がフレームごとに変わる
+	};
+
+	bool reuse = true;
+	bool fences = true;
+	bool in_flight = true;
+	bool serial = true;
+	bool overlapped = true;
+	for(const auto &cost : costs){
+		for(int frame_num = 1; frame_num <= FrameScheduler::MAX_FRAME_NUM; ++frame_num){
+			const FrameLoopResult result = RunFrameLoop(frame_num, loop_num, cost.cpu_ms, cost.gpu_ms, 24680u);
+			reuse = reuse && (result.reuse_error_num == 0);
+			fences = fences && (result.fence_error_num == 0);
+			in_flight = in_flight && (result.max_in_flight <= static_cast<uint64_t>(frame_num));
+
+			if(cost.gpu_ms >= 0.0){
+				//立ち上がりの分だけ理想から外れるので1%まで許す
+				const double expected = (frame_num == 1) ? cost.cpu_ms + cost.gpu_ms : std::max(cost.cpu_ms, cost.gpu_ms);
+				const bool ok = std::fabs(result.frame_ms - expected) <= 0.01 * expected;
+				serial = serial && (frame_num > 1 || ok);
+				overlapped = overlapped && (frame_num == 1 || ok);
+			}
+
+			char gpu_text[16];
+			if(cost.gpu_ms >= 0.0){
+				snprintf(gpu_text, sizeof(gpu_text), "%.1f ms", cost.gpu_ms);
+			}else{
+				snprintf(gpu_text, sizeof(gpu_text), "1-11 ms");
+			}
+			PrintLine("[framecheck] cpu %.1f ms  gpu %-8s  %d frames  %6.2f ms/frame  stalls %5d  max in flight %llu\n",
+				cost.cpu_ms, gpu_text, frame_num, result.frame_ms, result.stall_num, static_cast<unsigned long long>(result.max_in_flight));
+		}
+	}
+	checker.Check("frame resources are never reused while the GPU uses them", reuse);
+	checker.Check("fence values match the submit count", fences);
+	checker.Check("frames in flight never exceed the frame count", in_flight);
+	checker.Check("one frame serializes CPU and GPU", serial);
+	checker.Check("two or more frames overlap CPU and GPU", overlapped);
+
+	return checker.Result();
+}
@@ -0,0 +1,314 @@
+#include <cstdio>
+#include <cstdint>
+#include <chrono>
+#include <algorithm>
+#include <vector>
+#include "RenderGraph.h"
+#include "RendererGraph.h"
+#include "ResourceStateTracker.h"
+#include "TestCommon.h"
+
+namespace{
+//計測用のフレームグラフの宣言(リソースの使い方は検証のために手元にも残す)
+struct GraphAccess{
+	int		pass;
+	int		resource;
+	bool	write;
+};
+
+//pass_num個のパスが、前のパスが書いた一時リソースを読んで新しい一時リソースに書き込むグラフを乱数で作る
+//8パスに1つはバックバッファに合成し、一部のパスの出力はどこからも読まれない(削除される)
+void DeclareRandomGraph(RenderGraph *g, int pass_num, uint32_t seed, std::vector<GraphAccess> *accesses, std::vector<uint64_t> *sizes){
+	TestRandom random(seed);
+
+	g->Clear();
+	accesses->clear();
+	sizes->assign(1, 0);
+	const int back_buffer = g->ImportResource("back buffer", RenderResource{1}, RENDER_STATE_PRESENT);
+
+	std::vector<int> written;
+	char name[32];
+	for(int i = 0; i < pass_num; ++i){
+		snprintf(name, sizeof(name), "pass %d", i);
+		const int pass = g->AddPass(name);
+
+		//前のパスの出力を1~3個読む(同じものを2回読まない)
+		const int read_num = written.empty() ? 0 : static_cast<int>(1 + random.Next() % 3);
+		std::vector<int> reads;
+		for(int r = 0; r < read_num; ++r){
+			const int resource = written[written.size() - 1 - random.Next() % std::min<size_t>(written.size(), 16)];
+			if(std::find(reads.begin(), reads.end(), resource) == reads.end()){
+				reads.push_back(resource);
+				g->Read(pass, resource, RENDER_STATE_SHADER_RESOURCE);
+				accesses->push_back({pass, resource, false});
+			}
+		}
+
+		if(i % 8 == 7 || i == pass_num - 1){
+			g->Write(pass, back_buffer, RENDER_STATE_RENDER_TARGET);
+			accesses->push_back({pass, back_buffer, true});
+			continue;
+		}
+
+		snprintf(name, sizeof(name), "target %d", i);
+		const uint64_t size = (1 + random.Next() % 64) * 64 * 1024;
+		const int target = g->CreateTransient(name, size, 64 * 1024);
+		sizes->push_back(size);
+		g->Write(pass, target, RENDER_STATE_RENDER_TARGET);
+		accesses->push_back({pass, target, true});
+		written.push_back(target);
+	}
+}
+
+//コンパイル結果を宣言と突き合わせる
+//・同じリソースへの書き込みと、その前後の読み込み・書き込みの順が宣言と同じ
+//・使われる間が重なる一時リソースはメモリの範囲が重ならない
+bool IsGraphValid(const RenderGraph &g, const std::vector<GraphAccess> &accesses, const std::vector<uint64_t> &sizes, uint64_t alignment){
+	std::vector<int> position(g.PassNum(), -1);
+	for(size_t i = 0; i < g.Order().size(); ++i){
+		position[g.Order()[i]] = static_cast<int>(i);
+	}
+
+	std::vector<int> last_write(g.ResourceNum(), -1);
+	std::vector<int> last_access(g.ResourceNum(), -1);
+	std::vector<int> first(g.ResourceNum(), -1);
+	std::vector<int> last(g.ResourceNum(), -1);
+	for(const GraphAccess &a : accesses){
+		const int p = position[a.pass];
+		if(p < 0){
+			continue;
+		}
+		if(last_write[a.resource] > p || (a.write && last_access[a.resource] > p)){
+			return false;
+		}
+		last_access[a.resource] = std::max(last_access[a.resource], p);
+		if(a.write){
+			last_write[a.resource] = p;
+		}
+		first[a.resource] = (first[a.resource] < 0) ? p : std::min(first[a.resource], p);
+		last[a.resource] = std::max(last[a.resource], p);
+	}
+
+	//0番目がバックバッファで、1番目以降がすべて一時リソース
+	for(int a = 1; a < g.ResourceNum(); ++a){
+		if(first[a] < 0){
+			continue;
+		}
+		if(g.TransientOffset(a) % alignment != 0){
+			return false;
+		}
+		for(int b = a + 1; b < g.ResourceNum(); ++b){
+			if(first[b] < 0 || first[a] > last[b] || first[b] > last[a]){
+				continue;
+			}
+			const uint64_t end_a = g.TransientOffset(a) + sizes[a];
+			const uint64_t end_b = g.TransientOffset(b) + sizes[b];
+			if(g.TransientOffset(a) < end_b && g.TransientOffset(b) < end_a){
+				return false;
+			}
+		}
+	}
+	return true;
+}
+}
+
+
+//DirectX12Tests -graphbench [コンパイルの回数]
+//描画と同じフレームグラフでデバッグ表示を外したときにパスが削除されてバックバッファが正しく戻ること・シャドウマップのパスを外せること・
+//EVSMのぼかしの途中のモーメントが深度バッファとメモリを共有することと、
+//乱数で作った数百パスのグラフのコンパイル結果が毎回同じで、依存の順とメモリの共有が正しいことを確かめ、
+//パスの数ごとのコンパイル時間・削除したパスの数・一時リソースのメモリ(共有しない場合との比較)を計測する
+int GraphBenchmarkCommand(const char *command_line){
+	static const int pass_nums[] = {100, 300, 1000};
+
+	int iteration_num = 100;
+	sscanf(command_line, "-graphbench %d", &iteration_num);
+	if(iteration_num < 1){
+		return -1;
+	}
+
+	Checker checker("graphbench", 40);
+
+	//描画と同じ宣言で、リソースはバックバッファ・深度バッファ・シャドウマップ・キャッシュ・横にぼかしたモーメント・ぼかしたモーメントの順
+	const RenderResource renderer_resources[GRAPH_RESOURCE_NUM] = {{2}, {6}, {1}, {7}, {8}, {9}};
+	auto declare_renderer = [&renderer_resources](RenderGraph *graph, bool evsm, int passes[PASS_NUM], int resources[GRAPH_RESOURCE_NUM], ResourceStateTracker *tracker){
+		RendererGraphDesc desc{};
+		for(int r = 0; r < GRAPH_RESOURCE_NUM; ++r){
+			desc.resources[r] = renderer_resources[r];
+			tracker->Register(renderer_resources[r], (r == GRAPH_BACK_BUFFER) ? RENDER_STATE_PRESENT : (r < GRAPH_SHADOW_BLUR) ? RENDER_STATE_DEPTH_WRITE : RENDER_STATE_RENDER_TARGET);
+		}
+		desc.scene_depth_size		= 2 * 1024 * 1024;
+		desc.scene_depth_alignment	= 64 * 1024;
+		desc.shadow_blur_size		= 3 * 16 * 1024 * 1024;
+		desc.shadow_blur_alignment	= 64 * 1024;
+		desc.evsm					= evsm;
+		DeclareRendererGraph(graph, desc, passes, resources);
+	};
+	auto enable_renderer_passes = [](RenderGraph *graph, const int passes[PASS_NUM], const RendererPassState &state){
+		for(int pass = 0; pass < PASS_NUM; ++pass){
+			graph->SetPassEnabled(passes[pass], IsRendererPassEnabled(pass, state));
+		}
+	};
+	auto pass_order = [](const int passes[PASS_NUM], std::initializer_list<int> names){
+		std::vector<int> order;
+		for(int name : names){
+			order.push_back(passes[name]);
+		}
+		return order;
+	};
+
+	//デバッグ表示を外すと、そのパスだけが削除されて通常の描画の最後にバックバッファを戻す
+	{
+		RenderGraph graph;
+		ResourceStateTracker tracker;
+		int passes[PASS_NUM];
+		int resources[GRAPH_RESOURCE_NUM];
+		declare_renderer(&graph, false, passes, resources, &tracker);
+
+		//EVSM以外ではぼかしのパスを外す
+		RendererPassState state{ShadowCache::REDRAW_FULL, true, true, false, true};
+		enable_renderer_passes(&graph, passes, state);
+		const bool compiled = graph.Compile();
+		checker.Check("renderer graph compiles in order", compiled && graph.Order() == pass_order(passes, {PASS_SHADOW_CACHE, PASS_SHADOW_COPY, PASS_SHADOW, PASS_MAIN, PASS_DEBUG}));
+		checker.Check("only scene depth is placed", graph.TransientSize() == 2 * 1024 * 1024 && graph.GetStats().aliased_num == 0);
+
+		state.show_shadow_map = false;
+		enable_renderer_passes(&graph, passes, state);
+		graph.Compile();
+		graph.BuildBarriers(&tracker);
+		const std::vector<RenderBarrier> &end = graph.EndBarriers(passes[PASS_MAIN]);
+		checker.Check("debug pass is culled when disabled", graph.IsCulled(passes[PASS_DEBUG]) && !graph.IsCulled(passes[PASS_SHADOW_CACHE]) && graph.Order().size() == 4);
+		checker.Check("main pass returns the back buffer", end.size() == 1 && end[0].resource.value == 2 && end[0].after == RENDER_STATE_PRESENT);
+
+		//描き直さないフレームは前のフレームのシャドウマップをそのまま読む(遷移もいらない)
+		state.redraw = ShadowCache::REDRAW_NONE;
+		enable_renderer_passes(&graph, passes, state);
+		const bool skipped = graph.Compile();
+		graph.BuildBarriers(&tracker);
+		bool shadow_barrier = false;
+		for(const RenderBarrier &barrier : graph.BeginBarriers(passes[PASS_MAIN])){
+			shadow_barrier = shadow_barrier || (barrier.resource.value == 1);
+		}
+		checker.Check("shadow passes can be skipped", skipped && graph.Order() == pass_order(passes, {PASS_MAIN}) && !shadow_barrier);
+	}
+
+	//EVSMでは横にぼかしたモーメントを縦のぼかしの後は使わないので、深度バッファと同じメモリに置いて使い始めに切り替える
+	{
+		RenderGraph graph;
+		ResourceStateTracker tracker;
+		int passes[PASS_NUM];
+		int resources[GRAPH_RESOURCE_NUM];
+		declare_renderer(&graph, true, passes, resources, &tracker);
+
+		RendererPassState state{ShadowCache::REDRAW_FULL, true, true, true, true};
+		enable_renderer_passes(&graph, passes, state);
+		const bool compiled = graph.Compile();
+		graph.BuildBarriers(&tracker);
+		checker.Check("evsm graph blurs between shadow and main", compiled && graph.Order() == pass_order(passes,
+			{PASS_SHADOW_CACHE, PASS_SHADOW_COPY, PASS_SHADOW, PASS_SHADOW_BLUR_X, PASS_SHADOW_BLUR_Y, PASS_MAIN, PASS_DEBUG}));
+
+		auto has_aliasing = [&graph](int pass, uint64_t resource){
+			for(const RenderBarrier &barrier : graph.BeginBarriers(pass)){
+				if(barrier.type == RENDER_BARRIER_ALIASING && barrier.resource.value == resource){
+					return true;
+				}
+			}
+			return false;
+		};
+		checker.Check("blur intermediate aliases scene depth", graph.TransientSize() == 3 * 16 * 1024 * 1024 && graph.GetStats().aliased_num == 2 &&
+			graph.TransientOffset(resources[GRAPH_SCENE_DEPTH]) == graph.TransientOffset(resources[GRAPH_SHADOW_BLUR]));
+		checker.Check("aliasing barriers at blur and main", has_aliasing(passes[PASS_SHADOW_BLUR_X], 8) && has_aliasing(passes[PASS_MAIN], 6));
+
+		//描き直さないフレームはぼかさずに前のモーメントを読む
+		state.redraw = ShadowCache::REDRAW_NONE;
+		enable_renderer_passes(&graph, passes, state);
+		const bool skipped = graph.Compile();
+		checker.Check("blur passes skip with the shadow map", skipped && graph.Order() == pass_order(passes, {PASS_MAIN, PASS_DEBUG}) && graph.GetStats().aliased_num == 0);
+	}
+
+	//出力が使われないパスと、そのパスにしか使われないパスは削除される
+	//使われる間が重ならない一時リソースは同じメモリを共有し、使い始めに切り替えのバリアが入る
+	{
+		RenderGraph graph;
+		const int back_buffer = graph.ImportResource("back buffer", RenderResource{1}, RENDER_STATE_PRESENT);
+		const int unused = graph.CreateTransient("unused", 1024 * 1024, 64 * 1024);
+		const int unused2 = graph.CreateTransient("unused2", 1024 * 1024, 64 * 1024);
+		const int a = graph.CreateTransient("a", 1024 * 1024, 64 * 1024);
+		const int b = graph.CreateTransient("b", 1024 * 1024, 64 * 1024);
+		const int c = graph.CreateTransient("c", 1024 * 1024, 64 * 1024);
+		const int producer = graph.AddPass("producer");
+		graph.Write(producer, unused, RENDER_STATE_RENDER_TARGET);
+		const int consumer = graph.AddPass("consumer of unused");
+		graph.Read(consumer, unused, RENDER_STATE_SHADER_RESOURCE);
+		graph.Write(consumer, unused2, RENDER_STATE_RENDER_TARGET);
+		const int p0 = graph.AddPass("write a");
+		graph.Write(p0, a, RENDER_STATE_RENDER_TARGET);
+		const int p1 = graph.AddPass("a to b");
+		graph.Read(p1, a, RENDER_STATE_SHADER_RESOURCE);
+		graph.Write(p1, b, RENDER_STATE_RENDER_TARGET);
+		const int p2 = graph.AddPass("b to c");
+		graph.Read(p2, b, RENDER_STATE_SHADER_RESOURCE);
+		graph.Write(p2, c, RENDER_STATE_RENDER_TARGET);
+		const int p3 = graph.AddPass("c to back buffer");
+		graph.Read(p3, c, RENDER_STATE_SHADER_RESOURCE);
+		graph.Write(p3, back_buffer, RENDER_STATE_RENDER_TARGET);
+		for(int r = 1; r < graph.ResourceNum(); ++r){
+			graph.SetResource(r, RenderResource{static_cast<uint64_t>(r + 1)});
+		}
+
+		const bool compiled = graph.Compile();
+		checker.Check("unused outputs are culled", compiled && graph.IsCulled(producer) && graph.IsCulled(consumer) && graph.Order().size() == 4);
+
+		ResourceStateTracker tracker;
+		tracker.Register(RenderResource{1}, RENDER_STATE_PRESENT);
+		for(int r = 1; r < graph.ResourceNum(); ++r){
+			tracker.Register(RenderResource{static_cast<uint64_t>(r + 1)}, RENDER_STATE_SHADER_RESOURCE);
+		}
+		graph.BuildBarriers(&tracker);
+		bool aliasing = false;
+		for(const RenderBarrier &barrier : graph.BeginBarriers(p2)){
+			aliasing = aliasing || (barrier.type == RENDER_BARRIER_ALIASING && barrier.resource.value == static_cast<uint64_t>(c + 1));
+		}
+		checker.Check("transients with disjoint lifetimes alias", graph.TransientSize() == 2 * 1024 * 1024 && graph.GetStats().aliased_num == 2 && aliasing);
+
+		const int read_first = graph.AddPass("reads before write");
+		graph.Read(read_first, graph.CreateTransient("never written", 1024, 1024), RENDER_STATE_SHADER_RESOURCE);
+		checker.Check("reading an unwritten transient fails", !graph.Compile());
+	}
+
+	//乱数で作ったグラフ
+	for(int pass_num : pass_nums){
+		RenderGraph graph;
+		RenderGraph again;
+		std::vector<GraphAccess> accesses;
+		std::vector<uint64_t> sizes;
+		DeclareRandomGraph(&graph, pass_num, 12345u + pass_num, &accesses, &sizes);
+		DeclareRandomGraph(&again, pass_num, 12345u + pass_num, &accesses, &sizes);
+
+		graph.Compile();
+		again.Compile();
+		bool same = graph.Order() == again.Order();
+		for(int r = 0; r < graph.ResourceNum(); ++r){
+			same = same && graph.TransientOffset(r) == again.TransientOffset(r);
+		}
+
+		char name[64];
+		snprintf(name, sizeof(name), "%d passes: deterministic", pass_num);
+		checker.Check(name, same);
+		snprintf(name, sizeof(name), "%d passes: order and aliasing are valid", pass_num);
+		checker.Check(name, IsGraphValid(graph, accesses, sizes, 64 * 1024));
+
+		const auto begin = std::chrono::steady_clock::now();
+		for(int i = 0; i < iteration_num; ++i){
+			graph.Compile();
+		}
+		const double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - begin).count() / iteration_num;
+
+		const RenderGraph::Stats &stats = graph.GetStats();
+		PrintLine("[graphbench] %5d passes  compile %9.1f us  culled %4u  transients %4u  memory %7llu KB  unaliased %8llu KB\n",
+			pass_num, us, stats.culled_num, stats.transient_num,
+			static_cast<unsigned long long>(stats.transient_size / 1024), static_cast<unsigned long long>(stats.unaliased_size / 1024));
+	}
+
+	return checker.Result();
+}
@@ -0,0 +1,219 @@
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include "HeadlessRenderer.h"
+#include "TestCommon.h"
+
+namespace{
+constexpr RenderResource BACK_BUFFER	= {1};
+constexpr RenderResource DEPTH_BUFFER	= {2};
+
+//1フレーム分の描画を記録する(コマンド22個・描画4回・バリア3個を2回に分けて・状態の切り替え4回)
+void RecordCheckFrame(HeadlessCommandList *list){
+	const RenderBarrier begin_barriers[] = {
+		{BACK_BUFFER, RENDER_ALL_SUBRESOURCES, RENDER_STATE_PRESENT, RENDER_STATE_RENDER_TARGET, RENDER_BARRIER_FULL},
+		{DEPTH_BUFFER, RENDER_ALL_SUBRESOURCES, RENDER_STATE_DEPTH_READ, RENDER_STATE_DEPTH_WRITE, RENDER_BARRIER_FULL},
+	};
+	const RenderBarrier end_barrier = {BACK_BUFFER, RENDER_ALL_SUBRESOURCES, RENDER_STATE_RENDER_TARGET, RENDER_STATE_PRESENT, RENDER_BARRIER_FULL};
+	const float clear_color[4] = {0.0f, 0.0f, 0.0f, 1.0f};
+	const uint32_t constants[2] = {1, 2};
+	const RenderTargetView rtv{10};
+	const RenderTargetView dsv{11};
+
+	list->ResourceBarriers(2, begin_barriers);
+	list->ResourceBarriers(0, nullptr);		//空のバリアは数えない
+	list->SetRootSignature(RenderRootSignature{1});
+	list->SetPipeline(RenderPipeline{1});
+	list->SetDescriptorHeap(RenderDescriptorHeap{1});
+	list->SetViewport(RenderViewport{0.0f, 0.0f, 640.0f, 480.0f, 0.0f, 1.0f});
+	list->SetScissorRect(RenderRect{0, 0, 640, 480});
+	list->SetRenderTargets(1, &rtv, dsv);
+	list->ClearRenderTarget(rtv, clear_color);
+	list->ClearDepth(dsv, 1.0f);
+	list->SetTopology(RENDER_TOPOLOGY_TRIANGLE_LIST);
+	list->SetVertexBuffer(0, HeadlessUploadHeap::GPU_ADDRESS_BASE, 3 * 32, 32);
+	list->SetIndexBuffer(HeadlessUploadHeap::GPU_ADDRESS_BASE + 256, 6 * sizeof(uint16_t), RENDER_INDEX_16);
+	list->SetConstantBuffer(0, HeadlessUploadHeap::GPU_ADDRESS_BASE + 512);
+	list->SetRootConstants(1, 2, constants, 0);
+	list->SetDescriptorTable(2, RenderDescriptorTable{1});
+	for(int i = 0; i < 3; ++i){
+		list->DrawIndexed(6, 1, 0, 0, 0);
+	}
+	list->SetPipeline(RenderPipeline{2});
+	list->Draw(3, 1, 0, 0);
+	list->ResourceBarriers(1, &end_barrier);
+}
+
+uint64_t CountCommands(const HeadlessCommandList &list, HeadlessCommandType type){
+	uint64_t num = 0;
+	for(const HeadlessCommand &command : list.Commands()){
+		num += (command.type == type) ? 1 : 0;
+	}
+	return num;
+}
+}
+
+
+//DirectX12Tests -headlesscheck
+//ヘッドレスのバックエンドが数えるコマンド数・バリア数・アップロード量を、決まった手順の記録と突き合わせる
+//・コマンドリスト: コマンド・描画・バリア・バリアの呼び出し・状態の切り替えの数と、記録したコマンドの種類
+//・キュー: 実行したリストの統計の合計と、リストをまたいだリソースの状態・フェンス値
+//・誤った使い方(描画前の設定の抜け・Begin/Endの外の記録・状態の食い違い)がそれぞれ1つのエラーになる
+//・アップロードヒープ: 割り当てのバイト数・回数・失敗の数・アライメント・GPUアドレス・フレームの解放
+//・ストリーミングの転送先: ステージングに書き込んだバイト数・遅れて完了するフェンス値・ステージングが足りない場合の失敗
+int HeadlessRendererCheckCommand(const char *){
+	Checker checker("headlesscheck");
+
+
+	//コマンドリストとキュー
+	{
+		HeadlessCommandList list;
+		list.Begin(0);
+		RecordCheckFrame(&list);
+		list.End();
+
+		const HeadlessStats &stats = list.Stats();
+		checker.Check("command count", stats.command_num == 22 && list.Commands().size() == 22);
+		checker.Check("draw count", stats.draw_num == 4 && CountCommands(list, HEADLESS_DRAW_INDEXED) == 3 && CountCommands(list, HEADLESS_DRAW) == 1);
+		checker.Check("barrier count", stats.barrier_num == 3 && CountCommands(list, HEADLESS_BARRIER) == 3);
+		checker.Check("barrier batch count skips empty batches", stats.barrier_batch_num == 2);
+		checker.Check("state change count", stats.state_change_num == 4);
+		checker.Check("valid frame has no errors", stats.error_num == 0 && list.Errors().empty());
+
+		const HeadlessCommand &first = list.Commands().front();
+		checker.Check("barrier arguments are recorded", first.type == HEADLESS_BARRIER && first.args[0] == BACK_BUFFER.value
+			&& first.args[1] == RENDER_STATE_PRESENT && first.args[2] == RENDER_STATE_RENDER_TARGET);
+
+		//Beginで前の記録は消える
+		list.Begin(1);
+		list.End();
+		checker.Check("Begin resets commands and stats", list.Commands().empty() && list.Stats().command_num == 0);
+
+		//2フレーム分を提出する
+		HeadlessCommandList frames[2];
+		for(HeadlessCommandList &frame : frames){
+			frame.Begin(0);
+			RecordCheckFrame(&frame);
+			frame.End();
+		}
+		HeadlessCommandList *lists[] = {&frames[0], &frames[1]};
+		HeadlessQueue queue;
+		queue.SetResourceState(BACK_BUFFER, RENDER_STATE_PRESENT);
+		queue.SetResourceState(DEPTH_BUFFER, RENDER_STATE_DEPTH_READ);
+		queue.Execute(2, lists);
+		const HeadlessStats &queue_stats = queue.Stats();
+		checker.Check("queue sums the list stats", queue_stats.command_num == 44 && queue_stats.draw_num == 8
+			&& queue_stats.barrier_num == 6 && queue_stats.barrier_batch_num == 4 && queue_stats.state_change_num == 8);
+
+		//2フレーム目は深度バッファがDEPTH_WRITEのままなのでDEPTH_READからの遷移が食い違う
+		RenderResourceState back_buffer_state{};
+		queue.GetResourceState(BACK_BUFFER, &back_buffer_state);
+		checker.Check("queue tracks states across lists", back_buffer_state == RENDER_STATE_PRESENT && queue_stats.error_num == 1 && queue.Errors().size() == 1);
+
+		const uint64_t fence = queue.Signal();
+		checker.Check("signal completes immediately", fence == 1 && queue.CompletedValue() == 1 && queue.Signal() == 2);
+
+		queue.ResetStats();
+		checker.Check("ResetStats clears the queue stats", queue.Stats().command_num == 0 && queue.Errors().empty());
+	}
+
+	//誤った使い方はそれぞれ1つのエラーになる
+	{
+		HeadlessCommandList list;
+		list.Begin(0);
+		list.SetRootSignature(RenderRootSignature{1});
+		list.SetViewport(RenderViewport{0.0f, 0.0f, 64.0f, 64.0f, 0.0f, 1.0f});
+		list.SetScissorRect(RenderRect{0, 0, 64, 64});
+		const RenderTargetView rtv{1};
+		list.SetRenderTargets(1, &rtv, RenderTargetView{});
+		list.SetTopology(RENDER_TOPOLOGY_TRIANGLE_LIST);
+		list.Draw(3, 1, 0, 0);
+		checker.Check("draw without a pipeline", list.Stats().error_num == 1 && list.Stats().draw_num == 1);
+
+		const RenderBarrier to_copy = {BACK_BUFFER, RENDER_ALL_SUBRESOURCES, RENDER_STATE_PRESENT, RENDER_STATE_COPY_DEST, RENDER_BARRIER_FULL};
+		const RenderBarrier stale = {BACK_BUFFER, RENDER_ALL_SUBRESOURCES, RENDER_STATE_PRESENT, RENDER_STATE_RENDER_TARGET, RENDER_BARRIER_FULL};
+		list.ResourceBarriers(1, &to_copy);
+		list.ResourceBarriers(1, &stale);
+		checker.Check("barrier from a stale state", list.Stats().error_num == 2);
+
+		list.End();
+		list.SetTopology(RENDER_TOPOLOGY_TRIANGLE_LIST);
+		checker.Check("command outside Begin/End", list.Stats().error_num == 3);
+
+		list.End();
+		checker.Check("End without Begin", list.Stats().error_num == 4 && list.Errors().size() == 4);
+	}
+
+
+	//アップロードヒープ
+	{
+		static constexpr uint64_t HEAP_SIZE = 64 * 1024;
+		HeadlessUploadHeap heap(HEAP_SIZE);
+
+		bool aligned = true;
+		bool addressed = true;
+		for(int i = 0; i < 10; ++i){
+			RenderUploadHeap::Allocation allocation{};
+			if(!heap.AllocateConstant(100, &allocation)){
+				aligned = false;
+				continue;
+			}
+			aligned = aligned && (allocation.offset % RenderUploadHeap::CONSTANT_ALIGNMENT == 0);
+			addressed = addressed && (allocation.gpu_address == HeadlessUploadHeap::GPU_ADDRESS_BASE + allocation.offset);
+			memset(allocation.cpu_address, i, 100);
+		}
+		checker.Check("constants are 256-byte aligned", aligned);
+		checker.Check("GPU address is the base plus the offset", addressed);
+		checker.Check("uploaded bytes count the requested sizes", heap.UploadedBytes() == 1000 && heap.AllocationNum() == 10);
+		checker.Check("used size includes the alignment padding", heap.UsedSize() == 9 * 256 + 100);
+
+		//使い切ると失敗を数える
+		RenderUploadHeap::Allocation allocation{};
+		int allocated = 0;
+		while(heap.Allocate(4096, 16, &allocation)){
+			++allocated;
+		}
+		checker.Check("full heap counts failures", heap.FailedNum() == 1 && allocated == 15);
+
+		heap.FinishFrame(1);
+		heap.ReleaseCompletedFrames(0);
+		checker.Check("frame in flight keeps its allocations", heap.UsedSize() > 0);
+		heap.ReleaseCompletedFrames(1);
+		checker.Check("completed frame frees the heap", heap.UsedSize() == 0);
+
+		heap.ResetStats();
+		checker.Check("ResetStats clears the counters", heap.UploadedBytes() == 0 && heap.AllocationNum() == 0 && heap.FailedNum() == 0);
+	}
+
+
+	//ストリーミングの転送先
+	{
+		static constexpr int LATENCY = 2;
+		static constexpr int WIDTH = 100;	//行は400バイトで、ステージングでは512バイトに揃える
+		static constexpr int HEIGHT = 64;
+		std::vector<unsigned char> pixels(WIDTH * 4 * HEIGHT, 0x80);
+		const TextureLevel level = {WIDTH, HEIGHT, WIDTH * 4, HEIGHT, pixels.data()};
+
+		HeadlessStreamTarget target;
+		target.Initialize(64 * 1024, LATENCY);
+		const bool uploaded = target.UploadRows(RenderResource{1}, TEXTURE_FORMAT_BGRA8, 0, level, 0, HEIGHT);
+		checker.Check("stream upload writes pitched rows", uploaded && target.UploadedBytes() == 512 * (HEIGHT - 1) + WIDTH * 4);
+
+		const bool sliced = target.UploadRows(RenderResource{1}, TEXTURE_FORMAT_BGRA8, 0, level, 16, 8);
+		checker.Check("stream upload of a row range", sliced && target.UploadedBytes() == 512 * (HEIGHT - 1) + WIDTH * 4 + 512 * 7 + WIDTH * 4);
+
+		//64KBのステージングに32KBの転送は残りに収まらない
+		const bool overflow = target.UploadRows(RenderResource{1}, TEXTURE_FORMAT_BGRA8, 0, level, 0, HEIGHT);
+		checker.Check("full staging counts failures", !overflow && target.FailedNum() == 1);
+
+		const uint64_t fence = target.Submit();
+		target.EndFrame();
+		const bool pending = target.CompletedValue() == 0;
+		target.EndFrame();
+		checker.Check("submit completes after the latency", fence == 1 && pending && target.CompletedValue() == 1);
+		checker.Check("completed staging is reused", target.UploadRows(RenderResource{1}, TEXTURE_FORMAT_BGRA8, 0, level, 0, HEIGHT));
+	}
+
+	return checker.Result();
+}
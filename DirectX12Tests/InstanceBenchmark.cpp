@@ -0,0 +1,111 @@
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <chrono>
+#include <vector>
+#include "InstanceTransform.h"
+#include "HeadlessRenderer.h"
+#include "TestCommon.h"
+
+//DirectX12Tests -instbench [フレーム数]
+//球を1個ずつ定数バッファで描く場合とインスタンス描画の場合について、
+//CPUでの更新時間・記録時間と1フレームあたりの描画コマンド数をヘッドレスのバックエンドで計測する
+int InstanceBenchmarkCommand(const char *command_line){
+	typedef InstanceTransform::InstanceData InstanceData;
+	static const int instance_nums[] = {1, 1000, 100000};
+	//Sphereと同じ頂点・インデックスの数(頂点は位置・法線・UVのfloatが8個)
+	static constexpr int VERT_NUM = 32;
+	static constexpr int ARC_NUM = 32;
+	static constexpr int TEXTURE_NUM = 2;
+	static constexpr int MAX_INSTANCE_NUM = 100000;
+	static constexpr uint32_t VERTEX_SIZE = 8 * sizeof(float);
+	static constexpr uint32_t INDEX_NUM = (VERT_NUM - 1) * ARC_NUM * 6;
+
+	int frame_num = 60;
+	sscanf(command_line, "-instbench %d", &frame_num);
+	if(frame_num < 1){
+		return -1;
+	}
+
+	//1個ずつの場合は1インスタンスに256バイトの定数を使う
+	HeadlessUploadHeap upload_heap(2 * MAX_INSTANCE_NUM * RenderUploadHeap::CONSTANT_ALIGNMENT);
+	HeadlessCommandList command_list;
+	std::vector<InstanceData> scratch;
+
+	for(int num : instance_nums){
+		InstanceTransform instances;
+		instances.Resize(num);
+		for(int i = 0; i < num; ++i){
+			instances.Set(i, 0.1f * (i % 47), 0.1f * ((i / 47) % 47), 0.1f * (i / (47 * 47)), 0.04f, 0.5f * i, 0.0035f, i % TEXTURE_NUM);
+		}
+		scratch.resize(num);
+
+		for(int instanced = 0; instanced < 2; ++instanced){
+			double update_ms{};
+			double record_ms{};
+			uint64_t draw_num{};
+			uint64_t failed_num{};
+
+			for(int frame = 0; frame < frame_num; ++frame){
+				const float time = static_cast<float>(frame);
+				const auto begin = std::chrono::steady_clock::now();
+
+				//インスタンスデータの更新
+				RenderUploadHeap::Allocation instance_data{};
+				if(instanced){
+					if(upload_heap.Allocate(sizeof(InstanceData) * num, 16, &instance_data)){
+						instances.Write(time, static_cast<InstanceData*>(instance_data.cpu_address));
+					}
+				}else{
+					instances.WriteScalar(time, scratch.data());
+				}
+				const auto updated = std::chrono::steady_clock::now();
+
+				//描画コマンドの記録
+				command_list.Begin(0);
+				command_list.SetRootSignature(RenderRootSignature{1});
+				command_list.SetPipeline(RenderPipeline{1});
+				command_list.SetViewport(RenderViewport{0.0f, 0.0f, 640.0f, 480.0f, 0.0f, 1.0f});
+				command_list.SetScissorRect(RenderRect{0, 0, 640, 480});
+				const RenderTargetView rtv{1};
+				command_list.SetRenderTargets(1, &rtv, RenderTargetView{2});
+				command_list.SetTopology(RENDER_TOPOLOGY_TRIANGLE_LIST);
+				command_list.SetVertexBuffer(0, HeadlessUploadHeap::GPU_ADDRESS_BASE, VERTEX_SIZE * VERT_NUM * ARC_NUM, VERTEX_SIZE);
+				command_list.SetIndexBuffer(HeadlessUploadHeap::GPU_ADDRESS_BASE, INDEX_NUM * sizeof(uint16_t), RENDER_INDEX_16);
+
+				if(instanced){
+					command_list.SetVertexBuffer(1, instance_data.gpu_address, sizeof(InstanceData) * num, sizeof(InstanceData));
+					command_list.DrawIndexed(INDEX_NUM, num, 0, 0, 0);
+				}else{
+					for(int i = 0; i < num; ++i){
+						RenderUploadHeap::Allocation constant{};
+						if(!upload_heap.AllocateConstant(sizeof(InstanceData), &constant)){
+							break;
+						}
+						memcpy(constant.cpu_address, &scratch[i], sizeof(InstanceData));
+						command_list.SetConstantBuffer(0, constant.gpu_address);
+						command_list.DrawIndexed(INDEX_NUM, 1, 0, 0, 0);
+					}
+				}
+				command_list.End();
+				const auto recorded = std::chrono::steady_clock::now();
+
+				update_ms += std::chrono::duration<double, std::milli>(updated - begin).count();
+				record_ms += std::chrono::duration<double, std::milli>(recorded - updated).count();
+				draw_num += command_list.Stats().draw_num;
+
+				//GPUは即座に完了したものとして扱う
+				upload_heap.FinishFrame(frame + 1);
+				upload_heap.ReleaseCompletedFrames(frame + 1);
+			}
+			failed_num += upload_heap.FailedNum();
+			upload_heap.ResetStats();
+
+			PrintLine("[instbench] %6d spheres  %-9s  update %8.3f ms  record %8.3f ms  %6llu draws/frame%s\n",
+				num, instanced ? "instanced" : "per-draw", update_ms / frame_num, record_ms / frame_num,
+				static_cast<unsigned long long>(draw_num / frame_num), failed_num > 0 ? "  (upload heap full)" : "");
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,230 @@
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <chrono>
+#include <cmath>
+#include <algorithm>
+#include <vector>
+#include "MipChain.h"
+#include "TestCommon.h"
+
+namespace{
+typedef MipChain::byte byte;
+
+double ToLinear(int c){
+	const double v = c / 255.0;
+	return (v <= 0.04045) ? v / 12.92 : std::pow((v + 0.055) / 1.055, 2.4);
+}
+
+int ToSrgb(double l){
+	const double c = (l <= 0.0031308) ? l * 12.92 : 1.055 * std::pow(l, 1.0 / 2.4) - 0.055;
+	return static_cast<int>(std::min(255.0, std::max(0.0, c * 255.0 + 0.5)));
+}
+
+//縮小後のindex番目の画素に平均する元の画素の範囲[first, first + num)
+void GetTaps(int src_size, int index, int dst_size, int *first, int *num){
+	*first = (src_size == 1) ? 0 : index * 2;
+	*num = (src_size == 1) ? 1 : (src_size % 2 == 1 && index == dst_size - 1) ? 3 : 2;
+}
+
+//倍精度で平均した縮小(テーブルの量子化があるので比較は±1まで)
+void ReferenceDownsample(const byte *src, int width, int height, int pitch, byte *dst, int dst_pitch){
+	const int dst_width  = std::max(1, width / 2);
+	const int dst_height = std::max(1, height / 2);
+	for(int y = 0; y < dst_height; ++y){
+		int y0, ny;
+		GetTaps(height, y, dst_height, &y0, &ny);
+		for(int x = 0; x < dst_width; ++x){
+			int x0, nx;
+			GetTaps(width, x, dst_width, &x0, &nx);
+			double sum[4]{};
+			for(int sy = y0; sy < y0 + ny; ++sy){
+				for(int sx = x0; sx < x0 + nx; ++sx){
+					const byte *p = src + sy * pitch + sx * MipChain::PIXEL_SIZE;
+					for(int c = 0; c < 3; ++c){
+						sum[c] += ToLinear(p[c]);
+					}
+					sum[3] += p[3];
+				}
+			}
+			byte *d = dst + y * dst_pitch + x * MipChain::PIXEL_SIZE;
+			for(int c = 0; c < 3; ++c){
+				d[c] = static_cast<byte>(ToSrgb(sum[c] / (nx * ny)));
+			}
+			d[3] = static_cast<byte>(std::lround(sum[3] / (nx * ny)));
+		}
+	}
+}
+
+//2つの縮小結果の差の最大
+int MaxDifference(const std::vector<byte> &a, const std::vector<byte> &b){
+	int diff = 0;
+	for(size_t i = 0; i < a.size(); ++i){
+		diff = std::max(diff, std::abs(a[i] - b[i]));
+	}
+	return diff;
+}
+}
+
+
+//DirectX12Tests -mipbench [計測の繰り返し回数]
+//MipChainの縮小をスカラー実装・倍精度の平均と突き合わせ、速度を計測する
+//・Downsampleは様々なサイズ・ピッチ(幅や高さが1、奇数を含む)でDownsampleScalarとビット単位で一致する
+//・倍精度で平均した縮小との差は±1以内で、奇数の最後の列・行は3画素の平均になる
+//・Generateの各レベルはDownsampleを繰り返した結果と一致する
+//・大きな画像と奇数サイズの画像でスカラー実装とSIMDの処理速度(MP/s)を比べる
+int MipChainBenchmarkCommand(const char *command_line){
+	int repeat_num = 5;
+	sscanf(command_line, "-mipbench %d", &repeat_num);
+	if(repeat_num < 1){
+		return -1;
+	}
+
+	Checker checker("mipbench");
+
+	TestRandom random(24680u);
+
+	PrintLine("[mipbench] %s\n", MipChain::InstructionSet());
+
+
+	//スカラー実装・倍精度の平均との比較
+	{
+		static const int SIZES[] = {1, 2, 3, 4, 5, 7, 8, 9, 15, 16, 17, 31, 33, 64, 67};
+		bool bitwise = true;
+		bool inside = true;
+		int reference_diff = 0;
+		int case_num = 0;
+		for(int width : SIZES){
+			for(int height : SIZES){
+				//行の終わりに余白があるピッチも試す
+				const int pitch = width * MipChain::PIXEL_SIZE + (random.Next() % 3) * 4;
+				std::vector<byte> src(static_cast<size_t>(pitch) * height);
+				for(byte &b : src){
+					b = static_cast<byte>(random.Next());
+				}
+
+				const int dst_width  = std::max(1, width / 2);
+				const int dst_height = std::max(1, height / 2);
+				const int dst_pitch = dst_width * MipChain::PIXEL_SIZE + 8;
+				std::vector<byte> simd(static_cast<size_t>(dst_pitch) * dst_height, 0xcd);
+				std::vector<byte> scalar(simd.size(), 0xcd);
+				std::vector<byte> reference(simd.size(), 0xcd);
+				MipChain::Downsample(src.data(), width, height, pitch, simd.data(), dst_pitch);
+				MipChain::DownsampleScalar(src.data(), width, height, pitch, scalar.data(), dst_pitch);
+				ReferenceDownsample(src.data(), width, height, pitch, reference.data(), dst_pitch);
+
+				bitwise = bitwise && (simd == scalar);
+				reference_diff = std::max(reference_diff, MaxDifference(scalar, reference));
+				for(int y = 0; y < dst_height; ++y){
+					for(int i = dst_width * MipChain::PIXEL_SIZE; i < dst_pitch; ++i){
+						inside = inside && (simd[y * dst_pitch + i] == 0xcd);
+					}
+				}
+				++case_num;
+			}
+		}
+
+		char name[96];
+		snprintf(name, sizeof(name), "%d sizes match DownsampleScalar bitwise", case_num);
+		checker.Check(name, bitwise);
+		snprintf(name, sizeof(name), "within 1 of the double reference (max %d)", reference_diff);
+		checker.Check(name, reference_diff <= 1);
+		checker.Check("row padding is not written", inside);
+	}
+
+	//奇数の最後の列・行
+	{
+		//黒・黒・白の3x1は1/3の明るさになる(2画素だけでは黒になる)
+		const byte row[12] = {0, 0, 0, 255, 0, 0, 0, 255, 255, 255, 255, 255};
+		byte dst[4]{};
+		MipChain::Downsample(row, 3, 1, sizeof(row), dst, sizeof(dst));
+		const int expected = ToSrgb(1.0 / 3.0);
+		checker.Check("3x1 black black white averages three pixels", std::abs(dst[0] - expected) <= 1 && dst[0] == dst[1] && dst[1] == dst[2] && dst[3] == 255);
+
+		//5x5の最後の列・行を変えると縮小後の端の画素が変わる
+		const int pitch = 5 * MipChain::PIXEL_SIZE;
+		std::vector<byte> src(pitch * 5, 0);
+		byte before[2 * 2 * 4], after_column[2 * 2 * 4], after_row[2 * 2 * 4];
+		MipChain::Downsample(src.data(), 5, 5, pitch, before, 2 * MipChain::PIXEL_SIZE);
+		for(int y = 0; y < 5; ++y){
+			std::memset(&src[y * pitch + 4 * MipChain::PIXEL_SIZE], 255, MipChain::PIXEL_SIZE);
+		}
+		MipChain::Downsample(src.data(), 5, 5, pitch, after_column, 2 * MipChain::PIXEL_SIZE);
+		checker.Check("last column of an odd width reaches level 1", after_column[4] != before[4] && after_column[12] != before[12]
+			&& after_column[0] == before[0] && after_column[8] == before[8]);
+
+		std::fill(src.begin(), src.end(), 0);
+		std::memset(&src[4 * pitch], 255, pitch);
+		MipChain::Downsample(src.data(), 5, 5, pitch, after_row, 2 * MipChain::PIXEL_SIZE);
+		checker.Check("last row of an odd height reaches level 1", after_row[8] != before[8] && after_row[12] != before[12]
+			&& after_row[0] == before[0] && after_row[4] == before[4]);
+
+		//一様な画像は端でも値が変わらない
+		bool flat = true;
+		for(int value = 0; value < 256; value += 5){
+			std::vector<byte> image(7 * 3 * MipChain::PIXEL_SIZE, static_cast<byte>(value));
+			byte small[3 * 1 * 4];
+			MipChain::Downsample(image.data(), 7, 3, 7 * MipChain::PIXEL_SIZE, small, sizeof(small));
+			for(byte b : small){
+				flat = flat && std::abs(b - value) <= 1;
+			}
+		}
+		checker.Check("constant odd image stays constant", flat);
+	}
+
+	//Generate
+	{
+		const int width = 37;
+		const int height = 20;
+		std::vector<byte> src(width * height * MipChain::PIXEL_SIZE);
+		for(byte &b : src){
+			b = static_cast<byte>(random.Next());
+		}
+		MipChain chain;
+		bool generated = chain.Generate(src.data(), width, height, width * MipChain::PIXEL_SIZE);
+		bool matched = generated && chain.LevelNum() == MipChain::CalcLevelNum(width, height) && chain.LevelNum() == 6;
+		std::vector<byte> prev = src;
+		for(int i = 1; matched && i < chain.LevelNum(); ++i){
+			const MipChain::Level &p = chain.GetLevel(i - 1);
+			const MipChain::Level &level = chain.GetLevel(i);
+			std::vector<byte> expected(static_cast<size_t>(level.row_pitch) * level.height);
+			MipChain::Downsample(prev.data(), p.width, p.height, p.width * MipChain::PIXEL_SIZE, expected.data(), level.row_pitch);
+			matched = std::memcmp(expected.data(), level.pixels, expected.size()) == 0;
+			prev.swap(expected);
+		}
+		checker.Check("Generate levels match repeated Downsample", matched && chain.GetLevel(5).width == 1 && chain.GetLevel(5).height == 1);
+	}
+
+
+	//計測
+	static const int BENCH_SIZES[][2] = {{4096, 4096}, {2048, 2048}, {1023, 1023}, {1000, 333}};
+	for(const int *size : BENCH_SIZES){
+		const int width = size[0];
+		const int height = size[1];
+		const int pitch = width * MipChain::PIXEL_SIZE;
+		std::vector<byte> src(static_cast<size_t>(pitch) * height);
+		for(byte &b : src){
+			b = static_cast<byte>(random.Next());
+		}
+		const int dst_pitch = std::max(1, width / 2) * MipChain::PIXEL_SIZE;
+		std::vector<byte> dst(static_cast<size_t>(dst_pitch) * std::max(1, height / 2));
+
+		double scalar_ms = 1.0e9, simd_ms = 1.0e9;
+		for(int r = 0; r < repeat_num; ++r){
+			auto start = std::chrono::high_resolution_clock::now();
+			MipChain::DownsampleScalar(src.data(), width, height, pitch, dst.data(), dst_pitch);
+			scalar_ms = std::min(scalar_ms, std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count());
+
+			start = std::chrono::high_resolution_clock::now();
+			MipChain::Downsample(src.data(), width, height, pitch, dst.data(), dst_pitch);
+			simd_ms = std::min(simd_ms, std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count());
+		}
+
+		//MP/sは元の画像の画素数で数える
+		const double mega_pixels = static_cast<double>(width) * height / 1.0e6;
+		PrintLine("[mipbench] %5d x %-5d  scalar %8.3f ms (%7.1f MP/s)  simd %8.3f ms (%7.1f MP/s)  %4.2fx\n",
+			width, height, scalar_ms, mega_pixels / scalar_ms * 1000.0, simd_ms, mega_pixels / simd_ms * 1000.0, scalar_ms / simd_ms);
+	}
+
+	return checker.Result();
+}
@@ -0,0 +1,373 @@
+#include <cstdio>
+#include <cstdint>
+#include <chrono>
+#include <cmath>
+#include <algorithm>
+#include <vector>
+#include "OcclusionCuller.h"
+#include "ShadowCascades.h"
+#include "JobSystem.h"
+#include "TestCommon.h"
+
+namespace{
+//箱の8頂点(添字のビットがx, y, zの大きい側)の12個の三角形
+const uint32_t BOX_INDICES[12 * 3] = {
+	0, 2, 1,  1, 2, 3,
+	4, 5, 6,  5, 7, 6,
+	0, 1, 4,  1, 5, 4,
+	2, 6, 3,  3, 6, 7,
+	0, 4, 2,  2, 4, 6,
+	1, 3, 5,  3, 7, 5,
+};
+
+void BoxVertices(const float min[3], const float max[3], float vertices[8 * 3]){
+	for(int i = 0; i < 8; ++i){
+		for(int k = 0; k < 3; ++k){
+			vertices[i * 3 + k] = ((i >> k) & 1) ? max[k] : min[k];
+		}
+	}
+}
+
+//遮蔽カリングの正解用に、三角形の中に中心があるピクセルごとにfunc(ピクセルの添字, 深度)を呼ぶ
+//近クリップ面に掛かる三角形は扱わない(シーンは全てカメラの前に置く)。funcがfalseを返したら止めてfalseを返す
+template<class F>
+bool RasterizeReference(int width, int height, const ShadowCascades::Matrix &view_proj, const float *vertices, const uint32_t *indices, int triangle_num, F func){
+	for(int t = 0; t < triangle_num; ++t){
+		float x[3], y[3], z[3];
+		bool front = true;
+		for(int k = 0; k < 3; ++k){
+			float clip[4];
+			view_proj.TransformPoint(&vertices[indices[t * 3 + k] * 3], clip);
+			front = front && clip[2] >= 0.0f && clip[3] > 0.0f;
+			x[k] = (clip[0] / clip[3] * 0.5f + 0.5f) * width;
+			y[k] = (0.5f - clip[1] / clip[3] * 0.5f) * height;
+			z[k] = clip[2] / clip[3];
+		}
+		const float area = (x[1] - x[0]) * (y[2] - y[0]) - (x[2] - x[0]) * (y[1] - y[0]);
+		if(!front || area == 0.0f){
+			continue;
+		}
+
+		const int x0 = std::max(static_cast<int>(std::floor(std::min(std::min(x[0], x[1]), x[2]))), 0);
+		const int x1 = std::min(static_cast<int>(std::ceil(std::max(std::max(x[0], x[1]), x[2]))), width);
+		const int y0 = std::max(static_cast<int>(std::floor(std::min(std::min(y[0], y[1]), y[2]))), 0);
+		const int y1 = std::min(static_cast<int>(std::ceil(std::max(std::max(y[0], y[1]), y[2]))), height);
+		for(int py = y0; py < y1; ++py){
+			for(int px = x0; px < x1; ++px){
+				const float cx = px + 0.5f;
+				const float cy = py + 0.5f;
+				const float b0 = ((x[1] - cx) * (y[2] - cy) - (x[2] - cx) * (y[1] - cy)) / area;
+				const float b1 = ((x[2] - cx) * (y[0] - cy) - (x[0] - cx) * (y[2] - cy)) / area;
+				const float b2 = 1.0f - b0 - b1;
+				if(b0 < 0.0f || b1 < 0.0f || b2 < 0.0f){
+					continue;
+				}
+				if(!func(static_cast<size_t>(py) * width + px, b0 * z[0] + b1 * z[1] + b2 * z[2])){
+					return false;
+				}
+			}
+		}
+	}
+	return true;
+}
+
+//遮蔽カリングの計測用のシーン(遮蔽物は三角形、調べるものは箱の最小・最大の6つずつ)
+struct OcclusionScene{
+	const char					*name;
+	ShadowCascades::Matrix		view_proj;
+	std::vector<float>			vertices;
+	std::vector<uint32_t>		indices;
+	std::vector<float>			boxes;
+
+	int TriangleNum() const{return static_cast<int>(indices.size() / 3);}
+	int BoxNum() const{return static_cast<int>(boxes.size() / 6);}
+
+	void AddOccluderBox(const float min[3], const float max[3]){
+		const uint32_t base = static_cast<uint32_t>(vertices.size() / 3);
+		float v[8 * 3];
+		BoxVertices(min, max, v);
+		vertices.insert(vertices.end(), v, v + 8 * 3);
+		for(uint32_t index : BOX_INDICES){
+			indices.push_back(base + index);
+		}
+	}
+};
+}
+
+
+//DirectX12Tests -occlusionbench [遮蔽物の箱の数] [調べる箱の数]
+//合成したシーン(建物の箱が並ぶ街と、アプリの板ポリのような1枚の壁)をCPUの深度バッファに描いて箱を調べ、次のことを確かめる
+//・ジョブで帯に分けて描いた深度バッファが1スレッドで描いたものと一致する
+//・4倍の解像度のZバッファ(ピクセルの中心で深度を比べる)で見える箱を遮蔽されたと判定するのは、
+//  見える部分の幅か高さが1ピクセル未満のもの(遮蔽物の輪郭をピクセルの中心で塗るため)に限る。その割合も表示する
+//・壁の後ろ・前・縁からはみ出すもの・カメラの後ろ・近クリップ面をまたぐもの・画面の外の箱の判定
+//・遮蔽物を描いていなければ、画面の中の箱は全て見える
+//・裏向きの遮蔽物の三角形は描かず、two_sidedを指定したものは裏向きでも描く
+//あわせて、遮蔽物の描画(1スレッド・ジョブ)と問い合わせの所要時間、見えないものを除けた割合を表示する
+int OcclusionBenchmarkCommand(const char *command_line){
+	static constexpr float PI		= 3.14159265358979323846f;
+	static const int REPEAT_NUM		= 5;	//所要時間は最も速かったものを使う
+	static const int SUPERSAMPLE	= 4;	//正解のZバッファの解像度の倍率
+	static const int MAX_CHECKED	= 20000;	//正解と比べる箱の数の上限
+
+	int occluder_num = 2000;
+	int box_num = 100000;
+	sscanf(command_line, "-occlusionbench %d %d", &occluder_num, &box_num);
+	if(occluder_num < 1 || box_num < 1){
+		return -1;
+	}
+
+	Checker checker("occlusionbench");
+
+	TestRandom random(24680u);
+
+	const int width = OcclusionCuller::DEFAULT_WIDTH;
+	const int height = OcclusionCuller::DEFAULT_HEIGHT;
+	JobSystem jobs;
+
+
+	//街: 目の高さから通りの奥を見て、格子に並べた建物(3割は空き地)の間に小さな箱を置く
+	OcclusionScene city{"city"};
+	{
+		static const float CELL = 8.0f;
+		static const float EYE[3] = {3.0f, 1.7f, -5.0f};
+		static const float FOCUS[3] = {3.0f, 0.0f, 60.0f};
+		static const float UP[3] = {0.0f, 1.0f, 0.0f};
+		city.view_proj = ShadowCascades::Matrix::LookAtLH(EYE, FOCUS, UP) * ShadowCascades::Matrix::PerspectiveFovLH(60.0f * PI / 180.0f, 4.0f / 3.0f, 0.5f, 1000.0f);
+
+		int row = 0;
+		for(int n = 0; n < occluder_num; ++row){
+			for(int i = -15; i <= 15 && n < occluder_num; ++i){
+				if(random.Uniform(0.0f, 1.0f) < 0.3f){
+					continue;
+				}
+				const float half_x = random.Uniform(1.5f, 3.0f);
+				const float half_z = random.Uniform(1.5f, 3.0f);
+				const float min[3] = {i * CELL - half_x, 0.0f, 5.0f + row * CELL - half_z};
+				const float max[3] = {i * CELL + half_x, random.Uniform(3.0f, 20.0f), 5.0f + row * CELL + half_z};
+				city.AddOccluderBox(min, max);
+				++n;
+			}
+		}
+
+		//箱はおおよそ視錐台の中に置く
+		const float depth = 5.0f + row * CELL;
+		for(int i = 0; i < box_num; ++i){
+			const float size = random.Uniform(0.15f, 1.0f);
+			const float z = random.Uniform(3.0f, depth);
+			const float center[3] = {EYE[0] + random.Uniform(-0.8f, 0.8f) * (z - EYE[2]), random.Uniform(size, 6.0f), z};
+			for(int k = 0; k < 6; ++k){
+				city.boxes.push_back(center[k % 3] + ((k < 3) ? -size : size));
+			}
+		}
+	}
+
+	//壁: アプリのカメラの前にある板ポリ(2つの三角形)と、その前後の箱
+	OcclusionScene wall{"wall"};
+	{
+		static const float EYE[3] = {1.0f, 1.0f, -6.0f};
+		static const float FOCUS[3] = {0.0f, 0.0f, 0.0f};
+		static const float UP[3] = {0.0f, 1.0f, 0.0f};
+		static const float WALL[4 * 3] = {-3.0f, 2.0f, 2.0f,  3.0f, 2.0f, 2.0f,  -3.0f, -2.0f, 2.0f,  3.0f, -2.0f, 2.0f};
+		static const uint32_t WALL_INDICES[2 * 3] = {0, 1, 2,  2, 1, 3};
+		wall.view_proj = ShadowCascades::Matrix::LookAtLH(EYE, FOCUS, UP) * ShadowCascades::Matrix::PerspectiveFovLH(60.0f * PI / 180.0f, 640.0f / 480.0f, 1.0f, 20.0f);
+		wall.vertices.assign(WALL, WALL + 4 * 3);
+		wall.indices.assign(WALL_INDICES, WALL_INDICES + 2 * 3);
+
+		for(int i = 0; i < box_num; ++i){
+			const float size = random.Uniform(0.05f, 0.4f);
+			const float center[3] = {random.Uniform(-6.0f, 6.0f), random.Uniform(-5.0f, 5.0f), random.Uniform(-2.0f, 12.0f)};
+			for(int k = 0; k < 6; ++k){
+				wall.boxes.push_back(center[k % 3] + ((k < 3) ? -size : size));
+			}
+		}
+	}
+
+
+	for(const OcclusionScene *scene : {&city, &wall}){
+		char name[64];
+		OcclusionCuller culler;
+		culler.Initialize(width, height);
+
+		//1スレッドで描いたものとジョブで描いたものを比べる
+		culler.BeginFrame(scene->view_proj.m);
+		culler.AddOccluder(scene->vertices.data(), scene->indices.data(), scene->TriangleNum());
+		culler.Rasterize(nullptr);
+		std::vector<float> serial(static_cast<size_t>(width) * height);
+		for(int y = 0; y < height; ++y){
+			for(int x = 0; x < width; ++x){
+				serial[static_cast<size_t>(y) * width + x] = culler.DepthBound(x, y);
+			}
+		}
+
+		culler.BeginFrame(scene->view_proj.m);
+		culler.AddOccluder(scene->vertices.data(), scene->indices.data(), scene->TriangleNum());
+		culler.Rasterize(&jobs);
+		bool same = true;
+		for(int y = 0; y < height && same; ++y){
+			for(int x = 0; x < width && same; ++x){
+				same = (serial[static_cast<size_t>(y) * width + x] == culler.DepthBound(x, y));
+			}
+		}
+		snprintf(name, sizeof(name), "%s: parallel depth buffer matches one thread", scene->name);
+		checker.Check(name, same);
+
+
+		//正解のZバッファ(遮蔽物の最も手前の深度)
+		const int ref_width = width * SUPERSAMPLE;
+		const int ref_height = height * SUPERSAMPLE;
+		std::vector<float> reference(static_cast<size_t>(ref_width) * ref_height, 1.0f);
+		RasterizeReference(ref_width, ref_height, scene->view_proj, scene->vertices.data(), scene->indices.data(), scene->TriangleNum(), [&](size_t p, float z){
+			reference[p] = std::min(reference[p], z);
+			return true;
+		});
+
+		//箱のどこかのピクセルが遮蔽物より手前なら見える(画面に掛からないものは数えない)
+		int visible_num = 0, hidden_num = 0, false_negative_num = 0, wide_false_negative_num = 0, culled_hidden_num = 0;
+		const int checked_num = std::min(scene->BoxNum(), MAX_CHECKED);
+		for(int i = 0; i < checked_num; ++i){
+			const float *box = &scene->boxes[i * 6];
+			float v[8 * 3];
+			BoxVertices(box, box + 3, v);
+			const bool on_screen = !RasterizeReference(ref_width, ref_height, scene->view_proj, v, BOX_INDICES, 12, [](size_t, float z){
+				return !(z >= 0.0f && z <= 1.0f);
+			});
+			if(!on_screen){
+				continue;
+			}
+			const bool visible = !RasterizeReference(ref_width, ref_height, scene->view_proj, v, BOX_INDICES, 12, [&](size_t p, float z){
+				return !(z >= 0.0f && z <= 1.0f && z < reference[p]);
+			});
+
+			const OcclusionCuller::Result result = culler.TestBox(box, box + 3);
+			if(visible){
+				++visible_num;
+				if(result == OcclusionCuller::RESULT_OCCLUDED){
+					//見える部分を囲む矩形の大きさ(正解の解像度のピクセル)
+					int x0 = ref_width, y0 = ref_height, x1 = -1, y1 = -1;
+					RasterizeReference(ref_width, ref_height, scene->view_proj, v, BOX_INDICES, 12, [&](size_t p, float z){
+						if(z >= 0.0f && z <= 1.0f && z < reference[p]){
+							const int x = static_cast<int>(p % ref_width);
+							const int y = static_cast<int>(p / ref_width);
+							x0 = std::min(x0, x);
+							x1 = std::max(x1, x);
+							y0 = std::min(y0, y);
+							y1 = std::max(y1, y);
+						}
+						return true;
+					});
+					++false_negative_num;
+					wide_false_negative_num += (x1 - x0 + 1 >= SUPERSAMPLE && y1 - y0 + 1 >= SUPERSAMPLE) ? 1 : 0;
+				}
+			}else{
+				++hidden_num;
+				culled_hidden_num += (result != OcclusionCuller::RESULT_VISIBLE) ? 1 : 0;
+			}
+		}
+		snprintf(name, sizeof(name), "%s: occluded visible boxes show less than a pixel", scene->name);
+		checker.Check(name, wide_false_negative_num == 0);
+		PrintLine("[occlusionbench] %s: %d boxes on screen  visible %d  hidden %d  false negatives %d (%.3f%%)  hidden boxes culled %.1f%%\n",
+			scene->name, visible_num + hidden_num, visible_num, hidden_num, false_negative_num, 100.0 * false_negative_num / std::max(visible_num, 1),
+			100.0 * culled_hidden_num / std::max(hidden_num, 1));
+
+
+		//所要時間(三角形の準備、1スレッド・ジョブでの描画、全ての箱の問い合わせ)
+		double setup_ms = 1e30, serial_ms = 1e30, parallel_ms = 1e30, query_ms = 1e30;
+		int triangle_num = 0;
+		int result_nums[3] = {};
+		for(int r = 0; r < REPEAT_NUM; ++r){
+			for(JobSystem *job_system : {static_cast<JobSystem*>(nullptr), &jobs}){
+				const auto start = std::chrono::high_resolution_clock::now();
+				culler.BeginFrame(scene->view_proj.m);
+				culler.AddOccluder(scene->vertices.data(), scene->indices.data(), scene->TriangleNum());
+				triangle_num = culler.TriangleNum();
+				const auto middle = std::chrono::high_resolution_clock::now();
+				culler.Rasterize(job_system);
+				const auto end = std::chrono::high_resolution_clock::now();
+				setup_ms = std::min(setup_ms, std::chrono::duration<double, std::milli>(middle - start).count());
+				double &raster_ms = (job_system == nullptr) ? serial_ms : parallel_ms;
+				raster_ms = std::min(raster_ms, std::chrono::duration<double, std::milli>(end - middle).count());
+			}
+
+			std::fill(result_nums, result_nums + 3, 0);
+			const auto start = std::chrono::high_resolution_clock::now();
+			for(int i = 0; i < scene->BoxNum(); ++i){
+				++result_nums[culler.TestBox(&scene->boxes[i * 6], &scene->boxes[i * 6 + 3])];
+			}
+			const auto end = std::chrono::high_resolution_clock::now();
+			query_ms = std::min(query_ms, std::chrono::duration<double, std::milli>(end - start).count());
+		}
+		PrintLine("[occlusionbench] %s: %d triangles (%d after clipping)  setup %.3f ms  raster %s 1 thread %.3f ms  %u threads %.3f ms (%.1f M triangles/s)\n",
+			scene->name, scene->TriangleNum(), triangle_num, setup_ms, OcclusionCuller::InstructionSet(), serial_ms, jobs.ThreadNum(), parallel_ms,
+			triangle_num / std::min(serial_ms, parallel_ms) / 1000.0);
+		PrintLine("[occlusionbench] %s: %d queries %.3f ms (%.1f M boxes/s)  visible %d  occluded %d  off screen %d  (draws after frustum culling -%.1f%%)\n",
+			scene->name, scene->BoxNum(), query_ms, scene->BoxNum() / query_ms / 1000.0, result_nums[OcclusionCuller::RESULT_VISIBLE],
+			result_nums[OcclusionCuller::RESULT_OCCLUDED], result_nums[OcclusionCuller::RESULT_VIEW_CULLED],
+			100.0 * result_nums[OcclusionCuller::RESULT_OCCLUDED] / std::max(result_nums[OcclusionCuller::RESULT_VISIBLE] + result_nums[OcclusionCuller::RESULT_OCCLUDED], 1));
+	}
+
+
+	//決まった位置の箱(壁の後ろ・前・縁からはみ出すもの・カメラの後ろ・近クリップ面をまたぐもの・画面の外・壁の後ろの奥)
+	{
+		OcclusionCuller culler;
+		culler.Initialize(width, height);
+
+		culler.BeginFrame(wall.view_proj.m);
+		bool empty_visible = true;
+		for(int i = 0; i < wall.BoxNum(); ++i){
+			empty_visible = empty_visible && (culler.TestBox(&wall.boxes[i * 6], &wall.boxes[i * 6 + 3]) != OcclusionCuller::RESULT_OCCLUDED);
+		}
+		checker.Check("an empty depth buffer occludes nothing", empty_visible);
+
+		culler.AddOccluder(wall.vertices.data(), wall.indices.data(), wall.TriangleNum());
+		culler.Rasterize();
+
+		struct Case{
+			const char					*name;
+			float						center[3];
+			float						size;
+			OcclusionCuller::Result		expected;
+		};
+		static const Case CASES[] = {
+			{"behind the wall",				{0.0f, 0.0f, 6.0f},		0.5f,	OcclusionCuller::RESULT_OCCLUDED},
+			{"in front of the wall",		{0.0f, 0.0f, 0.0f},		0.5f,	OcclusionCuller::RESULT_VISIBLE},
+			{"peeking past the wall edge",	{4.0f, 0.0f, 6.0f},		0.5f,	OcclusionCuller::RESULT_VISIBLE},
+			{"behind the camera",			{1.0f, 1.0f, -12.0f},	0.5f,	OcclusionCuller::RESULT_VIEW_CULLED},
+			{"across the near plane",		{0.84f, 0.84f, -5.03f},	0.3f,	OcclusionCuller::RESULT_VISIBLE},
+			{"off screen",					{40.0f, 0.0f, 6.0f},	0.5f,	OcclusionCuller::RESULT_VIEW_CULLED},
+			{"far behind the wall",			{0.5f, 0.5f, 10.0f},	0.2f,	OcclusionCuller::RESULT_OCCLUDED},
+		};
+		bool known = true;
+		for(const Case &c : CASES){
+			const float min[3] = {c.center[0] - c.size, c.center[1] - c.size, c.center[2] - c.size};
+			const float max[3] = {c.center[0] + c.size, c.center[1] + c.size, c.center[2] + c.size};
+			const OcclusionCuller::Result result = culler.TestBox(min, max);
+			if(result != c.expected){
+				PrintLine("[occlusionbench] %s: %d (expected %d)\n", c.name, result, c.expected);
+				known = false;
+			}
+		}
+		checker.Check("known boxes around a wall", known);
+
+		//裏返した壁(カメラから裏が見える)は、two_sidedでなければ遮蔽物にしない
+		std::vector<uint32_t> reversed(wall.indices);
+		for(size_t i = 0; i < reversed.size(); i += 3){
+			std::swap(reversed[i + 1], reversed[i + 2]);
+		}
+		const float behind_min[3] = {-0.5f, -0.5f, 5.5f};
+		const float behind_max[3] = {0.5f, 0.5f, 6.5f};
+		culler.BeginFrame(wall.view_proj.m);
+		culler.AddOccluder(wall.vertices.data(), reversed.data(), wall.TriangleNum());
+		const int back_num = culler.TriangleNum();
+		culler.Rasterize();
+		checker.Check("back-facing occluder is skipped", back_num == 0 && culler.TestBox(behind_min, behind_max) == OcclusionCuller::RESULT_VISIBLE);
+
+		culler.BeginFrame(wall.view_proj.m);
+		culler.AddOccluder(wall.vertices.data(), reversed.data(), wall.TriangleNum(), nullptr, true);
+		const int two_sided_num = culler.TriangleNum();
+		culler.Rasterize();
+		checker.Check("two-sided occluder is drawn from behind", two_sided_num == 2 && culler.TestBox(behind_min, behind_max) == OcclusionCuller::RESULT_OCCLUDED);
+	}
+
+	return checker.Result();
+}
@@ -0,0 +1,211 @@
+#include <cstdio>
+#include <cstdint>
+#include <atomic>
+#include <future>
+#include <unordered_set>
+#include <vector>
+#include "PipelineRegistry.h"
+#include "JobSystem.h"
+#include "TestCommon.h"
+
+namespace{
+typedef PipelineRegistry::Handle Handle;
+
+//PipelineStateManager::HashDescと同じく、記述のメンバを1つずつ加えたキー
+struct CheckDesc{
+	uint64_t	root_signature;
+	uint32_t	vs_size;
+	uint32_t	ps_size;
+	uint32_t	blend;
+	uint32_t	cull;
+	uint32_t	depth_func;
+	uint32_t	rtv_format;
+	uint32_t	sample_count;
+};
+
+uint64_t HashCheckDesc(const CheckDesc &desc){
+	PipelineKeyBuilder key;
+	key.AddU64(desc.root_signature);
+	key.AddU32(desc.vs_size);
+	key.AddU32(desc.ps_size);
+	key.AddU32(desc.blend);
+	key.AddU32(desc.cull);
+	key.AddU32(desc.depth_func);
+	key.AddU32(desc.rtv_format);
+	key.AddU32(desc.sample_count);
+	return key.Value();
+}
+}
+
+
+//DirectX12Tests -pipelinecheck [キーの数]
+//PSOのキーの作り方と、キーで重複を除く登録表を確かめる
+//・キーはFNV-1a(64bit)と一致し、分けて加えても一度に加えても同じ値になる。要素の順序や境界が変われば値も変わる
+//・記述のメンバの組み合わせを変えたキーが衝突しない
+//・同じキーの登録は既存のハンドルを返して重複として数え、複数のスレッドから同時に登録しても1つにまとまる
+//・作成中・失敗したPSOはフォールバックをたどり、たどれなければINVALID_HANDLEになる
+int PipelineRegistryCheckCommand(const char *command_line){
+	int key_num = 20000;
+	sscanf(command_line, "-pipelinecheck %d", &key_num);
+	if(key_num < 1){
+		return -1;
+	}
+
+	Checker checker("pipelinecheck");
+
+
+	//キーの作り方
+	{
+		PipelineKeyBuilder empty;
+		PipelineKeyBuilder a;
+		a.AddBytes("a", 1);
+		checker.Check("key matches FNV-1a 64", empty.Value() == 14695981039346656037ull && a.Value() == 0xaf63dc4c8601ec8cull);
+
+		PipelineKeyBuilder whole;
+		PipelineKeyBuilder split;
+		whole.AddBytes("pipeline state", 14);
+		split.AddBytes("pipe", 4);
+		split.AddBytes("line state", 10);
+		checker.Check("incremental bytes give the same key", whole.Value() == split.Value());
+
+		PipelineKeyBuilder null_string;
+		PipelineKeyBuilder empty_string;
+		null_string.AddString(nullptr);
+		empty_string.AddString("");
+		checker.Check("null string hashes as an empty string", null_string.Value() == empty_string.Value() && empty_string.Value() != empty.Value());
+
+		PipelineKeyBuilder ab_c;
+		PipelineKeyBuilder a_bc;
+		ab_c.AddString("ab");
+		ab_c.AddString("c");
+		a_bc.AddString("a");
+		a_bc.AddString("bc");
+		checker.Check("string boundaries change the key", ab_c.Value() != a_bc.Value());
+
+		PipelineKeyBuilder forward;
+		PipelineKeyBuilder backward;
+		forward.AddU32(1);
+		forward.AddU32(2);
+		backward.AddU32(2);
+		backward.AddU32(1);
+		checker.Check("member order changes the key", forward.Value() != backward.Value());
+
+		//記述の組み合わせを変えたキー(iを各メンバの桁に分ける)
+		std::unordered_set<uint64_t> keys;
+		for(int i = 0; i < key_num; ++i){
+			int digits = i;
+			auto digit = [&digits](int base){
+				const int d = digits % base;
+				digits /= base;
+				return static_cast<uint32_t>(d);
+			};
+			CheckDesc desc{};
+			desc.vs_size		= 1024 + digit(7);
+			desc.ps_size		= 2048 + digit(11);
+			desc.blend			= digit(2);
+			desc.cull			= 1 + digit(3);
+			desc.depth_func		= 1 + digit(8);
+			desc.rtv_format		= 28 + digit(2);
+			desc.sample_count	= 1 << digit(3);
+			desc.root_signature	= 0x9e3779b97f4a7c15ull * (digits + 1);
+			keys.insert(HashCheckDesc(desc));
+		}
+		char name[96];
+		snprintf(name, sizeof(name), "%d distinct descs give distinct keys", key_num);
+		checker.Check(name, static_cast<int>(keys.size()) == key_num);
+	}
+
+
+	//重複の除去とフォールバック
+	{
+		PipelineRegistry registry;
+		bool added = false;
+		const Handle base = registry.Register(100, PipelineRegistry::INVALID_HANDLE, &added);
+		const bool base_added = added;
+		const Handle again = registry.Register(100, PipelineRegistry::INVALID_HANDLE, &added);
+		checker.Check("same key returns the existing handle", base_added && !added && again == base);
+		checker.Check("dedup is counted", registry.GetStats().request_num == 2 && registry.GetStats().dedup_num == 1 && registry.Num() == 1);
+		checker.Check("lookup by key and handle", registry.Find(100) == base && registry.GetKey(base) == 100
+			&& registry.Find(101) == PipelineRegistry::INVALID_HANDLE);
+
+		//base ← shadow ← variant の順にフォールバックする
+		const Handle shadow = registry.Register(200, base, &added);
+		const Handle variant = registry.Register(300, shadow, &added);
+		const Handle orphan = registry.Register(400, 1000, &added);	//未登録のフォールバックは無視する
+		checker.Check("new entries are pending", registry.PendingNum() == 4 && registry.GetState(variant) == PipelineRegistry::STATE_PENDING);
+		checker.Check("pending entry without a ready fallback is invalid", registry.Resolve(variant) == PipelineRegistry::INVALID_HANDLE
+			&& registry.Resolve(orphan) == PipelineRegistry::INVALID_HANDLE);
+
+		registry.SetState(base, PipelineRegistry::STATE_READY);
+		checker.Check("pending entry resolves through the fallback chain", registry.Resolve(variant) == base && registry.GetStats().fallback_num == 1);
+
+		registry.SetState(shadow, PipelineRegistry::STATE_FAILED);
+		registry.SetState(variant, PipelineRegistry::STATE_READY);
+		checker.Check("ready entry resolves to itself", registry.Resolve(variant) == variant && registry.GetStats().fallback_num == 1);
+		checker.Check("failed entry resolves to its fallback", registry.Resolve(shadow) == base && registry.GetStats().fallback_num == 2);
+		checker.Check("unknown handle is failed", registry.GetState(1000) == PipelineRegistry::STATE_FAILED && registry.Resolve(1000) == PipelineRegistry::INVALID_HANDLE);
+
+		//フォールバックの鎖がMAX_FALLBACK_DEPTHより長ければたどらない
+		PipelineRegistry chain;
+		Handle last = chain.Register(0, PipelineRegistry::INVALID_HANDLE, &added);
+		chain.SetState(last, PipelineRegistry::STATE_READY);
+		Handle within = PipelineRegistry::INVALID_HANDLE;
+		for(int i = 1; i <= PipelineRegistry::MAX_FALLBACK_DEPTH + 1; ++i){
+			last = chain.Register(i, last, &added);
+			if(i == PipelineRegistry::MAX_FALLBACK_DEPTH){
+				within = last;
+			}
+		}
+		checker.Check("fallback depth is limited", chain.Resolve(within) == 0 && chain.Resolve(last) == PipelineRegistry::INVALID_HANDLE);
+
+		registry.Clear();
+		checker.Check("Clear removes entries and stats", registry.Num() == 0 && registry.Find(100) == PipelineRegistry::INVALID_HANDLE
+			&& registry.GetStats().request_num == 0);
+	}
+
+
+	//複数のスレッドから同じキーを登録する
+	{
+		static constexpr int JOB_NUM = 16;
+		const int unique_num = (key_num < 4096) ? key_num : 4096;
+
+		JobSystem jobs;
+		PipelineRegistry registry;
+		std::atomic<int> added_num{0};
+		std::vector<std::vector<Handle>> handles(JOB_NUM, std::vector<Handle>(unique_num));
+		std::vector<std::future<void>> results;
+		for(int job = 0; job < JOB_NUM; ++job){
+			results.push_back(jobs.Push([job, unique_num, &registry, &added_num, &handles]{
+				//ジョブごとに順序をずらして登録する
+				for(int i = 0; i < unique_num; ++i){
+					const int index = (i + job * 131) % unique_num;
+					bool added = false;
+					handles[job][index] = registry.Register(0x1000 + index, PipelineRegistry::INVALID_HANDLE, &added);
+					added_num += added ? 1 : 0;
+				}
+			}));
+		}
+		for(std::future<void> &result : results){
+			result.wait();
+		}
+
+		bool agreed = true;
+		for(int job = 1; job < JOB_NUM; ++job){
+			agreed = agreed && (handles[job] == handles[0]);
+		}
+		bool keyed = true;
+		for(int i = 0; i < unique_num; ++i){
+			keyed = keyed && registry.GetKey(handles[0][i]) == static_cast<uint64_t>(0x1000 + i);
+		}
+		const PipelineRegistry::Stats stats = registry.GetStats();
+		const uint64_t request_num = static_cast<uint64_t>(JOB_NUM) * unique_num;
+
+		char name[96];
+		snprintf(name, sizeof(name), "%d jobs on %u threads agree on every handle", JOB_NUM, jobs.ThreadNum());
+		checker.Check(name, agreed && keyed);
+		checker.Check("each key is added exactly once", added_num == unique_num && registry.Num() == unique_num);
+		checker.Check("concurrent duplicates are counted", stats.request_num == request_num && stats.dedup_num == request_num - unique_num);
+	}
+
+	return checker.Result();
+}
@@ -0,0 +1,231 @@
+#include <cstdio>
+#include <cstdint>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "RecordScheduler.h"
+#include "HeadlessRenderer.h"
+#include "JobSystem.h"
+#include "TestCommon.h"
+
+namespace{
+//Begin・Endの呼び出しを数える記録先(Beginを失敗させることもできる)
+class MockRecordTarget : public RecordTarget{
+public:
+	explicit MockRecordTarget(bool fail_begin):
+		fail_begin_(fail_begin),
+		recording_(false),
+		begin_num_{},
+		end_num_{},
+		frame_index_(-1){}
+
+	bool Begin(int frame_index) override{
+		++begin_num_;
+		frame_index_ = frame_index;
+		if(fail_begin_){
+			return false;
+		}
+		recording_ = true;
+		return true;
+	}
+
+	bool End() override{
+		++end_num_;
+		recording_ = false;
+		return true;
+	}
+
+	bool IsRecording() const{return recording_;}
+	int BeginNum() const{return begin_num_;}
+	int EndNum() const{return end_num_;}
+	int FrameIndex() const{return frame_index_;}
+
+private:
+	bool	fail_begin_;
+	bool	recording_;
+	int		begin_num_;
+	int		end_num_;
+	int		frame_index_;
+};
+
+//pass番目のパスの記録(pass + 1回描く)
+//共有のリソースを偶数のパスはSHADER_RESOURCEからRENDER_TARGETへ、奇数のパスは戻す遷移をするので、
+//リストをAddPassした順に提出したときだけキューの状態の追跡が食い違わない
+bool RecordCheckPass(HeadlessCommandList *list, int pass, RenderResource shared){
+	const bool even = (pass % 2) == 0;
+	const RenderBarrier barrier = {shared, RENDER_ALL_SUBRESOURCES,
+		even ? RENDER_STATE_SHADER_RESOURCE : RENDER_STATE_RENDER_TARGET,
+		even ? RENDER_STATE_RENDER_TARGET : RENDER_STATE_SHADER_RESOURCE, RENDER_BARRIER_FULL};
+	list->ResourceBarriers(1, &barrier);
+
+	const RenderTargetView rtv{static_cast<uint64_t>(pass + 1)};
+	list->SetRootSignature(RenderRootSignature{1});
+	list->SetPipeline(RenderPipeline{static_cast<uint64_t>(pass + 1)});
+	list->SetViewport(RenderViewport{0.0f, 0.0f, 640.0f, 480.0f, 0.0f, 1.0f});
+	list->SetScissorRect(RenderRect{0, 0, 640, 480});
+	list->SetRenderTargets(1, &rtv, RenderTargetView{});
+	list->SetTopology(RENDER_TOPOLOGY_TRIANGLE_LIST);
+	for(int i = 0; i <= pass; ++i){
+		list->Draw(3, 1, 3 * i, 0);
+	}
+	return true;
+}
+
+bool SameCommands(const HeadlessCommandList &a, const HeadlessCommandList &b){
+	if(a.Commands().size() != b.Commands().size()){
+		return false;
+	}
+	for(size_t i = 0; i < a.Commands().size(); ++i){
+		const HeadlessCommand &ca = a.Commands()[i];
+		const HeadlessCommand &cb = b.Commands()[i];
+		if(ca.type != cb.type || ca.args[0] != cb.args[0] || ca.args[1] != cb.args[1] || ca.args[2] != cb.args[2] || ca.args[3] != cb.args[3]){
+			return false;
+		}
+	}
+	return true;
+}
+}
+
+
+//DirectX12Tests -recordcheck [フレーム数]
+//RecordSchedulerにヘッドレスのコマンドリストとBegin・Endを数える模擬の記録先を登録して確かめる
+//・ジョブに分けて記録しても、1スレッドで記録した場合とリストごとのコマンドが同じになる
+//・先頭のパスは呼び出したスレッドで、残りはワーカースレッドで記録する
+//・AddPassした順に提出すれば、パスをまたいだリソースの状態の追跡が食い違わない(逆順では食い違いが検出される)
+//・記録に失敗したパスがあればfalseを返すがリストは閉じる。Beginに失敗したパスは記録もEndもしない
+int RecordSchedulerCheckCommand(const char *command_line){
+	static constexpr int PASS_NUM = 8;
+	static const RenderResource SHARED = {100};
+
+	int frame_num = 200;
+	sscanf(command_line, "-recordcheck %d", &frame_num);
+	if(frame_num < 1){
+		return -1;
+	}
+
+	Checker checker("recordcheck");
+
+	JobSystem jobs;
+	const std::thread::id caller = std::this_thread::get_id();
+
+	//1スレッドで記録した結果を正とする
+	HeadlessCommandList reference[PASS_NUM];
+	{
+		RecordScheduler scheduler;
+		for(int pass = 0; pass < PASS_NUM; ++pass){
+			scheduler.AddPass(&reference[pass], [pass](RecordTarget *target){
+				return RecordCheckPass(static_cast<HeadlessCommandList*>(target), pass, SHARED);
+			});
+		}
+		checker.Check("serial recording succeeds", scheduler.Record(0, nullptr));
+	}
+
+	//ジョブに分けて記録する
+	HeadlessCommandList lists[PASS_NUM];
+	std::thread::id threads[PASS_NUM];
+	RecordScheduler scheduler;
+	for(int pass = 0; pass < PASS_NUM; ++pass){
+		scheduler.AddPass(&lists[pass], [pass, &threads](RecordTarget *target){
+			threads[pass] = std::this_thread::get_id();
+			return RecordCheckPass(static_cast<HeadlessCommandList*>(target), pass, SHARED);
+		});
+	}
+	bool order = scheduler.PassNum() == PASS_NUM;
+	for(int pass = 0; pass < PASS_NUM; ++pass){
+		order = order && (scheduler.GetTarget(pass) == &lists[pass]);
+	}
+	checker.Check("targets keep the AddPass order", order);
+
+	bool recorded = true;
+	bool same = true;
+	bool closed = true;
+	bool clean = true;
+	bool on_caller = true;
+	bool on_workers = true;
+	uint64_t draw_num = 0;
+	for(int frame = 0; frame < frame_num; ++frame){
+		recorded = recorded && scheduler.Record(frame % 3, &jobs);
+		on_caller = on_caller && (threads[0] == caller);
+		for(int pass = 0; pass < PASS_NUM; ++pass){
+			same = same && SameCommands(lists[pass], reference[pass]);
+			closed = closed && !lists[pass].IsRecording();
+			clean = clean && lists[pass].Stats().error_num == 0;
+			on_workers = on_workers && (pass == 0 || threads[pass] != caller);
+			draw_num += lists[pass].Stats().draw_num;
+		}
+	}
+	char name[96];
+	snprintf(name, sizeof(name), "%d frames recorded on %u worker threads", frame_num, jobs.ThreadNum());
+	checker.Check(name, recorded);
+	checker.Check("parallel lists match serial lists", same);
+	checker.Check("every list is closed after Record", closed);
+	checker.Check("no validation errors in the lists", clean);
+	checker.Check("first pass records on the calling thread", on_caller);
+	checker.Check("other passes record on worker threads", on_workers);
+	checker.Check("draw count matches the passes", draw_num == static_cast<uint64_t>(frame_num) * PASS_NUM * (PASS_NUM + 1) / 2);
+
+	//AddPassの順に提出する
+	{
+		HeadlessQueue queue;
+		queue.SetResourceState(SHARED, RENDER_STATE_SHADER_RESOURCE);
+		HeadlessCommandList *submit[PASS_NUM];
+		for(int pass = 0; pass < PASS_NUM; ++pass){
+			submit[pass] = static_cast<HeadlessCommandList*>(scheduler.GetTarget(pass));
+		}
+		queue.Execute(PASS_NUM, submit);
+		checker.Check("submitting in AddPass order keeps states consistent", queue.Stats().error_num == 0);
+
+		HeadlessQueue reversed;
+		reversed.SetResourceState(SHARED, RENDER_STATE_SHADER_RESOURCE);
+		for(int pass = PASS_NUM - 1; pass >= 0; --pass){
+			reversed.Execute(1, &submit[pass]);
+		}
+		checker.Check("submitting in reverse order is flagged", reversed.Stats().error_num > 0);
+	}
+
+	//失敗したパス
+	{
+		HeadlessCommandList ok_list;
+		HeadlessCommandList failed_list;
+		MockRecordTarget failed_begin(true);
+		MockRecordTarget mock(false);
+		std::atomic<int> called{0};
+
+		RecordScheduler failing;
+		failing.AddPass(&ok_list, [](RecordTarget *target){
+			return RecordCheckPass(static_cast<HeadlessCommandList*>(target), 0, SHARED);
+		});
+		failing.AddPass(&failed_list, [&called](RecordTarget *target){
+			++called;
+			RecordCheckPass(static_cast<HeadlessCommandList*>(target), 1, SHARED);
+			return false;
+		});
+		failing.AddPass(&failed_begin, [&called](RecordTarget*){
+			called += 100;
+			return true;
+		});
+		failing.AddPass(&mock, [](RecordTarget*){
+			return true;
+		});
+
+		for(int threaded = 0; threaded < 2; ++threaded){
+			called = 0;
+			const bool result = failing.Record(2, threaded ? &jobs : nullptr);
+			const char *mode = threaded ? "jobs" : "serial";
+
+			snprintf(name, sizeof(name), "%s: a failed pass fails Record", mode);
+			checker.Check(name, !result);
+			snprintf(name, sizeof(name), "%s: a failed pass still closes its list", mode);
+			checker.Check(name, !failed_list.IsRecording() && failed_list.Stats().draw_num == 2 && called == 1);
+			snprintf(name, sizeof(name), "%s: other passes still record", mode);
+			checker.Check(name, !ok_list.IsRecording() && ok_list.Stats().draw_num == 1 && mock.FrameIndex() == 2 && mock.EndNum() == mock.BeginNum());
+			snprintf(name, sizeof(name), "%s: a failed Begin skips recording and End", mode);
+			checker.Check(name, failed_begin.EndNum() == 0 && failed_begin.BeginNum() == threaded + 1);
+		}
+
+		failing.Clear();
+		checker.Check("Clear removes every pass", failing.PassNum() == 0 && failing.Record(0, &jobs));
+	}
+
+	return checker.Result();
+}
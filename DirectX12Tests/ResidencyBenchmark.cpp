@@ -0,0 +1,209 @@
+#include <cstdio>
+#include <cstdint>
+#include <chrono>
+#include <algorithm>
+#include <vector>
+#include "ResidencyManager.h"
+#include "HeadlessRenderer.h"
+#include "TestCommon.h"
+
+//DirectX12Tests -residencybench [フレーム数]
+//予算1GBに対して2.5GBのものを登録し、使うものの範囲が少しずつ移るフレームを模したキューで流す(途中で他のアプリが400MBを使う)
+//GPUが使っている間に退避しないこと・使う前に常駐させ直すこと・古いものから退避すること・
+//GPUが使っていないもので予算に収まる場合は収めることを確かめ、退避・常駐させ直した量と1フレームの処理時間を計測する
+//常駐させ直すのに失敗したものは要求が残り、同じフレームをやり直したUpdateで常駐することも確かめる
+int ResidencyBenchmarkCommand(const char *command_line){
+	static constexpr uint64_t MB = 1024 * 1024;
+	static constexpr uint64_t LOCAL_BUDGET = 1024 * MB;
+	static constexpr uint64_t NON_LOCAL_BUDGET = 512 * MB;
+	static constexpr uint64_t TOTAL_SIZE = 2560 * MB;
+	static constexpr uint64_t LATENCY = 2;	//提出からこのフレーム数の後に完了する
+	static const int object_nums[] = {4000, 40000};
+
+	int frame_num = 2000;
+	sscanf(command_line, "-residencybench %d", &frame_num);
+	if(frame_num < 1){
+		return -1;
+	}
+
+	Checker checker("residencybench", 48);
+
+	//常駐させ直すのに失敗した場合
+	{
+		HeadlessResidencyTarget target;
+		target.SetBudget(MEMORY_SEGMENT_LOCAL, 100 * MB);
+		ResidencyManager manager;
+		manager.Initialize(&target);
+		const RenderResource a{1};
+		const RenderResource b{2};
+		const int handle_a = manager.Register(a, 60 * MB, MEMORY_SEGMENT_LOCAL);
+		const int handle_b = manager.Register(b, 60 * MB, MEMORY_SEGMENT_LOCAL);
+		target.Add(a, 60 * MB, MEMORY_SEGMENT_LOCAL);
+		target.Add(b, 60 * MB, MEMORY_SEGMENT_LOCAL);
+
+		//bだけを使うフレームでaを退避する
+		target.Complete(1);
+		manager.BeginFrame(2);
+		manager.Use(handle_b);
+		const bool evicted = manager.Update(1) && !manager.IsResident(handle_a) && !target.IsResident(a);
+
+		//aを使うフレームで常駐に失敗すると要求が残る(このフレームは提出しない)
+		target.Complete(2);
+		target.FailMakeResident(1);
+		manager.BeginFrame(3);
+		manager.Use(handle_a);
+		const bool failed = !manager.Update(2) && !manager.IsResident(handle_a) && !target.IsResident(a) && manager.GetStats().failed_num == 1;
+
+		//同じフレームをやり直すと常駐させる
+		manager.BeginFrame(3);
+		manager.Use(handle_a);
+		const bool retried = manager.Update(2) && manager.IsResident(handle_a) && target.IsResident(a) && manager.GetStats().make_resident_num == 1;
+		target.Access(a, 3);
+		checker.Check("failed MakeResident is retried on the next Update", evicted && failed && retried && target.ErrorNum() == 0);
+
+		//要求が残ったまま破棄したものは常駐させ直さない
+		target.Complete(3);
+		target.FailMakeResident(1);
+		manager.BeginFrame(4);
+		manager.Use(handle_b);
+		const bool pending = !manager.Update(3) && !manager.IsResident(handle_b);
+		manager.Unregister(handle_b);
+		target.Remove(b);
+		//(フレーム4でaは退避しているので、aだけを常駐させ直す)
+		manager.BeginFrame(5);
+		manager.Use(handle_a);
+		checker.Check("unregistered pending request is dropped", pending && manager.Update(4) && manager.IsResident(handle_a) && target.ErrorNum() == 0
+			&& manager.GetStats().make_resident_num == 2 && manager.GetStats().evicted_num == 0);
+	}
+
+	for(int object_num : object_nums){
+		TestRandom random(7654321u + object_num);
+
+		HeadlessResidencyTarget target;
+		target.SetBudget(MEMORY_SEGMENT_LOCAL, LOCAL_BUDGET);
+		target.SetBudget(MEMORY_SEGMENT_NON_LOCAL, NON_LOCAL_BUDGET);
+		ResidencyManager manager;
+		manager.Initialize(&target);
+
+		//大きさは平均でTOTAL_SIZE / object_numになるようにばらつかせる(1/20はシステムメモリ)
+		struct Object{
+			RenderResource	resource;
+			uint64_t		size;
+			MemorySegment	segment;
+			int				handle;
+		};
+		std::vector<Object> objects(object_num);
+		uint64_t next_resource = 1;
+		auto create = [&](Object *o){
+			const uint64_t mean = TOTAL_SIZE / object_num;
+			o->resource	= RenderResource{next_resource++};
+			o->size		= (mean / 4 + random.Next() % (mean * 3 / 2)) & ~(64 * 1024 - 1);
+			o->size		= std::max<uint64_t>(o->size, 64 * 1024);
+			o->segment	= (random.Next() % 20 == 0) ? MEMORY_SEGMENT_NON_LOCAL : MEMORY_SEGMENT_LOCAL;
+			o->handle	= manager.Register(o->resource, o->size, o->segment);
+			target.Add(o->resource, o->size, o->segment);
+		};
+		for(Object &o : objects){
+			create(&o);
+		}
+
+		std::vector<int> used;
+		std::vector<bool> was_resident(object_num);
+		uint64_t lru_violation_num = 0;
+		uint64_t budget_violation_num = 0;
+		uint64_t peak_usage = 0;
+		double update_us = 0.0;
+
+		for(uint64_t frame = 1; frame <= static_cast<uint64_t>(frame_num); ++frame){
+			const uint64_t completed = (frame > LATENCY) ? frame - LATENCY : 0;
+			target.Complete(completed);
+
+			//中盤は他のアプリが予算を使う
+			const bool pressure = frame > static_cast<uint64_t>(frame_num) * 2 / 5 && frame <= static_cast<uint64_t>(frame_num) * 3 / 5;
+			target.SetExternalUsage(MEMORY_SEGMENT_LOCAL, pressure ? 400 * MB : 0);
+
+			//100フレームごとにGPUが使い終わったものを作り直す
+			if(frame % 100 == 0){
+				for(int i = 0; i < object_num / 100; ++i){
+					Object &o = objects[random.Next(object_num)];
+					if(manager.LastUsed(o.handle) <= completed){
+						manager.Unregister(o.handle);
+						target.Remove(o.resource);
+						create(&o);
+					}
+				}
+			}
+
+			//画面に入るものは全体の1/4で、1フレームに1/1000ずつ移る。ほかにランダムに少し使う
+			used.clear();
+			const int window = object_num / 4;
+			const int first = static_cast<int>((frame * object_num / 1000) % object_num);
+			for(int i = 0; i < window; ++i){
+				used.push_back((first + i) % object_num);
+			}
+			for(int i = 0; i < object_num / 100; ++i){
+				used.push_back(random.Next(object_num));
+			}
+			for(int i = 0; i < object_num; ++i){
+				was_resident[i] = manager.IsResident(objects[i].handle);
+			}
+
+			const auto begin = std::chrono::steady_clock::now();
+			manager.BeginFrame(frame);
+			for(int index : used){
+				manager.Use(objects[index].handle);
+			}
+			manager.Update(completed);
+			update_us += std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - begin).count();
+
+			//GPUが使う(常駐していなければエラーになる)
+			for(int index : used){
+				target.Access(objects[index].resource, frame);
+			}
+
+			//このフレームで退避したものは、常駐しているものより前に使われたもの
+			uint64_t newest_evicted = 0;
+			uint64_t oldest_resident = UINT64_MAX;
+			uint64_t pinned = pressure ? 400 * MB : 0;
+			for(int i = 0; i < object_num; ++i){
+				const Object &o = objects[i];
+				const bool resident = manager.IsResident(o.handle);
+				if(o.segment != MEMORY_SEGMENT_LOCAL){
+					continue;
+				}
+				if(was_resident[i] && !resident){
+					newest_evicted = std::max(newest_evicted, manager.LastUsed(o.handle));
+				}
+				if(resident){
+					oldest_resident = std::min(oldest_resident, manager.LastUsed(o.handle));
+					pinned += (manager.LastUsed(o.handle) > completed) ? o.size : 0;
+				}
+			}
+			lru_violation_num += (newest_evicted > oldest_resident) ? 1 : 0;
+
+			//GPUが使っているものだけで収まるなら、使用量は目標の割合に収まっている
+			const uint64_t usage = target.Usage(MEMORY_SEGMENT_LOCAL);
+			const uint64_t limit = static_cast<uint64_t>(LOCAL_BUDGET * ResidencyManager::DEFAULT_TARGET_RATIO);
+			budget_violation_num += (usage > std::max(limit, pinned)) ? 1 : 0;
+			peak_usage = std::max(peak_usage, usage);
+		}
+
+		const ResidencyManager::Stats &stats = manager.GetStats();
+		char name[96];
+		snprintf(name, sizeof(name), "%d objects: no eviction in flight or use while evicted", object_num);
+		checker.Check(name, target.ErrorNum() == 0 && stats.failed_num == 0);
+		snprintf(name, sizeof(name), "%d objects: evicts least recently used first", object_num);
+		checker.Check(name, lru_violation_num == 0);
+		snprintf(name, sizeof(name), "%d objects: stays within budget when possible", object_num);
+		checker.Check(name, budget_violation_num == 0);
+		snprintf(name, sizeof(name), "%d objects: resident size matches target usage", object_num);
+		checker.Check(name, stats.resident_size[MEMORY_SEGMENT_LOCAL] == target.Usage(MEMORY_SEGMENT_LOCAL) && stats.resident_size[MEMORY_SEGMENT_NON_LOCAL] == target.Usage(MEMORY_SEGMENT_NON_LOCAL));
+
+		PrintLine("[residencybench] %6d objects  %d frames  update %7.1f us/frame  evicted %8.1f MB/frame  made resident %8.1f MB/frame  peak %llu MB  over budget %llu frames\n",
+			object_num, frame_num, update_us / frame_num,
+			static_cast<double>(stats.evict_bytes) / MB / frame_num, static_cast<double>(stats.make_resident_bytes) / MB / frame_num,
+			static_cast<unsigned long long>(peak_usage / MB), static_cast<unsigned long long>(stats.over_budget_frame_num));
+	}
+
+	return checker.Result();
+}
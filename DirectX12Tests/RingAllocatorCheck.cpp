@@ -0,0 +1,169 @@
+#include <cstdio>
+#include <cstdint>
+#include <deque>
+#include <iterator>
+#include <utility>
+#include <vector>
+#include "RingAllocator.h"
+#include "TestCommon.h"
+
+//DirectX12Tests -ringcheck [フレーム数]
+//UploadRingBufferと同じ使い方(フレームごとにフェンス値で締め、GPUが2フレーム遅れて完了する)でRingAllocatorを確かめる
+//・返すオフセットがアライメントに揃い、リングの中に収まる
+//・末尾に収まらない割り当ては先頭に回り込み、捨てた末尾の残りも使用中のサイズに数える
+//・完了したフェンス値までのフレームだけが解放され、使用中の領域(まだ完了していないフレームの割り当て)と重ならない
+//・全てのフレームが完了すると空になり、次の割り当ては先頭から始まる
+int RingAllocatorCheckCommand(const char *command_line){
+	static constexpr uint64_t RING_SIZE = 1024 * 1024;
+	static constexpr int LATENCY = 2;	//GPUが完了するまでのフレーム数
+	static const uint64_t alignments[] = {1, 4, 16, 256, 512, 4096, 64 * 1024};
+
+	int frame_num = 2000;
+	sscanf(command_line, "-ringcheck %d", &frame_num);
+	if(frame_num < 1){
+		return -1;
+	}
+
+	Checker checker("ringcheck");
+
+	TestRandom random(97531u);
+
+
+	//決まった手順での回り込み
+	{
+		RingAllocator ring(1024);
+		const uint64_t a = ring.Allocate(600, 1);
+		ring.FinishFrame(1);
+		const uint64_t b = ring.Allocate(300, 1);
+		ring.FinishFrame(2);
+		checker.Check("allocations are placed back to back", a == 0 && b == 600 && ring.UsedSize() == 900);
+
+		//フレーム1の完了前は先頭に回り込めない
+		checker.Check("no wraparound into a frame still in flight", ring.Allocate(200, 1) == RingAllocator::INVALID_OFFSET);
+
+		ring.ReleaseCompletedFrames(1);
+		checker.Check("completed frame is released", ring.UsedSize() == 300 && ring.Tail() == 600 && ring.PendingFrameNum() == 1);
+
+		//末尾の124バイトには収まらないので先頭に回り込み、末尾の残りも使用中になる
+		const uint64_t c = ring.Allocate(200, 1);
+		checker.Check("allocation wraps to the start", c == 0 && ring.Head() == 200);
+		checker.Check("skipped tail is counted as used", ring.UsedSize() == 300 + 124 + 200);
+
+		//空きは[200, 600)だけ
+		checker.Check("allocation larger than the gap fails", ring.Allocate(401, 1) == RingAllocator::INVALID_OFFSET);
+		const uint64_t d = ring.Allocate(400, 1);
+		checker.Check("allocation fills the gap up to the tail", d == 200 && ring.IsFull());
+		checker.Check("full ring rejects allocations", ring.Allocate(1, 1) == RingAllocator::INVALID_OFFSET);
+		ring.FinishFrame(3);
+
+		//完了していないフェンス値では何も解放しない
+		ring.ReleaseCompletedFrames(1);
+		checker.Check("release with an old fence value keeps pending frames", ring.IsFull() && ring.PendingFrameNum() == 2);
+
+		ring.ReleaseCompletedFrames(3);
+		checker.Check("releasing every frame empties the ring", ring.IsEmpty() && ring.PendingFrameNum() == 0);
+		checker.Check("empty ring restarts at offset 0", ring.Allocate(1000, 1) == 0);
+	}
+
+	//アライメントの詰め物
+	{
+		RingAllocator ring(4096);
+		const uint64_t a = ring.Allocate(10, 1);
+		const uint64_t b = ring.Allocate(16, 256);
+		const uint64_t c = ring.Allocate(1, 512);
+		checker.Check("aligned offsets skip padding", a == 0 && b == 256 && c == 512 && ring.UsedSize() == 513);
+		checker.Check("allocation larger than the ring fails", ring.Allocate(4097, 1) == RingAllocator::INVALID_OFFSET);
+		checker.Check("zero-sized allocation fails", ring.Allocate(0, 16) == RingAllocator::INVALID_OFFSET);
+	}
+
+
+	//乱数の割り当てを手元の表と突き合わせる
+	{
+		struct Range{
+			uint64_t	offset;
+			uint64_t	size;
+		};
+		RingAllocator ring(RING_SIZE);
+		std::deque<std::vector<Range>> in_flight;	//完了していないフレームの割り当て(古い順)
+		std::vector<Range> current;
+		bool aligned = true;
+		bool inside = true;
+		bool disjoint = true;
+		bool used = true;
+		bool retired = true;
+		uint64_t alloc_num = 0;
+		uint64_t fail_num = 0;
+		uint64_t wrap_num = 0;
+
+		auto overlaps = [](const Range &a, const Range &b){
+			return a.offset < b.offset + b.size && b.offset < a.offset + a.size;
+		};
+
+		for(int frame = 1; frame <= frame_num; ++frame){
+			//フレームごとに割り当てる量を変え、ときどきリングを使い切る
+			const int request_num = 1 + random.Next() % 48;
+			for(int i = 0; i < request_num; ++i){
+				const uint64_t size = 1 + random.Next() % ((random.Next() % 8 == 0) ? 256 * 1024 : 4096);
+				const uint64_t alignment = alignments[random.Next() % std::size(alignments)];
+				const uint64_t head = ring.Head();
+				const uint64_t offset = ring.Allocate(size, alignment);
+				if(offset == RingAllocator::INVALID_OFFSET){
+					++fail_num;
+					continue;
+				}
+				++alloc_num;
+				wrap_num += (offset < head) ? 1 : 0;
+
+				const Range range = {offset, size};
+				aligned = aligned && (offset % alignment == 0);
+				inside = inside && (offset + size <= RING_SIZE);
+				for(const std::vector<Range> &ranges : in_flight){
+					for(const Range &other : ranges){
+						disjoint = disjoint && !overlaps(range, other);
+					}
+				}
+				for(const Range &other : current){
+					disjoint = disjoint && !overlaps(range, other);
+				}
+				current.push_back(range);
+			}
+
+			ring.FinishFrame(frame);
+			in_flight.push_back(std::move(current));
+			current.clear();
+
+			//GPUはLATENCYフレーム遅れて完了する
+			if(frame > LATENCY){
+				ring.ReleaseCompletedFrames(frame - LATENCY);
+				in_flight.pop_front();
+			}
+			retired = retired && (ring.PendingFrameNum() == in_flight.size());
+
+			uint64_t live_size = 0;
+			for(const std::vector<Range> &ranges : in_flight){
+				for(const Range &range : ranges){
+					live_size += range.size;
+				}
+			}
+			used = used && (ring.UsedSize() >= live_size) && (ring.UsedSize() <= RING_SIZE);
+		}
+
+		ring.ReleaseCompletedFrames(frame_num);
+		in_flight.clear();
+
+		char name[96];
+		snprintf(name, sizeof(name), "%llu allocations are aligned", static_cast<unsigned long long>(alloc_num));
+		checker.Check(name, aligned);
+		checker.Check("allocations stay inside the ring", inside);
+		checker.Check("allocations never overlap frames in flight", disjoint);
+		checker.Check("used size covers every live allocation", used);
+		checker.Check("one pending mark per frame in flight", retired);
+		checker.Check("wraparound happened", wrap_num > 0);
+		checker.Check("ring is empty after the last fence", ring.IsEmpty() && ring.PendingFrameNum() == 0);
+
+		PrintLine("[ringcheck] %d frames  allocations %llu  failed %llu  wrapped %llu\n",
+			frame_num, static_cast<unsigned long long>(alloc_num), static_cast<unsigned long long>(fail_num), static_cast<unsigned long long>(wrap_num));
+	}
+
+	return checker.Result();
+}
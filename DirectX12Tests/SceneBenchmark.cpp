@@ -0,0 +1,370 @@
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <chrono>
+#include <cmath>
+#include <algorithm>
+#include <vector>
+#include "Scene.h"
+#include "JobSystem.h"
+#include "TestCommon.h"
+
+namespace{
+//XMMatrixRotationX/XMMatrixRotationYと同じ
+ShadowCascades::Matrix RotationXMatrix(float angle){
+	const float c = std::cos(angle);
+	const float s = std::sin(angle);
+	return {{{1.0f, 0.0f, 0.0f, 0.0f}, {0.0f, c, s, 0.0f}, {0.0f, -s, c, 0.0f}, {0.0f, 0.0f, 0.0f, 1.0f}}};
+}
+
+ShadowCascades::Matrix RotationYMatrix(float angle){
+	const float c = std::cos(angle);
+	const float s = std::sin(angle);
+	return {{{c, 0.0f, -s, 0.0f}, {0.0f, 1.0f, 0.0f, 0.0f}, {s, 0.0f, c, 0.0f}, {0.0f, 0.0f, 0.0f, 1.0f}}};
+}
+
+//拡大 * 回転 * 平行移動
+ShadowCascades::Matrix AffineMatrix(const float scale[3], const ShadowCascades::Matrix &rotation, const float position[3]){
+	ShadowCascades::Matrix m = rotation;
+	for(int r = 0; r < 3; ++r){
+		for(int c = 0; c < 3; ++c){
+			m.m[r][c] *= scale[r];
+		}
+		m.m[3][r] = position[r];
+	}
+	return m;
+}
+
+//行列の成分の差の最大(1より大きい成分は相対的な差にする)
+float MatrixError(const ShadowCascades::Matrix &a, const ShadowCascades::Matrix &b){
+	float error = 0.0f;
+	for(int r = 0; r < 4; ++r){
+		for(int c = 0; c < 4; ++c){
+			error = std::max(error, std::fabs(a.m[r][c] - b.m[r][c]) / std::max(1.0f, std::fabs(b.m[r][c])));
+		}
+	}
+	return error;
+}
+
+//シーンの計測用のローカルの変換(回転はX軸で回してからY軸で回す)
+struct SceneLocal{
+	float	position[3];
+	float	angle[2];
+	float	scale[3];
+
+	ShadowCascades::Matrix Matrix() const{
+		return AffineMatrix(scale, RotationXMatrix(angle[0]) * RotationYMatrix(angle[1]), position);
+	}
+
+	void Apply(Scene *scene, Scene::Entity entity) const{
+		float qx[4], qy[4], q[4];
+		Scene::RotationX(angle[0], qx);
+		Scene::RotationY(angle[1], qy);
+		Scene::MultiplyRotation(qx, qy, q);
+		scene->SetPosition(entity, position[0], position[1], position[2]);
+		scene->SetRotation(entity, q);
+		scene->SetScale(entity, scale[0], scale[1], scale[2]);
+	}
+};
+
+//祖先のローカルの変換を順に掛けたワールド変換
+ShadowCascades::Matrix SceneReferenceWorld(const Scene &scene, const std::vector<SceneLocal> &locals, Scene::Entity entity){
+	ShadowCascades::Matrix world = locals[entity].Matrix();
+	for(Scene::Entity a = scene.Parent(entity); a != Scene::INVALID_ENTITY; a = scene.Parent(a)){
+		world = world * locals[a].Matrix();
+	}
+	return world;
+}
+
+bool IsDescendant(const Scene &scene, Scene::Entity entity, Scene::Entity ancestor){
+	for(Scene::Entity a = entity; a != Scene::INVALID_ENTITY; a = scene.Parent(a)){
+		if(a == ancestor){
+			return true;
+		}
+	}
+	return false;
+}
+}
+
+
+//DirectX12Tests -scenebench [エンティティの数の上限]
+//乱数の変換を持つエンティティを浅い階層(深さ4)に並べ、シーンの変換の更新について次のことを確かめる
+//・SIMDで求めたワールド変換が1個ずつ求める参照実装と一致し、ジョブに分けても同じ
+//・ワールド変換が祖先のローカルの変換(回転は行列の積)を順に掛けたものと一致する
+//・1つのローカルの変換を変えると、それと子孫だけを求め直し、他のワールド変換はそのまま
+//・親を付け替えると子孫も付いて動き、自分や子孫を親にはできない
+//・Sphere・Planeのアニメーションの行列と、カメラのビュー・プロジェクション行列
+//あわせて、1万・10万・100万個(上限まで)で全てを求め直す場合(参照実装・SIMD・SIMDとジョブ)と1%を変えた場合の所要時間を表示する
+int SceneBenchmarkCommand(const char *command_line){
+	static constexpr float PI		= 3.14159265358979323846f;
+	static const int REPEAT_NUM		= 5;		//所要時間は最も速かったものを使う
+	static const int LEVEL_NUM		= 4;
+	static const int CHECK_NUM		= 10000;	//確かめるシーンの大きさ
+	static const int SAMPLE_NUM		= 2000;		//祖先の積と比べるエンティティの数
+	static const float TOLERANCE	= 1.0e-4f;
+
+	int max_num = 1000000;
+	sscanf(command_line, "-scenebench %d", &max_num);
+	if(max_num < 1){
+		return -1;
+	}
+
+	Checker checker("scenebench");
+
+	TestRandom random(24680u);
+	auto uniform_int = [&random](int n){
+		return static_cast<int>((static_cast<uint64_t>(random.Next()) * static_cast<uint64_t>(n)) >> 24);
+	};
+
+	JobSystem jobs;
+	std::vector<SceneLocal> locals;
+
+	//num個を根として作ってから、乱数の順に1つ浅い深さのものを親にする(深さごとの数は1:2:3:4)
+	auto build = [&](Scene *scene, int num){
+		scene->Clear();
+		locals.resize(num);
+		for(int i = 0; i < num; ++i){
+			SceneLocal &l = locals[i];
+			l = {{random.Uniform(-4.0f, 4.0f), random.Uniform(-4.0f, 4.0f), random.Uniform(-4.0f, 4.0f)}, {random.Uniform(-PI, PI), random.Uniform(-PI, PI)},
+				{random.Uniform(0.5f, 1.5f), random.Uniform(0.5f, 1.5f), random.Uniform(0.5f, 1.5f)}};
+			l.Apply(scene, scene->Create());
+		}
+
+		std::vector<Scene::Entity> order(num);
+		for(int i = 0; i < num; ++i){
+			order[i] = static_cast<Scene::Entity>(i);
+		}
+		for(int i = num - 1; i > 0; --i){
+			std::swap(order[i], order[uniform_int(i + 1)]);
+		}
+		int level_begin[LEVEL_NUM + 1];
+		for(int l = 0; l <= LEVEL_NUM; ++l){
+			level_begin[l] = static_cast<int>(static_cast<int64_t>(num) * (l * (l + 1) / 2) / (LEVEL_NUM * (LEVEL_NUM + 1) / 2));
+		}
+		for(int l = 1; l < LEVEL_NUM; ++l){
+			const int parent_num = level_begin[l] - level_begin[l - 1];
+			for(int i = level_begin[l]; i < level_begin[l + 1] && parent_num > 0; ++i){
+				scene->SetParent(order[i], order[level_begin[l - 1] + uniform_int(parent_num)]);
+			}
+		}
+	};
+
+	//ローカルの変換を書き直して全てに印を付ける
+	auto touch_all = [&](Scene *scene){
+		for(int i = 0; i < scene->Num(); ++i){
+			locals[i].Apply(scene, static_cast<Scene::Entity>(i));
+		}
+	};
+
+
+	{
+		const int num = std::min(CHECK_NUM, max_num);
+		Scene scene;
+		build(&scene, num);
+
+		//参照実装・SIMD・SIMDとジョブで同じ結果になる
+		scene.UpdateScalar();
+		std::vector<Scene::Matrix> reference(num);
+		for(int i = 0; i < num; ++i){
+			reference[i] = scene.World(i);
+		}
+		touch_all(&scene);
+		const int simd_updated = scene.Update();
+		float simd_error = 0.0f;
+		for(int i = 0; i < num; ++i){
+			simd_error = std::max(simd_error, MatrixError(scene.World(i), reference[i]));
+		}
+		touch_all(&scene);
+		const int job_updated = scene.Update(&jobs);
+		float job_error = 0.0f;
+		for(int i = 0; i < num; ++i){
+			job_error = std::max(job_error, MatrixError(scene.World(i), reference[i]));
+		}
+		checker.Check("simd worlds match the scalar reference", simd_error <= TOLERANCE && simd_updated == num);
+		checker.Check("job-split worlds match the scalar reference", job_error <= TOLERANCE && job_updated == num);
+		checker.Check("hierarchy is sorted into the expected levels", scene.LevelNum() == std::min(LEVEL_NUM, num));
+
+		//祖先のローカルの変換の積
+		float product_error = 0.0f;
+		for(int i = 0; i < std::min(num, SAMPLE_NUM); ++i){
+			const Scene::Entity e = static_cast<Scene::Entity>(uniform_int(num));
+			product_error = std::max(product_error, MatrixError(scene.World(e), SceneReferenceWorld(scene, locals, e)));
+		}
+		checker.Check("worlds match products of ancestor local transforms", product_error <= TOLERANCE);
+
+
+		//子を持つものを1つ動かすと、それと子孫だけが変わる
+		Scene::Entity moved = 0;
+		while(scene.Parent(moved) != Scene::INVALID_ENTITY){
+			++moved;
+		}
+		for(int i = 0; i < num; ++i){
+			reference[i] = scene.World(i);
+		}
+		locals[moved].position[1] += 1.0f;
+		locals[moved].Apply(&scene, moved);
+		scene.Update(&jobs);
+
+		int subtree_num = 0;
+		bool marked = true;
+		bool untouched = true;
+		float moved_error = 0.0f;
+		for(int i = 0; i < num; ++i){
+			const bool descendant = IsDescendant(scene, i, moved);
+			subtree_num += descendant ? 1 : 0;
+			marked = marked && (scene.WorldChanged(i) == descendant);
+			if(descendant){
+				moved_error = std::max(moved_error, MatrixError(scene.World(i), SceneReferenceWorld(scene, locals, i)));
+			}else{
+				const Scene::Matrix world = scene.World(i);
+				untouched = untouched && memcmp(&world, &reference[i], sizeof(Scene::Matrix)) == 0;
+			}
+		}
+		checker.Check("one change marks exactly its subtree", marked && subtree_num > 1 && scene.UpdatedNum() == subtree_num);
+		checker.Check("other worlds are left untouched", untouched);
+		checker.Check("the moved subtree follows its root", moved_error <= TOLERANCE);
+
+		//何も変えなければ求め直さない
+		scene.Update(&jobs);
+		checker.Check("an unchanged scene updates nothing", scene.UpdatedNum() == 0);
+
+
+		//親の付け替え(movedを別の根の子にする)と、輪になる付け替え
+		Scene::Entity new_parent = moved + 1;
+		while(scene.Parent(new_parent) != Scene::INVALID_ENTITY){
+			++new_parent;
+		}
+		Scene::Entity child = 0;
+		while(scene.Parent(child) != moved){
+			++child;
+		}
+		const bool reparented = scene.SetParent(moved, new_parent);
+		scene.Update(&jobs);
+		float reparent_error = 0.0f;
+		for(int i = 0; i < num; ++i){
+			if(IsDescendant(scene, i, moved)){
+				reparent_error = std::max(reparent_error, MatrixError(scene.World(i), SceneReferenceWorld(scene, locals, i)));
+			}
+		}
+		checker.Check("reparented subtrees follow the new parent", reparented && reparent_error <= TOLERANCE && scene.LevelNum() == std::min(LEVEL_NUM + 1, num));
+
+		const bool self = scene.SetParent(moved, moved);
+		const bool cycle = scene.SetParent(new_parent, child);
+		checker.Check("parenting to itself or a descendant is rejected", !self && !cycle && scene.Parent(new_parent) == Scene::INVALID_ENTITY);
+	}
+
+
+	//Sphere・Planeのアニメーション(Animateと同じ式)をDirectXMathの行列の積と同じ並びで求めたものと比べる
+	{
+		Scene scene;
+		const Scene::Entity sphere = scene.Create();
+		const Scene::Entity plane = scene.Create();
+		float animation_error = 0.0f;
+		for(int frame = 1; frame <= 800; frame += 7){
+			const float sphere_angle = (static_cast<float>(frame % 1800) * PI / 180.0f) / 5.0f;
+			const float sphere_position[3] = {0.0f, std::sin(PI * ((frame % 240) / 120.0f)) * 0.5f, std::sin(PI * ((frame % 120) / 60.0f)) * 0.5f};
+			const float plane_angle[2] = {(90.0f + 10.0f * std::sin(PI * (frame % 144) / 72.0f)) * PI / 180.0f, -PI * (frame % 400) / 200.0f};
+			const float one[3] = {1.0f, 1.0f, 1.0f};
+			const float plane_scale[3] = {3.0f, 3.0f, 1.0f};
+			const float plane_position[3] = {0.0f, -2.0f, 0.0f};
+
+			float q[4], qx[4], qy[4];
+			Scene::RotationY(sphere_angle, q);
+			scene.SetRotation(sphere, q);
+			scene.SetPosition(sphere, sphere_position[0], sphere_position[1], sphere_position[2]);
+			Scene::RotationX(plane_angle[0], qx);
+			Scene::RotationY(plane_angle[1], qy);
+			Scene::MultiplyRotation(qx, qy, q);
+			scene.SetRotation(plane, q);
+			scene.SetScale(plane, plane_scale[0], plane_scale[1], plane_scale[2]);
+			scene.SetPosition(plane, plane_position[0], plane_position[1], plane_position[2]);
+			scene.Update();
+
+			animation_error = std::max(animation_error, MatrixError(scene.World(sphere), AffineMatrix(one, RotationYMatrix(sphere_angle), sphere_position)));
+			animation_error = std::max(animation_error, MatrixError(scene.World(plane),
+				AffineMatrix(plane_scale, RotationXMatrix(plane_angle[0]) * RotationYMatrix(plane_angle[1]), plane_position)));
+		}
+		checker.Check("quaternion rotations match the sphere and plane matrices", animation_error <= TOLERANCE);
+
+
+		//アプリのカメラ: 注視点は画面の中央、手前・奥の面の深度は0と1
+		const Scene::Camera camera = {{1.0f, 1.0f, -6.0f}, {0.0f, 0.0f, 0.0f}, {0.0f, 1.0f, 0.0f}, 60.0f * PI / 180.0f, 640.0f / 480.0f, 1.0f, 20.0f};
+		scene.SetCamera(camera);
+		scene.Update();
+		const Scene::Matrix expected = ShadowCascades::Matrix::LookAtLH(camera.eye, camera.focus, camera.up) *
+			ShadowCascades::Matrix::PerspectiveFovLH(camera.fov_y, camera.aspect, camera.near_z, camera.far_z);
+
+		float dir[3] = {camera.focus[0] - camera.eye[0], camera.focus[1] - camera.eye[1], camera.focus[2] - camera.eye[2]};
+		const float dir_length = std::sqrt(dir[0] * dir[0] + dir[1] * dir[1] + dir[2] * dir[2]);
+		float near_point[3], far_point[3];
+		for(int k = 0; k < 3; ++k){
+			near_point[k] = camera.eye[k] + dir[k] / dir_length * camera.near_z;
+			far_point[k] = camera.eye[k] + dir[k] / dir_length * camera.far_z;
+		}
+		float focus[4], near_clip[4], far_clip[4];
+		scene.ViewProj().TransformPoint(camera.focus, focus);
+		scene.ViewProj().TransformPoint(near_point, near_clip);
+		scene.ViewProj().TransformPoint(far_point, far_clip);
+		checker.Check("camera view-projection is LookAtLH * PerspectiveFovLH",
+			MatrixError(scene.ViewProj(), expected) <= TOLERANCE && MatrixError(scene.View() * scene.Projection(), expected) <= TOLERANCE &&
+			std::fabs(focus[0] / focus[3]) < 1.0e-5f && std::fabs(focus[1] / focus[3]) < 1.0e-5f &&
+			std::fabs(near_clip[2] / near_clip[3]) < 1.0e-5f && std::fabs(far_clip[2] / far_clip[3] - 1.0f) < 1.0e-5f);
+	}
+
+
+	//所要時間
+	PrintLine("[scenebench] %s x%d, %u job threads\n", Scene::InstructionSet(), Scene::LaneNum(), jobs.ThreadNum());
+	static const int SIZES[] = {10000, 100000, 1000000};
+	for(int size : SIZES){
+		const int num = std::min(size, max_num);
+		if(size != SIZES[0] && num < size){
+			break;
+		}
+
+		Scene scene;
+		build(&scene, num);
+		const auto build_start = std::chrono::high_resolution_clock::now();
+		scene.Update(&jobs);
+		const double first_ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - build_start).count();
+
+		//全てを求め直す
+		double scalar_ms = 1.0e9, simd_ms = 1.0e9, job_ms = 1.0e9;
+		for(int r = 0; r < REPEAT_NUM; ++r){
+			touch_all(&scene);
+			auto start = std::chrono::high_resolution_clock::now();
+			scene.UpdateScalar();
+			scalar_ms = std::min(scalar_ms, std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count());
+
+			touch_all(&scene);
+			start = std::chrono::high_resolution_clock::now();
+			scene.Update();
+			simd_ms = std::min(simd_ms, std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count());
+
+			touch_all(&scene);
+			start = std::chrono::high_resolution_clock::now();
+			scene.Update(&jobs);
+			job_ms = std::min(job_ms, std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count());
+		}
+
+		//1%を変える(子孫も求め直す)
+		double sparse_ms = 1.0e9;
+		int sparse_updated = 0;
+		for(int r = 0; r < REPEAT_NUM; ++r){
+			for(int i = 0; i < std::max(1, num / 100); ++i){
+				const Scene::Entity e = static_cast<Scene::Entity>(uniform_int(num));
+				locals[e].Apply(&scene, e);
+			}
+			const auto start = std::chrono::high_resolution_clock::now();
+			sparse_updated = scene.Update(&jobs);
+			sparse_ms = std::min(sparse_ms, std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count());
+		}
+
+		PrintLine("[scenebench] %7d entities %d levels  first %8.3f ms  scalar %8.3f ms  simd %8.3f ms  jobs %8.3f ms  (%4.1fx, %6.1f M/s)  1%% changed %7.3f ms (%d updated)\n",
+			num, scene.LevelNum(), first_ms, scalar_ms, simd_ms, job_ms, scalar_ms / job_ms, num / job_ms / 1000.0, sparse_ms, sparse_updated);
+		if(num < size){
+			break;
+		}
+	}
+
+	return checker.Result();
+}
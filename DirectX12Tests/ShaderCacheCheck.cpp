@@ -0,0 +1,250 @@
+#include <cstdio>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "ShaderCache.h"
+#include "TestCommon.h"
+
+namespace{
+typedef ShaderCache::byte byte;
+
+bool WriteFile(const std::string &file_name, const void *data, size_t size){
+	FILE *fp = fopen(file_name.c_str(), "wb");
+	if(fp == nullptr){
+		return false;
+	}
+	const bool ok = (size == 0 || fwrite(data, 1, size, fp) == size);
+	return (fclose(fp) == 0) && ok;
+}
+
+bool WriteText(const std::string &file_name, const std::string &text){
+	return WriteFile(file_name, text.data(), text.size());
+}
+
+bool ReadBytes(const std::string &file_name, std::vector<byte> *data){
+	MappedFile file;
+	if(!file.Open(file_name.c_str())){
+		return false;
+	}
+	data->assign(file.Data(), file.Data() + file.Size());
+	return true;
+}
+
+//file_nameのディレクトリを除いた部分(#includeに書く名前)
+std::string FileNameOf(const std::string &file_name){
+	const size_t pos = file_name.find_last_of("/\\");
+	return (pos == std::string::npos) ? file_name : file_name.substr(pos + 1);
+}
+
+bool SameData(const ShaderCache &cache, uint64_t key, const std::vector<byte> &expected){
+	const byte *data{};
+	size_t size{};
+	return cache.Find(key, &data, &size) && size == expected.size() && (size == 0 || memcmp(data, expected.data(), size) == 0);
+}
+}
+
+
+//DirectX12Tests -shadercheck <作業ファイルの名前>
+//ShaderCacheのキーとファイルの読み書きを確かめる(作業ファイルの名前に拡張子などを付けたファイルを作る)
+//・同じソース・エントリポイント・プロファイル・フラグからは常に同じキーを作り、どれか1つが変わればキーも変わる
+//・インクルードしたファイル(入れ子を含む)を書き換えるとキーが変わり、元に戻すと元のキーになる
+//・Saveしたファイルを開き直すと、全てのバイトコードが同じ内容・アライメントで見つかる
+//・途中で切れたファイルや、ヘッダ・エントリ表・バイトコードを書き換えたファイルは開かず、空のキャッシュになる
+int ShaderCacheCheckCommand(const char *command_line){
+	char base[260]{};
+	if(sscanf(command_line, "-shadercheck %259s", base) < 1){
+		return -1;
+	}
+	const std::string cache_name = std::string(base) + ".bin";
+	const std::string broken_name = std::string(base) + "_broken.bin";
+	const std::string main_name = std::string(base) + ".hlsl";
+	const std::string include_name = std::string(base) + "_inc.hlsl";
+	const std::string common_name = std::string(base) + "_common.hlsl";
+
+	Checker checker("shadercheck");
+
+	TestRandom random(13579u);
+
+
+	//キーの安定性
+	{
+		ShaderCache::Source source;
+		source.text = "float4 main() : SV_Target { return 1; }";
+		const uint64_t key = ShaderCache::MakeKey(source, "main", "ps_5_0", 1);
+		checker.Check("same input gives the same key", key == ShaderCache::MakeKey(source, "main", "ps_5_0", 1));
+		checker.Check("entry point changes the key", key != ShaderCache::MakeKey(source, "main2", "ps_5_0", 1));
+		checker.Check("profile changes the key", key != ShaderCache::MakeKey(source, "main", "ps_5_1", 1));
+		checker.Check("flags change the key", key != ShaderCache::MakeKey(source, "main", "ps_5_0", 3));
+
+		ShaderCache::Source edited = source;
+		edited.text += " ";
+		checker.Check("source text changes the key", key != ShaderCache::MakeKey(edited, "main", "ps_5_0", 1));
+
+		//要素の境界がずれただけでは同じキーにならない
+		ShaderCache::Source a;
+		ShaderCache::Source b;
+		a.include_names = {"ab"};
+		a.include_texts = {"c"};
+		b.include_names = {"a"};
+		b.include_texts = {"bc"};
+		checker.Check("shifted boundaries give different keys", ShaderCache::MakeKey(a, "main", "ps_5_0", 0) != ShaderCache::MakeKey(b, "main", "ps_5_0", 0)
+			&& ShaderCache::MakeKey(source, "ma", "inps_5_0", 0) != ShaderCache::MakeKey(source, "main", "ps_5_0", 0));
+	}
+
+	//インクルードしたファイルの変更
+	{
+		const std::string main_text = "#include \"" + FileNameOf(include_name) + "\"\n"
+			"  #  include \"" + FileNameOf(common_name) + "\"\n"
+			"#include <system.hlsl>\n"
+			"float4 main() : SV_Target { return Color(); }\n";
+		const std::string include_text = "#include \"" + FileNameOf(common_name) + "\"\nfloat4 Color() { return Scale * 0.5; }\n";
+		bool written = WriteText(main_name, main_text) && WriteText(include_name, include_text) && WriteText(common_name, "static const float Scale = 1.0;\n");
+
+		ShaderCache::Source source;
+		const bool read = ShaderCache::ReadSource(main_name.c_str(), &source);
+		checker.Check("ReadSource collects nested includes once", written && read && source.include_names.size() == 2
+			&& source.include_names[0] == include_name && source.include_names[1] == common_name);
+		const uint64_t key = ShaderCache::MakeKey(source, "main", "ps_5_0", 0);
+
+		ShaderCache::Source again;
+		ShaderCache::ReadSource(main_name.c_str(), &again);
+		checker.Check("reading the same files gives the same key", key == ShaderCache::MakeKey(again, "main", "ps_5_0", 0));
+
+		written = WriteText(common_name, "static const float Scale = 2.0;\n");
+		ShaderCache::Source changed;
+		ShaderCache::ReadSource(main_name.c_str(), &changed);
+		checker.Check("changing a nested include changes the key", written && key != ShaderCache::MakeKey(changed, "main", "ps_5_0", 0));
+
+		written = WriteText(common_name, "static const float Scale = 1.0;\n");
+		ShaderCache::Source restored;
+		ShaderCache::ReadSource(main_name.c_str(), &restored);
+		checker.Check("restoring the include restores the key", written && key == ShaderCache::MakeKey(restored, "main", "ps_5_0", 0));
+
+		remove(common_name.c_str());
+		ShaderCache::Source missing;
+		checker.Check("missing include fails ReadSource", !ShaderCache::ReadSource(main_name.c_str(), &missing));
+
+		remove(main_name.c_str());
+		remove(include_name.c_str());
+	}
+
+
+	//保存と読み込み
+	std::vector<uint64_t> keys;
+	std::vector<std::vector<byte>> blobs;
+	for(int i = 0; i < 24; ++i){
+		keys.push_back((static_cast<uint64_t>(random.Next()) << 40) ^ (static_cast<uint64_t>(random.Next()) << 16) ^ i);
+		std::vector<byte> blob(1 + random.Next() % 3000);
+		for(byte &b : blob){
+			b = static_cast<byte>(random.Next());
+		}
+		blobs.push_back(blob);
+	}
+	{
+		remove(cache_name.c_str());
+		ShaderCache cache;
+		checker.Check("missing file opens as an empty cache", !cache.Open(cache_name.c_str()) && cache.EntryNum() == 0);
+
+		for(size_t i = 0; i < keys.size() / 2; ++i){
+			cache.Add(keys[i], blobs[i].data(), blobs[i].size());
+		}
+		cache.Add(keys[0], blobs[1].data(), blobs[1].size());	//同じキーは最初のものを残す
+		checker.Check("pending entries are found before Save", cache.IsDirty() && SameData(cache, keys[0], blobs[0]));
+		checker.Check("first save succeeds", cache.Save(cache_name.c_str()) && !cache.IsDirty());
+		cache.Close();	//マップしたままのファイルはWindowsでは上書きできない
+
+		//開き直して残りを足す
+		ShaderCache reopened;
+		bool found = reopened.Open(cache_name.c_str()) && reopened.EntryNum() == static_cast<int>(keys.size() / 2);
+		for(size_t i = 0; i < keys.size() / 2; ++i){
+			found = found && SameData(reopened, keys[i], blobs[i]);
+		}
+		checker.Check("reopened cache finds every entry", found);
+
+		for(size_t i = keys.size() / 2; i < keys.size(); ++i){
+			reopened.Add(keys[i], blobs[i].data(), blobs[i].size());
+		}
+		checker.Check("second save merges file and pending entries", reopened.Save(cache_name.c_str()) && reopened.EntryNum() == static_cast<int>(keys.size()));
+
+		ShaderCache merged;
+		bool same = merged.Open(cache_name.c_str());
+		bool aligned = true;
+		for(size_t i = 0; i < keys.size(); ++i){
+			same = same && SameData(merged, keys[i], blobs[i]);
+			const byte *data{};
+			size_t size{};
+			aligned = aligned && merged.Find(keys[i], &data, &size) && (reinterpret_cast<uintptr_t>(data) % ShaderCache::DATA_ALIGNMENT == 0);
+		}
+		const byte *data{};
+		size_t size{};
+		checker.Check("round trip keeps every bytecode", same && merged.EntryNum() == static_cast<int>(keys.size()));
+		checker.Check("bytecode is aligned in the mapping", aligned);
+		checker.Check("unknown key is not found", !merged.Find(keys[0] ^ 1, &data, &size));
+	}
+
+	//壊れたファイル
+	{
+		std::vector<byte> file;
+		const bool loaded = ReadBytes(cache_name, &file);
+		ShaderCache::Header header{};
+		if(loaded){
+			memcpy(&header, file.data(), sizeof(header));
+		}
+		checker.Check("saved file has the expected header", loaded && header.magic == ShaderCache::MAGIC && header.entry_num == keys.size());
+
+		auto rejected = [&](const std::vector<byte> &bytes){
+			ShaderCache cache;
+			const byte *data{};
+			size_t size{};
+			return WriteFile(broken_name, bytes.data(), bytes.size()) && !cache.Open(broken_name.c_str())
+				&& cache.EntryNum() == 0 && !cache.Find(keys[0], &data, &size);
+		};
+
+		bool truncated = loaded;
+		for(size_t size = 0; loaded && size < file.size(); size += 1 + size / 16){
+			truncated = truncated && rejected(std::vector<byte>(file.begin(), file.begin() + size));
+		}
+		truncated = truncated && loaded && rejected(std::vector<byte>(file.begin(), file.end() - 1));
+		checker.Check("truncated files are rejected", truncated);
+
+		//ヘッダ・エントリ表の各フィールドと、各バイトコードの1バイトを書き換える
+		bool corrupted = loaded;
+		const size_t table_end = sizeof(ShaderCache::Header) + sizeof(ShaderCache::Entry) * keys.size();
+		for(size_t offset = 0; loaded && offset < table_end; offset += 4){
+			if(offset < sizeof(ShaderCache::Header) && offset >= offsetof(ShaderCache::Header, reserved)){
+				continue;
+			}
+			const size_t field = (offset - sizeof(ShaderCache::Header)) % sizeof(ShaderCache::Entry);
+			if(offset >= sizeof(ShaderCache::Header) && field < sizeof(uint64_t)){
+				continue;	//キーを書き換えたものは別のキーのエントリとして読める
+			}
+			std::vector<byte> bytes = file;
+			bytes[offset] ^= 0x5a;
+			corrupted = corrupted && rejected(bytes);
+		}
+		checker.Check("corrupted header or entry table is rejected", corrupted);
+
+		bool flipped = loaded;
+		for(size_t i = 0; loaded && i < keys.size(); ++i){
+			ShaderCache::Entry entry{};
+			memcpy(&entry, file.data() + sizeof(ShaderCache::Header) + sizeof(entry) * i, sizeof(entry));
+			std::vector<byte> bytes = file;
+			bytes[static_cast<size_t>(entry.offset + random.Next() % entry.size)] ^= 0x01;
+			flipped = flipped && rejected(bytes);
+		}
+		checker.Check("corrupted bytecode is rejected", flipped);
+
+		//壊れたファイルを開いた後も追加と保存はできる
+		ShaderCache cache;
+		cache.Open(broken_name.c_str());
+		cache.Add(keys[0], blobs[0].data(), blobs[0].size());
+		checker.Check("broken file is replaced by Save", cache.Save(broken_name.c_str()) && cache.EntryNum() == 1 && SameData(cache, keys[0], blobs[0]));
+	}
+
+	remove(cache_name.c_str());
+	remove(broken_name.c_str());
+
+	return checker.Result();
+}
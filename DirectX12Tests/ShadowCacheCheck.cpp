@@ -0,0 +1,291 @@
+#include <cstdio>
+#include <cstdint>
+#include <algorithm>
+#include <functional>
+#include <vector>
+#include "HeadlessRenderer.h"
+#include "RendererGraph.h"
+#include "ResidencyManager.h"
+#include "ShadowCache.h"
+#include "TestCommon.h"
+
+namespace{
+//シャドウマップのキャッシュの確認用のキャスター(ライトから見た正方形)
+struct SquareCaster{
+	float	transform[3];	//左下の位置と深度
+	int		size;
+};
+
+//平行移動だけのビュー(view[12], view[13])で正方形の深度をmapに描く(深度テストはLESS_EQUAL)
+void DrawSquareCaster(const SquareCaster &caster, const float view[16], int map_size, float *map){
+	const int x0 = static_cast<int>(caster.transform[0] + view[12]);
+	const int y0 = static_cast<int>(caster.transform[1] + view[13]);
+	for(int y = std::max(y0, 0); y < std::min(y0 + caster.size, map_size); ++y){
+		for(int x = std::max(x0, 0); x < std::min(x0 + caster.size, map_size); ++x){
+			float &depth = map[y * map_size + x];
+			depth = std::min(depth, caster.transform[2]);
+		}
+	}
+}
+
+//キャスターの動き方をフレームごとに与えて、ShadowCacheが決めた処理の回数を数える
+ShadowCache::Stats RunShadowCache(int caster_num, int layer_num, int frame_num, uint32_t static_frame_num, const std::function<bool(int, int)> &moves){
+	ShadowCache cache;
+	cache.Initialize(layer_num, static_frame_num);
+	std::vector<float> positions(caster_num, 0.0f);
+	for(int i = 0; i < caster_num; ++i){
+		cache.AddCaster();
+	}
+
+	float view[16]{};
+	for(int frame = 0; frame < frame_num; ++frame){
+		for(int i = 0; i < caster_num; ++i){
+			positions[i] += moves(frame, i) ? 1.0f : 0.0f;
+			cache.SetTransform(i, &positions[i], 1);
+		}
+		for(int layer = 0; layer < layer_num; ++layer){
+			cache.SetView(layer, view);
+		}
+		cache.Update();
+	}
+	return cache.GetStats();
+}
+}
+
+
+//DirectX12Tests -shadowcache [フレーム数]
+//キャスターとライトを乱数で動かしながら、ShadowCacheの判定に従ってキャッシュ・シャドウマップを更新した結果が、
+//毎フレーム全てのキャスターを描いた結果と一致することを確かめる(深度は正方形をCPUで描いて比べる)
+//あわせて、動かないものだけのときに描き直さないこと、動くものだけを描き直すこと、止まったものをキャッシュに移すこと、
+//常駐に失敗して記録しなかったフレームの描き直しをInvalidateで次のフレームに持ち越すことを確かめ、
+//アプリの設定(キャスター2つ・カスケード3枚)で動かし方ごとに描き直さずに済んだフレーム・キャスターの描画の数を表示する
+int ShadowCacheCheckCommand(const char *command_line){
+	static const int MAP_SIZE		= 32;
+	static const int LAYER_NUM		= 3;
+	static const int CASTER_NUM		= 8;
+	static const uint32_t STATIC_FRAME_NUM = 10;
+
+	int frame_num = 1000;
+	sscanf(command_line, "-shadowcache %d", &frame_num);
+	if(frame_num < 1){
+		return -1;
+	}
+
+	Checker checker("shadowcache");
+
+	//キャスターごとに、前半だけ動き続ける・ずっと止まっている・ときどき一定の間だけ動くのいずれかにする
+	//ライトもまれに動かす
+	{
+		TestRandom random(97531u);
+
+		std::vector<SquareCaster> casters(CASTER_NUM);
+		std::vector<int> kinds(CASTER_NUM);
+		std::vector<int> moving_frames(CASTER_NUM, 0);
+		for(int i = 0; i < CASTER_NUM; ++i){
+			casters[i] = {{static_cast<float>(random.Next(MAP_SIZE)), static_cast<float>(random.Next(MAP_SIZE)), 0.1f + 0.1f * i}, 4 + static_cast<int>(random.Next(8))};
+			kinds[i] = (i == 0) ? 0 : 1 + i % 2;
+		}
+		float views[LAYER_NUM][16]{};
+
+		ShadowCache cache;
+		cache.Initialize(LAYER_NUM, STATIC_FRAME_NUM);
+		for(int i = 0; i < CASTER_NUM; ++i){
+			cache.AddCaster();
+		}
+
+		std::vector<float> cached(LAYER_NUM * MAP_SIZE * MAP_SIZE, 1.0f);
+		std::vector<float> shadow_map(LAYER_NUM * MAP_SIZE * MAP_SIZE, 1.0f);
+		std::vector<float> reference(LAYER_NUM * MAP_SIZE * MAP_SIZE, 1.0f);
+		int mismatch_num = 0;
+		int skipped_while_moving = 0;
+
+		for(int frame = 0; frame < frame_num; ++frame){
+			bool any_moved = false;
+			for(int i = 0; i < CASTER_NUM; ++i){
+				if(kinds[i] == 2 && moving_frames[i] == 0 && random.Next(100) < 3){
+					moving_frames[i] = 1 + static_cast<int>(random.Next(20));
+				}
+				const bool moves = (kinds[i] == 0 && frame < frame_num / 2) || (moving_frames[i] > 0);
+				if(moving_frames[i] > 0){
+					--moving_frames[i];
+				}
+				if(moves){
+					casters[i].transform[0] = static_cast<float>(static_cast<int>(casters[i].transform[0] + 1.0f + random.Next(3)) % MAP_SIZE);
+					casters[i].transform[1] = static_cast<float>(static_cast<int>(casters[i].transform[1] + random.Next(3)) % MAP_SIZE);
+					any_moved = true;
+				}
+				cache.SetTransform(i, casters[i].transform, 3);
+			}
+			const bool light_moved = (random.Next(100) == 0);
+			for(int layer = 0; layer < LAYER_NUM; ++layer){
+				if(light_moved){
+					views[layer][12] = static_cast<float>(random.Next(9)) - 4.0f;
+					views[layer][13] = static_cast<float>(random.Next(9)) - 4.0f;
+				}
+				cache.SetView(layer, views[layer]);
+			}
+
+			//D3D12Managerのパスと同じ順で、キャッシュ・シャドウマップを更新する
+			const ShadowCache::Redraw redraw = cache.Update();
+			for(int layer = 0; layer < LAYER_NUM; ++layer){
+				float *cached_layer = &cached[layer * MAP_SIZE * MAP_SIZE];
+				float *map_layer = &shadow_map[layer * MAP_SIZE * MAP_SIZE];
+				if(redraw == ShadowCache::REDRAW_FULL && cache.HasStaticCaster()){
+					std::fill(cached_layer, cached_layer + MAP_SIZE * MAP_SIZE, 1.0f);
+					for(int i = 0; i < CASTER_NUM; ++i){
+						if(cache.IsStatic(i)){
+							DrawSquareCaster(casters[i], views[layer], MAP_SIZE, cached_layer);
+						}
+					}
+				}
+				if(redraw != ShadowCache::REDRAW_NONE){
+					if(cache.HasStaticCaster()){
+						std::copy(cached_layer, cached_layer + MAP_SIZE * MAP_SIZE, map_layer);
+					}else{
+						std::fill(map_layer, map_layer + MAP_SIZE * MAP_SIZE, 1.0f);
+					}
+					for(int i = 0; i < CASTER_NUM; ++i){
+						if(!cache.IsStatic(i)){
+							DrawSquareCaster(casters[i], views[layer], MAP_SIZE, map_layer);
+						}
+					}
+				}
+
+				//毎フレーム全て描いたもの
+				float *reference_layer = &reference[layer * MAP_SIZE * MAP_SIZE];
+				std::fill(reference_layer, reference_layer + MAP_SIZE * MAP_SIZE, 1.0f);
+				for(int i = 0; i < CASTER_NUM; ++i){
+					DrawSquareCaster(casters[i], views[layer], MAP_SIZE, reference_layer);
+				}
+			}
+
+			mismatch_num += (shadow_map == reference) ? 0 : 1;
+			skipped_while_moving += (redraw == ShadowCache::REDRAW_NONE && (any_moved || light_moved)) ? 1 : 0;
+		}
+
+		const ShadowCache::Stats &s = cache.GetStats();
+		const uint64_t all_draws = static_cast<uint64_t>(frame_num) * CASTER_NUM * LAYER_NUM;
+		checker.Check("cached shadow map matches a full redraw every frame", mismatch_num == 0);
+		checker.Check("never skips a frame where something moved", skipped_while_moving == 0);
+		checker.Check("frame counters add up", s.frame_num == static_cast<uint64_t>(frame_num) && s.skipped_num + s.dynamic_num + s.full_num == s.frame_num);
+		checker.Check("draw counters add up", s.static_draw_num + s.dynamic_draw_num + s.skipped_draw_num == all_draws);
+		checker.Check("mixed scene skips frames and caster draws", s.skipped_num > 0 && s.skipped_draw_num > 0);
+		PrintLine("[shadowcache] random scene: %d frames  skipped %llu  dynamic only %llu  full %llu  caster draws %llu / %llu\n",
+			frame_num, static_cast<unsigned long long>(s.skipped_num), static_cast<unsigned long long>(s.dynamic_num),
+			static_cast<unsigned long long>(s.full_num), static_cast<unsigned long long>(s.static_draw_num + s.dynamic_draw_num),
+			static_cast<unsigned long long>(all_draws));
+	}
+
+	//動かないものだけなら最初のフレームだけ描く
+	{
+		const ShadowCache::Stats s = RunShadowCache(2, LAYER_NUM, 100, STATIC_FRAME_NUM, [](int, int){return false;});
+		checker.Check("still casters are drawn once", s.full_num == 1 && s.skipped_num == 99 && s.static_draw_num == 2 * LAYER_NUM);
+	}
+
+	//動くものは動的なものになり、以後はそれだけを描く
+	{
+		const ShadowCache::Stats s = RunShadowCache(2, LAYER_NUM, 100, STATIC_FRAME_NUM, [](int, int caster){return caster == 0;});
+		checker.Check("only the moving caster is redrawn", s.full_num == 2 && s.dynamic_num == 98 && s.dynamic_draw_num == (98 + 1) * LAYER_NUM);
+	}
+
+	//止まったものはSTATIC_FRAME_NUMフレーム後にキャッシュに移し、以後は描き直さない
+	{
+		const ShadowCache::Stats s = RunShadowCache(2, LAYER_NUM, 100, STATIC_FRAME_NUM, [](int frame, int caster){return caster == 0 && frame < 20;});
+		checker.Check("a caster that stops is moved into the cache", s.full_num == 3 && s.dynamic_num == 18 && s.skipped_num == 100 - 3 - 18);
+	}
+
+	//ライトが動いたらキャッシュごと描き直す
+	{
+		ShadowCache cache;
+		cache.Initialize(1, STATIC_FRAME_NUM);
+		const float position = 0.0f;
+		float view[16]{};
+		cache.SetTransform(cache.AddCaster(), &position, 1);
+		cache.SetView(0, view);
+		const ShadowCache::Redraw first = cache.Update();
+		const ShadowCache::Redraw still = cache.Update();
+		view[12] = 1.0f;
+		cache.SetView(0, view);
+		const ShadowCache::Redraw moved = cache.Update();
+		cache.Invalidate();
+		const ShadowCache::Redraw invalidated = cache.Update();
+		checker.Check("light movement and Invalidate redraw the cache", first == ShadowCache::REDRAW_FULL && still == ShadowCache::REDRAW_NONE &&
+			moved == ShadowCache::REDRAW_FULL && invalidated == ShadowCache::REDRAW_FULL);
+	}
+
+	//D3D12Managerと同じ順(キャスターを調べてUpdate → 使うヒープを常駐させる)で、常駐に失敗したフレームを記録しない場合
+	//Updateで動いたことは消費されるので、Invalidateしなければやり直したフレームでシャドウマップを描き直さない
+	for(bool invalidate : {false, true}){
+		static constexpr uint64_t MB = 1024 * 1024;
+		HeadlessResidencyTarget target;
+		target.SetBudget(MEMORY_SEGMENT_LOCAL, 100 * MB);
+		ResidencyManager residency;
+		residency.Initialize(&target);
+		const RenderResource heaps[2] = {{1}, {2}};
+		int handles[2];
+		for(int i = 0; i < 2; ++i){
+			handles[i] = residency.Register(heaps[i], 60 * MB, MEMORY_SEGMENT_LOCAL);
+			target.Add(heaps[i], 60 * MB, MEMORY_SEGMENT_LOCAL);
+		}
+
+		ShadowCache cache;
+		cache.Initialize(LAYER_NUM, STATIC_FRAME_NUM);
+		const int caster = cache.AddCaster();
+		const float view[16]{};
+		for(int layer = 0; layer < LAYER_NUM; ++layer){
+			cache.SetView(layer, view);
+		}
+
+		//記録したフレームでシャドウマップのパスを使うか(記録しなければfalse)
+		auto populate = [&](uint64_t frame, float position, int heap, bool *recorded){
+			cache.SetTransform(caster, &position, 1);
+			cache.Update();
+			target.Complete(frame - 1);
+			residency.BeginFrame(frame);
+			residency.Use(handles[heap]);
+			*recorded = residency.Update(frame - 1);
+			if(!*recorded){
+				if(invalidate){
+					cache.Invalidate();
+				}
+				return false;
+			}
+			target.Access(heaps[heap], frame);
+			const RendererPassState state{cache.LastRedraw(), cache.HasStaticCaster(), cache.HasDynamicCaster(), false, false};
+			return IsRendererPassEnabled(PASS_SHADOW_COPY, state) || IsRendererPassEnabled(PASS_SHADOW, state);
+		};
+
+		//1つ目のヒープを退避し、キャスターが動いたフレームでそれを常駐させ直すのに失敗する
+		bool recorded[3];
+		const bool first = populate(1, 0.0f, 1, &recorded[0]);
+		target.FailMakeResident(1);
+		populate(2, 1.0f, 0, &recorded[1]);
+		const bool retried = populate(3, 1.0f, 0, &recorded[2]);
+		const bool skipped = first && recorded[0] && !recorded[1] && recorded[2] && target.ErrorNum() == 0;
+		if(invalidate){
+			checker.Check("skipped frame's redraw is done on the retried frame", skipped && retried);
+		}else{
+			checker.Check("without Invalidate the skipped frame's redraw is lost", skipped && !retried);
+		}
+	}
+
+	//アプリの設定(球・板ポリの2つ、カスケード3枚、D3D12Managerと同じ判定)で-pauseの指定ごとに数える
+	{
+		static const struct{
+			const char	*name;
+			bool		moves[2];	//球・板ポリ
+		}modes[] = {
+			{"animated", {true, true}},
+			{"-pause plane", {true, false}},
+			{"-pause", {false, false}},
+		};
+		for(const auto &mode : modes){
+			const ShadowCache::Stats s = RunShadowCache(2, 3, frame_num, ShadowCache::DEFAULT_STATIC_FRAME_NUM, [&mode](int, int caster){return mode.moves[caster];});
+			PrintLine("[shadowcache] %-14s skipped %5llu  dynamic only %5llu  full %llu  caster draws skipped %5.1f%%\n",
+				mode.name, static_cast<unsigned long long>(s.skipped_num), static_cast<unsigned long long>(s.dynamic_num),
+				static_cast<unsigned long long>(s.full_num), 100.0 * static_cast<double>(s.skipped_draw_num) / (2.0 * 3.0 * frame_num));
+		}
+	}
+
+	return checker.Result();
+}
@@ -0,0 +1,249 @@
+#include <cstdio>
+#include <cstdint>
+#include <chrono>
+#include <cmath>
+#include <algorithm>
+#include <vector>
+#include "ShadowFilter.h"
+#include "TestCommon.h"
+
+namespace{
+//シャドウマップの横方向の断面(受ける側の深度z・v = 0.5)のうち、中央の半分(u = 0.25から0.75)で光が当たる割合を調べる
+//(シャドウマップの外は光が当たるので、端の近くは含めない)
+struct ShadowProfile{
+	float	penumbra;		//0.01より大きく0.99より小さい範囲の幅(テクセル)
+	float	edge;			//影の縁(u = 0.5)での値
+	float	min;
+	float	max;
+	bool	monotonic;		//uが増えるにつれて減らない
+};
+
+ShadowProfile MeasureShadowProfile(const ShadowFilter &filter, ShadowFilterTier tier, float z, float angle = 0.0f){
+	static const int STEP_NUM = 8;	//1テクセルあたりの標本数
+
+	ShadowProfile profile{};
+	profile.min			= 1.0f;
+	profile.max			= 0.0f;
+	profile.monotonic	= true;
+
+	const int width = filter.Width();
+	float previous = -1.0f;
+	int penumbra_num = 0;
+	for(int i = width * STEP_NUM / 4; i <= width * STEP_NUM * 3 / 4; ++i){
+		const float u = static_cast<float>(i) / (width * STEP_NUM);
+		const float visibility = filter.Visibility(tier, u, 0.5f, z, angle);
+		profile.min = std::min(profile.min, visibility);
+		profile.max = std::max(profile.max, visibility);
+		profile.monotonic = profile.monotonic && (visibility >= previous - 1e-5f);
+		penumbra_num += (visibility > 0.01f && visibility < 0.99f) ? 1 : 0;
+		previous = visibility;
+	}
+	profile.penumbra	= static_cast<float>(penumbra_num) / STEP_NUM;
+	profile.edge		= filter.Visibility(tier, 0.5f, 0.5f, z, angle);
+	return profile;
+}
+}
+
+
+//DirectX12Tests -shadowfiltercheck [1段階あたりの計測の回数]
+//シャドウマップのフィルタの段階ごとに、CPUでの参照実装(ShadowFilter)が期待する影の縁を作ることを確かめる
+//・まっすぐな縁: ハードは縁で0から1に切り替わり、PCFは1テクセル、ポアソンはディスクの直径、EVSMはぼかしの幅で滑らかに変わる
+//・全て影・ゆるい斜面の自己遮蔽・重なった影の光漏れ(EVSM)・ポアソンディスクの回転
+//あわせて、段階ごとの1回のフィルタの所要時間とテクセルを読む数、EVSMの前処理の所要時間を表示する
+int ShadowFilterCheckCommand(const char *command_line){
+	static const int MAP_SIZE		= 64;
+	static const int BENCH_SIZE		= 1024;
+	static const float BIAS			= 0.005f;	//シェーダのSHADOW_BIASと同じ
+
+	int lookup_num = 1000000;
+	sscanf(command_line, "-shadowfiltercheck %d", &lookup_num);
+	if(lookup_num < 1){
+		return -1;
+	}
+
+	Checker checker("shadowfilter");
+
+	std::vector<float> depth(MAP_SIZE * MAP_SIZE);
+	ShadowFilter filter;
+
+	//左半分を深度0.3の遮蔽物が覆い、深度0.6の面が影を受ける(縁はu = 0.5)
+	{
+		for(int y = 0; y < MAP_SIZE; ++y){
+			for(int x = 0; x < MAP_SIZE; ++x){
+				depth[y * MAP_SIZE + x] = (x < MAP_SIZE / 2) ? 0.3f : 1.0f;
+			}
+		}
+		filter.SetDepthMap(depth.data(), MAP_SIZE, MAP_SIZE);
+		filter.Prefilter();
+
+		ShadowProfile profiles[SHADOW_FILTER_NUM];
+		for(int tier = 0; tier < SHADOW_FILTER_NUM; ++tier){
+			profiles[tier] = MeasureShadowProfile(filter, static_cast<ShadowFilterTier>(tier), (tier == SHADOW_FILTER_EVSM) ? 0.6f : 0.6f - BIAS);
+			PrintLine("[shadowfilter] %-8s straight edge: penumbra %5.2f texels  value at the edge %.3f\n",
+				ShadowFilter::TierName(static_cast<ShadowFilterTier>(tier)), profiles[tier].penumbra, profiles[tier].edge);
+		}
+
+		bool all_monotonic = true;
+		bool all_full_range = true;
+		for(const ShadowProfile &p : profiles){
+			all_monotonic = all_monotonic && p.monotonic;
+			all_full_range = all_full_range && p.min == 0.0f && p.max == 1.0f;
+		}
+		checker.Check("every tier is dark inside, lit outside and monotonic", all_monotonic && all_full_range);
+
+		const ShadowProfile &hard = profiles[SHADOW_FILTER_HARD];
+		const ShadowProfile &pcf = profiles[SHADOW_FILTER_PCF];
+		const ShadowProfile &poisson = profiles[SHADOW_FILTER_POISSON];
+		const ShadowProfile &evsm = profiles[SHADOW_FILTER_EVSM];
+		checker.Check("hard: the edge is a step", hard.penumbra == 0.0f);
+
+		//縁の1/4テクセル手前は4つのうち右の2つだけが光を受け、横の重みが1/4になる
+		const float quarter = filter.Pcf(0.5f - 0.25f / MAP_SIZE, 0.5f, 0.6f - BIAS);
+		checker.Check("pcf: bilinear weights of the 2x2 comparisons", pcf.edge == 0.5f && quarter == 0.25f);
+		checker.Check("pcf: the penumbra is one texel wide", pcf.penumbra > 0.8f && pcf.penumbra <= 1.0f);
+
+		//ディスクの点の横の広がり(最も離れた2点の間+PCFの1テクセル)より広くならない
+		float disk_min = 0.0f;
+		float disk_max = 0.0f;
+		for(const float *p : ShadowFilter::POISSON_DISK){
+			disk_min = std::min(disk_min, p[0]);
+			disk_max = std::max(disk_max, p[0]);
+		}
+		const float disk_width = (disk_max - disk_min) * ShadowFilter::POISSON_RADIUS + 1.0f;
+		checker.Check("poisson: the penumbra spans the disk", poisson.penumbra > 2.0f * ShadowFilter::POISSON_RADIUS && poisson.penumbra <= disk_width);
+		checker.Check("poisson: the edge is half lit", std::fabs(poisson.edge - 0.5f) < 0.2f);
+
+		//EVSMはぼかしの幅より先では完全な影・完全に光が当たる
+		const float blur_end = (ShadowFilter::EVSM_BLUR_RADIUS + 1.0f) / MAP_SIZE;
+		const bool evsm_outside = filter.Evsm(0.5f - blur_end, 0.5f, 0.6f) == 0.0f && filter.Evsm(0.5f + blur_end, 0.5f, 0.6f) == 1.0f;
+		checker.Check("evsm: the penumbra is wider than pcf and inside the blur", evsm.penumbra > pcf.penumbra && evsm_outside);
+		checker.Check("evsm: the edge is partly lit", evsm.edge > 0.05f && evsm.edge < 0.95f);
+
+		//ポアソンディスクを回しても縁から離れたところは変わらず、縁では回した結果の平均が半分に近づく
+		float average = 0.0f;
+		bool far_unchanged = true;
+		static const int ANGLE_NUM = 64;
+		for(int i = 0; i < ANGLE_NUM; ++i){
+			const float angle = 6.2831853f * i / ANGLE_NUM;
+			average += filter.Poisson(0.5f, 0.5f, 0.6f - BIAS, angle) / ANGLE_NUM;
+			far_unchanged = far_unchanged && filter.Poisson(0.25f, 0.5f, 0.6f - BIAS, angle) == 0.0f && filter.Poisson(0.75f, 0.5f, 0.6f - BIAS, angle) == 1.0f;
+		}
+		checker.Check("poisson: rotation averages to a half lit edge", std::fabs(average - 0.5f) < 0.05f && far_unchanged);
+	}
+
+	//全て覆われていれば全ての段階で影
+	{
+		std::fill(depth.begin(), depth.end(), 0.3f);
+		filter.SetDepthMap(depth.data(), MAP_SIZE, MAP_SIZE);
+		filter.Prefilter();
+
+		bool dark = true;
+		for(int tier = 0; tier < SHADOW_FILTER_NUM; ++tier){
+			const float z = (tier == SHADOW_FILTER_EVSM) ? 0.6f : 0.6f - BIAS;
+			const ShadowProfile p = MeasureShadowProfile(filter, static_cast<ShadowFilterTier>(tier), z);
+			dark = dark && p.max == 0.0f;
+		}
+		checker.Check("a fully covered receiver is dark in every tier", dark);
+	}
+
+	//ゆるい斜面(シャドウマップに描いた面そのもの)は自分に影を落とさない(EVSMは丸めの誤差の分だけ1を下回ってよい)
+	{
+		for(int y = 0; y < MAP_SIZE; ++y){
+			for(int x = 0; x < MAP_SIZE; ++x){
+				depth[y * MAP_SIZE + x] = 0.4f + 0.001f * x + 0.0005f * y;
+			}
+		}
+		filter.SetDepthMap(depth.data(), MAP_SIZE, MAP_SIZE);
+		filter.Prefilter();
+
+		float min_visibility[SHADOW_FILTER_NUM];
+		for(int tier = 0; tier < SHADOW_FILTER_NUM; ++tier){
+			min_visibility[tier] = 1.0f;
+			for(int y = 8; y < MAP_SIZE - 8; ++y){
+				for(int x = 8; x < MAP_SIZE - 8; ++x){
+					const float u = (x + 0.5f) / MAP_SIZE;
+					const float v = (y + 0.5f) / MAP_SIZE;
+					const float z = depth[y * MAP_SIZE + x] - ((tier == SHADOW_FILTER_EVSM) ? 0.0f : BIAS);
+					min_visibility[tier] = std::min(min_visibility[tier], filter.Visibility(static_cast<ShadowFilterTier>(tier), u, v, z));
+				}
+			}
+		}
+		checker.Check("a gentle slope does not shadow itself", *std::min_element(min_visibility, min_visibility + SHADOW_FILTER_EVSM) == 1.0f && min_visibility[SHADOW_FILTER_EVSM] > 0.99f);
+	}
+
+	//深度0.2と0.5の遮蔽物が隣り合い、その奥の深度0.8の面はどこも影になる
+	//分散シャドウマップは遮蔽物の境目で光が漏れやすいが、EVSMでは漏れない
+	{
+		for(int y = 0; y < MAP_SIZE; ++y){
+			for(int x = 0; x < MAP_SIZE; ++x){
+				depth[y * MAP_SIZE + x] = (x < MAP_SIZE / 2) ? 0.2f : 0.5f;
+			}
+		}
+		filter.SetDepthMap(depth.data(), MAP_SIZE, MAP_SIZE);
+		filter.Prefilter();
+
+		const ShadowProfile p = MeasureShadowProfile(filter, SHADOW_FILTER_EVSM, 0.8f);
+		checker.Check("evsm: no light bleeding between overlapping occluders", p.max < 0.01f);
+	}
+
+	//モーメントは深度の範囲の両端でも溢れない
+	{
+		float low[4];
+		float high[4];
+		ShadowFilter::WarpDepth(0.0f, low);
+		ShadowFilter::WarpDepth(1.0f, high);
+		bool finite = true;
+		for(int i = 0; i < 4; ++i){
+			finite = finite && std::isfinite(low[i]) && std::isfinite(high[i]) && low[i] != 0.0f && high[i] != 0.0f;
+		}
+		checker.Check("evsm moments stay finite for depths in [0, 1]", finite);
+	}
+
+
+	//段階ごとの所要時間(アプリと同じ大きさのシャドウマップに、乱数で置いた矩形の遮蔽物を描く)
+	{
+		TestRandom random(24680u);
+
+		std::vector<float> bench_depth(BENCH_SIZE * BENCH_SIZE, 1.0f);
+		for(int i = 0; i < 64; ++i){
+			const int x0 = static_cast<int>(random.Next(BENCH_SIZE));
+			const int y0 = static_cast<int>(random.Next(BENCH_SIZE));
+			const int size = 16 + static_cast<int>(random.Next(128));
+			const float d = 0.1f + 0.01f * static_cast<float>(random.Next(50));
+			for(int y = y0; y < std::min(y0 + size, BENCH_SIZE); ++y){
+				for(int x = x0; x < std::min(x0 + size, BENCH_SIZE); ++x){
+					bench_depth[y * BENCH_SIZE + x] = std::min(bench_depth[y * BENCH_SIZE + x], d);
+				}
+			}
+		}
+		filter.SetDepthMap(bench_depth.data(), BENCH_SIZE, BENCH_SIZE);
+
+		const auto prefilter_start = std::chrono::high_resolution_clock::now();
+		filter.Prefilter();
+		const double prefilter_ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - prefilter_start).count();
+
+		std::vector<float> lookups(static_cast<size_t>(lookup_num) * 4);
+		for(int i = 0; i < lookup_num; ++i){
+			lookups[i * 4 + 0] = static_cast<float>(random.Next(65536)) / 65536.0f;
+			lookups[i * 4 + 1] = static_cast<float>(random.Next(65536)) / 65536.0f;
+			lookups[i * 4 + 2] = 0.1f + static_cast<float>(random.Next(65536)) / 65536.0f * 0.9f;
+			lookups[i * 4 + 3] = static_cast<float>(random.Next(65536)) / 65536.0f * 6.2831853f;
+		}
+
+		for(int tier = 0; tier < SHADOW_FILTER_NUM; ++tier){
+			double sum = 0.0;
+			const auto start = std::chrono::high_resolution_clock::now();
+			for(int i = 0; i < lookup_num; ++i){
+				const float *l = &lookups[i * 4];
+				sum += filter.Visibility(static_cast<ShadowFilterTier>(tier), l[0], l[1], l[2], l[3]);
+			}
+			const double ns = std::chrono::duration<double, std::nano>(std::chrono::high_resolution_clock::now() - start).count() / lookup_num;
+			PrintLine("[shadowfilter] %-8s %7.1f ns / lookup  %3d texel reads  lit %5.1f%%\n",
+				ShadowFilter::TierName(static_cast<ShadowFilterTier>(tier)), ns, ShadowFilter::TexelReadNum(static_cast<ShadowFilterTier>(tier)), 100.0 * sum / lookup_num);
+		}
+		PrintLine("[shadowfilter] evsm prefilter %dx%d: %.1f ms  (%d texel reads per texel in 2 passes)\n",
+			BENCH_SIZE, BENCH_SIZE, prefilter_ms, 2 * (2 * ShadowFilter::EVSM_BLUR_RADIUS + 1));
+	}
+
+	return checker.Result();
+}
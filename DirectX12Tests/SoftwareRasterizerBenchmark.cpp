@@ -0,0 +1,87 @@
+#include <cstdio>
+#include <cstdint>
+#include <chrono>
+#include "SoftwareRasterizer.h"
+#include "ReferenceScene.h"
+#include "JobSystem.h"
+#include "TestCommon.h"
+
+//DirectX12Tests -swrender <出力ファイル(.bmp)> [幅 高さ フレーム]
+int SoftwareRenderCommand(const char *command_line){
+	char dst[260]{};
+	int width = 640;	//アプリのウインドウと同じ大きさ
+	int height = 480;
+	int frame = 1;
+	if(sscanf(command_line, "-swrender %259s %d %d %d", dst, &width, &height, &frame) < 1){
+		return -1;
+	}
+
+	ReferenceScene scene;
+	if(!scene.Load()){
+		return -1;
+	}
+
+	JobSystem jobs;
+	SoftwareRasterizer rasterizer;
+	rasterizer.SetJobSystem(&jobs);
+	if(!rasterizer.Resize(width, height)){
+		return -1;
+	}
+
+	SoftwareRasterizer::Scene desc;
+	scene.Build(frame, width, height, &desc);
+	rasterizer.Render(desc);
+
+	return rasterizer.SaveBMP(dst) ? 0 : -1;
+}
+
+
+//DirectX12Tests -swbench [フレーム数]
+//640x480から4Kまでの解像度で描画し、フレームレートをデバッグ出力と標準出力に書き出す
+int SoftwareBenchmarkCommand(const char *command_line){
+	static const int sizes[][2] = {
+		{640, 480},
+		{1280, 720},
+		{1920, 1080},
+		{3840, 2160},
+	};
+
+	int frame_num = 120;
+	sscanf(command_line, "-swbench %d", &frame_num);
+	if(frame_num < 1){
+		return -1;
+	}
+
+	ReferenceScene scene;
+	if(!scene.Load()){
+		return -1;
+	}
+
+	JobSystem jobs;
+	SoftwareRasterizer rasterizer;
+	rasterizer.SetJobSystem(&jobs);
+
+	SoftwareRasterizer::Scene desc;
+	for(const auto &size : sizes){
+		if(!rasterizer.Resize(size[0], size[1])){
+			return -1;
+		}
+
+		//1フレーム目はキャッシュを温めるために計測しない
+		scene.Build(1, size[0], size[1], &desc);
+		rasterizer.Render(desc);
+
+		const auto begin = std::chrono::steady_clock::now();
+		for(int i = 0; i < frame_num; ++i){
+			scene.Build(i + 1, size[0], size[1], &desc);
+			rasterizer.Render(desc);
+		}
+		const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+
+		PrintLine("[swbench] %4dx%-4d %4u threads  %8.2f fps  %8.3f ms/frame  %llu quads\n",
+			size[0], size[1], jobs.ThreadNum(), frame_num * 1000.0 / ms, ms / frame_num,
+			static_cast<unsigned long long>(rasterizer.ShadowStats().shaded_quad_num + rasterizer.MainStats().shaded_quad_num));
+	}
+
+	return 0;
+}
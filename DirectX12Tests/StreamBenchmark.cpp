@@ -0,0 +1,96 @@
+#include <cstdio>
+#include <cstdint>
+#include <chrono>
+#include <algorithm>
+#include <thread>
+#include "TextureAsset.h"
+#include "TextureStreamer.h"
+#include "HeadlessRenderer.h"
+#include "JobSystem.h"
+#include "TestCommon.h"
+
+//DirectX12Tests -streambench [テクスチャの数] [1フレームのミリ秒数]
+//earthのテクスチャを貼った球を遠くからカメラに近づけ、1フレームの転送量の予算ごとに
+//全てのテクスチャが必要な解像度になるまでのフレーム数・時間と、最も重いフレームの転送量・更新時間を計測する
+//転送先は提出から2フレーム後に完了する模擬キューで、読み込みはI/Oスレッドで行う
+//I/Oスレッドの読み込みが実際のフレームの間隔で進むように、フレームの間隔は指定したミリ秒数に合わせる
+int StreamBenchmarkCommand(const char *command_line){
+	static const uint64_t budgets[] = {0, 4 * 1024 * 1024, 1024 * 1024, 256 * 1024};
+	static const int APPROACH_FRAME_NUM	= 60;	//この間に球が近づいてくる
+	static const int MAX_FRAME_NUM		= 10000;
+	static const int QUEUE_LATENCY		= 2;
+	static const float FOV_Y			= 60.0f * 3.14159265f / 180.0f;
+	static const float PI				= 3.14159265f;
+
+	int texture_num = 16;
+	float frame_ms = 16.0f;
+	sscanf(command_line, "-streambench %d %f", &texture_num, &frame_ms);
+	if(texture_num < 1 || frame_ms < 0.0f){
+		return -1;
+	}
+
+	TextureAsset asset;
+	if(!asset.Load("earth")){
+		return -1;
+	}
+
+	JobSystem io_jobs(2);
+	for(uint64_t budget : budgets){
+		HeadlessStreamTarget target;
+		target.Initialize(64 * 1024 * 1024, QUEUE_LATENCY);
+
+		TextureStreamer streamer;
+		streamer.Initialize(&target, &io_jobs, budget);
+		for(int i = 0; i < texture_num; ++i){
+			if(streamer.Register(&asset, RenderResource{static_cast<uint64_t>(i + 1)}) < 0){
+				return -1;
+			}
+		}
+
+		//登録時の小さいレベルは計測の前に完了させる
+		target.Submit();
+		for(int i = 0; i < QUEUE_LATENCY; ++i){
+			target.EndFrame();
+		}
+		streamer.ResetStats();
+
+		const auto begin = std::chrono::steady_clock::now();
+		double max_update_ms{};
+		int frame = 0;
+		for(; frame < MAX_FRAME_NUM; ++frame){
+			std::this_thread::sleep_until(begin + std::chrono::microseconds(static_cast<long long>(frame * frame_ms * 1000.0f)));
+
+			//球は奥行き40から2まで近づき、手前のものほど大きく見える
+			const float t = std::min(1.0f, static_cast<float>(frame) / APPROACH_FRAME_NUM);
+			for(int i = 0; i < texture_num; ++i){
+				const float depth = (40.0f - 38.0f * t) * (1.0f + 0.25f * i);
+				streamer.Request(i, PI * TextureStreamer::ProjectedSize(1.0f, depth, FOV_Y, 480.0f));
+			}
+
+			const auto update_begin = std::chrono::steady_clock::now();
+			streamer.Update();
+			max_update_ms = std::max(max_update_ms, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - update_begin).count());
+
+			target.EndFrame();
+			if(frame >= APPROACH_FRAME_NUM && streamer.IsComplete()){
+				break;
+			}
+		}
+		const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+		streamer.WaitIdle();
+
+		const TextureStreamer::Stats &stats = streamer.GetStats();
+		char budget_text[32];
+		if(budget == 0){
+			snprintf(budget_text, sizeof(budget_text), "unlimited");
+		}else{
+			snprintf(budget_text, sizeof(budget_text), "%llu KB", static_cast<unsigned long long>(budget / 1024));
+		}
+
+		PrintLine("[streambench] %3d textures  budget %-9s  full quality %5d frames %9.2f ms  worst frame %8llu KB %7.3f ms  total %8llu KB%s\n",
+			texture_num, budget_text, frame + 1, ms, static_cast<unsigned long long>(stats.max_frame_upload_bytes / 1024), max_update_ms,
+			static_cast<unsigned long long>(stats.upload_bytes / 1024), target.FailedNum() > 0 ? "  (staging full)" : "");
+	}
+
+	return 0;
+}
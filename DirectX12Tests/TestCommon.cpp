@@ -0,0 +1,30 @@
+#if defined(_WIN32)
+#include <Windows.h>
+#endif
+#include <cstdio>
+#include <cstdarg>
+#include "TestCommon.h"
+
+void PrintLine(const char *format, ...){
+	char line[256];
+	va_list args;
+	va_start(args, format);
+	vsnprintf(line, sizeof(line), format, args);
+	va_end(args);
+#if defined(_WIN32)
+	OutputDebugStringA(line);
+#endif
+	fputs(line, stdout);
+}
+
+
+Checker::Checker(const char *tag, int name_width):
+	tag_(tag),
+	name_width_(name_width),
+	failed_num_{}{}
+
+bool Checker::Check(const char *name, bool ok){
+	PrintLine("[%s] %-*s %s\n", tag_, name_width_, name, ok ? "ok" : "FAILED");
+	failed_num_ += ok ? 0 : 1;
+	return ok;
+}
@@ -0,0 +1,84 @@
+#ifndef TEST_COMMON_HEADER_
+#define TEST_COMMON_HEADER_
+
+#include <cstdint>
+
+//GPUを使わないモジュールの検証と計測のコマンドで共通に使うもの
+//各コマンドはcommand_line("-csmcheck 100"のようにコマンド名から始まる引数の1行)を受け取り、
+//検証に成功したら0、失敗したら1、引数が正しくなければ-1を返す
+
+//デバッグ出力と標準出力の両方に書く
+void PrintLine(const char *format, ...);
+
+//検証の結果を1行ずつ"[tag] 名前 ok"(失敗ならFAILED)の形で書き、失敗した数を数える
+class Checker{
+public:
+	static constexpr int DEFAULT_NAME_WIDTH = 56;
+
+public:
+	explicit Checker(const char *tag, int name_width = DEFAULT_NAME_WIDTH);
+	~Checker(){}
+
+	//okをそのまま返す
+	bool Check(const char *name, bool ok);
+
+	int FailedNum() const{return failed_num_;}
+
+	//コマンドの戻り値(全て成功なら0、失敗があれば1)
+	int Result() const{return (failed_num_ == 0) ? 0 : 1;}
+
+private:
+	const char	*tag_;
+	int			name_width_;
+	int			failed_num_;
+};
+
+//検証の入力を作る乱数(線形合同法)。同じseedからは環境によらず同じ列になる
+class TestRandom{
+public:
+	explicit TestRandom(uint32_t seed):state_(seed){}
+	~TestRandom(){}
+
+	//24bitの値
+	uint32_t Next(){
+		state_ = state_ * 1664525u + 1013904223u;
+		return state_ >> 8;
+	}
+
+	//[0, n)の整数
+	uint32_t Next(uint32_t n){return Next() % n;}
+
+	//[lo, hi)の実数
+	float Uniform(float lo, float hi){return lo + (hi - lo) * static_cast<float>(Next()) / static_cast<float>(1 << 24);}
+
+private:
+	uint32_t	state_;
+};
+
+int CascadeCheckCommand(const char *command_line);
+int BarrierCheckCommand(const char *command_line);
+int GraphBenchmarkCommand(const char *command_line);
+int TlsfBenchmarkCommand(const char *command_line);
+int ResidencyBenchmarkCommand(const char *command_line);
+int ShadowCacheCheckCommand(const char *command_line);
+int ShadowFilterCheckCommand(const char *command_line);
+int CullBenchmarkCommand(const char *command_line);
+int OcclusionBenchmarkCommand(const char *command_line);
+int SceneBenchmarkCommand(const char *command_line);
+int SoftwareRenderCommand(const char *command_line);
+int SoftwareBenchmarkCommand(const char *command_line);
+int InstanceBenchmarkCommand(const char *command_line);
+int StreamBenchmarkCommand(const char *command_line);
+int RingAllocatorCheckCommand(const char *command_line);
+int FrameSchedulerCheckCommand(const char *command_line);
+int RecordSchedulerCheckCommand(const char *command_line);
+int HeadlessRendererCheckCommand(const char *command_line);
+int ShaderCacheCheckCommand(const char *command_line);
+int PipelineRegistryCheckCommand(const char *command_line);
+int CopyFootprintCheckCommand(const char *command_line);
+int DescriptorAllocatorCheckCommand(const char *command_line);
+int MipChainBenchmarkCommand(const char *command_line);
+int TextureBenchmarkCommand(const char *command_line);
+int FileBenchmarkCommand(const char *command_line);
+
+#endif
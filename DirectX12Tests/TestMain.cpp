@@ -0,0 +1,67 @@
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include "TestCommon.h"
+
+namespace{
+struct Command{
+	const char	*name;
+	int			(*function)(const char *command_line);
+	const char	*description;
+};
+
+const Command COMMANDS[] = {
+	{"-csmcheck", CascadeCheckCommand, "カスケードシャドウマップの分割と行列の検証"},
+	{"-barriercheck", BarrierCheckCommand, "バリアの自動挿入の検証"},
+	{"-graphbench", GraphBenchmarkCommand, "フレームグラフのコンパイルの検証と計測"},
+	{"-tlsfbench", TlsfBenchmarkCommand, "GPUメモリの割り当ての検証と計測"},
+	{"-residencybench", ResidencyBenchmarkCommand, "メモリの常駐の管理の検証と計測"},
+	{"-shadowcache", ShadowCacheCheckCommand, "シャドウマップのキャッシュの判定の検証"},
+	{"-shadowfiltercheck", ShadowFilterCheckCommand, "シャドウマップのフィルタの参照実装の検証と計測"},
+	{"-cullbench", CullBenchmarkCommand, "視錐台カリングの検証と計測"},
+	{"-occlusionbench", OcclusionBenchmarkCommand, "遮蔽カリングの検証と計測"},
+	{"-scenebench", SceneBenchmarkCommand, "シーンの変換の更新の検証と計測"},
+	{"-swrender", SoftwareRenderCommand, "CPUでの描画(正解画像の作成)"},
+	{"-swbench", SoftwareBenchmarkCommand, "CPUでの描画の計測"},
+	{"-instbench", InstanceBenchmarkCommand, "インスタンス描画の計測"},
+	{"-streambench", StreamBenchmarkCommand, "テクスチャのストリーミングの計測"},
+	{"-ringcheck", RingAllocatorCheckCommand, "アップロード用のリングバッファの割り当ての検証"},
+	{"-framecheck", FrameSchedulerCheckCommand, "フレームごとのフェンス値の管理の検証"},
+	{"-recordcheck", RecordSchedulerCheckCommand, "パスごとのコマンドの記録の振り分けの検証"},
+	{"-headlesscheck", HeadlessRendererCheckCommand, "ヘッドレスのバックエンドの数え方の検証"},
+	{"-shadercheck", ShaderCacheCheckCommand, "シェーダのキャッシュのキーとファイルの検証"},
+	{"-pipelinecheck", PipelineRegistryCheckCommand, "PSOのキーと登録表の重複除去の検証"},
+	{"-footprintcheck", CopyFootprintCheckCommand, "コピーのレイアウトとステージングのリングの検証"},
+	{"-descriptorcheck", DescriptorAllocatorCheckCommand, "デスクリプタの割り当ての断片化と再利用の検証"},
+	{"-mipbench", MipChainBenchmarkCommand, "ミップマップの縮小の検証と計測"},
+	{"-texbench", TextureBenchmarkCommand, "テクスチャの圧縮の画質と時間の計測"},
+	{"-filebench", FileBenchmarkCommand, "ファイルの読み込みの検証とmmap・std::ifstreamの比較"},
+};
+}
+
+//DirectX12Tests <コマンド> [引数]
+//GPUを使わないモジュールの検証と計測を行う(WindowsでもLinuxでも動く)。引数はコマンドごとの説明を参照
+//引数は空白でつないだ1行にしてコマンドに渡す
+int main(int argc, char *argv[]){
+	if(argc < 2){
+		printf("usage: DirectX12Tests <command> [arguments]\n");
+		for(const Command &command : COMMANDS){
+			printf("  %-20s %s\n", command.name, command.description);
+		}
+		return -1;
+	}
+
+	std::string command_line = argv[1];
+	for(int i = 2; i < argc; ++i){
+		command_line += ' ';
+		command_line += argv[i];
+	}
+
+	for(const Command &command : COMMANDS){
+		if(strcmp(argv[1], command.name) == 0){
+			return command.function(command_line.c_str());
+		}
+	}
+	printf("unknown command: %s\n", argv[1]);
+	return -1;
+}
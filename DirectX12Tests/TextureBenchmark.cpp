@@ -0,0 +1,329 @@
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <chrono>
+#include <cmath>
+#include <algorithm>
+#include <iterator>
+#include <string>
+#include <vector>
+#include "BlockCompressor.h"
+#include "TextureCooker.h"
+#include "TextureContainer.h"
+#include "TextureFile.h"
+#include "MipChain.h"
+#include "JobSystem.h"
+#include "TestCommon.h"
+
+namespace{
+typedef BlockCompressor::byte byte;
+
+struct Image{
+	int					width;
+	int					height;
+	std::vector<byte>	pixels;	//BGRA8(ピッチはwidth * 4)
+};
+
+//元の画像との差の二乗の合計
+struct Error{
+	double	color;		//BGRの3チャンネル
+	double	alpha;
+	double	pixel_num;
+
+	double ColorPsnr() const{return Psnr(color, pixel_num * 3);}
+	double AlphaPsnr() const{return Psnr(alpha, pixel_num);}
+
+	//誤差がなければ上限の値にする
+	static double Psnr(double squared_error, double sample_num){
+		if(squared_error <= 0.0){
+			return 99.0;
+		}
+		return 10.0 * std::log10(255.0 * 255.0 * sample_num / squared_error);
+	}
+};
+
+void AddError(const byte *a, int a_pitch, const byte *b, int b_pitch, int width, int height, Error *error){
+	for(int y = 0; y < height; ++y){
+		const byte *pa = a + y * a_pitch;
+		const byte *pb = b + y * b_pitch;
+		for(int x = 0; x < width * 4; x += 4){
+			for(int c = 0; c < 3; ++c){
+				const double d = static_cast<double>(pa[x + c]) - pb[x + c];
+				error->color += d * d;
+			}
+			const double d = static_cast<double>(pa[x + 3]) - pb[x + 3];
+			error->alpha += d * d;
+		}
+	}
+	error->pixel_num += static_cast<double>(width) * height;
+}
+
+//比較用のBC1の圧縮(各チャンネルの最小・最大を端点にし、4色から最も近い色を選ぶ)
+void EncodeBoundingBoxBlock(const byte *bgra, byte *dst){
+	int lo[3] = {255, 255, 255};
+	int hi[3] = {0, 0, 0};
+	for(int i = 0; i < 16; ++i){
+		for(int c = 0; c < 3; ++c){
+			lo[c] = std::min(lo[c], static_cast<int>(bgra[i * 4 + c]));
+			hi[c] = std::max(hi[c], static_cast<int>(bgra[i * 4 + c]));
+		}
+	}
+	auto to_565 = [](const int *bgr){
+		return static_cast<uint16_t>(((bgr[2] * 31 + 127) / 255) << 11 | ((bgr[1] * 63 + 127) / 255) << 5 | ((bgr[0] * 31 + 127) / 255));
+	};
+	uint16_t c0 = to_565(hi);
+	uint16_t c1 = to_565(lo);
+	if(c0 < c1){
+		std::swap(c0, c1);
+	}
+
+	//c0 > c1なら4色モード(等しければ全ての画素をc0にする)
+	int palette[4][3];
+	for(int e = 0; e < 2; ++e){
+		const uint16_t v = (e == 0) ? c0 : c1;
+		const int r = (v >> 11) & 31, g = (v >> 5) & 63, b = v & 31;
+		palette[e][0] = (b << 3) | (b >> 2);
+		palette[e][1] = (g << 2) | (g >> 4);
+		palette[e][2] = (r << 3) | (r >> 2);
+	}
+	for(int c = 0; c < 3; ++c){
+		palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+		palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+	}
+
+	uint32_t indices = 0;
+	for(int i = 0; i < 16 && c0 != c1; ++i){
+		int best = 0;
+		int best_distance = 1 << 30;
+		for(int p = 0; p < 4; ++p){
+			int distance = 0;
+			for(int c = 0; c < 3; ++c){
+				const int d = bgra[i * 4 + c] - palette[p][c];
+				distance += d * d;
+			}
+			if(distance < best_distance){
+				best = p;
+				best_distance = distance;
+			}
+		}
+		indices |= static_cast<uint32_t>(best) << (i * 2);
+	}
+
+	dst[0] = static_cast<byte>(c0);
+	dst[1] = static_cast<byte>(c0 >> 8);
+	dst[2] = static_cast<byte>(c1);
+	dst[3] = static_cast<byte>(c1 >> 8);
+	memcpy(dst + 4, &indices, sizeof(indices));
+}
+
+void CompressBoundingBox(const Image &image, byte *dst){
+	const int block_w = (image.width + 3) / 4;
+	byte block[64];
+	for(int by = 0; by < (image.height + 3) / 4; ++by){
+		for(int bx = 0; bx < block_w; ++bx){
+			for(int y = 0; y < 4; ++y){
+				const int sy = std::min(by * 4 + y, image.height - 1);
+				for(int x = 0; x < 4; ++x){
+					const int sx = std::min(bx * 4 + x, image.width - 1);
+					memcpy(block + (y * 4 + x) * 4, &image.pixels[(sy * image.width + sx) * 4], 4);
+				}
+			}
+			EncodeBoundingBoxBlock(block, dst + (by * block_w + bx) * 8);
+		}
+	}
+}
+
+bool LoadImage(const char *file_name, Image *image){
+	TextureFile file;
+	if(!file.Open(file_name)){
+		return false;
+	}
+	image->width = file.Width();
+	image->height = file.Height();
+	image->pixels.assign(file.Pixels(), file.Pixels() + file.PixelsSize());
+	return true;
+}
+
+bool SaveImage(const std::string &file_name, const Image &image){
+	FILE *fp = fopen(file_name.c_str(), "wb");
+	if(fp == nullptr){
+		return false;
+	}
+	const int32_t size[2] = {image.width, image.height};
+	bool ok = fwrite(size, sizeof(size), 1, fp) == 1;
+	ok = ok && fwrite(image.pixels.data(), 1, image.pixels.size(), fp) == image.pixels.size();
+	return (fclose(fp) == 0) && ok;
+}
+
+double ElapsedMs(std::chrono::high_resolution_clock::time_point start){
+	return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+}
+
+
+//DirectX12Tests -texbench <作業ファイルの名前> [計測の繰り返し回数]
+//テクスチャの圧縮の画質(PSNR)と時間を計測する(earth・wallを使い、作業ファイルの名前に拡張子などを付けたファイルを作る)
+//・BC1/BC3の圧縮にかかる時間(1スレッド・JobSystem)と、展開した画像の元の画像に対するPSNRを表示する
+//・主成分の方向を使う圧縮は、各チャンネルの最小・最大を端点にする圧縮よりPSNRが低くならない
+//・JobSystemで並列に圧縮しても1スレッドと同じ結果になる
+//・CookTextureで書き出したファイルの各レベルは、MipChainで縮小した画像を同じように圧縮したものと一致する
+//・CookTextureの時間と、レベル0・全てのレベルのPSNRを形式ごとに表示する
+int TextureBenchmarkCommand(const char *command_line){
+	char base[260]{};
+	int repeat_num = 3;
+	if(sscanf(command_line, "-texbench %259s %d", base, &repeat_num) < 1 || repeat_num < 1){
+		return -1;
+	}
+
+	Checker checker("texbench");
+
+	static const char *IMAGE_NAMES[] = {"earth", "wall"};
+	std::vector<Image> images(std::size(IMAGE_NAMES));
+	for(size_t i = 0; i < images.size(); ++i){
+		if(!LoadImage(IMAGE_NAMES[i], &images[i])){
+			return -1;
+		}
+
+		//アルファは全て255なので、BC3のアルファを確かめるために緑を入れる
+		Image &image = images[i];
+		for(size_t p = 0; p < image.pixels.size(); p += 4){
+			image.pixels[p + 3] = image.pixels[p + 1];
+		}
+	}
+
+	JobSystem jobs;
+	PrintLine("[texbench] %u job threads\n", jobs.ThreadNum());
+
+
+	//BC1/BC3の圧縮
+	{
+		static const TextureFormat FORMATS[] = {TEXTURE_FORMAT_BC1, TEXTURE_FORMAT_BC3};
+		bool not_worse = true;
+		bool same_with_jobs = true;
+		for(size_t i = 0; i < images.size(); ++i){
+			const Image &image = images[i];
+			const int pitch = image.width * 4;
+			std::vector<byte> decoded(image.pixels.size());
+
+			//比較用の圧縮
+			std::vector<byte> box(static_cast<size_t>(CalcTextureRowPitch(TEXTURE_FORMAT_BC1, image.width)) * CalcTextureRowNum(TEXTURE_FORMAT_BC1, image.height));
+			double box_ms = 1.0e9;
+			for(int r = 0; r < repeat_num; ++r){
+				const auto start = std::chrono::high_resolution_clock::now();
+				CompressBoundingBox(image, box.data());
+				box_ms = std::min(box_ms, ElapsedMs(start));
+			}
+			BlockCompressor::Decompress(TEXTURE_FORMAT_BC1, box.data(), image.width, image.height, decoded.data(), pitch);
+			Error box_error{};
+			AddError(image.pixels.data(), pitch, decoded.data(), pitch, image.width, image.height, &box_error);
+			PrintLine("[texbench] %-5s %4dx%-4d BC1 bbox  %8.3f ms                   PSNR %6.2f dB\n",
+				IMAGE_NAMES[i], image.width, image.height, box_ms, box_error.ColorPsnr());
+
+			for(TextureFormat format : FORMATS){
+				std::vector<byte> single(static_cast<size_t>(CalcTextureRowPitch(format, image.width)) * CalcTextureRowNum(format, image.height));
+				std::vector<byte> parallel(single.size());
+				double single_ms = 1.0e9, parallel_ms = 1.0e9;
+				for(int r = 0; r < repeat_num; ++r){
+					auto start = std::chrono::high_resolution_clock::now();
+					BlockCompressor::Compress(format, image.pixels.data(), image.width, image.height, pitch, single.data(), nullptr);
+					single_ms = std::min(single_ms, ElapsedMs(start));
+
+					start = std::chrono::high_resolution_clock::now();
+					BlockCompressor::Compress(format, image.pixels.data(), image.width, image.height, pitch, parallel.data(), &jobs);
+					parallel_ms = std::min(parallel_ms, ElapsedMs(start));
+				}
+				same_with_jobs = same_with_jobs && (single == parallel);
+
+				BlockCompressor::Decompress(format, single.data(), image.width, image.height, decoded.data(), pitch);
+				Error error{};
+				AddError(image.pixels.data(), pitch, decoded.data(), pitch, image.width, image.height, &error);
+				not_worse = not_worse && (error.ColorPsnr() >= box_error.ColorPsnr());
+
+				const double mega_pixels = static_cast<double>(image.width) * image.height / 1.0e6;
+				PrintLine("[texbench] %-5s %4dx%-4d %s      %8.3f ms  jobs %8.3f ms  PSNR %6.2f dB",
+					IMAGE_NAMES[i], image.width, image.height, (format == TEXTURE_FORMAT_BC1) ? "BC1" : "BC3",
+					single_ms, parallel_ms, error.ColorPsnr());
+				if(format == TEXTURE_FORMAT_BC3){
+					PrintLine("  alpha %6.2f dB", error.AlphaPsnr());
+				}
+				PrintLine("  (%6.1f MP/s)\n", mega_pixels / parallel_ms * 1000.0);
+			}
+		}
+		checker.Check("PCA endpoints are not worse than the bounding box", not_worse);
+		checker.Check("compressing with jobs gives the same blocks", same_with_jobs);
+	}
+
+
+	//CookTexture
+	{
+		static const TextureFormat FORMATS[] = {TEXTURE_FORMAT_BGRA8, TEXTURE_FORMAT_BC1, TEXTURE_FORMAT_BC3};
+		static const char *FORMAT_NAMES[] = {"BGRA8", "BC1", "BC3"};
+		const Image &image = images[0];
+		const std::string raw_name = std::string(base) + "_raw";
+		const bool saved = SaveImage(raw_name, image);
+		checker.Check("raw texture is written", saved);
+
+		MipChain mips;
+		mips.Generate(image.pixels.data(), image.width, image.height, image.width * 4);
+
+		bool cooked = saved;
+		bool levels_match = saved;
+		for(size_t f = 0; f < std::size(FORMATS) && saved; ++f){
+			const TextureFormat format = FORMATS[f];
+			const std::string cooked_name = std::string(base) + "_" + FORMAT_NAMES[f] + ".tex";
+			double cook_ms = 1.0e9;
+			for(int r = 0; r < repeat_num; ++r){
+				const auto start = std::chrono::high_resolution_clock::now();
+				cooked = cooked && CookTexture(raw_name.c_str(), cooked_name.c_str(), format, &jobs);
+				cook_ms = std::min(cook_ms, ElapsedMs(start));
+			}
+
+			TextureContainer container;
+			if(!cooked || !container.Open(cooked_name.c_str()) || container.Format() != format || container.LevelNum() != mips.LevelNum()){
+				levels_match = false;
+				continue;
+			}
+
+			//各レベルをMipChainの縮小と比べる(圧縮した形式は同じ圧縮を通したものと一致する)
+			Error top_error{};
+			Error all_error{};
+			for(int i = 0; i < container.LevelNum(); ++i){
+				const TextureLevel &level = container.GetLevel(i);
+				const MipChain::Level &mip = mips.GetLevel(i);
+				if(level.width != mip.width || level.height != mip.height){
+					levels_match = false;
+					break;
+				}
+
+				std::vector<byte> decoded(static_cast<size_t>(mip.width) * mip.height * 4);
+				if(format == TEXTURE_FORMAT_BGRA8){
+					for(int y = 0; y < mip.height; ++y){
+						memcpy(&decoded[y * mip.width * 4], level.pixels + y * level.row_pitch, mip.width * 4);
+					}
+				}else{
+					std::vector<byte> expected(static_cast<size_t>(level.row_pitch) * level.row_num);
+					BlockCompressor::Compress(format, mip.pixels, mip.width, mip.height, mip.row_pitch, expected.data(), nullptr);
+					levels_match = levels_match && memcmp(expected.data(), level.pixels, expected.size()) == 0;
+					BlockCompressor::Decompress(format, level.pixels, level.width, level.height, decoded.data(), level.width * 4);
+				}
+				AddError(mip.pixels, mip.row_pitch, decoded.data(), mip.width * 4, mip.width, mip.height, (i == 0) ? &top_error : &all_error);
+			}
+			all_error.color += top_error.color;
+			all_error.alpha += top_error.alpha;
+			all_error.pixel_num += top_error.pixel_num;
+			if(format == TEXTURE_FORMAT_BGRA8){
+				levels_match = levels_match && all_error.color == 0.0 && all_error.alpha == 0.0;
+			}
+
+			PrintLine("[texbench] cook earth %-5s %2d levels  %8.3f ms  PSNR level 0 %6.2f dB  all levels %6.2f dB\n",
+				FORMAT_NAMES[f], container.LevelNum(), cook_ms, top_error.ColorPsnr(), all_error.ColorPsnr());
+			container.Close();
+			remove(cooked_name.c_str());
+		}
+		remove(raw_name.c_str());
+		checker.Check("CookTexture writes every format", cooked);
+		checker.Check("cooked levels match MipChain and BlockCompressor", levels_match);
+	}
+
+	return checker.Result();
+}
@@ -0,0 +1,175 @@
+#include <cstdio>
+#include <cstdint>
+#include <chrono>
+#include <iterator>
+#include <map>
+#include <vector>
+#include "TlsfAllocator.h"
+#include "DescriptorAllocator.h"
+#include "TestCommon.h"
+
+//DirectX12Tests -tlsfbench [操作の回数]
+//GpuMemoryAllocatorのブロックと同じ使い方(4KB・64KB・4MBのアライメント、フェンスを待つ解放)で乱数の割り当て・解放を繰り返し、
+//割り当てた範囲が揃っていて重ならないこと・内部の構造が整合していること・全て解放すると1つの空きブロックに戻ることを確かめ、
+//1回の割り当て・解放にかかる時間をデスクリプタの割り当て(best-fit)と比べる
+int TlsfBenchmarkCommand(const char *command_line){
+	static constexpr uint64_t BLOCK_SIZE = 256ull * 1024 * 1024;
+	static const uint64_t alignments[] = {4 * 1024, 64 * 1024, 64 * 1024, 4 * 1024 * 1024};
+
+	int op_num = 200000;
+	sscanf(command_line, "-tlsfbench %d", &op_num);
+	if(op_num < 1){
+		return -1;
+	}
+
+	Checker checker("tlsfbench", 44);
+
+	TestRandom random(1234567u);
+
+	//テクスチャの大きさの分布(小さいものが多く、たまに数MB)
+	auto random_size = [&random]()->uint64_t{
+		const uint32_t r = random.Next() % 100;
+		if(r < 60){
+			return 256 + random.Next(64 * 1024);
+		}
+		if(r < 95){
+			return 64 * 1024 + random.Next(1024 * 1024);
+		}
+		return 1024 * 1024 + random.Next(8 * 1024 * 1024);
+	};
+
+	//乱数の操作を手元の割り当て表と突き合わせる
+	{
+		struct Live{
+			uint64_t	size;
+			uint64_t	fence_value;	//解放待ちなら0以外
+		};
+		TlsfAllocator allocator(BLOCK_SIZE);
+		std::map<uint64_t, Live> live;
+		std::vector<uint64_t> offsets;
+		uint64_t fence_value = 1;
+		bool aligned = true;
+		bool disjoint = true;
+		bool sizes = true;
+		bool valid = true;
+		uint64_t alloc_num = 0;
+		uint64_t fail_num = 0;
+
+		for(int op = 0; op < op_num; ++op){
+			if(offsets.empty() || random.Next() % 100 < 55){
+				const uint64_t size = random_size();
+				const uint64_t alignment = alignments[random.Next() % std::size(alignments)];
+				const uint64_t offset = allocator.Allocate(size, alignment);
+				if(offset == TlsfAllocator::INVALID_OFFSET){
+					++fail_num;
+					continue;
+				}
+				++alloc_num;
+				aligned = aligned && (offset % alignment == 0) && (offset + size <= BLOCK_SIZE);
+				sizes = sizes && (allocator.AllocationSize(offset) == size);
+
+				auto it = live.lower_bound(offset);
+				if(it != live.end() && it->first < offset + size){
+					disjoint = false;
+				}
+				if(it != live.begin() && std::prev(it)->first + std::prev(it)->second.size > offset){
+					disjoint = false;
+				}
+				live[offset] = {size, 0};
+				offsets.push_back(offset);
+			}else{
+				//1/4はフェンスを待って解放する
+				const size_t index = random.Next() % offsets.size();
+				const uint64_t offset = offsets[index];
+				offsets[index] = offsets.back();
+				offsets.pop_back();
+				const uint64_t fence = (random.Next() % 4 == 0) ? fence_value : 0;
+				allocator.Free(offset, fence);
+				if(fence == 0){
+					live.erase(offset);
+				}else{
+					live[offset].fence_value = fence;
+				}
+			}
+
+			//16回の操作を1フレームとし、2フレーム前までを完了したものとする
+			if(op % 16 == 15){
+				++fence_value;
+				allocator.ReleaseCompleted(fence_value - 2);
+				for(auto it = live.begin(); it != live.end();){
+					it = (it->second.fence_value != 0 && it->second.fence_value <= fence_value - 2) ? live.erase(it) : std::next(it);
+				}
+			}
+			if(op % 1024 == 0){
+				valid = valid && allocator.Validate();
+			}
+		}
+		valid = valid && allocator.Validate();
+		const TlsfAllocator::Stats busy = allocator.GetStats();
+
+		uint64_t live_size = 0;
+		for(const auto &l : live){
+			live_size += l.second.size;
+		}
+
+		checker.Check("offsets are aligned and in range", aligned);
+		checker.Check("allocations never overlap", disjoint);
+		checker.Check("allocation sizes are recorded", sizes);
+		checker.Check("blocks, free lists and bitmaps are consistent", valid);
+		checker.Check("used size matches live allocations", busy.used_size == live_size && busy.allocation_num == live.size());
+
+		for(uint64_t offset : offsets){
+			allocator.Free(offset, fence_value);
+		}
+		allocator.ReleaseCompleted(fence_value);
+		const TlsfAllocator::Stats empty = allocator.GetStats();
+		checker.Check("freeing everything leaves one free block", allocator.Validate() && allocator.IsEmpty() && empty.free_block_num == 1 && empty.largest_free_size == BLOCK_SIZE && empty.pending_num == 0);
+
+		PrintLine("[tlsfbench] fuzz %d ops  allocations %llu  failed %llu  busy %llu / %llu MB  free blocks %u  fragmentation %.3f\n",
+			op_num, static_cast<unsigned long long>(alloc_num), static_cast<unsigned long long>(fail_num),
+			static_cast<unsigned long long>(busy.used_size >> 20), static_cast<unsigned long long>(BLOCK_SIZE >> 20),
+			busy.free_block_num, busy.Fragmentation());
+	}
+
+	//割り当て・解放の速さ(同じ大きさの並びで、4096個を保ったまま入れ替える)
+	{
+		static constexpr int LIVE_NUM = 4096;
+		std::vector<uint64_t> sizes(op_num);
+		std::vector<uint32_t> victims(op_num);
+		for(int i = 0; i < op_num; ++i){
+			sizes[i]	= 256 + random.Next(32 * 1024);
+			victims[i]	= random.Next(LIVE_NUM);
+		}
+
+		TlsfAllocator allocator(BLOCK_SIZE);
+		std::vector<uint64_t> live(LIVE_NUM, TlsfAllocator::INVALID_OFFSET);
+		auto begin = std::chrono::steady_clock::now();
+		for(int i = 0; i < op_num; ++i){
+			uint64_t &slot = live[victims[i]];
+			allocator.Free(slot);
+			slot = allocator.Allocate(sizes[i], 4 * 1024);
+		}
+		const double tlsf_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - begin).count() / op_num;
+		const TlsfAllocator::Stats stats = allocator.GetStats();
+
+		//デスクリプタの割り当てで256バイトを1つとして同じ操作をする
+		DescriptorAllocator best_fit(static_cast<uint32_t>(BLOCK_SIZE / 256));
+		std::vector<uint32_t> firsts(LIVE_NUM, DescriptorAllocator::INVALID_INDEX);
+		std::vector<uint32_t> counts(LIVE_NUM, 0);
+		begin = std::chrono::steady_clock::now();
+		for(int i = 0; i < op_num; ++i){
+			const uint32_t v = victims[i];
+			if(firsts[v] != DescriptorAllocator::INVALID_INDEX){
+				best_fit.Free(firsts[v], counts[v]);
+			}
+			counts[v] = static_cast<uint32_t>((sizes[i] + 255) / 256);
+			firsts[v] = best_fit.Allocate(counts[v]);
+		}
+		const double best_fit_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - begin).count() / op_num;
+
+		PrintLine("[tlsfbench] free+allocate  tlsf %7.1f ns  best-fit %7.1f ns  (live %d, tlsf fragmentation %.3f, failed %llu)\n",
+			tlsf_ns, best_fit_ns, LIVE_NUM, stats.Fragmentation(), static_cast<unsigned long long>(stats.failed_num));
+	}
+
+	return checker.Result();
+}